@@ -16,6 +16,8 @@
 
 struct MassConvertWindow;
 
+class TxdGenModule;
+
 struct MassConvertWindow : public QDialog, public magicTextLocalizationItem
 {
     friend struct massconvEnv;
@@ -59,6 +61,7 @@ private:
 
 public:
     volatile rw::thread_t conversionThread;
+    TxdGenModule *volatile conversionModule;
 
     rw::rwlock *volatile convConsistencyLock;
 
@@ -12,6 +12,10 @@ struct compressionManager abstract
 
     virtual compressionProvider*    CreateProvider( void ) = 0;
     virtual void                    DestroyProvider( compressionProvider *prov ) = 0;
+
+    // Returns a stream that decompresses while it is read, or NULL if the format cannot do that.
+    // The returned stream owns the compressed stream.
+    virtual CFile*                  CreateDecompressionStream( CFile *compressed ) = 0;
 };
 
 // API to decode possibly compressed streams.
@@ -30,6 +30,9 @@ struct BlockProvider
         this->isInContext = false;
         this->contextStream = NULL;
         this->ignoreBlockRegions = parentProvider->ignoreBlockRegions;
+        this->isFlatReading = false;
+        this->readWindow = NULL;
+        this->targetStream = NULL;
     }
 
     inline BlockProvider( BlockProvider *parentProvider, bool ignoreBlockRegions )
@@ -39,6 +42,9 @@ struct BlockProvider
         this->isInContext = false;
         this->contextStream = NULL;
         this->ignoreBlockRegions = ignoreBlockRegions;
+        this->isFlatReading = false;
+        this->readWindow = NULL;
+        this->targetStream = NULL;
     }
 
     BlockProvider( const BlockProvider& right ) = delete;
@@ -58,6 +64,19 @@ protected:
 
     bool ignoreBlockRegions;
 
+    // If the block regions are trusted, reading is flattened: the bounds of a block have been verified
+    // against all parents when entering it, so reads only have to stay inside the block and are served
+    // from a read-ahead window of the root provider instead of going through every parent.
+    // The parents are updated once a child leaves its context.
+    struct ReadAheadWindow;
+
+    bool isFlatReading;
+    ReadAheadWindow *readWindow;
+
+    // When writing sequentially, the root provider assembles its block in a memory stream
+    // and writes it to this stream when leaving the context, so no seeks are done on it.
+    Stream *targetStream;
+
     // Processing context of this stream.
     // This is stored for important points.
     struct Context
@@ -89,6 +108,10 @@ public:
     void EnterContext( void ) throw( ... );
     void LeaveContext( void );
 
+    // Leaves the context after a failure.
+    // A block that is assembled for sequential writing is dropped instead of being written.
+    void AbortContext( void );
+
     inline bool inContext( void ) const
     {
         return this->isInContext;
@@ -98,6 +121,10 @@ public:
     void read( void *out_buf, size_t readCount ) throw( ... );
     void write( const void *in_buf, size_t writeCount ) throw( ... );
 
+    // Reads without copying if the underlying stream is memory based (see Stream::view).
+    // Returns NULL if that is not possible; then nothing was read and read() has to be used.
+    const void* read_view( size_t readCount ) throw( ... );
+
     void skip( size_t skipCount ) throw( ... );
     int64 tell( void ) const;
     int64 tell_absolute( void ) const;
@@ -110,6 +137,7 @@ public:
 protected:
     // Special helper algorithms.
     void read_native( void *out_buf, size_t readCount ) throw( ... );
+    const void* view_native( size_t readCount ) throw( ... );
     void write_native( const void *in_buf, size_t writeCount ) throw( ... );
 
     void skip_native( size_t skipCount ) throw( ... );
@@ -120,6 +148,9 @@ protected:
 
     Interface* getEngineInterface( void ) const;
 
+    void read_flat( void *out_buf, size_t readCount ) throw( ... );
+    void fetch_window( int64 absOffset, size_t readCount ) throw( ... );
+
 public:
     // Block meta-data API.
     uint32 getBlockID( void ) const throw( ... );
@@ -129,6 +160,9 @@ public:
     void setBlockID( uint32 id );
     void setBlockVersion( LibraryVersion version );
 
+    // Returns the stream that the outermost block provider works on.
+    Stream* getContextStream( void ) const;
+
     inline bool doesIgnoreBlockRegions( void ) const
     {
         return this->ignoreBlockRegions;
@@ -1,4 +1,5 @@
 // File interface for custom file pipelining.
+// Stream offsets are 64bit so that files bigger than 2GB (like uncompressed IMG archives) work.
 struct FileInterface abstract
 {
     typedef void* filePtr_t;
@@ -11,12 +12,12 @@ struct FileInterface abstract
     virtual size_t          ReadStream          ( filePtr_t ptr, void *outBuf, size_t readCount ) = 0;
     virtual size_t          WriteStream         ( filePtr_t ptr, const void *outBuf, size_t writeCount ) = 0;
     
-    virtual bool            SeekStream          ( filePtr_t ptr, long streamOffset, int type ) = 0;
-    virtual long            TellStream          ( filePtr_t ptr ) = 0;
+    virtual bool            SeekStream          ( filePtr_t ptr, int64 streamOffset, int type ) = 0;
+    virtual int64           TellStream          ( filePtr_t ptr ) = 0;
 
     virtual bool            IsEOFStream         ( filePtr_t ptr ) = 0;
 
-    virtual long            SizeStream          ( filePtr_t ptr ) = 0;
+    virtual int64           SizeStream          ( filePtr_t ptr ) = 0;
 
     virtual void            FlushStream         ( filePtr_t ptr ) = 0;
 };
@@ -69,11 +70,9 @@ protected:
             assert( 0 );
         }
 
-        long streamOffsetANSI = (long)offset;
+        bool seekSuccess = this->fileInterface->SeekStream( this->fptr, (int64)offset, offsetANSI );
 
-        int seekSuccess = this->fileInterface->SeekStream( this->fptr, streamOffsetANSI, offsetANSI );
-
-        if ( seekSuccess == -1 )
+        if ( seekSuccess == false )
             return -1;
 
         return this->fileInterface->TellStream( this->fptr );
@@ -81,11 +80,9 @@ protected:
 
     std::streampos seekpos( std::streamoff offset, std::ios_base::openmode openmode )
     {
-        long streamOffsetANSI = (long)offset;
-
-        int seekSuccess = this->fileInterface->SeekStream( this->fptr, streamOffsetANSI, SEEK_SET );
+        bool seekSuccess = this->fileInterface->SeekStream( this->fptr, (int64)offset, SEEK_SET );
 
-        if ( seekSuccess == -1 )
+        if ( seekSuccess == false )
             return -1;
 
         return this->fileInterface->TellStream( this->fptr );
@@ -100,10 +97,10 @@ protected:
 
     std::streamsize showmanyc( void )
     {
-        long curPos = this->fileInterface->TellStream( this->fptr );
-        long fileSize = this->fileInterface->SizeStream( this->fptr );
+        int64 curPos = this->fileInterface->TellStream( this->fptr );
+        int64 fileSize = this->fileInterface->SizeStream( this->fptr );
 
-        return (std::streamsize)( std::max( (long)0, fileSize - curPos ) );
+        return (std::streamsize)( std::max( (int64)0, fileSize - curPos ) );
     }
 
     std::streamsize xsgetn( char *outBuffer, std::streamsize n )
@@ -133,7 +130,7 @@ protected:
         if ( writeCount == 0 )
             return EOF;
 
-        this->fileInterface->SeekStream( this->fptr, -(long)writeCount, SEEK_CUR );
+        this->fileInterface->SeekStream( this->fptr, -(int64)writeCount, SEEK_CUR );
 
         return c;
     }
@@ -159,7 +156,7 @@ protected:
         if ( readCount == 0 )
             return EOF;
 
-        this->fileInterface->SeekStream( this->fptr, -(long)readCount, SEEK_CUR );
+        this->fileInterface->SeekStream( this->fptr, -(int64)readCount, SEEK_CUR );
 
         return theChar;
     }
@@ -519,6 +519,52 @@ enum eDXTCompressionMethod
     DXTRUNTIME_SQUISH       // prefer squish
 };
 
+// PVRTC compression configuration.
+enum ePVRCompressionMethod
+{
+    PVRRUNTIME_NATIVE,      // use the PVRTC codec that is embedded into rwtools
+    PVRRUNTIME_PVRTEXLIB    // prefer PVRTexLib, if it could be loaded
+};
+
+// Pixel memory configuration.
+enum ePixelAllocatorType
+{
+    PIXELALLOC_SYSTEM,      // every pixel buffer comes from the system heap
+    PIXELALLOC_POOLED       // freed pixel buffers are cached in size classes and handed out again
+};
+
+struct pixelAllocatorStats
+{
+    uint64 bytesLive;       // bytes of pixel buffers that are currently allocated
+    uint64 bytesPeak;       // highest bytesLive so far
+    uint64 bytesCached;     // bytes of freed pixel buffers that are kept for reuse
+    uint64 cacheHits;       // allocations that were served from the cache
+    uint64 cacheMisses;     // allocations that had to go to the system heap
+};
+
+// Statistics of the cache of compiled texel permutations (PS2/PSP memory swizzling).
+struct permutationPlanCacheStats
+{
+    uint32 planCount;       // amount of plans that are currently cached
+    uint64 bytesCached;     // memory taken by the cached plans
+    uint64 cacheHits;       // permutations that used a cached plan
+    uint64 cacheMisses;     // permutations that had to compile a plan first
+    uint64 evictions;       // plans that were dropped to stay in the memory budget
+};
+
+// Parameters that have to be known when the engine is created.
+struct engineCreationParams
+{
+    inline engineCreationParams( void )
+    {
+        this->pixelAllocator = PIXELALLOC_SYSTEM;
+        this->pixelCacheSize = 0;
+    }
+
+    ePixelAllocatorType pixelAllocator;
+    size_t pixelCacheSize;  // maximum bytes of freed pixel buffers to keep, zero picks the default
+};
+
 struct Interface abstract
 {
 protected:
@@ -572,9 +618,15 @@ public:
     void*               MemAllocate             ( size_t memSize );
     void                MemFree                 ( void *ptr );
 
+    // Pixel buffers are aligned to 64 bytes.
     void*               PixelAllocate           ( size_t memSize );
     void                PixelFree               ( void *pixels );
 
+    ePixelAllocatorType GetPixelAllocatorType   ( void ) const;
+    void                GetPixelAllocatorStats  ( pixelAllocatorStats& statsOut ) const;
+
+    void                GetPermutationPlanCacheStats( permutationPlanCacheStats& statsOut ) const;
+
     void                SetWarningManager       ( WarningManagerInterface *warningMan );
     WarningManagerInterface*    GetWarningManager( void ) const;
 
@@ -594,6 +646,9 @@ public:
     void                    SetDXTRuntime       ( eDXTCompressionMethod dxtRunType );
     eDXTCompressionMethod   GetDXTRuntime       ( void ) const;
 
+    bool                    SetPVRRuntime       ( ePVRCompressionMethod pvrRunType );
+    ePVRCompressionMethod   GetPVRRuntime       ( void ) const;
+
     void                SetFixIncompatibleRasters   ( bool doFix );
     bool                GetFixIncompatibleRasters   ( void ) const;
 
@@ -608,12 +663,40 @@ public:
 
     void                SetIgnoreSerializationBlockRegions  ( bool doIgnore );
     bool                GetIgnoreSerializationBlockRegions  ( void ) const;
+
+    // Serialization assembles every outermost block in memory and writes it to the stream in one sequential write.
+    // Use this for streams that cannot seek, like pipes or compression streams.
+    void                SetSequentialSerialization  ( bool sequential );
+    bool                GetSequentialSerialization  ( void ) const;
+
+    // Texture dictionaries that are read while this is enabled only read the texture names and filtering.
+    // Texel data is read from the source stream once the raster of a texture is requested.
+    // Deleting the source stream reads the textures that are still pending from it first.
+    void                SetLazyTexDictionaryLoading ( bool lazyLoad );
+    bool                GetLazyTexDictionaryLoading ( void ) const;
+
+    // Texture dictionaries that are read while this is enabled read the texture native blocks into memory
+    // and decode them on the worker threads. The textures keep the order of the dictionary.
+    // This has no effect if the calling thread uses its own configuration or lazy loading is enabled.
+    void                SetParallelTexDictionaryLoading ( bool parallelLoad );
+    bool                GetParallelTexDictionaryLoading ( void ) const;
+
+    // PNG and TGA images are converted row by row into the format of the native texture while they are decoded.
+    // Disabling this decodes the whole image first and converts it afterwards, which takes more memory.
+    void                SetStreamedImageDecoding    ( bool streamed );
+    bool                GetStreamedImageDecoding    ( void ) const;
+
+    // Amount of threads that parallel work (like DXT compression) is split across.
+    // Zero means one thread per logical processor, one disables the worker threads.
+    void                SetWorkerThreadCount    ( uint32 threadCount );
+    uint32              GetWorkerThreadCount    ( void ) const;
 };
 
 #include "renderware.utils.h"
 
 // To create a RenderWare interface, you have to go through a constructor.
 Interface*  CreateEngine( LibraryVersion engine_version );
+Interface*  CreateEngine( LibraryVersion engine_version, const engineCreationParams& params );
 void        DeleteEngine( Interface *theEngine );
 
 // Configuration interface.
@@ -8,7 +8,9 @@ enum eBuiltinStreamType
     RWSTREAMTYPE_FILE,
     RWSTREAMTYPE_FILE_W,
     RWSTREAMTYPE_MEMORY,
-    RWSTREAMTYPE_CUSTOM
+    RWSTREAMTYPE_CUSTOM,
+    RWSTREAMTYPE_FILE_MAPPED,       // read-only, maps the whole file into memory
+    RWSTREAMTYPE_FILE_MAPPED_W
 };
 
 enum eStreamMode
@@ -48,6 +50,9 @@ struct streamConstructionFileParamW_t : public streamConstructionParam_t
     const wchar_t *filename;
 };
 
+// If buf is NULL, the engine allocates a buffer that grows as it is written to.
+// bufSize is then the initial capacity. Otherwise the stream works on the caller's buffer,
+// which has to stay alive for as long as the stream does.
 struct streamConstructionMemoryParam_t : public streamConstructionParam_t
 {
     inline streamConstructionMemoryParam_t( void *buf, size_t bufSize )
@@ -156,6 +161,12 @@ struct Stream abstract
 
     virtual int64 size( void ) const throw( ... );
 
+    // Zero-copy access to the next viewCount bytes of the stream.
+    // Advances the stream and returns a pointer to the data, or NULL if the stream cannot
+    // provide one (nothing is consumed then). The data stays valid until the stream is
+    // written to or deleted.
+    virtual const void* view( size_t viewCount ) throw( ... );
+
     // Capability functions.
     virtual bool supportsSize( void ) const;
 };
@@ -31,6 +31,17 @@ struct reentrant_rwlock abstract
     void leave_write( void );
 };
 
+// Lets threads sleep until a state that is protected by a rwlock changes.
+// wait has to be called inside the write region of the lock; it leaves the region while sleeping.
+// Wakeups can be spurious, so check the state in a loop.
+struct rwcond abstract
+{
+    void wait( rwlock *theLock );
+
+    void signal( void );
+    void signal_all( void );
+};
+
 // Scoped lock objects.
 template <typename lockType = rwlock>
 struct scoped_rwlock_reader
@@ -100,12 +111,15 @@ rwlock* CreatePlacedReadWriteLock( Interface *engineInterface, void *mem );
 void ClosePlacedReadWriteLock( Interface *engineInterface, rwlock *theLock );
 
 reentrant_rwlock* CreateReentrantReadWriteLock( Interface *engineInterface );
-void CloseReentrantReadWriteLock( reentrant_rwlock *theLock );
+void CloseReentrantReadWriteLock( Interface *engineInterface, reentrant_rwlock *theLock );
 
 size_t GetReentrantReadWriteLockStructSize( Interface *engineInterface );
 reentrant_rwlock* CreatePlaceReeentrantReadWriteLock( Interface *engineInterface, void *mem );
 void ClosePlacedReentrantReadWriteLock( Interface *engineInterface, reentrant_rwlock *theLock );
 
+rwcond* CreateConditionVariable( Interface *engineInterface );
+void CloseConditionVariable( Interface *engineInterface, rwcond *theCond );
+
 // Thread creation API.
 thread_t MakeThread( Interface *engineInterface, threadEntryPoint_t entryPoint, void *ud );
 void CloseThread( Interface *engineInterface, thread_t threadHandle );
@@ -171,7 +171,9 @@ enum eMipmapGenerationMode
     MIPMAPGEN_CONTRAST,
     MIPMAPGEN_BRIGHTEN,
     MIPMAPGEN_DARKEN,
-    MIPMAPGEN_SELECTCLOSE
+    MIPMAPGEN_SELECTCLOSE,
+    MIPMAPGEN_SRGB,                 // averages in linear light, for color textures that are stored as sRGB
+    MIPMAPGEN_PREMULTIPLIED_ALPHA   // weights colors by their alpha, so transparent texels do not bleed into visible ones
 };
 
 enum eRasterType
@@ -274,13 +276,17 @@ struct Raster
 
 struct TexDictionary;
 
+struct lazyTextureData;
+
 struct TextureBase : public RwObject
 {
     friend struct TexDictionary;
+    friend struct texDictionaryStreamPlugin;
 
     inline TextureBase( Interface *engineInterface, void *construction_params ) : RwObject( engineInterface, construction_params )
     {
         this->texRaster = NULL;
+        this->lazyData = NULL;
         this->filterMode = RWFILTER_DISABLE;
         this->uAddressing = RWTEXADDRESS_WRAP;
         this->vAddressing = RWTEXADDRESS_WRAP;
@@ -322,15 +328,18 @@ struct TextureBase : public RwObject
 
     void SetRaster( Raster *texRaster );
 
-    Raster* GetRaster( void ) const
-    {
-        return this->texRaster;
-    }
+    // Textures of lazily loaded dictionaries read their raster on the first call.
+    Raster* GetRaster( void ) const;
 
 private:
+    void LoadLazyData( void );
+
     // Pointer to the pixel data storage.
     Raster *texRaster;
 
+    // Where to read the raster from if it has not been read yet.
+    std::atomic <lazyTextureData*> lazyData;
+
 	std::string name;
 	std::string maskName;
 	eRasterStageFilterMode filterMode;
@@ -426,6 +435,10 @@ struct TexDictionary : public RwObject
         return this->numTextures;
     }
 
+    // Reads the rasters of all textures that have been lazily loaded.
+    // After that the stream the dictionary was read from is not required anymore.
+    void LoadLazyTextures( void );
+
     // Returns the recommended texture platform for this TXD archive.
     // Use this if you want to add textures in a format that the framework recommends.
     // Can be NULL if there is no recommendation.
@@ -46,6 +46,11 @@
 // quality color-mapped images.
 #define RWLIB_INCLUDE_LIBIMAGEQUANT
 
+// Define this if you want to enable the "PVRTexLib" library for PVRTC compression.
+// It is loaded at runtime; if the library cannot be found, the built-in PVRTC
+// codec is used instead.
+#define RWLIB_INCLUDE_PVRTEXLIB
+
 // Define this if you want to use framework entry points for RenderWare in your project.
 // Those can be used to create managed RenderWare applications.
 #define RWLIB_INCLUDE_FRAMEWORK_ENTRYPOINTS
@@ -1,4 +1,5 @@
 #include <cmath>
+#include <cstring>
 
 #include "StdInc.h"
 
@@ -812,14 +813,93 @@ static std::vector<uint8>    nightColors_new;
 static std::vector<uint32>   vertexBoneIndices_new;
 static std::vector<float32>  vertexBoneWeights_new;
 
+// hash table over the temporary vertices, so we do not have to compare against all of them.
+// every slot holds (new vertex index + 1), zero marks an empty slot.
+static std::vector<uint32>   vertexHashTable;
+static std::vector<uint64>   vertexHashes_new;
+
+static inline uint64 hashVertexWord(uint64 hash, uint32 word)
+{
+	// FNV-1a over whole words.
+	hash ^= word;
+	hash *= 0x100000001B3ULL;
+
+	return hash;
+}
+
+static inline uint64 hashVertexFloat(uint64 hash, float32 value)
+{
+	// -0 and +0 compare equal, so they have to hash equal too.
+	uint32 bits = 0;
+
+	if (value != 0.0f)
+		memcpy(&bits, &value, sizeof(bits));
+
+	return hashVertexWord(hash, bits);
+}
+
+// hashes every attribute that addTempVertexIfNew compares
+static uint64 hashVertexAttributes(const Geometry &geom, uint32 index)
+{
+	uint64 hash = 0xCBF29CE484222325ULL;
+
+	for (uint32 n = 0; n < 3; n++)
+		hash = hashVertexFloat(hash, geom.vertices[index*3+n]);
+
+	if (geom.flags & FLAGS_NORMALS)
+    {
+		for (uint32 n = 0; n < 3; n++)
+			hash = hashVertexFloat(hash, geom.normals[index*3+n]);
+	}
+	if (geom.flags & FLAGS_TEXTURED || geom.flags & FLAGS_TEXTURED2)
+    {
+		for (uint32 j = 0; j < geom.numUVs; j++)
+        {
+			hash = hashVertexFloat(hash, geom.texCoords[j][index*2+0]);
+			hash = hashVertexFloat(hash, geom.texCoords[j][index*2+1]);
+		}
+	}
+	if (geom.flags & FLAGS_PRELIT)
+    {
+		const uint8 *color = &geom.vertexColors[index*4];
+
+		hash = hashVertexWord(hash, color[0] | (color[1] << 8) | (color[2] << 16) | ((uint32)color[3] << 24));
+	}
+	if (geom.hasNightColors)
+    {
+		const uint8 *color = &geom.nightColors[index*4];
+
+		hash = hashVertexWord(hash, color[0] | (color[1] << 8) | (color[2] << 16) | ((uint32)color[3] << 24));
+	}
+	if (geom.hasSkin)
+    {
+		hash = hashVertexWord(hash, geom.vertexBoneIndices[index]);
+
+		for (uint32 n = 0; n < 4; n++)
+			hash = hashVertexFloat(hash, geom.vertexBoneWeights[index*4+n]);
+	}
+
+	return hash;
+}
+
 // used only by Geometry::cleanUp()
 // adds new temporary vertex if it isn't already in the list
 // and returns the new index of that vertex
 uint32 Geometry::addTempVertexIfNew(uint32 index)
 {
+	uint64 hash = hashVertexAttributes(*this, index);
+
+	uint32 tableMask = (uint32)vertexHashTable.size() - 1;
+	uint32 slot = (uint32)(hash ^ (hash >> 32)) & tableMask;
+
 	// return if we already have the vertex
-	for (uint32 i = 0; i < vertices_new.size()/3; i++)
+	for ( ; vertexHashTable[slot] != 0; slot = (slot + 1) & tableMask)
     {
+		uint32 i = vertexHashTable[slot] - 1;
+
+		if (vertexHashes_new[i] != hash)
+			continue;
+
 		if (vertices_new[i*3+0] != vertices[index*3+0] ||
 		    vertices_new[i*3+1] != vertices[index*3+1] ||
 		    vertices_new[i*3+2] != vertices[index*3+2])
@@ -878,6 +958,10 @@ uint32 Geometry::addTempVertexIfNew(uint32 index)
 		cont: ;
 	}
 
+	// remember the new vertex in the free slot we stopped at
+	vertexHashTable[slot] = (uint32)(vertices_new.size()/3 + 1);
+	vertexHashes_new.push_back(hash);
+
 	// else add the vertex
 	vertices_new.push_back(vertices[index*3+0]);
 	vertices_new.push_back(vertices[index*3+1]);
@@ -939,10 +1023,22 @@ void Geometry::cleanUp(void)
 	vertexBoneIndices_new.clear();
 	vertexBoneWeights_new.clear();
 
+	// at most every vertex is unique, keep the table at most half full
+	uint32 oldVertexCount = vertices.size()/3;
+	uint32 tableSize = 16;
+
+	while (tableSize < oldVertexCount * 2)
+		tableSize *= 2;
+
+	vertexHashTable.assign(tableSize, 0);
+	vertexHashes_new.clear();
+	vertexHashes_new.reserve(oldVertexCount);
+
 	std::vector<uint32> newIndices;
+	newIndices.reserve(oldVertexCount);
 
 	// create new vertex list
-	for (uint32 i = 0; i < vertices.size()/3; i++)
+	for (uint32 i = 0; i < oldVertexCount; i++)
     {
 		newIndices.push_back(addTempVertexIfNew(i));
     }
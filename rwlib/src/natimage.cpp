@@ -353,12 +353,22 @@ const char* GetNativeImageTypeForStream( Stream *stream )
     {
         scoped_rwlock_reader <rwlock> ctxBrowseNativeImageTypes( imgEnv->lockImgFmtConsist );
 
+        // Native image formats with a magic number are found by one bounded header read.
+        if ( nativeImageTypeManager *sigTypeMan = imgEnv->signatureTable.MatchStream( stream ) )
+        {
+            return sigTypeMan->manData.imgType->name;
+        }
+
         int64 streamObjectPos = stream->tell();
 
         bool needsReset = false;
 
         LIST_FOREACH_BEGIN( nativeImageTypeManager, imgEnv->formatsList.root, manData.node )
 
+            // Types with signatures did not match already.
+            if ( item->manData.sigCount != 0 )
+                continue;
+
             if ( needsReset )
             {
                 stream->seek( streamObjectPos, RWSEEK_BEG );
@@ -851,6 +861,7 @@ bool RegisterNativeImageType(
     nativeImageTypeManager *typeManager,
     const char *typeName, size_t memSize, const char *friendlyName,
     const imaging_filename_ext *fileExtensions, size_t fileExtCount,
+    const imaging_stream_signature *signatures, size_t sigCount,
     const natimg_supported_native_desc *suppNatTex, size_t suppNatTexCount
 )
 {
@@ -892,11 +903,15 @@ bool RegisterNativeImageType(
                             typeManager->manData.friendlyName = friendlyName;
                             typeManager->manData.fileExtensions = fileExtensions;
                             typeManager->manData.fileExtCount = fileExtCount;
+                            typeManager->manData.signatures = signatures;
+                            typeManager->manData.sigCount = sigCount;
                             typeManager->manData.suppNatTex = suppNatTex;
                             typeManager->manData.suppNatTexCount = suppNatTexCount;
                             
                             LIST_INSERT( imgEnv->formatsList.root, typeManager->manData.node );
 
+                            imgEnv->signatureTable.AddFormat( typeManager, sigCount, signatures );
+
                             success = true;
                         }
                     }
@@ -954,6 +969,8 @@ bool UnregisterNativeImageType(
 
                     LIST_REMOVE( typeMan->manData.node );
 
+                    imgEnv->signatureTable.RemoveFormat( typeMan );
+
                     typeMan->manData.isRegistered = false;
 
                     // Delete our type.
@@ -33,6 +33,11 @@ static const imaging_filename_ext dds_file_extensions[] =
     { "dds", true }
 };
 
+static const imaging_stream_signature dds_signatures[] =
+{
+    { 0, 4, "DDS " }
+};
+
 static const natimg_supported_native_desc dds_supported_nat_textures[] =
 {
     { "Direct3D8" },
@@ -3352,6 +3357,7 @@ struct ddsNativeImageFormatTypeManager : public nativeImageTypeManager
             this,
             "DDS", sizeof( ddsNativeImage ), "DirectDraw Surface",
             dds_file_extensions, _countof( dds_file_extensions ),
+            dds_signatures, _countof( dds_signatures ),
             dds_supported_nat_textures, _countof( dds_supported_nat_textures )
         );
     }
@@ -4,6 +4,8 @@
 
 #include "pluginutil.hxx"
 
+#include "rwimaging.sig.hxx"
+
 namespace rw
 {
 
@@ -61,6 +63,8 @@ struct nativeImageTypeManager abstract
         const char *friendlyName;
         const imaging_filename_ext *fileExtensions;
         size_t fileExtCount;
+        const imaging_stream_signature *signatures;
+        size_t sigCount;
         const natimg_supported_native_desc *suppNatTex;
         size_t suppNatTexCount;
 
@@ -128,6 +132,8 @@ struct nativeImageEnv
 
         LIST_CLEAR( this->formatsList.root );
 
+        this->signatureTable.Clear();
+
         // Unregister our types.
         if ( RwTypeSystem::typeInfoBase *natImgType = this->natImgType )
         {
@@ -172,6 +178,9 @@ struct nativeImageEnv
     // List of all registered native imaging formats.
     RwList <nativeImageTypeManager> formatsList;
 
+    // Magic numbers of the registered formats that have one.
+    imagingSignatureTable <nativeImageTypeManager> signatureTable;
+
     rwlock *lockImgFmtConsist;
 
     // We want to allow plugins for the native image type.
@@ -188,6 +197,7 @@ bool RegisterNativeImageType(
     nativeImageTypeManager *typeManager,
     const char *typeName, size_t memSize, const char *friendlyName,
     const imaging_filename_ext *fileExtensions, size_t fileExtCount,
+    const imaging_stream_signature *signatures, size_t sigCount,
     const natimg_supported_native_desc *suppNatTex, size_t suppNatTexCount
 );
 bool UnregisterNativeImageType(
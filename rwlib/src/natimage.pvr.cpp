@@ -2414,12 +2414,6 @@ struct pvrNativeImageTypeManager : public nativeImageTypeManager
                     {
                         if ( isPVRTC_compressed )
                         {
-                            // Prepare decompression params.
-                            // Some handles to compressor params.
-                            pvrNativeTextureTypeProvider::PVRPixelType pvrSrcPixelType = pvrNativeEnv->PVRGetCachedPixelType( pvrtc_comprType );
-
-                            pvrNativeTextureTypeProvider::PVRPixelType pvrDstPixelType = pvrNativeEnv->pvrPixelType_rgba8888;
-
                             // Decompress the layers.
                             pvrNativeImage::mipmaps_t transLayers;
 
@@ -2449,7 +2443,7 @@ struct pvrNativeImageTypeManager : public nativeImageTypeManager
                                         surfWidth, surfHeight, layerWidth, layerHeight, srcTexels,
                                         RASTER_8888, 32, COLOR_RGBA,
                                         frm_pvrRasterFormat, frm_pvrDepth, frm_pvrRowAlignment, frm_pvrColorOrder,
-                                        pvrSrcPixelType, pvrDstPixelType,
+                                        pvrtc_comprType,
                                         dstTexels, dstDataSize
                                     );
 
@@ -2833,10 +2827,6 @@ struct pvrNativeImageTypeManager : public nativeImageTypeManager
                     uint32 comprBitDepth = getDepthByPVRFormat( pvrtc_comprType );
 
                     // Prepare PVR compression params.
-                    pvrNativeTextureTypeProvider::PVRPixelType pvrSrcPixelType = pvrNativeEnv->pvrPixelType_rgba8888;
-
-                    pvrNativeTextureTypeProvider::PVRPixelType pvrDstPixelType = pvrNativeEnv->PVRGetCachedPixelType( pvrtc_comprType );
-
                     uint32 pvrBlockWidth, pvrBlockHeight;
 
                     getPVRCompressionBlockDimensions( comprBitDepth, pvrBlockWidth, pvrBlockHeight );
@@ -2869,7 +2859,7 @@ struct pvrNativeImageTypeManager : public nativeImageTypeManager
                                 layerWidth, layerHeight, srcTexels,
                                 tmpColorDispatch, tmpPixelDepth, frm_pvrRowAlignment,
                                 RASTER_8888, 32, COLOR_RGBA,
-                                pvrSrcPixelType, pvrDstPixelType,
+                                pvrtc_comprType,
                                 pvrBlockWidth, pvrBlockHeight,
                                 comprBitDepth,
                                 dstSurfWidth, dstSurfHeight,
@@ -3714,6 +3704,7 @@ struct pvrNativeImageTypeManager : public nativeImageTypeManager
             this,
             "PVR", sizeof( pvrNativeImage ), "PowerVR Image",
             pvr_natimg_fileExt, _countof( pvr_natimg_fileExt ),
+            NULL, 0,    // legacy PVR headers carry no magic number in front.
             pvr_natimg_suppnattex, _countof( pvr_natimg_suppnattex )
         );
     }
@@ -0,0 +1,203 @@
+#ifndef _PIXELFORMAT_KERNELS_INTERNAL_INCLUDE_
+#define _PIXELFORMAT_KERNELS_INTERNAL_INCLUDE_
+
+// Row-level texel conversion kernels.
+// The colorModelDispatcher has to decide on raster format, color order and depth for every single
+// texel it touches. Since those properties stay the same for a whole mipmap layer we rather decide
+// once and then run a loop that is specialized for the format pair, possibly using SIMD.
+
+#include "pluginutil.hxx"
+
+#include "pixelformat.hxx"
+
+namespace rw
+{
+
+// Storage description of a raw color texel format.
+struct texelLayoutInfo
+{
+    eColorModel model;
+    uint32 byteSize;
+
+    // For COLORMODEL_RGBA the slots are the stored red, green, blue and alpha fields (before color ordering).
+    // For COLORMODEL_LUMINANCE slot 0 is the luminance and slot 1 is the alpha.
+    // A slot with zero bits does not exist in the format.
+    struct
+    {
+        uint32 shift;
+        uint32 bits;
+    } slots[ 4 ];
+
+    // Bits of the destination texel that the generic dispatcher never writes to.
+    uint32 preserveMask;
+};
+
+bool getTexelLayoutInfo( eRasterFormat rasterFormat, uint32 depth, texelLayoutInfo& infoOut );
+
+// Parameters that are prepared once per mipmap layer for a kernel.
+struct texelRowKernelParams
+{
+    texelLayoutInfo srcLayout;
+    texelLayoutInfo dstLayout;
+
+    // Which source slot feeds each destination slot, through which lookup table.
+    uint32 srcSlotOfDstSlot[ 4 ];
+    uint8 channelLUT[ 4 ][ 256 ];
+
+    // Used if we have to compute luminance from color, which is done in floating point.
+    uint32 srcSlotOfColor[ 4 ];
+    float colorToFloat[ 4 ][ 256 ];
+
+    // Byte shuffle mask for permutation kernels.
+    uint8 shuffleMask[ 32 ];
+};
+
+typedef void (*texelRowKernel_t)( const texelRowKernelParams& params, const void *srcRow, void *dstRow, uint32 texelCount );
+
+// Registered kernels are keyed on the full source and destination texel format.
+struct texelRowKernelKey
+{
+    eRasterFormat srcRasterFormat;
+    eColorOrdering srcColorOrder;
+    uint32 srcDepth;
+
+    eRasterFormat dstRasterFormat;
+    eColorOrdering dstColorOrder;
+    uint32 dstDepth;
+
+    inline bool operator == ( const texelRowKernelKey& right ) const
+    {
+        return
+            ( this->srcRasterFormat == right.srcRasterFormat &&
+              this->srcColorOrder == right.srcColorOrder &&
+              this->srcDepth == right.srcDepth &&
+              this->dstRasterFormat == right.dstRasterFormat &&
+              this->dstColorOrder == right.dstColorOrder &&
+              this->dstDepth == right.dstDepth );
+    }
+};
+
+enum class eTexelKernelISA
+{
+    PORTABLE,
+    SSE2,
+    AVX2
+};
+
+// A kernel that was picked for a specific format pair.
+struct texelRowConverter
+{
+    texelRowKernel_t kernel;
+    eTexelKernelISA isa;
+
+    texelRowKernelParams params;
+};
+
+struct texelKernelEnv;
+
+// Compares every kernel against the generic color dispatcher, bit for bit.
+bool VerifyTexelRowKernels( const texelKernelEnv& kernelEnv );
+
+struct texelKernelEnv
+{
+    inline void Initialize( EngineInterface *engineInterface )
+    {
+        LIST_CLEAR( this->kernels.root );
+
+        this->RegisterBuiltinKernels( engineInterface );
+
+#ifdef _DEBUG
+        // Every kernel has to produce the exact same texels as the generic dispatcher.
+        assert( VerifyTexelRowKernels( *this ) == true );
+#endif //_DEBUG
+    }
+
+    inline void Shutdown( EngineInterface *engineInterface )
+    {
+        LIST_FOREACH_BEGIN( kernelEntry, this->kernels.root, node )
+
+            item->~kernelEntry();
+
+            engineInterface->MemFree( item );
+
+        LIST_FOREACH_END
+
+        LIST_CLEAR( this->kernels.root );
+    }
+
+    struct kernelEntry
+    {
+        texelRowKernelKey key;
+
+        texelRowKernel_t kernel;
+        eTexelKernelISA isa;
+
+        RwListEntry <kernelEntry> node;
+    };
+
+    RwList <kernelEntry> kernels;
+
+    bool RegisterKernel( EngineInterface *engineInterface, const texelRowKernelKey& key, eTexelKernelISA isa, texelRowKernel_t kernel );
+
+    inline const kernelEntry* FindKernel( const texelRowKernelKey& key ) const
+    {
+        LIST_FOREACH_BEGIN( kernelEntry, this->kernels.root, node )
+
+            if ( item->key == key )
+            {
+                return item;
+            }
+
+        LIST_FOREACH_END
+
+        return NULL;
+    }
+
+private:
+    void RegisterBuiltinKernels( EngineInterface *engineInterface );
+};
+
+typedef PluginDependantStructRegister <texelKernelEnv, RwInterfaceFactory_t> texelKernelEnvRegister_t;
+
+extern texelKernelEnvRegister_t texelKernelEnvRegister;
+
+// Prepares the conversion parameters for a specific format pair.
+// Returns false if the format pair has to go through the generic color dispatcher.
+bool PrepareTexelRowConversion(
+    const texelRowKernelKey& key,
+    texelRowKernelParams& paramsOut
+);
+
+// Returns the lookup-table based kernel that handles any prepared format pair.
+texelRowKernel_t GetPortableTexelRowKernel( const texelRowKernelParams& params );
+
+// Returns the best kernel for a format pair, either registered or the portable plan-based one.
+bool FindTexelRowConverter(
+    Interface *engineInterface,
+    eRasterFormat srcRasterFormat, eColorOrdering srcColorOrder, uint32 srcDepth, ePaletteType srcPaletteType,
+    eRasterFormat dstRasterFormat, eColorOrdering dstColorOrder, uint32 dstDepth,
+    texelRowConverter& convOut
+);
+
+// Runs a kernel over a whole surface.
+void copyTexelDataByKernel(
+    const texelRowConverter& conv,
+    const void *srcTexels, void *dstTexels,
+    uint32 width, uint32 height,
+    uint32 srcRowSize, uint32 dstRowSize
+);
+
+// Converts a whole surface of raw texels, using a specialized kernel if there is one.
+// Otherwise the generic color model dispatcher is used.
+void copyTexelDataAccelerated(
+    Interface *engineInterface,
+    const void *srcTexels, void *dstTexels,
+    eRasterFormat srcRasterFormat, eColorOrdering srcColorOrder, uint32 srcDepth, ePaletteType srcPaletteType, const void *srcPaletteData, uint32 srcPaletteSize,
+    eRasterFormat dstRasterFormat, eColorOrdering dstColorOrder, uint32 dstDepth,
+    uint32 width, uint32 height,
+    uint32 srcRowSize, uint32 dstRowSize
+);
+
+};
+
+#endif //_PIXELFORMAT_KERNELS_INTERNAL_INCLUDE_
@@ -158,6 +158,28 @@ LibraryVersion HeaderInfo::getVersion(void) const
     return unpackVersion( this->packedVersion );
 }
 
+// Amount of bytes that are read ahead from streams that are not memory based.
+#define RWBLOCK_READ_AHEAD_SIZE     0x4000
+
+struct BlockProvider::ReadAheadWindow
+{
+    Stream *stream;
+
+    // Stream data starting at the absolute stream offset dataOffset.
+    const char *data;
+    int64 dataOffset;
+    size_t dataSize;
+
+    // End of the root block; nothing behind it is read ahead.
+    int64 endOffset;
+
+    // Memory based streams give us the whole root block at once.
+    bool isMapped;
+
+    char *buf;
+    size_t bufCapacity;
+};
+
 BlockProvider::BlockProvider( Stream *contextStream, eBlockMode blockMode )
 {
     this->parent = NULL;
@@ -165,6 +187,9 @@ BlockProvider::BlockProvider( Stream *contextStream, eBlockMode blockMode )
     this->isInContext = false;
     this->contextStream = contextStream;
     this->ignoreBlockRegions = contextStream->engineInterface->GetIgnoreSerializationBlockRegions();
+    this->isFlatReading = false;
+    this->readWindow = NULL;
+    this->targetStream = NULL;
 }
 
 BlockProvider::BlockProvider( Stream *contextStream, eBlockMode blockMode, bool ignoreBlockRegions )
@@ -174,6 +199,9 @@ BlockProvider::BlockProvider( Stream *contextStream, eBlockMode blockMode, bool
     this->isInContext = false;
     this->contextStream = contextStream;
     this->ignoreBlockRegions = ignoreBlockRegions;
+    this->isFlatReading = false;
+    this->readWindow = NULL;
+    this->targetStream = NULL;
 }
 
 void BlockProvider::EnterContext( void ) throw( ... )
@@ -184,12 +212,42 @@ void BlockProvider::EnterContext( void ) throw( ... )
     Stream *contextStream = this->contextStream;
     BlockProvider *parentProvider = this->parent;
 
+    if ( this->blockMode == RWBLOCKMODE_WRITE && parentProvider == NULL && contextStream != NULL )
+    {
+        Interface *engineInterface = contextStream->engineInterface;
+
+        if ( engineInterface->GetSequentialSerialization() )
+        {
+            // Assemble the block in memory, so the block headers can be written without seeking.
+            streamConstructionMemoryParam_t memParam( NULL, 0 );
+
+            Stream *blockStream = engineInterface->CreateStream( RWSTREAMTYPE_MEMORY, RWSTREAMMODE_CREATE, &memParam );
+
+            if ( blockStream == NULL )
+            {
+                throw RwBlockException( "failed to create block assembly stream" );
+            }
+
+            this->targetStream = contextStream;
+            this->contextStream = blockStream;
+
+            contextStream = blockStream;
+        }
+    }
+
     if ( this->blockMode == RWBLOCKMODE_READ )
     {
         // Read the header and set context information.
         rwBlockHeader blockHeader;
 
-        this->read_native( &blockHeader, sizeof( blockHeader ) );
+        if ( const rwBlockHeader *headerView = (const rwBlockHeader*)this->view_native( sizeof( blockHeader ) ) )
+        {
+            blockHeader = *headerView;
+        }
+        else
+        {
+            this->read_native( &blockHeader, sizeof( blockHeader ) );
+        }
 
         // Store the block context.
         this->blockContext.chunk_id = blockHeader.type;
@@ -285,6 +343,68 @@ void BlockProvider::EnterContext( void ) throw( ... )
         }
     }
 
+    // Since the block region has been verified, we can flatten the reading.
+    this->isFlatReading = false;
+    this->readWindow = NULL;
+
+    if ( this->blockMode == RWBLOCKMODE_READ && this->ignoreBlockRegions == false )
+    {
+        if ( parentProvider )
+        {
+            if ( parentProvider->isFlatReading )
+            {
+                this->isFlatReading = true;
+                this->readWindow = parentProvider->readWindow;
+            }
+        }
+        else if ( contextStream )
+        {
+            // The root provider owns the read-ahead window.
+            Interface *engineInterface = contextStream->engineInterface;
+
+            int64 blockOffset = this->blockContext.chunk_beg_offset_absolute;
+            int64 blockLength = this->blockContext.chunk_length;
+
+            const void *blockView = contextStream->view( (size_t)blockLength );
+
+            size_t bufCapacity = ( blockView != NULL ? 0 : RWBLOCK_READ_AHEAD_SIZE );
+
+            void *windowMem = engineInterface->MemAllocate( sizeof( ReadAheadWindow ) + bufCapacity );
+
+            if ( windowMem )
+            {
+                ReadAheadWindow *window = new (windowMem) ReadAheadWindow;
+
+                window->stream = contextStream;
+                window->endOffset = ( blockOffset + blockLength );
+                window->buf = (char*)( window + 1 );
+                window->bufCapacity = bufCapacity;
+                window->dataOffset = blockOffset;
+
+                if ( blockView )
+                {
+                    window->data = (const char*)blockView;
+                    window->dataSize = (size_t)blockLength;
+                    window->isMapped = true;
+                }
+                else
+                {
+                    window->data = window->buf;
+                    window->dataSize = 0;
+                    window->isMapped = false;
+                }
+
+                this->isFlatReading = true;
+                this->readWindow = window;
+            }
+            else if ( blockView )
+            {
+                // Give back what we have viewed.
+                contextStream->seek( blockOffset, RWSEEK_BEG );
+            }
+        }
+    }
+
     this->isInContext = true;
 }
 
@@ -325,9 +445,85 @@ void BlockProvider::LeaveContext( void )
         this->seek_native( endPos, RWSEEK_BEG );
     }
 
+    if ( Stream *targetStream = this->targetStream )
+    {
+        // Write the assembled block in one go.
+        Stream *blockStream = this->contextStream;
+
+        Interface *engineInterface = blockStream->engineInterface;
+
+        this->contextStream = targetStream;
+        this->targetStream = NULL;
+
+        this->isInContext = false;
+
+        try
+        {
+            size_t blockSize = (size_t)blockStream->size();
+
+            blockStream->seek( 0, RWSEEK_BEG );
+
+            const void *blockData = blockStream->view( blockSize );
+
+            if ( blockData == NULL || targetStream->write( blockData, blockSize ) != blockSize )
+            {
+                throw RwBlockException( "unfinished block write exception" );
+            }
+        }
+        catch( ... )
+        {
+            engineInterface->DeleteStream( blockStream );
+
+            throw;
+        }
+
+        engineInterface->DeleteStream( blockStream );
+    }
+
+    if ( ReadAheadWindow *window = this->readWindow )
+    {
+        if ( this->parent == NULL )
+        {
+            Interface *engineInterface = window->stream->engineInterface;
+
+            window->~ReadAheadWindow();
+
+            engineInterface->MemFree( window );
+        }
+
+        this->readWindow = NULL;
+    }
+
+    this->isFlatReading = false;
+
     this->isInContext = false;
 }
 
+void BlockProvider::AbortContext( void )
+{
+    assert( this->isInContext == true );
+
+    if ( Stream *targetStream = this->targetStream )
+    {
+        // Nothing of the block has reached the target stream yet, so it stays as it was.
+        // Target streams cannot seek, so this is the only way to not leave a broken block in them.
+        Stream *blockStream = this->contextStream;
+
+        Interface *engineInterface = blockStream->engineInterface;
+
+        this->contextStream = targetStream;
+        this->targetStream = NULL;
+
+        this->isInContext = false;
+
+        engineInterface->DeleteStream( blockStream );
+        return;
+    }
+
+    // Blocks that are written in place are closed, so that their parents stay readable.
+    this->LeaveContext();
+}
+
 void BlockProvider::read_native( void *out_buf, size_t readCount ) throw( ... )
 {
     Stream *contextStream = this->contextStream;
@@ -357,6 +553,88 @@ void BlockProvider::read_native( void *out_buf, size_t readCount ) throw( ... )
     }
 }
 
+void BlockProvider::fetch_window( int64 absOffset, size_t readCount ) throw( ... )
+{
+    ReadAheadWindow *window = this->readWindow;
+
+    if ( window->isMapped )
+    {
+        throw RwBlockException( "unfinished block read exception" );
+    }
+
+    Stream *stream = window->stream;
+
+    int64 fetchCount = std::min( (int64)window->bufCapacity, window->endOffset - absOffset );
+
+    if ( fetchCount < (int64)readCount )
+    {
+        fetchCount = readCount;
+    }
+
+    // Other users of the stream may have moved it.
+    if ( stream->tell() != absOffset )
+    {
+        stream->seek( absOffset, RWSEEK_BEG );
+    }
+
+    size_t actualReadCount = stream->read( window->buf, (size_t)fetchCount );
+
+    window->dataOffset = absOffset;
+    window->dataSize = actualReadCount;
+
+    if ( actualReadCount < readCount )
+    {
+        throw RwBlockException( "unfinished block read exception" );
+    }
+}
+
+void BlockProvider::read_flat( void *out_buf, size_t readCount ) throw( ... )
+{
+    if ( readCount == 0 )
+        return;
+
+    int64 contextSeek = this->blockContext.context_seek;
+
+    // Our block lies inside of all parents, so it is enough to stay inside of it.
+    if ( contextSeek < 0 || (int64)readCount > ( this->blockContext.chunk_length - contextSeek ) )
+    {
+        throw RwBlockException( "out-of-bounds block access" );
+    }
+
+    int64 absOffset = ( this->blockContext.chunk_beg_offset_absolute + contextSeek );
+
+    ReadAheadWindow *window = this->readWindow;
+
+    if ( window->isMapped == false && readCount > window->bufCapacity )
+    {
+        // Big reads go straight to the stream.
+        Stream *stream = window->stream;
+
+        if ( stream->tell() != absOffset )
+        {
+            stream->seek( absOffset, RWSEEK_BEG );
+        }
+
+        size_t actualReadCount = stream->read( out_buf, readCount );
+
+        if ( actualReadCount != readCount )
+        {
+            throw RwBlockException( "unfinished block read exception" );
+        }
+    }
+    else
+    {
+        if ( absOffset < window->dataOffset || (int64)readCount > ( window->dataOffset + (int64)window->dataSize - absOffset ) )
+        {
+            this->fetch_window( absOffset, readCount );
+        }
+
+        memcpy( out_buf, window->data + ( absOffset - window->dataOffset ), readCount );
+    }
+
+    this->blockContext.context_seek = ( contextSeek + readCount );
+}
+
 void BlockProvider::read( void *out_buf, size_t readCount ) throw( ... )
 {
     if ( this->isInContext == false )
@@ -364,6 +642,12 @@ void BlockProvider::read( void *out_buf, size_t readCount ) throw( ... )
         throw RwBlockException( "not in a block context" );
     }
 
+    if ( this->isFlatReading )
+    {
+        this->read_flat( out_buf, readCount );
+        return;
+    }
+
     if ( this->blockMode == RWBLOCKMODE_READ )
     {
         int64 totalStreamOffset = this->tell_absolute();
@@ -381,6 +665,78 @@ void BlockProvider::read( void *out_buf, size_t readCount ) throw( ... )
     this->blockContext.context_seek += readCount;
 }
 
+const void* BlockProvider::view_native( size_t readCount ) throw( ... )
+{
+    Stream *contextStream = this->contextStream;
+
+    if ( contextStream != NULL )
+    {
+        return contextStream->view( readCount );
+    }
+
+    BlockProvider *parentProvider = this->parent;
+
+    if ( parentProvider )
+    {
+        return parentProvider->read_view( readCount );
+    }
+
+    throw RwBlockException( "no block context for reading operation" );
+
+    return NULL;
+}
+
+const void* BlockProvider::read_view( size_t readCount ) throw( ... )
+{
+    if ( this->isInContext == false )
+    {
+        throw RwBlockException( "not in a block context" );
+    }
+
+    if ( this->isFlatReading )
+    {
+        const ReadAheadWindow *window = this->readWindow;
+
+        if ( window->isMapped == false )
+        {
+            return NULL;
+        }
+
+        int64 contextSeek = this->blockContext.context_seek;
+
+        if ( readCount != 0 && ( contextSeek < 0 || (int64)readCount > ( this->blockContext.chunk_length - contextSeek ) ) )
+        {
+            throw RwBlockException( "out-of-bounds block access" );
+        }
+
+        const void *dataView = ( window->data + ( this->blockContext.chunk_beg_offset_absolute + contextSeek - window->dataOffset ) );
+
+        this->blockContext.context_seek = ( contextSeek + readCount );
+
+        return dataView;
+    }
+
+    if ( this->blockMode == RWBLOCKMODE_READ )
+    {
+        int64 totalStreamOffset = this->tell_absolute();
+
+        // Verify this reading operation.
+        streamMemSlice_t readAccess( totalStreamOffset, readCount );
+
+        this->verifyLocalStreamAccess( readAccess );
+    }
+
+    const void *dataView = this->view_native( readCount );
+
+    if ( dataView != NULL )
+    {
+        // Advance the virtual block context seek.
+        this->blockContext.context_seek += readCount;
+    }
+
+    return dataView;
+}
+
 void BlockProvider::write_native( const void *in_buf, size_t writeCount ) throw( ... )
 {
     Stream *contextStream = this->contextStream;
@@ -417,6 +773,12 @@ void BlockProvider::write( const void *in_buf, size_t writeCount ) throw( ... )
         throw RwBlockException( "not in a block context" );
     }
 
+    if ( this->isFlatReading )
+    {
+        // The stream position is not maintained while reading flattened.
+        throw RwBlockException( "cannot write into a block that is being read" );
+    }
+
     // Create a slice that represents our stream access.
     int64 totalStreamOffset = this->tell_absolute();
 
@@ -483,8 +845,12 @@ void BlockProvider::skip( size_t skipCount ) throw( ... )
         throw RwBlockException( "not in a block context" );
     }
 
-    // Do the native operation.
-    this->skip_native( skipCount );
+    // Flattened reads start at the seek pointer, so there is nothing to do natively.
+    if ( this->isFlatReading == false )
+    {
+        // Do the native operation.
+        this->skip_native( skipCount );
+    }
 
     // Advance the virtual seek pointer.
     this->blockContext.context_seek += skipCount;
@@ -561,6 +927,18 @@ int64 BlockProvider::tell_absolute_native( void ) const
     return returnAbsolutePos;
 }
 
+Stream* BlockProvider::getContextStream( void ) const
+{
+    const BlockProvider *rootProvider = this;
+
+    while ( const BlockProvider *parentProvider = rootProvider->parent )
+    {
+        rootProvider = parentProvider;
+    }
+
+    return rootProvider->contextStream;
+}
+
 int64 BlockProvider::tell( void ) const
 {
     if ( this->isInContext == false )
@@ -607,6 +985,8 @@ void BlockProvider::seek( int64 pos, eSeekMode mode ) throw( ... )
     int64 realBlockOffset = blockBaseOffset + pos;
 
     // Transform into absolute ones now to seek on our file.
+    // Flattened reads start at the seek pointer, so they do not need that.
+    if ( this->isFlatReading == false )
     {
         int64 absoluteBlockOffset = realBlockOffset + this->blockContext.chunk_beg_offset;
 
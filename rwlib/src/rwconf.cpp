@@ -26,6 +26,14 @@ rwConfigBlock::rwConfigBlock( EngineInterface *intf )
     // Prefer the native toolchain.
     this->dxtRuntimeType = DXTRUNTIME_NATIVE;
 
+    // Prefer PVRTexLib if we can have it; the PowerVR provider falls back to
+    // the native codec if the library could not be loaded.
+#ifdef RWLIB_INCLUDE_PVRTEXLIB
+    this->pvrRuntimeType = PVRRUNTIME_PVRTEXLIB;
+#else
+    this->pvrRuntimeType = PVRRUNTIME_NATIVE;
+#endif //RWLIB_INCLUDE_PVRTEXLIB
+
     this->fixIncompatibleRasters = true;
     this->dxtPackedDecompression = false;
 
@@ -34,6 +42,16 @@ rwConfigBlock::rwConfigBlock( EngineInterface *intf )
 
     this->ignoreSerializationBlockRegions = false;
 
+    this->sequentialSerialization = false;
+
+    this->lazyTexDictionaryLoading = false;
+    this->parallelTexDictionaryLoading = false;
+
+    this->streamedImageDecoding = true;
+
+    // Use every processor for parallel work.
+    this->workerThreadCount = 0;
+
     this->enableMetaDataTagging = true;
 
     // Set per-thread states.
@@ -66,6 +84,7 @@ rwConfigBlock::rwConfigBlock( const rwConfigBlock& right )
 
     this->palRuntimeType = right.palRuntimeType;
     this->dxtRuntimeType = right.dxtRuntimeType;
+    this->pvrRuntimeType = right.pvrRuntimeType;
 
     this->warningLevel = right.warningLevel;
     this->ignoreSecureWarnings = right.ignoreSecureWarnings;
@@ -78,6 +97,15 @@ rwConfigBlock::rwConfigBlock( const rwConfigBlock& right )
 
     this->ignoreSerializationBlockRegions = right.ignoreSerializationBlockRegions;
 
+    this->sequentialSerialization = right.sequentialSerialization;
+
+    this->lazyTexDictionaryLoading = right.lazyTexDictionaryLoading;
+    this->parallelTexDictionaryLoading = right.parallelTexDictionaryLoading;
+
+    this->streamedImageDecoding = right.streamedImageDecoding;
+
+    this->workerThreadCount = right.workerThreadCount;
+
     this->enableMetaDataTagging = right.enableMetaDataTagging;
 
     // Copy per-thread states.
@@ -208,6 +236,38 @@ eDXTCompressionMethod rwConfigBlock::GetDXTRuntime( void ) const
     return this->dxtRuntimeType;
 }
 
+bool rwConfigBlock::SetPVRRuntime( ePVRCompressionMethod method )
+{
+    scoped_rwlock_writer <rwlock> lock( GetConfigLock() );
+
+    bool success = false;
+
+    if ( method == PVRRUNTIME_NATIVE )
+    {
+        // The native PVRTC codec is always available.
+        this->pvrRuntimeType = method;
+
+        success = true;
+    }
+#ifdef RWLIB_INCLUDE_PVRTEXLIB
+    else if ( method == PVRRUNTIME_PVRTEXLIB )
+    {
+        this->pvrRuntimeType = method;
+
+        success = true;
+    }
+#endif //RWLIB_INCLUDE_PVRTEXLIB
+
+    return success;
+}
+
+ePVRCompressionMethod rwConfigBlock::GetPVRRuntime( void ) const
+{
+    scoped_rwlock_reader <rwlock> lock( GetConfigLock() );
+
+    return this->pvrRuntimeType;
+}
+
 void rwConfigBlock::SetFixIncompatibleRasters( bool enable )
 {
     scoped_rwlock_writer <rwlock> lock( GetConfigLock() );
@@ -278,6 +338,76 @@ bool rwConfigBlock::GetIgnoreSerializationBlockRegions( void ) const
     return this->ignoreSerializationBlockRegions;
 }
 
+void rwConfigBlock::SetSequentialSerialization( bool sequential )
+{
+    scoped_rwlock_writer <rwlock> lock( GetConfigLock() );
+
+    this->sequentialSerialization = sequential;
+}
+
+bool rwConfigBlock::GetSequentialSerialization( void ) const
+{
+    scoped_rwlock_reader <rwlock> lock( GetConfigLock() );
+
+    return this->sequentialSerialization;
+}
+
+void rwConfigBlock::SetLazyTexDictionaryLoading( bool lazyLoad )
+{
+    scoped_rwlock_writer <rwlock> lock( GetConfigLock() );
+
+    this->lazyTexDictionaryLoading = lazyLoad;
+}
+
+bool rwConfigBlock::GetLazyTexDictionaryLoading( void ) const
+{
+    scoped_rwlock_reader <rwlock> lock( GetConfigLock() );
+
+    return this->lazyTexDictionaryLoading;
+}
+
+void rwConfigBlock::SetParallelTexDictionaryLoading( bool parallelLoad )
+{
+    scoped_rwlock_writer <rwlock> lock( GetConfigLock() );
+
+    this->parallelTexDictionaryLoading = parallelLoad;
+}
+
+bool rwConfigBlock::GetParallelTexDictionaryLoading( void ) const
+{
+    scoped_rwlock_reader <rwlock> lock( GetConfigLock() );
+
+    return this->parallelTexDictionaryLoading;
+}
+
+void rwConfigBlock::SetStreamedImageDecoding( bool streamed )
+{
+    scoped_rwlock_writer <rwlock> lock( GetConfigLock() );
+
+    this->streamedImageDecoding = streamed;
+}
+
+bool rwConfigBlock::GetStreamedImageDecoding( void ) const
+{
+    scoped_rwlock_reader <rwlock> lock( GetConfigLock() );
+
+    return this->streamedImageDecoding;
+}
+
+void rwConfigBlock::SetWorkerThreadCount( uint32 count )
+{
+    scoped_rwlock_writer <rwlock> lock( GetConfigLock() );
+
+    this->workerThreadCount = count;
+}
+
+uint32 rwConfigBlock::GetWorkerThreadCount( void ) const
+{
+    scoped_rwlock_reader <rwlock> lock( GetConfigLock() );
+
+    return this->workerThreadCount;
+}
+
 rwConfigEnvRegister_t rwConfigEnvRegister;
 
 void registerConfigurationEnvironment( void )
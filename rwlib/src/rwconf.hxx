@@ -40,6 +40,9 @@ struct rwConfigBlock
     void                        SetDXTRuntime( eDXTCompressionMethod method );
     eDXTCompressionMethod       GetDXTRuntime( void ) const;
 
+    bool                        SetPVRRuntime( ePVRCompressionMethod method );
+    ePVRCompressionMethod       GetPVRRuntime( void ) const;
+
     void                        SetFixIncompatibleRasters( bool doFix );
     bool                        GetFixIncompatibleRasters( void ) const;
 
@@ -55,6 +58,21 @@ struct rwConfigBlock
     void                        SetIgnoreSerializationBlockRegions( bool doIgnore );
     bool                        GetIgnoreSerializationBlockRegions( void ) const;
 
+    void                        SetSequentialSerialization( bool sequential );
+    bool                        GetSequentialSerialization( void ) const;
+
+    void                        SetLazyTexDictionaryLoading( bool lazyLoad );
+    bool                        GetLazyTexDictionaryLoading( void ) const;
+
+    void                        SetParallelTexDictionaryLoading( bool parallelLoad );
+    bool                        GetParallelTexDictionaryLoading( void ) const;
+
+    void                        SetStreamedImageDecoding( bool streamed );
+    bool                        GetStreamedImageDecoding( void ) const;
+
+    void                        SetWorkerThreadCount( uint32 count );
+    uint32                      GetWorkerThreadCount( void ) const;
+
     EngineInterface *engineInterface;
 
 private:
@@ -66,6 +84,7 @@ private:
 
     ePaletteRuntimeType palRuntimeType;
     eDXTCompressionMethod dxtRuntimeType;
+    ePVRCompressionMethod pvrRuntimeType;
     
     int warningLevel;
     bool ignoreSecureWarnings;
@@ -78,6 +97,15 @@ private:
 
     bool ignoreSerializationBlockRegions;
 
+    bool sequentialSerialization;
+
+    bool lazyTexDictionaryLoading;
+    bool parallelTexDictionaryLoading;
+
+    bool streamedImageDecoding;
+
+    uint32 workerThreadCount;
+
     bool enableMetaDataTagging;
 
 public:
@@ -38,14 +38,22 @@ struct ANSIFileInterface : public FileInterface
         return fwrite( inBuf, 1, writeCount, (FILE*)ptr );
     }
 
-    bool    SeekStream( filePtr_t ptr, long streamOffset, int type ) override
+    bool    SeekStream( filePtr_t ptr, int64 streamOffset, int type ) override
     {
-        return ( fseek( (FILE*)ptr, streamOffset, type ) == 0 );
+#ifdef _MSC_VER
+        return ( _fseeki64( (FILE*)ptr, streamOffset, type ) == 0 );
+#else
+        return ( fseeko64( (FILE*)ptr, (off64_t)streamOffset, type ) == 0 );
+#endif //_MSC_VER
     }
 
-    long    TellStream( filePtr_t ptr ) override
+    int64   TellStream( filePtr_t ptr ) override
     {
-        return ftell( (FILE*)ptr );
+#ifdef _MSC_VER
+        return _ftelli64( (FILE*)ptr );
+#else
+        return ftello64( (FILE*)ptr );
+#endif //_MSC_VER
     }
 
     bool    IsEOFStream( filePtr_t ptr ) override
@@ -53,11 +61,17 @@ struct ANSIFileInterface : public FileInterface
         return ( feof( (FILE*)ptr ) != 0 );
     }
 
-    long    SizeStream( filePtr_t ptr ) override
+    int64   SizeStream( filePtr_t ptr ) override
     {
-        struct stat stats;
+#ifdef _MSC_VER
+        struct _stat64 stats;
 
-        int result = fstat( fileno( (FILE*)ptr ), &stats );
+        int result = _fstat64( _fileno( (FILE*)ptr ), &stats );
+#else
+        struct stat64 stats;
+
+        int result = fstat64( fileno( (FILE*)ptr ), &stats );
+#endif //_MSC_VER
 
         if ( result != 0 )
             return -1;
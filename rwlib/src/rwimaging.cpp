@@ -8,6 +8,8 @@
 
 #include "txdread.d3d.dxt.hxx"
 
+#include "pixelformat.kernels.hxx"
+
 #include <PluginHelpers.h>
 
 #include <map>
@@ -133,6 +135,216 @@ inline void CompatibilityTransformImagingLayer( Interface *engineInterface, cons
     layerOut.compressionType = dstCompressionType;
 }
 
+// Puts decoded rows straight into the format that was chosen by a target selector.
+// Raw targets are converted row by row; palette and compressed targets get the source format.
+struct imagingTargetRowSink : public imagingRowSink
+{
+    inline imagingTargetRowSink( Interface *engineInterface, const imagingTargetFormatSelector& targetSelector )
+        : targetSelector( targetSelector )
+    {
+        this->engineInterface = engineInterface;
+        this->hasBegun = false;
+        this->dstTexels = NULL;
+        this->dstDataSize = 0;
+        this->srcPaletteData = NULL;
+        this->rowsPut = 0;
+    }
+
+    inline ~imagingTargetRowSink( void )
+    {
+        Interface *engineInterface = this->engineInterface;
+
+        if ( void *dstTexels = this->dstTexels )
+        {
+            engineInterface->PixelFree( dstTexels );
+        }
+
+        if ( void *srcPaletteData = this->srcPaletteData )
+        {
+            engineInterface->PixelFree( srcPaletteData );
+        }
+    }
+
+    enum class eSinkMode
+    {
+        COPY,
+        CONVERT
+    };
+
+    void BeginImage(
+        uint32 width, uint32 height,
+        eRasterFormat rasterFormat, uint32 depth, eColorOrdering colorOrder,
+        ePaletteType paletteType, void *paletteData, uint32 paletteSize
+    ) override
+    {
+        if ( this->hasBegun )
+        {
+            throw RwException( "imaging row sink has been started twice" );
+        }
+
+        // We own the palette from here on.
+        this->srcPaletteData = paletteData;
+
+        Interface *engineInterface = this->engineInterface;
+
+        this->width = width;
+        this->height = height;
+
+        pixelFormat srcFormat;
+        srcFormat.rasterFormat = rasterFormat;
+        srcFormat.depth = depth;
+        srcFormat.rowAlignment = 1;
+        srcFormat.colorOrder = colorOrder;
+        srcFormat.paletteType = paletteType;
+        srcFormat.compressionType = RWCOMPRESS_NONE;
+
+        this->srcFormat = srcFormat;
+        this->srcPaletteSize = paletteSize;
+        this->srcRowSize = getRasterDataRowSize( width, depth, 1 );
+
+        pixelFormat dstFormat;
+
+        this->targetSelector.ChooseTargetFormat( srcFormat, paletteSize, dstFormat );
+
+        bool isSameFormat =
+            ( dstFormat.rasterFormat == rasterFormat && dstFormat.depth == depth &&
+              dstFormat.colorOrder == colorOrder && dstFormat.paletteType == paletteType &&
+              dstFormat.compressionType == RWCOMPRESS_NONE );
+
+        // We cannot create palettes while streaming.
+        // Such targets get the source format and are converted by the caller.
+        if ( isSameFormat || dstFormat.paletteType != PALETTE_NONE || dstFormat.compressionType != RWCOMPRESS_NONE )
+        {
+            this->mode = eSinkMode::COPY;
+
+            uint32 dstRowAlignment = dstFormat.rowAlignment;
+
+            dstFormat = srcFormat;
+
+            if ( isSameFormat && dstRowAlignment != 0 )
+            {
+                dstFormat.rowAlignment = dstRowAlignment;
+            }
+        }
+        else
+        {
+            this->mode = eSinkMode::CONVERT;
+
+            if ( dstFormat.rowAlignment == 0 )
+            {
+                dstFormat.rowAlignment = srcFormat.rowAlignment;
+            }
+        }
+
+        this->dstRowSize = getRasterDataRowSize( width, dstFormat.depth, dstFormat.rowAlignment );
+
+        this->dstDataSize = getRasterDataSizeByRowSize( this->dstRowSize, height );
+
+        this->dstFormat = dstFormat;
+
+        this->dstTexels = engineInterface->PixelAllocate( this->dstDataSize );
+
+        if ( this->dstTexels == NULL )
+        {
+            throw RwException( "failed to allocate destination buffer for streamed image decoding" );
+        }
+
+        this->hasBegun = true;
+    }
+
+    void PutRow( uint32 row, const void *rowData ) override
+    {
+        if ( !this->hasBegun || row >= this->height )
+        {
+            throw RwException( "invalid row put into imaging row sink" );
+        }
+
+        eSinkMode mode = this->mode;
+
+        if ( mode == eSinkMode::COPY )
+        {
+            memcpy( getTexelDataRow( this->dstTexels, this->dstRowSize, row ), rowData, this->srcRowSize );
+        }
+        else if ( mode == eSinkMode::CONVERT )
+        {
+            const pixelFormat& srcFormat = this->srcFormat;
+            const pixelFormat& dstFormat = this->dstFormat;
+
+            copyTexelDataAccelerated(
+                this->engineInterface,
+                rowData, getTexelDataRow( this->dstTexels, this->dstRowSize, row ),
+                srcFormat.rasterFormat, srcFormat.colorOrder, srcFormat.depth, srcFormat.paletteType, this->srcPaletteData, this->srcPaletteSize,
+                dstFormat.rasterFormat, dstFormat.colorOrder, dstFormat.depth,
+                this->width, 1,
+                this->srcRowSize, this->dstRowSize
+            );
+        }
+
+        this->rowsPut++;
+    }
+
+    // Gives the finished image to the runtime.
+    inline void FinishImage( imagingLayerTraversal& layerOut )
+    {
+        if ( !this->hasBegun || this->rowsPut != this->height )
+        {
+            throw RwException( "incomplete image put into imaging row sink" );
+        }
+
+        const pixelFormat& dstFormat = this->dstFormat;
+
+        layerOut.layerWidth = this->width;
+        layerOut.layerHeight = this->height;
+        layerOut.mipWidth = this->width;
+        layerOut.mipHeight = this->height;
+        layerOut.texelSource = this->dstTexels;
+        layerOut.dataSize = this->dstDataSize;
+
+        layerOut.rasterFormat = dstFormat.rasterFormat;
+        layerOut.depth = dstFormat.depth;
+        layerOut.rowAlignment = dstFormat.rowAlignment;
+        layerOut.colorOrder = dstFormat.colorOrder;
+        layerOut.paletteType = dstFormat.paletteType;
+        layerOut.paletteData = NULL;
+        layerOut.paletteSize = 0;
+        layerOut.compressionType = dstFormat.compressionType;
+
+        layerOut.hasAlpha = false;
+
+        // The layer owns the buffers now.
+        if ( dstFormat.paletteType != PALETTE_NONE )
+        {
+            layerOut.paletteData = this->srcPaletteData;
+            layerOut.paletteSize = this->srcPaletteSize;
+
+            this->srcPaletteData = NULL;
+        }
+
+        this->dstTexels = NULL;
+    }
+
+private:
+    Interface *engineInterface;
+    const imagingTargetFormatSelector& targetSelector;
+
+    bool hasBegun;
+    eSinkMode mode;
+
+    uint32 width, height;
+
+    pixelFormat srcFormat;
+    void *srcPaletteData;
+    uint32 srcPaletteSize;
+    uint32 srcRowSize;
+
+    pixelFormat dstFormat;
+    void *dstTexels;
+    uint32 dstDataSize;
+    uint32 dstRowSize;
+
+    uint32 rowsPut;
+};
+
 struct rwImagingEnv
 {
     inline void Initialize( Interface *engineInterface )
@@ -151,6 +363,7 @@ struct rwImagingEnv
         const char *formatName;
         uint32 num_ext;
         const imaging_filename_ext *ext_array;
+        uint32 num_sig;
         imagingFormatExtension *intf;
     };
 
@@ -158,59 +371,83 @@ struct rwImagingEnv
 
     formatList_t registeredFormats;
 
-    inline bool Deserialize( Interface *engineInterface, Stream *inputStream, imagingLayerTraversal& layerOut ) const
+    // Magic numbers of all registered formats that have one.
+    imagingSignatureTable <imagingFormatExtension> signatureTable;
+
+    inline const imagingFormatExtension* DetectStreamFormat( Interface *engineInterface, Stream *inputStream ) const
     {
-        // Loop through all imaging extensions and check which one identifies with the given stream.
-        // For the one that identifies with it, try to deserialize the picture data with it.
+        // Most formats are identified by their magic number, which needs just one bounded read.
+        if ( const imagingFormatExtension *sigExt = this->signatureTable.MatchStream( inputStream ) )
+        {
+            return sigExt;
+        }
+
+        // Ask the imaging extensions without a magic number whether they identify with the given stream.
         const int64 rasterStreamPos = inputStream->tell();
 
         const imagingFormatExtension *supportedExt = NULL;
 
+        bool needsPositionReset = false;
+
+        for ( rwImagingEnv::formatList_t::const_iterator iter = this->registeredFormats.cbegin(); iter != this->registeredFormats.cend(); iter++ )
         {
-            bool needsPositionReset = false;
+            const rwImagingEnv::registeredExtension& regExt = (*iter).second;
+
+            // Formats with signatures did not match already.
+            if ( regExt.num_sig != 0 )
+                continue;
 
-            for ( rwImagingEnv::formatList_t::const_iterator iter = this->registeredFormats.cbegin(); iter != this->registeredFormats.cend(); iter++ )
+            if ( needsPositionReset )
             {
-                if ( needsPositionReset )
-                {
-                    inputStream->seek( rasterStreamPos, eSeekMode::RWSEEK_BEG );
-                
-                    needsPositionReset = false;
-                }
+                inputStream->seek( rasterStreamPos, eSeekMode::RWSEEK_BEG );
+            
+                needsPositionReset = false;
+            }
 
-                // Ask the imaging extension for support.
-                const imagingFormatExtension *imgExt = (*iter).second.intf;
+            // Ask the imaging extension for support.
+            const imagingFormatExtension *imgExt = regExt.intf;
 
-                bool hasSupport = false;
+            bool hasSupport = false;
 
-                try
-                {
-                    hasSupport = imgExt->IsStreamCompatible( engineInterface, inputStream );
-                }
-                catch( RwException& )
-                {
-                    // We do not have support, I guess.
-                    hasSupport = false;
-                }
+            try
+            {
+                hasSupport = imgExt->IsStreamCompatible( engineInterface, inputStream );
+            }
+            catch( RwException& )
+            {
+                // We do not have support, I guess.
+                hasSupport = false;
+            }
 
-                if ( hasSupport )
-                {
-                    supportedExt = imgExt;
-                    break;
-                }
+            // The probe has moved the stream.
+            needsPositionReset = true;
 
-                // We continue searching.
-                needsPositionReset = true;
+            if ( hasSupport )
+            {
+                supportedExt = imgExt;
+                break;
             }
         }
 
+        if ( needsPositionReset )
+        {
+            inputStream->seek( rasterStreamPos, eSeekMode::RWSEEK_BEG );
+        }
+
+        return supportedExt;
+    }
+
+    inline bool Deserialize( Interface *engineInterface, Stream *inputStream, imagingLayerTraversal& layerOut ) const
+    {
+        // Find the imaging extension that identifies with the given stream.
+        // Then try to deserialize the picture data with it.
+        const imagingFormatExtension *supportedExt = DetectStreamFormat( engineInterface, inputStream );
+
         // If we have a valid supported extension, try to fetch it's pixel data and put it into a Bitmap.
         if ( supportedExt != NULL )
         {
             imagingLayerTraversal fetchedLayer;
 
-            inputStream->seek( rasterStreamPos, eSeekMode::RWSEEK_BEG );
-
             // Fetch stuff.
             {
                 supportedExt->DeserializeImage( engineInterface, inputStream, fetchedLayer );
@@ -225,6 +462,34 @@ struct rwImagingEnv
         return false;
     }
 
+    inline bool DeserializeToFormat( Interface *engineInterface, Stream *inputStream, const imagingTargetFormatSelector& targetSelector, imagingLayerTraversal& layerOut ) const
+    {
+        const imagingFormatExtension *supportedExt = DetectStreamFormat( engineInterface, inputStream );
+
+        if ( supportedExt == NULL )
+        {
+            return false;
+        }
+
+        // Formats that decode row by row convert each row as soon as it is decoded.
+        if ( engineInterface->GetStreamedImageDecoding() )
+        {
+            imagingTargetRowSink rowSink( engineInterface, targetSelector );
+
+            bool hasStreamed = supportedExt->DeserializeImageRows( engineInterface, inputStream, rowSink );
+
+            if ( hasStreamed )
+            {
+                rowSink.FinishImage( layerOut );
+                return true;
+            }
+        }
+
+        // Otherwise the caller converts the whole image.
+        supportedExt->DeserializeImage( engineInterface, inputStream, layerOut );
+        return true;
+    }
+
     inline imagingFormatExtension* FindSupportedFormat( const char *formatDescriptor ) const
     {
         imagingFormatExtension *fittingFormat = NULL;
@@ -304,6 +569,30 @@ inline rwImagingEnv* GetImagingEnvironment( Interface *engineInterface )
 
 // We also have native raster serialization functions.
 // These methods should be used if the target image should store optimized texture data.
+#ifdef RWLIB_INCLUDE_IMAGING
+inline void ImagingLayerToRawMipmapLayer( const imagingLayerTraversal& travData, rawMipmapLayer& rawLayer )
+{
+    // Just give the data to the runtime.
+    rawLayer.mipData.width = travData.mipWidth;
+    rawLayer.mipData.height = travData.mipHeight;
+    rawLayer.mipData.layerWidth = travData.layerWidth;
+    rawLayer.mipData.layerHeight = travData.layerHeight;
+    rawLayer.mipData.texels = travData.texelSource;
+    rawLayer.mipData.dataSize = travData.dataSize;
+
+    rawLayer.rasterFormat = travData.rasterFormat;
+    rawLayer.depth = travData.depth;
+    rawLayer.rowAlignment = travData.rowAlignment;
+    rawLayer.colorOrder = travData.colorOrder;
+    rawLayer.paletteType = travData.paletteType;
+    rawLayer.paletteData = travData.paletteData;
+    rawLayer.paletteSize = travData.paletteSize;
+    rawLayer.compressionType = travData.compressionType;
+
+    rawLayer.hasAlpha = false;  // TODO.
+}
+#endif //RWLIB_INCLUDE_IMAGING
+
 bool DeserializeMipmapLayer( Stream *inputStream, rawMipmapLayer& rawLayer )
 {
     bool success = false;
@@ -320,24 +609,7 @@ bool DeserializeMipmapLayer( Stream *inputStream, rawMipmapLayer& rawLayer )
 
         if ( hasDeserialized )
         {
-            // Just give the data to the runtime.
-            rawLayer.mipData.width = travData.mipWidth;
-            rawLayer.mipData.height = travData.mipHeight;
-            rawLayer.mipData.layerWidth = travData.layerWidth;
-            rawLayer.mipData.layerHeight = travData.layerHeight;
-            rawLayer.mipData.texels = travData.texelSource;
-            rawLayer.mipData.dataSize = travData.dataSize;
-
-            rawLayer.rasterFormat = travData.rasterFormat;
-            rawLayer.depth = travData.depth;
-            rawLayer.rowAlignment = travData.rowAlignment;
-            rawLayer.colorOrder = travData.colorOrder;
-            rawLayer.paletteType = travData.paletteType;
-            rawLayer.paletteData = travData.paletteData;
-            rawLayer.paletteSize = travData.paletteSize;
-            rawLayer.compressionType = travData.compressionType;
-
-            rawLayer.hasAlpha = false;  // TODO.
+            ImagingLayerToRawMipmapLayer( travData, rawLayer );
 
             // Done!
             success = true;
@@ -348,6 +620,31 @@ bool DeserializeMipmapLayer( Stream *inputStream, rawMipmapLayer& rawLayer )
     return success;
 }
 
+bool DeserializeMipmapLayerToFormat( Stream *inputStream, const imagingTargetFormatSelector& targetSelector, rawMipmapLayer& rawLayer )
+{
+    bool success = false;
+
+#ifdef RWLIB_INCLUDE_IMAGING
+    Interface *engineInterface = inputStream->engineInterface;
+
+    if ( const rwImagingEnv *imgEnv = GetImagingEnvironment( engineInterface ) )
+    {
+        imagingLayerTraversal travData;
+
+        bool hasDeserialized = imgEnv->DeserializeToFormat( engineInterface, inputStream, targetSelector, travData );
+
+        if ( hasDeserialized )
+        {
+            ImagingLayerToRawMipmapLayer( travData, rawLayer );
+
+            success = true;
+        }
+    }
+#endif //RWLIB_INCLUDE_IMAGING
+
+    return success;
+}
+
 bool SerializeMipmapLayer( Stream *outputStream, const char *formatDescriptor, const rawMipmapLayer& rawLayer )
 {
     bool success = false;
@@ -404,9 +701,22 @@ bool DeserializeImage( Stream *inputStream, Bitmap& outputPixels )
 
     if ( const rwImagingEnv *imgEnv = GetImagingEnvironment( engineInterface ) )
     {
+        // Bitmaps store raw colors without palette.
+        struct bitmapTargetSelector : public imagingTargetFormatSelector
+        {
+            void ChooseTargetFormat( const pixelFormat& srcFormat, uint32 srcPaletteSize, pixelFormat& dstFormatOut ) const override
+            {
+                dstFormatOut = srcFormat;
+                dstFormatOut.depth = Bitmap::getRasterFormatDepth( srcFormat.rasterFormat );
+                dstFormatOut.paletteType = PALETTE_NONE;
+            }
+        };
+
+        bitmapTargetSelector targetSelector;
+
         imagingLayerTraversal fetchedLayer;
 
-        bool hasFetchedLayer = imgEnv->Deserialize( engineInterface, inputStream, fetchedLayer );
+        bool hasFetchedLayer = imgEnv->DeserializeToFormat( engineInterface, inputStream, targetSelector, fetchedLayer );
 
         if ( hasFetchedLayer )
         {
@@ -601,7 +911,12 @@ bool SerializeImage( Stream *outputStream, const char *formatDescriptor, const B
     return success;
 }
 
-bool RegisterImagingFormat( Interface *engineInterface, const char *formatName, uint32 num_ext, const imaging_filename_ext *ext_array, imagingFormatExtension *intf )
+bool RegisterImagingFormat(
+    Interface *engineInterface, const char *formatName,
+    uint32 num_ext, const imaging_filename_ext *ext_array,
+    uint32 num_sig, const imaging_stream_signature *sig_array,
+    imagingFormatExtension *intf
+)
 {
     bool success = false;
 
@@ -618,10 +933,13 @@ bool RegisterImagingFormat( Interface *engineInterface, const char *formatName,
             newExt.formatName = formatName;
             newExt.num_ext = num_ext;
             newExt.ext_array = ext_array;
+            newExt.num_sig = num_sig;
             newExt.intf = intf;
 
             imgEnv->registeredFormats[ formatName ] = newExt;
 
+            imgEnv->signatureTable.AddFormat( intf, num_sig, sig_array );
+
             success = true;
         }
     }
@@ -646,6 +964,8 @@ bool UnregisterImagingFormat( Interface *engineInterface, imagingFormatExtension
             if ( regExt.intf == intf )
             {
                 // Remove us.
+                imgEnv->signatureTable.RemoveFormat( intf );
+
                 imgEnv->registeredFormats.erase( iter );
 
                 success = true;
@@ -1,4 +1,6 @@
 // Internal header for the imaging components and environment.
+#include "rwimaging.sig.hxx"
+
 namespace rw
 {
 
@@ -23,6 +25,23 @@ struct imagingLayerTraversal
     bool hasAlpha;  // only valid for deserialization, if capabilities say so.
 };
 
+// Receives the rows of an image while it is being decoded.
+// This way an image can be put into its final format without a full-size intermediate buffer.
+struct imagingRowSink abstract
+{
+    // Called once before the first row, with the format of the rows that follow.
+    // The sink takes over the palette data, which has to be allocated using PixelAllocate.
+    virtual void BeginImage(
+        uint32 width, uint32 height,
+        eRasterFormat rasterFormat, uint32 depth, eColorOrdering colorOrder,
+        ePaletteType paletteType, void *paletteData, uint32 paletteSize
+    ) = 0;
+
+    // Every row is put exactly once, either top to bottom or bottom to top.
+    // Rows are packed with byte alignment.
+    virtual void PutRow( uint32 row, const void *rowData ) = 0;
+};
+
 // Interface for various image formats that this library should support.
 struct imagingFormatExtension abstract
 {
@@ -37,12 +56,27 @@ struct imagingFormatExtension abstract
     // Pull and fetch methods.
     virtual void DeserializeImage( Interface *engineInterface, Stream *inputStream, imagingLayerTraversal& outputPixels ) const = 0;
     virtual void SerializeImage( Interface *engineInterface, Stream *outputStream, const imagingLayerTraversal& inputPixels ) const = 0;
+
+    // Decodes the image row by row into a sink.
+    // Formats that cannot do that return false before reading anything; they are read using DeserializeImage instead.
+    virtual bool DeserializeImageRows( Interface *engineInterface, Stream *inputStream, imagingRowSink& rowSink ) const
+    {
+        return false;
+    }
 };
 
 #define IMAGING_COUNT_EXT(x)    ( sizeof(x) / sizeof(*x) )
 
 // Function to register new imaging formats.
-bool RegisterImagingFormat( Interface *engineInterface, const char *formatName, uint32 num_ext, const imaging_filename_ext *ext_array, imagingFormatExtension *intf );
+// Formats that begin with a magic number should pass it as signature, so that they are detected without probing.
+// A stream that matches a signature is handed to its format without calling IsStreamCompatible.
+// Formats without signatures (TGA) are probed after no signature has matched.
+bool RegisterImagingFormat(
+    Interface *engineInterface, const char *formatName,
+    uint32 num_ext, const imaging_filename_ext *ext_array,
+    uint32 num_sig, const imaging_stream_signature *sig_array,
+    imagingFormatExtension *intf
+);
 bool UnregisterImagingFormat( Interface *engineInterface, imagingFormatExtension *intf );
 
 }
\ No newline at end of file
@@ -26,6 +26,12 @@ static const imaging_filename_ext jpeg_ext[] =
     { "JPG", true }
 };
 
+// Start of image marker.
+static const imaging_stream_signature jpeg_sig[] =
+{
+    { 0, 2, "\xFF\xD8" }
+};
+
 // JPEG compliant serialization library for RenderWare.
 struct jpegImagingExtension : public imagingFormatExtension
 {
@@ -776,7 +782,7 @@ struct jpegImagingExtension : public imagingFormatExtension
 
     inline void Initialize( Interface *engineInterface )
     {
-        RegisterImagingFormat( engineInterface, "Joint Photographic Experts Group", IMAGING_COUNT_EXT(jpeg_ext), jpeg_ext, this );
+        RegisterImagingFormat( engineInterface, "Joint Photographic Experts Group", IMAGING_COUNT_EXT(jpeg_ext), jpeg_ext, IMAGING_COUNT_SIG(jpeg_sig), jpeg_sig, this );
     }
 
     inline void Shutdown( Interface *engineInterface )
@@ -33,6 +33,11 @@ static const imaging_filename_ext png_ext[] =
     { "PNG", true }
 };
 
+static const imaging_stream_signature png_sig[] =
+{
+    { 0, 8, "\x89PNG\r\n\x1A\n" }
+};
+
 struct pngImagingExtension : public imagingFormatExtension
 {
     struct png_chunk_header
@@ -176,401 +181,549 @@ struct pngImagingExtension : public imagingFormatExtension
         }
     }
 
-    void DeserializeImage( Interface *engineInterface, Stream *inputStream, imagingLayerTraversal& outputPixels ) const override
+    // Format of the rows that libpng delivers after the transformations have been set up.
+    struct png_image_header
     {
-        // We use this meta information to interface back with the RW core.
-        png_stream_info meta_info;
-        meta_info.engineInterface = engineInterface;
-        meta_info.usedStream = inputStream;
+        uint32 width, height;
+        eRasterFormat rasterFormat;
+        uint32 itemDepth;
+        eColorOrdering colorOrder;
+        ePaletteType paletteType;
+        void *paletteData;
+        uint32 paletteSize;
+    };
 
-        // Initialize our read structure.
-        png_structp read_info = png_create_read_struct_2(
-            PNG_LIBPNG_VER_STRING, &meta_info, png_error_routine, png_warning_routine,
-            &meta_info, png_malloc_routine, png_memfree_routine
+    // Maps the PNG color type to a RenderWare format and reads the palette, if any.
+    // The palette is allocated using PixelAllocate and belongs to the caller.
+    static void ReadPNGHeader( Interface *engineInterface, png_structp read_info, png_infop img_info, png_image_header& headerOut )
+    {
+        png_read_info( read_info, img_info );
+
+        // Read image meta information.
+        png_uint_32 width, height;
+        int png_depth, color_type, interlace_method,
+            compression_method, filter_method;
+
+        png_uint_32 ihdrResult = png_get_IHDR(
+            read_info, img_info, &width, &height, &png_depth, &color_type,
+            &interlace_method, &compression_method, &filter_method
         );
 
-        if ( read_info == NULL )
+        // We must have image information.
+        if ( ihdrResult == 0 )
         {
-            throw RwException( "failed to allocate PNG read struct" );
+            throw RwException( "PNG error: missing image meta information" );
+        }
+        
+        if ( color_type & ~0x07 )
+        {
+            throw RwException( "PNG error: unknown color type" );
         }
 
-        try
+        // Determine how we can map this PNG to RW original types.
+        eRasterFormat rasterFormat;
+        uint32 depth;
+        eColorOrdering colorOrder = COLOR_RGBA;
+
+        ePaletteType paletteType = PALETTE_NONE;
+        uint32 paletteSize = 0;
+
+        uint32 itemDepth;
+
+        bool directAcquireByPixelFormat = false;
+
+        if ( color_type == 0 )
         {
-            // Now initialize our info struct.
-            png_infop img_info = png_create_info_struct( read_info );
+            if ( png_depth == 1 || png_depth == 2 || png_depth == 4 || png_depth == 8 || png_depth == 16 )
+            {
+                // We are a grayscale image without palette and no alpha.
+                rasterFormat = RASTER_LUM;  // obviously 8bit LUM.
+                depth = 8;
+                itemDepth = 8;
 
-            if ( img_info == NULL )
+                // We always directly acquire this.
+                directAcquireByPixelFormat = true;
+
+                if ( png_depth < 8 )
+                {
+                    // Expand to full depth, please.
+                    png_set_expand_gray_1_2_4_to_8( read_info );
+                }
+                else if ( png_depth == 16 )
+                {
+                    // Warn the user of lossy PNG conversion.
+                    engineInterface->PushWarning( "lossy 16bit grayscale conversion to 8bit LUM8" );
+
+                    png_set_scale_16( read_info );
+                }
+            }
+            else
             {
-                throw RwException( "failed to allocate PNG info struct" );
+                throw RwException( "unknown .png grayscale format" );
             }
-
-            try
+        }
+        else if ( color_type == 2 )
+        {
+            if ( png_depth == 8 || png_depth == 16 )
             {
-                // Prepare the PNG environment for reading.
-                png_set_read_fn( read_info, &meta_info, png_read_routine );
+                // We are a color image without palette and no alpha.
+                rasterFormat = RASTER_888;
+                depth = 24;
+                itemDepth = 24;
 
-                png_read_info( read_info, img_info );
+                // Always directly acquire.
+                directAcquireByPixelFormat = true;
 
-                // Read image meta information.
-                png_uint_32 width, height;
-                int png_depth, color_type, interlace_method,
-                    compression_method, filter_method;
+                if ( png_depth == 16 )
+                {
+                    engineInterface->PushWarning( "lossy 16bit color channel to 8bit color channel conversion" );
 
-                png_uint_32 ihdrResult = png_get_IHDR(
-                    read_info, img_info, &width, &height, &png_depth, &color_type,
-                    &interlace_method, &compression_method, &filter_method
-                );
+                    png_set_scale_16( read_info );
+                }
+            }
+            else
+            {
+                throw RwException( "unknown .png truecolor format" );
+            }
+        }
+        else if ( color_type == 3 )
+        {
+            if ( png_depth == 4 || png_depth == 8 )
+            {
+                // We are a color image with palette.
+                // There can but there does not have to be alpha included.
+                rasterFormat = RASTER_888;
+                depth = 32;
+
+                // We can just take over the row as is.
+                itemDepth = png_depth;
 
-                // We must have image information.
-                if ( ihdrResult == 0 )
+                if ( png_depth == 4 )
                 {
-                    throw RwException( "PNG error: missing image meta information" );
+                    // Make sure we order the 4bit chunks properly.
+                    png_set_packswap( read_info );
+
+                    paletteType = PALETTE_4BIT;
                 }
-                
-                if ( color_type & ~0x07 )
+                else if ( png_depth == 8 )
                 {
-                    throw RwException( "PNG error: unknown color type" );
+                    paletteType = PALETTE_8BIT;
+                }
+                else
+                {
+                    assert( 0 );
                 }
 
-                // Determine how we can map this PNG to RW original types.
-                eRasterFormat rasterFormat;
-                uint32 depth;
-                eColorOrdering colorOrder = COLOR_RGBA;
-
-                ePaletteType paletteType = PALETTE_NONE;
-                uint32 paletteSize = 0;
+                paletteSize = (uint32)std::pow( 2, png_depth );
 
-                uint32 itemDepth;
+                // This format can also be directly acquired.
+                directAcquireByPixelFormat = true;
+            }
+            else
+            {
+                throw RwException( "unknown .png palette depth format" );
+            }
+        }
+        else if ( color_type == 4 )
+        {
+            if ( png_depth == 8 || png_depth == 16 )
+            {
+                // We are luminance with alpha.
+                rasterFormat = RASTER_LUM_ALPHA;
+                depth = 16;
+                itemDepth = 16;
 
-                bool directAcquireByPixelFormat = false;
+                directAcquireByPixelFormat = true;
 
-                if ( color_type == 0 )
+                if ( png_depth == 16 )
                 {
-                    if ( png_depth == 1 || png_depth == 2 || png_depth == 4 || png_depth == 8 || png_depth == 16 )
-                    {
-                        // We are a grayscale image without palette and no alpha.
-                        rasterFormat = RASTER_LUM;  // obviously 8bit LUM.
-                        depth = 8;
-                        itemDepth = 8;
+                    engineInterface->PushWarning( "lossy 16bit luminance alpha to 8bit conversion" );
 
-                        // We always directly acquire this.
-                        directAcquireByPixelFormat = true;
+                    png_set_scale_16( read_info );
+                }
+            }
+            else
+            {
+                throw RwException( "unknown .png luminance alpha format" );
+            }
+        }
+        else if ( color_type == 6 )
+        {
+            if ( png_depth == 8 || png_depth == 16 )
+            {
+                // We are a color image without palette but with alpha channel.
+                rasterFormat = RASTER_8888;
+                depth = 32;
+                itemDepth = 32;
 
-                        if ( png_depth < 8 )
-                        {
-                            // Expand to full depth, please.
-                            png_set_expand_gray_1_2_4_to_8( read_info );
-                        }
-                        else if ( png_depth == 16 )
-                        {
-                            // Warn the user of lossy PNG conversion.
-                            engineInterface->PushWarning( "lossy 16bit grayscale conversion to 8bit LUM8" );
+                // Direct acquisition ftw.
+                directAcquireByPixelFormat = true;
 
-                            png_set_scale_16( read_info );
-                        }
-                    }
-                    else
-                    {
-                        throw RwException( "unknown .png grayscale format" );
-                    }
-                }
-                else if ( color_type == 2 )
+                if ( png_depth == 16 )
                 {
-                    if ( png_depth == 8 || png_depth == 16 )
-                    {
-                        // We are a color image without palette and no alpha.
-                        rasterFormat = RASTER_888;
-                        depth = 24;
-                        itemDepth = 24;
+                    engineInterface->PushWarning( "lossy 16bit truecolor+alpha to 8bit conversion" );
+
+                    png_set_scale_16( read_info );
+                }
+            }
+            else
+            {
+                throw RwException( "unknown .png truecolor+alpha format" );
+            }
+        }
+        else
+        {
+            throw RwException( "PNG error: unknown color type" );
+        }
 
-                        // Always directly acquire.
-                        directAcquireByPixelFormat = true;
+        // TODO: allow conversion to supported format later, when we get better at stuff.
+        if ( directAcquireByPixelFormat == false )
+        {
+            throw RwException( "fatal error: could not apply pixels from .png directly" );
+        }
 
-                        if ( png_depth == 16 )
-                        {
-                            engineInterface->PushWarning( "lossy 16bit color channel to 8bit color channel conversion" );
+        // If we are a format with palette, get the palette chunk.
+        // It must be there.
+        void *paletteData = NULL;
 
-                            png_set_scale_16( read_info );
-                        }
-                    }
-                    else
-                    {
-                        throw RwException( "unknown .png truecolor format" );
-                    }
-                }
-                else if ( color_type == 3 )
-                {
-                    if ( png_depth == 4 || png_depth == 8 )
-                    {
-                        // We are a color image with palette.
-                        // There can but there does not have to be alpha included.
-                        rasterFormat = RASTER_888;
-                        depth = 32;
+        if ( paletteType != PALETTE_NONE )
+        {
+            int pngPalCount = 0;
+            png_colorp pngPaletteColors = NULL;
 
-                        // We can just take over the row as is.
-                        itemDepth = png_depth;
+            // Get the palette chunk and do things with it.
+            png_uint_32 palRes = png_get_PLTE( read_info, img_info, &pngPaletteColors, &pngPalCount );
 
-                        if ( png_depth == 4 )
-                        {
-                            // Make sure we order the 4bit chunks properly.
-                            png_set_packswap( read_info );
+            if ( palRes == 0 )
+            {
+                throw RwException( "could not find PLTE chunk in .png" );
+            }
 
-                            paletteType = PALETTE_4BIT;
-                        }
-                        else if ( png_depth == 8 )
-                        {
-                            paletteType = PALETTE_8BIT;
-                        }
-                        else
-                        {
-                            assert( 0 );
-                        }
+            // Check whether we have an alpha channel.
+            png_bytep alphaValues = NULL;
+            int numAlphaValues = 0;
 
-                        paletteSize = (uint32)std::pow( 2, png_depth );
+            png_uint_32 alphaChunkExists = png_get_tRNS( read_info, img_info, &alphaValues, &numAlphaValues, NULL );
 
-                        // This format can also be directly acquired.
-                        directAcquireByPixelFormat = true;
-                    }
-                    else
-                    {
-                        throw RwException( "unknown .png palette depth format" );
-                    }
-                }
-                else if ( color_type == 4 )
-                {
-                    if ( png_depth == 8 || png_depth == 16 )
-                    {
-                        // We are luminance with alpha.
-                        rasterFormat = RASTER_LUM_ALPHA;
-                        depth = 16;
-                        itemDepth = 16;
+            if ( alphaChunkExists != 0 )
+            {
+                // We want to store things as RASTER_8888 instead.
+                rasterFormat = RASTER_8888;
+                depth = 32;
+            }
 
-                        directAcquireByPixelFormat = true;
+            // Transform the PNG palette spec into a palette we understand.
+            size_t paletteDataSize = getPaletteDataSize( paletteSize, depth );
 
-                        if ( png_depth == 16 )
-                        {
-                            engineInterface->PushWarning( "lossy 16bit luminance alpha to 8bit conversion" );
+            paletteData = engineInterface->PixelAllocate( paletteDataSize );
 
-                            png_set_scale_16( read_info );
-                        }
+            try
+            {
+                colorModelDispatcher putDispatch( rasterFormat, colorOrder, depth, NULL, 0, PALETTE_NONE );
+
+                // Transform!
+                for ( uint32 n = 0; n < paletteSize; n++ )
+                {
+                    uint8 r = 0;
+                    uint8 g = 0;
+                    uint8 b = 0;
+                    uint8 a = 255;
+
+                    // Get the RGB components.
+                    if ( n < (uint32)pngPalCount )
+                    {
+                        png_colorp pngCurColor = pngPaletteColors + n;
+
+                        r = pngCurColor->red;
+                        g = pngCurColor->green;
+                        b = pngCurColor->blue;
                     }
-                    else
+
+                    // Get the alpha component, if present.
+                    if ( alphaChunkExists != 0 && n < (uint32)numAlphaValues )
                     {
-                        throw RwException( "unknown .png luminance alpha format" );
+                        a = alphaValues[ n ];
                     }
+
+                    // Store this color.
+                    putDispatch.setRGBA( paletteData, n, r, g, b, a );
                 }
-                else if ( color_type == 6 )
-                {
-                    if ( png_depth == 8 || png_depth == 16 )
-                    {
-                        // We are a color image without palette but with alpha channel.
-                        rasterFormat = RASTER_8888;
-                        depth = 32;
-                        itemDepth = 32;
+            }
+            catch( ... )
+            {
+                engineInterface->PixelFree( paletteData );
 
-                        // Direct acquisition ftw.
-                        directAcquireByPixelFormat = true;
+                throw;
+            }
+        }
 
-                        if ( png_depth == 16 )
-                        {
-                            engineInterface->PushWarning( "lossy 16bit truecolor+alpha to 8bit conversion" );
+        try
+        {
+            // Update parameters.
+            png_read_update_info( read_info, img_info );
+        }
+        catch( ... )
+        {
+            if ( paletteData != NULL )
+            {
+                engineInterface->PixelFree( paletteData );
+            }
 
-                            png_set_scale_16( read_info );
-                        }
-                    }
-                    else
-                    {
-                        throw RwException( "unknown .png truecolor+alpha format" );
-                    }
+            throw;
+        }
+
+        headerOut.width = width;
+        headerOut.height = height;
+        headerOut.rasterFormat = rasterFormat;
+        headerOut.itemDepth = itemDepth;
+        headerOut.colorOrder = colorOrder;
+        headerOut.paletteType = paletteType;
+        headerOut.paletteData = paletteData;
+        headerOut.paletteSize = paletteSize;
+    }
+
+    // Sets up libpng to read from the stream and calls the reader with the parsed header.
+    // The reader may take the palette by setting it to NULL in the header; otherwise it is freed.
+    template <typename readerType>
+    static void ReadPNGImage( Interface *engineInterface, Stream *inputStream, readerType& reader )
+    {
+        // We use this meta information to interface back with the RW core.
+        png_stream_info meta_info;
+        meta_info.engineInterface = engineInterface;
+        meta_info.usedStream = inputStream;
+
+        // Initialize our read structure.
+        png_structp read_info = png_create_read_struct_2(
+            PNG_LIBPNG_VER_STRING, &meta_info, png_error_routine, png_warning_routine,
+            &meta_info, png_malloc_routine, png_memfree_routine
+        );
+
+        if ( read_info == NULL )
+        {
+            throw RwException( "failed to allocate PNG read struct" );
+        }
+
+        try
+        {
+            // Now initialize our info struct.
+            png_infop img_info = png_create_info_struct( read_info );
+
+            if ( img_info == NULL )
+            {
+                throw RwException( "failed to allocate PNG info struct" );
+            }
+
+            try
+            {
+                // Prepare the PNG environment for reading.
+                png_set_read_fn( read_info, &meta_info, png_read_routine );
+
+                png_image_header header;
+
+                ReadPNGHeader( engineInterface, read_info, img_info, header );
+
+                try
+                {
+                    reader( read_info, img_info, header );
                 }
-                else
+                catch( ... )
                 {
-                    throw RwException( "PNG error: unknown color type" );
+                    // If we have not taken the palette data yet, we free it.
+                    if ( header.paletteData != NULL )
+                    {
+                        engineInterface->PixelFree( header.paletteData );
+                    }
+
+                    throw;
                 }
 
-                // TODO: allow conversion to supported format later, when we get better at stuff.
-                if ( directAcquireByPixelFormat == false )
+                // Clean up palette if we did not end up taking it.
+                if ( header.paletteData != NULL )
                 {
-                    throw RwException( "fatal error: could not apply pixels from .png directly" );
+                    engineInterface->PixelFree( header.paletteData );
                 }
+            }
+            catch( ... )
+            {
+                // An error happened, so destroy ourselves.
+                png_destroy_info_struct( read_info, &img_info );
 
-                // If we are a format with palette, get the palette chunk.
-                // It must be there.
-                void *paletteData = NULL;
+                throw;
+            }
 
-                if ( paletteType != PALETTE_NONE )
-                {
-                    int pngPalCount = 0;
-                    png_colorp pngPaletteColors = NULL;
+            // Free the info struct.
+            png_destroy_info_struct( read_info, &img_info );
+        }
+        catch( ... )
+        {
+            // Basically, we failed, so free resources.
+            png_destroy_read_struct( &read_info, NULL, NULL );
 
-                    // Get the palette chunk and do things with it.
-                    png_uint_32 palRes = png_get_PLTE( read_info, img_info, &pngPaletteColors, &pngPalCount );
+            throw;
+        }
 
-                    if ( palRes == 0 )
-                    {
-                        throw RwException( "could not find PLTE chunk in .png" );
-                    }
+        // Free the main struct.
+        png_destroy_read_struct( &read_info, NULL, NULL );
+    }
 
-                    // Check whether we have an alpha channel.
-                    png_bytep alphaValues = NULL;
-                    int numAlphaValues = 0;
+    void DeserializeImage( Interface *engineInterface, Stream *inputStream, imagingLayerTraversal& outputPixels ) const override
+    {
+        auto imageReader = [&]( png_structp read_info, png_infop img_info, png_image_header& header )
+        {
+            uint32 width = header.width;
+            uint32 height = header.height;
 
-                    png_uint_32 alphaChunkExists = png_get_tRNS( read_info, img_info, &alphaValues, &numAlphaValues, NULL );
+            // After we have set up everything, we can start the reading.
+            // For that we first allocate a big buffer with row pointers.
+            // We do not want to handle interlacing ourselves.
+            png_bytepp row_pointers =
+                (png_bytepp)engineInterface->MemAllocate( sizeof( png_bytep ) * height );
 
-                    if ( alphaChunkExists != 0 )
-                    {
-                        // We want to store things as RASTER_8888 instead.
-                        rasterFormat = RASTER_8888;
-                        depth = 32;
-                    }
+            if ( row_pointers == NULL )
+            {
+                throw RwException( "failed to allocate large enough buffer for PNG row pointers" );
+            }
 
-                    // Transform the PNG palette spec into a palette we understand.
-                    size_t paletteDataSize = getPaletteDataSize( paletteSize, depth );
+            try
+            {
+                // Calculate the size we need for a pixel buffer.
+                size_t rowLength = png_get_rowbytes( read_info, img_info );
 
-                    paletteData = engineInterface->PixelAllocate( paletteDataSize );
+                uint32 dstRowSize = getPNGRasterDataRowSize( width, header.itemDepth );
 
-                    try
-                    {
-                        colorModelDispatcher putDispatch( rasterFormat, colorOrder, depth, NULL, 0, PALETTE_NONE );
+                assert( rowLength == dstRowSize );
 
-                        // Transform!
-                        for ( uint32 n = 0; n < paletteSize; n++ )
-                        {
-                            uint8 r = 0;
-                            uint8 g = 0;
-                            uint8 b = 0;
-                            uint8 a = 255;
+                uint32 texelBufferSize = (uint32)( rowLength * height );
 
-                            // Get the RGB components.
-                            if ( n < (uint32)pngPalCount )
-                            {
-                                png_colorp pngCurColor = pngPaletteColors + n;
+                // Allocate a pixel buffer. We may want to reuse this buffer directly if we can.
+                void *texelBuffer = engineInterface->PixelAllocate( texelBufferSize );
 
-                                r = pngCurColor->red;
-                                g = pngCurColor->green;
-                                b = pngCurColor->blue;
-                            }
+                if ( texelBuffer == NULL )
+                {
+                    throw RwException( "failed to allocate large enough memory buffer for PNG texel data" );
+                }
 
-                            // Get the alpha component, if present.
-                            if ( alphaChunkExists != 0 && n < (uint32)numAlphaValues )
-                            {
-                                a = alphaValues[ n ];
-                            }
+                // Set the row pointers, so that they point into the texel buffer properly.
+                {
+                    size_t texelBufferOffset = 0;
 
-                            // Store this color.
-                            putDispatch.setRGBA( paletteData, n, r, g, b, a );
-                        }
-                    }
-                    catch( ... )
+                    for ( uint32 n = 0; n < height; n++ )
                     {
-                        engineInterface->PixelFree( paletteData );
+                        row_pointers[ n ] = (png_bytep)texelBuffer + texelBufferOffset;
 
-                        throw;
+                        texelBufferOffset += rowLength;
                     }
                 }
 
-                // Update parameters.
-                png_read_update_info( read_info, img_info );
+                // We made sure that the resulting buffer is always a contiguous array of pixels
+                // So there is no problem of directly acquiring it.
 
                 try
                 {
-                    // After we have set up everything, we can start the reading.
-                    // For that we first allocate a big buffer with row pointers.
-                    // We do not want to handle interlacing ourselves.
-                    png_bytepp row_pointers =
-                        (png_bytepp)engineInterface->MemAllocate( sizeof( png_bytep ) * height );
+                    // Alright, we can read the image.
+                    png_read_image( read_info, row_pointers );
 
-                    if ( row_pointers == NULL )
-                    {
-                        throw RwException( "failed to allocate large enough buffer for PNG row pointers" );
-                    }
+                    // Read some shit at the end.
+                    // Example says it is required..?
+                    png_read_end( read_info, img_info );
+                }
+                catch( ... )
+                {
+                    engineInterface->PixelFree( texelBuffer );
 
-                    try
-                    {
-                        // Calculate the size we need for a pixel buffer.
-                        size_t rowLength = png_get_rowbytes( read_info, img_info );
+                    throw;
+                }
 
-                        uint32 dstRowSize = getPNGRasterDataRowSize( width, itemDepth );
+                // Lets handle this thing now!
+                outputPixels.layerWidth = width;
+                outputPixels.layerHeight = height;
+                outputPixels.mipWidth = width;
+                outputPixels.mipHeight = height;
+                outputPixels.texelSource = texelBuffer;
+                outputPixels.dataSize = texelBufferSize;
+                outputPixels.rasterFormat = header.rasterFormat;
+                outputPixels.depth = header.itemDepth;
+                outputPixels.rowAlignment = getPNGTexelDataRowAlignment();
+                outputPixels.colorOrder = header.colorOrder;
+                outputPixels.paletteType = header.paletteType;
+                outputPixels.paletteData = header.paletteData;
+                outputPixels.paletteSize = header.paletteSize;
+                outputPixels.compressionType = RWCOMPRESS_NONE;
+
+                // We took the palette.
+                header.paletteData = NULL;
+            }
+            catch( ... )
+            {
+                engineInterface->MemFree( row_pointers );
 
-                        assert( rowLength == dstRowSize );
+                throw;
+            }
 
-                        uint32 texelBufferSize = (uint32)( rowLength * height );
+            // Free the buffer again.
+            engineInterface->MemFree( row_pointers );
+        };
 
-                        // Allocate a pixel buffer. We may want to reuse this buffer directly if we can.
-                        void *texelBuffer = engineInterface->PixelAllocate( texelBufferSize );
+        ReadPNGImage( engineInterface, inputStream, imageReader );
 
-                        if ( texelBuffer == NULL )
-                        {
-                            throw RwException( "failed to allocate large enough memory buffer for PNG texel data" );
-                        }
+        // Done!
+    }
 
-                        // Set the row pointers, so that they point into the texel buffer properly.
-                        {
-                            size_t texelBufferOffset = 0;
+    bool DeserializeImageRows( Interface *engineInterface, Stream *inputStream, imagingRowSink& rowSink ) const override
+    {
+        auto rowReader = [&]( png_structp read_info, png_infop img_info, png_image_header& header )
+        {
+            uint32 width = header.width;
+            uint32 height = header.height;
 
-                            for ( uint32 n = 0; n < height; n++ )
-                            {
-                                row_pointers[ n ] = (png_bytep)texelBuffer + texelBufferOffset;
+            size_t rowLength = png_get_rowbytes( read_info, img_info );
 
-                                texelBufferOffset += rowLength;
-                            }
-                        }
+            assert( rowLength == getPNGRasterDataRowSize( width, header.itemDepth ) );
 
-                        // We made sure that the resulting buffer is always a contiguous array of pixels
-                        // So there is no problem of directly acquiring it.
+            // The sink owns the palette from here on.
+            void *paletteData = header.paletteData;
 
-                        try
-                        {
-                            // Alright, we can read the image.
-                            png_read_image( read_info, row_pointers );
+            header.paletteData = NULL;
 
-                            // Lets handle this thing now!
-                            {
-                                outputPixels.layerWidth = width;
-                                outputPixels.layerHeight = height;
-                                outputPixels.mipWidth = width;
-                                outputPixels.mipHeight = height;
-                                outputPixels.texelSource = texelBuffer;
-                                outputPixels.dataSize = texelBufferSize;
-                                outputPixels.rasterFormat = rasterFormat;
-                                outputPixels.depth = itemDepth;
-                                outputPixels.rowAlignment = getPNGTexelDataRowAlignment();
-                                outputPixels.colorOrder = colorOrder;
-                                outputPixels.paletteType = paletteType;
-                                outputPixels.paletteData = paletteData;
-                                outputPixels.paletteSize = paletteSize;
-                                outputPixels.compressionType = RWCOMPRESS_NONE;
-
-                                // We took the palette.
-                                paletteData = NULL;
-
-                                // We took the texel buffer.
-                                texelBuffer = NULL;
-                            }
+            rowSink.BeginImage(
+                width, height,
+                header.rasterFormat, header.itemDepth, header.colorOrder,
+                header.paletteType, paletteData, header.paletteSize
+            );
 
-                            // Read some shit at the end.
-                            // Example says it is required..?
-                            png_read_end( read_info, img_info );
-                        }
-                        catch( ... )
-                        {
-                            if ( texelBuffer != NULL )
-                            {
-                                engineInterface->PixelFree( texelBuffer );
+            // Interlaced images only have complete rows after the last pass.
+            // We decode those as a whole and hand out the finished rows.
+            bool isInterlaced = ( png_get_interlace_type( read_info, img_info ) != PNG_INTERLACE_NONE );
 
-                                texelBuffer = NULL;
-                            }
+            uint32 bufferRowCount = ( isInterlaced ? height : 1 );
 
-                            throw;
-                        }
+            void *rowBuffer = engineInterface->PixelAllocate( rowLength * bufferRowCount );
 
-                        // If we do not directly acquire, we do not need the texel buffer anymore.
-                        if ( texelBuffer != NULL )
-                        {
-                            engineInterface->PixelFree( texelBuffer );
+            if ( rowBuffer == NULL )
+            {
+                throw RwException( "failed to allocate PNG row buffer" );
+            }
 
-                            texelBuffer = NULL;
-                        }
+            try
+            {
+                if ( isInterlaced )
+                {
+                    png_bytepp row_pointers =
+                        (png_bytepp)engineInterface->MemAllocate( sizeof( png_bytep ) * height );
+
+                    if ( row_pointers == NULL )
+                    {
+                        throw RwException( "failed to allocate large enough buffer for PNG row pointers" );
+                    }
+
+                    for ( uint32 n = 0; n < height; n++ )
+                    {
+                        row_pointers[ n ] = (png_bytep)rowBuffer + rowLength * n;
+                    }
+
+                    try
+                    {
+                        png_read_image( read_info, row_pointers );
                     }
                     catch( ... )
                     {
@@ -579,53 +732,38 @@ struct pngImagingExtension : public imagingFormatExtension
                         throw;
                     }
 
-                    // Free the buffer again.
                     engineInterface->MemFree( row_pointers );
+
+                    for ( uint32 row = 0; row < height; row++ )
+                    {
+                        rowSink.PutRow( row, (const char*)rowBuffer + rowLength * row );
+                    }
                 }
-                catch( ... )
+                else
                 {
-                    // If we have not taken the palette data yet, we free it.
-                    if ( paletteData != NULL )
+                    for ( uint32 row = 0; row < height; row++ )
                     {
-                        engineInterface->PixelFree( paletteData );
+                        png_read_row( read_info, (png_bytep)rowBuffer, NULL );
 
-                        paletteData = NULL;
+                        rowSink.PutRow( row, rowBuffer );
                     }
-
-                    throw;
                 }
 
-                // Clean up palette if we did not end up taking it.
-                if ( paletteData != NULL )
-                {
-                    engineInterface->PixelFree( paletteData );
-
-                    paletteData = NULL;
-                }
+                png_read_end( read_info, img_info );
             }
             catch( ... )
             {
-                // An error happened, so destroy ourselves.
-                png_destroy_info_struct( read_info, &img_info );
+                engineInterface->PixelFree( rowBuffer );
 
                 throw;
             }
 
-            // Free the info struct.
-            png_destroy_info_struct( read_info, &img_info );
-        }
-        catch( ... )
-        {
-            // Basically, we failed, so free resources.
-            png_destroy_read_struct( &read_info, NULL, NULL );
-
-            throw;
-        }
+            engineInterface->PixelFree( rowBuffer );
+        };
 
-        // Free the main struct.
-        png_destroy_read_struct( &read_info, NULL, NULL );
+        ReadPNGImage( engineInterface, inputStream, rowReader );
 
-        // Done!
+        return true;
     }
 
     static void png_write_routine( png_structp write_info, png_bytep buffer, png_size_t count )
@@ -1048,7 +1186,7 @@ struct pngImagingExtension : public imagingFormatExtension
 
     inline void Initialize( Interface *engineInterface )
     {
-        RegisterImagingFormat( engineInterface, "Portable Network Graphics", IMAGING_COUNT_EXT(png_ext), png_ext, this );
+        RegisterImagingFormat( engineInterface, "Portable Network Graphics", IMAGING_COUNT_EXT(png_ext), png_ext, IMAGING_COUNT_SIG(png_sig), png_sig, this );
     }
 
     inline void Shutdown( Interface *engineInterface )
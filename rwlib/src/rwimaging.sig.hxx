@@ -0,0 +1,154 @@
+// Magic number tables for stream format detection.
+// Imaging formats and native image formats declare the bytes that their streams carry at fixed offsets,
+// so that a stream can be identified by one bounded header read instead of probing every format.
+#ifndef _RENDERWARE_IMAGING_SIGNATURES_
+#define _RENDERWARE_IMAGING_SIGNATURES_
+
+#include <vector>
+#include <algorithm>
+
+namespace rw
+{
+
+// A sequence of bytes at a fixed offset from the start of a stream.
+struct imaging_stream_signature
+{
+    uint32 offset;
+    uint32 length;
+    const char *bytes;
+};
+
+#define IMAGING_COUNT_SIG(x)    ( sizeof(x) / sizeof(*x) )
+
+// Every signature has to fit into the header that is read for detection.
+#define IMAGING_MAX_SIGNATURE_EXTENT    32
+
+template <typename formatType>
+struct imagingSignatureTable
+{
+    inline imagingSignatureTable( void )
+    {
+        this->headerSize = 0;
+    }
+
+    inline void AddFormat( formatType *format, size_t sigCount, const imaging_stream_signature *sigs )
+    {
+        for ( size_t n = 0; n < sigCount; n++ )
+        {
+            const imaging_stream_signature& sig = sigs[ n ];
+
+            uint32 sigExtent = ( sig.offset + sig.length );
+
+            assert( sig.length != 0 && sigExtent <= IMAGING_MAX_SIGNATURE_EXTENT );
+
+            signatureEntry newEntry;
+            newEntry.sig = sig;
+            newEntry.format = format;
+
+            // Longer signatures are more specific, so they are matched first.
+            typename signatureList_t::iterator insertIter =
+                std::upper_bound( this->entries.begin(), this->entries.end(), newEntry,
+                    []( const signatureEntry& left, const signatureEntry& right )
+                    {
+                        return ( left.sig.length > right.sig.length );
+                    }
+                );
+
+            this->entries.insert( insertIter, newEntry );
+
+            if ( sigExtent > this->headerSize )
+            {
+                this->headerSize = sigExtent;
+            }
+        }
+    }
+
+    inline void RemoveFormat( formatType *format )
+    {
+        this->entries.erase(
+            std::remove_if( this->entries.begin(), this->entries.end(),
+                [&]( const signatureEntry& entry )
+                {
+                    return ( entry.format == format );
+                }
+            ),
+            this->entries.end()
+        );
+
+        uint32 newHeaderSize = 0;
+
+        for ( const signatureEntry& entry : this->entries )
+        {
+            uint32 sigExtent = ( entry.sig.offset + entry.sig.length );
+
+            if ( sigExtent > newHeaderSize )
+            {
+                newHeaderSize = sigExtent;
+            }
+        }
+
+        this->headerSize = newHeaderSize;
+    }
+
+    inline void Clear( void )
+    {
+        this->entries.clear();
+
+        this->headerSize = 0;
+    }
+
+    // Returns the format that owns a signature inside of the given header bytes, or NULL.
+    inline formatType* Match( const char *header, uint32 headerReadCount ) const
+    {
+        for ( const signatureEntry& entry : this->entries )
+        {
+            const imaging_stream_signature& sig = entry.sig;
+
+            if ( sig.offset + sig.length <= headerReadCount &&
+                 memcmp( header + sig.offset, sig.bytes, sig.length ) == 0 )
+            {
+                return entry.format;
+            }
+        }
+
+        return NULL;
+    }
+
+    // Reads the detection header at the current stream position.
+    // The stream is seeked back to where it was, no matter the result.
+    inline formatType* MatchStream( Stream *stream ) const
+    {
+        uint32 readSize = this->headerSize;
+
+        if ( readSize == 0 )
+        {
+            return NULL;
+        }
+
+        char header[ IMAGING_MAX_SIGNATURE_EXTENT ];
+
+        int64 streamStartPos = stream->tell();
+
+        size_t headerReadCount = stream->read( header, readSize );
+
+        stream->seek( streamStartPos, RWSEEK_BEG );
+
+        return Match( header, (uint32)headerReadCount );
+    }
+
+private:
+    struct signatureEntry
+    {
+        imaging_stream_signature sig;
+        formatType *format;
+    };
+
+    typedef std::vector <signatureEntry> signatureList_t;
+
+    signatureList_t entries;
+    uint32 headerSize;
+};
+
+};
+
+#endif //_RENDERWARE_IMAGING_SIGNATURES_
@@ -188,7 +188,8 @@ struct tgaImagingExtension : public imagingFormatExtension
     inline void Initialize( Interface *engineInterface )
     {
         // We can now address the imaging environment and register ourselves, quite exciting.
-        RegisterImagingFormat( engineInterface, "Truevision Raster Graphics", IMAGING_COUNT_EXT(tga_ext), tga_ext, this );
+        // TGA has no magic number, so it is probed after all signatures failed.
+        RegisterImagingFormat( engineInterface, "Truevision Raster Graphics", IMAGING_COUNT_EXT(tga_ext), tga_ext, 0, NULL, this );
     }
 
     inline void Shutdown( Interface *engineInterface )
@@ -278,7 +279,23 @@ struct tgaImagingExtension : public imagingFormatExtension
         TGAORIENT_TOPRIGHT
     };
 
-    void DeserializeImage( Interface *engineInterface, Stream *inputStream, imagingLayerTraversal& outputTexels ) const override
+    // Layout of the texel rows in a .tga stream, as mapped to RenderWare.
+    struct tga_image_header
+    {
+        uint32 width, height;
+        eRasterFormat rasterFormat;
+        uint32 itemDepth;
+        eColorOrdering colorOrder;
+        ePaletteType paletteType;
+        void *paletteData;
+        uint32 paletteSize;
+        bool flip_horizontal;
+        bool flip_vertical;
+    };
+
+    // Reads everything in front of the color/index data.
+    // The palette is allocated using PixelAllocate and belongs to the caller.
+    static void ReadTGAHeader( Interface *engineInterface, Stream *inputStream, tga_image_header& headerOut )
     {
         // Read the header and decide about color format stuff.
         TgaHeader headerData;
@@ -452,43 +469,68 @@ struct tgaImagingExtension : public imagingFormatExtension
             }
         }
 
+        // The data can be oriented in four different ways, to the liking of the serializer.
+        // We should allow any orientation, but we only store in TOPLEFT.
+        bool flip_horizontal = false;
+        bool flip_vertical = false;
+
+        if ( tgaOrient == TGAORIENT_TOPLEFT )
+        {
+            flip_horizontal = false;
+            flip_vertical = false;
+        }
+        else if ( tgaOrient == TGAORIENT_TOPRIGHT )
+        {
+            flip_horizontal = true;
+            flip_vertical = false;
+        }
+        else if ( tgaOrient == TGAORIENT_BOTTOMLEFT )
+        {
+            flip_horizontal = false;
+            flip_vertical = true;
+        }
+        else if ( tgaOrient == TGAORIENT_BOTTOMRIGHT )
+        {
+            flip_horizontal = true;
+            flip_vertical = true;
+        }
+        else
+        {
+            assert( 0 );
+        }
+
+        headerOut.width = headerData.Width;
+        headerOut.height = headerData.Height;
+        headerOut.rasterFormat = dstRasterFormat;
+        headerOut.itemDepth = dstItemDepth;
+        headerOut.colorOrder = dstColorOrder;
+        headerOut.paletteType = dstPaletteType;
+        headerOut.paletteData = paletteData;
+        headerOut.paletteSize = paletteSize;
+        headerOut.flip_horizontal = flip_horizontal;
+        headerOut.flip_vertical = flip_vertical;
+    }
+
+    void DeserializeImage( Interface *engineInterface, Stream *inputStream, imagingLayerTraversal& outputTexels ) const override
+    {
+        tga_image_header header;
+
+        ReadTGAHeader( engineInterface, inputStream, header );
+
+        void *paletteData = header.paletteData;
+
         try
         {
-            // The data can be oriented in four different ways, to the liking of the serializer.
-            // We should allow any orientation, but we only store in TOPLEFT.
-            bool flip_horizontal = false;
-            bool flip_vertical = false;
+            bool flip_horizontal = header.flip_horizontal;
+            bool flip_vertical = header.flip_vertical;
 
-            if ( tgaOrient == TGAORIENT_TOPLEFT )
-            {
-                flip_horizontal = false;
-                flip_vertical = false;
-            }
-            else if ( tgaOrient == TGAORIENT_TOPRIGHT )
-            {
-                flip_horizontal = true;
-                flip_vertical = false;
-            }
-            else if ( tgaOrient == TGAORIENT_BOTTOMLEFT )
-            {
-                flip_horizontal = false;
-                flip_vertical = true;
-            }
-            else if ( tgaOrient == TGAORIENT_BOTTOMRIGHT )
-            {
-                flip_horizontal = true;
-                flip_vertical = true;
-            }
-            else
-            {
-                assert( 0 );
-            }
+            uint32 dstItemDepth = header.itemDepth;
 
-            bool canDirectlyAcquire = ( tgaOrient == TGAORIENT_TOPLEFT );
+            bool canDirectlyAcquire = ( !flip_horizontal && !flip_vertical );
 
             // Now read the color/index data.
-            uint32 width = headerData.Width;
-            uint32 height = headerData.Height;
+            uint32 width = header.width;
+            uint32 height = header.height;
 
             uint32 tgaRowSize = getTGARasterDataRowSize( width, dstItemDepth );
 
@@ -601,13 +643,13 @@ struct tgaImagingExtension : public imagingFormatExtension
             outputTexels.texelSource = texelData;
             outputTexels.dataSize = rasterDataSize;
             
-            outputTexels.rasterFormat = dstRasterFormat;
+            outputTexels.rasterFormat = header.rasterFormat;
             outputTexels.depth = dstItemDepth;
             outputTexels.rowAlignment = getTGATexelDataRowAlignment();
-            outputTexels.colorOrder = dstColorOrder;
-            outputTexels.paletteType = dstPaletteType;
+            outputTexels.colorOrder = header.colorOrder;
+            outputTexels.paletteType = header.paletteType;
             outputTexels.paletteData = paletteData;
-            outputTexels.paletteSize = paletteSize;
+            outputTexels.paletteSize = header.paletteSize;
             outputTexels.compressionType = RWCOMPRESS_NONE;
         }
         catch( ... )
@@ -625,6 +667,88 @@ struct tgaImagingExtension : public imagingFormatExtension
         // We are done!
     }
 
+    bool DeserializeImageRows( Interface *engineInterface, Stream *inputStream, imagingRowSink& rowSink ) const override
+    {
+        tga_image_header header;
+
+        ReadTGAHeader( engineInterface, inputStream, header );
+
+        uint32 width = header.width;
+        uint32 height = header.height;
+
+        uint32 dstItemDepth = header.itemDepth;
+
+        bool flip_horizontal = header.flip_horizontal;
+        bool flip_vertical = header.flip_vertical;
+
+        // The sink owns the palette from here on.
+        rowSink.BeginImage(
+            width, height,
+            header.rasterFormat, dstItemDepth, header.colorOrder,
+            header.paletteType, header.paletteData, header.paletteSize
+        );
+
+        uint32 tgaRowSize = getTGARasterDataRowSize( width, dstItemDepth );
+
+        checkAhead( inputStream, getRasterDataSizeByRowSize( tgaRowSize, height ) );
+
+        // Mirrored rows need a second buffer to be transformed into.
+        uint32 rowBufCount = ( flip_horizontal ? 2 : 1 );
+
+        void *rowbuf = engineInterface->PixelAllocate( tgaRowSize * rowBufCount );
+
+        if ( rowbuf == NULL )
+        {
+            throw RwException( "failed to allocate .tga row buffer" );
+        }
+
+        try
+        {
+            void *flipbuf = ( (char*)rowbuf + tgaRowSize );
+
+            for ( uint32 srcRow = 0; srcRow < height; srcRow++ )
+            {
+                size_t rowReadCount = inputStream->read( rowbuf, tgaRowSize );
+
+                if ( rowReadCount != tgaRowSize )
+                {
+                    throw RwException( "incomplete TGA row read exception" );
+                }
+
+                uint32 dstRow = ( flip_vertical ? ( height - srcRow - 1 ) : srcRow );
+
+                if ( flip_horizontal )
+                {
+                    for ( uint32 srcCol = 0; srcCol < width; srcCol++ )
+                    {
+                        moveDataByDepth(
+                            flipbuf, rowbuf,
+                            dstItemDepth,
+                            eByteAddressingMode::MOST_SIGNIFICANT,
+                            ( width - srcCol - 1 ), srcCol
+                        );
+                    }
+
+                    rowSink.PutRow( dstRow, flipbuf );
+                }
+                else
+                {
+                    rowSink.PutRow( dstRow, rowbuf );
+                }
+            }
+        }
+        catch( ... )
+        {
+            engineInterface->PixelFree( rowbuf );
+
+            throw;
+        }
+
+        engineInterface->PixelFree( rowbuf );
+
+        return true;
+    }
+
     static inline bool getTGAFullColorConfiguration(
         eRasterFormat srcRasterFormat,
         eRasterFormat& dstRasterFormatOut, uint32& dstColorDepthOut, uint32& dstAlphaBitsOut
@@ -29,6 +29,13 @@ static const imaging_filename_ext tiff_ext[] =
     { "TIF", true }
 };
 
+// Byte order mark followed by the TIFF version 42.
+static const imaging_stream_signature tiff_sig[] =
+{
+    { 0, 4, "II\x2A\x00" },
+    { 0, 4, "MM\x00\x2A" }
+};
+
 // RenderWare TIFF imaging extension, because it is a great format!
 // Criterion's toolchain had TIFF support, too.
 struct tiffImagingExtension : public imagingFormatExtension
@@ -1439,7 +1446,7 @@ struct tiffImagingExtension : public imagingFormatExtension
 
     inline void Initialize( Interface *engineInterface )
     {
-        RegisterImagingFormat( engineInterface, "Tag Image File Format", IMAGING_COUNT_EXT(tiff_ext), tiff_ext, this );
+        RegisterImagingFormat( engineInterface, "Tag Image File Format", IMAGING_COUNT_EXT(tiff_ext), tiff_ext, IMAGING_COUNT_SIG(tiff_sig), tiff_sig, this );
     }
 
     inline void Shutdown( Interface *engineInterface )
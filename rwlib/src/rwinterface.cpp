@@ -8,6 +8,8 @@
 
 #include "rwthreading.hxx"
 
+#include "rwthreading.pool.hxx"
+
 namespace rw
 {
 
@@ -491,6 +493,20 @@ eDXTCompressionMethod Interface::GetDXTRuntime( void ) const
     return GetConstEnvironmentConfigBlock( engineInterface ).GetDXTRuntime();
 }
 
+bool Interface::SetPVRRuntime( ePVRCompressionMethod pvrRunType )
+{
+    EngineInterface *engineInterface = (EngineInterface*)this;
+
+    return GetEnvironmentConfigBlock( engineInterface ).SetPVRRuntime( pvrRunType );
+}
+
+ePVRCompressionMethod Interface::GetPVRRuntime( void ) const
+{
+    const EngineInterface *engineInterface = (const EngineInterface*)this;
+
+    return GetConstEnvironmentConfigBlock( engineInterface ).GetPVRRuntime();
+}
+
 void Interface::SetFixIncompatibleRasters( bool doFix )
 {
     EngineInterface *engineInterface = (EngineInterface*)this;
@@ -561,9 +577,81 @@ bool Interface::GetIgnoreSerializationBlockRegions( void ) const
     return GetConstEnvironmentConfigBlock( engineInterface ).GetIgnoreSerializationBlockRegions();
 }
 
+void Interface::SetSequentialSerialization( bool sequential )
+{
+    EngineInterface *engineInterface = (EngineInterface*)this;
+
+    GetEnvironmentConfigBlock( engineInterface ).SetSequentialSerialization( sequential );
+}
+
+bool Interface::GetSequentialSerialization( void ) const
+{
+    const EngineInterface *engineInterface = (const EngineInterface*)this;
+
+    return GetConstEnvironmentConfigBlock( engineInterface ).GetSequentialSerialization();
+}
+
+void Interface::SetLazyTexDictionaryLoading( bool lazyLoad )
+{
+    EngineInterface *engineInterface = (EngineInterface*)this;
+
+    GetEnvironmentConfigBlock( engineInterface ).SetLazyTexDictionaryLoading( lazyLoad );
+}
+
+bool Interface::GetLazyTexDictionaryLoading( void ) const
+{
+    const EngineInterface *engineInterface = (const EngineInterface*)this;
+
+    return GetConstEnvironmentConfigBlock( engineInterface ).GetLazyTexDictionaryLoading();
+}
+
+void Interface::SetParallelTexDictionaryLoading( bool parallelLoad )
+{
+    EngineInterface *engineInterface = (EngineInterface*)this;
+
+    GetEnvironmentConfigBlock( engineInterface ).SetParallelTexDictionaryLoading( parallelLoad );
+}
+
+bool Interface::GetParallelTexDictionaryLoading( void ) const
+{
+    const EngineInterface *engineInterface = (const EngineInterface*)this;
+
+    return GetConstEnvironmentConfigBlock( engineInterface ).GetParallelTexDictionaryLoading();
+}
+
+void Interface::SetStreamedImageDecoding( bool streamed )
+{
+    EngineInterface *engineInterface = (EngineInterface*)this;
+
+    GetEnvironmentConfigBlock( engineInterface ).SetStreamedImageDecoding( streamed );
+}
+
+bool Interface::GetStreamedImageDecoding( void ) const
+{
+    const EngineInterface *engineInterface = (const EngineInterface*)this;
+
+    return GetConstEnvironmentConfigBlock( engineInterface ).GetStreamedImageDecoding();
+}
+
+void Interface::SetWorkerThreadCount( uint32 threadCount )
+{
+    EngineInterface *engineInterface = (EngineInterface*)this;
+
+    GetEnvironmentConfigBlock( engineInterface ).SetWorkerThreadCount( threadCount );
+}
+
+uint32 Interface::GetWorkerThreadCount( void ) const
+{
+    const EngineInterface *engineInterface = (const EngineInterface*)this;
+
+    return GetConstEnvironmentConfigBlock( engineInterface ).GetWorkerThreadCount();
+}
+
 // Static library object that takes care of initializing the module dependencies properly.
 extern void registerConfigurationEnvironment( void );
 extern void registerThreadingEnvironment( void );
+extern void registerThreadPoolEnvironment( void );
+extern void registerPixelAllocatorEnvironment( void );
 extern void registerWarningHandlerEnvironment( void );
 extern void registerEventSystem( void );
 extern void registerTXDPlugins( void );
@@ -579,6 +667,8 @@ extern void registerDrawingLayerEnvironment( void );
 
 extern void registerConfigurationBlockDispatching( void );
 
+extern void SetupPixelAllocator( EngineInterface *engineInterface, const engineCreationParams& params );
+
 static bool hasInitialized = false;
 
 static bool VerifyLibraryIntegrity( void )
@@ -600,7 +690,7 @@ static bool VerifyLibraryIntegrity( void )
 }
 
 // Interface creation for the RenderWare engine.
-Interface* CreateEngine( LibraryVersion theVersion )
+Interface* CreateEngine( LibraryVersion theVersion, const engineCreationParams& params )
 {
     if ( hasInitialized == false )
     {
@@ -616,6 +706,12 @@ Interface* CreateEngine( LibraryVersion theVersion )
 
             // Now do the main modules.
             registerThreadingEnvironment();
+
+            // Pixel memory has to outlive every module that uses it.
+            // Its cache locks come from the threading environment, which does not use pixel memory itself.
+            registerPixelAllocatorEnvironment();
+
+            registerThreadPoolEnvironment();
             registerWarningHandlerEnvironment();
             registerEventSystem();
             registerStreamGlobalPlugins();
@@ -647,6 +743,8 @@ Interface* CreateEngine( LibraryVersion theVersion )
 
         if ( engineOut )
         {
+            SetupPixelAllocator( (EngineInterface*)engineOut, params );
+
             engineOut->SetVersion( theVersion );
         }
     }
@@ -654,12 +752,20 @@ Interface* CreateEngine( LibraryVersion theVersion )
     return engineOut;
 }
 
+Interface* CreateEngine( LibraryVersion theVersion )
+{
+    return CreateEngine( theVersion, engineCreationParams() );
+}
+
 void DeleteEngine( Interface *theEngine )
 {
     assert( hasInitialized == true );
 
     EngineInterface *engineInterface = (EngineInterface*)theEngine;
 
+    // Let the worker threads finish cleanly.
+    ShutdownThreadPool( engineInterface );
+
     // Kill everything threading related, so we can terminate (WARNING: HACK)
     PurgeActiveThreadingObjects( engineInterface );
 
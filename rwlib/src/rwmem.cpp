@@ -1,5 +1,15 @@
 #include "StdInc.h"
 
+#include "pluginutil.hxx"
+
+#include <atomic>
+#include <new>
+#include <limits>
+
+#ifndef _MSC_VER
+#include <stdlib.h>
+#endif //_MSC_VER
+
 namespace rw
 {
 
@@ -15,14 +25,449 @@ void Interface::MemFree( void *ptr )
     delete [] ptr;
 }
 
+// Pixel memory.
+// Pixel buffers are big and are allocated and freed all the time during conversion, so the engine
+// can keep freed buffers around in size classes and hand them out again. Every buffer is aligned
+// to a cache line so that SIMD code can work on it.
+#define PIXEL_ALIGNMENT             64
+
+// Size classes go from 64 bytes to 64 megabytes, with four classes per power of two.
+// Power-of-two mipmap layers exactly hit a class this way.
+#define PIXEL_MIN_CLASS_EXP         6
+#define PIXEL_MAX_CLASS_EXP         26
+#define PIXEL_CLASSES_PER_EXP       4
+#define PIXEL_NUM_SIZE_CLASSES      ( ( PIXEL_MAX_CLASS_EXP - PIXEL_MIN_CLASS_EXP ) * PIXEL_CLASSES_PER_EXP + 1 )
+#define PIXEL_NO_SIZE_CLASS         0xFFFFFFFF
+
+// Freed buffers are cached in shards, each with their own lock.
+// Every thread sticks to one shard, so threads rarely wait on each other.
+#define PIXEL_NUM_CACHE_SHARDS      8
+
+#define PIXEL_DEFAULT_CACHE_SIZE    ( 256 * 1024 * 1024 )
+
+#define PIXEL_BLOCK_MAGIC           0x50584C42
+
+struct pixelBlockHeader
+{
+    uint32 magic;
+    uint32 sizeClass;
+    size_t blockSize;               // usable bytes after the header
+
+    pixelBlockHeader *nextFree;     // only valid while cached
+};
+
+static_assert( sizeof( pixelBlockHeader ) <= PIXEL_ALIGNMENT, "pixel block header does not fit into the alignment" );
+
+AINLINE uint32 getHighestBitIndex( size_t value )
+{
+    uint32 index = 0;
+
+    while ( value >>= 1 )
+    {
+        index++;
+    }
+
+    return index;
+}
+
+AINLINE size_t getPixelSizeClassSize( uint32 sizeClass )
+{
+    size_t classBase = ( (size_t)1 << ( PIXEL_MIN_CLASS_EXP + sizeClass / PIXEL_CLASSES_PER_EXP ) );
+
+    return ( classBase + ( classBase / PIXEL_CLASSES_PER_EXP ) * ( sizeClass % PIXEL_CLASSES_PER_EXP ) );
+}
+
+AINLINE uint32 getPixelSizeClass( size_t memSize )
+{
+    if ( memSize <= ( (size_t)1 << PIXEL_MIN_CLASS_EXP ) )
+        return 0;
+
+    // Find the power of two below the size and the sub-class that covers it.
+    uint32 sizeExp = getHighestBitIndex( memSize - 1 );
+
+    if ( sizeExp >= PIXEL_MAX_CLASS_EXP )
+        return PIXEL_NO_SIZE_CLASS;
+
+    size_t classBase = ( (size_t)1 << sizeExp );
+    size_t classStep = ( classBase / PIXEL_CLASSES_PER_EXP );
+
+    uint32 subClass = (uint32)( ( memSize - classBase + classStep - 1 ) / classStep );
+
+    return ( ( sizeExp - PIXEL_MIN_CLASS_EXP ) * PIXEL_CLASSES_PER_EXP + subClass );
+}
+
+static pixelBlockHeader* AllocateSystemPixelBlock( size_t blockSize, uint32 sizeClass )
+{
+    if ( blockSize > std::numeric_limits <size_t>::max() - PIXEL_ALIGNMENT )
+    {
+        throw std::bad_alloc();
+    }
+
+    void *mem = NULL;
+
+#ifdef _MSC_VER
+    mem = _aligned_malloc( PIXEL_ALIGNMENT + blockSize, PIXEL_ALIGNMENT );
+#else
+    if ( posix_memalign( &mem, PIXEL_ALIGNMENT, PIXEL_ALIGNMENT + blockSize ) != 0 )
+    {
+        mem = NULL;
+    }
+#endif //_MSC_VER
+
+    if ( mem == NULL )
+    {
+        throw std::bad_alloc();
+    }
+
+    pixelBlockHeader *header = (pixelBlockHeader*)mem;
+    header->magic = PIXEL_BLOCK_MAGIC;
+    header->sizeClass = sizeClass;
+    header->blockSize = blockSize;
+    header->nextFree = NULL;
+
+    return header;
+}
+
+static void FreeSystemPixelBlock( pixelBlockHeader *header )
+{
+#ifdef _MSC_VER
+    _aligned_free( header );
+#else
+    free( header );
+#endif //_MSC_VER
+}
+
+AINLINE void* GetPixelBlockData( pixelBlockHeader *header )
+{
+    return ( (char*)header + PIXEL_ALIGNMENT );
+}
+
+AINLINE pixelBlockHeader* GetPixelBlockHeader( void *pixels )
+{
+    pixelBlockHeader *header = (pixelBlockHeader*)( (char*)pixels - PIXEL_ALIGNMENT );
+
+    assert( header->magic == PIXEL_BLOCK_MAGIC );
+
+    return header;
+}
+
+static std::atomic <uint32> _nextPixelCacheShard( 0 );
+
+static thread_local uint32 _threadPixelCacheShard = PIXEL_NUM_CACHE_SHARDS;
+
+AINLINE uint32 GetThreadPixelCacheShard( void )
+{
+    uint32 shardIndex = _threadPixelCacheShard;
+
+    if ( shardIndex == PIXEL_NUM_CACHE_SHARDS )
+    {
+        shardIndex = ( _nextPixelCacheShard++ % PIXEL_NUM_CACHE_SHARDS );
+
+        _threadPixelCacheShard = shardIndex;
+    }
+
+    return shardIndex;
+}
+
+struct pixelAllocatorEnv
+{
+    struct cacheShard
+    {
+        rwlock *lock;
+
+        pixelBlockHeader *freeLists[ PIXEL_NUM_SIZE_CLASSES ];
+        size_t cachedBytes;
+    };
+
+    inline void Initialize( EngineInterface *engineInterface )
+    {
+        this->allocatorType = PIXELALLOC_SYSTEM;
+        this->shardCacheLimit = ( PIXEL_DEFAULT_CACHE_SIZE / PIXEL_NUM_CACHE_SHARDS );
+        this->isActive = true;
+
+        for ( cacheShard& shard : this->shards )
+        {
+            shard.lock = CreateReadWriteLock( engineInterface );
+
+            for ( pixelBlockHeader*& freeList : shard.freeLists )
+            {
+                freeList = NULL;
+            }
+
+            shard.cachedBytes = 0;
+        }
+
+        this->bytesLive = 0;
+        this->bytesPeak = 0;
+        this->bytesCached = 0;
+        this->cacheHits = 0;
+        this->cacheMisses = 0;
+    }
+
+    inline void Shutdown( EngineInterface *engineInterface )
+    {
+        // Pixels that are freed after this point go straight back to the system.
+        this->isActive = false;
+
+        this->ReleaseCache();
+
+        for ( cacheShard& shard : this->shards )
+        {
+            if ( rwlock *lock = shard.lock )
+            {
+                CloseReadWriteLock( engineInterface, lock );
+
+                shard.lock = NULL;
+            }
+        }
+    }
+
+    inline void operator = ( const pixelAllocatorEnv& right )
+    {
+        throw RwException( "cannot copy pixel allocator environment" );
+    }
+
+    void ReleaseCache( void )
+    {
+        for ( cacheShard& shard : this->shards )
+        {
+            scoped_rwlock_writer <rwlock> lock( shard.lock );
+
+            for ( pixelBlockHeader*& freeList : shard.freeLists )
+            {
+                pixelBlockHeader *header = freeList;
+
+                while ( header )
+                {
+                    pixelBlockHeader *nextFree = header->nextFree;
+
+                    FreeSystemPixelBlock( header );
+
+                    header = nextFree;
+                }
+
+                freeList = NULL;
+            }
+
+            this->bytesCached -= shard.cachedBytes;
+
+            shard.cachedBytes = 0;
+        }
+    }
+
+    AINLINE pixelBlockHeader* TakeCachedBlock( cacheShard& shard, uint32 sizeClass )
+    {
+        pixelBlockHeader *header = shard.freeLists[ sizeClass ];
+
+        if ( header )
+        {
+            shard.freeLists[ sizeClass ] = header->nextFree;
+            shard.cachedBytes -= header->blockSize;
+
+            this->bytesCached -= header->blockSize;
+        }
+
+        return header;
+    }
+
+    pixelBlockHeader* Allocate( size_t memSize )
+    {
+        bool usePool = ( this->allocatorType == PIXELALLOC_POOLED && this->isActive );
+
+        // Only round up to the size class if the block can be recycled.
+        // The system allocator should not waste memory on padding.
+        uint32 sizeClass = ( usePool ? getPixelSizeClass( memSize ) : PIXEL_NO_SIZE_CLASS );
+
+        pixelBlockHeader *header = NULL;
+
+        if ( sizeClass != PIXEL_NO_SIZE_CLASS )
+        {
+            uint32 ownShard = GetThreadPixelCacheShard();
+
+            {
+                cacheShard& shard = this->shards[ ownShard ];
+
+                scoped_rwlock_writer <rwlock> lock( shard.lock );
+
+                header = TakeCachedBlock( shard, sizeClass );
+            }
+
+            // Buffers are often freed by another thread than the one that allocated them.
+            // So look into the other shards too, but do not wait for them.
+            for ( uint32 n = 1; header == NULL && n < PIXEL_NUM_CACHE_SHARDS; n++ )
+            {
+                cacheShard& shard = this->shards[ ( ownShard + n ) % PIXEL_NUM_CACHE_SHARDS ];
+
+                rwlock *lock = shard.lock;
+
+                if ( lock && lock->try_enter_write() )
+                {
+                    header = TakeCachedBlock( shard, sizeClass );
+
+                    lock->leave_write();
+                }
+            }
+
+            if ( header )
+            {
+                this->cacheHits++;
+            }
+            else
+            {
+                this->cacheMisses++;
+
+                header = AllocateSystemPixelBlock( getPixelSizeClassSize( sizeClass ), sizeClass );
+            }
+        }
+        else
+        {
+            // Not pooled or too big to keep around.
+            header = AllocateSystemPixelBlock( memSize, PIXEL_NO_SIZE_CLASS );
+
+            if ( usePool )
+            {
+                this->cacheMisses++;
+            }
+        }
+
+        // Update the statistics.
+        uint64 newBytesLive = ( this->bytesLive += header->blockSize );
+
+        uint64 curBytesPeak = this->bytesPeak.load();
+
+        while ( newBytesLive > curBytesPeak && !this->bytesPeak.compare_exchange_weak( curBytesPeak, newBytesLive ) );
+
+        return header;
+    }
+
+    void Free( pixelBlockHeader *header )
+    {
+        size_t blockSize = header->blockSize;
+
+        this->bytesLive -= blockSize;
+
+        uint32 sizeClass = header->sizeClass;
+
+        if ( sizeClass != PIXEL_NO_SIZE_CLASS && this->allocatorType == PIXELALLOC_POOLED && this->isActive )
+        {
+            cacheShard& shard = this->shards[ GetThreadPixelCacheShard() ];
+
+            scoped_rwlock_writer <rwlock> lock( shard.lock );
+
+            // Check again under the lock, so that no block is cached after Shutdown has released the shard.
+            if ( this->isActive && shard.cachedBytes + blockSize <= this->shardCacheLimit )
+            {
+                header->nextFree = shard.freeLists[ sizeClass ];
+                shard.freeLists[ sizeClass ] = header;
+
+                shard.cachedBytes += blockSize;
+
+                this->bytesCached += blockSize;
+
+                return;
+            }
+        }
+
+        FreeSystemPixelBlock( header );
+    }
+
+    ePixelAllocatorType allocatorType;
+    size_t shardCacheLimit;
+
+    std::atomic <bool> isActive;
+
+    cacheShard shards[ PIXEL_NUM_CACHE_SHARDS ];
+
+    // Statistics.
+    std::atomic <uint64> bytesLive;
+    std::atomic <uint64> bytesPeak;
+    std::atomic <uint64> bytesCached;
+    std::atomic <uint64> cacheHits;
+    std::atomic <uint64> cacheMisses;
+};
+
+static PluginDependantStructRegister <pixelAllocatorEnv, RwInterfaceFactory_t> pixelAllocatorEnvRegister;
+
 void* Interface::PixelAllocate( size_t memSize )
 {
-    return new uint8[ memSize ];
+    pixelBlockHeader *header = NULL;
+
+    if ( pixelAllocatorEnv *allocEnv = pixelAllocatorEnvRegister.GetPluginStruct( (EngineInterface*)this ) )
+    {
+        header = allocEnv->Allocate( memSize );
+    }
+    else
+    {
+        header = AllocateSystemPixelBlock( memSize, PIXEL_NO_SIZE_CLASS );
+    }
+
+    return GetPixelBlockData( header );
 }
 
 void Interface::PixelFree( void *ptr )
 {
-    delete [] ptr;
+    if ( ptr == NULL )
+        return;
+
+    pixelBlockHeader *header = GetPixelBlockHeader( ptr );
+
+    if ( pixelAllocatorEnv *allocEnv = pixelAllocatorEnvRegister.GetPluginStruct( (EngineInterface*)this ) )
+    {
+        allocEnv->Free( header );
+    }
+    else
+    {
+        FreeSystemPixelBlock( header );
+    }
+}
+
+ePixelAllocatorType Interface::GetPixelAllocatorType( void ) const
+{
+    ePixelAllocatorType allocatorType = PIXELALLOC_SYSTEM;
+
+    if ( const pixelAllocatorEnv *allocEnv = pixelAllocatorEnvRegister.GetConstPluginStruct( (const EngineInterface*)this ) )
+    {
+        allocatorType = allocEnv->allocatorType;
+    }
+
+    return allocatorType;
+}
+
+void Interface::GetPixelAllocatorStats( pixelAllocatorStats& statsOut ) const
+{
+    statsOut.bytesLive = 0;
+    statsOut.bytesPeak = 0;
+    statsOut.bytesCached = 0;
+    statsOut.cacheHits = 0;
+    statsOut.cacheMisses = 0;
+
+    if ( const pixelAllocatorEnv *allocEnv = pixelAllocatorEnvRegister.GetConstPluginStruct( (const EngineInterface*)this ) )
+    {
+        statsOut.bytesLive = allocEnv->bytesLive;
+        statsOut.bytesPeak = allocEnv->bytesPeak;
+        statsOut.bytesCached = allocEnv->bytesCached;
+        statsOut.cacheHits = allocEnv->cacheHits;
+        statsOut.cacheMisses = allocEnv->cacheMisses;
+    }
+}
+
+// Called by CreateEngine before the engine is handed out, so no pixels have been allocated yet.
+void SetupPixelAllocator( EngineInterface *engineInterface, const engineCreationParams& params )
+{
+    if ( pixelAllocatorEnv *allocEnv = pixelAllocatorEnvRegister.GetPluginStruct( engineInterface ) )
+    {
+        allocEnv->allocatorType = params.pixelAllocator;
+
+        if ( size_t pixelCacheSize = params.pixelCacheSize )
+        {
+            allocEnv->shardCacheLimit = ( pixelCacheSize / PIXEL_NUM_CACHE_SHARDS );
+        }
+    }
+}
+
+void registerPixelAllocatorEnvironment( void )
+{
+    pixelAllocatorEnvRegister.RegisterPlugin( engineFactory );
 }
 
-};
\ No newline at end of file
+};
@@ -8,6 +8,18 @@
 bool DeserializeMipmapLayer( Stream *inputStream, rawMipmapLayer& rawLayer );
 bool SerializeMipmapLayer( Stream *outputStream, const char *formatDescriptor, const rawMipmapLayer& rawLayer );
 
+// Decides the format that an image is decoded into, once the format of its rows is known.
+// Raw targets without palette are converted while decoding; palette and compressed targets receive the source format.
+struct imagingTargetFormatSelector abstract
+{
+    virtual void ChooseTargetFormat( const pixelFormat& srcFormat, uint32 srcPaletteSize, pixelFormat& dstFormatOut ) const = 0;
+};
+
+// Deserializes a mipmap layer while converting it into the format chosen by the selector.
+// Formats that can decode row by row never hold the image in two formats at once.
+// The other formats return their layer unconverted, so the caller still has to check the format.
+bool DeserializeMipmapLayerToFormat( Stream *inputStream, const imagingTargetFormatSelector& targetSelector, rawMipmapLayer& rawLayer );
+
 // Native imaging internal functions with special requirements.
 // Read them up before using them!
 void NativeImagePutToRasterNoLock( NativeImage *nativeImg, Raster *raster );
@@ -318,4 +318,7 @@ void CopyConvertPaletteData(
 bool ConvertPixelData( Interface *engineInterface, pixelDataTraversal& pixelsToConvert, const pixelFormat pixFormat );
 bool ConvertPixelDataDeferred( Interface *engineInterface, const pixelDataTraversal& srcPixels, pixelDataTraversal& dstPixels, const pixelFormat pixFormat );
 
+// Reads the rasters of all lazily loaded textures whose source is the given stream.
+void LoadLazyTexturesFromStream( EngineInterface *engineInterface, Stream *sourceStream );
+
 #endif //_RENDERWARE_PRIVATE_TEXDICT_
\ No newline at end of file
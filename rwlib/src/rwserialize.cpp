@@ -188,10 +188,10 @@ void Interface::SerializeBlock( RwObject *objectToStore, BlockProvider& outputPr
         catch( ... )
         {
             // If any exception was triggered during serialization, we want to cleanly leave the context
-            // and rethrow it.
+            // and rethrow it. The unfinished block must not be written to sequential outputs.
             if ( requiresBlockContext )
             {
-                outputProvider.LeaveContext();
+                outputProvider.AbortContext();
             }
 
             throw;
@@ -0,0 +1,132 @@
+/*
+    RenderWare SIMD helpers.
+
+    We want to make use of the vector units of the machine whenever we have to crunch
+    through a lot of texels. Instruction sets above the compile-time baseline have to be
+    checked at runtime because our users run all kinds of machines.
+*/
+
+#ifndef _RENDERWARE_SIMD_HELPERS_
+#define _RENDERWARE_SIMD_HELPERS_
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define RWLIB_ENABLE_X86_SIMD
+#endif
+
+#ifdef RWLIB_ENABLE_X86_SIMD
+
+#include <emmintrin.h>
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+// Functions that use instructions above the compilation baseline have to be marked.
+// MSVC allows any intrinsic anywhere, GCC and clang want a target attribute.
+#if defined(__GNUC__) || defined(__clang__)
+#define RWSIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define RWSIMD_TARGET_AVX2
+#endif
+
+#endif //RWLIB_ENABLE_X86_SIMD
+
+namespace rw
+{
+
+// Capabilities of the processor that executes us.
+struct cpuFeatures
+{
+    bool hasSSE2;
+    bool hasAVX2;
+};
+
+#ifdef RWLIB_ENABLE_X86_SIMD
+
+inline void _rwsimd_cpuid( int regs[4], int leaf, int subleaf )
+{
+#ifdef _MSC_VER
+    __cpuidex( regs, leaf, subleaf );
+#else
+    unsigned int a, b, c, d;
+
+    __cpuid_count( leaf, subleaf, a, b, c, d );
+
+    regs[0] = (int)a;
+    regs[1] = (int)b;
+    regs[2] = (int)c;
+    regs[3] = (int)d;
+#endif
+}
+
+inline unsigned long long _rwsimd_xgetbv( unsigned int idx )
+{
+#ifdef _MSC_VER
+    return _xgetbv( idx );
+#else
+    unsigned int eax, edx;
+
+    __asm__ __volatile__( "xgetbv" : "=a" (eax), "=d" (edx) : "c" (idx) );
+
+    return ( (unsigned long long)edx << 32 ) | eax;
+#endif
+}
+
+inline cpuFeatures _rwsimd_detect_features( void )
+{
+    cpuFeatures features;
+    features.hasSSE2 = false;
+    features.hasAVX2 = false;
+
+    int regs[4];
+
+    _rwsimd_cpuid( regs, 0, 0 );
+
+    int maxLeaf = regs[0];
+
+    if ( maxLeaf >= 1 )
+    {
+        _rwsimd_cpuid( regs, 1, 0 );
+
+        features.hasSSE2 = ( ( regs[3] & ( 1 << 26 ) ) != 0 );
+
+        bool hasOSXSAVE = ( ( regs[2] & ( 1 << 27 ) ) != 0 );
+        bool hasAVX = ( ( regs[2] & ( 1 << 28 ) ) != 0 );
+
+        if ( maxLeaf >= 7 && hasOSXSAVE && hasAVX )
+        {
+            // The operating system has to save the YMM registers for us.
+            unsigned long long xcr0 = _rwsimd_xgetbv( 0 );
+
+            if ( ( xcr0 & 0x6 ) == 0x6 )
+            {
+                _rwsimd_cpuid( regs, 7, 0 );
+
+                features.hasAVX2 = ( ( regs[1] & ( 1 << 5 ) ) != 0 );
+            }
+        }
+    }
+
+    return features;
+}
+
+#endif //RWLIB_ENABLE_X86_SIMD
+
+// Returns the (cached) feature set of the running processor.
+inline const cpuFeatures& GetCPUFeatures( void )
+{
+#ifdef RWLIB_ENABLE_X86_SIMD
+    static const cpuFeatures features = _rwsimd_detect_features();
+#else
+    static const cpuFeatures features = { false, false };
+#endif
+
+    return features;
+}
+
+};
+
+#endif //_RENDERWARE_SIMD_HELPERS_
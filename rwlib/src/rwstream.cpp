@@ -2,6 +2,17 @@
 
 #include "pluginutil.hxx"
 
+#ifdef _WIN32
+#include "native.win32.hxx"
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif //_WIN32
+
+#include <limits>
+
 namespace rw
 {
 
@@ -39,6 +50,12 @@ int64 Stream::size( void ) const throw( ... )
     throw RwStreamException( "size is not supported" );
 }
 
+const void* Stream::view( size_t viewCount ) throw( ... )
+{
+    // Streams are not memory based by default.
+    return NULL;
+}
+
 bool Stream::supportsSize( void ) const
 {
     return false;
@@ -93,7 +110,7 @@ struct FileStream : public Stream
     {
         if ( Interface *engineInterface = this->engineInterface )
         {
-            engineInterface->GetFileInterface()->SeekStream( this->file_handle, (long)skipCount, SEEK_CUR );
+            engineInterface->GetFileInterface()->SeekStream( this->file_handle, skipCount, SEEK_CUR );
         }
     }
 
@@ -129,7 +146,7 @@ struct FileStream : public Stream
                 ansi_seek = SEEK_END;
             }   
 
-            engineInterface->GetFileInterface()->SeekStream( this->file_handle, (long)seek_off, ansi_seek );
+            engineInterface->GetFileInterface()->SeekStream( this->file_handle, seek_off, ansi_seek );
         }
     }
 
@@ -154,47 +171,389 @@ struct FileStream : public Stream
 };
 
 // Memory stream.
+// Works either on a buffer of the caller or on a buffer that is owned by the engine.
+// Only the engine-owned buffer can grow.
 struct MemoryStream : public Stream
 {
     inline MemoryStream( Interface *engineInterface, void *construction_params ) : Stream( engineInterface, construction_params )
     {
-        return;
+        this->buf = NULL;
+        this->bufCapacity = 0;
+        this->dataSize = 0;
+        this->seekPos = 0;
+        this->isOwnedBuffer = false;
+        this->isWritable = false;
     }
 
-    size_t read( void *out_buf, size_t readCount )
+    inline ~MemoryStream( void )
     {
-        return 0;
+        if ( this->isOwnedBuffer )
+        {
+            if ( void *buf = this->buf )
+            {
+                this->engineInterface->MemFree( buf );
+            }
+        }
     }
 
-    size_t write( const void *in_buf, size_t writeCount )
+    // Makes sure that the buffer can take reqSize bytes.
+    inline bool reserve( size_t reqSize )
     {
-        return 0;
+        if ( reqSize <= this->bufCapacity )
+            return true;
+
+        if ( this->isOwnedBuffer == false )
+            return false;
+
+        size_t newCapacity = std::max( std::max( reqSize, this->bufCapacity * 2 ), (size_t)256 );
+
+        char *newBuf = (char*)this->engineInterface->MemAllocate( newCapacity );
+
+        if ( char *oldBuf = this->buf )
+        {
+            memcpy( newBuf, oldBuf, this->dataSize );
+
+            this->engineInterface->MemFree( oldBuf );
+        }
+
+        this->buf = newBuf;
+        this->bufCapacity = newCapacity;
+
+        return true;
     }
 
-    void skip( int64 skipCount )
+    size_t read( void *out_buf, size_t readCount ) override
     {
+        size_t seekPos = this->seekPos;
+        size_t dataSize = this->dataSize;
+
+        if ( seekPos >= dataSize )
+            return 0;
 
+        size_t actualReadCount = std::min( readCount, dataSize - seekPos );
+
+        memcpy( out_buf, this->buf + seekPos, actualReadCount );
+
+        this->seekPos = ( seekPos + actualReadCount );
+
+        return actualReadCount;
     }
 
-    int64 tell( void ) const
+    size_t write( const void *in_buf, size_t writeCount ) override
     {
-        return 0;
+        if ( this->isWritable == false || writeCount == 0 )
+            return 0;
+
+        size_t seekPos = this->seekPos;
+
+        if ( writeCount > std::numeric_limits <size_t>::max() - seekPos )
+            return 0;
+
+        size_t writeEnd = ( seekPos + writeCount );
+
+        if ( this->reserve( writeEnd ) == false )
+        {
+            // Write as much as fits into the caller's buffer.
+            size_t bufCapacity = this->bufCapacity;
+
+            if ( seekPos >= bufCapacity )
+                return 0;
+
+            writeCount = ( bufCapacity - seekPos );
+            writeEnd = bufCapacity;
+        }
+
+        char *buf = this->buf;
+
+        // If we seeked past the end, the gap is zero-filled, just like with files.
+        size_t dataSize = this->dataSize;
+
+        if ( seekPos > dataSize )
+        {
+            memset( buf + dataSize, 0, seekPos - dataSize );
+        }
+
+        memcpy( buf + seekPos, in_buf, writeCount );
+
+        this->seekPos = writeEnd;
+
+        if ( writeEnd > dataSize )
+        {
+            this->dataSize = writeEnd;
+        }
+
+        return writeCount;
     }
 
-    void seek( int64 seek_off, eSeekMode seek_mode )
+    void skip( int64 skipCount ) override
     {
+        this->seek( skipCount, RWSEEK_CUR );
+    }
 
+    int64 tell( void ) const override
+    {
+        return (int64)this->seekPos;
     }
 
-    int64 size( void ) const
+    void seek( int64 seek_off, eSeekMode seek_mode ) override
     {
+        int64 basePos = 0;
+
+        if ( seek_mode == RWSEEK_CUR )
+        {
+            basePos = (int64)this->seekPos;
+        }
+        else if ( seek_mode == RWSEEK_END )
+        {
+            basePos = (int64)this->dataSize;
+        }
+
+        int64 newPos = ( basePos + seek_off );
+
+        if ( newPos < 0 || (uint64)newPos > std::numeric_limits <size_t>::max() )
+        {
+            throw RwStreamException( "invalid memory stream seek" );
+        }
+
+        this->seekPos = (size_t)newPos;
+    }
+
+    int64 size( void ) const override
+    {
+        return (int64)this->dataSize;
+    }
+
+    const void* view( size_t viewCount ) override
+    {
+        size_t seekPos = this->seekPos;
+        size_t dataSize = this->dataSize;
+
+        if ( seekPos > dataSize || viewCount > ( dataSize - seekPos ) )
+            return NULL;
+
+        this->seekPos = ( seekPos + viewCount );
+
+        return ( this->buf + seekPos );
+    }
+
+    bool supportsSize( void ) const override
+    {
+        return true;
+    }
+
+    char *buf;
+    size_t bufCapacity;
+    size_t dataSize;
+    size_t seekPos;
+
+    bool isOwnedBuffer;
+    bool isWritable;
+};
+
+// Read-only file stream that maps the whole file into memory.
+// Reading is a memcpy out of the mapping and view requests point straight into it.
+struct MappedFileStream : public Stream
+{
+    inline MappedFileStream( Interface *engineInterface, void *construction_params ) : Stream( engineInterface, construction_params )
+    {
+        this->mapping = NULL;
+        this->mapSize = 0;
+        this->seekPos = 0;
+
+#ifdef _WIN32
+        this->fileHandle = INVALID_HANDLE_VALUE;
+        this->mapHandle = NULL;
+#endif //_WIN32
+    }
+
+    inline ~MappedFileStream( void )
+    {
+#ifdef _WIN32
+        if ( const char *mapping = this->mapping )
+        {
+            UnmapViewOfFile( mapping );
+        }
+
+        if ( HANDLE mapHandle = this->mapHandle )
+        {
+            CloseHandle( mapHandle );
+        }
+
+        if ( this->fileHandle != INVALID_HANDLE_VALUE )
+        {
+            CloseHandle( this->fileHandle );
+        }
+#else
+        if ( const char *mapping = this->mapping )
+        {
+            munmap( (void*)mapping, this->mapSize );
+        }
+#endif //_WIN32
+    }
+
+#ifdef _WIN32
+    inline bool mapFile( HANDLE fileHandle )
+    {
+        if ( fileHandle == INVALID_HANDLE_VALUE )
+            return false;
+
+        this->fileHandle = fileHandle;
+
+        LARGE_INTEGER fileSize;
+
+        if ( GetFileSizeEx( fileHandle, &fileSize ) == FALSE )
+            return false;
+
+        if ( (uint64)fileSize.QuadPart > std::numeric_limits <size_t>::max() )
+            return false;
+
+        // Empty files cannot be mapped, but they are valid streams nonetheless.
+        if ( fileSize.QuadPart == 0 )
+            return true;
+
+        HANDLE mapHandle = CreateFileMappingW( fileHandle, NULL, PAGE_READONLY, 0, 0, NULL );
+
+        if ( mapHandle == NULL )
+            return false;
+
+        this->mapHandle = mapHandle;
+
+        const void *mapping = MapViewOfFile( mapHandle, FILE_MAP_READ, 0, 0, 0 );
+
+        if ( mapping == NULL )
+            return false;
+
+        this->mapping = (const char*)mapping;
+        this->mapSize = (size_t)fileSize.QuadPart;
+
+        return true;
+    }
+#else
+    inline bool mapFile( int fileDesc )
+    {
+        if ( fileDesc == -1 )
+            return false;
+
+        bool success = false;
+
+        struct stat fileInfo;
+
+        if ( fstat( fileDesc, &fileInfo ) == 0 && (uint64)fileInfo.st_size <= std::numeric_limits <size_t>::max() )
+        {
+            size_t fileSize = (size_t)fileInfo.st_size;
+
+            if ( fileSize == 0 )
+            {
+                success = true;
+            }
+            else
+            {
+                void *mapping = mmap( NULL, fileSize, PROT_READ, MAP_PRIVATE, fileDesc, 0 );
+
+                if ( mapping != MAP_FAILED )
+                {
+                    this->mapping = (const char*)mapping;
+                    this->mapSize = fileSize;
+
+                    success = true;
+                }
+            }
+        }
+
+        // The mapping stays valid without the descriptor.
+        close( fileDesc );
+
+        return success;
+    }
+#endif //_WIN32
+
+    size_t read( void *out_buf, size_t readCount ) override
+    {
+        size_t seekPos = this->seekPos;
+        size_t mapSize = this->mapSize;
+
+        if ( seekPos >= mapSize )
+            return 0;
+
+        size_t actualReadCount = std::min( readCount, mapSize - seekPos );
+
+        memcpy( out_buf, this->mapping + seekPos, actualReadCount );
+
+        this->seekPos = ( seekPos + actualReadCount );
+
+        return actualReadCount;
+    }
+
+    size_t write( const void *in_buf, size_t writeCount ) override
+    {
+        // Mapped file streams are read-only.
         return 0;
     }
 
-    bool supportsSize( void ) const
+    void skip( int64 skipCount ) override
+    {
+        this->seek( skipCount, RWSEEK_CUR );
+    }
+
+    int64 tell( void ) const override
+    {
+        return (int64)this->seekPos;
+    }
+
+    void seek( int64 seek_off, eSeekMode seek_mode ) override
+    {
+        int64 basePos = 0;
+
+        if ( seek_mode == RWSEEK_CUR )
+        {
+            basePos = (int64)this->seekPos;
+        }
+        else if ( seek_mode == RWSEEK_END )
+        {
+            basePos = (int64)this->mapSize;
+        }
+
+        int64 newPos = ( basePos + seek_off );
+
+        if ( newPos < 0 || (uint64)newPos > std::numeric_limits <size_t>::max() )
+        {
+            throw RwStreamException( "invalid mapped file stream seek" );
+        }
+
+        this->seekPos = (size_t)newPos;
+    }
+
+    int64 size( void ) const override
+    {
+        return (int64)this->mapSize;
+    }
+
+    const void* view( size_t viewCount ) override
+    {
+        size_t seekPos = this->seekPos;
+        size_t mapSize = this->mapSize;
+
+        if ( seekPos > mapSize || viewCount > ( mapSize - seekPos ) )
+            return NULL;
+
+        this->seekPos = ( seekPos + viewCount );
+
+        return ( this->mapping + seekPos );
+    }
+
+    bool supportsSize( void ) const override
     {
         return true;
     }
+
+    const char *mapping;
+    size_t mapSize;
+    size_t seekPos;
+
+#ifdef _WIN32
+    HANDLE fileHandle;
+    HANDLE mapHandle;
+#endif //_WIN32
 };
 
 // Custom stream.
@@ -306,11 +665,13 @@ struct streamSystemPlugin
     {
         this->fileStreamTypeInfo = NULL;
         this->memoryStreamTypeInfo = NULL;
+        this->mappedFileStreamTypeInfo = NULL;
 
         if ( engine->streamTypeInfo != NULL )
         {
             this->fileStreamTypeInfo = engine->typeSystem.RegisterStructType <FileStream> ( "file_stream", engine->streamTypeInfo );
             this->memoryStreamTypeInfo = engine->typeSystem.RegisterStructType <MemoryStream> ( "memory_stream", engine->streamTypeInfo );
+            this->mappedFileStreamTypeInfo = engine->typeSystem.RegisterStructType <MappedFileStream> ( "mapped_file_stream", engine->streamTypeInfo );
         }
 
         this->streamEnvLock = rw::CreateReadWriteLock( engine );
@@ -341,11 +702,17 @@ struct streamSystemPlugin
         {
             engine->typeSystem.DeleteType( memoryStreamTypeInfo );
         }
+
+        if ( RwTypeSystem::typeInfoBase *mappedFileStreamTypeInfo = this->mappedFileStreamTypeInfo )
+        {
+            engine->typeSystem.DeleteType( mappedFileStreamTypeInfo );
+        }
     }
 
     // Built-in stream types.
     RwTypeSystem::typeInfoBase *fileStreamTypeInfo;
     RwTypeSystem::typeInfoBase *memoryStreamTypeInfo;
+    RwTypeSystem::typeInfoBase *mappedFileStreamTypeInfo;
     
     // Custom stream types.
     typedef std::vector <RwTypeSystem::typeInfoBase*> typeInfoList_t;
@@ -578,7 +945,152 @@ Stream* Interface::CreateStream( eBuiltinStreamType streamType, eStreamMode stre
         }
         else if ( streamType == RWSTREAMTYPE_MEMORY )
         {
+            if ( RwTypeSystem::typeInfoBase *memoryStreamTypeInfo = streamSysEnv->memoryStreamTypeInfo )
+            {
+                if ( param->dwSize >= sizeof( streamConstructionMemoryParam_t ) )
+                {
+                    streamConstructionMemoryParam_t *mem_param = (streamConstructionMemoryParam_t*)param;
+
+                    GenericRTTI *rttiObj = engineInterface->typeSystem.Construct( engineInterface, memoryStreamTypeInfo, NULL );
+
+                    if ( rttiObj )
+                    {
+                        MemoryStream *memStream = (MemoryStream*)RwTypeSystem::GetObjectFromTypeStruct( rttiObj );
+
+                        memStream->isWritable = ( streamMode != RWSTREAMMODE_READONLY );
+
+                        bool isSetup = true;
+
+                        if ( void *buf = mem_param->buf )
+                        {
+                            memStream->buf = (char*)buf;
+                            memStream->bufCapacity = mem_param->bufSize;
+
+                            // Just like files, the write-only modes start out empty.
+                            if ( streamMode == RWSTREAMMODE_WRITEONLY || streamMode == RWSTREAMMODE_CREATE )
+                            {
+                                memStream->dataSize = 0;
+                            }
+                            else
+                            {
+                                memStream->dataSize = mem_param->bufSize;
+                            }
+                        }
+                        else
+                        {
+                            memStream->isOwnedBuffer = true;
+
+                            try
+                            {
+                                memStream->reserve( mem_param->bufSize );
+                            }
+                            catch( ... )
+                            {
+                                isSetup = false;
+                            }
+                        }
+
+                        if ( isSetup )
+                        {
+                            outputStream = memStream;
+                        }
+                        else
+                        {
+                            engineInterface->typeSystem.Destroy( engineInterface, rttiObj );
+                        }
+                    }
+                }
+            }
+        }
+        else if ( streamType == RWSTREAMTYPE_FILE_MAPPED || streamType == RWSTREAMTYPE_FILE_MAPPED_W )
+        {
+            // Mappings can only be read from.
+            if ( streamMode == RWSTREAMMODE_READONLY )
+            {
+                if ( RwTypeSystem::typeInfoBase *mappedFileStreamTypeInfo = streamSysEnv->mappedFileStreamTypeInfo )
+                {
+                    bool hasValidParam = false;
 
+                    if ( streamType == RWSTREAMTYPE_FILE_MAPPED )
+                    {
+                        hasValidParam = ( param->dwSize >= sizeof( streamConstructionFileParam_t ) );
+                    }
+                    else if ( streamType == RWSTREAMTYPE_FILE_MAPPED_W )
+                    {
+                        hasValidParam = ( param->dwSize >= sizeof( streamConstructionFileParamW_t ) );
+                    }
+
+                    GenericRTTI *rttiObj = NULL;
+
+                    if ( hasValidParam )
+                    {
+                        rttiObj = engineInterface->typeSystem.Construct( engineInterface, mappedFileStreamTypeInfo, NULL );
+                    }
+
+                    if ( rttiObj )
+                    {
+                        MappedFileStream *mappedStream = (MappedFileStream*)RwTypeSystem::GetObjectFromTypeStruct( rttiObj );
+
+                        bool couldMap = false;
+
+#ifdef _WIN32
+                        HANDLE fileHandle = INVALID_HANDLE_VALUE;
+
+                        if ( streamType == RWSTREAMTYPE_FILE_MAPPED )
+                        {
+                            streamConstructionFileParam_t *file_param = (streamConstructionFileParam_t*)param;
+
+                            fileHandle = CreateFileA( file_param->filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+                        }
+                        else
+                        {
+                            streamConstructionFileParamW_t *file_param = (streamConstructionFileParamW_t*)param;
+
+                            fileHandle = CreateFileW( file_param->filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+                        }
+
+                        couldMap = mappedStream->mapFile( fileHandle );
+#else
+                        int fileDesc = -1;
+
+                        if ( streamType == RWSTREAMTYPE_FILE_MAPPED )
+                        {
+                            streamConstructionFileParam_t *file_param = (streamConstructionFileParam_t*)param;
+
+                            fileDesc = open( file_param->filename, O_RDONLY );
+                        }
+                        else
+                        {
+                            streamConstructionFileParamW_t *file_param = (streamConstructionFileParamW_t*)param;
+
+                            // The system wants multi-byte paths.
+                            size_t pathLength = wcstombs( NULL, file_param->filename, 0 );
+
+                            if ( pathLength != (size_t)-1 )
+                            {
+                                std::string mbPath( pathLength, '\0' );
+
+                                wcstombs( &mbPath[ 0 ], file_param->filename, pathLength + 1 );
+
+                                fileDesc = open( mbPath.c_str(), O_RDONLY );
+                            }
+                        }
+
+                        couldMap = mappedStream->mapFile( fileDesc );
+#endif //_WIN32
+
+                        if ( couldMap )
+                        {
+                            outputStream = mappedStream;
+                        }
+                        else
+                        {
+                            // This also closes any handles that we got.
+                            engineInterface->typeSystem.Destroy( engineInterface, rttiObj );
+                        }
+                    }
+                }
+            }
         }
         else if ( streamType == RWSTREAMTYPE_CUSTOM )
         {
@@ -632,6 +1144,9 @@ void Interface::DeleteStream( Stream *theStream )
 {
     EngineInterface *engineInterface = (EngineInterface*)this;
 
+    // Textures that still have to read their raster from this stream do so now.
+    LoadLazyTexturesFromStream( engineInterface, theStream );
+
     // Just rek it.
     engineInterface->typeSystem.Destroy( engineInterface, RwTypeSystem::GetTypeStructFromObject( theStream ) );
 }
@@ -117,6 +117,22 @@ struct reentrant_rwlock_implementation : public reentrant_rwlock
     }
 };
 
+// Condition variable implementation.
+void rwcond::wait( rwlock *theLock )
+{
+    ((CConditionVariable*)this)->Wait( (CReadWriteLock*)GetRWLockObject( theLock ) );
+}
+
+void rwcond::signal( void )
+{
+    ((CConditionVariable*)this)->Signal();
+}
+
+void rwcond::signal_all( void )
+{
+    ((CConditionVariable*)this)->SignalAll();
+}
+
 // Lock creation API.
 rwlock* CreateReadWriteLock( Interface *engineInterface )
 {
@@ -210,6 +226,31 @@ void ClosePlacedReentrantReadWriteLock( Interface *engineInterface, reentrant_rw
     reentrant_rwlock_implementation::Destroy( threadEnv, theLock );
 }
 
+rwcond* CreateConditionVariable( Interface *engineInterface )
+{
+    threadingEnvironment *threadEnv = GetThreadingEnv( engineInterface );
+
+    size_t condSize = threadEnv->nativeMan->GetConditionVariableStructSize();
+
+    void *condMem = engineInterface->MemAllocate( condSize );
+
+    if ( !condMem )
+    {
+        return NULL;
+    }
+
+    return (rwcond*)threadEnv->nativeMan->CreatePlacedConditionVariable( condMem );
+}
+
+void CloseConditionVariable( Interface *engineInterface, rwcond *theCond )
+{
+    threadingEnvironment *threadEnv = GetThreadingEnv( engineInterface );
+
+    threadEnv->nativeMan->ClosePlacedConditionVariable( (CConditionVariable*)theCond );
+
+    engineInterface->MemFree( theCond );
+}
+
 // Thread API.
 struct nativeexec_traverse
 {
@@ -0,0 +1,333 @@
+// RenderWare worker thread pool implementation.
+#include "StdInc.h"
+
+#include "rwthreading.pool.hxx"
+
+#include "rwconf.hxx"
+
+#include <thread>
+
+namespace rw
+{
+
+threadPoolEnvRegister_t threadPoolEnvRegister;
+
+AINLINE uint64 makeItemRange( uint32 begin, uint32 end )
+{
+    return ( (uint64)begin | ( (uint64)end << 32 ) );
+}
+
+AINLINE uint32 getItemRangeBegin( uint64 range )
+{
+    return (uint32)( range );
+}
+
+AINLINE uint32 getItemRangeEnd( uint64 range )
+{
+    return (uint32)( range >> 32 );
+}
+
+bool threadPoolEnv::ClaimItem( parallelJob& job, uint32 ownRange, uint32& itemIndexOut )
+{
+    // First take from the front of our own range.
+    if ( ownRange < job.rangeCount )
+    {
+        itemRange_t& range = job.ranges[ ownRange ];
+
+        uint64 curRange = range.load();
+
+        while ( true )
+        {
+            uint32 begin = getItemRangeBegin( curRange );
+            uint32 end = getItemRangeEnd( curRange );
+
+            if ( begin >= end )
+                break;
+
+            if ( range.compare_exchange_weak( curRange, makeItemRange( begin + 1, end ) ) )
+            {
+                job.unclaimedItems--;
+
+                itemIndexOut = begin;
+                return true;
+            }
+        }
+    }
+
+    // Steal from the back of the other ranges.
+    // We start at our neighbour so that thieves do not all crowd the same range.
+    // Ranges only ever shrink, so once every range was seen empty there is nothing left to claim.
+    uint32 rangeCount = job.rangeCount;
+
+    for ( uint32 n = 1; n <= rangeCount; n++ )
+    {
+        uint32 victim = ( ( ownRange + n ) % rangeCount );
+
+        itemRange_t& range = job.ranges[ victim ];
+
+        uint64 curRange = range.load();
+
+        while ( true )
+        {
+            uint32 begin = getItemRangeBegin( curRange );
+            uint32 end = getItemRangeEnd( curRange );
+
+            if ( begin >= end )
+                break;
+
+            if ( range.compare_exchange_weak( curRange, makeItemRange( begin, end - 1 ) ) )
+            {
+                job.unclaimedItems--;
+
+                itemIndexOut = ( end - 1 );
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+void threadPoolEnv::Participate( parallelJob& job )
+{
+    uint32 ownRange = job.nextRange++;
+
+    uint32 itemIndex;
+
+    while ( ClaimItem( job, ownRange, itemIndex ) )
+    {
+        // Once something failed we just drain the items.
+        if ( job.hasFailed.load() == false )
+        {
+            try
+            {
+                job.callback( job.ud, itemIndex );
+            }
+            catch( ... )
+            {
+                scoped_rwlock_writer <rwlock> lock( this->poolLock );
+
+                if ( job.hasFailed.load() == false )
+                {
+                    job.failure = std::current_exception();
+                    job.hasFailed = true;
+                }
+            }
+        }
+
+        if ( --job.pendingItems == 0 )
+        {
+            scoped_rwlock_writer <rwlock> lock( this->poolLock );
+
+            this->jobFinishedCond->signal_all();
+        }
+    }
+}
+
+void threadPoolEnv::RunJob( parallelJob& job )
+{
+    uint32 helperCount = job.maxHelpers;
+
+    if ( helperCount != 0 )
+    {
+        scoped_rwlock_writer <rwlock> lock( this->poolLock );
+
+        this->EnsureWorkers( helperCount );
+
+        LIST_APPEND( this->activeJobs.root, job.node );
+
+        this->workAvailableCond->signal_all();
+    }
+
+    // The calling thread always takes part, so we make progress even if every worker is busy.
+    this->Participate( job );
+
+    if ( helperCount != 0 )
+    {
+        scoped_rwlock_writer <rwlock> lock( this->poolLock );
+
+        // Wait for the items that other threads are still processing.
+        while ( job.pendingItems.load() != 0 )
+        {
+            this->jobFinishedCond->wait( this->poolLock );
+        }
+
+        LIST_REMOVE( job.node );
+
+        // The job lives on our stack, so no helper may touch it anymore after we return.
+        while ( job.attachedHelpers != 0 )
+        {
+            this->jobFinishedCond->wait( this->poolLock );
+        }
+    }
+}
+
+void threadPoolEnv::EnsureWorkers( uint32 workerCount )
+{
+    // Called with the pool lock held.
+    while ( this->workers.size() < workerCount )
+    {
+        thread_t worker = MakeThread( this->engineInterface, _WorkerThreadMain, this );
+
+        if ( worker == NULL )
+            break;
+
+        this->workers.push_back( worker );
+
+        ResumeThread( this->engineInterface, worker );
+    }
+}
+
+void __cdecl threadPoolEnv::_WorkerThreadMain( thread_t threadHandle, Interface *engineInterface, void *ud )
+{
+    threadPoolEnv *poolEnv = (threadPoolEnv*)ud;
+
+    rwlock *poolLock = poolEnv->poolLock;
+
+    scoped_rwlock_writer <rwlock> lock( poolLock );
+
+    while ( poolEnv->isTerminating == false )
+    {
+        parallelJob *job = NULL;
+
+        LIST_FOREACH_BEGIN( parallelJob, poolEnv->activeJobs.root, node )
+
+            if ( item->attachedHelpers < item->maxHelpers && item->unclaimedItems.load() != 0 )
+            {
+                job = item;
+                break;
+            }
+
+        LIST_FOREACH_END
+
+        if ( job == NULL )
+        {
+            // Sleep until a job with unclaimed items is posted.
+            poolEnv->workAvailableCond->wait( poolLock );
+            continue;
+        }
+
+        job->attachedHelpers++;
+
+        poolLock->leave_write();
+
+        poolEnv->Participate( *job );
+
+        poolLock->enter_write();
+
+        if ( --job->attachedHelpers == 0 )
+        {
+            poolEnv->jobFinishedCond->signal_all();
+        }
+    }
+}
+
+void threadPoolEnv::StopWorkers( void )
+{
+    {
+        scoped_rwlock_writer <rwlock> lock( this->poolLock );
+
+        this->isTerminating = true;
+
+        this->workAvailableCond->signal_all();
+    }
+
+    EngineInterface *engineInterface = this->engineInterface;
+
+    for ( thread_t worker : this->workers )
+    {
+        JoinThread( engineInterface, worker );
+        CloseThread( engineInterface, worker );
+    }
+
+    this->workers.clear();
+}
+
+uint32 GetParallelConcurrency( EngineInterface *engineInterface )
+{
+    uint32 threadCount = GetConstEnvironmentConfigBlock( engineInterface ).GetWorkerThreadCount();
+
+    if ( threadCount == 0 )
+    {
+        // One thread per logical processor.
+        threadCount = std::thread::hardware_concurrency();
+
+        if ( threadCount == 0 )
+        {
+            threadCount = 1;
+        }
+    }
+
+    if ( threadCount > MAX_POOL_PARTICIPANTS )
+    {
+        threadCount = MAX_POOL_PARTICIPANTS;
+    }
+
+    return threadCount;
+}
+
+void ParallelForEx( EngineInterface *engineInterface, uint32 itemCount, uint32 maxConcurrency, parallelTaskCallback_t callback, void *ud )
+{
+    if ( itemCount == 0 )
+        return;
+
+    threadPoolEnv *poolEnv = threadPoolEnvRegister.GetPluginStruct( engineInterface );
+
+    uint32 participantCount = std::min( std::min( maxConcurrency, itemCount ), (uint32)MAX_POOL_PARTICIPANTS );
+
+    if ( poolEnv == NULL || participantCount <= 1 )
+    {
+        // Just do it on this thread.
+        for ( uint32 n = 0; n < itemCount; n++ )
+        {
+            callback( ud, n );
+        }
+
+        return;
+    }
+
+    threadPoolEnv::parallelJob job;
+    job.callback = callback;
+    job.ud = ud;
+    job.rangeCount = participantCount;
+
+    // Split the items evenly across the participants.
+    for ( uint32 n = 0; n < participantCount; n++ )
+    {
+        uint32 begin = (uint32)( ( (uint64)itemCount * n ) / participantCount );
+        uint32 end = (uint32)( ( (uint64)itemCount * ( n + 1 ) ) / participantCount );
+
+        job.ranges[ n ] = makeItemRange( begin, end );
+    }
+
+    job.nextRange = 0;
+    job.unclaimedItems = itemCount;
+    job.pendingItems = itemCount;
+    job.hasFailed = false;
+    job.maxHelpers = ( participantCount - 1 );
+    job.attachedHelpers = 0;
+
+    poolEnv->RunJob( job );
+
+    if ( job.hasFailed )
+    {
+        std::rethrow_exception( job.failure );
+    }
+}
+
+void ShutdownThreadPool( EngineInterface *engineInterface )
+{
+    threadPoolEnv *poolEnv = threadPoolEnvRegister.GetPluginStruct( engineInterface );
+
+    if ( poolEnv )
+    {
+        poolEnv->StopWorkers();
+    }
+}
+
+void registerThreadPoolEnvironment( void )
+{
+    threadPoolEnvRegister.RegisterPlugin( engineFactory );
+}
+
+};
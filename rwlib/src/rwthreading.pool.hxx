@@ -0,0 +1,145 @@
+// RenderWare worker thread pool.
+// Texel crunching (compression, filtering, conversion) can be split into independent items.
+// Those items are spread over the worker threads of the pool, and the thread that asked for the
+// work takes part itself. Every participant owns a range of item indices and takes items from
+// the front of it. If a participant runs out of items, it steals from the back of another range.
+
+#ifndef _RENDERWARE_THREAD_POOL_
+#define _RENDERWARE_THREAD_POOL_
+
+#include "pluginutil.hxx"
+
+#include <atomic>
+#include <exception>
+#include <vector>
+
+namespace rw
+{
+
+// Upper limit of threads that work on a single job.
+#define MAX_POOL_PARTICIPANTS   64
+
+typedef void (*parallelTaskCallback_t)( void *ud, uint32 itemIndex );
+
+struct threadPoolEnv
+{
+    inline void Initialize( EngineInterface *engineInterface )
+    {
+        this->engineInterface = engineInterface;
+        this->isTerminating = false;
+
+        this->poolLock = CreateReadWriteLock( engineInterface );
+        this->workAvailableCond = CreateConditionVariable( engineInterface );
+        this->jobFinishedCond = CreateConditionVariable( engineInterface );
+
+        LIST_CLEAR( this->activeJobs.root );
+    }
+
+    inline void Shutdown( EngineInterface *engineInterface )
+    {
+        // The workers must have been stopped before the threading environment went down.
+        assert( this->workers.empty() == true );
+
+        if ( rwcond *cond = this->jobFinishedCond )
+        {
+            CloseConditionVariable( engineInterface, cond );
+        }
+
+        if ( rwcond *cond = this->workAvailableCond )
+        {
+            CloseConditionVariable( engineInterface, cond );
+        }
+
+        if ( rwlock *lock = this->poolLock )
+        {
+            CloseReadWriteLock( engineInterface, lock );
+        }
+    }
+
+    inline void operator = ( const threadPoolEnv& right )
+    {
+        throw RwException( "cannot copy thread pool environment" );
+    }
+
+    // A range of item indices that a participant is working on.
+    // The low 32bits are the first index, the high 32bits are the end index.
+    typedef std::atomic <uint64> itemRange_t;
+
+    struct parallelJob
+    {
+        parallelTaskCallback_t callback;
+        void *ud;
+
+        uint32 rangeCount;
+        itemRange_t ranges[ MAX_POOL_PARTICIPANTS ];
+
+        std::atomic <uint32> nextRange;         // next range that is given to a participant
+        std::atomic <uint32> unclaimedItems;    // items that have not been taken yet
+        std::atomic <uint32> pendingItems;      // items that have not finished yet
+
+        std::atomic <bool> hasFailed;
+        std::exception_ptr failure;             // protected by the pool lock
+
+        uint32 maxHelpers;
+        uint32 attachedHelpers;                 // protected by the pool lock
+
+        RwListEntry <parallelJob> node;
+    };
+
+    void RunJob( parallelJob& job );
+
+    void Participate( parallelJob& job );
+    bool ClaimItem( parallelJob& job, uint32 ownRange, uint32& itemIndexOut );
+
+    void EnsureWorkers( uint32 workerCount );
+    void StopWorkers( void );
+
+    static void __cdecl _WorkerThreadMain( thread_t threadHandle, Interface *engineInterface, void *ud );
+
+    EngineInterface *engineInterface;
+
+    rwlock *poolLock;
+    rwcond *workAvailableCond;      // signaled when a job with unclaimed items is added
+    rwcond *jobFinishedCond;        // signaled when the last item of a job finished or a helper detached
+
+    bool isTerminating;
+
+    std::vector <thread_t> workers;
+
+    RwList <parallelJob> activeJobs;
+};
+
+typedef PluginDependantStructRegister <threadPoolEnv, RwInterfaceFactory_t> threadPoolEnvRegister_t;
+
+extern threadPoolEnvRegister_t threadPoolEnvRegister;
+
+// Returns the amount of threads (including the calling one) that parallel work is split across.
+// This is taken from the configuration of the calling thread.
+uint32 GetParallelConcurrency( EngineInterface *engineInterface );
+
+// Calls the callback for every item index in [0, itemCount), using up to maxConcurrency threads.
+// Returns when every item has been processed. If an item threw an exception, the remaining items
+// are skipped and the first exception is rethrown on the calling thread.
+// Since items may run on pool threads they must not depend on per-thread configuration.
+void ParallelForEx( EngineInterface *engineInterface, uint32 itemCount, uint32 maxConcurrency, parallelTaskCallback_t callback, void *ud );
+
+template <typename callbackType>
+inline void ParallelFor( EngineInterface *engineInterface, uint32 itemCount, uint32 maxConcurrency, callbackType& cb )
+{
+    struct helper
+    {
+        static void call( void *ud, uint32 itemIndex )
+        {
+            ( *(callbackType*)ud )( itemIndex );
+        }
+    };
+
+    ParallelForEx( engineInterface, itemCount, maxConcurrency, helper::call, &cb );
+}
+
+// Private API.
+void ShutdownThreadPool( EngineInterface *engineInterface );
+
+};
+
+#endif //_RENDERWARE_THREAD_POOL_
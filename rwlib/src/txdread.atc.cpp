@@ -234,56 +234,23 @@ void atcNativeTextureTypeProvider::DeserializeTexture( TextureBase *theTexture,
     engineInterface->DeserializeExtensions( theTexture, inputProvider );
 }
 
-inline CMP_FORMAT getAMDTCFormatFromInternalFormat( eATCInternalFormat internalFormat )
-{
-    CMP_FORMAT actualFormat;
-
-    if ( internalFormat == ATC_RGB_AMD )
-    {
-        actualFormat = CMP_FORMAT_ATC_RGB;
-    }
-    else if ( internalFormat == ATC_RGBA_EXPLICIT_ALPHA_AMD )
-    {
-        actualFormat = CMP_FORMAT_ATC_RGBA_Explicit;
-    }
-    else if ( internalFormat == ATC_RGBA_INTERPOLATED_ALPHA_AMD )
-    {
-        actualFormat = CMP_FORMAT_ATC_RGBA_Interpolated;
-    }
-    else
-    {
-        assert( 0 );
-    }
-
-    return actualFormat;
-}
-
-inline void getAMDTCFormatTargetParams(
-    eATCInternalFormat internalFormat,CMP_FORMAT& requiredOutputCodec,
-    eRasterFormat& outputCodecRasterFormat, uint32& outputCodecDepth, eColorOrdering& outputCodecColorOrder
+// Format of the texels that the ATC codec reads and writes.
+inline void getATCCodecRasterFormat(
+    eATCInternalFormat internalFormat,
+    eRasterFormat& codecRasterFormat, uint32& codecDepth, eColorOrdering& codecColorOrder
 )
 {
     if ( internalFormat == ATC_RGB_AMD )
     {
-        requiredOutputCodec = CMP_FORMAT_ARGB_8888;
-
-        outputCodecRasterFormat = RASTER_888;
-        outputCodecDepth = 32;
-        outputCodecColorOrder = COLOR_BGRA;
-    }
-    else if ( internalFormat == ATC_RGBA_EXPLICIT_ALPHA_AMD ||
-              internalFormat == ATC_RGBA_INTERPOLATED_ALPHA_AMD )
-    {
-        requiredOutputCodec = CMP_FORMAT_ARGB_8888;
-
-        outputCodecRasterFormat = RASTER_8888;
-        outputCodecDepth = 32;
-        outputCodecColorOrder = COLOR_BGRA;
+        codecRasterFormat = RASTER_888;
     }
     else
     {
-        assert( 0 );
+        codecRasterFormat = RASTER_8888;
     }
+
+    codecDepth = 32;
+    codecColorOrder = COLOR_RGBA;
 }
 
 // Pixel API.
@@ -292,63 +259,45 @@ inline void DecompressATCMipmap(
     uint32 mipWidth, uint32 mipHeight, uint32 layerWidth, uint32 layerHeight, const void *srcTexels, uint32 srcDataSize,
     eRasterFormat atcRasterFormat, uint32 atcDepth, eColorOrdering atcColorOrder,
     eRasterFormat targetRasterFormat, uint32 targetDepth, uint32 targetRowAlignment, eColorOrdering targetColorOrder,
-    CMP_FORMAT srcRasterATITCFormat, CMP_FORMAT dstRasterATITCFormat,
+    eATCInternalFormat internalFormat,
     void*& dstTexelsOut, uint32& dstDataSizeOut
 )
 {
-    CMP_Texture srcTexture;
-    srcTexture.dwSize = sizeof( CMP_Texture );
-    srcTexture.dwWidth = mipWidth;
-    srcTexture.dwHeight = mipHeight;
-    srcTexture.dwPitch = 0;
-    srcTexture.format = srcRasterATITCFormat;
-    srcTexture.dwDataSize = srcDataSize;
-    srcTexture.pData = (CMP_BYTE*)srcTexels;
-
-    CMP_Texture dstTexture;
-    dstTexture.dwSize = sizeof( CMP_Texture );
-    dstTexture.dwWidth = mipWidth;
-    dstTexture.dwHeight = mipHeight;
-    dstTexture.dwPitch = 0;
-    dstTexture.format = dstRasterATITCFormat;
-    dstTexture.dwDataSize = CMP_CalculateBufferSize( &dstTexture );
-
-    void *atcTexels = engineInterface->PixelAllocate( dstTexture.dwDataSize );
-
-    dstTexture.pData = (CMP_BYTE*)atcTexels;
-
-    if ( !dstTexture.pData )
+    uint32 atcRowAlignment = getATCToolTextureDataRowAlignment();
+
+    uint32 atcRowSize = getRasterDataRowSize( mipWidth, atcDepth, atcRowAlignment );
+
+    uint32 atcDataSize = getRasterDataSizeByRowSize( atcRowSize, mipHeight );
+
+    void *atcTexels = engineInterface->PixelAllocate( atcDataSize );
+
+    if ( !atcTexels )
     {
-        throw RwException( "failed to allocate decompression surface buffer for AMDCompress decompression task" );
+        throw RwException( "failed to allocate decompression surface buffer for ATC decompression task" );
     }
 
     void *dstTexels = atcTexels;
-    uint32 dstDataSize = dstTexture.dwDataSize;
+    uint32 dstDataSize = atcDataSize;
 
     try
     {
         // Decompress, wazaaa!
-        CMP_ERROR atcErrorCode = CMP_ConvertTexture( &srcTexture, &dstTexture, NULL, NULL, NULL, NULL );
-
-        if ( atcErrorCode != CMP_OK )
-        {
-            throw RwException( "failed to decompress AMDCompress native texture surface data" );
-        }
+        atitc::DecompressSurface(
+            (EngineInterface*)engineInterface, internalFormat,
+            mipWidth, mipHeight, srcTexels,
+            atcTexels, atcRowSize
+        );
 
         // Put the texels into a format we want.
-        uint32 atcRowAlignment = getATCToolTextureDataRowAlignment();
-
         bool needsNewBuffer = shouldAllocateNewRasterBuffer( mipWidth, atcDepth, atcRowAlignment, targetDepth, targetRowAlignment );
 
         if ( atcRasterFormat != targetRasterFormat || mipWidth != layerWidth || mipHeight != layerHeight || needsNewBuffer || atcColorOrder != targetColorOrder )
         {
-            uint32 atcRowSize = getRasterDataRowSize( mipWidth, atcDepth, atcRowAlignment );
-
             uint32 dstRowSize = getRasterDataRowSize( layerWidth, targetDepth, targetRowAlignment );
 
             if ( mipWidth != layerWidth || mipHeight != layerHeight || needsNewBuffer )
             {
-                dstDataSize = getRasterDataSizeByRowSize( dstRowSize, mipHeight );
+                dstDataSize = getRasterDataSizeByRowSize( dstRowSize, layerHeight );
 
                 dstTexels = engineInterface->PixelAllocate( dstDataSize );
             }
@@ -412,17 +361,12 @@ void atcNativeTextureTypeProvider::GetPixelDataFromTexture( Interface *engineInt
 
     pixelsOut.mipmaps.resize( mipmapCount );
 
-    // Calculate the properties of the ATI TC source and destination textures.
-    CMP_FORMAT srcRasterATITCFormat = getAMDTCFormatFromInternalFormat( internalFormat );
+    // Fetch format properties of the decompression destination surface.
+    eRasterFormat atcRasterFormat;
+    uint32 atcDepth;
+    eColorOrdering atcColorOrder;
 
-    // Fetch format properties that are required as decompression destination surface.
-    eRasterFormat atcRasterFormat = RASTER_8888;
-    uint32 atcDepth = 32;
-    eColorOrdering atcColorOrder = COLOR_RGBA;
-
-    CMP_FORMAT dstRasterATITCFormat;
-
-    getAMDTCFormatTargetParams( internalFormat, dstRasterATITCFormat, atcRasterFormat, atcDepth, atcColorOrder );
+    getATCCodecRasterFormat( internalFormat, atcRasterFormat, atcDepth, atcColorOrder );
 
     for ( uint32 n = 0; n < mipmapCount; n++ )
     {
@@ -453,7 +397,7 @@ void atcNativeTextureTypeProvider::GetPixelDataFromTexture( Interface *engineInt
             mipWidth, mipHeight, layerWidth, layerHeight, mipLayer.texels, mipLayer.dataSize,
             atcRasterFormat, atcDepth, atcColorOrder,
             targetRasterFormat, targetDepth, targetRowAlignment, targetColorOrder,
-            srcRasterATITCFormat, dstRasterATITCFormat,
+            internalFormat,
             mipTexels, texDataSize
         );
 
@@ -490,14 +434,14 @@ inline void CompressMipmapToATC(
     eRasterFormat srcRasterFormat, uint32 srcDepth, uint32 srcRowAlignment, eColorOrdering srcColorOrder, ePaletteType srcPaletteType, const void *srcPaletteData, uint32 srcPaletteSize,
     eRasterFormat feedRasterFormat, uint32 feedDepth, eColorOrdering feedColorOrder,
     uint32 compressionBlockSize,
-    CMP_FORMAT srcTextureFormat, CMP_FORMAT dstTextureFormat,
+    eATCInternalFormat internalFormat,
     uint32& dstWidthOut, uint32& dstHeightOut,
     void*& dstTexelsOut, uint32& dstDataSizeOut
 )
 {
     uint32 srcLayerRowSize = getRasterDataRowSize( mipWidth, srcDepth, srcRowAlignment );
 
-    // Put this mipmap in a ATI_Compress compatible texture.
+    // Put this mipmap into a surface that the ATC codec can read.
     uint32 feedLayerTexRowSize = getRasterDataRowSize( mipWidth, feedDepth, getATCToolTextureDataRowAlignment() );
 
     uint32 feedTextureDataSize = getRasterDataSizeByRowSize( feedLayerTexRowSize, mipHeight );
@@ -547,32 +491,11 @@ inline void CompressMipmapToATC(
         {
             // Compress the texture now.
             {
-                CMP_Texture srcTexture;
-                srcTexture.dwSize = sizeof( srcTexture );
-                srcTexture.dwWidth = mipWidth;
-                srcTexture.dwHeight = mipHeight;
-                srcTexture.dwPitch = 0;
-                srcTexture.format = srcTextureFormat;
-                srcTexture.dwDataSize = feedTextureDataSize;
-                srcTexture.pData = (CMP_BYTE*)feedTexels;
-
-                CMP_Texture dstTexture;
-                dstTexture.dwSize = sizeof( dstTexture );
-                dstTexture.dwWidth = mipWidth;
-                dstTexture.dwHeight = mipHeight;
-                dstTexture.dwPitch = 0;
-                dstTexture.format = dstTextureFormat;
-                dstTexture.dwDataSize = dstDataSize;
-                dstTexture.pData = (CMP_BYTE*)dstTexels;
-
-                // Do the conversion.
-                CMP_ERROR atcErrorCode =
-                    CMP_ConvertTexture( &srcTexture, &dstTexture, NULL, NULL, NULL, NULL );
-
-                if ( atcErrorCode != CMP_OK )
-                {
-                    throw RwException( "unknown error in ATC mipmap encoding" );
-                }
+                atitc::CompressSurface(
+                    (EngineInterface*)engineInterface, internalFormat,
+                    mipWidth, mipHeight, feedTexels, feedLayerTexRowSize,
+                    dstTexels
+                );
 
                 // Return stuff.
                 outWidth = compressWidth;
@@ -654,15 +577,11 @@ void atcNativeTextureTypeProvider::SetPixelDataToTexture( Interface *engineInter
     // Do it.
     {
         // Get the format that we will output the feed-in texture as.
-        eRasterFormat feedRasterFormat = RASTER_8888;
-        uint32 feedDepth = 32;
-        eColorOrdering feedColorOrder = COLOR_BGRA;
-
-        CMP_FORMAT srcTextureFormat;
+        eRasterFormat feedRasterFormat;
+        uint32 feedDepth;
+        eColorOrdering feedColorOrder;
 
-        getAMDTCFormatTargetParams( internalFormat, srcTextureFormat, feedRasterFormat, feedDepth, feedColorOrder );
-
-        CMP_FORMAT dstTextureFormat = getAMDTCFormatFromInternalFormat( internalFormat );
+        getATCCodecRasterFormat( internalFormat, feedRasterFormat, feedDepth, feedColorOrder );
 
         uint32 compressionBlockSize = getATCCompressionBlockSize( internalFormat );
 
@@ -693,7 +612,7 @@ void atcNativeTextureTypeProvider::SetPixelDataToTexture( Interface *engineInter
                 srcRasterFormat, srcDepth, srcRowAlignment, srcColorOrder, srcPaletteType, srcPaletteData, srcPaletteSize,
                 feedRasterFormat, feedDepth, feedColorOrder,
                 compressionBlockSize,
-                srcTextureFormat, dstTextureFormat,
+                internalFormat,
                 compressWidth, compressHeight,
                 dstTexels, dstDataSize
             );
@@ -802,11 +721,7 @@ struct atcMipmapManager
         uint32 atcDepth;
         eColorOrdering atcColorOrder;
 
-        CMP_FORMAT dstRasterATITCFormat;
-
-        getAMDTCFormatTargetParams( internalFormat, dstRasterATITCFormat, atcRasterFormat, atcDepth, atcColorOrder );
-
-        CMP_FORMAT srcRasterATITCFormat = getAMDTCFormatFromInternalFormat( internalFormat );
+        getATCCodecRasterFormat( internalFormat, atcRasterFormat, atcDepth, atcColorOrder );
 
         // Perform it.
         void *dstTexels = NULL;
@@ -817,7 +732,7 @@ struct atcMipmapManager
             mipWidth, mipHeight, layerWidth, layerHeight, srcTexels, srcDataSize,
             atcRasterFormat, atcDepth, atcColorOrder,
             targetRasterFormat, targetDepth, targetRowAlignment, targetColorOrder,
-            srcRasterATITCFormat, dstRasterATITCFormat,
+            internalFormat,
             dstTexels, dstDataSize
         );
 
@@ -905,15 +820,11 @@ struct atcMipmapManager
         }
 
         // Get the format that we will output the feed-in texture as.
-        eRasterFormat feedRasterFormat = RASTER_8888;
-        uint32 feedDepth = 32;
-        eColorOrdering feedColorOrder = COLOR_BGRA;
+        eRasterFormat feedRasterFormat;
+        uint32 feedDepth;
+        eColorOrdering feedColorOrder;
 
-        CMP_FORMAT srcTextureFormat;
-
-        getAMDTCFormatTargetParams( internalFormat, srcTextureFormat, feedRasterFormat, feedDepth, feedColorOrder );
-
-        CMP_FORMAT dstTextureFormat = getAMDTCFormatFromInternalFormat( internalFormat );
+        getATCCodecRasterFormat( internalFormat, feedRasterFormat, feedDepth, feedColorOrder );
 
         uint32 compressionBlockSize = getATCCompressionBlockSize( internalFormat );
 
@@ -929,7 +840,7 @@ struct atcMipmapManager
             rasterFormat, depth, rowAlignment, colorOrder, paletteType, paletteData, paletteSize,
             feedRasterFormat, feedDepth, feedColorOrder,
             compressionBlockSize,
-            srcTextureFormat, dstTextureFormat,
+            internalFormat,
             compressedWidth, compressedHeight,
             dstTexels, dstDataSize
         );
@@ -1046,6 +957,27 @@ void registerATCNativePlugin( void )
     atcNativeTexturePluginStore.RegisterPlugin( engineFactory );
 }
 
+bool atcNativeTextureTypeProvider::DeserializeTextureProperties( TextureBase *theTexture, BlockProvider& inputProvider ) const
+{
+    return readTextureNativeStructHeader <amdtc::textureNativeGenericHeader> ( inputProvider,
+        [&]( const amdtc::textureNativeGenericHeader& metaHeader )
+        {
+            if ( metaHeader.platformDescriptor != PLATFORM_ATC )
+            {
+                return false;
+            }
+
+            readTextureNativeNames( *theTexture, metaHeader.name, metaHeader.maskName );
+
+            metaHeader.formatInfo.parse( *theTexture );
+
+            theTexture->SetFilterMode( getFixedFilteringMode( theTexture->GetFilterMode(), metaHeader.mipmapCount ) );
+
+            return true;
+        }
+    );
+}
+
 };
 
 #endif //RWLIB_INCLUDE_NATIVETEX_ATC_MOBILE
\ No newline at end of file
@@ -6,10 +6,7 @@
 
 #include "txdread.common.hxx"
 
-// AMDCompress does include windows.h
-#define WIN32_LEAN_AND_MEAN
-#define NOMINMAX
-#include <Compressonator.h>
+#include "txdread.atitc.hxx"
 
 #define PLATFORM_ATC    11
 
@@ -30,33 +27,6 @@ inline uint32 getATCExportTextureDataRowAlignment( void )
     return 4;
 }
 
-enum eATCInternalFormat
-{
-    ATC_RGB_AMD = 0x8C92,
-    ATC_RGBA_EXPLICIT_ALPHA_AMD = 0x8C93,
-    ATC_RGBA_INTERPOLATED_ALPHA_AMD = 0x87EE
-};
-
-inline uint32 getATCCompressionBlockSize( eATCInternalFormat internalFormat )
-{
-    uint32 theSize = 0;
-
-    if ( internalFormat == ATC_RGB_AMD )
-    {
-        theSize = 8;
-    }
-    else if ( internalFormat == ATC_RGBA_EXPLICIT_ALPHA_AMD )
-    {
-        theSize = 16;
-    }
-    else if ( internalFormat == ATC_RGBA_INTERPOLATED_ALPHA_AMD )
-    {
-        theSize = 16;
-    }
-
-    return theSize;
-}
-
 inline void getATCMipmapSizeRules( nativeTextureSizeRules& rulesOut )
 {
     rulesOut.powerOfTwo = false;
@@ -147,6 +117,8 @@ struct atcNativeTextureTypeProvider : public texNativeTypeProvider
     void SerializeTexture( TextureBase *theTexture, PlatformTexture *nativeTex, BlockProvider& outputProvider ) const;
     void DeserializeTexture( TextureBase *theTexture, PlatformTexture *nativeTex, BlockProvider& inputProvider ) const;
 
+    bool DeserializeTextureProperties( TextureBase *theTexture, BlockProvider& inputProvider ) const;
+
     void GetPixelCapabilities( pixelCapabilities& capsOut ) const override
     {
         capsOut.supportsDXT1 = false;
@@ -0,0 +1,900 @@
+#include "StdInc.h"
+
+#ifdef RWLIB_INCLUDE_NATIVETEX_ATC_MOBILE
+
+#include <cfloat>
+
+#include "txdread.atitc.hxx"
+
+#include "txdread.d3d.dxt.hxx"
+
+#include "rwsimd.hxx"
+
+// ATC blocks are laid out like DXT blocks: ATC RGB is a DXT1 block, explicit alpha puts a DXT3 alpha
+// list in front of it and interpolated alpha a DXT5 alpha ramp. The difference is in the color part:
+// the first color is stored as RGB555 with a mode bit on top, and the palette is either
+// { c0, 5/8 c0 + 3/8 c1, 3/8 c0 + 5/8 c1, c1 } or, with the mode bit set, { 0, c0 - c1 / 4, c0, c1 }.
+
+namespace rw
+{
+
+namespace atitc
+{
+
+typedef dxt1_block <endian::little_endian> atcColorBlock;
+typedef dxt2_3_block <endian::little_endian> atcExplicitAlphaBlock;
+typedef dxt4_5_block <endian::little_endian> atcInterpolatedAlphaBlock;
+
+static const uint32 ATC_ALTERNATE_MODE_BIT = 0x8000;
+
+AINLINE uint32 expand5( uint32 val )
+{
+    return ( ( val << 3 ) | ( val >> 2 ) );
+}
+
+AINLINE uint32 expand6( uint32 val )
+{
+    return ( ( val << 2 ) | ( val >> 4 ) );
+}
+
+// Calculates the four RGB colors that the indices of a color block select from.
+AINLINE void buildColorPalette( uint32 color0, uint32 color1, int32 paletteOut[4][3] )
+{
+    int32 low[3] =
+    {
+        (int32)expand5( ( color0 >> 10 ) & 0x1F ),
+        (int32)expand5( ( color0 >> 5 ) & 0x1F ),
+        (int32)expand5( color0 & 0x1F )
+    };
+
+    int32 high[3] =
+    {
+        (int32)expand5( ( color1 >> 11 ) & 0x1F ),
+        (int32)expand6( ( color1 >> 5 ) & 0x3F ),
+        (int32)expand5( color1 & 0x1F )
+    };
+
+    bool isAlternateMode = ( ( color0 & ATC_ALTERNATE_MODE_BIT ) != 0 );
+
+    for ( uint32 ch = 0; ch < 3; ch++ )
+    {
+        if ( isAlternateMode )
+        {
+            paletteOut[0][ch] = 0;
+            paletteOut[1][ch] = std::max( 0, low[ch] - ( high[ch] >> 2 ) );
+            paletteOut[2][ch] = low[ch];
+            paletteOut[3][ch] = high[ch];
+        }
+        else
+        {
+            paletteOut[0][ch] = low[ch];
+            paletteOut[1][ch] = ( 5 * low[ch] + 3 * high[ch] ) >> 3;
+            paletteOut[2][ch] = ( 3 * low[ch] + 5 * high[ch] ) >> 3;
+            paletteOut[3][ch] = high[ch];
+        }
+    }
+}
+
+// Interpolated alpha uses the rounding DXT5 ramp.
+AINLINE void buildAlphaRamp( uint32 alpha0, uint32 alpha1, uint8 rampOut[8] )
+{
+    rampOut[0] = (uint8)alpha0;
+    rampOut[1] = (uint8)alpha1;
+
+    if ( alpha0 > alpha1 )
+    {
+        for ( uint32 n = 0; n < 6; n++ )
+        {
+            rampOut[ n + 2 ] = (uint8)( ( ( 6 - n ) * alpha0 + ( n + 1 ) * alpha1 + 3 ) / 7 );
+        }
+    }
+    else
+    {
+        for ( uint32 n = 0; n < 4; n++ )
+        {
+            rampOut[ n + 2 ] = (uint8)( ( ( 4 - n ) * alpha0 + ( n + 1 ) * alpha1 + 2 ) / 5 );
+        }
+
+        rampOut[6] = 0;
+        rampOut[7] = 255;
+    }
+}
+
+AINLINE uint64 loadAlphaIndices( const uint48_t& indices )
+{
+    uint64 result = 0;
+
+    for ( uint32 n = 0; n < 6; n++ )
+    {
+        result |= ( (uint64)(uint8)indices.data[n] << ( n * 8 ) );
+    }
+
+    return result;
+}
+
+AINLINE uint48_t storeAlphaIndices( uint64 indices )
+{
+    uint48_t result;
+
+    for ( uint32 n = 0; n < 6; n++ )
+    {
+        result.data[n] = (char)(uint8)( indices >> ( n * 8 ) );
+    }
+
+    return result;
+}
+
+// All ATC block types keep their color part in the col0, col1 and indexList fields.
+template <typename blockType>
+AINLINE void decodeColorPart( const blockType& block, uint8 texelsOut[16][4] )
+{
+    rgb565 color0 = block.col0;
+    rgb565 color1 = block.col1;
+
+    int32 palette[4][3];
+
+    buildColorPalette( color0.val, color1.val, palette );
+
+    uint32 indexList = block.indexList;
+
+    for ( uint32 n = 0; n < 16; n++ )
+    {
+        const int32 *entry = palette[ ( indexList >> ( n * 2 ) ) & 3 ];
+
+        texelsOut[n][0] = (uint8)entry[0];
+        texelsOut[n][1] = (uint8)entry[1];
+        texelsOut[n][2] = (uint8)entry[2];
+    }
+}
+
+AINLINE void decodeBlock( eATCInternalFormat internalFormat, const void *blockData, uint8 texelsOut[16][4] )
+{
+    if ( internalFormat == ATC_RGB_AMD )
+    {
+        decodeColorPart( *(const atcColorBlock*)blockData, texelsOut );
+
+        for ( uint32 n = 0; n < 16; n++ )
+        {
+            texelsOut[n][3] = 255;
+        }
+    }
+    else if ( internalFormat == ATC_RGBA_EXPLICIT_ALPHA_AMD )
+    {
+        const atcExplicitAlphaBlock& block = *(const atcExplicitAlphaBlock*)blockData;
+
+        decodeColorPart( block, texelsOut );
+
+        uint64 alphaList = block.alphaList;
+
+        for ( uint32 n = 0; n < 16; n++ )
+        {
+            texelsOut[n][3] = (uint8)( ( ( alphaList >> ( n * 4 ) ) & 0xF ) * 17 );
+        }
+    }
+    else
+    {
+        const atcInterpolatedAlphaBlock& block = *(const atcInterpolatedAlphaBlock*)blockData;
+
+        decodeColorPart( block, texelsOut );
+
+        uint8 ramp[8];
+
+        buildAlphaRamp( block.alphaPreMult[0], block.alphaPreMult[1], ramp );
+
+        uint64 alphaIndices = loadAlphaIndices( block.alphaList );
+
+        for ( uint32 n = 0; n < 16; n++ )
+        {
+            texelsOut[n][3] = ramp[ ( alphaIndices >> ( n * 3 ) ) & 7 ];
+        }
+    }
+}
+
+void DecompressSurface(
+    EngineInterface *engineInterface, eATCInternalFormat internalFormat,
+    uint32 surfWidth, uint32 surfHeight, const void *srcBlocks,
+    void *dstTexels, uint32 dstRowSize
+)
+{
+    uint32 blockSize = getATCCompressionBlockSize( internalFormat );
+
+    if ( blockSize == 0 )
+    {
+        throw RwException( "invalid ATC internal format in decompression" );
+    }
+
+    if ( ( surfWidth % 4 ) != 0 || ( surfHeight % 4 ) != 0 )
+    {
+        throw RwException( "invalid ATC surface dimensions in decompression" );
+    }
+
+    uint32 blocksWidth = ( surfWidth / 4 );
+    uint32 blocksHeight = ( surfHeight / 4 );
+
+    auto decodeRow = [&]( uint32 by )
+    {
+        const uint8 *blockData = (const uint8*)srcBlocks + (size_t)by * blocksWidth * blockSize;
+
+        uint8 *dstRows[4];
+
+        for ( uint32 row = 0; row < 4; row++ )
+        {
+            dstRows[row] = (uint8*)dstTexels + (size_t)( by * 4 + row ) * dstRowSize;
+        }
+
+        for ( uint32 bx = 0; bx < blocksWidth; bx++ )
+        {
+            uint8 texels[16][4];
+
+            decodeBlock( internalFormat, blockData, texels );
+
+            for ( uint32 row = 0; row < 4; row++ )
+            {
+                memcpy( dstRows[row] + bx * 16, texels[ row * 4 ], 16 );
+            }
+
+            blockData += blockSize;
+        }
+    };
+
+    ParallelFor( engineInterface, blocksHeight, GetParallelConcurrency( engineInterface ), decodeRow );
+}
+
+// *** Encoder.
+
+// The texels of one block, split into channels so that four texels fit into a vector.
+struct colorBlockTexels
+{
+    float red[16];
+    float green[16];
+    float blue[16];
+};
+
+// Endpoints in their stored precision: RGB555 for the first and RGB565 for the second color.
+struct colorEndpoints
+{
+    int32 values[6];
+    bool isAlternateMode;
+
+    inline uint32 getColor0( void ) const
+    {
+        uint32 color = ( ( values[0] << 10 ) | ( values[1] << 5 ) | values[2] );
+
+        if ( isAlternateMode )
+        {
+            color |= ATC_ALTERNATE_MODE_BIT;
+        }
+
+        return color;
+    }
+
+    inline uint32 getColor1( void ) const
+    {
+        return ( ( values[3] << 11 ) | ( values[4] << 5 ) | values[5] );
+    }
+};
+
+static const int32 endpointMaximums[6] = { 31, 31, 31, 31, 63, 31 };
+
+AINLINE int32 quantizeChannel( float val, int32 maxVal )
+{
+    int32 quantized = (int32)( val * maxVal / 255.0f + 0.5f );
+
+    return std::min( std::max( quantized, 0 ), maxVal );
+}
+
+AINLINE void setEndpoints( colorEndpoints& endpoints, const float color0[3], const float color1[3], bool isAlternateMode )
+{
+    for ( uint32 ch = 0; ch < 3; ch++ )
+    {
+        endpoints.values[ ch ] = quantizeChannel( color0[ch], endpointMaximums[ ch ] );
+        endpoints.values[ ch + 3 ] = quantizeChannel( color1[ch], endpointMaximums[ ch + 3 ] );
+    }
+
+    endpoints.isAlternateMode = isAlternateMode;
+}
+
+// Picks the closest palette entry for every texel and returns the summed squared error.
+// All distances are whole numbers well below 2^24, so the vector and scalar paths agree exactly.
+static float evaluateEndpoints( const colorBlockTexels& texels, const colorEndpoints& endpoints, uint32 *indexListOut )
+{
+    int32 palette[4][3];
+
+    buildColorPalette( endpoints.getColor0(), endpoints.getColor1(), palette );
+
+    uint32 indexList = 0;
+
+#ifdef RWLIB_ENABLE_X86_SIMD
+    __m128 paletteRed[4], paletteGreen[4], paletteBlue[4];
+
+    for ( uint32 p = 0; p < 4; p++ )
+    {
+        paletteRed[p] = _mm_set1_ps( (float)palette[p][0] );
+        paletteGreen[p] = _mm_set1_ps( (float)palette[p][1] );
+        paletteBlue[p] = _mm_set1_ps( (float)palette[p][2] );
+    }
+
+    __m128 totalError = _mm_setzero_ps();
+
+    for ( uint32 n = 0; n < 16; n += 4 )
+    {
+        __m128 red = _mm_loadu_ps( texels.red + n );
+        __m128 green = _mm_loadu_ps( texels.green + n );
+        __m128 blue = _mm_loadu_ps( texels.blue + n );
+
+        __m128 bestError = _mm_set1_ps( FLT_MAX );
+        __m128i bestIndex = _mm_setzero_si128();
+
+        for ( uint32 p = 0; p < 4; p++ )
+        {
+            __m128 diffRed = _mm_sub_ps( red, paletteRed[p] );
+            __m128 diffGreen = _mm_sub_ps( green, paletteGreen[p] );
+            __m128 diffBlue = _mm_sub_ps( blue, paletteBlue[p] );
+
+            __m128 error =
+                _mm_add_ps(
+                    _mm_add_ps( _mm_mul_ps( diffRed, diffRed ), _mm_mul_ps( diffGreen, diffGreen ) ),
+                    _mm_mul_ps( diffBlue, diffBlue )
+                );
+
+            __m128i isBetter = _mm_castps_si128( _mm_cmplt_ps( error, bestError ) );
+
+            bestError = _mm_min_ps( error, bestError );
+            bestIndex = _mm_or_si128( _mm_andnot_si128( isBetter, bestIndex ), _mm_and_si128( isBetter, _mm_set1_epi32( (int)p ) ) );
+        }
+
+        totalError = _mm_add_ps( totalError, bestError );
+
+        if ( indexListOut )
+        {
+            int32 indices[4];
+
+            _mm_storeu_si128( (__m128i*)indices, bestIndex );
+
+            for ( uint32 k = 0; k < 4; k++ )
+            {
+                indexList |= ( (uint32)indices[k] << ( ( n + k ) * 2 ) );
+            }
+        }
+    }
+
+    float errors[4];
+
+    _mm_storeu_ps( errors, totalError );
+
+    float errorSum = ( ( errors[0] + errors[1] ) + ( errors[2] + errors[3] ) );
+#else
+    float errorSum = 0;
+
+    for ( uint32 n = 0; n < 16; n++ )
+    {
+        float bestError = FLT_MAX;
+        uint32 bestIndex = 0;
+
+        for ( uint32 p = 0; p < 4; p++ )
+        {
+            float diffRed = ( texels.red[n] - (float)palette[p][0] );
+            float diffGreen = ( texels.green[n] - (float)palette[p][1] );
+            float diffBlue = ( texels.blue[n] - (float)palette[p][2] );
+
+            float error = ( diffRed * diffRed + diffGreen * diffGreen + diffBlue * diffBlue );
+
+            if ( error < bestError )
+            {
+                bestError = error;
+                bestIndex = p;
+            }
+        }
+
+        errorSum += bestError;
+
+        indexList |= ( bestIndex << ( n * 2 ) );
+    }
+#endif //RWLIB_ENABLE_X86_SIMD
+
+    if ( indexListOut )
+    {
+        *indexListOut = indexList;
+    }
+
+    return errorSum;
+}
+
+// Initial endpoints at both ends of the principal axis of the block colors.
+static void findPrincipalEndpoints( const colorBlockTexels& texels, float lowOut[3], float highOut[3] )
+{
+    float mean[3] = { 0, 0, 0 };
+
+    for ( uint32 n = 0; n < 16; n++ )
+    {
+        mean[0] += texels.red[n];
+        mean[1] += texels.green[n];
+        mean[2] += texels.blue[n];
+    }
+
+    for ( uint32 ch = 0; ch < 3; ch++ )
+    {
+        mean[ch] /= 16.0f;
+    }
+
+    float cov[6] = { 0, 0, 0, 0, 0, 0 };
+
+    for ( uint32 n = 0; n < 16; n++ )
+    {
+        float r = ( texels.red[n] - mean[0] );
+        float g = ( texels.green[n] - mean[1] );
+        float b = ( texels.blue[n] - mean[2] );
+
+        cov[0] += r * r;
+        cov[1] += r * g;
+        cov[2] += r * b;
+        cov[3] += g * g;
+        cov[4] += g * b;
+        cov[5] += b * b;
+    }
+
+    // Power iteration, starting from the channel with the biggest spread.
+    float axis[3] = { cov[0], cov[3], cov[5] };
+
+    for ( uint32 iter = 0; iter < 6; iter++ )
+    {
+        float x = ( cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2] );
+        float y = ( cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2] );
+        float z = ( cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2] );
+
+        float len = std::max( std::max( fabs( x ), fabs( y ) ), fabs( z ) );
+
+        if ( len < FLT_EPSILON )
+        {
+            break;
+        }
+
+        axis[0] = ( x / len );
+        axis[1] = ( y / len );
+        axis[2] = ( z / len );
+    }
+
+    float axisLenSq = ( axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2] );
+
+    if ( axisLenSq < FLT_EPSILON )
+    {
+        // All texels have the same color.
+        for ( uint32 ch = 0; ch < 3; ch++ )
+        {
+            lowOut[ch] = mean[ch];
+            highOut[ch] = mean[ch];
+        }
+        return;
+    }
+
+    float minProj = FLT_MAX;
+    float maxProj = -FLT_MAX;
+
+    for ( uint32 n = 0; n < 16; n++ )
+    {
+        float proj =
+            ( ( texels.red[n] - mean[0] ) * axis[0] +
+              ( texels.green[n] - mean[1] ) * axis[1] +
+              ( texels.blue[n] - mean[2] ) * axis[2] ) / axisLenSq;
+
+        minProj = std::min( minProj, proj );
+        maxProj = std::max( maxProj, proj );
+    }
+
+    // Pull the ends in a little because the extremes are rarely hit exactly.
+    float inset = ( ( maxProj - minProj ) / 16.0f );
+
+    minProj += inset;
+    maxProj -= inset;
+
+    for ( uint32 ch = 0; ch < 3; ch++ )
+    {
+        lowOut[ch] = std::min( std::max( mean[ch] + axis[ch] * minProj, 0.0f ), 255.0f );
+        highOut[ch] = std::min( std::max( mean[ch] + axis[ch] * maxProj, 0.0f ), 255.0f );
+    }
+}
+
+// Least-squares fit of both endpoints to the current palette assignment (standard mode only).
+static bool refineEndpoints( const colorBlockTexels& texels, uint32 indexList, colorEndpoints& endpoints )
+{
+    static const float indexWeights[4] = { 0.0f, 3.0f / 8.0f, 5.0f / 8.0f, 1.0f };
+
+    float aa = 0, ab = 0, bb = 0;
+    float ax[3] = { 0, 0, 0 };
+    float bx[3] = { 0, 0, 0 };
+
+    for ( uint32 n = 0; n < 16; n++ )
+    {
+        float w = indexWeights[ ( indexList >> ( n * 2 ) ) & 3 ];
+        float iw = ( 1.0f - w );
+
+        aa += iw * iw;
+        ab += iw * w;
+        bb += w * w;
+
+        ax[0] += iw * texels.red[n];
+        ax[1] += iw * texels.green[n];
+        ax[2] += iw * texels.blue[n];
+
+        bx[0] += w * texels.red[n];
+        bx[1] += w * texels.green[n];
+        bx[2] += w * texels.blue[n];
+    }
+
+    float det = ( aa * bb - ab * ab );
+
+    if ( fabs( det ) < FLT_EPSILON )
+    {
+        return false;
+    }
+
+    float color0[3], color1[3];
+
+    for ( uint32 ch = 0; ch < 3; ch++ )
+    {
+        color0[ch] = ( ( bb * ax[ch] - ab * bx[ch] ) / det );
+        color1[ch] = ( ( aa * bx[ch] - ab * ax[ch] ) / det );
+    }
+
+    setEndpoints( endpoints, color0, color1, false );
+    return true;
+}
+
+// Greedy search over single steps of the stored endpoint channels.
+static float searchEndpoints( const colorBlockTexels& texels, colorEndpoints& endpoints, float bestError )
+{
+    static const uint32 MAX_SEARCH_SWEEPS = 8;
+
+    for ( uint32 sweep = 0; sweep < MAX_SEARCH_SWEEPS && bestError > 0; sweep++ )
+    {
+        bool hasImproved = false;
+
+        for ( uint32 comp = 0; comp < 6; comp++ )
+        {
+            for ( int32 step = -1; step <= 1; step += 2 )
+            {
+                int32 newValue = ( endpoints.values[ comp ] + step );
+
+                if ( newValue < 0 || newValue > endpointMaximums[ comp ] )
+                {
+                    continue;
+                }
+
+                colorEndpoints tryEndpoints = endpoints;
+                tryEndpoints.values[ comp ] = newValue;
+
+                float error = evaluateEndpoints( texels, tryEndpoints, NULL );
+
+                if ( error < bestError )
+                {
+                    bestError = error;
+                    endpoints = tryEndpoints;
+
+                    hasImproved = true;
+                }
+            }
+        }
+
+        if ( !hasImproved )
+        {
+            break;
+        }
+    }
+
+    return bestError;
+}
+
+static const uint32 ENCODER_REFINE_PASSES = 2;
+
+static void encodeColorPart( const colorBlockTexels& texels, uint32& color0Out, uint32& color1Out, uint32& indexListOut )
+{
+    float low[3], high[3];
+
+    findPrincipalEndpoints( texels, low, high );
+
+    // The second color has more precision in green, so try both assignments.
+    colorEndpoints bestEndpoints;
+    setEndpoints( bestEndpoints, low, high, false );
+
+    float bestError = evaluateEndpoints( texels, bestEndpoints, NULL );
+    {
+        colorEndpoints swapped;
+        setEndpoints( swapped, high, low, false );
+
+        float swappedError = evaluateEndpoints( texels, swapped, NULL );
+
+        if ( swappedError < bestError )
+        {
+            bestEndpoints = swapped;
+            bestError = swappedError;
+        }
+    }
+
+    for ( uint32 pass = 0; pass < ENCODER_REFINE_PASSES && bestError > 0; pass++ )
+    {
+        uint32 indexList;
+
+        evaluateEndpoints( texels, bestEndpoints, &indexList );
+
+        colorEndpoints refined = bestEndpoints;
+
+        if ( !refineEndpoints( texels, indexList, refined ) )
+        {
+            break;
+        }
+
+        float refinedError = evaluateEndpoints( texels, refined, NULL );
+
+        if ( refinedError >= bestError )
+        {
+            break;
+        }
+
+        bestEndpoints = refined;
+        bestError = refinedError;
+    }
+
+    bestError = searchEndpoints( texels, bestEndpoints, bestError );
+
+    // Blocks with dark texels might do better with the black entry of the alternate palette.
+    bool hasDarkTexels = false;
+
+    for ( uint32 n = 0; n < 16; n++ )
+    {
+        if ( std::max( std::max( texels.red[n], texels.green[n] ), texels.blue[n] ) < 32.0f )
+        {
+            hasDarkTexels = true;
+            break;
+        }
+    }
+
+    if ( hasDarkTexels && bestError > 0 )
+    {
+        // In the alternate palette the first color sits below the second one.
+        colorEndpoints altEndpoints;
+
+        float altLow[3], altHigh[3];
+
+        for ( uint32 ch = 0; ch < 3; ch++ )
+        {
+            altLow[ch] = std::min( low[ch], high[ch] );
+            altHigh[ch] = std::max( low[ch], high[ch] );
+        }
+
+        setEndpoints( altEndpoints, altLow, altHigh, true );
+
+        float altError = evaluateEndpoints( texels, altEndpoints, NULL );
+
+        altError = searchEndpoints( texels, altEndpoints, altError );
+
+        if ( altError < bestError )
+        {
+            bestEndpoints = altEndpoints;
+            bestError = altError;
+        }
+    }
+
+    color0Out = bestEndpoints.getColor0();
+    color1Out = bestEndpoints.getColor1();
+
+    evaluateEndpoints( texels, bestEndpoints, &indexListOut );
+}
+
+template <typename blockType>
+AINLINE void storeColorPart( blockType& block, const colorBlockTexels& texels )
+{
+    uint32 color0, color1, indexList;
+
+    encodeColorPart( texels, color0, color1, indexList );
+
+    rgb565 packedColor0;
+    packedColor0.val = (unsigned short)color0;
+
+    rgb565 packedColor1;
+    packedColor1.val = (unsigned short)color1;
+
+    block.col0 = packedColor0;
+    block.col1 = packedColor1;
+    block.indexList = indexList;
+}
+
+AINLINE uint32 getAlphaRampError( const uint8 alphas[16], const uint8 ramp[8], uint64 *indicesOut )
+{
+    uint32 errorSum = 0;
+    uint64 indices = 0;
+
+    for ( uint32 n = 0; n < 16; n++ )
+    {
+        uint32 bestError = 0xFFFFFFFF;
+        uint32 bestIndex = 0;
+
+        for ( uint32 k = 0; k < 8; k++ )
+        {
+            int32 diff = ( (int32)alphas[n] - (int32)ramp[k] );
+
+            uint32 error = (uint32)( diff * diff );
+
+            if ( error < bestError )
+            {
+                bestError = error;
+                bestIndex = k;
+            }
+        }
+
+        errorSum += bestError;
+
+        indices |= ( (uint64)bestIndex << ( n * 3 ) );
+    }
+
+    if ( indicesOut )
+    {
+        *indicesOut = indices;
+    }
+
+    return errorSum;
+}
+
+static void encodeInterpolatedAlpha( const uint8 alphas[16], atcInterpolatedAlphaBlock& block )
+{
+    uint32 minAlpha = 255, maxAlpha = 0;
+    uint32 minInner = 255, maxInner = 0;
+
+    for ( uint32 n = 0; n < 16; n++ )
+    {
+        uint32 alpha = alphas[n];
+
+        minAlpha = std::min( minAlpha, alpha );
+        maxAlpha = std::max( maxAlpha, alpha );
+
+        // The six-value ramp has explicit entries for the extremes.
+        if ( alpha != 0 && alpha != 255 )
+        {
+            minInner = std::min( minInner, alpha );
+            maxInner = std::max( maxInner, alpha );
+        }
+    }
+
+    if ( minInner > maxInner )
+    {
+        minInner = maxInner = minAlpha;
+    }
+
+    // Eight-value ramp needs alpha0 > alpha1, the six-value ramp alpha0 <= alpha1.
+    uint8 ramp[8];
+    uint64 indices = 0;
+
+    uint32 alpha0 = maxAlpha;
+    uint32 alpha1 = minAlpha;
+
+    uint32 bestError = 0xFFFFFFFF;
+
+    if ( alpha0 > alpha1 )
+    {
+        buildAlphaRamp( alpha0, alpha1, ramp );
+
+        bestError = getAlphaRampError( alphas, ramp, &indices );
+    }
+
+    if ( bestError != 0 )
+    {
+        uint8 innerRamp[8];
+        uint64 innerIndices;
+
+        buildAlphaRamp( minInner, maxInner, innerRamp );
+
+        uint32 innerError = getAlphaRampError( alphas, innerRamp, &innerIndices );
+
+        if ( innerError < bestError )
+        {
+            alpha0 = minInner;
+            alpha1 = maxInner;
+
+            indices = innerIndices;
+        }
+    }
+
+    block.alphaPreMult[0] = (uint8)alpha0;
+    block.alphaPreMult[1] = (uint8)alpha1;
+    block.alphaList = storeAlphaIndices( indices );
+}
+
+AINLINE void encodeBlock(
+    eATCInternalFormat internalFormat,
+    const void *srcTexels, uint32 srcRowSize, uint32 srcWidth, uint32 srcHeight,
+    uint32 x, uint32 y,
+    void *blockData
+)
+{
+    colorBlockTexels texels;
+    uint8 alphas[16];
+
+    for ( uint32 n = 0; n < 16; n++ )
+    {
+        uint32 srcX = std::min( x + ( n % 4 ), srcWidth - 1 );
+        uint32 srcY = std::min( y + ( n / 4 ), srcHeight - 1 );
+
+        const uint8 *texel = (const uint8*)srcTexels + (size_t)srcY * srcRowSize + srcX * 4;
+
+        texels.red[n] = texel[0];
+        texels.green[n] = texel[1];
+        texels.blue[n] = texel[2];
+
+        alphas[n] = texel[3];
+    }
+
+    if ( internalFormat == ATC_RGB_AMD )
+    {
+        storeColorPart( *(atcColorBlock*)blockData, texels );
+    }
+    else if ( internalFormat == ATC_RGBA_EXPLICIT_ALPHA_AMD )
+    {
+        atcExplicitAlphaBlock& block = *(atcExplicitAlphaBlock*)blockData;
+
+        storeColorPart( block, texels );
+
+        uint64 alphaList = 0;
+
+        for ( uint32 n = 0; n < 16; n++ )
+        {
+            alphaList |= ( (uint64)( ( alphas[n] + 8 ) / 17 ) << ( n * 4 ) );
+        }
+
+        block.alphaList = alphaList;
+    }
+    else
+    {
+        atcInterpolatedAlphaBlock& block = *(atcInterpolatedAlphaBlock*)blockData;
+
+        storeColorPart( block, texels );
+
+        encodeInterpolatedAlpha( alphas, block );
+    }
+}
+
+void CompressSurface(
+    EngineInterface *engineInterface, eATCInternalFormat internalFormat,
+    uint32 srcWidth, uint32 srcHeight, const void *srcTexels, uint32 srcRowSize,
+    void *dstBlocks
+)
+{
+    uint32 blockSize = getATCCompressionBlockSize( internalFormat );
+
+    if ( blockSize == 0 )
+    {
+        throw RwException( "invalid ATC internal format in compression" );
+    }
+
+    if ( srcWidth == 0 || srcHeight == 0 )
+    {
+        return;
+    }
+
+    uint32 blocksWidth = ( ALIGN_SIZE( srcWidth, 4u ) / 4 );
+    uint32 blocksHeight = ( ALIGN_SIZE( srcHeight, 4u ) / 4 );
+
+    // Every block is written to a fixed location, so the result does not depend on the thread count.
+    auto encodeRow = [&]( uint32 by )
+    {
+        uint8 *blockData = (uint8*)dstBlocks + (size_t)by * blocksWidth * blockSize;
+
+        for ( uint32 bx = 0; bx < blocksWidth; bx++ )
+        {
+            encodeBlock(
+                internalFormat,
+                srcTexels, srcRowSize, srcWidth, srcHeight,
+                bx * 4, by * 4,
+                blockData
+            );
+
+            blockData += blockSize;
+        }
+    };
+
+    ParallelFor( engineInterface, blocksHeight, GetParallelConcurrency( engineInterface ), encodeRow );
+}
+
+};
+
+};
+
+#endif //RWLIB_INCLUDE_NATIVETEX_ATC_MOBILE
@@ -0,0 +1,59 @@
+// ATI_TC texture compression (ATC RGB, explicit alpha and interpolated alpha).
+// The blocks share the layout of the DXT1/DXT3/DXT5 blocks, only the color palette is derived differently.
+#ifndef _RENDERWARE_ATITC_CODEC_
+#define _RENDERWARE_ATITC_CODEC_
+
+namespace rw
+{
+
+enum eATCInternalFormat
+{
+    ATC_RGB_AMD = 0x8C92,
+    ATC_RGBA_EXPLICIT_ALPHA_AMD = 0x8C93,
+    ATC_RGBA_INTERPOLATED_ALPHA_AMD = 0x87EE
+};
+
+inline uint32 getATCCompressionBlockSize( eATCInternalFormat internalFormat )
+{
+    uint32 theSize = 0;
+
+    if ( internalFormat == ATC_RGB_AMD )
+    {
+        theSize = 8;
+    }
+    else if ( internalFormat == ATC_RGBA_EXPLICIT_ALPHA_AMD )
+    {
+        theSize = 16;
+    }
+    else if ( internalFormat == ATC_RGBA_INTERPOLATED_ALPHA_AMD )
+    {
+        theSize = 16;
+    }
+
+    return theSize;
+}
+
+namespace atitc
+{
+
+// Decodes an ATC surface into RGBA8888 texels.
+// The surface dimensions have to be a multiple of 4.
+void DecompressSurface(
+    EngineInterface *engineInterface, eATCInternalFormat internalFormat,
+    uint32 surfWidth, uint32 surfHeight, const void *srcBlocks,
+    void *dstTexels, uint32 dstRowSize
+);
+
+// Encodes RGBA8888 texels of any dimensions into an ATC surface of 4x4 blocks.
+// Texels outside of the source are filled by repeating the border texels.
+void CompressSurface(
+    EngineInterface *engineInterface, eATCInternalFormat internalFormat,
+    uint32 srcWidth, uint32 srcHeight, const void *srcTexels, uint32 srcRowSize,
+    void *dstBlocks
+);
+
+};
+
+};
+
+#endif //_RENDERWARE_ATITC_CODEC_
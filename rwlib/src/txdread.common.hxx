@@ -6,6 +6,8 @@
 namespace rw
 {
 
+struct lazyTextureSource;
+
 struct texDictionaryStreamPlugin : public serializationProvider
 {
     inline void Initialize( EngineInterface *engineInterface )
@@ -17,10 +19,19 @@ struct texDictionaryStreamPlugin : public serializationProvider
             // Register ourselves.
             RegisterSerialization( engineInterface, CHUNK_TEXDICTIONARY, txdTypeInfo, this, RWSERIALIZE_ISOF );
         }
+
+        this->lazyLoadLock = CreateReentrantReadWriteLock( engineInterface );
+
+        LIST_CLEAR( this->lazySources.root );
     }
 
     inline void Shutdown( EngineInterface *engineInterface )
     {
+        if ( reentrant_rwlock *lazyLoadLock = this->lazyLoadLock )
+        {
+            CloseReentrantReadWriteLock( engineInterface, lazyLoadLock );
+        }
+
         if ( RwTypeSystem::typeInfoBase *txdTypeInfo = this->txdTypeInfo )
         {
             // Unregister us again.
@@ -39,13 +50,33 @@ struct texDictionaryStreamPlugin : public serializationProvider
     void        Serialize( Interface *engineInterface, BlockProvider& outputProvider, RwObject *objectToSerialize ) const;
     void        Deserialize( Interface *engineInterface, BlockProvider& inputProvider, RwObject *objectToDeserialize ) const;
 
+    // Lazy loading of textures.
+    TextureBase*    DeserializeLazyTexture( EngineInterface *engineInterface, BlockProvider& textureNativeBlock, int64 blockOffset, lazyTextureSource *lazySource ) const;
+    void            LoadLazyTexture( TextureBase *theTexture ) const;
+    void            ReleaseLazyTexture( TextureBase *theTexture ) const;
+    void            LoadLazyTexturesFromStream( Stream *sourceStream ) const;
+
+    void            LoadLazyTextureNoLock( TextureBase *theTexture ) const;
+    void            ReleaseLazyTextureNoLock( TextureBase *theTexture ) const;
+    void            ReleaseLazyTextureSourceNoLock( EngineInterface *engineInterface, lazyTextureSource *lazySource ) const;
+
+    // Reads the texture native blocks into memory and decodes them on the worker threads.
+    void        DeserializeTexturesParallel( EngineInterface *engineInterface, BlockProvider& inputProvider, TexDictionary *txdObj, uint32 textureBlockCount ) const;
+
     RwTypeSystem::typeInfoBase *txdTypeInfo;
+
+    // Serializes reading from the source streams of lazily loaded textures.
+    // It also protects the list of source streams. Reading a texture can delete streams, which
+    // looks for lazily loaded textures again, so the lock is reentrant.
+    reentrant_rwlock *lazyLoadLock;
+
+    // Streams that lazily loaded textures still have to read from.
+    mutable RwList <lazyTextureSource> lazySources;
 };
 
-inline void fixFilteringMode(TextureBase& inTex, uint32 mipmapCount)
+// Returns the filtering mode that matches the mipmap count.
+inline eRasterStageFilterMode getFixedFilteringMode(eRasterStageFilterMode currentFilterMode, uint32 mipmapCount)
 {
-    eRasterStageFilterMode currentFilterMode = inTex.GetFilterMode();
-
     eRasterStageFilterMode newFilterMode = currentFilterMode;
 
     if ( mipmapCount > 1 )
@@ -73,6 +104,15 @@ inline void fixFilteringMode(TextureBase& inTex, uint32 mipmapCount)
         }
     }
 
+    return newFilterMode;
+}
+
+inline void fixFilteringMode(TextureBase& inTex, uint32 mipmapCount)
+{
+    eRasterStageFilterMode currentFilterMode = inTex.GetFilterMode();
+
+    eRasterStageFilterMode newFilterMode = getFixedFilteringMode( currentFilterMode, mipmapCount );
+
     // If the texture requires a different filter mode, set it.
     if ( currentFilterMode != newFilterMode )
     {
@@ -491,6 +531,57 @@ struct texFormatInfo_serialized
     }
 };
 
+// Reads the leading header of the struct block of a texture native and gives it to the callback.
+// Used to fetch the texture properties without touching the texel data.
+template <typename headerType, typename callbackType>
+inline bool readTextureNativeStructHeader( BlockProvider& inputProvider, callbackType&& cb )
+{
+    bool hasProperties = false;
+
+    BlockProvider texNativeStruct( &inputProvider );
+
+    texNativeStruct.EnterContext();
+
+    try
+    {
+        if ( texNativeStruct.getBlockID() == CHUNK_STRUCT )
+        {
+            headerType metaHeader;
+            texNativeStruct.read( &metaHeader, sizeof( metaHeader ) );
+
+            hasProperties = cb( metaHeader );
+        }
+    }
+    catch( ... )
+    {
+        texNativeStruct.LeaveContext();
+
+        throw;
+    }
+
+    texNativeStruct.LeaveContext();
+
+    return hasProperties;
+}
+
+// Takes over the zero-padded names of a texture native header.
+template <size_t nameSize>
+inline void readTextureNativeNames( TextureBase& theTexture, const char (&name)[ nameSize ], const char (&maskName)[ nameSize ] )
+{
+    char tmpbuf[ nameSize + 1 ];
+
+    // Make sure the name buffer is zero terminated.
+    tmpbuf[ nameSize ] = '\0';
+
+    memcpy( tmpbuf, name, nameSize );
+
+    theTexture.SetName( tmpbuf );
+
+    memcpy( tmpbuf, maskName, nameSize );
+
+    theTexture.SetMaskName( tmpbuf );
+}
+
 struct wardrumFormatInfo
 {
 private:
@@ -11,12 +11,16 @@
 
 #include "txdread.natcompat.hxx"
 
+#include "txdread.raster.hxx"
+
 #include "pluginutil.hxx"
 
 #include "txdread.common.hxx"
 
 #include "rwserialize.hxx"
 
+#include "rwthreading.pool.hxx"
+
 namespace rw
 {
 
@@ -24,6 +28,296 @@ namespace rw
  * Texture Dictionary
  */
 
+// Stream that lazily loaded textures are read from.
+// It is shared by all textures of one dictionary read.
+// Sources are protected by the lazy load lock.
+struct lazyTextureSource
+{
+    Stream *sourceStream;
+
+    uint32 refCount;
+
+    RwListEntry <lazyTextureSource> node;
+
+    // Textures that have not been read yet.
+    RwList <lazyTextureData> textures;
+};
+
+struct lazyTextureData
+{
+    lazyTextureSource *source;
+
+    TextureBase *texture;
+
+    RwListEntry <lazyTextureData> sourceNode;
+
+    // Stream offset of the texture native block header.
+    int64 blockOffset;
+
+    // Properties as they were read from the header.
+    // Only the ones that were changed since have to be kept once the texture is read.
+    std::string texName;
+    std::string texMaskName;
+    eRasterStageFilterMode filterMode;
+    eRasterStageAddressMode uAddressing;
+    eRasterStageAddressMode vAddressing;
+};
+
+void texDictionaryStreamPlugin::ReleaseLazyTextureSourceNoLock( EngineInterface *engineInterface, lazyTextureSource *lazySource ) const
+{
+    if ( --lazySource->refCount == 0 )
+    {
+        LIST_REMOVE( lazySource->node );
+
+        lazySource->~lazyTextureSource();
+
+        engineInterface->MemFree( lazySource );
+    }
+}
+
+TextureBase* texDictionaryStreamPlugin::DeserializeLazyTexture( EngineInterface *engineInterface, BlockProvider& textureNativeBlock, int64 blockOffset, lazyTextureSource *lazySource ) const
+{
+    TextureBase *texture = NULL;
+
+    textureNativeBlock.EnterContext();
+
+    try
+    {
+        if ( textureNativeBlock.getBlockID() == CHUNK_TEXTURENATIVE )
+        {
+            texture = CreateTexture( engineInterface, NULL );
+
+            if ( texture )
+            {
+                texture->SetEngineVersion( textureNativeBlock.getBlockVersion() );
+
+                bool hasProperties = false;
+
+                try
+                {
+                    hasProperties = nativeTextureStreamStore.GetPluginStruct( engineInterface )->DeserializeProperties( textureNativeBlock, texture );
+                }
+                catch( RwException& )
+                {
+                    // Let the complete deserialization report the error.
+                    hasProperties = false;
+                }
+
+                if ( hasProperties )
+                {
+                    void *lazyMem = engineInterface->MemAllocate( sizeof( lazyTextureData ) );
+
+                    if ( lazyMem == NULL )
+                    {
+                        throw RwException( "failed to allocate lazy texture data" );
+                    }
+
+                    lazyTextureData *lazyData = new (lazyMem) lazyTextureData;
+
+                    lazyData->source = lazySource;
+                    lazyData->texture = texture;
+                    lazyData->blockOffset = blockOffset;
+                    lazyData->texName = texture->GetName();
+                    lazyData->texMaskName = texture->GetMaskName();
+                    lazyData->filterMode = texture->GetFilterMode();
+                    lazyData->uAddressing = texture->GetUAddressing();
+                    lazyData->vAddressing = texture->GetVAddressing();
+
+                    {
+                        scoped_rwlock_writer <reentrant_rwlock> ctxAddLazy( this->lazyLoadLock );
+
+                        LIST_APPEND( lazySource->textures.root, lazyData->sourceNode );
+
+                        lazySource->refCount++;
+
+                        texture->lazyData = lazyData;
+                    }
+                }
+                else
+                {
+                    engineInterface->DeleteRwObject( texture );
+
+                    texture = NULL;
+                }
+            }
+        }
+    }
+    catch( ... )
+    {
+        if ( texture )
+        {
+            engineInterface->DeleteRwObject( texture );
+        }
+
+        textureNativeBlock.LeaveContext();
+
+        throw;
+    }
+
+    textureNativeBlock.LeaveContext();
+
+    return texture;
+}
+
+void texDictionaryStreamPlugin::LoadLazyTexture( TextureBase *theTexture ) const
+{
+    scoped_rwlock_writer <reentrant_rwlock> ctxLoadLazy( this->lazyLoadLock );
+
+    this->LoadLazyTextureNoLock( theTexture );
+}
+
+void texDictionaryStreamPlugin::LoadLazyTextureNoLock( TextureBase *theTexture ) const
+{
+    // Another thread could have loaded the texture already.
+    lazyTextureData *lazyData = theTexture->lazyData.load();
+
+    if ( lazyData == NULL )
+        return;
+
+    EngineInterface *engineInterface = (EngineInterface*)theTexture->engineInterface;
+
+    Stream *sourceStream = lazyData->source->sourceStream;
+
+    // The block is read into a texture of its own, so that we can tell which properties
+    // have been changed since the header was read.
+    TextureBase *loadedTexture = CreateTexture( engineInterface, NULL );
+
+    if ( loadedTexture == NULL )
+    {
+        engineInterface->PushWarning( "failed to allocate texture for lazy loading" );
+    }
+    else
+    {
+        int64 prevStreamPos = sourceStream->tell();
+
+        try
+        {
+            sourceStream->seek( lazyData->blockOffset, RWSEEK_BEG );
+
+            BlockProvider textureNativeBlock( sourceStream, RWBLOCKMODE_READ, false );
+
+            textureNativeBlock.EnterContext();
+
+            try
+            {
+                nativeTextureStreamStore.GetPluginStruct( engineInterface )->Deserialize( engineInterface, textureNativeBlock, loadedTexture );
+            }
+            catch( ... )
+            {
+                textureNativeBlock.LeaveContext();
+
+                throw;
+            }
+
+            textureNativeBlock.LeaveContext();
+
+            // Take over the raster.
+            Raster *texRaster = loadedTexture->texRaster;
+
+            loadedTexture->texRaster = NULL;
+
+            theTexture->texRaster = texRaster;
+
+            if ( texRaster != NULL && texRaster->GetEngineVersion() != theTexture->GetEngineVersion() )
+            {
+                texRaster->SetEngineVersion( theTexture->GetEngineVersion() );
+            }
+
+            // The complete read can fix properties, like the filtering by the actual mipmap count.
+            // Take them unless they were changed since the header was read.
+            if ( theTexture->GetName() == lazyData->texName )
+            {
+                theTexture->SetName( loadedTexture->GetName().c_str() );
+            }
+
+            if ( theTexture->GetMaskName() == lazyData->texMaskName )
+            {
+                theTexture->SetMaskName( loadedTexture->GetMaskName().c_str() );
+            }
+
+            if ( theTexture->GetFilterMode() == lazyData->filterMode )
+            {
+                theTexture->SetFilterMode( loadedTexture->GetFilterMode() );
+            }
+
+            if ( theTexture->GetUAddressing() == lazyData->uAddressing )
+            {
+                theTexture->SetUAddressing( loadedTexture->GetUAddressing() );
+            }
+
+            if ( theTexture->GetVAddressing() == lazyData->vAddressing )
+            {
+                theTexture->SetVAddressing( loadedTexture->GetVAddressing() );
+            }
+        }
+        catch( RwException& except )
+        {
+            // We cannot remove the texture from its dictionary here, so it stays without raster.
+            std::string pushWarning = "texture native reading failure: ";
+            pushWarning += except.message;
+
+            engineInterface->PushWarning( std::move( pushWarning ) );
+        }
+
+        sourceStream->seek( prevStreamPos, RWSEEK_BEG );
+
+        engineInterface->DeleteRwObject( loadedTexture );
+    }
+
+    this->ReleaseLazyTextureNoLock( theTexture );
+}
+
+void texDictionaryStreamPlugin::ReleaseLazyTexture( TextureBase *theTexture ) const
+{
+    scoped_rwlock_writer <reentrant_rwlock> ctxReleaseLazy( this->lazyLoadLock );
+
+    this->ReleaseLazyTextureNoLock( theTexture );
+}
+
+void texDictionaryStreamPlugin::ReleaseLazyTextureNoLock( TextureBase *theTexture ) const
+{
+    lazyTextureData *lazyData = theTexture->lazyData.exchange( NULL );
+
+    if ( lazyData )
+    {
+        EngineInterface *engineInterface = (EngineInterface*)theTexture->engineInterface;
+
+        LIST_REMOVE( lazyData->sourceNode );
+
+        this->ReleaseLazyTextureSourceNoLock( engineInterface, lazyData->source );
+
+        lazyData->~lazyTextureData();
+
+        engineInterface->MemFree( lazyData );
+    }
+}
+
+void texDictionaryStreamPlugin::LoadLazyTexturesFromStream( Stream *sourceStream ) const
+{
+    scoped_rwlock_writer <reentrant_rwlock> ctxLoadLazy( this->lazyLoadLock );
+
+    // Loading the last texture of a source deletes that source, so look it up again every time.
+    while ( true )
+    {
+        TextureBase *pendingTexture = NULL;
+
+        LIST_FOREACH_BEGIN( lazyTextureSource, this->lazySources.root, node )
+
+            if ( item->sourceStream == sourceStream && LIST_EMPTY( item->textures.root ) == false )
+            {
+                pendingTexture = LIST_GETITEM( lazyTextureData, item->textures.root.next, sourceNode )->texture;
+                break;
+            }
+
+        LIST_FOREACH_END
+
+        if ( pendingTexture == NULL )
+            break;
+
+        this->LoadLazyTextureNoLock( pendingTexture );
+    }
+}
+
 TexDictionary* texDictionaryStreamPlugin::CreateTexDictionary( EngineInterface *engineInterface ) const
 {
     GenericRTTI *rttiObj = engineInterface->typeSystem.Construct( engineInterface, this->txdTypeInfo, NULL );
@@ -58,6 +352,247 @@ const TexDictionary* texDictionaryStreamPlugin::ToConstTexDictionary( EngineInte
     return NULL;
 }
 
+static void addDeserializedTextureNative( EngineInterface *engineInterface, TexDictionary *txdObj, RwObject *rwObj, const std::string& errDebugMsg )
+{
+    if ( rwObj )
+    {
+        // If it is a texture, add it to our TXD.
+        bool hasBeenAddedToTXD = false;
+
+        GenericRTTI *rttiObj = RwTypeSystem::GetTypeStructFromObject( rwObj );
+
+        RwTypeSystem::typeInfoBase *typeInfo = RwTypeSystem::GetTypeInfoFromTypeStruct( rttiObj );
+
+        if ( engineInterface->typeSystem.IsTypeInheritingFrom( engineInterface->textureTypeInfo, typeInfo ) )
+        {
+            TextureBase *texture = (TextureBase*)rwObj;
+
+            texture->AddToDictionary( txdObj );
+
+            hasBeenAddedToTXD = true;
+        }
+
+        // If it has not been added, delete it.
+        if ( hasBeenAddedToTXD == false )
+        {
+            engineInterface->DeleteRwObject( rwObj );
+        }
+    }
+    else
+    {
+        std::string pushWarning;
+
+        if ( errDebugMsg.empty() == false )
+        {
+            pushWarning = "texture native reading failure: ";
+            pushWarning += errDebugMsg;
+        }
+        else
+        {
+            pushWarning = "failed to deserialize texture native block in texture dictionary";
+        }
+
+        engineInterface->PushWarning( pushWarning.c_str() );
+    }
+}
+
+void texDictionaryStreamPlugin::DeserializeTexturesParallel( EngineInterface *engineInterface, BlockProvider& inputProvider, TexDictionary *txdObj, uint32 textureBlockCount ) const
+{
+    uint32 concurrency = GetParallelConcurrency( engineInterface );
+
+    // Only a few blocks per thread are kept in memory at a time.
+    uint32 batchSize = ( concurrency * 4 );
+
+    struct textureNativeJob
+    {
+        const void *blockData;
+        size_t blockSize;
+        bool ownsBlockData;     // false if blockData points into the memory of the input stream
+
+        RwObject *rwObj;
+        std::string errDebugMsg;
+
+        nativeTextureStreamPlugin::QueuedWarningHandler warningQueue;
+    };
+
+    std::vector <textureNativeJob> jobs( std::min( batchSize, textureBlockCount ) );
+
+    auto decodeBlock = [&]( uint32 jobIndex )
+    {
+        textureNativeJob& job = jobs[ jobIndex ];
+
+        if ( job.blockData == NULL )
+            return;
+
+        // Keep the warnings of this texture, so they can be reported in order.
+        GlobalPushWarningHandler( engineInterface, &job.warningQueue );
+
+        try
+        {
+            // The stream is read-only, so it never writes to the block memory.
+            streamConstructionMemoryParam_t memParam( const_cast <void*> ( job.blockData ), job.blockSize );
+
+            Stream *blockStream = engineInterface->CreateStream( RWSTREAMTYPE_MEMORY, RWSTREAMMODE_READONLY, &memParam );
+
+            if ( blockStream == NULL )
+            {
+                throw RwException( "failed to create texture native block stream" );
+            }
+
+            try
+            {
+                BlockProvider textureNativeBlock( blockStream, RWBLOCKMODE_READ, false );
+
+                job.rwObj = engineInterface->DeserializeBlock( textureNativeBlock );
+            }
+            catch( ... )
+            {
+                engineInterface->DeleteStream( blockStream );
+
+                throw;
+            }
+
+            engineInterface->DeleteStream( blockStream );
+        }
+        catch( RwException& except )
+        {
+            job.rwObj = NULL;
+            job.errDebugMsg = except.message;
+        }
+        catch( ... )
+        {
+            GlobalPopWarningHandler( engineInterface );
+
+            throw;
+        }
+
+        GlobalPopWarningHandler( engineInterface );
+    };
+
+    uint32 n = 0;
+
+    while ( n < textureBlockCount )
+    {
+        uint32 batchCount = std::min( batchSize, textureBlockCount - n );
+
+        for ( uint32 jobIndex = 0; jobIndex < batchCount; jobIndex++ )
+        {
+            textureNativeJob& job = jobs[ jobIndex ];
+
+            job.blockData = NULL;
+            job.blockSize = 0;
+            job.ownsBlockData = false;
+            job.rwObj = NULL;
+            job.errDebugMsg.clear();
+            job.warningQueue.message_list.clear();
+        }
+
+        try
+        {
+            // Fetch the blocks on this thread, since the stream is not thread-safe.
+            for ( uint32 jobIndex = 0; jobIndex < batchCount; jobIndex++ )
+            {
+                textureNativeJob& job = jobs[ jobIndex ];
+
+                try
+                {
+                    int64 texBlockStart = inputProvider.tell();
+
+                    // Skip the block to learn about its size.
+                    {
+                        BlockProvider textureNativeBlock( &inputProvider );
+
+                        textureNativeBlock.EnterContext();
+                        textureNativeBlock.LeaveContext();
+                    }
+
+                    size_t blockSize = (size_t)( inputProvider.tell() - texBlockStart );
+
+                    inputProvider.seek( texBlockStart, RWSEEK_BEG );
+
+                    // Memory based streams give us the block without a copy.
+                    // Their memory stays valid while we are reading, so the workers can decode from it directly.
+                    if ( const void *blockView = inputProvider.read_view( blockSize ) )
+                    {
+                        job.blockData = blockView;
+                        job.blockSize = blockSize;
+                    }
+                    else
+                    {
+                        void *blockData = engineInterface->MemAllocate( blockSize );
+
+                        if ( blockData == NULL )
+                        {
+                            throw RwException( "failed to allocate texture native block memory" );
+                        }
+
+                        job.blockData = blockData;
+                        job.blockSize = blockSize;
+                        job.ownsBlockData = true;
+
+                        inputProvider.read( blockData, blockSize );
+                    }
+                }
+                catch( RwException& except )
+                {
+                    // Like in the sequential reading, we continue after broken blocks.
+                    if ( job.ownsBlockData )
+                    {
+                        engineInterface->MemFree( const_cast <void*> ( job.blockData ) );
+
+                        job.ownsBlockData = false;
+                    }
+
+                    job.blockData = NULL;
+
+                    job.errDebugMsg = except.message;
+                }
+            }
+
+            ParallelFor( engineInterface, batchCount, concurrency, decodeBlock );
+        }
+        catch( ... )
+        {
+            for ( uint32 jobIndex = 0; jobIndex < batchCount; jobIndex++ )
+            {
+                textureNativeJob& job = jobs[ jobIndex ];
+
+                if ( job.ownsBlockData )
+                {
+                    engineInterface->MemFree( const_cast <void*> ( job.blockData ) );
+                }
+
+                if ( RwObject *rwObj = job.rwObj )
+                {
+                    engineInterface->DeleteRwObject( rwObj );
+                }
+            }
+
+            throw;
+        }
+
+        // Add the textures in the order of the dictionary.
+        for ( uint32 jobIndex = 0; jobIndex < batchCount; jobIndex++ )
+        {
+            textureNativeJob& job = jobs[ jobIndex ];
+
+            if ( job.ownsBlockData )
+            {
+                engineInterface->MemFree( const_cast <void*> ( job.blockData ) );
+            }
+
+            for ( std::string& msg : job.warningQueue.message_list )
+            {
+                engineInterface->PushWarning( std::move( msg ) );
+            }
+
+            addDeserializedTextureNative( engineInterface, txdObj, job.rwObj, job.errDebugMsg );
+        }
+
+        n += batchCount;
+    }
+}
+
 void texDictionaryStreamPlugin::Deserialize( Interface *intf, BlockProvider& inputProvider, RwObject *objectToDeserialize ) const
 {
     EngineInterface *engineInterface = (EngineInterface*)intf;
@@ -114,76 +649,130 @@ void texDictionaryStreamPlugin::Deserialize( Interface *intf, BlockProvider& inp
         txdObj->hasRecommendedPlatform = requiresRecommendedPlatform;
         txdObj->recDevicePlatID = recDevicePlatID;
 
-        // Now follow multiple TEXTURENATIVE blocks.
-        // Deserialize all of them.
+        // If requested, we only read the texture properties and keep the location of the texel data.
+        // Skipping the texel data requires the block lengths to be trusted.
+        lazyTextureSource *lazySource = NULL;
 
-        for ( uint32 n = 0; n < textureBlockCount; n++ )
+        if ( engineInterface->GetLazyTexDictionaryLoading() && inputProvider.doesIgnoreBlockRegions() == false )
         {
-            BlockProvider textureNativeBlock( &inputProvider );
-
-            // Deserialize this block.
-            RwObject *rwObj = NULL;
-
-            std::string errDebugMsg;
-
-            try
-            {
-                rwObj = engineInterface->DeserializeBlock( textureNativeBlock );
-            }
-            catch( RwException& except )
+            if ( Stream *sourceStream = inputProvider.getContextStream() )
             {
-                // Catch the exception and try to continue.
-                rwObj = NULL;
+                void *sourceMem = engineInterface->MemAllocate( sizeof( lazyTextureSource ) );
 
-                if ( textureNativeBlock.doesIgnoreBlockRegions() )
+                if ( sourceMem )
                 {
-                    // If we failed any texture parsing in the "ignoreBlockRegions" parse mode,
-                    // there is no point in continuing, since the environment does not recover.
-                    throw;
-                }
+                    lazySource = new (sourceMem) lazyTextureSource;
 
-                errDebugMsg = except.message;
-            }
+                    lazySource->sourceStream = sourceStream;
 
-            if ( rwObj )
-            {
-                // If it is a texture, add it to our TXD.
-                bool hasBeenAddedToTXD = false;
+                    // The reference of this deserialization.
+                    lazySource->refCount = 1;
 
-                GenericRTTI *rttiObj = RwTypeSystem::GetTypeStructFromObject( rwObj );
+                    LIST_CLEAR( lazySource->textures.root );
 
-                RwTypeSystem::typeInfoBase *typeInfo = RwTypeSystem::GetTypeInfoFromTypeStruct( rttiObj );
+                    scoped_rwlock_writer <reentrant_rwlock> ctxAddSource( this->lazyLoadLock );
 
-                if ( engineInterface->typeSystem.IsTypeInheritingFrom( engineInterface->textureTypeInfo, typeInfo ) )
-                {
-                    TextureBase *texture = (TextureBase*)rwObj;
+                    LIST_APPEND( this->lazySources.root, lazySource->node );
+                }
+            }
+        }
 
-                    texture->AddToDictionary( txdObj );
+        // Now follow multiple TEXTURENATIVE blocks.
+        // Deserialize all of them, on the worker threads if requested.
+        // That is only possible if the worker threads see the configuration of this thread.
+        bool parallelDecode = false;
 
-                    hasBeenAddedToTXD = true;
-                }
+        if ( lazySource == NULL && textureBlockCount > 1 && inputProvider.doesIgnoreBlockRegions() == false )
+        {
+            const rwConfigBlock& cfgBlock = GetConstEnvironmentConfigBlock( engineInterface );
+
+            parallelDecode =
+                ( cfgBlock.GetParallelTexDictionaryLoading() && cfgBlock.enableThreadedConfig == false &&
+                  GetParallelConcurrency( engineInterface ) > 1 );
+        }
 
-                // If it has not been added, delete it.
-                if ( hasBeenAddedToTXD == false )
+        if ( parallelDecode )
+        {
+            this->DeserializeTexturesParallel( engineInterface, inputProvider, txdObj, textureBlockCount );
+        }
+        else
+        {
+            try
+            {
+                for ( uint32 n = 0; n < textureBlockCount; n++ )
                 {
-                    engineInterface->DeleteRwObject( rwObj );
+                    // Deserialize this block.
+                    RwObject *rwObj = NULL;
+
+                    std::string errDebugMsg;
+
+                    if ( lazySource )
+                    {
+                        int64 texBlockStart = inputProvider.tell();
+                        int64 blockOffset = inputProvider.tell_absolute();
+
+                        try
+                        {
+                            BlockProvider textureNativeBlock( &inputProvider );
+
+                            rwObj = this->DeserializeLazyTexture( engineInterface, textureNativeBlock, blockOffset, lazySource );
+                        }
+                        catch( RwException& )
+                        {
+                            rwObj = NULL;
+                        }
+
+                        if ( rwObj == NULL )
+                        {
+                            // Read this block completely instead.
+                            inputProvider.seek( texBlockStart, RWSEEK_BEG );
+                        }
+                    }
+
+                    if ( rwObj == NULL )
+                    {
+                        BlockProvider textureNativeBlock( &inputProvider );
+
+                        try
+                        {
+                            rwObj = engineInterface->DeserializeBlock( textureNativeBlock );
+                        }
+                        catch( RwException& except )
+                        {
+                            // Catch the exception and try to continue.
+                            rwObj = NULL;
+
+                            if ( textureNativeBlock.doesIgnoreBlockRegions() )
+                            {
+                                // If we failed any texture parsing in the "ignoreBlockRegions" parse mode,
+                                // there is no point in continuing, since the environment does not recover.
+                                throw;
+                            }
+
+                            errDebugMsg = except.message;
+                        }
+                    }
+
+                    addDeserializedTextureNative( engineInterface, txdObj, rwObj, errDebugMsg );
                 }
             }
-            else
+            catch( ... )
             {
-                std::string pushWarning;
-
-                if ( errDebugMsg.empty() == false )
-                {
-                    pushWarning = "texture native reading failure: ";
-                    pushWarning += errDebugMsg;
-                }
-                else
+                if ( lazySource )
                 {
-                    pushWarning = "failed to deserialize texture native block in texture dictionary";
+                    scoped_rwlock_writer <reentrant_rwlock> ctxReleaseSource( this->lazyLoadLock );
+
+                    this->ReleaseLazyTextureSourceNoLock( engineInterface, lazySource );
                 }
 
-                engineInterface->PushWarning( pushWarning.c_str() );
+                throw;
+            }
+
+            if ( lazySource )
+            {
+                scoped_rwlock_writer <reentrant_rwlock> ctxReleaseSource( this->lazyLoadLock );
+
+                this->ReleaseLazyTextureSourceNoLock( engineInterface, lazySource );
             }
         }
     }
@@ -237,6 +826,23 @@ TexDictionary::~TexDictionary( void )
 
 static PluginDependantStructRegister <texDictionaryStreamPlugin, RwInterfaceFactory_t> texDictionaryStreamStore;
 
+void LoadLazyTexturesFromStream( EngineInterface *engineInterface, Stream *sourceStream )
+{
+    if ( texDictionaryStreamPlugin *txdStream = texDictionaryStreamStore.GetPluginStruct( engineInterface ) )
+    {
+        txdStream->LoadLazyTexturesFromStream( sourceStream );
+    }
+}
+
+void TexDictionary::LoadLazyTextures( void )
+{
+    LIST_FOREACH_BEGIN( TextureBase, this->textures.root, texDictNode )
+
+        item->GetRaster();
+
+    LIST_FOREACH_END
+}
+
 void TexDictionary::clear(void)
 {
 	// We remove the links of all textures inside of us.
@@ -315,7 +921,9 @@ const TexDictionary* ToConstTexDictionary( Interface *intf, const RwObject *rwOb
 TextureBase::TextureBase( const TextureBase& right ) : RwObject( right )
 {
     // General cloning business.
-    this->texRaster = AcquireRaster( right.texRaster );
+    // Lazily loaded textures have to read their raster for that.
+    this->texRaster = AcquireRaster( right.GetRaster() );
+    this->lazyData = NULL;
     this->name = right.name;
     this->maskName = right.maskName;
     this->filterMode = right.filterMode;
@@ -357,6 +965,37 @@ void TextureBase::SetRaster( Raster *texRaster )
             this->objVersion = ourRaster->GetEngineVersion();
         }
     }
+
+    // A raster that has been set replaces the one that would be read lazily.
+    if ( this->lazyData.load() != NULL )
+    {
+        EngineInterface *engineInterface = (EngineInterface*)this->engineInterface;
+
+        if ( texDictionaryStreamPlugin *txdStream = texDictionaryStreamStore.GetPluginStruct( engineInterface ) )
+        {
+            txdStream->ReleaseLazyTexture( this );
+        }
+    }
+}
+
+Raster* TextureBase::GetRaster( void ) const
+{
+    if ( this->lazyData.load() != NULL )
+    {
+        const_cast <TextureBase*> ( this )->LoadLazyData();
+    }
+
+    return this->texRaster;
+}
+
+void TextureBase::LoadLazyData( void )
+{
+    EngineInterface *engineInterface = (EngineInterface*)this->engineInterface;
+
+    if ( texDictionaryStreamPlugin *txdStream = texDictionaryStreamStore.GetPluginStruct( engineInterface ) )
+    {
+        txdStream->LoadLazyTexture( this );
+    }
 }
 
 void TextureBase::AddToDictionary( TexDictionary *dict )
@@ -671,6 +1310,8 @@ void registerNativeTexturePlugins( void );
 
 // Sub modules.
 void registerResizeFilteringEnvironment( void );
+void registerTexelKernelEnvironment( void );
+void registerPermutationPlanCache( void );
 
 void registerTXDPlugins( void )
 {
@@ -682,6 +1323,8 @@ void registerTXDPlugins( void )
 
     // Register pure sub modules.
     registerResizeFilteringEnvironment();
+    registerTexelKernelEnvironment();
+    registerPermutationPlanCache();
 }
 
 }
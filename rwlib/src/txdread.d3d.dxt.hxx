@@ -6,6 +6,8 @@
 
 #include "pixelformat.hxx"
 
+#include "rwthreading.pool.hxx"
+
 namespace rw
 {
 
@@ -492,170 +494,192 @@ inline uint32 getDXTRasterDataSize(uint32 dxtType, uint32 texUnitCount)
     return ( texBlockCount * blockSize );
 }
 
+// Compresses one row of 4x4 blocks.
+// Block rows do not depend on each other, so they can be compressed on multiple threads at once.
 template <template <typename numberType> class endianness>
-inline void compressTexelsUsingDXT(
-    Interface *engineInterface,
-    uint32 dxtType, const void *texelSource, uint32 mipWidth, uint32 mipHeight, uint32 rowAlignment,
-    eRasterFormat rasterFormat, const void *paletteData, ePaletteType paletteType, uint32 maxpalette, eColorOrdering colorOrder, uint32 itemDepth,
-    void*& texelsOut, uint32& dataSizeOut,
-    uint32& realWidthOut, uint32& realHeightOut
+inline void compressDXTBlockRow(
+    uint32 dxtType, const void *texelSource, uint32 mipWidth, uint32 mipHeight, uint32 rawRowSize,
+    const colorModelDispatcher& fetchSrcDispatch,
+    void *dxtArray, uint32 widthBlocks, uint32 y_block
 )
 {
-    // Make sure the texture dimensions are aligned by 4.
-    uint32 alignedMipWidth = ALIGN_SIZE( mipWidth, 4u );
-    uint32 alignedMipHeight = ALIGN_SIZE( mipHeight, 4u );
+    uint32 compressedBlockCount = ( y_block * widthBlocks );
 
-    uint32 dxtDataSize = getDXTRasterDataSize(dxtType, ( alignedMipWidth * alignedMipHeight ) );
+    uint32 y = ( y_block * 4 );
 
-    void *dxtArray = engineInterface->PixelAllocate( dxtDataSize );
+    uint32 x = 0;
 
-    if ( !dxtArray )
+    for ( uint32 x_block = 0; x_block < widthBlocks; x_block++, x += 4 )
     {
-        throw RwException( "failed to allocate DXT surface in compression routine" );
-    }
-    
-    try
-    {
-        // Calculate the row size of the source texture.
-        uint32 rawRowSize = getRasterDataRowSize( mipWidth, itemDepth, rowAlignment );
-
-        // Loop across the image.
-        uint32 compressedBlockCount = 0;
+        // Compress a 4x4 color block.
+        PixelFormat::pixeldata32bit colors[4][4];
 
-        uint32 widthBlocks = alignedMipWidth / 4;
-        uint32 heightBlocks = alignedMipHeight / 4;
+        // Check whether we should premultiply.
+        bool isPremultiplied = ( dxtType == 2 || dxtType == 4 );
 
-        uint32 y = 0;
+        for ( uint32 y_iter = 0; y_iter != 4; y_iter++ )
+        {
+            for ( uint32 x_iter = 0; x_iter != 4; x_iter++ )
+            {
+                PixelFormat::pixeldata32bit& inColor = colors[ y_iter ][ x_iter ];
 
-        colorModelDispatcher fetchSrcDispatch( rasterFormat, colorOrder, itemDepth, paletteData, maxpalette, paletteType );
+                uint8 r = 0;
+                uint8 g = 0;
+                uint8 b = 0;
+                uint8 a = 0;
 
-        for ( uint32 y_block = 0; y_block < heightBlocks; y_block++, y += 4 )
-        {
-            uint32 x = 0;
+                uint32 targetX = ( x + x_iter );
+                uint32 targetY = ( y + y_iter );
 
-            for ( uint32 x_block = 0; x_block < widthBlocks; x_block++, x += 4 )
-            {
-                // Compress a 4x4 color block.
-                PixelFormat::pixeldata32bit colors[4][4];
+                if ( targetX < mipWidth && targetY < mipHeight )
+                {
+                    const void *rowData = getConstTexelDataRow( texelSource, rawRowSize, targetY );
 
-                // Check whether we should premultiply.
-                bool isPremultiplied = ( dxtType == 2 || dxtType == 4 );
+                    fetchSrcDispatch.getRGBA( rowData, targetX, r, g, b, a );
+                }
 
-                for ( uint32 y_iter = 0; y_iter != 4; y_iter++ )
+                if ( isPremultiplied )
                 {
-                    for ( uint32 x_iter = 0; x_iter != 4; x_iter++ )
-                    {
-                        PixelFormat::pixeldata32bit& inColor = colors[ y_iter ][ x_iter ];
+                    premultiplyByAlpha( r, g, b, a, r, g, b );
+                }
 
-                        uint8 r = 0;
-                        uint8 g = 0;
-                        uint8 b = 0;
-                        uint8 a = 0;
+                inColor.red = r;
+                inColor.green = g;
+                inColor.blue = b;
+                inColor.alpha = a;
+            }
+        }
 
-                        uint32 targetX = ( x + x_iter );
-                        uint32 targetY = ( y + y_iter );
+        // Compress it using SQUISH.
 
-                        if ( targetX < mipWidth && targetY < mipHeight )
-                        {
-                            const void *rowData = getConstTexelDataRow( texelSource, rawRowSize, targetY );
+        // Since SQUISH only supports native-word DXT blocks, we will have to
+        // convert to the correct endianness after compression.
+        if ( dxtType == 1 )
+        {
+            struct native_dxt1_block
+            {
+                rgb565 col0;
+                rgb565 col1;
 
-                            fetchSrcDispatch.getRGBA( rowData, targetX, r, g, b, a );
-                        }
+                uint32 indexList;
+            };
+            native_dxt1_block compr_block;
 
-                        if ( isPremultiplied )
-                        {
-                            premultiplyByAlpha( r, g, b, a, r, g, b );
-                        }
+            squish::Compress( (const squish::u8*)colors, &compr_block, squish::kDxt1 );
 
-                        inColor.red = r;
-                        inColor.green = g;
-                        inColor.blue = b;
-                        inColor.alpha = a;
-                    }
-                }
+            // Write it into the texture in correct endianness.
+            dxt1_block <endianness> *dstBlock = (dxt1_block <endianness>*)dxtArray + compressedBlockCount;
 
-                // Compress it using SQUISH.
+            dstBlock->col0 = compr_block.col0;
+            dstBlock->col1 = compr_block.col1;
+            dstBlock->indexList = compr_block.indexList;
+        }
+        else if ( dxtType == 2 || dxtType == 3 )
+        {
+            struct native_dxt23_block
+            {
+                uint64 alphaList;
 
-                // Since SQUISH only supports native-word DXT blocks, we will have to
-                // convert to the correct endianness after compression.
-                if ( dxtType == 1 )
-                {
-                    struct native_dxt1_block
-                    {
-                        rgb565 col0;
-                        rgb565 col1;
+                rgb565 col0;
+                rgb565 col1;
 
-                        uint32 indexList;
-                    };
-                    native_dxt1_block compr_block;
+                uint32 indexList;
+            };
+            native_dxt23_block compr_block;
 
-                    squish::Compress( (const squish::u8*)colors, &compr_block, squish::kDxt1 );
+            squish::Compress( (const squish::u8*)colors, &compr_block, squish::kDxt3 );
 
-                    // Write it into the texture in correct endianness.
-                    dxt1_block <endianness> *dstBlock = (dxt1_block <endianness>*)dxtArray + compressedBlockCount;
+            // Write it in correct endianness to the texture.
+            dxt2_3_block <endianness> *dstBlock = (dxt2_3_block <endianness>*)dxtArray + compressedBlockCount;
 
-                    dstBlock->col0 = compr_block.col0;
-                    dstBlock->col1 = compr_block.col1;
-                    dstBlock->indexList = compr_block.indexList;
-                }
-                else if ( dxtType == 2 || dxtType == 3 )
-                {
-                    struct native_dxt23_block
-                    {
-                        uint64 alphaList;
+            dstBlock->alphaList = compr_block.alphaList;
+            dstBlock->col0 = compr_block.col0;
+            dstBlock->col1 = compr_block.col1;
+            dstBlock->indexList = compr_block.indexList;
+        }
+        else if ( dxtType == 4 || dxtType == 5 )
+        {
+            struct native_dxt45_block
+            {
+                uint8 alphaPreMult[2];
+                uint48_t alphaList;
 
-                        rgb565 col0;
-                        rgb565 col1;
+                rgb565 col0;
+                rgb565 col1;
 
-                        uint32 indexList;
-                    };
-                    native_dxt23_block compr_block;
+                uint32 indexList;
+            };
+            native_dxt45_block compr_block;
 
-                    squish::Compress( (const squish::u8*)colors, &compr_block, squish::kDxt3 );
+            squish::Compress( (const squish::u8*)colors, &compr_block, squish::kDxt5 );
 
-                    // Write it in correct endianness to the texture.
-                    dxt2_3_block <endianness> *dstBlock = (dxt2_3_block <endianness>*)dxtArray + compressedBlockCount;
+            // Write the destination block into the texture.
+            dxt4_5_block <endianness> *dstBlock = (dxt4_5_block <endianness>*)dxtArray + compressedBlockCount;
 
-                    dstBlock->alphaList = compr_block.alphaList;
-                    dstBlock->col0 = compr_block.col0;
-                    dstBlock->col1 = compr_block.col1;
-                    dstBlock->indexList = compr_block.indexList;
-                }
-                else if ( dxtType == 4 || dxtType == 5 )
-                {
-                    struct native_dxt45_block
-                    {
-                        uint8 alphaPreMult[2];
-                        uint48_t alphaList;
+            dstBlock->alphaPreMult[0] = compr_block.alphaPreMult[0];
+            dstBlock->alphaPreMult[1] = compr_block.alphaPreMult[1];
+            dstBlock->alphaList = compr_block.alphaList;
+            dstBlock->col0 = compr_block.col0;
+            dstBlock->col1 = compr_block.col1;
+            dstBlock->indexList = compr_block.indexList;
+        }
+        else
+        {
+            assert( 0 );
+        }
+
+        // Increment the block count.
+        compressedBlockCount++;
+    }
+}
+
+template <template <typename numberType> class endianness>
+inline void compressTexelsUsingDXT(
+    Interface *engineInterface,
+    uint32 dxtType, const void *texelSource, uint32 mipWidth, uint32 mipHeight, uint32 rowAlignment,
+    eRasterFormat rasterFormat, const void *paletteData, ePaletteType paletteType, uint32 maxpalette, eColorOrdering colorOrder, uint32 itemDepth,
+    void*& texelsOut, uint32& dataSizeOut,
+    uint32& realWidthOut, uint32& realHeightOut
+)
+{
+    // Make sure the texture dimensions are aligned by 4.
+    uint32 alignedMipWidth = ALIGN_SIZE( mipWidth, 4u );
+    uint32 alignedMipHeight = ALIGN_SIZE( mipHeight, 4u );
 
-                        rgb565 col0;
-                        rgb565 col1;
+    uint32 dxtDataSize = getDXTRasterDataSize(dxtType, ( alignedMipWidth * alignedMipHeight ) );
 
-                        uint32 indexList;
-                    };
-                    native_dxt45_block compr_block;
+    void *dxtArray = engineInterface->PixelAllocate( dxtDataSize );
 
-                    squish::Compress( (const squish::u8*)colors, &compr_block, squish::kDxt5 );
+    if ( !dxtArray )
+    {
+        throw RwException( "failed to allocate DXT surface in compression routine" );
+    }
+    
+    try
+    {
+        // Calculate the row size of the source texture.
+        uint32 rawRowSize = getRasterDataRowSize( mipWidth, itemDepth, rowAlignment );
 
-                    // Write the destination block into the texture.
-                    dxt4_5_block <endianness> *dstBlock = (dxt4_5_block <endianness>*)dxtArray + compressedBlockCount;
+        // Loop across the image.
+        uint32 widthBlocks = alignedMipWidth / 4;
+        uint32 heightBlocks = alignedMipHeight / 4;
 
-                    dstBlock->alphaPreMult[0] = compr_block.alphaPreMult[0];
-                    dstBlock->alphaPreMult[1] = compr_block.alphaPreMult[1];
-                    dstBlock->alphaList = compr_block.alphaList;
-                    dstBlock->col0 = compr_block.col0;
-                    dstBlock->col1 = compr_block.col1;
-                    dstBlock->indexList = compr_block.indexList;
-                }
-                else
-                {
-                    assert( 0 );
-                }
+        colorModelDispatcher fetchSrcDispatch( rasterFormat, colorOrder, itemDepth, paletteData, maxpalette, paletteType );
 
-                // Increment the block count.
-                compressedBlockCount++;
-            }
-        }
+        // Spread the block rows over the worker threads.
+        // Every block is written to a fixed location, so the result is the same as serial compression.
+        EngineInterface *rwEngine = (EngineInterface*)engineInterface;
+
+        auto compressRow = [&]( uint32 y_block )
+        {
+            compressDXTBlockRow <endianness> (
+                dxtType, texelSource, mipWidth, mipHeight, rawRowSize,
+                fetchSrcDispatch,
+                dxtArray, widthBlocks, y_block
+            );
+        };
+
+        ParallelFor( rwEngine, heightBlocks, GetParallelConcurrency( rwEngine ), compressRow );
     }
     catch( ... )
     {
@@ -387,6 +387,29 @@ void registerD3D8NativePlugin( void )
     d3dNativeTexturePluginRegister.RegisterPlugin( engineFactory );
 }
 
+bool d3d8NativeTextureTypeProvider::DeserializeTextureProperties( TextureBase *theTexture, BlockProvider& inputProvider ) const
+{
+    return readTextureNativeStructHeader <d3d8::textureMetaHeaderStructGeneric> ( inputProvider,
+        [&]( const d3d8::textureMetaHeaderStructGeneric& metaHeader )
+        {
+            if ( metaHeader.platformDescriptor != PLATFORM_D3D8 )
+            {
+                return false;
+            }
+
+            readTextureNativeNames( *theTexture, metaHeader.name, metaHeader.maskName );
+
+            texFormatInfo texFormat = metaHeader.texFormat;
+
+            texFormat.parse( *theTexture );
+
+            theTexture->SetFilterMode( getFixedFilteringMode( theTexture->GetFilterMode(), metaHeader.mipmapCount ) );
+
+            return true;
+        }
+    );
+}
+
 };
 
 #endif //RWLIB_INCLUDE_NATIVETEX_D3D8
\ No newline at end of file
@@ -191,6 +191,8 @@ struct d3d8NativeTextureTypeProvider : public texNativeTypeProvider
     void SerializeTexture( TextureBase *theTexture, PlatformTexture *nativeTex, BlockProvider& outputProvider ) const;
     void DeserializeTexture( TextureBase *theTexture, PlatformTexture *nativeTex, BlockProvider& inputProvider ) const;
 
+    bool DeserializeTextureProperties( TextureBase *theTexture, BlockProvider& inputProvider ) const;
+
     void GetPixelCapabilities( pixelCapabilities& capsOut ) const override
     {
         capsOut.supportsDXT1 = true;
@@ -715,6 +715,29 @@ void registerD3D9NativePlugin( void )
     d3dNativeTexturePluginRegister.RegisterPlugin( engineFactory );
 }
 
+bool d3d9NativeTextureTypeProvider::DeserializeTextureProperties( TextureBase *theTexture, BlockProvider& inputProvider ) const
+{
+    return readTextureNativeStructHeader <d3d9::textureMetaHeaderStructGeneric> ( inputProvider,
+        [&]( const d3d9::textureMetaHeaderStructGeneric& metaHeader )
+        {
+            if ( metaHeader.platformDescriptor != PLATFORM_D3D9 )
+            {
+                return false;
+            }
+
+            readTextureNativeNames( *theTexture, metaHeader.name, metaHeader.maskName );
+
+            texFormatInfo texFormat = metaHeader.texFormat;
+
+            texFormat.parse( *theTexture );
+
+            theTexture->SetFilterMode( getFixedFilteringMode( theTexture->GetFilterMode(), metaHeader.mipmapCount ) );
+
+            return true;
+        }
+    );
+}
+
 };
 
 #endif //RWLIB_INCLUDE_NATIVETEX_D3D9
\ No newline at end of file
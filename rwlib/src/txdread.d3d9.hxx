@@ -571,6 +571,8 @@ struct d3d9NativeTextureTypeProvider : public texNativeTypeProvider, d3dpublic::
     void SerializeTexture( TextureBase *theTexture, PlatformTexture *nativeTex, BlockProvider& outputProvider ) const override;
     void DeserializeTexture( TextureBase *theTexture, PlatformTexture *nativeTex, BlockProvider& inputProvider ) const override;
 
+    bool DeserializeTextureProperties( TextureBase *theTexture, BlockProvider& inputProvider ) const override;
+
     void GetPixelCapabilities( pixelCapabilities& capsOut ) const override
     {
         capsOut.supportsDXT1 = true;
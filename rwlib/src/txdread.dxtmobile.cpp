@@ -299,6 +299,27 @@ void registerMobileDXTNativePlugin( void )
     dxtMobileNativeTexRegister.RegisterPlugin( engineFactory );
 }
 
+bool dxtMobileNativeTextureTypeProvider::DeserializeTextureProperties( TextureBase *theTexture, BlockProvider& inputProvider ) const
+{
+    return readTextureNativeStructHeader <mobile_dxt::textureNativeGenericHeader> ( inputProvider,
+        [&]( const mobile_dxt::textureNativeGenericHeader& metaHeader )
+        {
+            if ( metaHeader.platformDescriptor != PLATFORMDESC_DXT_MOBILE )
+            {
+                return false;
+            }
+
+            readTextureNativeNames( *theTexture, metaHeader.name, metaHeader.maskName );
+
+            metaHeader.formatInfo.parse( *theTexture );
+
+            theTexture->SetFilterMode( getFixedFilteringMode( theTexture->GetFilterMode(), metaHeader.mipmapCount ) );
+
+            return true;
+        }
+    );
+}
+
 };
 
 #endif //RWLIB_INCLUDE_NATIVETEX_S3TC_MOBILE
\ No newline at end of file
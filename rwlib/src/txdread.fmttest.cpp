@@ -3,4 +3,158 @@
 
 #include "StdInc.h"
 
-// TODO.
\ No newline at end of file
+#include "pixelformat.kernels.hxx"
+
+namespace rw
+{
+
+// Enough texels to cover every byte value and the scalar tails of the vector kernels.
+#define TEXEL_TEST_COUNT    263
+
+struct testTexelFormat
+{
+    eRasterFormat rasterFormat;
+    uint32 depth;
+};
+
+static const testTexelFormat _testTexelFormats[] =
+{
+    { RASTER_1555, 16 },
+    { RASTER_555, 16 },
+    { RASTER_565, 16 },
+    { RASTER_4444, 16 },
+    { RASTER_8888, 32 },
+    { RASTER_888, 32 },
+    { RASTER_888, 24 },
+    { RASTER_LUM, 8 },
+    { RASTER_LUM_ALPHA, 8 },
+    { RASTER_LUM_ALPHA, 16 }
+};
+
+static const eColorOrdering _testColorOrders[] =
+{
+    COLOR_RGBA, COLOR_BGRA, COLOR_ABGR, COLOR_ARGB, COLOR_BARG
+};
+
+static void fillTestTexels( uint8 *data, uint32 dataSize, uint32 seed )
+{
+    uint32 lcg = ( seed * 2654435761u + 1 );
+
+    for ( uint32 n = 0; n < dataSize; n++ )
+    {
+        uint32 texelIndex = ( n / 4 );
+        uint32 byteIndex = ( n % 4 );
+
+        if ( texelIndex < 256 )
+        {
+            data[ n ] = (uint8)( texelIndex + byteIndex * 67 + seed );
+        }
+        else
+        {
+            lcg = ( lcg * 1103515245u + 12345u );
+
+            data[ n ] = (uint8)( lcg >> 16 );
+        }
+    }
+}
+
+static bool verifyKernelAgainstDispatcher( const texelRowKernelKey& key, const texelRowKernelParams& params, texelRowKernel_t kernel )
+{
+    uint8 srcTexels[ TEXEL_TEST_COUNT * 4 ];
+    uint8 genericTexels[ TEXEL_TEST_COUNT * 4 ];
+    uint8 kernelTexels[ TEXEL_TEST_COUNT * 4 ];
+
+    fillTestTexels( srcTexels, sizeof( srcTexels ), 0 );
+
+    // Bits that are not written have to stay the same.
+    fillTestTexels( genericTexels, sizeof( genericTexels ), 1 );
+    memcpy( kernelTexels, genericTexels, sizeof( kernelTexels ) );
+
+    colorModelDispatcher fetchDispatch( key.srcRasterFormat, key.srcColorOrder, key.srcDepth, NULL, 0, PALETTE_NONE );
+    colorModelDispatcher putDispatch( key.dstRasterFormat, key.dstColorOrder, key.dstDepth, NULL, 0, PALETTE_NONE );
+
+    for ( uint32 n = 0; n < TEXEL_TEST_COUNT; n++ )
+    {
+        abstractColorItem colorItem;
+
+        fetchDispatch.getColor( srcTexels, n, colorItem );
+
+        putDispatch.setColor( genericTexels, n, colorItem );
+    }
+
+    kernel( params, srcTexels, kernelTexels, TEXEL_TEST_COUNT );
+
+    uint32 dstDataSize = ( TEXEL_TEST_COUNT * params.dstLayout.byteSize );
+
+    return ( memcmp( genericTexels, kernelTexels, dstDataSize ) == 0 );
+}
+
+bool VerifyTexelRowKernels( const texelKernelEnv& kernelEnv )
+{
+    bool allMatch = true;
+
+    for ( const testTexelFormat& srcFormat : _testTexelFormats )
+    {
+        bool isSrcLum = ( getColorModelFromRasterFormat( srcFormat.rasterFormat ) == COLORMODEL_LUMINANCE );
+
+        for ( eColorOrdering srcColorOrder : _testColorOrders )
+        {
+            // Luminance formats are keyed without color order.
+            if ( isSrcLum && srcColorOrder != COLOR_RGBA )
+                continue;
+
+            for ( const testTexelFormat& dstFormat : _testTexelFormats )
+            {
+                bool isDstLum = ( getColorModelFromRasterFormat( dstFormat.rasterFormat ) == COLORMODEL_LUMINANCE );
+
+                for ( eColorOrdering dstColorOrder : _testColorOrders )
+                {
+                    if ( isDstLum && dstColorOrder != COLOR_RGBA )
+                        continue;
+
+                    texelRowKernelKey key;
+                    key.srcRasterFormat = srcFormat.rasterFormat;
+                    key.srcColorOrder = srcColorOrder;
+                    key.srcDepth = srcFormat.depth;
+                    key.dstRasterFormat = dstFormat.rasterFormat;
+                    key.dstColorOrder = dstColorOrder;
+                    key.dstDepth = dstFormat.depth;
+
+                    texelRowKernelParams params;
+
+                    if ( !PrepareTexelRowConversion( key, params ) )
+                    {
+                        allMatch = false;
+                        continue;
+                    }
+
+                    // Test the kernel that serves any format pair.
+                    if ( texelRowKernel_t portableKernel = GetPortableTexelRowKernel( params ) )
+                    {
+                        if ( !verifyKernelAgainstDispatcher( key, params, portableKernel ) )
+                        {
+                            allMatch = false;
+                        }
+                    }
+                    else
+                    {
+                        allMatch = false;
+                    }
+
+                    // Test the specialized kernel, if there is one.
+                    if ( const texelKernelEnv::kernelEntry *entry = kernelEnv.FindKernel( key ) )
+                    {
+                        if ( !verifyKernelAgainstDispatcher( key, params, entry->kernel ) )
+                        {
+                            allMatch = false;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return allMatch;
+}
+
+};
@@ -105,8 +105,149 @@ AINLINE void GCProcessTiledCoordsFromLinear(
     }
 }
 
+// Addressing of a GC native surface whose dimensions are a multiple of its tile dimensions.
+// Such a surface stores the texels of each tile row next to each other, so instead of looking up
+// the tiled coordinate of every texel we can move whole runs of texels at once.
+struct gcTileAddressing
+{
+    AINLINE gcTileAddressing( uint32 surfWidth, uint32 clusterWidth, uint32 clusterHeight, uint32 clusterCount, bool isSwizzled )
+    {
+        this->surfWidth = surfWidth;
+        this->clusterWidth = clusterWidth;
+        this->clusterHeight = clusterHeight;
+        this->clusterCount = clusterCount;
+        this->isSwizzled = isSwizzled;
+
+        this->tilesPerRow = ( surfWidth / clusterWidth );
+        this->tileItemCount = ( clusterWidth * clusterHeight );
+    }
+
+    // Returns the item index of the texel at (x, y) of the first cluster.
+    AINLINE uint32 GetItemIndex( uint32 x, uint32 y ) const
+    {
+        uint32 tile_x = ( x / this->clusterWidth );
+        uint32 local_x = ( x % this->clusterWidth );
+
+        if ( this->isSwizzled )
+        {
+            uint32 tile_y = ( y / this->clusterHeight );
+            uint32 local_y = ( y % this->clusterHeight );
+
+            uint32 tileIndex = ( tile_y * this->tilesPerRow + tile_x );
+
+            return ( tileIndex * this->clusterCount * this->tileItemCount + local_y * this->clusterWidth + local_x );
+        }
+
+        return ( ( y * this->tilesPerRow + tile_x ) * this->clusterCount * this->clusterWidth + local_x );
+    }
+
+    // Distance in items between the same texel of two neighboring clusters.
+    AINLINE uint32 GetClusterStride( void ) const
+    {
+        return ( this->isSwizzled ? this->tileItemCount : this->clusterWidth );
+    }
+
+    // Returns how many texels starting at x are stored next to each other.
+    AINLINE uint32 GetRunLength( uint32 x ) const
+    {
+        if ( !this->isSwizzled && this->clusterCount == 1 )
+        {
+            return ( this->surfWidth - x );
+        }
+
+        return ( this->clusterWidth - ( x % this->clusterWidth ) );
+    }
+
+    // Calls cb( x, y, runLength ) for every run of texels inside of the region,
+    // in the order in which they are stored.
+    template <typename callbackType>
+    AINLINE void ProcessRuns( uint32 regionWidth, uint32 regionHeight, callbackType& cb ) const
+    {
+        if ( this->isSwizzled )
+        {
+            uint32 clusterWidth = this->clusterWidth;
+            uint32 clusterHeight = this->clusterHeight;
+
+            uint32 tilesWidth = ( ALIGN_SIZE( regionWidth, clusterWidth ) / clusterWidth );
+            uint32 tilesHeight = ( ALIGN_SIZE( regionHeight, clusterHeight ) / clusterHeight );
+
+            for ( uint32 tile_y = 0; tile_y < tilesHeight; tile_y++ )
+            {
+                for ( uint32 tile_x = 0; tile_x < tilesWidth; tile_x++ )
+                {
+                    uint32 x = ( tile_x * clusterWidth );
+
+                    uint32 runLength = std::min( clusterWidth, regionWidth - x );
+
+                    for ( uint32 local_y = 0; local_y < clusterHeight; local_y++ )
+                    {
+                        uint32 y = ( tile_y * clusterHeight + local_y );
+
+                        if ( y >= regionHeight )
+                            break;
+
+                        cb( x, y, runLength );
+                    }
+                }
+            }
+        }
+        else
+        {
+            for ( uint32 y = 0; y < regionHeight; y++ )
+            {
+                uint32 x = 0;
+
+                while ( x < regionWidth )
+                {
+                    uint32 runLength = std::min( this->GetRunLength( x ), regionWidth - x );
+
+                    cb( x, y, runLength );
+
+                    x += runLength;
+                }
+            }
+        }
+    }
+
+private:
+    uint32 surfWidth;
+    uint32 clusterWidth, clusterHeight;
+    uint32 clusterCount;
+    bool isSwizzled;
+
+    uint32 tilesPerRow;
+    uint32 tileItemCount;
+};
+
+// Native surfaces that we create are always a multiple of their tile size, but we check anyway because
+// other surfaces have to be converted texel by texel to keep their exact behavior.
+AINLINE bool isGCSurfaceTileAligned(
+    uint32 surfWidth, uint32 surfHeight,
+    uint32 clusterWidth, uint32 clusterHeight,
+    uint32 layerWidth, uint32 layerHeight
+)
+{
+    return
+        ( ( surfWidth % clusterWidth ) == 0 && ( surfHeight % clusterHeight ) == 0 &&
+          layerWidth <= surfWidth && layerHeight <= surfHeight );
+}
+
 inline void DXTIndexListInverseCopy( uint32& dstIndexList, uint32 srcIndexList, uint32 blockPixelWidth, uint32 blockPixelHeight )
 {
+    if ( blockPixelWidth == 4 && blockPixelHeight == 4 )
+    {
+        // Mirroring a whole block along both axis just reverses the order of its 2bit indices.
+        uint32 indexList = srcIndexList;
+
+        indexList = ( ( indexList >> 2 ) & 0x33333333 ) | ( ( indexList & 0x33333333 ) << 2 );
+        indexList = ( ( indexList >> 4 ) & 0x0F0F0F0F ) | ( ( indexList & 0x0F0F0F0F ) << 4 );
+        indexList = ( ( indexList >> 8 ) & 0x00FF00FF ) | ( ( indexList & 0x00FF00FF ) << 8 );
+        indexList = ( indexList >> 16 ) | ( indexList << 16 );
+
+        dstIndexList = indexList;
+        return;
+    }
+
     dstIndexList = 0;
 
     for ( uint32 local_y = 0; local_y < blockPixelHeight; local_y++ )
@@ -220,8 +361,106 @@ inline void copyPaletteIndexAcrossSurfaces(
     }
 }
 
+// Copies a run of palette indices the same way copyPaletteItemGeneric does for each of them.
+inline void copyPaletteIndexRun(
+    const void *srcTexels, uint32 srcIndex, uint32 srcDepth, ePaletteType srcPaletteType,
+    void *dstTexels, uint32 dstIndex, uint32 dstDepth, ePaletteType dstPaletteType,
+    uint32 paletteSize, uint32 itemCount
+)
+{
+    if ( srcDepth == dstDepth && srcPaletteType == dstPaletteType )
+    {
+        if ( srcDepth == 8 && srcPaletteType == PALETTE_8BIT )
+        {
+            const uint8 *srcItems = ( (const uint8*)srcTexels + srcIndex );
+            uint8 *dstItems = ( (uint8*)dstTexels + dstIndex );
+
+            for ( uint32 n = 0; n < itemCount; n++ )
+            {
+                uint8 palIndex = srcItems[ n ];
+
+                // Indices outside of the palette are cleared.
+                dstItems[ n ] = ( palIndex < paletteSize ? palIndex : 0 );
+            }
+
+            return;
+        }
+
+        if ( srcDepth == 4 && ( srcPaletteType == PALETTE_4BIT || srcPaletteType == PALETTE_4BIT_LSB ) &&
+             ( srcIndex % 2 ) == 0 && ( dstIndex % 2 ) == 0 )
+        {
+            // Both nibbles of a byte belong to the same palette, so their order does not matter.
+            const uint8 *srcItems = ( (const uint8*)srcTexels + srcIndex / 2 );
+            uint8 *dstItems = ( (uint8*)dstTexels + dstIndex / 2 );
+
+            uint32 byteCount = ( itemCount / 2 );
+
+            for ( uint32 n = 0; n < byteCount; n++ )
+            {
+                uint8 srcByte = srcItems[ n ];
+
+                uint8 lowIndex = ( srcByte & 0x0F );
+                uint8 highIndex = ( srcByte >> 4 );
+
+                if ( lowIndex >= paletteSize )
+                {
+                    lowIndex = 0;
+                }
+
+                if ( highIndex >= paletteSize )
+                {
+                    highIndex = 0;
+                }
+
+                dstItems[ n ] = ( lowIndex | ( highIndex << 4 ) );
+            }
+
+            // Leave the last index to the generic path.
+            srcIndex += byteCount * 2;
+            dstIndex += byteCount * 2;
+            itemCount -= byteCount * 2;
+        }
+    }
+
+    for ( uint32 n = 0; n < itemCount; n++ )
+    {
+        copyPaletteItemGeneric(
+            srcTexels, dstTexels,
+            srcIndex + n, srcDepth, srcPaletteType,
+            dstIndex + n, dstDepth, dstPaletteType,
+            paletteSize
+        );
+    }
+}
+
 typedef dxt1_block <endian::big_endian> gc_dxt1_block;
 
+// Copies a DXT1 block between the Gamecube and the framework layout.
+// The Gamecube stores the indices of a block mirrored.
+template <typename dstBlockType, typename srcBlockType>
+AINLINE void GCCopyDXT1Block( dstBlockType *dstBlock, const srcBlockType *srcBlock )
+{
+    dstBlock->col0 = srcBlock->col0;
+    dstBlock->col1 = srcBlock->col1;
+
+    uint32 dstIndexList = 0;
+
+    DXTIndexListInverseCopy( dstIndexList, srcBlock->indexList, 4u, 4u );
+
+    dstBlock->indexList = dstIndexList;
+}
+
+template <typename blockType>
+AINLINE void GCClearDXT1Block( blockType *dstBlock )
+{
+    rgb565 clearColor;
+    clearColor.val = 0;
+
+    dstBlock->col0 = clearColor;
+    dstBlock->col1 = clearColor;
+    dstBlock->indexList = 0;
+}
+
 inline void ConvertGCMipmapToRasterFormat(
     Interface *engineInterface,
     uint32 mipWidth, uint32 mipHeight, uint32 layerWidth, uint32 layerHeight, void *texelSource, uint32 dataSize,
@@ -272,7 +511,29 @@ inline void ConvertGCMipmapToRasterFormat(
         {
             uint32 srcRowSize = getGCRasterDataRowSize( mipWidth, srcDepth );
 
-            if ( internalFormat == GVRFMT_PAL_4BIT || internalFormat == GVRFMT_PAL_8BIT )
+            // If the native surface is made of whole tiles, we can move tile row by tile row.
+            bool isTileAligned = isGCSurfaceTileAligned( mipWidth, mipHeight, clusterWidth, clusterHeight, layerWidth, layerHeight );
+
+            if ( ( internalFormat == GVRFMT_PAL_4BIT || internalFormat == GVRFMT_PAL_8BIT ) && isTileAligned )
+            {
+                assert( paletteType != PALETTE_NONE );
+
+                gcTileAddressing srcTiles( mipWidth, clusterWidth, clusterHeight, 1, true );
+
+                srcTiles.ProcessRuns(
+                    layerWidth, layerHeight,
+                    [&]( uint32 x, uint32 y, uint32 runLength )
+                {
+                    void *dstRow = getTexelDataRow( dstTexels, dstRowSize, y );
+
+                    copyPaletteIndexRun(
+                        texelSource, srcTiles.GetItemIndex( x, y ), srcDepth, paletteType,
+                        dstRow, x, dstDepth, paletteType,
+                        paletteSize, runLength
+                    );
+                });
+            }
+            else if ( internalFormat == GVRFMT_PAL_4BIT || internalFormat == GVRFMT_PAL_8BIT )
             {
                 assert( paletteType != PALETTE_NONE );
 
@@ -320,51 +581,96 @@ inline void ConvertGCMipmapToRasterFormat(
                 uint32 clusterGCItemWidth = mipWidth * clusterCount;
                 uint32 clusterGCItemHeight = mipHeight;
 
-                GCProcessRandomAccessTileSurface(
-                    mipWidth, mipHeight,
-                    clusterWidth, clusterHeight, clusterCount,
-                    isFormatSwizzled,
-                    [&]( uint32 dst_pos_x, uint32 dst_pos_y, uint32 src_pos_x, uint32 src_pos_y, uint32 cluster_index )
+                if ( isTileAligned )
                 {
-                    // We are unswizzling.
-                    if ( dst_pos_x < layerWidth && dst_pos_y < layerHeight )
-                    {
-                        // Just do a naive movement for now.
-                        void *dstRow = getTexelDataRow( dstTexels, dstRowSize, dst_pos_y );
+                    gcTileAddressing srcTiles( mipWidth, clusterWidth, clusterHeight, clusterCount, isFormatSwizzled );
 
-                        abstractColorItem colorItem;
+                    uint32 clusterStride = srcTiles.GetClusterStride();
 
-                        bool hasColor = false;
+                    srcTiles.ProcessRuns(
+                        layerWidth, layerHeight,
+                        [&]( uint32 x, uint32 y, uint32 runLength )
+                    {
+                        void *dstRow = getTexelDataRow( dstTexels, dstRowSize, y );
 
-                        if ( src_pos_x < clusterGCItemWidth && src_pos_y < clusterGCItemHeight )
+                        uint32 srcItemIndex = srcTiles.GetItemIndex( x, y );
+
+                        // Clusters are processed one after the other, just like in the texel-by-texel path,
+                        // because the second cluster of RGBA8888 builds on what the first one wrote.
+                        for ( uint32 cluster_index = 0; cluster_index < clusterCount; cluster_index++ )
                         {
-                            const void *srcRow = getConstTexelDataRow( texelSource, srcRowSize, src_pos_y );
+                            for ( uint32 n = 0; n < runLength; n++ )
+                            {
+                                uint32 dst_pos_x = ( x + n );
 
-                            readGCNativeColor(
-                                srcRow, srcDispatch, src_pos_x,
-                                cluster_index,
-                                [&]( abstractColorItem& colorItem )
-                                {
-                                    // We want to update the color with green and blue.
-                                    dstDispatch.getColor( dstRow, dst_pos_x, colorItem );
+                                abstractColorItem colorItem;
 
-                                    assert( colorItem.model == COLORMODEL_RGBA );
-                                }, colorItem
-                            );
+                                readGCNativeColor(
+                                    texelSource, srcDispatch, srcItemIndex + n,
+                                    cluster_index,
+                                    [&]( abstractColorItem& colorItem )
+                                    {
+                                        dstDispatch.getColor( dstRow, dst_pos_x, colorItem );
+
+                                        assert( colorItem.model == COLORMODEL_RGBA );
+                                    }, colorItem
+                                );
 
-                            hasColor = true;
+                                dstDispatch.setColor( dstRow, dst_pos_x, colorItem );
+                            }
+
+                            srcItemIndex += clusterStride;
                         }
-                    
-                        if ( !hasColor )
+                    });
+                }
+                else
+                {
+                    GCProcessRandomAccessTileSurface(
+                        mipWidth, mipHeight,
+                        clusterWidth, clusterHeight, clusterCount,
+                        isFormatSwizzled,
+                        [&]( uint32 dst_pos_x, uint32 dst_pos_y, uint32 src_pos_x, uint32 src_pos_y, uint32 cluster_index )
+                    {
+                        // We are unswizzling.
+                        if ( dst_pos_x < layerWidth && dst_pos_y < layerHeight )
                         {
-                            // If we could not get a valid color, we set it to cleared state.
-                            dstDispatch.setClearedColor( colorItem );
-                        }
+                            // Just do a naive movement for now.
+                            void *dstRow = getTexelDataRow( dstTexels, dstRowSize, dst_pos_y );
 
-                        // Put the destination color.
-                        dstDispatch.setColor( dstRow, dst_pos_x, colorItem );
-                    }
-                });
+                            abstractColorItem colorItem;
+
+                            bool hasColor = false;
+
+                            if ( src_pos_x < clusterGCItemWidth && src_pos_y < clusterGCItemHeight )
+                            {
+                                const void *srcRow = getConstTexelDataRow( texelSource, srcRowSize, src_pos_y );
+
+                                readGCNativeColor(
+                                    srcRow, srcDispatch, src_pos_x,
+                                    cluster_index,
+                                    [&]( abstractColorItem& colorItem )
+                                    {
+                                        // We want to update the color with green and blue.
+                                        dstDispatch.getColor( dstRow, dst_pos_x, colorItem );
+
+                                        assert( colorItem.model == COLORMODEL_RGBA );
+                                    }, colorItem
+                                );
+
+                                hasColor = true;
+                            }
+                    
+                            if ( !hasColor )
+                            {
+                                // If we could not get a valid color, we set it to cleared state.
+                                dstDispatch.setClearedColor( colorItem );
+                            }
+
+                            // Put the destination color.
+                            dstDispatch.setColor( dstRow, dst_pos_x, colorItem );
+                        }
+                    });
+                }
             }
         }
         catch( ... )
@@ -423,50 +729,73 @@ inline void ConvertGCMipmapToRasterFormat(
 
             frm_dxt1_block *dstBlocks = (frm_dxt1_block*)dstTexels;
 
-            memcodec::permutationUtilities::ProcessTextureLayerPackedTiles(
-                gcBlocksWidth, gcBlocksHeight,
-                2, 2,
-                1,
-                [&]( uint32 dst_pos_x, uint32 dst_pos_y, uint32 src_pos_x, uint32 src_pos_y, uint32 cluster_index )
+            // Each 8x8 tile of the native surface stores 2x2 DXT1 blocks one after the other.
+            bool isTileAligned = isGCSurfaceTileAligned( gcBlocksWidth, gcBlocksHeight, 2, 2, dxtBlocksWidth, dxtBlocksHeight );
+
+            if ( isTileAligned )
             {
-                // We unswizzle.
-                if ( dst_pos_x < dxtBlocksWidth && dst_pos_y < dxtBlocksHeight )
-                {
-                    // Get the destination block ptr.
-                    uint32 dstBlockIndex = ( dst_pos_x + dst_pos_y * dxtBlocksWidth );
+                uint32 gcTilesWidth = ( gcBlocksWidth / 2 );
 
-                    frm_dxt1_block *dstBlock = ( dstBlocks + dstBlockIndex );
+                uint32 dxtTilesWidth = ( ALIGN_SIZE( dxtBlocksWidth, 2u ) / 2 );
+                uint32 dxtTilesHeight = ( ALIGN_SIZE( dxtBlocksHeight, 2u ) / 2 );
 
-                    // Attempt to get the source block.
-                    if ( src_pos_x < gcBlocksWidth && src_pos_y < gcBlocksHeight )
+                for ( uint32 tile_y = 0; tile_y < dxtTilesHeight; tile_y++ )
+                {
+                    for ( uint32 tile_x = 0; tile_x < dxtTilesWidth; tile_x++ )
                     {
-                        uint32 srcBlockIndex = ( src_pos_x + src_pos_y * gcBlocksWidth );
+                        const gc_dxt1_block *srcTileBlocks = ( gcBlocks + ( tile_y * gcTilesWidth + tile_x ) * 4 );
 
-                        const gc_dxt1_block *srcBlock = ( gcBlocks + srcBlockIndex );
+                        for ( uint32 local_y = 0; local_y < 2; local_y++ )
+                        {
+                            uint32 dst_pos_y = ( tile_y * 2 + local_y );
 
-                        // Copy things over properly.
-                        dstBlock->col0 = srcBlock->col0;
-                        dstBlock->col1 = srcBlock->col1;
+                            if ( dst_pos_y >= dxtBlocksHeight )
+                                break;
 
-                        // The index list needs special handling.
-                        uint32 dstIndexList = 0;
+                            for ( uint32 local_x = 0; local_x < 2; local_x++ )
+                            {
+                                uint32 dst_pos_x = ( tile_x * 2 + local_x );
 
-                        DXTIndexListInverseCopy( dstIndexList, srcBlock->indexList, dxt_blockPixelWidth, dxt_blockPixelHeight );
+                                if ( dst_pos_x >= dxtBlocksWidth )
+                                    break;
 
-                        dstBlock->indexList = dstIndexList;
+                                GCCopyDXT1Block( dstBlocks + ( dst_pos_x + dst_pos_y * dxtBlocksWidth ), srcTileBlocks + ( local_x + local_y * 2 ) );
+                            }
+                        }
                     }
-                    else
+                }
+            }
+            else
+            {
+                memcodec::permutationUtilities::ProcessTextureLayerPackedTiles(
+                    gcBlocksWidth, gcBlocksHeight,
+                    2, 2,
+                    1,
+                    [&]( uint32 dst_pos_x, uint32 dst_pos_y, uint32 src_pos_x, uint32 src_pos_y, uint32 cluster_index )
+                {
+                    // We unswizzle.
+                    if ( dst_pos_x < dxtBlocksWidth && dst_pos_y < dxtBlocksHeight )
                     {
-                        // We sort of just clear our block.
-                        rgb565 clearColor;
-                        clearColor.val = 0;
+                        // Get the destination block ptr.
+                        uint32 dstBlockIndex = ( dst_pos_x + dst_pos_y * dxtBlocksWidth );
+
+                        frm_dxt1_block *dstBlock = ( dstBlocks + dstBlockIndex );
 
-                        dstBlock->col0 = clearColor;
-                        dstBlock->col1 = clearColor;
-                        dstBlock->indexList = 0;
+                        // Attempt to get the source block.
+                        if ( src_pos_x < gcBlocksWidth && src_pos_y < gcBlocksHeight )
+                        {
+                            uint32 srcBlockIndex = ( src_pos_x + src_pos_y * gcBlocksWidth );
+
+                            GCCopyDXT1Block( dstBlock, gcBlocks + srcBlockIndex );
+                        }
+                        else
+                        {
+                            // We sort of just clear our block.
+                            GCClearDXT1Block( dstBlock );
+                        }
                     }
-                }
-            });
+                });
+            }
 
             // We successfully converted!
         }
@@ -606,23 +935,35 @@ inline void TranscodeIntoNativeGCLayer(
                 assert( dstPaletteType != PALETTE_NONE );
 
                 // Transform palette indice.
-                GCProcessRandomAccessTileSurface(
+                // We write the native surface in the order it is stored, tile row by tile row.
+                gcTileAddressing dstTiles( gcSurfWidth, clusterWidth, clusterHeight, 1, true );
+
+                dstTiles.ProcessRuns(
                     gcSurfWidth, gcSurfHeight,
-                    clusterWidth, clusterHeight,
-                    1,
-                    true,
-                    [&]( uint32 src_pos_x, uint32 src_pos_y, uint32 dst_pos_x, uint32 dst_pos_y, uint32 cluster_index )
+                    [&]( uint32 x, uint32 y, uint32 runLength )
                 {
-                    // We are swizzling.
-                    copyPaletteIndexAcrossSurfaces(
-                        srcTexels, layerWidth, layerHeight, srcRowSize,
-                        gcTexels, gcSurfWidth, gcSurfHeight, gcRowSize,
-                        src_pos_x, src_pos_y,
-                        dst_pos_x, dst_pos_y,
-                        srcDepth, srcPaletteType,
-                        nativeDepth, dstPaletteType,
-                        srcPaletteSize
-                    );
+                    uint32 dstItemIndex = dstTiles.GetItemIndex( x, y );
+
+                    uint32 srcRunLength = 0;
+
+                    if ( x < layerWidth && y < layerHeight )
+                    {
+                        srcRunLength = std::min( runLength, layerWidth - x );
+
+                        const void *srcRow = getConstTexelDataRow( srcTexels, srcRowSize, y );
+
+                        copyPaletteIndexRun(
+                            srcRow, x, srcDepth, srcPaletteType,
+                            gcTexels, dstItemIndex, nativeDepth, dstPaletteType,
+                            srcPaletteSize, srcRunLength
+                        );
+                    }
+
+                    // Clear the indices that are not covered by the layer.
+                    for ( uint32 n = srcRunLength; n < runLength; n++ )
+                    {
+                        setpaletteindex( gcTexels, dstItemIndex + n, nativeDepth, dstPaletteType, 0 );
+                    }
                 });
             }
             else
@@ -643,52 +984,54 @@ inline void TranscodeIntoNativeGCLayer(
                     0, PALETTE_NONE, NULL, 0
                 );
 
-                // Set up valid clustered dimensions.
-                uint32 clusterGCItemWidth = gcSurfWidth * clusterCount;
-                uint32 clusterGCItemHeight = gcSurfHeight;
-
                 // Process the color data.
-                GCProcessRandomAccessTileSurface(
-                    gcSurfWidth, gcSurfHeight,
-                    clusterWidth, clusterHeight,
-                    clusterCount,
-                    isSurfaceSwizzled,
-                    [&]( uint32 src_pos_x, uint32 src_pos_y, uint32 dst_pos_x, uint32 dst_pos_y, uint32 cluster_index )
-                {
-                    // We are swizzling.
-                    if ( dst_pos_x < clusterGCItemWidth && dst_pos_y < clusterGCItemHeight )
-                    {
-                        // Pretty dangerous to intermix cluster dimensions with regular dimensions.
-                        // But it works here because the y dimension is left untouched.
-                        void *dstRow = getTexelDataRow( gcTexels, gcRowSize, dst_pos_y );
+                // We write the native surface in the order it is stored, tile row by tile row.
+                gcTileAddressing dstTiles( gcSurfWidth, clusterWidth, clusterHeight, clusterCount, isSurfaceSwizzled );
 
-                        // Get the color to put into the row.
-                        abstractColorItem colorItem;
-                        bool gotColor = false;
+                uint32 clusterStride = dstTiles.GetClusterStride();
 
-                        if ( src_pos_x < layerWidth && src_pos_y < layerHeight )
-                        {
-                            const void *srcRow = getConstTexelDataRow( srcTexels, srcRowSize, src_pos_y );
+                dstTiles.ProcessRuns(
+                    gcSurfWidth, gcSurfHeight,
+                    [&]( uint32 x, uint32 y, uint32 runLength )
+                {
+                    const void *srcRow = NULL;
+                    uint32 srcRunLength = 0;
 
-                            srcDispatch.getColor( srcRow, src_pos_x, colorItem );
+                    if ( x < layerWidth && y < layerHeight )
+                    {
+                        srcRow = getConstTexelDataRow( srcTexels, srcRowSize, y );
+                        srcRunLength = std::min( runLength, layerWidth - x );
+                    }
 
-                            gotColor = true;
-                        }
+                    uint32 dstItemIndex = dstTiles.GetItemIndex( x, y );
 
-                        // If we could not get a color, we just put a cleared one.
-                        if ( !gotColor )
+                    for ( uint32 cluster_index = 0; cluster_index < clusterCount; cluster_index++ )
+                    {
+                        for ( uint32 n = 0; n < runLength; n++ )
                         {
-                            srcDispatch.setClearedColor( colorItem );
+                            // Get the color to put into the row.
+                            // If we could not get a color, we just put a cleared one.
+                            abstractColorItem colorItem;
+
+                            if ( n < srcRunLength )
+                            {
+                                srcDispatch.getColor( srcRow, x + n, colorItem );
+                            }
+                            else
+                            {
+                                srcDispatch.setClearedColor( colorItem );
+                            }
+
+                            // Write properly into the destination.
+                            // The important tidbit is that we need to double-cluster the RGBA8888 format.
+                            writeGCNativeColor(
+                                gcTexels, dstDispatch, dstItemIndex + n,
+                                cluster_index,
+                                colorItem
+                            );
                         }
 
-                        // Write properly into the destination.
-                        // The important tidbit is that we need to double-cluster the RGBA8888 format.
-                        
-                        writeGCNativeColor(
-                            dstRow, dstDispatch, dst_pos_x,
-                            cluster_index,
-                            colorItem
-                        );
+                        dstItemIndex += clusterStride;
                     }
                 });
             }
@@ -744,48 +1087,42 @@ inline void TranscodeIntoNativeGCLayer(
             gc_dxt1_block *dstBlocks = (gc_dxt1_block*)gcTexels;
 
             // Process the framework DXT1 structs into native GC DXT1 structs.
-            memcodec::permutationUtilities::ProcessTextureLayerPackedTiles(
-                gcDXTBlocksWidth, gcDXTBlocksHeight,
-                2, 2,
-                1,
-                [&]( uint32 src_pos_x, uint32 src_pos_y, uint32 dst_pos_x, uint32 dst_pos_y, uint32 cluster_index )
-            {
-                // We are swizzling.
-                if ( dst_pos_x < gcDXTBlocksWidth && dst_pos_y < gcDXTBlocksHeight )
-                {
-                    // Get the destination block ptr.
-                    uint32 dstBlockIndex = ( dst_pos_x + gcDXTBlocksWidth * dst_pos_y );
+            // Each 8x8 tile of the native surface stores 2x2 DXT1 blocks one after the other,
+            // so we write the native surface from front to back.
+            uint32 gcTilesWidth = ( gcDXTBlocksWidth / 2 );
+            uint32 gcTilesHeight = ( gcDXTBlocksHeight / 2 );
 
-                    gc_dxt1_block *dstBlock = ( dstBlocks + dstBlockIndex );
+            gc_dxt1_block *dstBlock = dstBlocks;
 
-                    if ( src_pos_x < srcDXTBlocksWidth && src_pos_y < srcDXTBlocksHeight )
+            for ( uint32 tile_y = 0; tile_y < gcTilesHeight; tile_y++ )
+            {
+                for ( uint32 tile_x = 0; tile_x < gcTilesWidth; tile_x++ )
+                {
+                    for ( uint32 local_y = 0; local_y < 2; local_y++ )
                     {
-                        uint32 srcBlockIndex = ( src_pos_x + srcDXTBlocksWidth * src_pos_y );
-
-                        const frm_dxt1_block *srcBlock = ( (const frm_dxt1_block*)srcTexels + srcBlockIndex );
+                        uint32 src_pos_y = ( tile_y * 2 + local_y );
 
-                        dstBlock->col0 = srcBlock->col0;
-                        dstBlock->col1 = srcBlock->col1;
-                        
-                        // Indexlist needs special handling.
-                        uint32 dstIndexList = 0;
+                        for ( uint32 local_x = 0; local_x < 2; local_x++ )
+                        {
+                            uint32 src_pos_x = ( tile_x * 2 + local_x );
 
-                        DXTIndexListInverseCopy( dstIndexList, srcBlock->indexList, dxt_blockPixelWidth, dxt_blockPixelHeight );
+                            if ( src_pos_x < srcDXTBlocksWidth && src_pos_y < srcDXTBlocksHeight )
+                            {
+                                uint32 srcBlockIndex = ( src_pos_x + srcDXTBlocksWidth * src_pos_y );
 
-                        dstBlock->indexList = dstIndexList;
-                    }
-                    else
-                    {
-                        // Just clear the block.
-                        rgb565 clearColor;
-                        clearColor.val = 0;
+                                GCCopyDXT1Block( dstBlock, srcBlocks + srcBlockIndex );
+                            }
+                            else
+                            {
+                                // Just clear the block.
+                                GCClearDXT1Block( dstBlock );
+                            }
 
-                        dstBlock->col0 = clearColor;
-                        dstBlock->col1 = clearColor;
-                        dstBlock->indexList = 0;
+                            dstBlock++;
+                        }
                     }
                 }
-            });
+            }
         }
         catch( ... )
         {
@@ -846,118 +1183,232 @@ inline void TransformRawGCMipmapLayer(
 
     try
     {
-        for ( uint32 layerY = 0; layerY < layerHeight; layerY++ )
+        bool isPaletteFormat = ( dstInternalFormat == GVRFMT_PAL_4BIT || dstInternalFormat == GVRFMT_PAL_8BIT );
+
+        // The destination surface is made of whole tiles. If the source surface is too, we can
+        // move texels tile row by tile row.
+        bool isTileAligned = isGCSurfaceTileAligned( srcMipWidth, srcMipHeight, srcClusterWidth, srcClusterHeight, layerWidth, layerHeight );
+
+        if ( isTileAligned )
         {
-            for ( uint32 layerX = 0; layerX < layerWidth; layerX++ )
+            gcTileAddressing srcTiles( srcMipWidth, srcClusterWidth, srcClusterHeight, srcClusterCount, isSrcFormatSwizzled );
+            gcTileAddressing dstTiles( dstMipWidth, dstClusterWidth, dstClusterHeight, dstClusterCount, isDstFormatSwizzled );
+
+            uint32 srcClusterStride = srcTiles.GetClusterStride();
+            uint32 dstClusterStride = dstTiles.GetClusterStride();
+
+            if ( isPaletteFormat )
             {
-                if ( dstInternalFormat == GVRFMT_PAL_4BIT || dstInternalFormat == GVRFMT_PAL_8BIT )
-                {
-                    assert( srcInternalFormat == GVRFMT_PAL_4BIT || srcInternalFormat == GVRFMT_PAL_8BIT );
+                assert( srcInternalFormat == GVRFMT_PAL_4BIT || srcInternalFormat == GVRFMT_PAL_8BIT );
 
-                    // This is a pretty simple depth item one-cluster copy operation!
-                    assert( srcClusterCount == 1 && dstClusterCount == 1 );
+                // This is a pretty simple depth item one-cluster copy operation!
+                assert( srcClusterCount == 1 && dstClusterCount == 1 );
 
-                    const ePaletteType srcPaletteType = getPaletteTypeFromGCNativeFormat( srcInternalFormat );
+                const ePaletteType srcPaletteType = getPaletteTypeFromGCNativeFormat( srcInternalFormat );
+                const ePaletteType dstPaletteType = getPaletteTypeFromGCNativeFormat( dstInternalFormat );
 
-                    assert( srcPaletteType != PALETTE_NONE );
+                assert( srcPaletteType != PALETTE_NONE );
+                assert( dstPaletteType != PALETTE_NONE );
+                assert( srcPaletteType == dstPaletteType );
 
-                    const ePaletteType dstPaletteType = getPaletteTypeFromGCNativeFormat( dstInternalFormat );
+                dstTiles.ProcessRuns(
+                    layerWidth, layerHeight,
+                    [&]( uint32 x, uint32 y, uint32 runLength )
+                {
+                    uint32 dstItemIndex = dstTiles.GetItemIndex( x, y );
 
-                    assert( dstPaletteType != PALETTE_NONE );
-                    assert( srcPaletteType == dstPaletteType );
+                    // A destination run can span multiple source tiles.
+                    uint32 n = 0;
 
-                    // Get the source coordinate.
-                    uint32 src_tiled_x, src_tiled_y;
+                    while ( n < runLength )
+                    {
+                        uint32 srcRunLength = std::min( srcTiles.GetRunLength( x + n ), runLength - n );
 
-                    GCGetTiledCoordFromLinear(
-                        layerX, layerY,
-                        srcMipWidth, srcMipHeight,
-                        srcClusterWidth, srcClusterHeight,
-                        isSrcFormatSwizzled,
-                        src_tiled_x, src_tiled_y
-                    );
+                        copyPaletteIndexRun(
+                            srcTexels, srcTiles.GetItemIndex( x + n, y ), srcDepth, srcPaletteType,
+                            dstTexels, dstItemIndex + n, dstDepth, dstPaletteType,
+                            paletteSize, srcRunLength
+                        );
 
-                    // Get the destination coordinate.
-                    uint32 dst_tiled_x, dst_tiled_y;
+                        n += srcRunLength;
+                    }
+                });
+            }
+            else
+            {
+                assert( srcInternalFormat != GVRFMT_PAL_4BIT && srcInternalFormat != GVRFMT_PAL_8BIT );
 
-                    GCGetTiledCoordFromLinear(
-                        layerX, layerY,
-                        dstMipWidth, dstMipHeight,
-                        dstClusterWidth, dstClusterHeight,
-                        isDstFormatSwizzled,
-                        dst_tiled_x, dst_tiled_y
-                    );
+                gcColorDispatch srcDispatch(
+                    srcInternalFormat, GVRPIX_NO_PALETTE, COLOR_RGBA,
+                    0, PALETTE_NONE, NULL, 0
+                );
 
-                    // Copy the item.
-                    copyPaletteIndexAcrossSurfaces(
-                        srcTexels, srcMipWidth, srcMipHeight, srcRowSize,
-                        dstTexels, dstMipWidth, dstMipHeight, dstRowSize,
-                        src_tiled_x, src_tiled_y,
-                        dst_tiled_x, dst_tiled_y,
-                        srcDepth, srcPaletteType,
-                        dstDepth, dstPaletteType,
-                        paletteSize
-                    );
-                }
-                else
+                gcColorDispatch dstDispatch(
+                    dstInternalFormat, GVRPIX_NO_PALETTE, COLOR_RGBA,
+                    0, PALETTE_NONE, NULL, 0
+                );
+
+                dstTiles.ProcessRuns(
+                    layerWidth, layerHeight,
+                    [&]( uint32 x, uint32 y, uint32 runLength )
                 {
-                    assert( srcInternalFormat != GVRFMT_PAL_4BIT && srcInternalFormat != GVRFMT_PAL_8BIT );
+                    uint32 dstItemIndex = dstTiles.GetItemIndex( x, y );
 
-                    gcColorDispatch srcDispatch(
-                        srcInternalFormat, GVRPIX_NO_PALETTE, COLOR_RGBA,
-                        0, PALETTE_NONE, NULL, 0
-                    );
+                    // A destination run can span multiple source tiles.
+                    uint32 n = 0;
 
-                    gcColorDispatch dstDispatch(
-                        dstInternalFormat, GVRPIX_NO_PALETTE, COLOR_RGBA,
-                        0, PALETTE_NONE, NULL, 0
-                    );
+                    while ( n < runLength )
+                    {
+                        uint32 srcRunLength = std::min( srcTiles.GetRunLength( x + n ), runLength - n );
 
-                    // Get the color from the source.
-                    abstractColorItem colorItem;
-                    colorItem.setClearedColor( COLORMODEL_RGBA );   // for safety we start with a cleared color.
+                        uint32 srcItemIndex = srcTiles.GetItemIndex( x + n, y );
 
-                    GCProcessTiledCoordsFromLinear(
-                        layerX, layerY, srcMipWidth, srcMipHeight,
-                        srcClusterWidth, srcClusterHeight, srcClusterCount,
-                        isSrcFormatSwizzled,
-                        [&]( uint32 tiled_x, uint32 tiled_y, uint32 cluster_index )
-                    {
-                        // Safety is a big concern of mine.
-                        if ( tiled_x < srcMipWidth * srcClusterCount && tiled_y < srcMipHeight )
+                        for ( uint32 m = 0; m < srcRunLength; m++ )
                         {
-                            const void *srcRow = getConstTexelDataRow( srcTexels, srcRowSize, tiled_y );
-
-                            readGCNativeColor(
-                                srcRow, srcDispatch, tiled_x,
-                                cluster_index,
-                                []( abstractColorItem& colorItem ){},   // nothing to do here.
-                                colorItem
-                            );
+                            // Get the color from all source clusters.
+                            abstractColorItem colorItem;
+                            colorItem.setClearedColor( COLORMODEL_RGBA );   // for safety we start with a cleared color.
+
+                            for ( uint32 cluster_index = 0; cluster_index < srcClusterCount; cluster_index++ )
+                            {
+                                readGCNativeColor(
+                                    srcTexels, srcDispatch, srcItemIndex + cluster_index * srcClusterStride + m,
+                                    cluster_index,
+                                    []( abstractColorItem& colorItem ){},   // nothing to do here.
+                                    colorItem
+                                );
+                            }
+
+                            // Put it into all destination clusters.
+                            for ( uint32 cluster_index = 0; cluster_index < dstClusterCount; cluster_index++ )
+                            {
+                                writeGCNativeColor(
+                                    dstTexels, dstDispatch, dstItemIndex + cluster_index * dstClusterStride + n + m,
+                                    cluster_index, colorItem
+                                );
+                            }
                         }
-                    });
 
-                    // Now the source color should be properly initialized.
-                    // We should put it into the destination slot.
+                        n += srcRunLength;
+                    }
+                });
+            }
+        }
+        else
+        {
+            for ( uint32 layerY = 0; layerY < layerHeight; layerY++ )
+            {
+                for ( uint32 layerX = 0; layerX < layerWidth; layerX++ )
+                {
+                    if ( dstInternalFormat == GVRFMT_PAL_4BIT || dstInternalFormat == GVRFMT_PAL_8BIT )
+                    {
+                        assert( srcInternalFormat == GVRFMT_PAL_4BIT || srcInternalFormat == GVRFMT_PAL_8BIT );
+
+                        // This is a pretty simple depth item one-cluster copy operation!
+                        assert( srcClusterCount == 1 && dstClusterCount == 1 );
+
+                        const ePaletteType srcPaletteType = getPaletteTypeFromGCNativeFormat( srcInternalFormat );
+
+                        assert( srcPaletteType != PALETTE_NONE );
+
+                        const ePaletteType dstPaletteType = getPaletteTypeFromGCNativeFormat( dstInternalFormat );
+
+                        assert( dstPaletteType != PALETTE_NONE );
+                        assert( srcPaletteType == dstPaletteType );
+
+                        // Get the source coordinate.
+                        uint32 src_tiled_x, src_tiled_y;
+
+                        GCGetTiledCoordFromLinear(
+                            layerX, layerY,
+                            srcMipWidth, srcMipHeight,
+                            srcClusterWidth, srcClusterHeight,
+                            isSrcFormatSwizzled,
+                            src_tiled_x, src_tiled_y
+                        );
+
+                        // Get the destination coordinate.
+                        uint32 dst_tiled_x, dst_tiled_y;
+
+                        GCGetTiledCoordFromLinear(
+                            layerX, layerY,
+                            dstMipWidth, dstMipHeight,
+                            dstClusterWidth, dstClusterHeight,
+                            isDstFormatSwizzled,
+                            dst_tiled_x, dst_tiled_y
+                        );
 
-                    GCProcessTiledCoordsFromLinear(
-                        layerX, layerY, dstMipWidth, dstMipHeight,
-                        dstClusterWidth, dstClusterHeight, dstClusterCount,
-                        isDstFormatSwizzled,
-                        [&]( uint32 tiled_x, uint32 tiled_y, uint32 cluster_index )
+                        // Copy the item.
+                        copyPaletteIndexAcrossSurfaces(
+                            srcTexels, srcMipWidth, srcMipHeight, srcRowSize,
+                            dstTexels, dstMipWidth, dstMipHeight, dstRowSize,
+                            src_tiled_x, src_tiled_y,
+                            dst_tiled_x, dst_tiled_y,
+                            srcDepth, srcPaletteType,
+                            dstDepth, dstPaletteType,
+                            paletteSize
+                        );
+                    }
+                    else
                     {
-                        if ( tiled_x < dstMipWidth * dstClusterCount && tiled_y < dstMipHeight )
-                        {
-                            void *dstRow = getTexelDataRow( dstTexels, dstRowSize, tiled_y );
+                        assert( srcInternalFormat != GVRFMT_PAL_4BIT && srcInternalFormat != GVRFMT_PAL_8BIT );
 
-                            // Put the color, I guess.
-                            // Or what we want to put from it anyway.
-                            writeGCNativeColor(
-                                dstRow, dstDispatch, tiled_x,
-                                cluster_index, colorItem
-                            );
-                        }
-                    });
+                        gcColorDispatch srcDispatch(
+                            srcInternalFormat, GVRPIX_NO_PALETTE, COLOR_RGBA,
+                            0, PALETTE_NONE, NULL, 0
+                        );
+
+                        gcColorDispatch dstDispatch(
+                            dstInternalFormat, GVRPIX_NO_PALETTE, COLOR_RGBA,
+                            0, PALETTE_NONE, NULL, 0
+                        );
+
+                        // Get the color from the source.
+                        abstractColorItem colorItem;
+                        colorItem.setClearedColor( COLORMODEL_RGBA );   // for safety we start with a cleared color.
+
+                        GCProcessTiledCoordsFromLinear(
+                            layerX, layerY, srcMipWidth, srcMipHeight,
+                            srcClusterWidth, srcClusterHeight, srcClusterCount,
+                            isSrcFormatSwizzled,
+                            [&]( uint32 tiled_x, uint32 tiled_y, uint32 cluster_index )
+                        {
+                            // Safety is a big concern of mine.
+                            if ( tiled_x < srcMipWidth * srcClusterCount && tiled_y < srcMipHeight )
+                            {
+                                const void *srcRow = getConstTexelDataRow( srcTexels, srcRowSize, tiled_y );
+
+                                readGCNativeColor(
+                                    srcRow, srcDispatch, tiled_x,
+                                    cluster_index,
+                                    []( abstractColorItem& colorItem ){},   // nothing to do here.
+                                    colorItem
+                                );
+                            }
+                        });
+
+                        // Now the source color should be properly initialized.
+                        // We should put it into the destination slot.
+
+                        GCProcessTiledCoordsFromLinear(
+                            layerX, layerY, dstMipWidth, dstMipHeight,
+                            dstClusterWidth, dstClusterHeight, dstClusterCount,
+                            isDstFormatSwizzled,
+                            [&]( uint32 tiled_x, uint32 tiled_y, uint32 cluster_index )
+                        {
+                            if ( tiled_x < dstMipWidth * dstClusterCount && tiled_y < dstMipHeight )
+                            {
+                                void *dstRow = getTexelDataRow( dstTexels, dstRowSize, tiled_y );
+
+                                // Put the color, I guess.
+                                // Or what we want to put from it anyway.
+                                writeGCNativeColor(
+                                    dstRow, dstDispatch, tiled_x,
+                                    cluster_index, colorItem
+                                );
+                            }
+                        });
+                    }
                 }
             }
         }
@@ -0,0 +1,412 @@
+// Cache of compiled memory permutations.
+// Native textures of the same platform come in few shapes, so we compile each shape into a flat
+// list of texel moves once and reuse it for every later texture.
+#include "StdInc.h"
+
+#include "txdread.memcodec.hxx"
+
+#include "pluginutil.hxx"
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <vector>
+
+namespace rw
+{
+
+// Memory that the cached plans may take in total.
+#define PERMUTATION_PLAN_CACHE_SIZE     ( 64 * 1024 * 1024 )
+
+// Bigger plans are not compiled; those permutations run directly.
+#define PERMUTATION_PLAN_MAX_SIZE       ( PERMUTATION_PLAN_CACHE_SIZE / 4 )
+
+namespace memcodec
+{
+
+namespace permutationUtilities
+{
+
+// Everything that decides where texels go.
+struct permutationPlanKey
+{
+    uint32 rawWidth, rawHeight, rawDepth, rawColumnWidth, rawColumnHeight;
+    uint32 packedWidth, packedHeight, packedColumnWidth, packedColumnHeight;
+    uint32 colsWidth, colsHeight;
+    const uint32 *permutationData_primCol;
+    const uint32 *permutationData_secCol;
+    uint32 permWidth, permHeight;
+    uint32 permutationStride, permHoriSplit;
+    uint32 srcRowAlignment, dstRowAlignment;
+    bool revert, isPackingConvention;
+
+    inline bool operator == ( const permutationPlanKey& right ) const
+    {
+        return
+            this->rawWidth == right.rawWidth && this->rawHeight == right.rawHeight && this->rawDepth == right.rawDepth &&
+            this->rawColumnWidth == right.rawColumnWidth && this->rawColumnHeight == right.rawColumnHeight &&
+            this->packedWidth == right.packedWidth && this->packedHeight == right.packedHeight &&
+            this->packedColumnWidth == right.packedColumnWidth && this->packedColumnHeight == right.packedColumnHeight &&
+            this->colsWidth == right.colsWidth && this->colsHeight == right.colsHeight &&
+            this->permutationData_primCol == right.permutationData_primCol &&
+            this->permutationData_secCol == right.permutationData_secCol &&
+            this->permWidth == right.permWidth && this->permHeight == right.permHeight &&
+            this->permutationStride == right.permutationStride && this->permHoriSplit == right.permHoriSplit &&
+            this->srcRowAlignment == right.srcRowAlignment && this->dstRowAlignment == right.dstRowAlignment &&
+            this->revert == right.revert && this->isPackingConvention == right.isPackingConvention;
+    }
+};
+
+// A permutation compiled into texel moves.
+// Offsets are in bytes, except for 4bit texels where they count nibbles.
+struct permutationPlan
+{
+    struct texelMove
+    {
+        uint32 srcOffset;
+        uint32 dstOffset;
+    };
+
+    permutationPlanKey key;
+
+    std::vector <texelMove> moves;
+
+    inline size_t GetMemorySize( void ) const
+    {
+        return ( sizeof( *this ) + this->moves.capacity() * sizeof( texelMove ) );
+    }
+};
+
+typedef std::shared_ptr <const permutationPlan> permutationPlanPtr_t;
+
+static inline void getPermutationRowSizes( const permutationPlanKey& key, uint32& srcRowSizeOut, uint32& dstRowSizeOut )
+{
+    uint32 packedTransformedStride = ( key.packedWidth * key.permutationStride );
+
+    uint32 srcStride, targetStride;
+
+    if ( !key.revert )
+    {
+        srcStride = key.rawWidth;
+        targetStride = packedTransformedStride;
+    }
+    else
+    {
+        srcStride = packedTransformedStride;
+        targetStride = key.rawWidth;
+    }
+
+    srcRowSizeOut = getRasterDataRowSize( srcStride, key.rawDepth, key.srcRowAlignment );
+    dstRowSizeOut = getRasterDataRowSize( targetStride, key.rawDepth, key.dstRowAlignment );
+}
+
+static inline bool isPlanDepthSupported( uint32 depth )
+{
+    return ( depth == 4 || depth == 8 || depth == 16 || depth == 24 || depth == 32 );
+}
+
+static void compilePermutationPlan( permutationPlan& plan )
+{
+    const permutationPlanKey& key = plan.key;
+
+    uint32 srcRowSize, dstRowSize;
+    getPermutationRowSizes( key, srcRowSize, dstRowSize );
+
+    uint32 depth = key.rawDepth;
+
+    auto recordMove = [&]( uint32 source_xOff, uint32 source_yOff, uint32 target_xOff, uint32 target_yOff )
+    {
+        permutationPlan::texelMove move;
+
+        if ( depth == 4 )
+        {
+            move.srcOffset = ( source_yOff * srcRowSize * 2 + source_xOff );
+            move.dstOffset = ( target_yOff * dstRowSize * 2 + target_xOff );
+        }
+        else
+        {
+            uint32 texelSize = ( depth / 8 );
+
+            move.srcOffset = ( source_yOff * srcRowSize + source_xOff * texelSize );
+            move.dstOffset = ( target_yOff * dstRowSize + target_xOff * texelSize );
+        }
+
+        plan.moves.push_back( move );
+    };
+
+    walkPermutation(
+        key.rawWidth, key.rawHeight, key.rawColumnWidth, key.rawColumnHeight,
+        key.packedWidth, key.packedHeight, key.packedColumnWidth, key.packedColumnHeight,
+        key.colsWidth, key.colsHeight,
+        key.permutationData_primCol, key.permutationData_secCol, key.permWidth, key.permHeight,
+        key.permutationStride, key.permHoriSplit,
+        key.revert, key.isPackingConvention,
+        recordMove
+    );
+
+    plan.moves.shrink_to_fit();
+}
+
+template <typename texelType>
+static inline void executeTexelMoves( const permutationPlan& plan, const void *srcTexels, void *dstTexels )
+{
+    const char *srcBytes = (const char*)srcTexels;
+    char *dstBytes = (char*)dstTexels;
+
+    for ( const permutationPlan::texelMove& move : plan.moves )
+    {
+        *(texelType*)( dstBytes + move.dstOffset ) = *(const texelType*)( srcBytes + move.srcOffset );
+    }
+}
+
+static void executePermutationPlan( const permutationPlan& plan, const void *srcTexels, void *dstTexels )
+{
+    uint32 depth = plan.key.rawDepth;
+
+    if ( depth == 4 )
+    {
+        const PixelFormat::palette4bit *srcData = (const PixelFormat::palette4bit*)srcTexels;
+        PixelFormat::palette4bit *dstData = (PixelFormat::palette4bit*)dstTexels;
+
+        for ( const permutationPlan::texelMove& move : plan.moves )
+        {
+            PixelFormat::palette4bit::trav_t travItem;
+
+            srcData->getvalue( move.srcOffset, travItem );
+            dstData->setvalue( move.dstOffset, travItem );
+        }
+    }
+    else if ( depth == 8 )
+    {
+        executeTexelMoves <uint8> ( plan, srcTexels, dstTexels );
+    }
+    else if ( depth == 16 )
+    {
+        executeTexelMoves <uint16> ( plan, srcTexels, dstTexels );
+    }
+    else if ( depth == 24 )
+    {
+        struct colorStruct
+        {
+            uint8 x, y, z;
+        };
+
+        executeTexelMoves <colorStruct> ( plan, srcTexels, dstTexels );
+    }
+    else if ( depth == 32 )
+    {
+        executeTexelMoves <uint32> ( plan, srcTexels, dstTexels );
+    }
+}
+
+struct permutationPlanCacheEnv
+{
+    inline void Initialize( EngineInterface *engineInterface )
+    {
+        this->bytesCached = 0;
+
+        this->cacheHits = 0;
+        this->cacheMisses = 0;
+        this->evictions = 0;
+
+        this->planLock = CreateReadWriteLock( engineInterface );
+    }
+
+    inline void Shutdown( EngineInterface *engineInterface )
+    {
+        this->plans.clear();
+
+        this->bytesCached = 0;
+
+        if ( rwlock *planLock = this->planLock )
+        {
+            CloseReadWriteLock( engineInterface, planLock );
+        }
+    }
+
+    inline void operator = ( const permutationPlanCacheEnv& right )
+    {
+        throw RwException( "cannot copy permutation plan cache environment" );
+    }
+
+    // Returns the plan for the key if it is cached.
+    inline permutationPlanPtr_t FindPlan( const permutationPlanKey& key )
+    {
+        // Writer lock because we move the plan to the front.
+        scoped_rwlock_writer <rwlock> ctxFindPlan( this->planLock );
+
+        for ( planList_t::iterator iter = this->plans.begin(); iter != this->plans.end(); iter++ )
+        {
+            if ( (*iter)->key == key )
+            {
+                // Keep recently used plans at the front.
+                this->plans.splice( this->plans.begin(), this->plans, iter );
+
+                return this->plans.front();
+            }
+        }
+
+        return permutationPlanPtr_t();
+    }
+
+    // Puts a plan into the cache, dropping the least recently used plans if we run out of memory.
+    // If another thread has put a plan for the same shape in the meantime, that one is returned.
+    inline permutationPlanPtr_t InsertPlan( permutationPlanPtr_t plan )
+    {
+        scoped_rwlock_writer <rwlock> ctxInsertPlan( this->planLock );
+
+        for ( const permutationPlanPtr_t& cachedPlan : this->plans )
+        {
+            if ( cachedPlan->key == plan->key )
+            {
+                return cachedPlan;
+            }
+        }
+
+        size_t planSize = plan->GetMemorySize();
+
+        while ( !this->plans.empty() && this->bytesCached + planSize > PERMUTATION_PLAN_CACHE_SIZE )
+        {
+            this->bytesCached -= this->plans.back()->GetMemorySize();
+
+            // Threads that still run the plan keep it alive.
+            this->plans.pop_back();
+
+            this->evictions++;
+        }
+
+        this->plans.push_front( plan );
+
+        this->bytesCached += planSize;
+
+        return plan;
+    }
+
+    inline void GetStats( permutationPlanCacheStats& statsOut ) const
+    {
+        scoped_rwlock_reader <rwlock> ctxGetStats( this->planLock );
+
+        statsOut.planCount = (uint32)this->plans.size();
+        statsOut.bytesCached = this->bytesCached;
+        statsOut.cacheHits = this->cacheHits;
+        statsOut.cacheMisses = this->cacheMisses;
+        statsOut.evictions = this->evictions;
+    }
+
+    typedef std::list <permutationPlanPtr_t> planList_t;
+
+    rwlock *planLock;
+
+    planList_t plans;       // most recently used first
+    size_t bytesCached;
+
+    std::atomic <uint64> cacheHits;
+    std::atomic <uint64> cacheMisses;
+    uint64 evictions;
+};
+
+static PluginDependantStructRegister <permutationPlanCacheEnv, RwInterfaceFactory_t> permutationPlanCacheEnvRegister;
+
+void permuteArrayCached(
+    Interface *engineInterface,
+    const void *srcToBePermuted, uint32 rawWidth, uint32 rawHeight, uint32 rawDepth, uint32 rawColumnWidth, uint32 rawColumnHeight,
+    void *dstTexels, uint32 packedWidth, uint32 packedHeight, uint32 packedDepth, uint32 packedColumnWidth, uint32 packedColumnHeight,
+    uint32 colsWidth, uint32 colsHeight,
+    const uint32 *permutationData_primCol, const uint32 *permutationData_secCol, uint32 permWidth, uint32 permHeight,
+    uint32 permutationStride, uint32 permHoriSplit,
+    uint32 srcRowAlignment, uint32 dstRowAlignment,
+    bool revert, bool isPackingConvention
+)
+{
+    permutationPlanCacheEnv *cacheEnv = permutationPlanCacheEnvRegister.GetPluginStruct( (EngineInterface*)engineInterface );
+
+    // Get the size of the plan before we compile it; there is at most one move per visited texel.
+    uint32 columnTexelCount = ( ( packedColumnWidth * permutationStride ) / permHoriSplit * packedColumnHeight );
+
+    size_t expectedPlanSize = ( (size_t)colsWidth * permHoriSplit * colsHeight * columnTexelCount * sizeof( permutationPlan::texelMove ) );
+
+    if ( cacheEnv == NULL || !isPlanDepthSupported( rawDepth ) || expectedPlanSize > PERMUTATION_PLAN_MAX_SIZE )
+    {
+        permuteArray(
+            srcToBePermuted, rawWidth, rawHeight, rawDepth, rawColumnWidth, rawColumnHeight,
+            dstTexels, packedWidth, packedHeight, packedDepth, packedColumnWidth, packedColumnHeight,
+            colsWidth, colsHeight,
+            permutationData_primCol, permutationData_secCol, permWidth, permHeight,
+            permutationStride, permHoriSplit,
+            srcRowAlignment, dstRowAlignment,
+            revert, isPackingConvention
+        );
+        return;
+    }
+
+    permutationPlanKey key;
+    key.rawWidth = rawWidth;
+    key.rawHeight = rawHeight;
+    key.rawDepth = rawDepth;
+    key.rawColumnWidth = rawColumnWidth;
+    key.rawColumnHeight = rawColumnHeight;
+    key.packedWidth = packedWidth;
+    key.packedHeight = packedHeight;
+    key.packedColumnWidth = packedColumnWidth;
+    key.packedColumnHeight = packedColumnHeight;
+    key.colsWidth = colsWidth;
+    key.colsHeight = colsHeight;
+    key.permutationData_primCol = permutationData_primCol;
+    key.permutationData_secCol = permutationData_secCol;
+    key.permWidth = permWidth;
+    key.permHeight = permHeight;
+    key.permutationStride = permutationStride;
+    key.permHoriSplit = permHoriSplit;
+    key.srcRowAlignment = srcRowAlignment;
+    key.dstRowAlignment = dstRowAlignment;
+    key.revert = revert;
+    key.isPackingConvention = isPackingConvention;
+
+    permutationPlanPtr_t plan = cacheEnv->FindPlan( key );
+
+    if ( plan )
+    {
+        cacheEnv->cacheHits++;
+    }
+    else
+    {
+        cacheEnv->cacheMisses++;
+
+        // Compile outside of the lock, so that other shapes do not have to wait.
+        std::shared_ptr <permutationPlan> newPlan = std::make_shared <permutationPlan> ();
+        newPlan->key = key;
+
+        compilePermutationPlan( *newPlan );
+
+        plan = cacheEnv->InsertPlan( std::move( newPlan ) );
+    }
+
+    executePermutationPlan( *plan, srcToBePermuted, dstTexels );
+}
+
+};
+
+};
+
+void Interface::GetPermutationPlanCacheStats( permutationPlanCacheStats& statsOut ) const
+{
+    statsOut.planCount = 0;
+    statsOut.bytesCached = 0;
+    statsOut.cacheHits = 0;
+    statsOut.cacheMisses = 0;
+    statsOut.evictions = 0;
+
+    using namespace memcodec::permutationUtilities;
+
+    if ( const permutationPlanCacheEnv *cacheEnv = permutationPlanCacheEnvRegister.GetConstPluginStruct( (const EngineInterface*)this ) )
+    {
+        cacheEnv->GetStats( statsOut );
+    }
+}
+
+void registerPermutationPlanCache( void )
+{
+    memcodec::permutationUtilities::permutationPlanCacheEnvRegister.RegisterPlugin( engineFactory );
+}
+
+};
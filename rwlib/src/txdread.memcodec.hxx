@@ -14,14 +14,16 @@ namespace memcodec
 // Common utilities for permutation providers.
 namespace permutationUtilities
 {
-    inline static void permuteArray(
-        const void *srcToBePermuted, uint32 rawWidth, uint32 rawHeight, uint32 rawDepth, uint32 rawColumnWidth, uint32 rawColumnHeight,
-        void *dstTexels, uint32 packedWidth, uint32 packedHeight, uint32 packedDepth, uint32 packedColumnWidth, uint32 packedColumnHeight,
+    // Walks through the permutation and calls cb( srcX, srcY, dstX, dstY ) for every texel that has to be moved.
+    template <typename callbackType>
+    AINLINE void walkPermutation(
+        uint32 rawWidth, uint32 rawHeight, uint32 rawColumnWidth, uint32 rawColumnHeight,
+        uint32 packedWidth, uint32 packedHeight, uint32 packedColumnWidth, uint32 packedColumnHeight,
         uint32 colsWidth, uint32 colsHeight,
         const uint32 *permutationData_primCol, const uint32 *permutationData_secCol, uint32 permWidth, uint32 permHeight,
         uint32 permutationStride, uint32 permHoriSplit,
-        uint32 srcRowAlignment, uint32 dstRowAlignment,
-        bool revert, bool isPackingConvention = true
+        bool revert, bool isPackingConvention,
+        callbackType& cb
         )
     {
         // Get the dimensions of a column as expressed in units of the permutation format.
@@ -37,8 +39,6 @@ namespace permutationUtilities
         uint32 packedTargetWidth = packedWidth;
         uint32 packedTargetHeight = packedHeight;
 
-        uint32 permItemDepth = rawDepth;
-
         uint32 packedTransformedColumnWidth = ( permProcessColumnWidth * permutationStride ) / permHoriSplit;
         uint32 packedTransformedColumnHeight = ( permProcessColumnHeight );
 
@@ -47,24 +47,6 @@ namespace permutationUtilities
         // Get the stride through the packed data in raw format.
         uint32 packedTransformedStride = ( packedTargetWidth * permutationStride );
 
-        // Determine the strides for both arrays.
-        uint32 srcStride, targetStride;
-
-        if ( !revert )
-        {
-            srcStride = permSourceWidth;
-            targetStride = packedTransformedStride;
-        }
-        else
-        {
-            srcStride = packedTransformedStride;
-            targetStride = permSourceWidth;
-        }
-
-        // Calculate the row sizes.
-        uint32 srcRowSize = getRasterDataRowSize( srcStride, permItemDepth, srcRowAlignment );
-        uint32 dstRowSize = getRasterDataRowSize( targetStride, permItemDepth, dstRowAlignment );
-
         // Permute the pixels.
         for ( uint32 colY = 0; colY < colsHeight; colY++ )
         {
@@ -152,17 +134,7 @@ namespace permutationUtilities
                                 target_yOff = source_pixel_yOff;
                             }
 
-                            // Get the rows.
-                            const void *srcRow = getConstTexelDataRow( srcToBePermuted, srcRowSize, source_yOff );
-                            void *dstRow = getTexelDataRow( dstTexels, dstRowSize, target_yOff );
-
-                            // Move the data over.
-                            moveDataByDepth(
-                                dstRow, srcRow,
-                                permItemDepth,
-                                eByteAddressingMode::MOST_SIGNIFICANT,
-                                target_xOff, source_xOff
-                            );
+                            cb( source_xOff, source_yOff, target_xOff, target_yOff );
                         }
                     }
                 }
@@ -170,6 +142,76 @@ namespace permutationUtilities
         }
     }
 
+    // Reference implementation of the permutation, moving texels one by one.
+    inline static void permuteArray(
+        const void *srcToBePermuted, uint32 rawWidth, uint32 rawHeight, uint32 rawDepth, uint32 rawColumnWidth, uint32 rawColumnHeight,
+        void *dstTexels, uint32 packedWidth, uint32 packedHeight, uint32 packedDepth, uint32 packedColumnWidth, uint32 packedColumnHeight,
+        uint32 colsWidth, uint32 colsHeight,
+        const uint32 *permutationData_primCol, const uint32 *permutationData_secCol, uint32 permWidth, uint32 permHeight,
+        uint32 permutationStride, uint32 permHoriSplit,
+        uint32 srcRowAlignment, uint32 dstRowAlignment,
+        bool revert, bool isPackingConvention = true
+        )
+    {
+        uint32 packedTransformedStride = ( packedWidth * permutationStride );
+
+        // Determine the strides for both arrays.
+        uint32 srcStride, targetStride;
+
+        if ( !revert )
+        {
+            srcStride = rawWidth;
+            targetStride = packedTransformedStride;
+        }
+        else
+        {
+            srcStride = packedTransformedStride;
+            targetStride = rawWidth;
+        }
+
+        // Calculate the row sizes.
+        uint32 srcRowSize = getRasterDataRowSize( srcStride, rawDepth, srcRowAlignment );
+        uint32 dstRowSize = getRasterDataRowSize( targetStride, rawDepth, dstRowAlignment );
+
+        auto moveTexel = [&]( uint32 source_xOff, uint32 source_yOff, uint32 target_xOff, uint32 target_yOff )
+        {
+            // Get the rows.
+            const void *srcRow = getConstTexelDataRow( srcToBePermuted, srcRowSize, source_yOff );
+            void *dstRow = getTexelDataRow( dstTexels, dstRowSize, target_yOff );
+
+            // Move the data over.
+            moveDataByDepth(
+                dstRow, srcRow,
+                rawDepth,
+                eByteAddressingMode::MOST_SIGNIFICANT,
+                target_xOff, source_xOff
+            );
+        };
+
+        walkPermutation(
+            rawWidth, rawHeight, rawColumnWidth, rawColumnHeight,
+            packedWidth, packedHeight, packedColumnWidth, packedColumnHeight,
+            colsWidth, colsHeight,
+            permutationData_primCol, permutationData_secCol, permWidth, permHeight,
+            permutationStride, permHoriSplit,
+            revert, isPackingConvention,
+            moveTexel
+        );
+    }
+
+    // Same as permuteArray, but the permutation is compiled into a plan of texel moves once
+    // per shape and kept in a cache of the engine. Use this for permutations that come up often.
+    void permuteArrayCached(
+        Interface *engineInterface,
+        const void *srcToBePermuted, uint32 rawWidth, uint32 rawHeight, uint32 rawDepth, uint32 rawColumnWidth, uint32 rawColumnHeight,
+        void *dstTexels, uint32 packedWidth, uint32 packedHeight, uint32 packedDepth, uint32 packedColumnWidth, uint32 packedColumnHeight,
+        uint32 colsWidth, uint32 colsHeight,
+        const uint32 *permutationData_primCol, const uint32 *permutationData_secCol, uint32 permWidth, uint32 permHeight,
+        uint32 permutationStride, uint32 permHoriSplit,
+        uint32 srcRowAlignment, uint32 dstRowAlignment,
+        bool revert, bool isPackingConvention = true
+    );
+
     template <typename processorType, typename callbackType>
     AINLINE void GenericProcessTiledCoordsFromLinear(
         uint32 linearX, uint32 linearY, uint32 surfWidth, uint32 surfHeight,
@@ -771,7 +813,8 @@ struct genericMemoryEncoder
             if (permutationData_primCol != NULL && permutationData_secCol != NULL)
             {
                 // Permute!
-                permutationUtilities::permuteArray(
+                permutationUtilities::permuteArrayCached(
+                    engineInterface,
                     srcToBeTransformed, rawWidth, rawHeight, rawDepth, rawColumnWidth, rawColumnHeight,
                     newtexels, packedWidth, packedHeight, packedDepth, packedColumnWidth, packedColumnHeight,
                     columnWidthCount, columnHeightCount,
@@ -3,6 +3,10 @@
 
 #include "txdread.raster.hxx"
 
+#include "txdread.size.hxx"
+
+#include <vector>
+
 namespace rw
 {
 
@@ -185,6 +189,350 @@ inline void ensurePutIntoArray( dataType dataToPut, containerType& container, ui
     container[ putIndex ] = dataToPut;
 }
 
+// Transforms colors into the space that we average mipmaps in, and back.
+struct mipmapColorSpace
+{
+    inline mipmapColorSpace( eMipmapGenerationMode mipGenMode, eColorModel model )
+    {
+        this->isSRGB = ( mipGenMode == MIPMAPGEN_SRGB );
+        this->isPremultiplied = ( mipGenMode == MIPMAPGEN_PREMULTIPLIED_ALPHA );
+
+        // Luminance colors only use two floats.
+        this->colorChannels = ( model == COLORMODEL_LUMINANCE ? 1 : 3 );
+        this->alphaChannel = ( model == COLORMODEL_LUMINANCE ? 1 : 3 );
+    }
+
+    static float srgbToLinear( float value )
+    {
+        // Our source formats have at most 8 bits per channel, so a table is exact enough.
+        struct srgbTable
+        {
+            float values[ 256 ];
+
+            inline srgbTable( void )
+            {
+                for ( uint32 n = 0; n < 256; n++ )
+                {
+                    double c = ( n / 255.0 );
+
+                    values[ n ] = (float)( c <= 0.04045 ? c / 12.92 : pow( ( c + 0.055 ) / 1.055, 2.4 ) );
+                }
+            }
+        };
+
+        static const srgbTable table;
+
+        return table.values[ (uint32)( clampColorChannel( value ) * 255.0f + 0.5f ) ];
+    }
+
+    static float linearToSRGB( float value )
+    {
+        value = clampColorChannel( value );
+
+        return (float)( value <= 0.0031308f ? value * 12.92f : 1.055 * pow( (double)value, 1.0 / 2.4 ) - 0.055 );
+    }
+
+    inline void toAverageSpace( float *colors, uint32 count ) const
+    {
+        uint32 colorChannels = this->colorChannels;
+        uint32 alphaChannel = this->alphaChannel;
+
+        for ( uint32 n = 0; n < count; n++ )
+        {
+            float *color = colors + n * 4;
+
+            if ( this->isSRGB )
+            {
+                for ( uint32 c = 0; c < colorChannels; c++ )
+                {
+                    color[ c ] = srgbToLinear( color[ c ] );
+                }
+            }
+            else if ( this->isPremultiplied )
+            {
+                float alpha = color[ alphaChannel ];
+
+                for ( uint32 c = 0; c < colorChannels; c++ )
+                {
+                    color[ c ] *= alpha;
+                }
+            }
+        }
+    }
+
+    inline void fromAverageSpace( float *colors, uint32 count ) const
+    {
+        uint32 colorChannels = this->colorChannels;
+        uint32 alphaChannel = this->alphaChannel;
+
+        for ( uint32 n = 0; n < count; n++ )
+        {
+            float *color = colors + n * 4;
+
+            if ( this->isSRGB )
+            {
+                for ( uint32 c = 0; c < colorChannels; c++ )
+                {
+                    color[ c ] = linearToSRGB( color[ c ] );
+                }
+            }
+            else if ( this->isPremultiplied )
+            {
+                float alpha = color[ alphaChannel ];
+
+                for ( uint32 c = 0; c < colorChannels; c++ )
+                {
+                    color[ c ] = ( alpha > 0 ? color[ c ] / alpha : 0.0f );
+                }
+            }
+        }
+    }
+
+    inline bool hasAlpha( const float *colors, uint32 count ) const
+    {
+        uint32 alphaChannel = this->alphaChannel;
+
+        for ( uint32 n = 0; n < count; n++ )
+        {
+            if ( colors[ n * 4 + alphaChannel ] < 1.0f )
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool isSRGB;
+    bool isPremultiplied;
+    uint32 colorChannels;
+    uint32 alphaChannel;
+};
+
+// Averages 2x2 blocks of colors (or 2x1, 1x2 if a dimension has reached one texel).
+// If only one row is reduced, both row pointers are the same.
+AINLINE void reduceMipmapRow( const float *srcRowTop, const float *srcRowBottom, float *dstRow, uint32 dstWidth, uint32 srcStepX )
+{
+    uint32 secondOff = ( srcStepX - 1 ) * 4;
+
+#ifdef RWLIB_ENABLE_X86_SIMD
+    const __m128 quarter = _mm_set1_ps( 0.25f );
+
+    for ( uint32 x = 0; x < dstWidth; x++ )
+    {
+        uint32 srcOff = ( x * srcStepX * 4 );
+
+        __m128 top = _mm_add_ps( _mm_loadu_ps( srcRowTop + srcOff ), _mm_loadu_ps( srcRowTop + srcOff + secondOff ) );
+        __m128 bottom = _mm_add_ps( _mm_loadu_ps( srcRowBottom + srcOff ), _mm_loadu_ps( srcRowBottom + srcOff + secondOff ) );
+
+        _mm_storeu_ps( dstRow + x * 4, _mm_mul_ps( _mm_add_ps( top, bottom ), quarter ) );
+    }
+#else
+    for ( uint32 x = 0; x < dstWidth; x++ )
+    {
+        uint32 srcOff = ( x * srcStepX * 4 );
+
+        for ( uint32 c = 0; c < 4; c++ )
+        {
+            float sum =
+                srcRowTop[ srcOff + c ] + srcRowTop[ srcOff + secondOff + c ] +
+                srcRowBottom[ srcOff + c ] + srcRowBottom[ srcOff + secondOff + c ];
+
+            dstRow[ x * 4 + c ] = ( sum * 0.25f );
+        }
+    }
+#endif //RWLIB_ENABLE_X86_SIMD
+}
+
+// Builds every missing mipmap level for the averaging modes.
+// The base level is decoded once; each level is then reduced from the one before it, in floating point.
+static void generateMipmapChain(
+    Interface *engineInterface, PlatformTexture *platformTex, texNativeTypeProvider *texProvider,
+    const Bitmap& baseBitmap, uint32 oldMipmapCount, uint32 maxMipmapCount, eMipmapGenerationMode mipGenMode
+)
+{
+    if ( maxMipmapCount <= oldMipmapCount )
+        return;
+
+    uint32 baseWidth = baseBitmap.getWidth();
+    uint32 baseHeight = baseBitmap.getHeight();
+
+    uint32 depth = baseBitmap.getDepth();
+    uint32 rowAlignment = baseBitmap.getRowAlignment();
+
+    eRasterFormat rasterFormat = baseBitmap.getFormat();
+    eColorOrdering colorOrder = baseBitmap.getColorOrder();
+
+    resampleRowCodec codec( rasterFormat, colorOrder, depth, PALETTE_NONE, NULL, 0, depth );
+
+    if ( codec.colorModel != COLORMODEL_RGBA && codec.colorModel != COLORMODEL_LUMINANCE )
+    {
+        throw RwException( "unsupported color model in mipmap generation" );
+    }
+
+    mipmapColorSpace colorSpace( mipGenMode, codec.colorModel );
+
+    mipGenLevelGenerator mipLevelGen( baseWidth, baseHeight );
+
+    if ( !mipLevelGen.isValidLevel() )
+    {
+        throw RwException( "invalid raster dimensions in mipmap generation" );
+    }
+
+    const void *baseTexels = baseBitmap.getTexelsData();
+    uint32 baseRowSize = getRasterDataRowSize( baseWidth, depth, rowAlignment );
+
+    // The level that we reduce from. Empty while that is the base level.
+    std::vector <float> prevLevel;
+    uint32 prevWidth = baseWidth;
+
+    std::vector <float> curLevel;
+
+    // Temporary rows for the decoded base level.
+    std::vector <float> baseRowTop( (size_t)baseWidth * 4 );
+    std::vector <float> baseRowBottom( (size_t)baseWidth * 4 );
+
+    std::vector <float> encodeRow;
+
+    for ( uint32 mipIndex = 1; mipIndex < maxMipmapCount; mipIndex++ )
+    {
+        if ( !mipLevelGen.incrementLevel() )
+            break;
+
+        uint32 mipWidth = mipLevelGen.getLevelWidth();
+        uint32 mipHeight = mipLevelGen.getLevelHeight();
+
+        uint32 srcStepX = ( mipLevelGen.didIncrementWidth() ? 2 : 1 );
+        uint32 srcStepY = ( mipLevelGen.didIncrementHeight() ? 2 : 1 );
+
+        size_t rowFloats = ( (size_t)mipWidth * 4 );
+
+        curLevel.resize( rowFloats * mipHeight );
+
+        for ( uint32 mip_y = 0; mip_y < mipHeight; mip_y++ )
+        {
+            uint32 srcTopY = ( mip_y * srcStepY );
+            uint32 srcBottomY = ( srcTopY + srcStepY - 1 );
+
+            const float *srcRowTop, *srcRowBottom;
+
+            if ( prevLevel.empty() )
+            {
+                codec.DecodeRow( getConstTexelDataRow( baseTexels, baseRowSize, srcTopY ), baseRowTop.data(), baseWidth );
+                colorSpace.toAverageSpace( baseRowTop.data(), baseWidth );
+
+                srcRowTop = baseRowTop.data();
+                srcRowBottom = srcRowTop;
+
+                if ( srcBottomY != srcTopY )
+                {
+                    codec.DecodeRow( getConstTexelDataRow( baseTexels, baseRowSize, srcBottomY ), baseRowBottom.data(), baseWidth );
+                    colorSpace.toAverageSpace( baseRowBottom.data(), baseWidth );
+
+                    srcRowBottom = baseRowBottom.data();
+                }
+            }
+            else
+            {
+                srcRowTop = prevLevel.data() + (size_t)srcTopY * prevWidth * 4;
+                srcRowBottom = prevLevel.data() + (size_t)srcBottomY * prevWidth * 4;
+            }
+
+            reduceMipmapRow( srcRowTop, srcRowBottom, curLevel.data() + mip_y * rowFloats, mipWidth, srcStepX );
+        }
+
+        if ( mipIndex >= oldMipmapCount )
+        {
+            // Encode the level and give it to the texture.
+            uint32 texRowSize = getRasterDataRowSize( mipWidth, depth, rowAlignment );
+
+            uint32 texDataSize = getRasterDataSizeByRowSize( texRowSize, mipHeight );
+
+            void *newtexels = engineInterface->PixelAllocate( texDataSize );
+
+            if ( !newtexels )
+            {
+                throw RwException( "failed to allocate mipmap texels in mipmap generation" );
+            }
+
+            texNativeTypeProvider::acquireFeedback_t acquireFeedback;
+
+            bool couldAdd = false;
+
+            try
+            {
+                bool hasAlpha = false;
+
+                encodeRow.resize( rowFloats );
+
+                for ( uint32 mip_y = 0; mip_y < mipHeight; mip_y++ )
+                {
+                    memcpy( encodeRow.data(), curLevel.data() + mip_y * rowFloats, rowFloats * sizeof( float ) );
+
+                    colorSpace.fromAverageSpace( encodeRow.data(), mipWidth );
+
+                    if ( !hasAlpha )
+                    {
+                        hasAlpha = colorSpace.hasAlpha( encodeRow.data(), mipWidth );
+                    }
+
+                    codec.EncodeRow( encodeRow.data(), getTexelDataRow( newtexels, texRowSize, mip_y ), mipWidth );
+                }
+
+                // Push the texels into the texture.
+                rawMipmapLayer rawMipLayer;
+
+                rawMipLayer.mipData.width = mipWidth;
+                rawMipLayer.mipData.height = mipHeight;
+
+                rawMipLayer.mipData.layerWidth = mipWidth;   // layer dimensions.
+                rawMipLayer.mipData.layerHeight = mipHeight;
+
+                rawMipLayer.mipData.texels = newtexels;
+                rawMipLayer.mipData.dataSize = texDataSize;
+
+                rawMipLayer.rasterFormat = rasterFormat;
+                rawMipLayer.depth = depth;
+                rawMipLayer.rowAlignment = rowAlignment;
+                rawMipLayer.colorOrder = colorOrder;
+                rawMipLayer.paletteType = PALETTE_NONE;
+                rawMipLayer.paletteData = NULL;
+                rawMipLayer.paletteSize = 0;
+                rawMipLayer.compressionType = RWCOMPRESS_NONE;
+
+                rawMipLayer.hasAlpha = hasAlpha;
+
+                rawMipLayer.isNewlyAllocated = true;
+
+                couldAdd = texProvider->AddMipmapLayer(
+                    engineInterface, platformTex, rawMipLayer, acquireFeedback
+                );
+            }
+            catch( ... )
+            {
+                engineInterface->PixelFree( newtexels );
+
+                throw;
+            }
+
+            if ( couldAdd == false || acquireFeedback.hasDirectlyAcquired == false )
+            {
+                engineInterface->PixelFree( newtexels );
+            }
+
+            if ( couldAdd == false )
+            {
+                // If we failed to add any mipmap, we abort operation.
+                break;
+            }
+        }
+
+        // The next level is reduced from this one.
+        prevLevel.swap( curLevel );
+        prevWidth = mipWidth;
+    }
+}
+
 // TODO: maybe in the future I will combine the resize filtering with this mipmap generation logic.
 // For now I see no need to, especially since both use the same logic.
 
@@ -224,6 +572,13 @@ void Raster::generateMipmaps( uint32 maxMipmapCount, eMipmapGenerationMode mipGe
     if ( oldMipmapCount == 0 )
         return;
 
+    // The averaging modes build the whole chain from a single decode of the base level.
+    if ( mipGenMode == MIPMAPGEN_DEFAULT || mipGenMode == MIPMAPGEN_SRGB || mipGenMode == MIPMAPGEN_PREMULTIPLIED_ALPHA )
+    {
+        generateMipmapChain( engineInterface, platformTex, texProvider, textureBitmap, oldMipmapCount, maxMipmapCount, mipGenMode );
+        return;
+    }
+
     // Do the generation.
     // We process the image in 2x2 blocks for the level index 1, 4x4 for level index 2, ...
     uint32 firstLevelWidth, firstLevelHeight;
@@ -15,7 +15,14 @@ namespace rw
 // Compatibility routines to make sure that pixel data can be properly pushed to
 // native textures.
 
-inline void CompatibilityTransformPixelData( Interface *engineInterface, pixelDataTraversal& pixelData, const texNativeTypeProvider *capsProvider )
+// Decides the format that pixels have to be in so that the native texture can take them.
+// Returns whether that format is different from the source format.
+inline bool DecideCompatiblePixelFormat(
+    Interface *engineInterface,
+    const pixelFormat& srcFormat, uint32 srcPaletteSize, bool hasAlpha,
+    const texNativeTypeProvider *capsProvider,
+    pixelFormat& dstFormatOut
+)
 {
     // Get the general capabilities struct that we have to obey.
     pixelCapabilities pixelCaps;
@@ -24,18 +31,6 @@ inline void CompatibilityTransformPixelData( Interface *engineInterface, pixelDa
     // Make sure the pixelData does not violate the capabilities struct.
     // This is done by "downcasting". It preserves maximum image quality, but increases memory requirements.
 
-    // First get the original parameters onto stack.
-    eRasterFormat srcRasterFormat = pixelData.rasterFormat;
-    uint32 srcDepth = pixelData.depth;
-    uint32 srcRowAlignment = pixelData.rowAlignment;
-    eColorOrdering srcColorOrder = pixelData.colorOrder;
-    ePaletteType srcPaletteType = pixelData.paletteType;
-    void *srcPaletteData = pixelData.paletteData;
-    uint32 srcPaletteSize = pixelData.paletteSize;
-    eCompressionType srcCompressionType = pixelData.compressionType;
-
-    uint32 srcMipmapCount = (uint32)pixelData.mipmaps.size();
-
     // Now decide the target format depending on the capabilities.
     eRasterFormat dstRasterFormat;
     uint32 dstDepth;
@@ -48,9 +43,9 @@ inline void CompatibilityTransformPixelData( Interface *engineInterface, pixelDa
     bool wantsUpdate =
         TransformDestinationRasterFormat(
             engineInterface,
-            srcRasterFormat, srcDepth, srcRowAlignment, srcColorOrder, srcPaletteType, srcPaletteSize, srcCompressionType,
+            srcFormat.rasterFormat, srcFormat.depth, srcFormat.rowAlignment, srcFormat.colorOrder, srcFormat.paletteType, srcPaletteSize, srcFormat.compressionType,
             dstRasterFormat, dstDepth, dstRowAlignment, dstColorOrder, dstPaletteType, dstPaletteSize, dstCompressionType,
-            pixelCaps, pixelData.hasAlpha
+            pixelCaps, hasAlpha
         );
 
     // Now the destination transformation is definately compatible with the native texture specification,
@@ -84,23 +79,35 @@ inline void CompatibilityTransformPixelData( Interface *engineInterface, pixelDa
         }
     }
 
+    dstFormatOut.rasterFormat = dstRasterFormat;
+    dstFormatOut.depth = dstDepth;
+    dstFormatOut.rowAlignment = dstRowAlignment;
+    dstFormatOut.colorOrder = dstColorOrder;
+    dstFormatOut.paletteType = dstPaletteType;
+    dstFormatOut.compressionType = dstCompressionType;
+
+    return wantsUpdate;
+}
+
+inline void CompatibilityTransformPixelData( Interface *engineInterface, pixelDataTraversal& pixelData, const texNativeTypeProvider *capsProvider )
+{
+    pixelFormat srcPixelFormat;
+
+    srcPixelFormat.rasterFormat = pixelData.rasterFormat;
+    srcPixelFormat.depth = pixelData.depth;
+    srcPixelFormat.rowAlignment = pixelData.rowAlignment;
+    srcPixelFormat.colorOrder = pixelData.colorOrder;
+    srcPixelFormat.paletteType = pixelData.paletteType;
+    srcPixelFormat.compressionType = pixelData.compressionType;
+
+    pixelFormat dstPixelFormat;
+
+    bool wantsUpdate = DecideCompatiblePixelFormat( engineInterface, srcPixelFormat, pixelData.paletteSize, pixelData.hasAlpha, capsProvider, dstPixelFormat );
+
     if ( wantsUpdate )
     {
         // Convert the pixels now.
-        bool hasUpdated;
-        {
-            // Create a destination format struct.
-            pixelFormat dstPixelFormat;
-
-            dstPixelFormat.rasterFormat = dstRasterFormat;
-            dstPixelFormat.depth = dstDepth;
-            dstPixelFormat.rowAlignment = dstRowAlignment;
-            dstPixelFormat.colorOrder = dstColorOrder;
-            dstPixelFormat.paletteType = dstPaletteType;
-            dstPixelFormat.compressionType = dstCompressionType;
-
-            hasUpdated = ConvertPixelData( engineInterface, pixelData, dstPixelFormat );
-        }
+        bool hasUpdated = ConvertPixelData( engineInterface, pixelData, dstPixelFormat );
 
         // If we have updated at all, apply changes.
         if ( hasUpdated )
@@ -108,7 +115,7 @@ inline void CompatibilityTransformPixelData( Interface *engineInterface, pixelDa
             // We must have the correct parameters.
             // Here we verify problematic parameters only.
             // Params like rasterFormat are expected to be handled properly no matter what.
-            assert( pixelData.compressionType == dstCompressionType );
+            assert( pixelData.compressionType == dstPixelFormat.compressionType );
         }
     }
 }
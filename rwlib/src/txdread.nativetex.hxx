@@ -199,6 +199,13 @@ struct texNativeTypeProvider abstract
     virtual void            SerializeTexture( TextureBase *theTexture, PlatformTexture *nativeTex, BlockProvider& outputProvider ) const throw( ... ) = 0;
     virtual void            DeserializeTexture( TextureBase *theTexture, PlatformTexture *nativeTex, BlockProvider& inputProvider ) const throw( ... ) = 0;
 
+    // Reads only the texture properties (name, mask name and filtering) of a texture native block.
+    // Returns false if the properties cannot be fetched without reading the whole block.
+    virtual bool            DeserializeTextureProperties( TextureBase *theTexture, BlockProvider& inputProvider ) const throw( ... )
+    {
+        return false;
+    }
+
     // Conversion parameters.
     virtual void            GetPixelCapabilities( pixelCapabilities& capsOut ) const = 0;
     virtual void            GetStorageCapabilities( storageCapabilities& storeCaps ) const = 0;
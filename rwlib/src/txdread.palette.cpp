@@ -12,6 +12,8 @@
 
 #include "txdread.raster.hxx"
 
+#include "rwthreading.pool.hxx"
+
 #ifdef RWLIB_INCLUDE_LIBIMAGEQUANT
 // Include the libimagequant library headers.
 #include <libimagequant.h>
@@ -20,9 +22,13 @@
 namespace rw
 {
 
+// Images smaller than this are remapped on the calling thread.
+#define PALETTE_REMAP_PARALLEL_MIN_PIXELS   ( 256 * 256 )
+
+// Remaps texels to an existing palette. The palette lookup of conv has to be built.
 inline void nativePaletteRemap(
     Interface *engineInterface,
-    palettizer& conv, ePaletteType convPaletteFormat, uint32 convItemDepth,
+    const palettizer& conv, ePaletteType convPaletteFormat, uint32 convItemDepth,
     const void *texelSource, uint32 mipWidth, uint32 mipHeight,
     ePaletteType srcPaletteType, const void *srcPaletteData, uint32 srcPaletteCount,
     eRasterFormat srcRasterFormat, eColorOrdering srcColorOrder, uint32 srcItemDepth,
@@ -52,33 +58,58 @@ inline void nativePaletteRemap(
 
     try
     {
-        colorModelDispatcher fetchDispatch( srcRasterFormat, srcColorOrder, srcItemDepth, srcPaletteData, srcPaletteCount, srcPaletteType );
+        // Rows do not depend on each other, so we split the image into bands of rows.
+        uint32 concurrency = 1;
+
+        if ( (uint64)mipWidth * mipHeight >= PALETTE_REMAP_PARALLEL_MIN_PIXELS )
+        {
+            concurrency = GetParallelConcurrency( (EngineInterface*)engineInterface );
+        }
+
+        uint32 bandHeight = mipHeight;
+
+        if ( concurrency > 1 )
+        {
+            bandHeight = std::max( 1u, mipHeight / ( concurrency * 4 ) );
+        }
+
+        uint32 bandCount = ( bandHeight != 0 ? ( ( mipHeight + bandHeight - 1 ) / bandHeight ) : 0 );
 
-        for ( uint32 row = 0; row < mipHeight; row++ )
+        auto remapBand = [&]( uint32 bandIndex )
         {
-            const void *srcRow = getConstTexelDataRow( texelSource, srcRowSize, row );
-            void *dstRow = getTexelDataRow( newTexelData, dstRowSize, row );
+            colorModelDispatcher fetchDispatch( srcRasterFormat, srcColorOrder, srcItemDepth, srcPaletteData, srcPaletteCount, srcPaletteType );
 
-            for ( uint32 col = 0; col < mipWidth; col++ )
+            uint32 rowStart = ( bandIndex * bandHeight );
+            uint32 rowEnd = std::min( rowStart + bandHeight, mipHeight );
+
+            for ( uint32 row = rowStart; row < rowEnd; row++ )
             {
-                // Browse each texel of the original image and link it to a palette entry.
-                uint8 red, green, blue, alpha;
-                bool hasColor = fetchDispatch.getRGBA(srcRow, col, red, green, blue, alpha);
+                const void *srcRow = getConstTexelDataRow( texelSource, srcRowSize, row );
+                void *dstRow = getTexelDataRow( newTexelData, dstRowSize, row );
 
-                if ( !hasColor )
+                for ( uint32 col = 0; col < mipWidth; col++ )
                 {
-                    red = 0;
-                    green = 0;
-                    blue = 0;
-                    alpha = 0;
-                }
+                    // Browse each texel of the original image and link it to a palette entry.
+                    uint8 red, green, blue, alpha;
+                    bool hasColor = fetchDispatch.getRGBA(srcRow, col, red, green, blue, alpha);
 
-                uint32 paletteIndex = conv.getclosestlink(red, green, blue, alpha);
+                    if ( !hasColor )
+                    {
+                        red = 0;
+                        green = 0;
+                        blue = 0;
+                        alpha = 0;
+                    }
 
-                // Store it in the palette data.
-                setpaletteindex(dstRow, col, convItemDepth, convPaletteFormat, paletteIndex);
+                    uint32 paletteIndex = conv.getclosestlink(red, green, blue, alpha);
+
+                    // Store it in the palette data.
+                    setpaletteindex(dstRow, col, convItemDepth, convPaletteFormat, paletteIndex);
+                }
             }
-        }
+        };
+
+        ParallelFor( (EngineInterface*)engineInterface, bandCount, concurrency, remapBand );
     }
     catch( ... )
     {
@@ -231,8 +262,7 @@ void PalettizePixelData( Interface *engineInterface, pixelDataTraversal& pixelDa
         {
             palettizer conv;
 
-            // Linear eliminate unique texels.
-            // Use only the first texture.
+            // Collect the colors of the first mipmap.
             if ( mipmapCount > 0 )
             {
                 pixelDataTraversal::mipmapResource& mainLayer = pixelData.mipmaps[ 0 ];
@@ -244,31 +274,9 @@ void PalettizePixelData( Interface *engineInterface, pixelDataTraversal& pixelDa
 
                 uint32 srcRowSize = getRasterDataRowSize( srcWidth, srcDepth, srcRowAlignment );
 
-#if 0
-                // First define properties to use for linear elimination.
-                for (uint32 y = 0; y < srcHeight; y++)
-                {
-                    for (uint32 x = 0; x < srcWidth; x++)
-                    {
-                        uint32 colorIndex = PixelFormat::coord2index(x, y, srcWidth);
-
-                        uint8 red, green, blue, alpha;
-                        bool hasColor = browsetexelcolor(texelSource, paletteType, paletteData, maxpalette, colorIndex, rasterFormat, red, green, blue, alpha);
-
-                        if ( hasColor )
-                        {
-                            conv.characterize(red, green, blue, alpha);
-                        }
-                    }
-                }
-
-                // Prepare the linear elimination.
-                conv.after_characterize();
-#endif
-
                 colorModelDispatcher fetchDispatch( srcRasterFormat, srcColorOrder, srcDepth, srcPaletteData, srcPaletteCount, srcPaletteType );
 
-                // Linear eliminate.
+                // Feed every color into the histogram.
                 for (uint32 y = 0; y < srcHeight; y++)
                 {
                     const void *srcRow = getConstTexelDataRow( texelSource, srcRowSize, y );
@@ -286,7 +294,7 @@ void PalettizePixelData( Interface *engineInterface, pixelDataTraversal& pixelDa
                 }
             }
 
-            // Construct a palette out of the remaining colors.
+            // Quantize the colors into a palette.
             conv.constructpalette(maxPaletteEntries);
 
             // Point each color from the original texture to the palette.
@@ -928,6 +936,7 @@ void RemapMipmapLayer(
 
         // Put the palette texels into the remapper.
         remapper.texelElimData = paletteContainer;
+        remapper.buildlookup();
 
         // Do the remap.
         nativePaletteRemap(
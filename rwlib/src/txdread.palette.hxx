@@ -1,11 +1,17 @@
-#include <map>
 #include <algorithm>
+#include <vector>
 #define _USE_MATH_DEFINES
 #include <math.h>
+#include <stdlib.h>
 
 namespace rw
 {
 
+// Native color quantizer.
+// Colors are collected into a histogram of unique colors, which is split by median cut
+// into as many boxes as the palette can hold. The box means are then refined using k-means.
+// To map colors to the palette we use an inverse color lookup: the color space is split into
+// cells and every cell knows the palette entries that can be nearest to a color inside of it.
 struct palettizer
 {
     struct texel_t
@@ -26,898 +32,653 @@ struct palettizer
         uint32 usageCount;
     };
 
-    static inline double color2double(uint8 color)
-    {
-        return ( (double)color / 255.0f );
-    }
-
-    static inline uint8 double2color(double num)
-    {
-        return (uint8)( num * 255.0f );
-    }
-
-    static inline double colorbrightness(uint8 red, uint8 green, uint8 blue, uint8 alpha)
-    {
-        return
-            std::max(color2double(red), std::max(color2double(green), color2double(blue))) * color2double(alpha);
-    }
-
     typedef std::vector <texel_t> texelContainer_t;
 
-    static const uint32 maxtexellinearelimination = 25000;
-
+    // The palette, once constructed.
     texelContainer_t texelElimData;
 
-    uint32 alphaZeroTexelCount;
+    // All colors that were fed, packed as RGBA.
+    std::vector <uint32> fedColors;
 
     inline palettizer( void )
     {
-        // Initialize characteristics.
-        this->hasBrightest = false;
-        this->hasDimmest = false;
-
-        texelElimData.reserve( maxtexellinearelimination );
+        return;
+    }
 
-        this->alphaZeroTexelCount = 0;
+    static AINLINE uint32 packcolor( uint8 red, uint8 green, uint8 blue, uint8 alpha )
+    {
+        return ( (uint32)red | ( (uint32)green << 8 ) | ( (uint32)blue << 16 ) | ( (uint32)alpha << 24 ) );
     }
 
-    inline ~palettizer( void )
+    static AINLINE uint8 colorchannel( uint32 packed, uint32 channel )
     {
-        return;
+        return (uint8)( packed >> ( channel * 8 ) );
     }
 
-    // Some characteristics about the underlying texels.
-    texel_t brightestColor;
-    double brightest;
-    bool hasBrightest;
+    static AINLINE uint8 texelchannel( const texel_t& texel, uint32 channel )
+    {
+        switch( channel )
+        {
+        case 0: return texel.red;
+        case 1: return texel.green;
+        case 2: return texel.blue;
+        }
 
-    texel_t dimmestColor;
-    double dimmest;
-    bool hasDimmest;
+        return texel.alpha;
+    }
 
-    template <typename resultType>
-    struct resultCache
+    inline void feedcolor( uint8 red, uint8 green, uint8 blue, uint8 alpha )
     {
-        struct indexTuple
+        // Fully transparent colors all look the same.
+        if ( alpha == 0 )
         {
-            uint32 i, n;
+            red = 0;
+            green = 0;
+            blue = 0;
+        }
 
-            inline indexTuple(uint32 i, uint32 n)
-            {
-                this->i = i;
-                this->n = n;
-            }
+        fedColors.push_back( packcolor( red, green, blue, alpha ) );
+    }
 
-            inline bool operator == ( const indexTuple& right ) const
-            {
-                return ( this->i == right.i && this.n == right.n || this->i == right.n && this->n == right.i );
-            }
+    // A unique color of the histogram.
+    struct histColor_t
+    {
+        uint8 channels[4];
+        uint32 count;
+    };
 
-            inline bool operator < ( const indexTuple& right ) const
-            {
-                return false;
-            }
-        };
+    // A range of histogram colors that become one palette entry.
+    struct colorBox_t
+    {
+        uint32 begin, end;
 
-        typedef std::map <indexTuple, resultType> resultMap_t;
+        double error;       // weighted sum of squared distances to the mean
+        uint32 splitChannel;
+    };
 
-        resultMap_t results;
+    static inline void analyzebox( const std::vector <histColor_t>& colors, colorBox_t& box )
+    {
+        double sum[4] = { 0, 0, 0, 0 };
+        double sumSq[4] = { 0, 0, 0, 0 };
+        double totalCount = 0;
 
-        inline bool getCachedResult(uint32 i, uint32 n, resultType& result)
+        for ( uint32 n = box.begin; n < box.end; n++ )
         {
-            resultMap_t::const_iterator forward_iter = results.find( indexTuple(i, n) );
+            const histColor_t& color = colors[ n ];
 
-            if ( forward_iter != results.end() )
+            double count = color.count;
+
+            for ( uint32 c = 0; c < 4; c++ )
             {
-                result = forward_iter->second;
-                return true;
+                double value = color.channels[ c ];
+
+                sum[ c ] += value * count;
+                sumSq[ c ] += value * value * count;
             }
 
-            return false;
+            totalCount += count;
         }
 
-        inline void putCachedResult(uint32 i, uint32 n, const resultType& result)
-        {
-            results[ indexTuple(i, n) ] = result;
-        }
+        double error = 0;
+        double largestVariance = -1;
 
-        inline void eliminate(uint32 n)
+        for ( uint32 c = 0; c < 4; c++ )
         {
-            resultMap_t::iterator iter = results.begin();
+            double variance = ( sumSq[ c ] - sum[ c ] * sum[ c ] / totalCount );
 
-            while (iter != results.end())
-            {
-                const indexTuple& tuple = iter->first;
+            error += variance;
 
-                if (tuple.n == n || tuple.i == n)
-                {
-                    iter = results.erase(iter);
-                }
-                else
-                {
-                    iter++;
-                }
+            if ( variance > largestVariance )
+            {
+                largestVariance = variance;
+                box.splitChannel = c;
             }
         }
-    };
 
-    template <typename criteriaType>
-    inline bool findmostsimilarpixel(const criteriaType& parser, typename criteriaType::result_t& theResult, uint32 first, uint32& second)
-    {
-        uint32 numTexels = (uint32)texelElimData.size();
+        // A box of one color cannot be split.
+        box.error = ( box.end - box.begin > 1 ? error : -1 );
+    }
 
-        uint32 smallest;
-        typename criteriaType::result_t smallestResult;
-        bool hasSmallest = false;
+    static inline texel_t boxmean( const std::vector <histColor_t>& colors, const colorBox_t& box )
+    {
+        double sum[4] = { 0, 0, 0, 0 };
+        double totalCount = 0;
 
+        for ( uint32 n = box.begin; n < box.end; n++ )
         {
-            const texel_t& firstComparand = texelElimData.at( first );
+            const histColor_t& color = colors[ n ];
 
-            for (uint32 i = 0; i < numTexels; i++)
+            for ( uint32 c = 0; c < 4; c++ )
             {
-                if (i != first)
-                {
-                    const texel_t& secondComparand = texelElimData.at( i );
-
-                    typename criteriaType::result_t thisResult = parser.getCriteria(firstComparand, secondComparand);
-
-                    if (!hasSmallest || parser.isSmaller(thisResult, smallestResult))
-                    {
-                        smallest = i;
-                        smallestResult = thisResult;
-
-                        if (!hasSmallest)
-                        {
-                            hasSmallest = true;
-                        }
-                    }
-                }
+                sum[ c ] += (double)color.channels[ c ] * color.count;
             }
-        }
 
-        if (hasSmallest)
-        {
-            second = smallest;
-            theResult = smallestResult;
+            totalCount += color.count;
         }
 
-        return hasSmallest;
-    }
+        texel_t mean;
+        mean.red = (uint8)( sum[0] / totalCount + 0.5 );
+        mean.green = (uint8)( sum[1] / totalCount + 0.5 );
+        mean.blue = (uint8)( sum[2] / totalCount + 0.5 );
+        mean.alpha = (uint8)( sum[3] / totalCount + 0.5 );
+        mean.usageCount = (uint32)totalCount;
 
-    template <typename criteriaType>
-    inline bool findpixelundercriteria(const criteriaType& parser, typename criteriaType::result_t& theResult, uint32& first, uint32& second)
-    {
-        size_t numTexels = texelElimData.size();
+        return mean;
+    }
 
-        uint32 smallest_first, smallest_second;
-        typename criteriaType::result_t smallest;
-        bool hasSmallest = false;
+    // Amount of k-means passes after median cut.
+    static const uint32 maxrefinementpasses = 8;
 
-        for (size_t n = 0; n < numTexels; n++)
+    inline void constructpalette( uint32 maxentries )
+    {
+        // Build the histogram of unique colors.
+        std::vector <histColor_t> colors;
         {
-            const texel_t& firstComparand = texelElimData.at( n );
+            std::sort( fedColors.begin(), fedColors.end() );
+
+            size_t fedCount = fedColors.size();
+            size_t n = 0;
 
-            for (size_t i = 0; i < numTexels; i++)
+            while ( n < fedCount )
             {
-                if (i != n)
-                {
-                    typename criteriaType::result_t thisResult;
+                uint32 packed = fedColors[ n ];
 
-                    const texel_t& secondComparand = texelElimData.at( i );
+                size_t runEnd = n + 1;
 
-                    thisResult = parser.getCriteria(firstComparand, secondComparand);
+                while ( runEnd < fedCount && fedColors[ runEnd ] == packed )
+                {
+                    runEnd++;
+                }
 
-                    if (!hasSmallest || parser.isSmaller(thisResult, smallest))
-                    {
-                        smallest_first = n;
-                        smallest_second = i;
-                        smallest = thisResult;
+                histColor_t color;
 
-                        if (!hasSmallest)
-                        {
-                            hasSmallest = true;
-                        }
-                    }
+                for ( uint32 c = 0; c < 4; c++ )
+                {
+                    color.channels[ c ] = colorchannel( packed, c );
                 }
-            }
-        }
 
-        if (hasSmallest)
-        {
-            first = smallest_first;
-            second = smallest_second;
-            theResult = smallest;
-        }
+                color.count = (uint32)( runEnd - n );
 
-        return hasSmallest;
-    }
+                colors.push_back( color );
 
-    struct brightnessCriteria
-    {
-        bool calculateBrightest;
+                n = runEnd;
+            }
 
-        inline brightnessCriteria(bool brightest)
-        {
-            this->calculateBrightest = brightest;
+            // We do not need the texels anymore.
+            std::vector <uint32> ().swap( fedColors );
         }
 
-        typedef double result_t;
+        texelElimData.clear();
+
+        if ( colors.empty() || maxentries == 0 )
+            return;
 
-        inline result_t getCriteria(const texel_t& firstComparand, const texel_t& secondComparand) const
+        // Median cut: split the box with the biggest error until the palette is full.
+        std::vector <colorBox_t> boxes;
         {
-            double firstBrightness =
-                colorbrightness(firstComparand.red, firstComparand.green, firstComparand.blue, firstComparand.alpha);
+            colorBox_t rootBox;
+            rootBox.begin = 0;
+            rootBox.end = (uint32)colors.size();
 
-            double secondBrightness =
-                colorbrightness(secondComparand.red, secondComparand.green, secondComparand.blue, secondComparand.alpha);
+            analyzebox( colors, rootBox );
 
-            return fabs( std::max(firstBrightness, secondBrightness) - std::min(firstBrightness, secondBrightness) );
+            boxes.push_back( rootBox );
         }
 
-        inline bool isSmaller(result_t first, result_t second) const
+        while ( boxes.size() < maxentries )
         {
-            return ( calculateBrightest ) ? (first > second) : (first < second);
-        }
-    };
+            size_t splitIndex = 0;
+            double largestError = -1;
 
-    struct colordiffCriteria
-    {
-        struct result_t
-        {
-            double angleDiff;
-            double distance;
-            double alphaDist;
-
-            inline double getCriterion( void ) const
+            for ( size_t n = 0; n < boxes.size(); n++ )
             {
-                return ( distance + alphaDist * 10 );
+                if ( boxes[ n ].error > largestError )
+                {
+                    largestError = boxes[ n ].error;
+                    splitIndex = n;
+                }
             }
-        };
 
-        struct vec4_t
-        {
-            double x, y, z, w;
-        };
+            if ( largestError < 0 )
+            {
+                // Every box is a single color.
+                break;
+            }
 
-        static inline double rad2deg(double rad)
-        {
-            return rad * 180 / M_PI;
-        }
+            colorBox_t box = boxes[ splitIndex ];
 
-        static inline double deg2rad(double deg)
-        {
-            return deg / 180 * M_PI;
-        }
+            uint32 channel = box.splitChannel;
 
-        inline static void RGB2HSV(const texel_t& color, double& hueOut, double& saturationOut, double& valueOut)
-        {
-            // Transform all color components into doubles.
-            double firstRed = color2double(color.red);
-            double firstGreen = color2double(color.green);
-            double firstBlue = color2double(color.blue);
+            // Find the weighted median value of the channel.
+            uint64 valueCounts[ 256 ] = { 0 };
+            uint64 totalCount = 0;
 
-            double low = std::min(firstRed, std::min(firstGreen, firstBlue));
-            double brightness = std::max(firstRed, std::max(firstGreen, firstBlue));
+            for ( uint32 n = box.begin; n < box.end; n++ )
+            {
+                const histColor_t& color = colors[ n ];
 
-            double delta = brightness - low;
+                valueCounts[ color.channels[ channel ] ] += color.count;
+                totalCount += color.count;
+            }
 
-            double hueColor = 0;
+            uint32 lowestValue = 0;
 
-            double saturation = 0.0f;
+            while ( valueCounts[ lowestValue ] == 0 )
+            {
+                lowestValue++;
+            }
 
-            double colorX = 0;
-            double colorY = 0;
+            // Colors up to splitValue go into the low box. The box has more than one value in
+            // this channel, so we stop before the highest value to keep both halves non-empty.
+            uint32 splitValue = lowestValue;
+            uint64 runningCount = valueCounts[ lowestValue ];
 
-            if (delta != 0)
+            for ( uint32 value = lowestValue + 1; value < 256 && runningCount < ( totalCount / 2 ); value++ )
             {
-                saturation = delta / brightness;
+                if ( valueCounts[ value ] == 0 )
+                    continue;
 
-                double deltar = (brightness - firstRed);
-                double deltag = (brightness - firstGreen);
-                double deltab = (brightness - firstBlue);
+                if ( runningCount + valueCounts[ value ] == totalCount )
+                    break;
 
-                // Calculate the hue angle.
-                double hueStart, hueModDelta;
+                splitValue = value;
+                runningCount += valueCounts[ value ];
+            }
 
-                if (firstRed == brightness)
+            uint32 splitAt = (uint32)( std::partition( colors.begin() + box.begin, colors.begin() + box.end,
+                [channel, splitValue]( const histColor_t& color )
                 {
-                    hueStart = (0.0/3.0);
-                    hueModDelta = (deltab - deltag);
-                }
-                else if (firstGreen == brightness)
-                {
-                    hueStart = (1.0/3.0);
-                    hueModDelta = (deltar - deltab);
-                }
-                else if (firstBlue == brightness)
-                {
-                    hueStart = (2.0/3.0);
-                    hueModDelta = (deltag - deltar);
+                    return ( color.channels[ channel ] <= splitValue );
                 }
+            ) - colors.begin() );
 
-                // Adjust the HUE mod.
-                double hueMod = ((hueModDelta / 6.0) + delta / 2) / brightness;
+            colorBox_t lowBox;
+            lowBox.begin = box.begin;
+            lowBox.end = splitAt;
 
-                // Calculate the hue region.
-                hueColor = hueStart + hueMod;
+            colorBox_t highBox;
+            highBox.begin = splitAt;
+            highBox.end = box.end;
 
-                // Convert it to an angle.
-                if ( hueColor < 0 )
-                {
-                    hueColor = hueColor + 1;
-                }
-                else if ( hueColor > 1 )
-                {
-                    hueColor = hueColor - 1;
-                }
-
-                hueColor = hueColor * M_PI * 2;
-            }
+            analyzebox( colors, lowBox );
+            analyzebox( colors, highBox );
 
-            // Give the hue to the runtime.
-            hueOut = hueColor;
-
-            saturationOut = saturation;
-
-            valueOut = brightness;
+            boxes[ splitIndex ] = lowBox;
+            boxes.push_back( highBox );
         }
 
-        inline static double saturatecolor(double theColor)
+        texelElimData.reserve( boxes.size() );
+
+        for ( const colorBox_t& box : boxes )
         {
-            return std::min(1.0, std::max(0.0, theColor));
+            texelElimData.push_back( boxmean( colors, box ) );
         }
 
-        inline static void HSV2RGB(double hue, double saturation, double value, texel_t& colorOut)
-        {
-            // Convert the HUE to RGB.
-            double hueFloatingPoint = ( hue / M_PI / 2 );
+        // Refine the palette with k-means.
+        size_t paletteSize = texelElimData.size();
+
+        std::vector <uint32> assignment( colors.size(), 0xFFFFFFFF );
 
-            double delta = value * saturation;
+        // Building the lookup costs about as much as searching the palette for a few ten thousand colors.
+        bool useLookup = ( colors.size() > lookupCellCount * 2 );
 
-            double redColor;
-            double greenColor;
-            double blueColor;
+        // While refining, the lookup only has to know the cells that contain histogram colors.
+        std::vector <bool> usedCells;
 
-            if (delta == 0)
+        if ( useLookup )
+        {
+            usedCells.resize( lookupCellCount, false );
+
+            for ( const histColor_t& color : colors )
             {
-                redColor = 0;
-                greenColor = 0;
-                blueColor = 0;
+                usedCells[ getlookupcell( color.channels[0], color.channels[1], color.channels[2], color.channels[3] ) ] = true;
             }
-            else
+        }
+
+        for ( uint32 pass = 0; pass < maxrefinementpasses; pass++ )
+        {
+            if ( useLookup )
             {
-                double hueStartPlusMod = hueFloatingPoint - delta/2/value;
+                buildlookup( &usedCells );
+            }
 
-                double hueRegion = hueStartPlusMod;
+            std::vector <double> sums( paletteSize * 4, 0.0 );
+            std::vector <double> counts( paletteSize, 0.0 );
 
-                // Normalize the hue.
-                while (hueRegion < 0.0)
-                {
-                    hueRegion += 1.0;
-                }
+            bool hasChanged = false;
 
-                while (hueRegion >= 1.0)
-                {
-                    hueRegion -= 1.0;
-                }
+            for ( size_t n = 0; n < colors.size(); n++ )
+            {
+                const histColor_t& color = colors[ n ];
 
-                double hueStart = 0.0f;
+                uint32 index;
 
-                if (hueRegion >= 0.0 && hueRegion <= (1.0/6.0))
+                if ( useLookup )
                 {
-                    // brightest: red, green, blue
-                    redColor = value;
-                    blueColor = value - delta;
-
-                    hueStart = (0.0/3.0);
+                    index = getclosestlink( color.channels[0], color.channels[1], color.channels[2], color.channels[3] );
                 }
-                else if (hueRegion <= (2.0/6.0))
-                {
-                    // brightest: green, red, blue
-                    greenColor = value;
-                    blueColor = value - delta;
-
-                    hueStart = (1.0/3.0);
-                }
-                else if (hueRegion <= (3.0/6.0))
+                else
                 {
-                    // brightest: green, blue, red
-                    greenColor = value;
-                    redColor = value - delta;
-
-                    hueStart = (1.0/3.0);
+                    index = searchclosest( 0, (uint32)paletteSize, NULL, color.channels[0], color.channels[1], color.channels[2], color.channels[3] );
                 }
-                else if (hueRegion <= (4.0/6.0))
-                {
-                    // brightest: blue, green, red
-                    blueColor = value;
-                    redColor = value - delta;
 
-                    hueStart = (2.0/3.0);
-                }
-                else if (hueRegion <= (5.0/6.0))
+                if ( assignment[ n ] != index )
                 {
-                    // brightest: blue, red, green
-                    blueColor = value;
-                    greenColor = value - delta;
-
-                    hueStart = (2.0/3.0);
-                }
-                else if (hueRegion <= 1.0)
-                {
-                    // brightest: red, blue, green
-                    redColor = value;
-                    greenColor = value - delta;
-
-                    hueStart = 0;
+                    assignment[ n ] = index;
+                    hasChanged = true;
                 }
 
-                double hueMod = ( hueFloatingPoint - hueStart );
+                double count = color.count;
 
-                double hueModDelta = (delta/2 + (hueMod * value));
-
-                if (hueRegion <= (1.0/6.0))
-                {
-                    greenColor = (hueModDelta + blueColor);
-                }
-                else if (hueRegion <= (2.0/6.0))
-                {
-                    redColor = (hueModDelta + blueColor);
-                }
-                else if (hueRegion <= (3.0/6.0))
-                {
-                    blueColor = (hueModDelta + redColor);
-                }
-                else if (hueRegion <= (4.0/6.0))
-                {
-                    greenColor = (hueModDelta + redColor);
-                }
-                else if (hueRegion <= (5.0/6.0))
+                for ( uint32 c = 0; c < 4; c++ )
                 {
-                    redColor = (hueModDelta + greenColor);
+                    sums[ index * 4 + c ] += color.channels[ c ] * count;
                 }
-                else if (hueRegion <= 1.0)
-                {
-                    blueColor = (hueModDelta + greenColor);
-                }
-            }
-
-            // Normalize the colors.
-            double hueRed = value - redColor;
-            double hueBlue = value - blueColor;
-            double hueGreen = value - greenColor;
-
-            // Put it into our vector.
-            uint8 brightnessColor = double2color(value);
 
-            colorOut.red = brightnessColor - double2color(hueRed);
-            colorOut.green = brightnessColor - double2color(hueGreen);
-            colorOut.blue = brightnessColor - double2color(hueBlue);
-        }
-
-        inline void getHSVPropertiesOfColor(const texel_t& color, double& hueOut, vec4_t& vecOut) const
-        {
-            // Give the perfect transparency a special position.
-            if (color.alpha == 0)
-            {
-                hueOut = 0;
-                vecOut.x = 0;
-                vecOut.y = 0;
-                vecOut.z = 0;
-                vecOut.w = -9001;
-                return;
+                counts[ index ] += count;
             }
 
-            double brightness, saturation, hueColor;
-
-            RGB2HSV(color, hueColor, saturation, brightness);
+            if ( !hasChanged )
+                break;
 
-            // Construct the HUE color coordinate.
-            double colorX = (cos(hueColor) * saturation);
-            double colorY = (sin(hueColor) * saturation);
-
-            // Create the blackness vector.
-            double blacknessZ =
-                (1.0 - brightness) * 1.7;
+            for ( size_t n = 0; n < paletteSize; n++ )
+            {
+                double count = counts[ n ];
 
-            // Create the alpha vector
-            double alphaW =
-                (1.0 - color2double(color.alpha)) * 2.4;
+                // Entries that nothing maps to are left alone.
+                if ( count == 0 )
+                    continue;
 
-            // Construct the coordinate.
-            vecOut.x = colorX;
-            vecOut.y = colorY;
-            vecOut.z = blacknessZ;
-            vecOut.w = alphaW;
+                texel_t& entry = texelElimData[ n ];
 
-            hueOut = hueColor;
+                entry.red = (uint8)( sums[ n * 4 + 0 ] / count + 0.5 );
+                entry.green = (uint8)( sums[ n * 4 + 1 ] / count + 0.5 );
+                entry.blue = (uint8)( sums[ n * 4 + 2 ] / count + 0.5 );
+                entry.alpha = (uint8)( sums[ n * 4 + 3 ] / count + 0.5 );
+                entry.usageCount = (uint32)count;
+            }
         }
 
-        inline static double anglemorph(double angle, double morph)
-        {
-            bool needsRecursion = false;
+        // The palette may have changed in the last pass.
+        buildlookup();
+    }
 
-            do
-            {
-                needsRecursion = false;
+    inline void* makepalette(Interface *engineInterface, eRasterFormat rasterFormat, eColorOrdering colorOrder)
+    {
+        uint32 palDepth = Bitmap::getRasterFormatDepth(rasterFormat);
 
-                if ( angle > morph )
-                {
-                    angle -= M_PI * 2;
+        uint32 palItemCount = (uint32)texelElimData.size();
 
-                    needsRecursion = true;
-                }
-                else if ( angle < -morph )
-                {
-                    angle += M_PI * 2;
+        uint32 palDataSize = getPaletteDataSize( palItemCount, palDepth );
 
-                    needsRecursion = true;
-                }
-            }
-            while ( needsRecursion );
+        // Allocate a container for the palette.
+        void *paletteData = engineInterface->PixelAllocate( palDataSize );
 
-            return angle;
-        }
+        uint32 n = 0;
 
-        inline static double normalizeangledistance(double angle)
-        {
-            return anglemorph(angle, M_PI);
-        }
+        colorModelDispatcher putDispatch( rasterFormat, colorOrder, palDepth, NULL, 0, PALETTE_NONE );
 
-        inline static double normalizeangle(double angle)
+        for ( texelContainer_t::const_iterator iter = texelElimData.begin(); iter != texelElimData.end(); iter++ )
         {
-            return anglemorph(angle, M_PI * 2);
-        }
+            const texel_t& curTexel = *iter;
 
-        inline static double anglediff(double first, double second)
-        {
-            return normalizeangledistance( first - second );
+            putDispatch.setRGBA(paletteData, n++, curTexel.red, curTexel.green, curTexel.blue, curTexel.alpha);
         }
 
-        inline result_t getCriteria(const texel_t& first, const texel_t& second) const
-        {
-            double firstHUE, secondHUE;
-            vec4_t firstVec, secondVec;
-
-            // Calculate HSV color properties using an extended 4-dimensional model.
-            getHSVPropertiesOfColor(first, firstHUE, firstVec);
-            getHSVPropertiesOfColor(second, secondHUE, secondVec);
-    
-            // Calculate the distance between HUE angles.
-            double angleDiff = fabs( anglediff(firstHUE, secondHUE) );
-
-            // Construct the difference between the two vectors.
-            vec4_t vecDiff;
-            vecDiff.x = ( firstVec.x - secondVec.x );
-            vecDiff.y = ( firstVec.y - secondVec.y );
-            vecDiff.z = ( firstVec.z - secondVec.z );
-            vecDiff.w = ( firstVec.w - secondVec.w );
-
-            // Calculate the distance result.
-            result_t result;
-            result.angleDiff = angleDiff;
-            result.distance = sqrt( vecDiff.x*vecDiff.x + vecDiff.y*vecDiff.y + vecDiff.z*vecDiff.z + vecDiff.w*vecDiff.w );
-
-            double alphaColor = color2double(first.alpha);
-            double alphaColor2 = color2double(second.alpha);
-
-            result.alphaDist = fabs(alphaColor - alphaColor2);
-
-            return result;
-        }
+        return paletteData;
+    }
 
-        inline bool isSmaller(result_t first, result_t second) const
-        {
-            return
-                first.getCriterion() < second.getCriterion();
-        }
-    };
+    // Inverse color lookup.
+    // The color space is split into cells that span 16 values of red, green and blue and 32 values of alpha.
+    // Cell candidates are found in two steps: first for cells of twice the size, then for the cells inside
+    // of them using only the candidates of the bigger cell.
+    static const uint32 lookupColorBits = 4;
+    static const uint32 lookupAlphaBits = 3;
+
+    static const uint32 lookupCellCount = ( 1 << ( lookupColorBits * 3 + lookupAlphaBits ) );
 
-    inline void characterize(uint8 red, uint8 green, uint8 blue, uint8 alpha)
+    struct lookupCell_t
     {
-        // Define properties about this color and set up conversion hints.
-#if 0
-        brightnessCriteria bright(true);
+        uint32 candidateStart;
+        uint32 candidateCount;
+    };
 
-        findpixelundercriteria(bright, this->brightest, 
-#endif
+    std::vector <lookupCell_t> lookupCells;
+    std::vector <uint8> lookupCandidates;
 
-        this->alphaZeroTexelCount++;
+    static AINLINE uint32 getlookupcell( uint8 red, uint8 green, uint8 blue, uint8 alpha )
+    {
+        const uint32 colorShift = ( 8 - lookupColorBits );
+        const uint32 alphaShift = ( 8 - lookupAlphaBits );
+
+        return
+            ( (uint32)( red >> colorShift ) ) |
+            ( (uint32)( green >> colorShift ) << lookupColorBits ) |
+            ( (uint32)( blue >> colorShift ) << ( lookupColorBits * 2 ) ) |
+            ( (uint32)( alpha >> alphaShift ) << ( lookupColorBits * 3 ) );
     }
 
-    inline void after_characterize(void)
+    static AINLINE uint32 colordistance( const texel_t& entry, uint8 red, uint8 green, uint8 blue, uint8 alpha )
     {
-        return;
+        int32 dr = ( (int32)entry.red - red );
+        int32 dg = ( (int32)entry.green - green );
+        int32 db = ( (int32)entry.blue - blue );
+        int32 da = ( (int32)entry.alpha - alpha );
+
+        return (uint32)( dr * dr + dg * dg + db * db + da * da );
     }
 
-    template <typename numType>
-    inline static numType weightedmiddle(numType first, numType second, numType firstWeight, numType secondWeight)
+    // Puts the entries of inCandidates that can be the closest for any color inside of [low, high] into outCandidates.
+    inline void findcandidates(
+        const uint8 *inCandidates, uint32 inCount, const int32 low[4], const int32 high[4],
+        std::vector <uint32>& minDist, std::vector <uint8>& outCandidates
+    ) const
     {
-        double weightCompositor = ( firstWeight + secondWeight );
-
-        numType result = 0;
+        // Any color in the cell is at most this far away from its nearest entry.
+        uint32 bestMaxDist = 0xFFFFFFFF;
 
-        if ( weightCompositor != 0 )
+        for ( uint32 n = 0; n < inCount; n++ )
         {
-            result = ( first * firstWeight + second * secondWeight ) / weightCompositor;
-        }
+            const texel_t& entry = texelElimData[ inCandidates[ n ] ];
 
-        return result;
-    }
+            uint32 entryMinDist = 0;
+            uint32 entryMaxDist = 0;
 
-    inline static uint8 colormiddle(uint8 first, uint8 second, double firstWeight, double secondWeight)
-    {
-        double firstColor = color2double(first);
-        double secondColor = color2double(second);
+            for ( uint32 c = 0; c < 4; c++ )
+            {
+                int32 value = texelchannel( entry, c );
 
-        double weighted = weightedmiddle(firstColor, secondColor, firstWeight, secondWeight);
+                int32 minDelta = 0;
 
-        return (uint8)( weighted * 255.0 );
-    }
+                if ( value < low[ c ] )
+                {
+                    minDelta = ( low[ c ] - value );
+                }
+                else if ( value > high[ c ] )
+                {
+                    minDelta = ( value - high[ c ] );
+                }
 
-    colordiffCriteria crit;
+                int32 maxDelta = std::max( abs( value - low[ c ] ), abs( value - high[ c ] ) );
 
-    inline void feedcolor(uint8 red, uint8 green, uint8 blue, uint8 alpha)
-    {
-        // Try to find an already existing color that is same as the given one.
-        bool texelExists = false;
+                entryMinDist += (uint32)( minDelta * minDelta );
+                entryMaxDist += (uint32)( maxDelta * maxDelta );
+            }
 
-        texel_t theTexel;
+            minDist[ n ] = entryMinDist;
 
-        theTexel.red = red;
-        theTexel.green = green;
-        theTexel.blue = blue;
-        theTexel.alpha = alpha;
+            bestMaxDist = std::min( bestMaxDist, entryMaxDist );
+        }
 
-        for (uint32 n = 0; n < texelElimData.size(); n++)
+        // Only entries that can be closer than that are candidates.
+        // They stay in palette order, so that ties go to the lowest index.
+        for ( uint32 n = 0; n < inCount; n++ )
         {
-            texel_t& compTexel = texelElimData[n];
-
-            bool isTheTexel = false;
-
-            if ( !isTheTexel )
+            if ( minDist[ n ] <= bestMaxDist )
             {
-                colordiffCriteria::result_t criterion = crit.getCriteria(compTexel, theTexel);
-
-                isTheTexel =
-                    ( criterion.angleDiff < colordiffCriteria::deg2rad(2.75) &&
-                      criterion.distance < 0.15 &&
-                      criterion.alphaDist < 0.075 );
+                outCandidates.push_back( inCandidates[ n ] );
             }
+        }
+    }
 
-            if (isTheTexel)
-            {
-                // We already have this texel, so dont add it.
-                texelExists = true;
+    // Searches the palette entries [iter, end) for the closest one. If candidates is not NULL,
+    // the range indexes into it instead of the palette.
+    inline uint32 searchclosest( uint32 iter, uint32 end, const uint8 *candidates, uint8 red, uint8 green, uint8 blue, uint8 alpha ) const
+    {
+        const texel_t *palette = texelElimData.data();
 
-                // Increase the usage count.
-                compTexel.usageCount++;
-            }
-        }
+        uint32 closestIndex = 0;
+        uint32 closestDist = 0xFFFFFFFF;
 
-        if ( !texelExists )
+        for ( ; iter < end; iter++ )
         {
-            theTexel.usageCount++;
+            uint32 index = ( candidates ? candidates[ iter ] : iter );
 
-            // If the texel was not found, eliminate ourselves.
-            texelElimData.push_back( theTexel );
+            uint32 dist = colordistance( palette[ index ], red, green, blue, alpha );
+
+            if ( dist < closestDist )
+            {
+                closestIndex = index;
+                closestDist = dist;
+            }
         }
-    }
 
-    static inline bool sortByUsageCount(const texel_t& left, const texel_t& right)
-    {
-        return ( left.usageCount > right.usageCount );
+        return closestIndex;
     }
 
-    struct similarPixels_t
+    // Has to be called after the palette (texelElimData) has changed and before getclosestlink.
+    // If usedCells is given, only the cells marked in it can be looked up.
+    inline void buildlookup( const std::vector <bool> *usedCells = NULL )
     {
-        const colordiffCriteria *crit;
+        uint32 paletteSize = (uint32)texelElimData.size();
 
-        uint32 first_index;
-        uint32 second_index;
+        assert( paletteSize <= 256 );
 
-        colordiffCriteria::result_t theResult;
+        lookupCells.resize( lookupCellCount );
+        lookupCandidates.clear();
 
-        inline bool operator < ( const similarPixels_t& right ) const
-        {
-            return crit->isSmaller( theResult, right.theResult );
-        }
+        uint8 allEntries[ 256 ];
 
-        inline bool operator == ( const similarPixels_t& right ) const
+        for ( uint32 n = 0; n < paletteSize; n++ )
         {
-            return ( this->first_index == right.first_index && this->second_index == right.second_index ||
-                     this->first_index == right.second_index && this->second_index == right.first_index );
+            allEntries[ n ] = (uint8)n;
         }
-    };
 
-    inline void constructpalette(uint32 maxentries)
-    {
-        // Construct similarity lists of texels while the amount of texels is too big.
-        while ( texelElimData.size() > maxentries )
-        {
-            uint32 numTexels = (uint32)texelElimData.size();
+        std::vector <uint32> minDist( paletteSize );
+        std::vector <uint8> parentCandidates;
 
-            typedef std::vector <similarPixels_t> simList_t;
+        const uint32 colorCellSize = ( 1 << ( 8 - lookupColorBits ) );
+        const uint32 alphaCellSize = ( 1 << ( 8 - lookupAlphaBits ) );
 
-            simList_t similarities;
+        const uint32 colorCells = ( 1 << lookupColorBits );
+        const uint32 alphaCells = ( 1 << lookupAlphaBits );
 
-            similarities.reserve( numTexels );
-
-            for ( uint32 n = 0; n < numTexels; n++ )
+        for ( uint32 pa = 0; pa < alphaCells; pa += 2 )
+        {
+            for ( uint32 pb = 0; pb < colorCells; pb += 2 )
             {
-                uint32 smallest;
-                colordiffCriteria::result_t smallest_result;
-
-                bool hasFound = findmostsimilarpixel(crit, smallest_result, n, smallest);
+                for ( uint32 pg = 0; pg < colorCells; pg += 2 )
+                {
+                    for ( uint32 pr = 0; pr < colorCells; pr += 2 )
+                    {
+                        const uint32 parentCoord[4] = { pr, pg, pb, pa };
 
-                assert( hasFound == true );
+                        // Get the cells inside of this one.
+                        uint32 childCells[ 16 ];
+                        uint32 childCount = 0;
 
-                // Store it.
-                similarPixels_t sim;
-                sim.first_index = n;
-                sim.second_index = smallest;
-                sim.theResult = smallest_result;
-                sim.crit = &crit;
+                        for ( uint32 child = 0; child < 16; child++ )
+                        {
+                            uint32 childCoord[4];
 
-                // Make sure this is not already in the list.
-                if ( std::find( similarities.begin(), similarities.end(), sim ) == similarities.end() )
-                {
-                    similarities.push_back( sim );
-                }
-            }
+                            for ( uint32 c = 0; c < 4; c++ )
+                            {
+                                childCoord[ c ] = ( parentCoord[ c ] + ( ( child >> c ) & 1 ) );
+                            }
 
-            // Sort the list so that the most similar pixels come first.
-            std::sort( similarities.begin(), similarities.end() );
+                            uint32 cellIndex =
+                                childCoord[0] |
+                                ( childCoord[1] << lookupColorBits ) |
+                                ( childCoord[2] << ( lookupColorBits * 2 ) ) |
+                                ( childCoord[3] << ( lookupColorBits * 3 ) );
 
-            // Merge the colors to create a new color list.
-            std::vector <texel_t> newColors;
+                            lookupCell_t& cell = lookupCells[ cellIndex ];
 
-            for ( simList_t::const_iterator iter = similarities.begin(); iter != similarities.end(); iter++ )
-            {
-                const similarPixels_t& sim = *iter;
+                            cell.candidateStart = (uint32)lookupCandidates.size();
+                            cell.candidateCount = 0;
 
-                const colordiffCriteria::result_t& colorDiff = sim.theResult;
+                            if ( usedCells == NULL || (*usedCells)[ cellIndex ] )
+                            {
+                                childCells[ childCount++ ] = cellIndex;
+                            }
+                        }
 
-                uint32 first_diff = sim.first_index;
-                uint32 second_diff = sim.second_index;
+                        if ( childCount == 0 )
+                            continue;
 
-                bool isCloseEnough =
-                    colorDiff.angleDiff < colordiffCriteria::deg2rad(1.5) &&
-                    colorDiff.distance < 0.05 &&
-                    colorDiff.alphaDist < 0.1;
+                        int32 low[4], high[4];
 
-                if (isCloseEnough)
-                {
-                    // Delete the texel that is used the least.
-                    const texel_t& firstTexel = texelElimData.at( first_diff );
-                    const texel_t& secondTexel = texelElimData.at( second_diff );
+                        for ( uint32 c = 0; c < 4; c++ )
+                        {
+                            uint32 cellSize = ( c == 3 ? alphaCellSize : colorCellSize );
 
-                    if ( firstTexel.usageCount < secondTexel.usageCount )
-                    {
-                        newColors.push_back( secondTexel );
-                    }
-                    else
-                    {
-                        newColors.push_back( firstTexel );
-                    }
-                }
-                else
-                {
-                    // Generate a color between the color that is close to both colors.
-                    // Then remove both colors, preferring the new one.
-                    texel_t newTexel;
-                    {
-                        const texel_t& firstTexel = texelElimData.at( first_diff );
-                        const texel_t& secondTexel = texelElimData.at( second_diff );
+                            low[ c ] = (int32)( parentCoord[ c ] * cellSize );
+                            high[ c ] = (int32)( low[ c ] + cellSize * 2 - 1 );
+                        }
 
-                        double hue1, saturation1, brightness1,
-                               hue2, saturation2, brightness2;
+                        parentCandidates.clear();
 
-                        double firstAlpha = color2double(firstTexel.alpha);
-                        double secondAlpha = color2double(secondTexel.alpha);
+                        findcandidates( allEntries, paletteSize, low, high, minDist, parentCandidates );
 
-                        double overallNormalWeight = ( firstAlpha + secondAlpha ) / 2;
+                        // Now the cells inside of it.
+                        for ( uint32 child = 0; child < childCount; child++ )
+                        {
+                            uint32 cellIndex = childCells[ child ];
 
-                        double firstWeight = firstAlpha / overallNormalWeight;
-                        double secondWeight = secondAlpha / overallNormalWeight;
+                            for ( uint32 c = 0; c < 4; c++ )
+                            {
+                                uint32 bits = ( c == 3 ? lookupAlphaBits : lookupColorBits );
+                                uint32 cellSize = ( 1 << ( 8 - bits ) );
 
-                        double overallUsageCount = ( (double)firstTexel.usageCount + (double)secondTexel.usageCount ) / 2.0;
+                                uint32 cellCoord = ( cellIndex >> ( c * lookupColorBits ) ) & ( ( 1 << bits ) - 1 );
 
-                        double firstAlphaWeight = (double)firstTexel.usageCount / overallUsageCount;
-                        double secondAlphaWeight = ( 2 - firstAlphaWeight );
-                        
-                        colordiffCriteria::RGB2HSV(firstTexel, hue1, saturation1, brightness1);
-                        colordiffCriteria::RGB2HSV(secondTexel, hue2, saturation2, brightness2);
+                                low[ c ] = (int32)( cellCoord * cellSize );
+                                high[ c ] = (int32)( low[ c ] + cellSize - 1 );
+                            }
 
-                        // Calculate the middle color based on HSVA.
-                        double hueMiddle =
-                            colordiffCriteria::normalizeangle(
-                                hue1 + colordiffCriteria::anglediff(hue2, hue1) / 2
-                            );
+                            lookupCell_t& cell = lookupCells[ cellIndex ];
 
-                        double saturationMiddle = weightedmiddle(saturation1, saturation2, firstWeight, secondWeight);
-                        double brightnessMiddle = weightedmiddle(saturation1, saturation2, firstWeight, secondWeight);
+                            cell.candidateStart = (uint32)lookupCandidates.size();
 
-                        // Get the new RGB value.
-                        colordiffCriteria::HSV2RGB(hueMiddle, saturationMiddle, brightnessMiddle, newTexel);
+                            findcandidates( parentCandidates.data(), (uint32)parentCandidates.size(), low, high, minDist, lookupCandidates );
 
-                        // Alpha is calculated conventionally.
-                        newTexel.alpha = colormiddle(firstTexel.alpha, secondTexel.alpha, firstAlphaWeight, secondAlphaWeight);
+                            cell.candidateCount = ( (uint32)lookupCandidates.size() - cell.candidateStart );
+                        }
                     }
-                    newColors.push_back(newTexel);
                 }
             }
-
-            // Replace the colors.
-            texelElimData = newColors;
         }
     }
 
-    inline void* makepalette(Interface *engineInterface, eRasterFormat rasterFormat, eColorOrdering colorOrder)
+    // Returns the palette entry that is closest to the given color.
+    // Can be called from multiple threads once buildlookup has been called.
+    inline uint32 getclosestlink(uint8 red, uint8 green, uint8 blue, uint8 alpha) const
     {
-        uint32 palDepth = Bitmap::getRasterFormatDepth(rasterFormat);
-
-        uint32 palItemCount = (uint32)texelElimData.size();
-
-        uint32 palDataSize = getPaletteDataSize( palItemCount, palDepth );
-
-        // Allocate a container for the palette.
-        void *paletteData = engineInterface->PixelAllocate( palDataSize );
-
-        uint32 n = 0;
-
-        colorModelDispatcher putDispatch( rasterFormat, colorOrder, palDepth, NULL, 0, PALETTE_NONE );
-
-        for ( texelContainer_t::const_iterator iter = texelElimData.begin(); iter != texelElimData.end(); iter++ )
+        if ( alpha == 0 )
         {
-            const texel_t& curTexel = *iter;
-
-            putDispatch.setRGBA(paletteData, n++, curTexel.red, curTexel.green, curTexel.blue, curTexel.alpha);
+            red = 0;
+            green = 0;
+            blue = 0;
         }
 
-        return paletteData;
-    }
-    
-    inline uint32 getclosestlink(uint8 red, uint8 green, uint8 blue, uint8 alpha)
-    {
-        // Find an index into the palette image that is closest to the given color.
-        colordiffCriteria parser;
-
-        texel_t theTexel;
-        theTexel.red = red;
-        theTexel.green = green;
-        theTexel.blue = blue;
-        theTexel.alpha = alpha;
-
-        uint32 closestIndex;
-        colordiffCriteria::result_t closest;
-        bool hasClosest = false;
-
-        uint32 index = 0;
-
-        for (texelContainer_t::const_iterator iter = texelElimData.begin(); iter != texelElimData.end(); iter++)
-        {
-            const texel_t& curTexel = *iter;
-
-            colordiffCriteria::result_t thisClose = parser.getCriteria(theTexel, curTexel);
+        const lookupCell_t& cell = lookupCells[ getlookupcell( red, green, blue, alpha ) ];
 
-            if (!hasClosest || parser.isSmaller(thisClose, closest))
-            {
-                closestIndex = index;
-                closest = thisClose;
+        uint32 candidateIter = cell.candidateStart;
+        uint32 candidateEnd = ( candidateIter + cell.candidateCount );
 
-                if (!hasClosest)
-                {
-                    hasClosest = true;
-                }
-            }
+        assert( candidateIter != candidateEnd );
 
-            index++;
-        }
-
-        assert(hasClosest == true);
-
-        return closestIndex;
+        return searchclosest( candidateIter, candidateEnd, lookupCandidates.data(), red, green, blue, alpha );
     }
 };
 
@@ -935,4 +696,4 @@ void RemapMipmapLayer(
 // Main palettization function for the pixel conversion framework.
 void PalettizePixelData( Interface *engineInterface, pixelDataTraversal& pixelData, const pixelFormat& dstPixelFormat );
 
-}
\ No newline at end of file
+}
@@ -2,6 +2,8 @@
 
 #include "pixelformat.hxx"
 
+#include "pixelformat.kernels.hxx"
+
 #include "pixelutil.hxx"
 
 #include "txdread.d3d.dxt.hxx"
@@ -326,10 +328,11 @@ void ConvertPaletteDepth(
     );
 }
 
-template <typename srcColorDispatcher, typename dstColorDispatcher>
 inline void copyTexelData(
+    Interface *engineInterface,
     const void *srcTexels, void *dstTexels,
-    srcColorDispatcher& fetchDispatch, dstColorDispatcher& putDispatch,
+    eRasterFormat srcRasterFormat, eColorOrdering srcColorOrder, ePaletteType srcPaletteType, const void *srcPaletteData, uint32 srcPaletteSize,
+    eRasterFormat dstRasterFormat, eColorOrdering dstColorOrder,
     uint32 mipWidth, uint32 mipHeight,
     uint32 srcDepth, uint32 dstDepth,
     uint32 srcRowAlignment, uint32 dstRowAlignment
@@ -338,12 +341,12 @@ inline void copyTexelData(
     uint32 srcRowSize = getRasterDataRowSize( mipWidth, srcDepth, srcRowAlignment );
     uint32 dstRowSize = getRasterDataRowSize( mipWidth, dstDepth, dstRowAlignment );
 
-    copyTexelDataEx(
+    copyTexelDataAccelerated(
+        engineInterface,
         srcTexels, dstTexels,
-        fetchDispatch, putDispatch,
+        srcRasterFormat, srcColorOrder, srcDepth, srcPaletteType, srcPaletteData, srcPaletteSize,
+        dstRasterFormat, dstColorOrder, dstDepth,
         mipWidth, mipHeight,
-        0, 0,
-        0, 0,
         srcRowSize, dstRowSize
     );
 }
@@ -403,12 +406,11 @@ void TransformMipmapLayer(
             else
             {
                 // We always have to do work, but very often we are optimized.
-                colorModelDispatcher fetchDispatch( srcRasterFormat, srcColorOrder, srcDepth, srcPaletteData, srcPaletteSize, srcPaletteType );
-                colorModelDispatcher putDispatch( dstRasterFormat, dstColorOrder, dstDepth, NULL, 0, PALETTE_NONE );
-
                 copyTexelData(
+                    engineInterface,
                     srcTexels, dstTexels,
-                    fetchDispatch, putDispatch,
+                    srcRasterFormat, srcColorOrder, srcPaletteType, srcPaletteData, srcPaletteSize,
+                    dstRasterFormat, dstColorOrder,
                     surfWidth, surfHeight,
                     srcDepth, dstDepth,
                     srcRowAlignment, dstRowAlignment
@@ -511,16 +513,13 @@ bool ConvertMipmapLayerNative(
 
             try
             {
-                colorModelDispatcher fetchDispatch( srcRasterFormat, srcColorOrder, srcDepth, srcPaletteData, srcPaletteSize, srcPaletteType );
-                colorModelDispatcher putDispatch( dstRasterFormat, dstColorOrder, dstDepth, NULL, 0, PALETTE_NONE );
-
                 // Do the conversion.
-                copyTexelDataEx(
+                copyTexelDataAccelerated(
+                    engineInterface,
                     srcTexels, newtexels,
-                    fetchDispatch, putDispatch,
+                    srcRasterFormat, srcColorOrder, srcDepth, srcPaletteType, srcPaletteData, srcPaletteSize,
+                    dstRasterFormat, dstColorOrder, dstDepth,
                     mipWidth, mipHeight,
-                    0, 0,
-                    0, 0,
                     srcRowSize, dstRowSize
                 );
             }
@@ -766,15 +765,12 @@ void CopyTransformRawMipmapLayer(
         }
         else
         {
-            colorModelDispatcher fetchDispatch( srcRasterFormat, srcColorOrder, srcDepth, srcPaletteData, srcPaletteSize, srcPaletteType );
-            colorModelDispatcher putDispatch( dstRasterFormat, dstColorOrder, dstDepth, NULL, 0, PALETTE_NONE );
-
-            copyTexelDataEx(
+            copyTexelDataAccelerated(
+                engineInterface,
                 srcTexels, dstTexels,
-                fetchDispatch, putDispatch,
+                srcRasterFormat, srcColorOrder, srcDepth, srcPaletteType, srcPaletteData, srcPaletteSize,
+                dstRasterFormat, dstColorOrder, dstDepth,
                 surfWidth, surfHeight,
-                0, 0,
-                0, 0,
                 srcRowSize, dstRowSize
             );
         }
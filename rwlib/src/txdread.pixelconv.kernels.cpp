@@ -0,0 +1,1261 @@
+// Format-specialized texel row conversion kernels.
+// Those have to produce the exact same texels as the generic colorModelDispatcher.
+#include "StdInc.h"
+
+#include "pixelformat.kernels.hxx"
+
+#include "rwsimd.hxx"
+
+namespace rw
+{
+
+texelKernelEnvRegister_t texelKernelEnvRegister;
+
+#define TEXEL_SLOT_NONE     4
+
+bool getTexelLayoutInfo( eRasterFormat rasterFormat, uint32 depth, texelLayoutInfo& infoOut )
+{
+    // Layouts follow the bitfield structs that the generic dispatcher uses.
+    struct slotDesc
+    {
+        uint32 shift, bits;
+    };
+
+    eColorModel model;
+    uint32 byteSize;
+    slotDesc slots[ 4 ] = { { 0, 0 }, { 0, 0 }, { 0, 0 }, { 0, 0 } };
+    uint32 preserveMask = 0;
+
+    if ( rasterFormat == RASTER_1555 && depth == 16 )
+    {
+        model = COLORMODEL_RGBA;
+        byteSize = 2;
+        slots[0] = { 0, 5 };
+        slots[1] = { 5, 5 };
+        slots[2] = { 10, 5 };
+        slots[3] = { 15, 1 };
+    }
+    else if ( rasterFormat == RASTER_555 && depth == 16 )
+    {
+        model = COLORMODEL_RGBA;
+        byteSize = 2;
+        slots[0] = { 0, 5 };
+        slots[1] = { 5, 5 };
+        slots[2] = { 10, 5 };
+        preserveMask = 0x8000;
+    }
+    else if ( rasterFormat == RASTER_565 && depth == 16 )
+    {
+        model = COLORMODEL_RGBA;
+        byteSize = 2;
+        slots[0] = { 0, 5 };
+        slots[1] = { 5, 6 };
+        slots[2] = { 11, 5 };
+    }
+    else if ( rasterFormat == RASTER_4444 && depth == 16 )
+    {
+        model = COLORMODEL_RGBA;
+        byteSize = 2;
+        slots[0] = { 0, 4 };
+        slots[1] = { 4, 4 };
+        slots[2] = { 8, 4 };
+        slots[3] = { 12, 4 };
+    }
+    else if ( rasterFormat == RASTER_8888 && depth == 32 )
+    {
+        model = COLORMODEL_RGBA;
+        byteSize = 4;
+        slots[0] = { 0, 8 };
+        slots[1] = { 8, 8 };
+        slots[2] = { 16, 8 };
+        slots[3] = { 24, 8 };
+    }
+    else if ( rasterFormat == RASTER_888 && ( depth == 32 || depth == 24 ) )
+    {
+        model = COLORMODEL_RGBA;
+        byteSize = ( depth / 8 );
+        slots[0] = { 0, 8 };
+        slots[1] = { 8, 8 };
+        slots[2] = { 16, 8 };
+
+        if ( depth == 32 )
+        {
+            // The unused byte is left alone.
+            preserveMask = 0xFF000000;
+        }
+    }
+    else if ( rasterFormat == RASTER_LUM && depth == 8 )
+    {
+        model = COLORMODEL_LUMINANCE;
+        byteSize = 1;
+        slots[0] = { 0, 8 };
+    }
+    else if ( rasterFormat == RASTER_LUM_ALPHA && depth == 8 )
+    {
+        model = COLORMODEL_LUMINANCE;
+        byteSize = 1;
+        slots[0] = { 0, 4 };
+        slots[1] = { 4, 4 };
+    }
+    else if ( rasterFormat == RASTER_LUM_ALPHA && depth == 16 )
+    {
+        model = COLORMODEL_LUMINANCE;
+        byteSize = 2;
+        slots[0] = { 0, 8 };
+        slots[1] = { 8, 8 };
+    }
+    else
+    {
+        // Everything else goes through the dispatcher.
+        return false;
+    }
+
+    infoOut.model = model;
+    infoOut.byteSize = byteSize;
+
+    for ( uint32 n = 0; n < 4; n++ )
+    {
+        infoOut.slots[n].shift = slots[n].shift;
+        infoOut.slots[n].bits = slots[n].bits;
+    }
+
+    infoOut.preserveMask = preserveMask;
+
+    return true;
+}
+
+// Maps a logical color channel to a stored slot (and the other way round).
+// The generic dispatcher uses the same table for fetching and putting.
+AINLINE void getColorOrderPermutation( eColorOrdering colorOrder, uint32 permOut[ 4 ] )
+{
+    uint32 r = 0, g = 1, b = 2, a = 3;
+
+    if ( colorOrder == COLOR_BGRA )
+    {
+        r = 2; g = 1; b = 0; a = 3;
+    }
+    else if ( colorOrder == COLOR_ABGR )
+    {
+        r = 3; g = 2; b = 1; a = 0;
+    }
+    else if ( colorOrder == COLOR_ARGB )
+    {
+        r = 3; g = 0; b = 1; a = 2;
+    }
+    else if ( colorOrder == COLOR_BARG )
+    {
+        r = 2; g = 3; b = 0; a = 1;
+    }
+
+    permOut[0] = r;
+    permOut[1] = g;
+    permOut[2] = b;
+    permOut[3] = a;
+}
+
+// Channel scaling goes through the exact same math as the dispatcher.
+// Because of that every lookup table entry matches the generic result.
+AINLINE float channelToFloat( uint32 value, uint32 bits )
+{
+    float result;
+
+    if ( bits == 0 )
+    {
+        // Missing channels are fully set.
+        result = color_defaults <float>::one;
+    }
+    else if ( bits == 1 )
+    {
+        solve1bitalpha( value != 0, result );
+    }
+    else if ( bits == 8 )
+    {
+        destscalecolorn( (uint8)value, result );
+    }
+    else
+    {
+        destscalecolor( value, ( 1u << bits ) - 1, result );
+    }
+
+    return result;
+}
+
+AINLINE uint8 floatToChannel( float value, uint32 bits )
+{
+    uint8 result;
+
+    if ( bits == 1 )
+    {
+        result = ( resolve1bitalpha( value ) ? 1 : 0 );
+    }
+    else if ( bits == 8 )
+    {
+        destscalecolorn( value, result );
+    }
+    else
+    {
+        result = putscalecolor <uint8> ( value, ( 1u << bits ) - 1 );
+    }
+
+    return result;
+}
+
+inline void buildChannelLUT( const texelLayoutInfo& srcLayout, uint32 srcSlot, uint32 dstBits, uint8 lutOut[ 256 ] )
+{
+    uint32 srcBits = 0;
+
+    if ( srcSlot != TEXEL_SLOT_NONE )
+    {
+        srcBits = srcLayout.slots[ srcSlot ].bits;
+    }
+
+    uint32 valueCount = ( 1u << srcBits );
+
+    for ( uint32 n = 0; n < 256; n++ )
+    {
+        uint32 value = ( n < valueCount ? n : 0 );
+
+        lutOut[ n ] = floatToChannel( channelToFloat( value, srcBits ), dstBits );
+    }
+}
+
+inline void buildFloatLUT( const texelLayoutInfo& srcLayout, uint32 srcSlot, float lutOut[ 256 ] )
+{
+    uint32 srcBits = 0;
+
+    if ( srcSlot != TEXEL_SLOT_NONE )
+    {
+        srcBits = srcLayout.slots[ srcSlot ].bits;
+    }
+
+    uint32 valueCount = ( 1u << srcBits );
+
+    for ( uint32 n = 0; n < 256; n++ )
+    {
+        uint32 value = ( n < valueCount ? n : 0 );
+
+        lutOut[ n ] = channelToFloat( value, srcBits );
+    }
+}
+
+AINLINE uint32 resolveSlot( const texelLayoutInfo& layout, uint32 slot )
+{
+    if ( layout.slots[ slot ].bits == 0 )
+    {
+        return TEXEL_SLOT_NONE;
+    }
+
+    return slot;
+}
+
+bool PrepareTexelRowConversion( const texelRowKernelKey& key, texelRowKernelParams& params )
+{
+    texelLayoutInfo& srcLayout = params.srcLayout;
+    texelLayoutInfo& dstLayout = params.dstLayout;
+
+    if ( !getTexelLayoutInfo( key.srcRasterFormat, key.srcDepth, srcLayout ) ||
+         !getTexelLayoutInfo( key.dstRasterFormat, key.dstDepth, dstLayout ) )
+    {
+        return false;
+    }
+
+    uint32 srcPerm[ 4 ];
+    uint32 dstPerm[ 4 ];
+
+    getColorOrderPermutation( key.srcColorOrder, srcPerm );
+    getColorOrderPermutation( key.dstColorOrder, dstPerm );
+
+    eColorModel srcModel = srcLayout.model;
+    eColorModel dstModel = dstLayout.model;
+
+    for ( uint32 dstSlot = 0; dstSlot < 4; dstSlot++ )
+    {
+        uint32 srcSlot = TEXEL_SLOT_NONE;
+
+        if ( dstModel == COLORMODEL_RGBA )
+        {
+            // Put by color order, after we fetched by color order.
+            uint32 logicalChannel = dstPerm[ dstSlot ];
+
+            if ( srcModel == COLORMODEL_RGBA )
+            {
+                srcSlot = srcPerm[ logicalChannel ];
+            }
+            else
+            {
+                // Luminance is spread across red, green and blue.
+                srcSlot = ( logicalChannel < 3 ? 0 : 1 );
+            }
+        }
+        else if ( dstModel == COLORMODEL_LUMINANCE )
+        {
+            if ( srcModel == COLORMODEL_LUMINANCE )
+            {
+                srcSlot = dstSlot;
+            }
+            else if ( dstSlot == 1 )
+            {
+                // The alpha channel is passed through, the luminance has to be computed.
+                srcSlot = srcPerm[ 3 ];
+            }
+        }
+
+        if ( srcSlot != TEXEL_SLOT_NONE )
+        {
+            srcSlot = resolveSlot( srcLayout, srcSlot );
+        }
+
+        params.srcSlotOfDstSlot[ dstSlot ] = srcSlot;
+
+        buildChannelLUT( srcLayout, srcSlot, dstLayout.slots[ dstSlot ].bits, params.channelLUT[ dstSlot ] );
+    }
+
+    if ( srcModel == COLORMODEL_RGBA && dstModel == COLORMODEL_LUMINANCE )
+    {
+        for ( uint32 logicalChannel = 0; logicalChannel < 4; logicalChannel++ )
+        {
+            uint32 srcSlot = resolveSlot( srcLayout, srcPerm[ logicalChannel ] );
+
+            params.srcSlotOfColor[ logicalChannel ] = srcSlot;
+
+            buildFloatLUT( srcLayout, srcSlot, params.colorToFloat[ logicalChannel ] );
+        }
+    }
+
+    // Byte shuffle for 8888 permutations, for four texels per lane.
+    if ( srcLayout.byteSize == 4 && dstLayout.byteSize == 4 )
+    {
+        for ( uint32 n = 0; n < 32; n++ )
+        {
+            uint32 texelIndex = ( ( n % 16 ) / 4 );
+            uint32 dstSlot = ( n % 4 );
+
+            uint32 srcSlot = params.srcSlotOfDstSlot[ dstSlot ];
+
+            if ( srcSlot == TEXEL_SLOT_NONE )
+            {
+                // Zero the byte.
+                params.shuffleMask[ n ] = 0x80;
+            }
+            else
+            {
+                params.shuffleMask[ n ] = (uint8)( texelIndex * 4 + srcSlot );
+            }
+        }
+    }
+
+    return true;
+}
+
+// Texel memory access.
+template <uint32 byteSize>
+AINLINE uint32 loadTexel( const uint8 *ptr )
+{
+    uint32 value = 0;
+
+    if ( byteSize == 1 )
+    {
+        value = *ptr;
+    }
+    else if ( byteSize == 2 )
+    {
+        value = *(const uint16*)ptr;
+    }
+    else if ( byteSize == 3 )
+    {
+        value = ( (uint32)ptr[0] | ( (uint32)ptr[1] << 8 ) | ( (uint32)ptr[2] << 16 ) );
+    }
+    else if ( byteSize == 4 )
+    {
+        value = *(const uint32*)ptr;
+    }
+
+    return value;
+}
+
+template <uint32 byteSize>
+AINLINE void storeTexel( uint8 *ptr, uint32 value )
+{
+    if ( byteSize == 1 )
+    {
+        *ptr = (uint8)value;
+    }
+    else if ( byteSize == 2 )
+    {
+        *(uint16*)ptr = (uint16)value;
+    }
+    else if ( byteSize == 3 )
+    {
+        ptr[0] = (uint8)( value );
+        ptr[1] = (uint8)( value >> 8 );
+        ptr[2] = (uint8)( value >> 16 );
+    }
+    else if ( byteSize == 4 )
+    {
+        *(uint32*)ptr = value;
+    }
+}
+
+// Portable kernel that moves every destination slot through a lookup table.
+template <uint32 srcByteSize, uint32 dstByteSize>
+static void _kernel_portable_lut( const texelRowKernelParams& params, const void *srcRow, void *dstRow, uint32 texelCount )
+{
+    const uint8 *srcPtr = (const uint8*)srcRow;
+    uint8 *dstPtr = (uint8*)dstRow;
+
+    uint32 srcShift[ 4 ];
+    uint32 srcMask[ 4 ];
+    uint32 dstShift[ 4 ];
+    bool hasDstSlot[ 4 ];
+
+    for ( uint32 n = 0; n < 4; n++ )
+    {
+        uint32 srcSlot = params.srcSlotOfDstSlot[ n ];
+
+        if ( srcSlot == TEXEL_SLOT_NONE )
+        {
+            srcShift[ n ] = 0;
+            srcMask[ n ] = 0;
+        }
+        else
+        {
+            srcShift[ n ] = params.srcLayout.slots[ srcSlot ].shift;
+            srcMask[ n ] = ( ( 1u << params.srcLayout.slots[ srcSlot ].bits ) - 1 );
+        }
+
+        dstShift[ n ] = params.dstLayout.slots[ n ].shift;
+        hasDstSlot[ n ] = ( params.dstLayout.slots[ n ].bits != 0 );
+    }
+
+    uint32 preserveMask = params.dstLayout.preserveMask;
+
+    for ( uint32 n = 0; n < texelCount; n++ )
+    {
+        uint32 srcValue = loadTexel <srcByteSize> ( srcPtr );
+
+        uint32 dstValue = 0;
+
+        if ( preserveMask != 0 )
+        {
+            dstValue = ( loadTexel <dstByteSize> ( dstPtr ) & preserveMask );
+        }
+
+        for ( uint32 slot = 0; slot < 4; slot++ )
+        {
+            if ( hasDstSlot[ slot ] )
+            {
+                uint32 srcChannel = ( ( srcValue >> srcShift[ slot ] ) & srcMask[ slot ] );
+
+                dstValue |= ( (uint32)params.channelLUT[ slot ][ srcChannel ] << dstShift[ slot ] );
+            }
+        }
+
+        storeTexel <dstByteSize> ( dstPtr, dstValue );
+
+        srcPtr += srcByteSize;
+        dstPtr += dstByteSize;
+    }
+}
+
+// Portable kernel for color to luminance conversion, which has to happen in floating point.
+template <uint32 srcByteSize, uint32 dstByteSize>
+static void _kernel_portable_color2lum( const texelRowKernelParams& params, const void *srcRow, void *dstRow, uint32 texelCount )
+{
+    const uint8 *srcPtr = (const uint8*)srcRow;
+    uint8 *dstPtr = (uint8*)dstRow;
+
+    uint32 srcShift[ 4 ];
+    uint32 srcMask[ 4 ];
+
+    for ( uint32 n = 0; n < 4; n++ )
+    {
+        uint32 srcSlot = params.srcSlotOfColor[ n ];
+
+        if ( srcSlot == TEXEL_SLOT_NONE )
+        {
+            srcShift[ n ] = 0;
+            srcMask[ n ] = 0;
+        }
+        else
+        {
+            srcShift[ n ] = params.srcLayout.slots[ srcSlot ].shift;
+            srcMask[ n ] = ( ( 1u << params.srcLayout.slots[ srcSlot ].bits ) - 1 );
+        }
+    }
+
+    const texelLayoutInfo& dstLayout = params.dstLayout;
+
+    uint32 lumShift = dstLayout.slots[0].shift;
+    uint32 lumBits = dstLayout.slots[0].bits;
+
+    bool hasAlpha = ( dstLayout.slots[1].bits != 0 );
+    uint32 alphaShift = dstLayout.slots[1].shift;
+
+    uint32 alphaSrcShift = 0;
+    uint32 alphaSrcMask = 0;
+
+    if ( hasAlpha )
+    {
+        uint32 alphaSrcSlot = params.srcSlotOfDstSlot[1];
+
+        if ( alphaSrcSlot != TEXEL_SLOT_NONE )
+        {
+            alphaSrcShift = params.srcLayout.slots[ alphaSrcSlot ].shift;
+            alphaSrcMask = ( ( 1u << params.srcLayout.slots[ alphaSrcSlot ].bits ) - 1 );
+        }
+    }
+
+    for ( uint32 n = 0; n < texelCount; n++ )
+    {
+        uint32 srcValue = loadTexel <srcByteSize> ( srcPtr );
+
+        float red =     params.colorToFloat[0][ ( srcValue >> srcShift[0] ) & srcMask[0] ];
+        float green =   params.colorToFloat[1][ ( srcValue >> srcShift[1] ) & srcMask[1] ];
+        float blue =    params.colorToFloat[2][ ( srcValue >> srcShift[2] ) & srcMask[2] ];
+
+        float lum = rgb2lum( red, green, blue );
+
+        uint32 dstValue = ( (uint32)floatToChannel( lum, lumBits ) << lumShift );
+
+        if ( hasAlpha )
+        {
+            uint32 srcAlpha = ( ( srcValue >> alphaSrcShift ) & alphaSrcMask );
+
+            dstValue |= ( (uint32)params.channelLUT[1][ srcAlpha ] << alphaShift );
+        }
+
+        storeTexel <dstByteSize> ( dstPtr, dstValue );
+
+        srcPtr += srcByteSize;
+        dstPtr += dstByteSize;
+    }
+}
+
+template <template <uint32, uint32> class kernelTemplate>
+struct portableKernelTable
+{
+    template <uint32 srcByteSize>
+    static texelRowKernel_t pickForSource( uint32 dstByteSize )
+    {
+        switch( dstByteSize )
+        {
+        case 1: return kernelTemplate <srcByteSize, 1>::call;
+        case 2: return kernelTemplate <srcByteSize, 2>::call;
+        case 3: return kernelTemplate <srcByteSize, 3>::call;
+        case 4: return kernelTemplate <srcByteSize, 4>::call;
+        }
+
+        return NULL;
+    }
+
+    static texelRowKernel_t pick( uint32 srcByteSize, uint32 dstByteSize )
+    {
+        switch( srcByteSize )
+        {
+        case 1: return pickForSource <1> ( dstByteSize );
+        case 2: return pickForSource <2> ( dstByteSize );
+        case 3: return pickForSource <3> ( dstByteSize );
+        case 4: return pickForSource <4> ( dstByteSize );
+        }
+
+        return NULL;
+    }
+};
+
+template <uint32 srcByteSize, uint32 dstByteSize>
+struct portable_lut_kernel
+{
+    static void call( const texelRowKernelParams& params, const void *srcRow, void *dstRow, uint32 texelCount )
+    {
+        _kernel_portable_lut <srcByteSize, dstByteSize> ( params, srcRow, dstRow, texelCount );
+    }
+};
+
+template <uint32 srcByteSize, uint32 dstByteSize>
+struct portable_color2lum_kernel
+{
+    static void call( const texelRowKernelParams& params, const void *srcRow, void *dstRow, uint32 texelCount )
+    {
+        _kernel_portable_color2lum <srcByteSize, dstByteSize> ( params, srcRow, dstRow, texelCount );
+    }
+};
+
+texelRowKernel_t GetPortableTexelRowKernel( const texelRowKernelParams& params )
+{
+    uint32 srcByteSize = params.srcLayout.byteSize;
+    uint32 dstByteSize = params.dstLayout.byteSize;
+
+    if ( params.srcLayout.model == COLORMODEL_RGBA && params.dstLayout.model == COLORMODEL_LUMINANCE )
+    {
+        return portableKernelTable <portable_color2lum_kernel>::pick( srcByteSize, dstByteSize );
+    }
+
+    return portableKernelTable <portable_lut_kernel>::pick( srcByteSize, dstByteSize );
+}
+
+// Plain row copy if the formats are the same and the dispatcher would write every bit.
+template <uint32 byteSize>
+static void _kernel_copy_row( const texelRowKernelParams& params, const void *srcRow, void *dstRow, uint32 texelCount )
+{
+    if ( srcRow != dstRow )
+    {
+        memcpy( dstRow, srcRow, (size_t)texelCount * byteSize );
+    }
+}
+
+#ifdef RWLIB_ENABLE_X86_SIMD
+
+// Traits of the 16bit texel formats that we pack and unpack using vector instructions.
+template <eRasterFormat rasterFormat>
+struct packed16_traits
+{};
+
+template <>
+struct packed16_traits <RASTER_565>
+{
+    static const uint32 redBits = 5, greenBits = 6, blueBits = 5, alphaBits = 0;
+    static const uint32 redShift = 0, greenShift = 5, blueShift = 11, alphaShift = 0;
+};
+
+template <>
+struct packed16_traits <RASTER_1555>
+{
+    static const uint32 redBits = 5, greenBits = 5, blueBits = 5, alphaBits = 1;
+    static const uint32 redShift = 0, greenShift = 5, blueShift = 10, alphaShift = 15;
+};
+
+template <>
+struct packed16_traits <RASTER_4444>
+{
+    static const uint32 redBits = 4, greenBits = 4, blueBits = 4, alphaBits = 4;
+    static const uint32 redShift = 0, greenShift = 4, blueShift = 8, alphaShift = 12;
+};
+
+// floor( c * max / 255 ) for c in [0, 255], which is what the dispatcher calculates in floating point.
+template <uint32 bits>
+AINLINE __m128i _sse2_scale_down( __m128i c )
+{
+    if ( bits == 1 )
+    {
+        // Any set value is a set bit.
+        return _mm_andnot_si128( _mm_cmpeq_epi16( c, _mm_setzero_si128() ), _mm_set1_epi16( 1 ) );
+    }
+
+    __m128i t = _mm_mullo_epi16( c, _mm_set1_epi16( (short)( ( 1 << bits ) - 1 ) ) );
+
+    return _mm_srli_epi16( _mm_add_epi16( _mm_add_epi16( t, _mm_set1_epi16( 1 ) ), _mm_srli_epi16( t, 8 ) ), 8 );
+}
+
+// round( v * 255 / max ), using multipliers that were verified against the dispatcher for every value.
+template <uint32 bits>
+AINLINE __m128i _sse2_scale_up( __m128i v )
+{
+    if ( bits == 1 )
+    {
+        return _mm_mullo_epi16( v, _mm_set1_epi16( 255 ) );
+    }
+    else if ( bits == 4 )
+    {
+        return _mm_mullo_epi16( v, _mm_set1_epi16( 17 ) );
+    }
+    else if ( bits == 5 )
+    {
+        return _mm_srli_epi16( _mm_add_epi16( _mm_mullo_epi16( v, _mm_set1_epi16( 527 ) ), _mm_set1_epi16( 23 ) ), 6 );
+    }
+    else if ( bits == 6 )
+    {
+        return _mm_srli_epi16( _mm_add_epi16( _mm_mullo_epi16( v, _mm_set1_epi16( 259 ) ), _mm_set1_epi16( 33 ) ), 6 );
+    }
+
+    return v;
+}
+
+// Swaps red and blue of 8888 texels (RGBA <-> BGRA).
+static void _kernel_sse2_8888_swaprb( const texelRowKernelParams& params, const void *srcRow, void *dstRow, uint32 texelCount )
+{
+    const uint8 *srcPtr = (const uint8*)srcRow;
+    uint8 *dstPtr = (uint8*)dstRow;
+
+    const __m128i maskGA = _mm_set1_epi32( 0xFF00FF00 );
+    const __m128i maskRB = _mm_set1_epi32( 0x00FF00FF );
+
+    uint32 n = 0;
+
+    for ( ; n + 4 <= texelCount; n += 4 )
+    {
+        __m128i texels = _mm_loadu_si128( (const __m128i*)( srcPtr + n * 4 ) );
+
+        __m128i ga = _mm_and_si128( texels, maskGA );
+        __m128i rb = _mm_and_si128( texels, maskRB );
+
+        // Swap the 16bit halves of each texel.
+        rb = _mm_shufflelo_epi16( rb, _MM_SHUFFLE( 2, 3, 0, 1 ) );
+        rb = _mm_shufflehi_epi16( rb, _MM_SHUFFLE( 2, 3, 0, 1 ) );
+
+        _mm_storeu_si128( (__m128i*)( dstPtr + n * 4 ), _mm_or_si128( ga, rb ) );
+    }
+
+    if ( n < texelCount )
+    {
+        _kernel_portable_lut <4, 4> ( params, srcPtr + n * 4, dstPtr + n * 4, texelCount - n );
+    }
+}
+
+// 8888 to 16bit color, eight texels at a time.
+template <eRasterFormat dstRasterFormat, bool swapRedBlue>
+static void _kernel_sse2_8888_pack16( const texelRowKernelParams& params, const void *srcRow, void *dstRow, uint32 texelCount )
+{
+    typedef packed16_traits <dstRasterFormat> traits;
+
+    const uint8 *srcPtr = (const uint8*)srcRow;
+    uint8 *dstPtr = (uint8*)dstRow;
+
+    const __m128i byteMask = _mm_set1_epi32( 0xFF );
+
+    uint32 n = 0;
+
+    for ( ; n + 8 <= texelCount; n += 8 )
+    {
+        __m128i lo = _mm_loadu_si128( (const __m128i*)( srcPtr + n * 4 ) );
+        __m128i hi = _mm_loadu_si128( (const __m128i*)( srcPtr + n * 4 + 16 ) );
+
+        // Split into channels, one texel per 16bit lane.
+        __m128i c0 = _mm_packs_epi32( _mm_and_si128( lo, byteMask ), _mm_and_si128( hi, byteMask ) );
+        __m128i c1 = _mm_packs_epi32( _mm_and_si128( _mm_srli_epi32( lo, 8 ), byteMask ), _mm_and_si128( _mm_srli_epi32( hi, 8 ), byteMask ) );
+        __m128i c2 = _mm_packs_epi32( _mm_and_si128( _mm_srli_epi32( lo, 16 ), byteMask ), _mm_and_si128( _mm_srli_epi32( hi, 16 ), byteMask ) );
+
+        __m128i red = ( swapRedBlue ? c2 : c0 );
+        __m128i blue = ( swapRedBlue ? c0 : c2 );
+
+        __m128i result =
+            _mm_or_si128(
+                _mm_or_si128(
+                    _mm_slli_epi16( _sse2_scale_down <traits::redBits> ( red ), traits::redShift ),
+                    _mm_slli_epi16( _sse2_scale_down <traits::greenBits> ( c1 ), traits::greenShift )
+                ),
+                _mm_slli_epi16( _sse2_scale_down <traits::blueBits> ( blue ), traits::blueShift )
+            );
+
+        if ( traits::alphaBits != 0 )
+        {
+            __m128i c3 = _mm_packs_epi32( _mm_srli_epi32( lo, 24 ), _mm_srli_epi32( hi, 24 ) );
+
+            result = _mm_or_si128( result, _mm_slli_epi16( _sse2_scale_down <traits::alphaBits> ( c3 ), traits::alphaShift ) );
+        }
+
+        _mm_storeu_si128( (__m128i*)( dstPtr + n * 2 ), result );
+    }
+
+    if ( n < texelCount )
+    {
+        _kernel_portable_lut <4, 2> ( params, srcPtr + n * 4, dstPtr + n * 2, texelCount - n );
+    }
+}
+
+// 16bit color to 8888, eight texels at a time.
+template <eRasterFormat srcRasterFormat, bool swapRedBlue>
+static void _kernel_sse2_unpack16_8888( const texelRowKernelParams& params, const void *srcRow, void *dstRow, uint32 texelCount )
+{
+    typedef packed16_traits <srcRasterFormat> traits;
+
+    const uint8 *srcPtr = (const uint8*)srcRow;
+    uint8 *dstPtr = (uint8*)dstRow;
+
+    uint32 n = 0;
+
+    for ( ; n + 8 <= texelCount; n += 8 )
+    {
+        __m128i texels = _mm_loadu_si128( (const __m128i*)( srcPtr + n * 2 ) );
+
+        __m128i c0 = _sse2_scale_up <traits::redBits> ( _mm_and_si128( _mm_srli_epi16( texels, traits::redShift ), _mm_set1_epi16( ( 1 << traits::redBits ) - 1 ) ) );
+        __m128i c1 = _sse2_scale_up <traits::greenBits> ( _mm_and_si128( _mm_srli_epi16( texels, traits::greenShift ), _mm_set1_epi16( ( 1 << traits::greenBits ) - 1 ) ) );
+        __m128i c2 = _sse2_scale_up <traits::blueBits> ( _mm_and_si128( _mm_srli_epi16( texels, traits::blueShift ), _mm_set1_epi16( ( 1 << traits::blueBits ) - 1 ) ) );
+        __m128i c3;
+
+        if ( traits::alphaBits != 0 )
+        {
+            c3 = _sse2_scale_up <traits::alphaBits> ( _mm_and_si128( _mm_srli_epi16( texels, traits::alphaShift ), _mm_set1_epi16( ( 1 << traits::alphaBits ) - 1 ) ) );
+        }
+        else
+        {
+            c3 = _mm_set1_epi16( 0xFF );
+        }
+
+        __m128i red = ( swapRedBlue ? c2 : c0 );
+        __m128i blue = ( swapRedBlue ? c0 : c2 );
+
+        __m128i rg = _mm_or_si128( red, _mm_slli_epi16( c1, 8 ) );
+        __m128i ba = _mm_or_si128( blue, _mm_slli_epi16( c3, 8 ) );
+
+        _mm_storeu_si128( (__m128i*)( dstPtr + n * 4 ), _mm_unpacklo_epi16( rg, ba ) );
+        _mm_storeu_si128( (__m128i*)( dstPtr + n * 4 + 16 ), _mm_unpackhi_epi16( rg, ba ) );
+    }
+
+    if ( n < texelCount )
+    {
+        _kernel_portable_lut <2, 4> ( params, srcPtr + n * 2, dstPtr + n * 4, texelCount - n );
+    }
+}
+
+// LUM8 to 8888 (RGBA or BGRA), sixteen texels at a time.
+static void _kernel_sse2_lum8_8888( const texelRowKernelParams& params, const void *srcRow, void *dstRow, uint32 texelCount )
+{
+    const uint8 *srcPtr = (const uint8*)srcRow;
+    uint8 *dstPtr = (uint8*)dstRow;
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alpha = _mm_set1_epi16( (short)0xFF00 );
+
+    uint32 n = 0;
+
+    for ( ; n + 16 <= texelCount; n += 16 )
+    {
+        __m128i lum = _mm_loadu_si128( (const __m128i*)( srcPtr + n ) );
+
+        __m128i lumLo = _mm_unpacklo_epi8( lum, zero );
+        __m128i lumHi = _mm_unpackhi_epi8( lum, zero );
+
+        __m128i rgLo = _mm_or_si128( lumLo, _mm_slli_epi16( lumLo, 8 ) );
+        __m128i baLo = _mm_or_si128( lumLo, alpha );
+        __m128i rgHi = _mm_or_si128( lumHi, _mm_slli_epi16( lumHi, 8 ) );
+        __m128i baHi = _mm_or_si128( lumHi, alpha );
+
+        __m128i *dstVec = (__m128i*)( dstPtr + n * 4 );
+
+        _mm_storeu_si128( dstVec + 0, _mm_unpacklo_epi16( rgLo, baLo ) );
+        _mm_storeu_si128( dstVec + 1, _mm_unpackhi_epi16( rgLo, baLo ) );
+        _mm_storeu_si128( dstVec + 2, _mm_unpacklo_epi16( rgHi, baHi ) );
+        _mm_storeu_si128( dstVec + 3, _mm_unpackhi_epi16( rgHi, baHi ) );
+    }
+
+    if ( n < texelCount )
+    {
+        _kernel_portable_lut <1, 4> ( params, srcPtr + n, dstPtr + n * 4, texelCount - n );
+    }
+}
+
+// Any color order permutation of 8888 texels, eight texels at a time.
+RWSIMD_TARGET_AVX2 static void _kernel_avx2_8888_shuffle( const texelRowKernelParams& params, const void *srcRow, void *dstRow, uint32 texelCount )
+{
+    const uint8 *srcPtr = (const uint8*)srcRow;
+    uint8 *dstPtr = (uint8*)dstRow;
+
+    const __m256i shuffleMask = _mm256_loadu_si256( (const __m256i*)params.shuffleMask );
+
+    uint32 n = 0;
+
+    for ( ; n + 8 <= texelCount; n += 8 )
+    {
+        __m256i texels = _mm256_loadu_si256( (const __m256i*)( srcPtr + n * 4 ) );
+
+        _mm256_storeu_si256( (__m256i*)( dstPtr + n * 4 ), _mm256_shuffle_epi8( texels, shuffleMask ) );
+    }
+
+    if ( n < texelCount )
+    {
+        _kernel_portable_lut <4, 4> ( params, srcPtr + n * 4, dstPtr + n * 4, texelCount - n );
+    }
+}
+
+template <uint32 bits>
+RWSIMD_TARGET_AVX2 AINLINE __m256i _avx2_scale_down( __m256i c )
+{
+    if ( bits == 1 )
+    {
+        return _mm256_andnot_si256( _mm256_cmpeq_epi16( c, _mm256_setzero_si256() ), _mm256_set1_epi16( 1 ) );
+    }
+
+    __m256i t = _mm256_mullo_epi16( c, _mm256_set1_epi16( (short)( ( 1 << bits ) - 1 ) ) );
+
+    return _mm256_srli_epi16( _mm256_add_epi16( _mm256_add_epi16( t, _mm256_set1_epi16( 1 ) ), _mm256_srli_epi16( t, 8 ) ), 8 );
+}
+
+template <uint32 bits>
+RWSIMD_TARGET_AVX2 AINLINE __m256i _avx2_scale_up( __m256i v )
+{
+    if ( bits == 1 )
+    {
+        return _mm256_mullo_epi16( v, _mm256_set1_epi16( 255 ) );
+    }
+    else if ( bits == 4 )
+    {
+        return _mm256_mullo_epi16( v, _mm256_set1_epi16( 17 ) );
+    }
+    else if ( bits == 5 )
+    {
+        return _mm256_srli_epi16( _mm256_add_epi16( _mm256_mullo_epi16( v, _mm256_set1_epi16( 527 ) ), _mm256_set1_epi16( 23 ) ), 6 );
+    }
+    else if ( bits == 6 )
+    {
+        return _mm256_srli_epi16( _mm256_add_epi16( _mm256_mullo_epi16( v, _mm256_set1_epi16( 259 ) ), _mm256_set1_epi16( 33 ) ), 6 );
+    }
+
+    return v;
+}
+
+// 8888 to 16bit color, sixteen texels at a time.
+template <eRasterFormat dstRasterFormat, bool swapRedBlue>
+RWSIMD_TARGET_AVX2 static void _kernel_avx2_8888_pack16( const texelRowKernelParams& params, const void *srcRow, void *dstRow, uint32 texelCount )
+{
+    typedef packed16_traits <dstRasterFormat> traits;
+
+    const uint8 *srcPtr = (const uint8*)srcRow;
+    uint8 *dstPtr = (uint8*)dstRow;
+
+    const __m256i byteMask = _mm256_set1_epi32( 0xFF );
+
+    uint32 n = 0;
+
+    for ( ; n + 16 <= texelCount; n += 16 )
+    {
+        __m256i lo = _mm256_loadu_si256( (const __m256i*)( srcPtr + n * 4 ) );
+        __m256i hi = _mm256_loadu_si256( (const __m256i*)( srcPtr + n * 4 + 32 ) );
+
+        // Packing works per 128bit lane, so the texel order is fixed up at the end.
+        __m256i c0 = _mm256_packs_epi32( _mm256_and_si256( lo, byteMask ), _mm256_and_si256( hi, byteMask ) );
+        __m256i c1 = _mm256_packs_epi32( _mm256_and_si256( _mm256_srli_epi32( lo, 8 ), byteMask ), _mm256_and_si256( _mm256_srli_epi32( hi, 8 ), byteMask ) );
+        __m256i c2 = _mm256_packs_epi32( _mm256_and_si256( _mm256_srli_epi32( lo, 16 ), byteMask ), _mm256_and_si256( _mm256_srli_epi32( hi, 16 ), byteMask ) );
+
+        __m256i red = ( swapRedBlue ? c2 : c0 );
+        __m256i blue = ( swapRedBlue ? c0 : c2 );
+
+        __m256i result =
+            _mm256_or_si256(
+                _mm256_or_si256(
+                    _mm256_slli_epi16( _avx2_scale_down <traits::redBits> ( red ), traits::redShift ),
+                    _mm256_slli_epi16( _avx2_scale_down <traits::greenBits> ( c1 ), traits::greenShift )
+                ),
+                _mm256_slli_epi16( _avx2_scale_down <traits::blueBits> ( blue ), traits::blueShift )
+            );
+
+        if ( traits::alphaBits != 0 )
+        {
+            __m256i c3 = _mm256_packs_epi32( _mm256_srli_epi32( lo, 24 ), _mm256_srli_epi32( hi, 24 ) );
+
+            result = _mm256_or_si256( result, _mm256_slli_epi16( _avx2_scale_down <traits::alphaBits> ( c3 ), traits::alphaShift ) );
+        }
+
+        result = _mm256_permute4x64_epi64( result, _MM_SHUFFLE( 3, 1, 2, 0 ) );
+
+        _mm256_storeu_si256( (__m256i*)( dstPtr + n * 2 ), result );
+    }
+
+    if ( n < texelCount )
+    {
+        _kernel_portable_lut <4, 2> ( params, srcPtr + n * 4, dstPtr + n * 2, texelCount - n );
+    }
+}
+
+// 16bit color to 8888, sixteen texels at a time.
+template <eRasterFormat srcRasterFormat, bool swapRedBlue>
+RWSIMD_TARGET_AVX2 static void _kernel_avx2_unpack16_8888( const texelRowKernelParams& params, const void *srcRow, void *dstRow, uint32 texelCount )
+{
+    typedef packed16_traits <srcRasterFormat> traits;
+
+    const uint8 *srcPtr = (const uint8*)srcRow;
+    uint8 *dstPtr = (uint8*)dstRow;
+
+    uint32 n = 0;
+
+    for ( ; n + 16 <= texelCount; n += 16 )
+    {
+        __m256i texels = _mm256_loadu_si256( (const __m256i*)( srcPtr + n * 2 ) );
+
+        __m256i c0 = _avx2_scale_up <traits::redBits> ( _mm256_and_si256( _mm256_srli_epi16( texels, traits::redShift ), _mm256_set1_epi16( ( 1 << traits::redBits ) - 1 ) ) );
+        __m256i c1 = _avx2_scale_up <traits::greenBits> ( _mm256_and_si256( _mm256_srli_epi16( texels, traits::greenShift ), _mm256_set1_epi16( ( 1 << traits::greenBits ) - 1 ) ) );
+        __m256i c2 = _avx2_scale_up <traits::blueBits> ( _mm256_and_si256( _mm256_srli_epi16( texels, traits::blueShift ), _mm256_set1_epi16( ( 1 << traits::blueBits ) - 1 ) ) );
+        __m256i c3;
+
+        if ( traits::alphaBits != 0 )
+        {
+            c3 = _avx2_scale_up <traits::alphaBits> ( _mm256_and_si256( _mm256_srli_epi16( texels, traits::alphaShift ), _mm256_set1_epi16( ( 1 << traits::alphaBits ) - 1 ) ) );
+        }
+        else
+        {
+            c3 = _mm256_set1_epi16( 0xFF );
+        }
+
+        __m256i red = ( swapRedBlue ? c2 : c0 );
+        __m256i blue = ( swapRedBlue ? c0 : c2 );
+
+        __m256i rg = _mm256_or_si256( red, _mm256_slli_epi16( c1, 8 ) );
+        __m256i ba = _mm256_or_si256( blue, _mm256_slli_epi16( c3, 8 ) );
+
+        // Unpacking works per 128bit lane aswell.
+        __m256i lo = _mm256_unpacklo_epi16( rg, ba );
+        __m256i hi = _mm256_unpackhi_epi16( rg, ba );
+
+        _mm256_storeu_si256( (__m256i*)( dstPtr + n * 4 ), _mm256_permute2x128_si256( lo, hi, 0x20 ) );
+        _mm256_storeu_si256( (__m256i*)( dstPtr + n * 4 + 32 ), _mm256_permute2x128_si256( lo, hi, 0x31 ) );
+    }
+
+    if ( n < texelCount )
+    {
+        _kernel_portable_lut <2, 4> ( params, srcPtr + n * 2, dstPtr + n * 4, texelCount - n );
+    }
+}
+
+#endif //RWLIB_ENABLE_X86_SIMD
+
+bool texelKernelEnv::RegisterKernel( EngineInterface *engineInterface, const texelRowKernelKey& key, eTexelKernelISA isa, texelRowKernel_t kernel )
+{
+    // The first kernel that was registered for a format pair wins.
+    if ( this->FindKernel( key ) != NULL )
+    {
+        return false;
+    }
+
+    void *entryMem = engineInterface->MemAllocate( sizeof( kernelEntry ) );
+
+    if ( !entryMem )
+    {
+        return false;
+    }
+
+    kernelEntry *entry = new (entryMem) kernelEntry();
+
+    entry->key = key;
+    entry->kernel = kernel;
+    entry->isa = isa;
+
+    LIST_APPEND( this->kernels.root, entry->node );
+
+    return true;
+}
+
+AINLINE texelRowKernelKey makeKernelKey(
+    eRasterFormat srcRasterFormat, eColorOrdering srcColorOrder, uint32 srcDepth,
+    eRasterFormat dstRasterFormat, eColorOrdering dstColorOrder, uint32 dstDepth
+)
+{
+    texelRowKernelKey key;
+    key.srcRasterFormat = srcRasterFormat;
+    key.srcColorOrder = srcColorOrder;
+    key.srcDepth = srcDepth;
+    key.dstRasterFormat = dstRasterFormat;
+    key.dstColorOrder = dstColorOrder;
+    key.dstDepth = dstDepth;
+
+    return key;
+}
+
+void texelKernelEnv::RegisterBuiltinKernels( EngineInterface *engineInterface )
+{
+    static const eColorOrdering commonOrders[] = { COLOR_RGBA, COLOR_BGRA };
+
+    // Same format, same color order is a plain copy.
+    // Not for every color order though, because ARGB and BARG are not symmetric in the dispatcher.
+    for ( eColorOrdering colorOrder : commonOrders )
+    {
+        this->RegisterKernel( engineInterface, makeKernelKey( RASTER_8888, colorOrder, 32, RASTER_8888, colorOrder, 32 ), eTexelKernelISA::PORTABLE, _kernel_copy_row <4> );
+        this->RegisterKernel( engineInterface, makeKernelKey( RASTER_565, colorOrder, 16, RASTER_565, colorOrder, 16 ), eTexelKernelISA::PORTABLE, _kernel_copy_row <2> );
+        this->RegisterKernel( engineInterface, makeKernelKey( RASTER_1555, colorOrder, 16, RASTER_1555, colorOrder, 16 ), eTexelKernelISA::PORTABLE, _kernel_copy_row <2> );
+        this->RegisterKernel( engineInterface, makeKernelKey( RASTER_4444, colorOrder, 16, RASTER_4444, colorOrder, 16 ), eTexelKernelISA::PORTABLE, _kernel_copy_row <2> );
+    }
+
+#ifdef RWLIB_ENABLE_X86_SIMD
+    const cpuFeatures& cpuFeat = GetCPUFeatures();
+
+    // Wider instruction sets are registered first so that they are preferred.
+    if ( cpuFeat.hasAVX2 )
+    {
+        static const eColorOrdering allOrders[] = { COLOR_RGBA, COLOR_BGRA, COLOR_ABGR, COLOR_ARGB, COLOR_BARG };
+
+        for ( eColorOrdering srcOrder : allOrders )
+        {
+            for ( eColorOrdering dstOrder : allOrders )
+            {
+                this->RegisterKernel( engineInterface, makeKernelKey( RASTER_8888, srcOrder, 32, RASTER_8888, dstOrder, 32 ), eTexelKernelISA::AVX2, _kernel_avx2_8888_shuffle );
+            }
+        }
+
+        for ( eColorOrdering srcOrder : commonOrders )
+        {
+            for ( eColorOrdering dstOrder : commonOrders )
+            {
+                bool swapRedBlue = ( srcOrder != dstOrder );
+
+                this->RegisterKernel( engineInterface, makeKernelKey( RASTER_8888, srcOrder, 32, RASTER_565, dstOrder, 16 ), eTexelKernelISA::AVX2,
+                    swapRedBlue ? _kernel_avx2_8888_pack16 <RASTER_565, true> : _kernel_avx2_8888_pack16 <RASTER_565, false> );
+                this->RegisterKernel( engineInterface, makeKernelKey( RASTER_8888, srcOrder, 32, RASTER_1555, dstOrder, 16 ), eTexelKernelISA::AVX2,
+                    swapRedBlue ? _kernel_avx2_8888_pack16 <RASTER_1555, true> : _kernel_avx2_8888_pack16 <RASTER_1555, false> );
+                this->RegisterKernel( engineInterface, makeKernelKey( RASTER_8888, srcOrder, 32, RASTER_4444, dstOrder, 16 ), eTexelKernelISA::AVX2,
+                    swapRedBlue ? _kernel_avx2_8888_pack16 <RASTER_4444, true> : _kernel_avx2_8888_pack16 <RASTER_4444, false> );
+
+                this->RegisterKernel( engineInterface, makeKernelKey( RASTER_565, srcOrder, 16, RASTER_8888, dstOrder, 32 ), eTexelKernelISA::AVX2,
+                    swapRedBlue ? _kernel_avx2_unpack16_8888 <RASTER_565, true> : _kernel_avx2_unpack16_8888 <RASTER_565, false> );
+                this->RegisterKernel( engineInterface, makeKernelKey( RASTER_1555, srcOrder, 16, RASTER_8888, dstOrder, 32 ), eTexelKernelISA::AVX2,
+                    swapRedBlue ? _kernel_avx2_unpack16_8888 <RASTER_1555, true> : _kernel_avx2_unpack16_8888 <RASTER_1555, false> );
+                this->RegisterKernel( engineInterface, makeKernelKey( RASTER_4444, srcOrder, 16, RASTER_8888, dstOrder, 32 ), eTexelKernelISA::AVX2,
+                    swapRedBlue ? _kernel_avx2_unpack16_8888 <RASTER_4444, true> : _kernel_avx2_unpack16_8888 <RASTER_4444, false> );
+            }
+        }
+    }
+
+    if ( cpuFeat.hasSSE2 )
+    {
+        this->RegisterKernel( engineInterface, makeKernelKey( RASTER_8888, COLOR_RGBA, 32, RASTER_8888, COLOR_BGRA, 32 ), eTexelKernelISA::SSE2, _kernel_sse2_8888_swaprb );
+        this->RegisterKernel( engineInterface, makeKernelKey( RASTER_8888, COLOR_BGRA, 32, RASTER_8888, COLOR_RGBA, 32 ), eTexelKernelISA::SSE2, _kernel_sse2_8888_swaprb );
+
+        for ( eColorOrdering srcOrder : commonOrders )
+        {
+            for ( eColorOrdering dstOrder : commonOrders )
+            {
+                bool swapRedBlue = ( srcOrder != dstOrder );
+
+                this->RegisterKernel( engineInterface, makeKernelKey( RASTER_8888, srcOrder, 32, RASTER_565, dstOrder, 16 ), eTexelKernelISA::SSE2,
+                    swapRedBlue ? _kernel_sse2_8888_pack16 <RASTER_565, true> : _kernel_sse2_8888_pack16 <RASTER_565, false> );
+                this->RegisterKernel( engineInterface, makeKernelKey( RASTER_8888, srcOrder, 32, RASTER_1555, dstOrder, 16 ), eTexelKernelISA::SSE2,
+                    swapRedBlue ? _kernel_sse2_8888_pack16 <RASTER_1555, true> : _kernel_sse2_8888_pack16 <RASTER_1555, false> );
+                this->RegisterKernel( engineInterface, makeKernelKey( RASTER_8888, srcOrder, 32, RASTER_4444, dstOrder, 16 ), eTexelKernelISA::SSE2,
+                    swapRedBlue ? _kernel_sse2_8888_pack16 <RASTER_4444, true> : _kernel_sse2_8888_pack16 <RASTER_4444, false> );
+
+                this->RegisterKernel( engineInterface, makeKernelKey( RASTER_565, srcOrder, 16, RASTER_8888, dstOrder, 32 ), eTexelKernelISA::SSE2,
+                    swapRedBlue ? _kernel_sse2_unpack16_8888 <RASTER_565, true> : _kernel_sse2_unpack16_8888 <RASTER_565, false> );
+                this->RegisterKernel( engineInterface, makeKernelKey( RASTER_1555, srcOrder, 16, RASTER_8888, dstOrder, 32 ), eTexelKernelISA::SSE2,
+                    swapRedBlue ? _kernel_sse2_unpack16_8888 <RASTER_1555, true> : _kernel_sse2_unpack16_8888 <RASTER_1555, false> );
+                this->RegisterKernel( engineInterface, makeKernelKey( RASTER_4444, srcOrder, 16, RASTER_8888, dstOrder, 32 ), eTexelKernelISA::SSE2,
+                    swapRedBlue ? _kernel_sse2_unpack16_8888 <RASTER_4444, true> : _kernel_sse2_unpack16_8888 <RASTER_4444, false> );
+            }
+
+            // Luminance has no color order, but the alpha has to stay in the last byte.
+            this->RegisterKernel( engineInterface, makeKernelKey( RASTER_LUM, COLOR_RGBA, 8, RASTER_8888, srcOrder, 32 ), eTexelKernelISA::SSE2, _kernel_sse2_lum8_8888 );
+        }
+    }
+#endif //RWLIB_ENABLE_X86_SIMD
+}
+
+bool FindTexelRowConverter(
+    Interface *intf,
+    eRasterFormat srcRasterFormat, eColorOrdering srcColorOrder, uint32 srcDepth, ePaletteType srcPaletteType,
+    eRasterFormat dstRasterFormat, eColorOrdering dstColorOrder, uint32 dstDepth,
+    texelRowConverter& convOut
+)
+{
+    EngineInterface *engineInterface = (EngineInterface*)intf;
+
+    // Palette texels have to be resolved through the dispatcher.
+    if ( srcPaletteType != PALETTE_NONE )
+    {
+        return false;
+    }
+
+    texelRowKernelKey key =
+        makeKernelKey(
+            srcRasterFormat, srcColorOrder, srcDepth,
+            dstRasterFormat, dstColorOrder, dstDepth
+        );
+
+    // Luminance formats do not care about color order.
+    if ( srcRasterFormat == RASTER_LUM || srcRasterFormat == RASTER_LUM_ALPHA )
+    {
+        key.srcColorOrder = COLOR_RGBA;
+    }
+
+    if ( dstRasterFormat == RASTER_LUM || dstRasterFormat == RASTER_LUM_ALPHA )
+    {
+        key.dstColorOrder = COLOR_RGBA;
+    }
+
+    if ( !PrepareTexelRowConversion( key, convOut.params ) )
+    {
+        return false;
+    }
+
+    texelRowKernel_t kernel = NULL;
+    eTexelKernelISA isa = eTexelKernelISA::PORTABLE;
+
+    if ( const texelKernelEnv *kernelEnv = texelKernelEnvRegister.GetConstPluginStruct( engineInterface ) )
+    {
+        if ( const texelKernelEnv::kernelEntry *entry = kernelEnv->FindKernel( key ) )
+        {
+            kernel = entry->kernel;
+            isa = entry->isa;
+        }
+    }
+
+    if ( kernel == NULL )
+    {
+        kernel = GetPortableTexelRowKernel( convOut.params );
+
+        if ( kernel == NULL )
+        {
+            return false;
+        }
+    }
+
+    convOut.kernel = kernel;
+    convOut.isa = isa;
+
+    return true;
+}
+
+void copyTexelDataByKernel(
+    const texelRowConverter& conv,
+    const void *srcTexels, void *dstTexels,
+    uint32 width, uint32 height,
+    uint32 srcRowSize, uint32 dstRowSize
+)
+{
+    texelRowKernel_t kernel = conv.kernel;
+
+    for ( uint32 row = 0; row < height; row++ )
+    {
+        const void *srcRow = getConstTexelDataRow( srcTexels, srcRowSize, row );
+        void *dstRow = getTexelDataRow( dstTexels, dstRowSize, row );
+
+        kernel( conv.params, srcRow, dstRow, width );
+    }
+}
+
+void copyTexelDataAccelerated(
+    Interface *engineInterface,
+    const void *srcTexels, void *dstTexels,
+    eRasterFormat srcRasterFormat, eColorOrdering srcColorOrder, uint32 srcDepth, ePaletteType srcPaletteType, const void *srcPaletteData, uint32 srcPaletteSize,
+    eRasterFormat dstRasterFormat, eColorOrdering dstColorOrder, uint32 dstDepth,
+    uint32 width, uint32 height,
+    uint32 srcRowSize, uint32 dstRowSize
+)
+{
+    // Decide once for the whole surface.
+    texelRowConverter conv;
+
+    bool hasKernel =
+        FindTexelRowConverter(
+            engineInterface,
+            srcRasterFormat, srcColorOrder, srcDepth, srcPaletteType,
+            dstRasterFormat, dstColorOrder, dstDepth,
+            conv
+        );
+
+    if ( hasKernel )
+    {
+        copyTexelDataByKernel(
+            conv,
+            srcTexels, dstTexels,
+            width, height,
+            srcRowSize, dstRowSize
+        );
+    }
+    else
+    {
+        colorModelDispatcher fetchDispatch( srcRasterFormat, srcColorOrder, srcDepth, srcPaletteData, srcPaletteSize, srcPaletteType );
+        colorModelDispatcher putDispatch( dstRasterFormat, dstColorOrder, dstDepth, NULL, 0, PALETTE_NONE );
+
+        copyTexelDataEx(
+            srcTexels, dstTexels,
+            fetchDispatch, putDispatch,
+            width, height,
+            0, 0,
+            0, 0,
+            srcRowSize, dstRowSize
+        );
+    }
+}
+
+void registerTexelKernelEnvironment( void )
+{
+    texelKernelEnvRegister.RegisterPlugin( engineFactory );
+}
+
+};
@@ -176,13 +176,29 @@ uint32 NativeTexturePS2::GSTexture::readGIFPacket(Interface *engineInterface, Bl
                     // Preallocate the register space.
                     this->storedRegs.resize( numRegs );
 
+                    // Try to look at the register list in-place.
+                    typedef endian::little_endian <uint64> serRegister_t[ 2 ];
+
+                    const serRegister_t *regListView = (const serRegister_t*)inputProvider.read_view( numRegs * sizeof( serRegister_t ) );
+
                     for ( uint32 n = 0; n < numRegs; n++ )
                     {
-                        // Read the register content.
-                        uint64 regContent = inputProvider.readUInt64();
+                        uint64 regContent;
+                        regID_struct regID;
+
+                        if ( regListView )
+                        {
+                            regContent = regListView[ n ][ 0 ];
+                            regID = regListView[ n ][ 1 ];
+                        }
+                        else
+                        {
+                            // Read the register content.
+                            regContent = inputProvider.readUInt64();
                         
-                        // Read the register ID.
-                        regID_struct regID = inputProvider.readUInt64();
+                            // Read the register ID.
+                            regID = inputProvider.readUInt64();
+                        }
 
                         // Put the register into the register storage.
                         GSRegInfo& regInfo = this->storedRegs[ n ];
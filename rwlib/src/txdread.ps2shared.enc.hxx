@@ -227,7 +227,8 @@ static bool clut(
             const uint32 clutRequiredRowAlignment = 1;
 
             // Perform the permutation.
-            memcodec::permutationUtilities::permuteArray(
+            memcodec::permutationUtilities::permuteArrayCached(
+                engineInterface,
                 srcTexels, clutWidth, clutHeight, itemDepth, permuteWidth, permuteHeight,
                 dstTexels, clutWidth, clutHeight, itemDepth, permuteWidth, permuteHeight,
                 colsWidth, colsHeight,
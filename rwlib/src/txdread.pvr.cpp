@@ -248,6 +248,27 @@ void registerPVRNativePlugin( void )
     pvrNativeTextureTypeProviderRegister.RegisterPlugin( engineFactory );
 }
 
+bool pvrNativeTextureTypeProvider::DeserializeTextureProperties( TextureBase *theTexture, BlockProvider& inputProvider ) const
+{
+    return readTextureNativeStructHeader <pvr::textureMetaHeaderGeneric> ( inputProvider,
+        [&]( const pvr::textureMetaHeaderGeneric& metaHeader )
+        {
+            if ( metaHeader.platformDescriptor != PLATFORM_PVR )
+            {
+                return false;
+            }
+
+            readTextureNativeNames( *theTexture, metaHeader.name, metaHeader.maskName );
+
+            metaHeader.formatInfo.parse( *theTexture );
+
+            theTexture->SetFilterMode( getFixedFilteringMode( theTexture->GetFilterMode(), metaHeader.mipmapCount ) );
+
+            return true;
+        }
+    );
+}
+
 };
 
 #endif //RWLIB_INCLUDE_NATIVETEX_POWERVR_MOBILE
\ No newline at end of file
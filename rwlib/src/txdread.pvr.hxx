@@ -2,10 +2,12 @@
 
 #include "txdread.nativetex.hxx"
 
+#ifdef RWLIB_INCLUDE_PVRTEXLIB
 // The PowerVR stuff includes the Windows header.
 #define WIN32_LEAN_AND_MEAN
 #define NOMINMAX
 #include <PVRTextureUtilities.h>
+#endif //RWLIB_INCLUDE_PVRTEXLIB
 
 #include "txdread.d3d.genmip.hxx"
 
@@ -15,6 +17,8 @@
 
 #include "pixelformat.hxx"
 
+#include "txdread.pvrtc.hxx"
+
 #define PLATFORM_PVR    10
 
 namespace rw
@@ -167,6 +171,8 @@ struct pvrNativeTextureTypeProvider : public texNativeTypeProvider
     void SerializeTexture( TextureBase *theTexture, PlatformTexture *nativeTex, BlockProvider& outputProvider ) const;
     void DeserializeTexture( TextureBase *theTexture, PlatformTexture *nativeTex, BlockProvider& inputProvider ) const;
 
+    bool DeserializeTextureProperties( TextureBase *theTexture, BlockProvider& inputProvider ) const;
+
     void GetPixelCapabilities( pixelCapabilities& capsOut ) const
     {
         capsOut.supportsDXT1 = false;
@@ -189,18 +195,28 @@ struct pvrNativeTextureTypeProvider : public texNativeTypeProvider
         storeCaps.isCompressedFormat = true;
     }
 
-    // Public API.
-    typedef void* PVRTextureHeader;
-    typedef void* PVRTexture;
-    typedef void* PVRPixelType;
-
     // Transformation pipeline functions.
+    // PVRTC data is processed by PVRTexLib if it is loaded and selected by the configuration,
+    // otherwise by our own codec. The decompressed side is always RGBA8888 without row padding.
+    bool IsUsingPVRTexLib( Interface *engineInterface ) const;
+
+    void DecompressPVRToRGBA(
+        Interface *engineInterface,
+        uint32 surfWidth, uint32 surfHeight, const void *srcTexels, ePVRInternalFormat pvrFormat,
+        void *dstTexels
+    );
+    void CompressRGBAToPVR(
+        Interface *engineInterface,
+        uint32 surfWidth, uint32 surfHeight, const void *srcTexels, ePVRInternalFormat pvrFormat,
+        void *dstTexels
+    );
+
     void DecompressPVRMipmap(
         Interface *engineInterface,
         uint32 mipWidth, uint32 mipHeight, uint32 layerWidth, uint32 layerHeight, const void *srcTexels,
         eRasterFormat pvrRasterFormat, uint32 pvrDepth, eColorOrdering pvrColorOrder,
         eRasterFormat targetRasterFormat, uint32 targetDepth, uint32 targetRowAlignment, eColorOrdering targetColorOrder,
-        PVRPixelType pvrSrcPixelType, PVRPixelType pvrDstPixelType,
+        ePVRInternalFormat pvrFormat,
         void*& dstTexelsOut, uint32& dstDataSizeOut
     );
     template <typename srcDispatchType>
@@ -209,14 +225,13 @@ struct pvrNativeTextureTypeProvider : public texNativeTypeProvider
         uint32 mipWidth, uint32 mipHeight, const void *srcTexels,
         srcDispatchType& fetchDispatch, uint32 srcDepth, uint32 srcRowAlignment,
         eRasterFormat pvrRasterFormat, uint32 pvrDepth, eColorOrdering pvrColorOrder,
-        PVRPixelType pvrSrcPixelType, PVRPixelType pvrDstPixelType,
+        ePVRInternalFormat pvrFormat,
         uint32 pvrBlockWidth, uint32 pvrBlockHeight,
         uint32 pvrBlockDepth,
         uint32& widthOut, uint32& heightOut,
         void*& dstTexelsOut, uint32& dstDataSizeOut
     )
     {
-        // Create a PVR texture.
         uint32 srcRowSize = getRasterDataRowSize( mipWidth, srcDepth, srcRowAlignment );
 
         // We need to determine dimensions that the PVR texture has to use.
@@ -225,96 +240,72 @@ struct pvrNativeTextureTypeProvider : public texNativeTypeProvider
 
         uint32 pvrRowSize = getRasterDataRowSize( pvrTexWidth, pvrDepth, getPVRToolTextureDataRowAlignment() );
 
-        PVRTextureHeader pvrHeader = PVRTextureHeaderCreate( PVRPixelTypeGetID( pvrSrcPixelType ), pvrTexHeight, pvrTexWidth );
+        uint32 pvrColorDataSize = getRasterDataSizeByRowSize( pvrRowSize, pvrTexHeight );
 
-        if ( !pvrHeader )
+        void *pvrSrcBuf = engineInterface->PixelAllocate( pvrColorDataSize );
+
+        if ( !pvrSrcBuf )
         {
-            throw RwException( "failed to create PVRTexLib texture header" );
+            throw RwException( "failed to allocate color buffer for PVRTC compression" );
         }
 
+        uint32 dstDataSize = getPackedRasterDataSize( pvrTexWidth * pvrTexHeight, pvrBlockDepth );
+
+        void *dstTexels = NULL;
+
         try
         {
-            // Copy stuff into the PVR texture properly.
-            PVRTexture pvrTexture = PVRTextureCreate( pvrHeader );
-
-            if ( !pvrTexture )
+            // Process the colors into the format that the compressor takes.
             {
-                throw RwException( "failed to create PVRTexLib texture handle" );
+                colorModelDispatcher putDispatch( pvrRasterFormat, pvrColorOrder, pvrDepth, NULL, 0, PALETTE_NONE );
+
+                copyTexelDataBounded(
+                    srcTexels, pvrSrcBuf,
+                    fetchDispatch, putDispatch,
+                    mipWidth, mipHeight,
+                    pvrTexWidth, pvrTexHeight,
+                    0, 0,
+                    0, 0,
+                    srcRowSize, pvrRowSize
+                );
             }
 
-            try
-            {
-                // Process the colors into the PowerVR texture.
-                {
-                    void *pvrDstBuf = PVRTextureGetDataPtr( pvrTexture );
-
-                    colorModelDispatcher putDispatch( pvrRasterFormat, pvrColorOrder, pvrDepth, NULL, 0, PALETTE_NONE );
-
-                    copyTexelDataBounded(
-                        srcTexels, pvrDstBuf,
-                        fetchDispatch, putDispatch,
-                        mipWidth, mipHeight,
-                        pvrTexWidth, pvrTexHeight,
-                        0, 0,
-                        0, 0,
-                        srcRowSize, pvrRowSize
-                    );
-                }
-
-                // Transcode it.
-                bool transcodeSuccess =
-                    PVRTranscode( pvrTexture, pvrDstPixelType, ePVRTVarTypeUnsignedByteNorm, ePVRTCSpacelRGB );
-
-                if ( transcodeSuccess == false )
-                {
-                    throw RwException( "failed to compress texture data to PVRTC using PVRTexLib" );
-                }
-
-                // Copy the PowerVR pixels into a local array.
-                uint32 dstDataSize = getPackedRasterDataSize(pvrTexWidth * pvrTexHeight, pvrBlockDepth);
-
-                PVRTextureHeaderCheckDataSize( pvrTexture, dstDataSize );
-
-                void *dstTexels = engineInterface->PixelAllocate( dstDataSize );
-
-                if ( !dstTexels )
-                {
-                    throw RwException( "failed to allocate copy-buffer for PVRTC compressed data in PowerVR native texture mipmap compression" );
-                }
-
-                memcpy( dstTexels, PVRTextureGetDataPtr( pvrTexture ), dstDataSize );
+            dstTexels = engineInterface->PixelAllocate( dstDataSize );
 
-                // Give parameters to the runtime.
-                widthOut = pvrTexWidth;
-                heightOut = pvrTexHeight;
-
-                dstTexelsOut = dstTexels;
-                dstDataSizeOut = dstDataSize;
-            }
-            catch( ... )
+            if ( !dstTexels )
             {
-                PVRTextureDelete( pvrTexture );
-
-                throw;
+                throw RwException( "failed to allocate copy-buffer for PVRTC compressed data in PowerVR native texture mipmap compression" );
             }
 
-            PVRTextureDelete( pvrTexture );
+            CompressRGBAToPVR( engineInterface, pvrTexWidth, pvrTexHeight, pvrSrcBuf, pvrFormat, dstTexels );
         }
         catch( ... )
         {
-            PVRTextureHeaderDelete( pvrHeader );
+            if ( dstTexels )
+            {
+                engineInterface->PixelFree( dstTexels );
+            }
+
+            engineInterface->PixelFree( pvrSrcBuf );
 
             throw;
         }
 
-        PVRTextureHeaderDelete( pvrHeader );
+        engineInterface->PixelFree( pvrSrcBuf );
+
+        // Give parameters to the runtime.
+        widthOut = pvrTexWidth;
+        heightOut = pvrTexHeight;
+
+        dstTexelsOut = dstTexels;
+        dstDataSizeOut = dstDataSize;
     }
     void pvrNativeTextureTypeProvider::CompressMipmapToPVR(
         Interface *engineInterface,
         uint32 mipWidth, uint32 mipHeight, const void *srcTexels,
         eRasterFormat srcRasterFormat, uint32 srcDepth, uint32 srcRowAlignment, eColorOrdering srcColorOrder, ePaletteType srcPaletteType, const void *srcPaletteData, uint32 srcPaletteSize,
         eRasterFormat pvrRasterFormat, uint32 pvrDepth, eColorOrdering pvrColorOrder,
-        PVRPixelType pvrSrcPixelType, PVRPixelType pvrDstPixelType,
+        ePVRInternalFormat pvrFormat,
         uint32 pvrBlockWidth, uint32 pvrBlockHeight,
         uint32 pvrBlockDepth,
         uint32& widthOut, uint32& heightOut,
@@ -328,7 +319,7 @@ struct pvrNativeTextureTypeProvider : public texNativeTypeProvider
             mipWidth, mipHeight, srcTexels,
             fetchDispatch, srcDepth, srcRowAlignment,
             pvrRasterFormat, pvrDepth, pvrColorOrder,
-            pvrSrcPixelType, pvrDstPixelType,
+            pvrFormat,
             pvrBlockWidth, pvrBlockHeight,
             pvrBlockDepth,
             widthOut, heightOut,
@@ -443,6 +434,12 @@ struct pvrNativeTextureTypeProvider : public texNativeTypeProvider
         return 0;
     }
 
+#ifdef RWLIB_INCLUDE_PVRTEXLIB
+    // PVRTexLib access.
+    typedef void* PVRTextureHeader;
+    typedef void* PVRTexture;
+    typedef void* PVRPixelType;
+
 private:
     static constexpr size_t FUTURE_BUFFER_EXAPAND = 128u;
 
@@ -484,9 +481,9 @@ private:
 
     PVRTranscode_t pvrTranscode;
 
-    bool wasRegistered;
     HMODULE pvrModule;
-    
+    bool isPVRTexLibLoaded;
+
 public:
     // Cached pixel type things.
     PVRPixelType pvrPixelType_pvrtc_2bpp_rgb;
@@ -716,9 +713,9 @@ public:
         return false;
     }
 
-    inline void Initialize( Interface *engineInterface )
+    inline void LoadPVRTexLib( void )
     {
-        bool didRegister = false;
+        bool isLoaded = false;
 
         HMODULE pvrModule = LoadLibraryA( "PVRTexLib.dll" );
 
@@ -787,20 +784,15 @@ public:
                 this->pvrPixelType_rgba8888 = PVRPixelTypeCreate( 'r', 'g', 'b', 'a', 8, 8, 8, 8 );
             }
 
-            didRegister = RegisterNativeTextureType( engineInterface, "PowerVR", this, sizeof( NativeTexturePVR ) );
+            isLoaded = true;
         }
 
-        this->wasRegistered = didRegister;
+        this->isPVRTexLibLoaded = isLoaded;
     }
 
-    inline void Shutdown( Interface *engineInterface )
+    inline void UnloadPVRTexLib( void )
     {
-        if ( this->wasRegistered )
-        {
-            UnregisterNativeTextureType( engineInterface, "PowerVR" );
-
-            this->wasRegistered = false;
-        }
+        this->isPVRTexLibLoaded = false;
 
         // Clean up cached things.
         {
@@ -861,12 +853,40 @@ public:
             this->pvrModule = NULL;
         }
     }
+#endif //RWLIB_INCLUDE_PVRTEXLIB
+
+    inline void Initialize( Interface *engineInterface )
+    {
+#ifdef RWLIB_INCLUDE_PVRTEXLIB
+        // PVRTexLib is optional, we always have our own PVRTC codec.
+        LoadPVRTexLib();
+#endif //RWLIB_INCLUDE_PVRTEXLIB
+
+        this->wasRegistered = RegisterNativeTextureType( engineInterface, "PowerVR", this, sizeof( NativeTexturePVR ) );
+    }
+
+    inline void Shutdown( Interface *engineInterface )
+    {
+        if ( this->wasRegistered )
+        {
+            UnregisterNativeTextureType( engineInterface, "PowerVR" );
+
+            this->wasRegistered = false;
+        }
+
+#ifdef RWLIB_INCLUDE_PVRTEXLIB
+        UnloadPVRTexLib();
+#endif //RWLIB_INCLUDE_PVRTEXLIB
+    }
 
     inline void operator =( const pvrNativeTextureTypeProvider& right )
     {
         // Nothing to do.
         return;
     }
+
+private:
+    bool wasRegistered;
 };
 
 typedef PluginDependantStructRegister <pvrNativeTextureTypeProvider, RwInterfaceFactory_t> pvrNativeTextureTypeProviderRegister_t;
@@ -0,0 +1,1010 @@
+#include "StdInc.h"
+
+#ifdef RWLIB_INCLUDE_NATIVETEX_POWERVR_MOBILE
+
+#include "txdread.pvrtc.hxx"
+
+#include "rwthreading.pool.hxx"
+
+// PVRTC1 stores two low-precision colors per block. Every texel is decoded by bilinearly upscaling
+// the colors of the four blocks around it and blending between the two upscaled colors by a
+// per-texel modulation value.
+
+namespace rw
+{
+
+namespace pvrtc
+{
+
+#pragma pack(1)
+struct pvrtcBlock
+{
+    endian::little_endian <uint32> modulationData;
+    endian::little_endian <uint32> colorData;
+};
+#pragma pack()
+
+// Modulation values are stored in eighths.
+// The upper bits of a decoded modulation value tell how to finish it.
+enum
+{
+    MODFLAG_PUNCHTHROUGH = 0x10,    // alpha is forced to zero
+    MODFLAG_INTERP_HV = 0x20,       // 2bpp only: average of the horizontal and vertical neighbours
+    MODFLAG_INTERP_H = 0x40,        // 2bpp only: average of the horizontal neighbours
+    MODFLAG_INTERP_V = 0x60,        // 2bpp only: average of the vertical neighbours
+
+    MODFLAG_INTERP_MASK = 0x60,
+    MODVALUE_MASK = 0x0F
+};
+
+static const uint8 modulationLevels[ 4 ] = { 0, 3, 5, 8 };
+
+// Block colors in the precision that the upscaling works with: 5bit color and 4bit alpha.
+struct blockColors
+{
+    uint8 colorA[ 4 ];
+    uint8 colorB[ 4 ];
+};
+
+AINLINE uint8 expandTo5( uint32 val, uint32 bits )
+{
+    if ( bits == 4 )
+    {
+        return (uint8)( ( val << 1 ) | ( val >> 3 ) );
+    }
+    else if ( bits == 3 )
+    {
+        return (uint8)( ( val << 2 ) | ( val >> 1 ) );
+    }
+
+    return (uint8)val;
+}
+
+AINLINE void unpackBlockColors( uint32 colorData, blockColors& colorsOut )
+{
+    // Color A takes the lower half, color B the upper half. The mode bit 0 belongs to neither.
+    uint32 a = ( colorData & 0xFFFF );
+
+    if ( a & 0x8000 )
+    {
+        // RGB 554
+        colorsOut.colorA[0] = expandTo5( ( a >> 10 ) & 0x1F, 5 );
+        colorsOut.colorA[1] = expandTo5( ( a >> 5 ) & 0x1F, 5 );
+        colorsOut.colorA[2] = expandTo5( ( a >> 1 ) & 0x0F, 4 );
+        colorsOut.colorA[3] = 0xF;
+    }
+    else
+    {
+        // ARGB 3443
+        colorsOut.colorA[0] = expandTo5( ( a >> 8 ) & 0x0F, 4 );
+        colorsOut.colorA[1] = expandTo5( ( a >> 4 ) & 0x0F, 4 );
+        colorsOut.colorA[2] = expandTo5( ( a >> 1 ) & 0x07, 3 );
+        colorsOut.colorA[3] = (uint8)( ( ( a >> 12 ) & 0x07 ) << 1 );
+    }
+
+    uint32 b = ( colorData >> 16 );
+
+    if ( b & 0x8000 )
+    {
+        // RGB 555
+        colorsOut.colorB[0] = expandTo5( ( b >> 10 ) & 0x1F, 5 );
+        colorsOut.colorB[1] = expandTo5( ( b >> 5 ) & 0x1F, 5 );
+        colorsOut.colorB[2] = expandTo5( b & 0x1F, 5 );
+        colorsOut.colorB[3] = 0xF;
+    }
+    else
+    {
+        // ARGB 3444
+        colorsOut.colorB[0] = expandTo5( ( b >> 8 ) & 0x0F, 4 );
+        colorsOut.colorB[1] = expandTo5( ( b >> 4 ) & 0x0F, 4 );
+        colorsOut.colorB[2] = expandTo5( b & 0x0F, 4 );
+        colorsOut.colorB[3] = (uint8)( ( ( b >> 12 ) & 0x07 ) << 1 );
+    }
+}
+
+AINLINE uint32 spreadBits( uint32 val )
+{
+    val &= 0xFFFF;
+    val = ( val | ( val << 8 ) ) & 0x00FF00FF;
+    val = ( val | ( val << 4 ) ) & 0x0F0F0F0F;
+    val = ( val | ( val << 2 ) ) & 0x33333333;
+    val = ( val | ( val << 1 ) ) & 0x55555555;
+
+    return val;
+}
+
+AINLINE bool isPowerOfTwo( uint32 val )
+{
+    return ( val != 0 && ( val & ( val - 1 ) ) == 0 );
+}
+
+// Blocks are stored in morton order across the square part of the surface, with the remaining
+// squares following each other. The block index splits into a column and a row part.
+struct blockOrder
+{
+    inline blockOrder( uint32 blocksWidth, uint32 blocksHeight )
+    {
+        uint32 minDimm = std::min( blocksWidth, blocksHeight );
+
+        uint32 shiftCount = 0;
+
+        while ( ( 1u << shiftCount ) < minDimm )
+        {
+            shiftCount++;
+        }
+
+        uint32 squareMask = ( ( 1u << shiftCount ) - 1 );
+
+        this->columnOffsets.resize( blocksWidth );
+
+        for ( uint32 x = 0; x < blocksWidth; x++ )
+        {
+            uint32 offset = ( spreadBits( x & squareMask ) << 1 );
+
+            if ( blocksHeight < blocksWidth )
+            {
+                offset += ( ( x >> shiftCount ) << ( shiftCount * 2 ) );
+            }
+
+            this->columnOffsets[ x ] = offset;
+        }
+
+        this->rowOffsets.resize( blocksHeight );
+
+        for ( uint32 y = 0; y < blocksHeight; y++ )
+        {
+            uint32 offset = spreadBits( y & squareMask );
+
+            if ( blocksHeight >= blocksWidth )
+            {
+                offset += ( ( y >> shiftCount ) << ( shiftCount * 2 ) );
+            }
+
+            this->rowOffsets[ y ] = offset;
+        }
+    }
+
+    AINLINE uint32 GetBlockIndex( uint32 x, uint32 y ) const
+    {
+        return ( this->columnOffsets[ x ] + this->rowOffsets[ y ] );
+    }
+
+    std::vector <uint32> columnOffsets;
+    std::vector <uint32> rowOffsets;
+};
+
+// Describes the four blocks that a texel is upscaled from, along with their weights.
+// Weights are given in ( 1 / ( blockWidth * blockHeight ) ).
+struct texelFootprint
+{
+    uint32 blockIndex[ 4 ];     // top-left, top-right, bottom-left, bottom-right (linear, not morton)
+    uint32 weight[ 4 ];
+};
+
+template <uint32 blockWidth, uint32 blockHeight>
+AINLINE void getTexelFootprint( uint32 x, uint32 y, uint32 blocksWidth, uint32 blocksHeight, texelFootprint& footOut )
+{
+    // Block colors sit at the center of their blocks and the surface wraps around.
+    uint32 sx = ( x + blocksWidth * blockWidth - blockWidth / 2 );
+    uint32 sy = ( y + blocksHeight * blockHeight - blockHeight / 2 );
+
+    uint32 bx0 = ( sx / blockWidth ) & ( blocksWidth - 1 );
+    uint32 by0 = ( sy / blockHeight ) & ( blocksHeight - 1 );
+    uint32 bx1 = ( bx0 + 1 ) & ( blocksWidth - 1 );
+    uint32 by1 = ( by0 + 1 ) & ( blocksHeight - 1 );
+
+    uint32 fx = ( sx % blockWidth );
+    uint32 fy = ( sy % blockHeight );
+
+    footOut.blockIndex[0] = ( by0 * blocksWidth + bx0 );
+    footOut.blockIndex[1] = ( by0 * blocksWidth + bx1 );
+    footOut.blockIndex[2] = ( by1 * blocksWidth + bx0 );
+    footOut.blockIndex[3] = ( by1 * blocksWidth + bx1 );
+
+    footOut.weight[0] = ( blockWidth - fx ) * ( blockHeight - fy );
+    footOut.weight[1] = fx * ( blockHeight - fy );
+    footOut.weight[2] = ( blockWidth - fx ) * fy;
+    footOut.weight[3] = fx * fy;
+}
+
+template <uint32 pvrDepth>
+struct pvrtcFormat
+{
+    static constexpr uint32 blockWidth = ( pvrDepth == 2 ? 8 : 4 );
+    static constexpr uint32 blockHeight = 4;
+    static constexpr uint32 weightTotal = ( blockWidth * blockHeight );
+
+    // Reads the modulation values of a block into a map of the whole surface.
+    static AINLINE void UnpackModulation( uint32 modData, bool modeFlag, uint8 *modMap, uint32 surfWidth, uint32 texelX, uint32 texelY )
+    {
+        if ( pvrDepth == 4 )
+        {
+            for ( uint32 y = 0; y < blockHeight; y++ )
+            {
+                uint8 *modRow = ( modMap + ( texelY + y ) * surfWidth + texelX );
+
+                for ( uint32 x = 0; x < blockWidth; x++ )
+                {
+                    uint32 code = ( modData & 3 );
+
+                    uint8 modValue;
+
+                    if ( modeFlag )
+                    {
+                        // Punch-through mode: 0, 4/8, 4/8 with zero alpha, 8/8.
+                        if ( code == 0 )
+                        {
+                            modValue = 0;
+                        }
+                        else if ( code == 3 )
+                        {
+                            modValue = 8;
+                        }
+                        else
+                        {
+                            modValue = ( code == 2 ? ( 4 | MODFLAG_PUNCHTHROUGH ) : 4 );
+                        }
+                    }
+                    else
+                    {
+                        modValue = modulationLevels[ code ];
+                    }
+
+                    modRow[ x ] = modValue;
+
+                    modData >>= 2;
+                }
+            }
+        }
+        else if ( modeFlag == false )
+        {
+            // One bit per texel.
+            for ( uint32 y = 0; y < blockHeight; y++ )
+            {
+                uint8 *modRow = ( modMap + ( texelY + y ) * surfWidth + texelX );
+
+                for ( uint32 x = 0; x < blockWidth; x++ )
+                {
+                    modRow[ x ] = ( ( modData & 1 ) ? 8 : 0 );
+
+                    modData >>= 1;
+                }
+            }
+        }
+        else
+        {
+            // Two bits for every other texel in a checkerboard pattern, the others are
+            // interpolated from their neighbours. The lowest bit of the first stored texel
+            // selects between HV and single-direction interpolation, and if so, the lowest bit
+            // of the center texel selects the direction.
+            uint8 interpFlag = MODFLAG_INTERP_HV;
+
+            if ( modData & 1 )
+            {
+                interpFlag = ( ( modData & ( 1 << 20 ) ) ? MODFLAG_INTERP_V : MODFLAG_INTERP_H );
+
+                if ( modData & ( 1 << 21 ) )
+                {
+                    modData |= ( 1 << 20 );
+                }
+                else
+                {
+                    modData &= ~( 1 << 20 );
+                }
+            }
+
+            if ( modData & 2 )
+            {
+                modData |= 1;
+            }
+            else
+            {
+                modData &= ~1;
+            }
+
+            for ( uint32 y = 0; y < blockHeight; y++ )
+            {
+                uint8 *modRow = ( modMap + ( texelY + y ) * surfWidth + texelX );
+
+                for ( uint32 x = 0; x < blockWidth; x++ )
+                {
+                    if ( ( ( x ^ y ) & 1 ) == 0 )
+                    {
+                        modRow[ x ] = modulationLevels[ modData & 3 ];
+
+                        modData >>= 2;
+                    }
+                    else
+                    {
+                        modRow[ x ] = interpFlag;
+                    }
+                }
+            }
+        }
+    }
+
+    // Returns the final modulation value of a texel, in eighths, along with the punch-through flag.
+    static AINLINE uint32 ResolveModulation( const uint8 *modMap, uint32 surfWidth, uint32 surfHeight, uint32 x, uint32 y )
+    {
+        uint8 modValue = modMap[ y * surfWidth + x ];
+
+        uint32 interpFlag = ( modValue & MODFLAG_INTERP_MASK );
+
+        if ( pvrDepth == 2 && interpFlag != 0 )
+        {
+            // The neighbours of interpolated texels are always stored texels.
+            uint32 left = ( ( x + surfWidth - 1 ) & ( surfWidth - 1 ) );
+            uint32 right = ( ( x + 1 ) & ( surfWidth - 1 ) );
+            uint32 up = ( ( y + surfHeight - 1 ) & ( surfHeight - 1 ) );
+            uint32 down = ( ( y + 1 ) & ( surfHeight - 1 ) );
+
+            uint32 horiSum = ( modMap[ y * surfWidth + left ] & MODVALUE_MASK ) + ( modMap[ y * surfWidth + right ] & MODVALUE_MASK );
+            uint32 vertSum = ( modMap[ up * surfWidth + x ] & MODVALUE_MASK ) + ( modMap[ down * surfWidth + x ] & MODVALUE_MASK );
+
+            if ( interpFlag == MODFLAG_INTERP_HV )
+            {
+                return ( horiSum + vertSum + 2 ) / 4;
+            }
+            else if ( interpFlag == MODFLAG_INTERP_H )
+            {
+                return ( horiSum + 1 ) / 2;
+            }
+
+            return ( vertSum + 1 ) / 2;
+        }
+
+        return modValue;
+    }
+};
+
+// Brings the upscaled colors to 8bit precision and blends them like PowerVR hardware does.
+// upA and upB are in ( 1 / weightTotal ) of 5bit color and 4bit alpha.
+template <uint32 weightTotal>
+AINLINE void finishTexelColor( const uint32 upA[ 4 ], const uint32 upB[ 4 ], uint32 modValue, bool punchThrough, uint8 *texelOut )
+{
+    // Scale both block sizes to the same precision, then replicate the upper bits into the lower ones.
+    constexpr uint32 precisionScale = ( 64 / weightTotal );
+
+    for ( uint32 c = 0; c < 4; c++ )
+    {
+        uint32 scaledA = ( upA[ c ] * precisionScale );
+        uint32 scaledB = ( upB[ c ] * precisionScale );
+
+        uint32 colorA, colorB;
+
+        if ( c == 3 )
+        {
+            colorA = ( scaledA >> 6 ) + ( scaledA >> 2 );
+            colorB = ( scaledB >> 6 ) + ( scaledB >> 2 );
+        }
+        else
+        {
+            colorA = ( scaledA >> 8 ) + ( scaledA >> 3 );
+            colorB = ( scaledB >> 8 ) + ( scaledB >> 3 );
+        }
+
+        texelOut[ c ] = (uint8)( ( colorA * ( 8 - modValue ) + colorB * modValue ) / 8 );
+    }
+
+    if ( punchThrough )
+    {
+        texelOut[ 3 ] = 0;
+    }
+}
+
+template <uint32 weightTotal>
+AINLINE void upscaleColors( const blockColors *colors, const texelFootprint& foot, uint32 upA[ 4 ], uint32 upB[ 4 ] )
+{
+    for ( uint32 c = 0; c < 4; c++ )
+    {
+        upA[ c ] = 0;
+        upB[ c ] = 0;
+    }
+
+    for ( uint32 n = 0; n < 4; n++ )
+    {
+        const blockColors& blockCol = colors[ foot.blockIndex[ n ] ];
+        uint32 weight = foot.weight[ n ];
+
+        for ( uint32 c = 0; c < 4; c++ )
+        {
+            upA[ c ] += blockCol.colorA[ c ] * weight;
+            upB[ c ] += blockCol.colorB[ c ] * weight;
+        }
+    }
+}
+
+template <uint32 pvrDepth>
+static void decompressSurface(
+    EngineInterface *engineInterface,
+    uint32 surfWidth, uint32 surfHeight, const void *srcBlocks,
+    void *dstTexels, uint32 dstRowSize
+)
+{
+    typedef pvrtcFormat <pvrDepth> format;
+
+    uint32 blocksWidth = ( surfWidth / format::blockWidth );
+    uint32 blocksHeight = ( surfHeight / format::blockHeight );
+
+    blockOrder order( blocksWidth, blocksHeight );
+
+    std::vector <blockColors> colors( blocksWidth * blocksHeight );
+    std::vector <uint8> modMap( surfWidth * surfHeight );
+
+    const pvrtcBlock *blocks = (const pvrtcBlock*)srcBlocks;
+
+    uint32 parallelCount = GetParallelConcurrency( engineInterface );
+
+    // First read all blocks, since texels depend on the neighbouring blocks.
+    auto unpackRow = [&]( uint32 by )
+    {
+        for ( uint32 bx = 0; bx < blocksWidth; bx++ )
+        {
+            const pvrtcBlock& block = blocks[ order.GetBlockIndex( bx, by ) ];
+
+            uint32 colorData = block.colorData;
+
+            unpackBlockColors( colorData, colors[ by * blocksWidth + bx ] );
+
+            format::UnpackModulation(
+                block.modulationData, ( colorData & 1 ) != 0,
+                modMap.data(), surfWidth, bx * format::blockWidth, by * format::blockHeight
+            );
+        }
+    };
+
+    ParallelFor( engineInterface, blocksHeight, parallelCount, unpackRow );
+
+    auto decodeRow = [&]( uint32 by )
+    {
+        for ( uint32 y = by * format::blockHeight; y < ( by + 1 ) * format::blockHeight; y++ )
+        {
+            uint8 *dstRow = ( (uint8*)dstTexels + y * dstRowSize );
+
+            for ( uint32 x = 0; x < surfWidth; x++ )
+            {
+                texelFootprint foot;
+                getTexelFootprint <format::blockWidth, format::blockHeight> ( x, y, blocksWidth, blocksHeight, foot );
+
+                uint32 upA[ 4 ], upB[ 4 ];
+                upscaleColors <format::weightTotal> ( colors.data(), foot, upA, upB );
+
+                uint32 modValue = format::ResolveModulation( modMap.data(), surfWidth, surfHeight, x, y );
+
+                finishTexelColor <format::weightTotal> (
+                    upA, upB,
+                    ( modValue & MODVALUE_MASK ), ( modValue & MODFLAG_PUNCHTHROUGH ) != 0,
+                    dstRow + x * 4
+                );
+            }
+        }
+    };
+
+    ParallelFor( engineInterface, blocksHeight, parallelCount, decodeRow );
+}
+
+inline void verifySurfaceDimensions( uint32 pvrDepth, uint32 surfWidth, uint32 surfHeight )
+{
+    if ( pvrDepth != 2 && pvrDepth != 4 )
+    {
+        throw RwException( "invalid PVRTC bit depth" );
+    }
+
+    uint32 blockWidth = getBlockWidth( pvrDepth );
+    uint32 blockHeight = getBlockHeight( pvrDepth );
+
+    if ( !isPowerOfTwo( surfWidth ) || !isPowerOfTwo( surfHeight ) ||
+         surfWidth < blockWidth * 2 || surfHeight < blockHeight * 2 )
+    {
+        throw RwException( "PVRTC surface dimensions have to be power-of-two and at least two blocks wide and high" );
+    }
+}
+
+void DecompressSurface(
+    EngineInterface *engineInterface, uint32 pvrDepth,
+    uint32 surfWidth, uint32 surfHeight, const void *srcBlocks,
+    void *dstTexels, uint32 dstRowSize
+)
+{
+    verifySurfaceDimensions( pvrDepth, surfWidth, surfHeight );
+
+    if ( pvrDepth == 2 )
+    {
+        decompressSurface <2> ( engineInterface, surfWidth, surfHeight, srcBlocks, dstTexels, dstRowSize );
+    }
+    else
+    {
+        decompressSurface <4> ( engineInterface, surfWidth, surfHeight, srcBlocks, dstTexels, dstRowSize );
+    }
+}
+
+// The encoder starts every block with the bounding box of its texels and then refines the
+// block colors by least squares against the chosen modulation. A block influences the texels of
+// its 3x3 block neighbourhood only, so blocks of equal coordinate parity are refined in parallel.
+// 2bpp blocks are always encoded with one modulation bit per texel.
+struct encoderBlock
+{
+    float colorA[ 4 ];
+    float colorB[ 4 ];
+
+    bool isOpaque;
+};
+
+static const uint32 ENCODER_REFINE_PASSES = 2;
+
+// Picks the code of a color channel that decodes nearest to the wanted value.
+AINLINE uint32 quantizeChannel( float val, uint32 bits, bool isAlpha )
+{
+    uint32 maxCode = ( ( 1u << bits ) - 1 );
+
+    int32 guess = (int32)( val * maxCode / 255.0f + 0.5f );
+
+    uint32 bestCode = 0;
+    float bestError = 0;
+    bool hasBest = false;
+
+    for ( int32 code = guess - 1; code <= guess + 1; code++ )
+    {
+        if ( code < 0 || code > (int32)maxCode )
+            continue;
+
+        float decoded;
+
+        if ( isAlpha )
+        {
+            // 3bit alpha turns into 4bit alpha with a zero bit below.
+            decoded = (float)( ( code << 1 ) * 17 );
+        }
+        else
+        {
+            decoded = (float)expandTo5( code, bits ) * 255.0f / 31.0f;
+        }
+
+        float error = fabs( decoded - val );
+
+        if ( !hasBest || error < bestError )
+        {
+            bestCode = code;
+            bestError = error;
+            hasBest = true;
+        }
+    }
+
+    return bestCode;
+}
+
+AINLINE uint32 packBlockColors( const encoderBlock& block )
+{
+    uint32 colorData = 0;
+
+    if ( block.isOpaque )
+    {
+        uint32 a =
+            0x8000 |
+            ( quantizeChannel( block.colorA[0], 5, false ) << 10 ) |
+            ( quantizeChannel( block.colorA[1], 5, false ) << 5 ) |
+            ( quantizeChannel( block.colorA[2], 4, false ) << 1 );
+
+        uint32 b =
+            0x8000 |
+            ( quantizeChannel( block.colorB[0], 5, false ) << 10 ) |
+            ( quantizeChannel( block.colorB[1], 5, false ) << 5 ) |
+            ( quantizeChannel( block.colorB[2], 5, false ) );
+
+        colorData = ( a | ( b << 16 ) );
+    }
+    else
+    {
+        uint32 a =
+            ( quantizeChannel( block.colorA[3], 3, true ) << 12 ) |
+            ( quantizeChannel( block.colorA[0], 4, false ) << 8 ) |
+            ( quantizeChannel( block.colorA[1], 4, false ) << 4 ) |
+            ( quantizeChannel( block.colorA[2], 3, false ) << 1 );
+
+        uint32 b =
+            ( quantizeChannel( block.colorB[3], 3, true ) << 12 ) |
+            ( quantizeChannel( block.colorB[0], 4, false ) << 8 ) |
+            ( quantizeChannel( block.colorB[1], 4, false ) << 4 ) |
+            ( quantizeChannel( block.colorB[2], 4, false ) );
+
+        colorData = ( a | ( b << 16 ) );
+    }
+
+    // The mode bit stays zero: 4bpp blocks use the standard modulation levels and 2bpp blocks
+    // store one modulation bit per texel.
+    return colorData;
+}
+
+template <uint32 pvrDepth>
+static void compressSurface(
+    EngineInterface *engineInterface, bool hasAlpha,
+    uint32 surfWidth, uint32 surfHeight, const void *srcTexels, uint32 srcRowSize,
+    void *dstBlocks
+)
+{
+    typedef pvrtcFormat <pvrDepth> format;
+
+    constexpr uint32 blockWidth = format::blockWidth;
+    constexpr uint32 blockHeight = format::blockHeight;
+    constexpr float weightScale = ( 1.0f / format::weightTotal );
+
+    // Candidate modulation values in eighths, in the order of their codes.
+    constexpr uint32 modCandidateCount = ( pvrDepth == 4 ? 4 : 2 );
+    static const uint8 modCandidates[ 2 ][ 4 ] = { { 0, 8 }, { 0, 3, 5, 8 } };
+
+    const uint8 *useModCandidates = modCandidates[ pvrDepth == 4 ? 1 : 0 ];
+
+    uint32 blocksWidth = ( surfWidth / blockWidth );
+    uint32 blocksHeight = ( surfHeight / blockHeight );
+
+    std::vector <encoderBlock> encBlocks( blocksWidth * blocksHeight );
+    std::vector <uint8> modMap( surfWidth * surfHeight );
+
+    uint32 parallelCount = GetParallelConcurrency( engineInterface );
+
+    auto getSourceTexel = [&]( uint32 x, uint32 y, float colorOut[ 4 ] )
+    {
+        const uint8 *texel = ( (const uint8*)srcTexels + y * srcRowSize + x * 4 );
+
+        colorOut[0] = texel[0];
+        colorOut[1] = texel[1];
+        colorOut[2] = texel[2];
+        colorOut[3] = ( hasAlpha ? texel[3] : 255.0f );
+    };
+
+    auto getUpscaledColors = [&]( const texelFootprint& foot, float upA[ 4 ], float upB[ 4 ] )
+    {
+        for ( uint32 c = 0; c < 4; c++ )
+        {
+            upA[ c ] = 0;
+            upB[ c ] = 0;
+        }
+
+        for ( uint32 n = 0; n < 4; n++ )
+        {
+            const encoderBlock& block = encBlocks[ foot.blockIndex[ n ] ];
+            float weight = ( foot.weight[ n ] * weightScale );
+
+            for ( uint32 c = 0; c < 4; c++ )
+            {
+                upA[ c ] += block.colorA[ c ] * weight;
+                upB[ c ] += block.colorB[ c ] * weight;
+            }
+        }
+    };
+
+    // Start with the bounding box of every block.
+    auto initializeRow = [&]( uint32 by )
+    {
+        for ( uint32 bx = 0; bx < blocksWidth; bx++ )
+        {
+            encoderBlock& block = encBlocks[ by * blocksWidth + bx ];
+
+            float minColor[ 4 ] = { 255, 255, 255, 255 };
+            float maxColor[ 4 ] = { 0, 0, 0, 0 };
+
+            for ( uint32 y = 0; y < blockHeight; y++ )
+            {
+                for ( uint32 x = 0; x < blockWidth; x++ )
+                {
+                    float color[ 4 ];
+                    getSourceTexel( bx * blockWidth + x, by * blockHeight + y, color );
+
+                    for ( uint32 c = 0; c < 4; c++ )
+                    {
+                        minColor[ c ] = std::min( minColor[ c ], color[ c ] );
+                        maxColor[ c ] = std::max( maxColor[ c ], color[ c ] );
+                    }
+                }
+            }
+
+            // The translucent color modes cost a lot of color precision, so we only take them
+            // if any texel that this block influences is not (close to) opaque.
+            bool isOpaque = true;
+
+            if ( hasAlpha )
+            {
+                for ( int32 dy = -(int32)blockHeight; dy < (int32)( blockHeight * 2 ) && isOpaque; dy++ )
+                {
+                    uint32 y = ( ( by * blockHeight + surfHeight + dy ) & ( surfHeight - 1 ) );
+
+                    const uint8 *srcRow = ( (const uint8*)srcTexels + y * srcRowSize );
+
+                    for ( int32 dx = -(int32)blockWidth; dx < (int32)( blockWidth * 2 ); dx++ )
+                    {
+                        uint32 x = ( ( bx * blockWidth + surfWidth + dx ) & ( surfWidth - 1 ) );
+
+                        if ( srcRow[ x * 4 + 3 ] < 0xF8 )
+                        {
+                            isOpaque = false;
+                            break;
+                        }
+                    }
+                }
+            }
+
+            for ( uint32 c = 0; c < 4; c++ )
+            {
+                block.colorA[ c ] = minColor[ c ];
+                block.colorB[ c ] = maxColor[ c ];
+            }
+
+            if ( isOpaque )
+            {
+                block.colorA[ 3 ] = 255;
+                block.colorB[ 3 ] = 255;
+            }
+
+            block.isOpaque = isOpaque;
+        }
+    };
+
+    ParallelFor( engineInterface, blocksHeight, parallelCount, initializeRow );
+
+    auto selectModulationRow = [&]( uint32 by )
+    {
+        for ( uint32 y = by * blockHeight; y < ( by + 1 ) * blockHeight; y++ )
+        {
+            for ( uint32 x = 0; x < surfWidth; x++ )
+            {
+                texelFootprint foot;
+                getTexelFootprint <blockWidth, blockHeight> ( x, y, blocksWidth, blocksHeight, foot );
+
+                float upA[ 4 ], upB[ 4 ];
+                getUpscaledColors( foot, upA, upB );
+
+                float color[ 4 ];
+                getSourceTexel( x, y, color );
+
+                uint8 bestMod = 0;
+                float bestError = 0;
+
+                for ( uint32 n = 0; n < modCandidateCount; n++ )
+                {
+                    float modFactor = ( useModCandidates[ n ] / 8.0f );
+
+                    float error = 0;
+
+                    for ( uint32 c = 0; c < 4; c++ )
+                    {
+                        float diff = ( upA[ c ] + ( upB[ c ] - upA[ c ] ) * modFactor - color[ c ] );
+
+                        error += diff * diff;
+                    }
+
+                    if ( n == 0 || error < bestError )
+                    {
+                        bestMod = useModCandidates[ n ];
+                        bestError = error;
+                    }
+                }
+
+                modMap[ y * surfWidth + x ] = bestMod;
+            }
+        }
+    };
+
+    // Solves the block colors that fit the texels around a block best if everything else stays.
+    auto refineBlock = [&]( uint32 bx, uint32 by )
+    {
+        encoderBlock& block = encBlocks[ by * blocksWidth + bx ];
+
+        float sumAA = 0, sumAB = 0, sumBB = 0;
+        float sumAT[ 4 ] = { 0, 0, 0, 0 };
+        float sumBT[ 4 ] = { 0, 0, 0, 0 };
+
+        uint32 centerX = ( bx * blockWidth + blockWidth / 2 );
+        uint32 centerY = ( by * blockHeight + blockHeight / 2 );
+
+        for ( int32 dy = -(int32)blockHeight + 1; dy < (int32)blockHeight; dy++ )
+        {
+            uint32 y = ( ( centerY + surfHeight + dy ) & ( surfHeight - 1 ) );
+            float weightY = (float)( blockHeight - std::abs( dy ) );
+
+            for ( int32 dx = -(int32)blockWidth + 1; dx < (int32)blockWidth; dx++ )
+            {
+                uint32 x = ( ( centerX + surfWidth + dx ) & ( surfWidth - 1 ) );
+                float weight = ( weightY * ( blockWidth - std::abs( dx ) ) * weightScale );
+
+                texelFootprint foot;
+                getTexelFootprint <blockWidth, blockHeight> ( x, y, blocksWidth, blocksHeight, foot );
+
+                float upA[ 4 ], upB[ 4 ];
+                getUpscaledColors( foot, upA, upB );
+
+                float color[ 4 ];
+                getSourceTexel( x, y, color );
+
+                float modFactor = ( modMap[ y * surfWidth + x ] / 8.0f );
+
+                float factorA = weight * ( 1.0f - modFactor );
+                float factorB = weight * modFactor;
+
+                sumAA += factorA * factorA;
+                sumAB += factorA * factorB;
+                sumBB += factorB * factorB;
+
+                for ( uint32 c = 0; c < 4; c++ )
+                {
+                    // What is left for this block after the other blocks have contributed.
+                    float others =
+                        ( 1.0f - modFactor ) * ( upA[ c ] - weight * block.colorA[ c ] ) +
+                        modFactor * ( upB[ c ] - weight * block.colorB[ c ] );
+
+                    float target = ( color[ c ] - others );
+
+                    sumAT[ c ] += factorA * target;
+                    sumBT[ c ] += factorB * target;
+                }
+            }
+        }
+
+        float det = ( sumAA * sumBB - sumAB * sumAB );
+
+        for ( uint32 c = 0; c < 4; c++ )
+        {
+            float newA = block.colorA[ c ];
+            float newB = block.colorB[ c ];
+
+            if ( fabs( det ) > 1e-6f )
+            {
+                newA = ( sumAT[ c ] * sumBB - sumBT[ c ] * sumAB ) / det;
+                newB = ( sumBT[ c ] * sumAA - sumAT[ c ] * sumAB ) / det;
+            }
+            else if ( sumAA > 1e-6f && sumBB <= 1e-6f )
+            {
+                // Only color A is used around this block.
+                newA = ( sumAT[ c ] / sumAA );
+            }
+            else if ( sumBB > 1e-6f && sumAA <= 1e-6f )
+            {
+                newB = ( sumBT[ c ] / sumBB );
+            }
+
+            block.colorA[ c ] = std::min( std::max( newA, 0.0f ), 255.0f );
+            block.colorB[ c ] = std::min( std::max( newB, 0.0f ), 255.0f );
+        }
+
+        if ( block.isOpaque )
+        {
+            block.colorA[ 3 ] = 255;
+            block.colorB[ 3 ] = 255;
+        }
+    };
+
+    for ( uint32 pass = 0; pass < ENCODER_REFINE_PASSES; pass++ )
+    {
+        ParallelFor( engineInterface, blocksHeight, parallelCount, selectModulationRow );
+
+        for ( uint32 parityY = 0; parityY < 2; parityY++ )
+        {
+            for ( uint32 parityX = 0; parityX < 2; parityX++ )
+            {
+                auto refineRow = [&]( uint32 rowIndex )
+                {
+                    uint32 by = ( rowIndex * 2 + parityY );
+
+                    for ( uint32 bx = parityX; bx < blocksWidth; bx += 2 )
+                    {
+                        refineBlock( bx, by );
+                    }
+                };
+
+                ParallelFor( engineInterface, blocksHeight / 2, parallelCount, refineRow );
+            }
+        }
+    }
+
+    // Now bring the block colors down to the stored precision and choose the final modulation
+    // against what the decoder will actually produce.
+    std::vector <uint32> colorWords( blocksWidth * blocksHeight );
+    std::vector <blockColors> quantColors( blocksWidth * blocksHeight );
+
+    auto quantizeRow = [&]( uint32 by )
+    {
+        for ( uint32 bx = 0; bx < blocksWidth; bx++ )
+        {
+            uint32 blockIndex = ( by * blocksWidth + bx );
+
+            uint32 colorData = packBlockColors( encBlocks[ blockIndex ] );
+
+            colorWords[ blockIndex ] = colorData;
+
+            unpackBlockColors( colorData, quantColors[ blockIndex ] );
+        }
+    };
+
+    ParallelFor( engineInterface, blocksHeight, parallelCount, quantizeRow );
+
+    blockOrder order( blocksWidth, blocksHeight );
+
+    pvrtcBlock *blocks = (pvrtcBlock*)dstBlocks;
+
+    auto encodeRow = [&]( uint32 by )
+    {
+        for ( uint32 bx = 0; bx < blocksWidth; bx++ )
+        {
+            uint32 modData = 0;
+            uint32 modBit = 0;
+
+            for ( uint32 ly = 0; ly < blockHeight; ly++ )
+            {
+                uint32 y = ( by * blockHeight + ly );
+
+                for ( uint32 lx = 0; lx < blockWidth; lx++ )
+                {
+                    uint32 x = ( bx * blockWidth + lx );
+
+                    texelFootprint foot;
+                    getTexelFootprint <blockWidth, blockHeight> ( x, y, blocksWidth, blocksHeight, foot );
+
+                    uint32 upA[ 4 ], upB[ 4 ];
+                    upscaleColors <format::weightTotal> ( quantColors.data(), foot, upA, upB );
+
+                    const uint8 *srcTexel = ( (const uint8*)srcTexels + y * srcRowSize + x * 4 );
+
+                    uint32 bestCode = 0;
+                    uint32 bestError = 0;
+
+                    for ( uint32 n = 0; n < modCandidateCount; n++ )
+                    {
+                        uint8 decoded[ 4 ];
+                        finishTexelColor <format::weightTotal> ( upA, upB, useModCandidates[ n ], false, decoded );
+
+                        uint32 error = 0;
+
+                        for ( uint32 c = 0; c < 4; c++ )
+                        {
+                            if ( c == 3 && !hasAlpha )
+                                continue;
+
+                            int32 diff = ( (int32)decoded[ c ] - (int32)srcTexel[ c ] );
+
+                            error += (uint32)( diff * diff );
+                        }
+
+                        if ( n == 0 || error < bestError )
+                        {
+                            bestCode = n;
+                            bestError = error;
+                        }
+                    }
+
+                    modData |= ( bestCode << modBit );
+                    modBit += ( pvrDepth == 4 ? 2 : 1 );
+                }
+            }
+
+            pvrtcBlock& block = blocks[ order.GetBlockIndex( bx, by ) ];
+
+            block.modulationData = modData;
+            block.colorData = colorWords[ by * blocksWidth + bx ];
+        }
+    };
+
+    ParallelFor( engineInterface, blocksHeight, parallelCount, encodeRow );
+}
+
+void CompressSurface(
+    EngineInterface *engineInterface, uint32 pvrDepth, bool hasAlpha,
+    uint32 surfWidth, uint32 surfHeight, const void *srcTexels, uint32 srcRowSize,
+    void *dstBlocks
+)
+{
+    verifySurfaceDimensions( pvrDepth, surfWidth, surfHeight );
+
+    if ( pvrDepth == 2 )
+    {
+        compressSurface <2> ( engineInterface, hasAlpha, surfWidth, surfHeight, srcTexels, srcRowSize, dstBlocks );
+    }
+    else
+    {
+        compressSurface <4> ( engineInterface, hasAlpha, surfWidth, surfHeight, srcTexels, srcRowSize, dstBlocks );
+    }
+}
+
+};
+
+};
+
+#endif //RWLIB_INCLUDE_NATIVETEX_POWERVR_MOBILE
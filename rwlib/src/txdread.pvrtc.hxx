@@ -0,0 +1,43 @@
+// PVRTC1 texture compression (2bpp and 4bpp).
+// The PowerVR native texture and native image use this codec when PVRTexLib is not available or not wanted.
+#ifndef _RENDERWARE_PVRTC_CODEC_
+#define _RENDERWARE_PVRTC_CODEC_
+
+namespace rw
+{
+
+namespace pvrtc
+{
+
+// Dimensions of the area that is covered by a single 64bit PVRTC block.
+inline uint32 getBlockWidth( uint32 pvrDepth )
+{
+    return ( pvrDepth == 2 ? 8u : 4u );
+}
+
+inline uint32 getBlockHeight( uint32 pvrDepth )
+{
+    return 4u;
+}
+
+// Decodes a PVRTC surface into RGBA8888 texels.
+// The surface dimensions have to be power-of-two and at least two blocks wide and high.
+void DecompressSurface(
+    EngineInterface *engineInterface, uint32 pvrDepth,
+    uint32 surfWidth, uint32 surfHeight, const void *srcBlocks,
+    void *dstTexels, uint32 dstRowSize
+);
+
+// Encodes RGBA8888 texels into a PVRTC surface of ( surfWidth * surfHeight * pvrDepth / 8 ) bytes.
+// If hasAlpha is false, the alpha channel of the source is ignored and every block is stored opaque.
+void CompressSurface(
+    EngineInterface *engineInterface, uint32 pvrDepth, bool hasAlpha,
+    uint32 surfWidth, uint32 surfHeight, const void *srcTexels, uint32 srcRowSize,
+    void *dstBlocks
+);
+
+};
+
+};
+
+#endif //_RENDERWARE_PVRTC_CODEC_
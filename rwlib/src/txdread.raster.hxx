@@ -235,6 +235,61 @@ struct nativeTextureStreamPlugin : public serializationProvider
         messages_t message_list;
     };
 
+    // Reads the texture properties of a texture native block without reading its texel data.
+    // This only succeeds if one provider is sure about the block; ambiguous blocks have to be deserialized fully.
+    bool DeserializeProperties( BlockProvider& inputProvider, TextureBase *theTexture ) const
+    {
+        texNativeTypeProvider *electedProvider = NULL;
+        bool isAbsoluteElection = false;
+        bool isAmbiguous = false;
+
+        LIST_FOREACH_BEGIN( texNativeTypeProvider, this->texNativeTypes.root, managerData.managerNode )
+
+            inputProvider.seek( 0, RWSEEK_BEG );
+
+            eTexNativeCompatibility thisCompat = RWTEXCOMPAT_NONE;
+
+            try
+            {
+                thisCompat = item->IsCompatibleTextureBlock( inputProvider );
+            }
+            catch( RwException& )
+            {
+                thisCompat = RWTEXCOMPAT_NONE;
+            }
+
+            if ( thisCompat == RWTEXCOMPAT_ABSOLUTE )
+            {
+                if ( isAbsoluteElection )
+                {
+                    return false;
+                }
+
+                electedProvider = item;
+                isAbsoluteElection = true;
+            }
+            else if ( thisCompat == RWTEXCOMPAT_MAYBE && !isAbsoluteElection )
+            {
+                if ( electedProvider != NULL )
+                {
+                    isAmbiguous = true;
+                }
+
+                electedProvider = item;
+            }
+
+        LIST_FOREACH_END
+
+        if ( electedProvider == NULL || ( isAmbiguous && !isAbsoluteElection ) )
+        {
+            return false;
+        }
+
+        inputProvider.seek( 0, RWSEEK_BEG );
+
+        return electedProvider->DeserializeTextureProperties( theTexture, inputProvider );
+    }
+
     void Deserialize( Interface *intf, BlockProvider& inputProvider, RwObject *objectToDeserialize ) const
     {
         EngineInterface *engineInterface = (EngineInterface*)intf;
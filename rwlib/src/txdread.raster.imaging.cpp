@@ -213,6 +213,25 @@ void Raster::writeImage(Stream *outputStream, const char *method)
     }
 }
 
+// Decides the format that imaging rows are decoded into, for a native texture.
+struct rasterImagingTargetSelector : public imagingTargetFormatSelector
+{
+    inline rasterImagingTargetSelector( Interface *engineInterface, const texNativeTypeProvider *texProvider )
+    {
+        this->engineInterface = engineInterface;
+        this->texProvider = texProvider;
+    }
+
+    void ChooseTargetFormat( const pixelFormat& srcFormat, uint32 srcPaletteSize, pixelFormat& dstFormatOut ) const override
+    {
+        // Alpha only matters for compressed sources, which imaging formats do not give.
+        DecideCompatiblePixelFormat( this->engineInterface, srcFormat, srcPaletteSize, false, this->texProvider, dstFormatOut );
+    }
+
+    Interface *engineInterface;
+    const texNativeTypeProvider *texProvider;
+};
+
 void Raster::readImage( rw::Stream *inputStream )
 {
     scoped_rwlock_writer <rwlock> rasterConsistency( GetRasterLock( this ) );
@@ -278,9 +297,12 @@ void Raster::readImage( rw::Stream *inputStream )
     if ( !hasDeserialized )
     {
         // Attempt to get a mipmap layer from the stream.
+        // Rows are put into the target format while decoding, so the image is never stored twice.
         rawMipmapLayer rawImagingLayer;
 
-        bool deserializeSuccess = DeserializeMipmapLayer( inputStream, rawImagingLayer );
+        rasterImagingTargetSelector targetSelector( engineInterface, texProvider );
+
+        bool deserializeSuccess = DeserializeMipmapLayerToFormat( inputStream, targetSelector, rawImagingLayer );
 
         if ( !deserializeSuccess )
         {
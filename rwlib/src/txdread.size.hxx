@@ -14,6 +14,8 @@
 
 #include "txdread.nativetex.hxx"
 
+#include "rwsimd.hxx"
+
 namespace rw
 {
 
@@ -34,10 +36,26 @@ struct resizeColorPipeline abstract
     virtual bool putcolor( uint32 x, uint32 y, const abstractColorItem& colorIn ) = 0;
 };
 
+// Filters that are described by a symmetric one-dimensional kernel.
+// Those are applied in two passes over whole rows, which works for any resize ratio.
+struct resizeSeparableKernel abstract
+{
+    // Radius of the kernel in source pixels, if the raster is not minified.
+    virtual double GetSupport( void ) const = 0;
+
+    virtual double Evaluate( double x ) const = 0;
+};
+
 struct rasterResizeFilterInterface abstract
 {
     virtual void GetSupportedFiltering( resizeFilteringCaps& filterOut ) const = 0;
 
+    // If a filter has a separable kernel, it is used instead of the per-pixel filtering methods.
+    virtual const resizeSeparableKernel* GetSeparableKernel( void ) const
+    {
+        return NULL;
+    }
+
     virtual void MagnifyFiltering(
         const resizeColorPipeline& srcBmp, uint32 magX, uint32 magY, uint32 magScaleX, uint32 magScaleY,
         resizeColorPipeline& dstBmp, uint32 dstX, uint32 dstY
@@ -468,6 +486,185 @@ private:
     rasterResizeFilterInterface *upscaleFilter;
 };
 
+AINLINE float clampColorChannel( float value )
+{
+    return std::min( std::max( value, 0.0f ), 1.0f );
+}
+
+// Reads and writes rows of colors as four floats per texel. Luminance colors use the first two floats.
+// Used by the resize filters and the mipmap generator.
+struct resampleRowCodec
+{
+    inline resampleRowCodec(
+        eRasterFormat rasterFormat, eColorOrdering colorOrder,
+        uint32 srcDepth, ePaletteType paletteType, const void *paletteData, uint32 paletteSize,
+        uint32 dstDepth
+    ) : srcDispatch( rasterFormat, colorOrder, srcDepth, paletteData, paletteSize, paletteType ),
+        dstDispatch( rasterFormat, colorOrder, dstDepth, NULL, 0, PALETTE_NONE )
+    {
+        this->colorModel = srcDispatch.getColorModel();
+
+        // Source and destination are the same 8888 format, so we do not have to care about the color order.
+        this->isRawBytes =
+            ( rasterFormat == RASTER_8888 && paletteType == PALETTE_NONE && srcDepth == 32 && dstDepth == 32 );
+    }
+
+    inline void DecodeRow( const void *srcRow, float *colorsOut, uint32 count ) const
+    {
+        if ( this->isRawBytes )
+        {
+            const uint8 *srcBytes = (const uint8*)srcRow;
+
+            uint32 n = 0;
+
+#ifdef RWLIB_ENABLE_X86_SIMD
+            const __m128 scale = _mm_set1_ps( 1.0f / 255.0f );
+            const __m128i zero = _mm_setzero_si128();
+
+            for ( ; n < count; n++ )
+            {
+                int texel;
+                memcpy( &texel, srcBytes + n * 4, sizeof( texel ) );
+
+                __m128i bytes = _mm_unpacklo_epi16( _mm_unpacklo_epi8( _mm_cvtsi32_si128( texel ), zero ), zero );
+
+                _mm_storeu_ps( colorsOut + n * 4, _mm_mul_ps( _mm_cvtepi32_ps( bytes ), scale ) );
+            }
+#endif //RWLIB_ENABLE_X86_SIMD
+
+            for ( uint32 byteIndex = n * 4; byteIndex < count * 4; byteIndex++ )
+            {
+                colorsOut[ byteIndex ] = ( srcBytes[ byteIndex ] / 255.0f );
+            }
+
+            return;
+        }
+
+        eColorModel model = this->colorModel;
+
+        for ( uint32 n = 0; n < count; n++ )
+        {
+            abstractColorItem colorItem;
+
+            srcDispatch.getColor( srcRow, n, colorItem );
+
+            float *color = colorsOut + n * 4;
+
+            if ( model == COLORMODEL_RGBA )
+            {
+                color[0] = colorItem.rgbaColor.r;
+                color[1] = colorItem.rgbaColor.g;
+                color[2] = colorItem.rgbaColor.b;
+                color[3] = colorItem.rgbaColor.a;
+            }
+            else
+            {
+                color[0] = colorItem.luminance.lum;
+                color[1] = colorItem.luminance.alpha;
+                color[2] = 0;
+                color[3] = 0;
+            }
+        }
+    }
+
+    inline void EncodeRow( const float *colors, void *dstRow, uint32 count ) const
+    {
+        if ( this->isRawBytes )
+        {
+            uint8 *dstBytes = (uint8*)dstRow;
+
+            uint32 n = 0;
+
+#ifdef RWLIB_ENABLE_X86_SIMD
+            const __m128 scale = _mm_set1_ps( 255.0f );
+            const __m128 half = _mm_set1_ps( 0.5f );
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 one = _mm_set1_ps( 1.0f );
+
+            for ( ; n < count; n++ )
+            {
+                __m128 color = _mm_min_ps( _mm_max_ps( _mm_loadu_ps( colors + n * 4 ), zero ), one );
+
+                // Same rounding as the color dispatcher.
+                __m128i ints = _mm_cvttps_epi32( _mm_add_ps( _mm_mul_ps( color, scale ), half ) );
+
+                __m128i words = _mm_packs_epi32( ints, ints );
+                int texel = _mm_cvtsi128_si32( _mm_packus_epi16( words, words ) );
+
+                memcpy( dstBytes + n * 4, &texel, sizeof( texel ) );
+            }
+#endif //RWLIB_ENABLE_X86_SIMD
+
+            for ( uint32 byteIndex = n * 4; byteIndex < count * 4; byteIndex++ )
+            {
+                dstBytes[ byteIndex ] = (uint8)( clampColorChannel( colors[ byteIndex ] ) * 255.0f + 0.5f );
+            }
+
+            return;
+        }
+
+        eColorModel model = this->colorModel;
+
+        for ( uint32 n = 0; n < count; n++ )
+        {
+            const float *color = colors + n * 4;
+
+            abstractColorItem colorItem;
+            colorItem.model = model;
+
+            if ( model == COLORMODEL_RGBA )
+            {
+                colorItem.rgbaColor.r = clampColorChannel( color[0] );
+                colorItem.rgbaColor.g = clampColorChannel( color[1] );
+                colorItem.rgbaColor.b = clampColorChannel( color[2] );
+                colorItem.rgbaColor.a = clampColorChannel( color[3] );
+            }
+            else
+            {
+                colorItem.luminance.lum = clampColorChannel( color[0] );
+                colorItem.luminance.alpha = clampColorChannel( color[1] );
+            }
+
+            dstDispatch.setColor( dstRow, n, colorItem );
+        }
+    }
+
+    colorModelDispatcher srcDispatch;
+    colorModelDispatcher dstDispatch;
+
+    eColorModel colorModel;
+    bool isRawBytes;
+};
+
+// Resizes a raw raster using separable kernels, see txdread.size.separable.cpp.
+// The destination has the same format as the source but without a palette.
+// If a kernel is NULL then that dimension must not change.
+void PerformSeparableResizeFiltering(
+    EngineInterface *engineInterface,
+    const void *srcTexels, uint32 srcWidth, uint32 srcHeight, uint32 srcDepth,
+    ePaletteType paletteType, const void *paletteData, uint32 paletteSize,
+    void *dstTexels, uint32 dstWidth, uint32 dstHeight, uint32 dstDepth,
+    eRasterFormat rasterFormat, eColorOrdering colorOrder, uint32 rowAlignment,
+    const resizeSeparableKernel *horiKernel, const resizeSeparableKernel *vertKernel
+);
+
+AINLINE const resizeSeparableKernel* GetSamplingKernel(
+    eSamplingType samplingType,
+    rasterResizeFilterInterface *upscaleFilter, rasterResizeFilterInterface *downsamplingFilter
+)
+{
+    if ( samplingType == eSamplingType::UPSCALING )
+    {
+        return upscaleFilter->GetSeparableKernel();
+    }
+    else if ( samplingType == eSamplingType::DOWNSAMPLING )
+    {
+        return downsamplingFilter->GetSeparableKernel();
+    }
+
+    return NULL;
+}
+
 AINLINE void performFiltering1D(
     EngineInterface *engineInterface,
     mipmapLayerResizeColorPipeline& dstColorPipe,   // cached thing.
@@ -541,7 +738,20 @@ AINLINE void performFiltering1D(
                     currentTexels, currentWidth, currentHeight
                 );
 
-                if ( mipHoriSampling == eSamplingType::UPSCALING )
+                const resizeSeparableKernel *horiKernel = GetSamplingKernel( mipHoriSampling, upscaleFilter, downsamplingFilter );
+
+                if ( horiKernel )
+                {
+                    PerformSeparableResizeFiltering(
+                        engineInterface,
+                        currentTexels, currentWidth, currentHeight, currentDepth,
+                        currentPaletteType, currentPaletteData, currentPaletteSize,
+                        redirTargetTexels, redirTargetWidth, redirTargetHeight, sampleDepth,
+                        rasterFormat, colorOrder, rowAlignment,
+                        horiKernel, NULL
+                    );
+                }
+                else if ( mipHoriSampling == eSamplingType::UPSCALING )
                 {
                     magnifyFiltering2D filterProc(
                         srcDynamicPipe, dstColorPipe,
@@ -645,7 +855,20 @@ AINLINE void performFiltering1D(
                     currentTexels, currentWidth, currentHeight
                 );
 
-                if ( mipVertSampling == eSamplingType::UPSCALING )
+                const resizeSeparableKernel *vertKernel = GetSamplingKernel( mipVertSampling, upscaleFilter, downsamplingFilter );
+
+                if ( vertKernel )
+                {
+                    PerformSeparableResizeFiltering(
+                        engineInterface,
+                        currentTexels, currentWidth, currentHeight, currentDepth,
+                        currentPaletteType, currentPaletteData, currentPaletteSize,
+                        redirTargetTexels, redirTargetWidth, redirTargetHeight, sampleDepth,
+                        rasterFormat, colorOrder, rowAlignment,
+                        NULL, vertKernel
+                    );
+                }
+                else if ( mipVertSampling == eSamplingType::UPSCALING )
                 {
                     magnifyFiltering2D filterProc(
                         srcDynamicPipe, dstColorPipe,
@@ -798,7 +1021,28 @@ AINLINE void PerformRawBitmapResizeFiltering(
 
         bool hasDoneOptimizedFiltering = false;
 
-        if ( horiSampling == eSamplingType::DOWNSAMPLING && vertSampling == eSamplingType::DOWNSAMPLING )
+        // If every dimension that changes has a separable kernel, we can do it all in one go.
+        const resizeSeparableKernel *horiKernel = GetSamplingKernel( horiSampling, upscaleFilter, downsamplingFilter );
+        const resizeSeparableKernel *vertKernel = GetSamplingKernel( vertSampling, upscaleFilter, downsamplingFilter );
+
+        bool canFilterSeparable =
+            ( horiSampling == eSamplingType::SAME || horiKernel != NULL ) &&
+            ( vertSampling == eSamplingType::SAME || vertKernel != NULL );
+
+        if ( canFilterSeparable )
+        {
+            PerformSeparableResizeFiltering(
+                engineInterface,
+                rawOrigTexels, rawOrigLayerWidth, rawOrigLayerHeight, itemDepth,
+                paletteType, paletteData, paletteSize,
+                transMipData, targetLayerWidth, targetLayerHeight, sampleDepth,
+                rasterFormat, colorOrder, rowAlignment,
+                horiKernel, vertKernel
+            );
+
+            hasDoneOptimizedFiltering = true;
+        }
+        else if ( horiSampling == eSamplingType::DOWNSAMPLING && vertSampling == eSamplingType::DOWNSAMPLING )
         {
             // Check for support first.
             if ( downsamplingCaps.minify2D )
@@ -0,0 +1,503 @@
+#include "StdInc.h"
+
+#include "txdread.size.hxx"
+
+#include "rwthreading.pool.hxx"
+
+#include <vector>
+
+// Resize filters that are described by a one-dimensional kernel.
+// Because such kernels are separable, we first filter every needed source row horizontally
+// and then combine those rows vertically. Both passes work on rows of floating point colors,
+// so any ratio of minification and magnification is supported in both dimensions.
+
+namespace rw
+{
+
+// Contributions of the source pixels to every target pixel of one dimension.
+struct resampleAxis
+{
+    uint32 windowSize;              // amount of weights for every target pixel
+    std::vector <uint32> firstIndex;
+    std::vector <float> weights;    // windowSize weights for every target pixel, starting at firstIndex
+
+    void Setup( uint32 srcCount, uint32 dstCount, const resizeSeparableKernel *kernel )
+    {
+        if ( kernel == NULL )
+        {
+            // The dimension does not change, so every target pixel is its source pixel.
+            assert( srcCount == dstCount );
+
+            this->windowSize = 1;
+            this->firstIndex.resize( dstCount );
+            this->weights.resize( dstCount );
+
+            for ( uint32 n = 0; n < dstCount; n++ )
+            {
+                this->firstIndex[ n ] = n;
+                this->weights[ n ] = 1.0f;
+            }
+
+            return;
+        }
+
+        double ratio = (double)srcCount / (double)dstCount;
+
+        // When we minify, the kernel has to be stretched across the source pixels that make up a target pixel.
+        double filterScale = std::max( 1.0, ratio );
+        double support = kernel->GetSupport() * filterScale;
+
+        uint32 windowSize = std::min( (uint32)floor( support * 2 ) + 1, srcCount );
+
+        this->windowSize = windowSize;
+        this->firstIndex.resize( dstCount );
+        this->weights.assign( (size_t)dstCount * windowSize, 0.0f );
+
+        std::vector <double> srcWeights( windowSize );
+
+        for ( uint32 n = 0; n < dstCount; n++ )
+        {
+            // Pixel centers are at half coordinates.
+            double center = ( n + 0.5 ) * ratio;
+
+            int32 left = (int32)ceil( center - support - 0.5 );
+            int32 right = (int32)floor( center + support - 0.5 );
+
+            // Pixels outside of the surface take the color of the edge.
+            int32 first = std::max( left, 0 );
+
+            if ( first > (int32)( srcCount - windowSize ) )
+            {
+                first = (int32)( srcCount - windowSize );
+            }
+
+            std::fill( srcWeights.begin(), srcWeights.end(), 0.0 );
+
+            double weightSum = 0;
+
+            for ( int32 srcIndex = left; srcIndex <= right; srcIndex++ )
+            {
+                double weight = kernel->Evaluate( ( srcIndex + 0.5 - center ) / filterScale );
+
+                int32 clampedIndex = std::min( std::max( srcIndex, 0 ), (int32)srcCount - 1 );
+
+                srcWeights[ clampedIndex - first ] += weight;
+
+                weightSum += weight;
+            }
+
+            float *targetWeights = &this->weights[ (size_t)n * windowSize ];
+
+            if ( weightSum == 0 )
+            {
+                // Should not happen with sane kernels, but we want a color anyway.
+                int32 nearest = std::min( std::max( (int32)floor( center ), 0 ), (int32)srcCount - 1 );
+
+                targetWeights[ nearest - first ] = 1.0f;
+            }
+            else
+            {
+                for ( uint32 k = 0; k < windowSize; k++ )
+                {
+                    targetWeights[ k ] = (float)( srcWeights[ k ] / weightSum );
+                }
+            }
+
+            this->firstIndex[ n ] = (uint32)first;
+        }
+    }
+};
+
+AINLINE void resampleFilterRow(
+    const float *srcRow, float *dstRow, uint32 dstCount, const resampleAxis& axis
+)
+{
+    uint32 windowSize = axis.windowSize;
+
+    const uint32 *firstIndex = axis.firstIndex.data();
+    const float *weights = axis.weights.data();
+
+#ifdef RWLIB_ENABLE_X86_SIMD
+    for ( uint32 n = 0; n < dstCount; n++ )
+    {
+        const float *srcPixel = srcRow + (size_t)firstIndex[ n ] * 4;
+        const float *pixelWeights = weights + (size_t)n * windowSize;
+
+        __m128 acc = _mm_setzero_ps();
+
+        for ( uint32 k = 0; k < windowSize; k++ )
+        {
+            acc = _mm_add_ps( acc, _mm_mul_ps( _mm_set1_ps( pixelWeights[ k ] ), _mm_loadu_ps( srcPixel + k * 4 ) ) );
+        }
+
+        _mm_storeu_ps( dstRow + (size_t)n * 4, acc );
+    }
+#else
+    for ( uint32 n = 0; n < dstCount; n++ )
+    {
+        const float *srcPixel = srcRow + (size_t)firstIndex[ n ] * 4;
+        const float *pixelWeights = weights + (size_t)n * windowSize;
+
+        float r = 0, g = 0, b = 0, a = 0;
+
+        for ( uint32 k = 0; k < windowSize; k++ )
+        {
+            float weight = pixelWeights[ k ];
+
+            r += weight * srcPixel[ k * 4 + 0 ];
+            g += weight * srcPixel[ k * 4 + 1 ];
+            b += weight * srcPixel[ k * 4 + 2 ];
+            a += weight * srcPixel[ k * 4 + 3 ];
+        }
+
+        float *dstPixel = dstRow + (size_t)n * 4;
+
+        dstPixel[0] = r;
+        dstPixel[1] = g;
+        dstPixel[2] = b;
+        dstPixel[3] = a;
+    }
+#endif //RWLIB_ENABLE_X86_SIMD
+}
+
+// dstRow += srcRow * weight, for floatCount floats.
+AINLINE void resampleAccumulateRow( float *dstRow, const float *srcRow, float weight, uint32 floatCount )
+{
+    uint32 n = 0;
+
+#ifdef RWLIB_ENABLE_X86_SIMD
+    __m128 weightVec = _mm_set1_ps( weight );
+
+    for ( ; n + 8 <= floatCount; n += 8 )
+    {
+        __m128 acc0 = _mm_add_ps( _mm_loadu_ps( dstRow + n ), _mm_mul_ps( weightVec, _mm_loadu_ps( srcRow + n ) ) );
+        __m128 acc1 = _mm_add_ps( _mm_loadu_ps( dstRow + n + 4 ), _mm_mul_ps( weightVec, _mm_loadu_ps( srcRow + n + 4 ) ) );
+
+        _mm_storeu_ps( dstRow + n, acc0 );
+        _mm_storeu_ps( dstRow + n + 4, acc1 );
+    }
+#endif //RWLIB_ENABLE_X86_SIMD
+
+    for ( ; n < floatCount; n++ )
+    {
+        dstRow[ n ] += srcRow[ n ] * weight;
+    }
+}
+
+// Surfaces below this amount of target pixels are not worth splitting across threads.
+static const uint32 RESAMPLE_PARALLEL_MIN_PIXELS = ( 128 * 128 );
+
+// Maximum size of the horizontally filtered rows that a band keeps around.
+static const size_t RESAMPLE_BAND_BUFFER_SIZE = ( 16 * 1024 * 1024 );
+
+void PerformSeparableResizeFiltering(
+    EngineInterface *engineInterface,
+    const void *srcTexels, uint32 srcWidth, uint32 srcHeight, uint32 srcDepth,
+    ePaletteType paletteType, const void *paletteData, uint32 paletteSize,
+    void *dstTexels, uint32 dstWidth, uint32 dstHeight, uint32 dstDepth,
+    eRasterFormat rasterFormat, eColorOrdering colorOrder, uint32 rowAlignment,
+    const resizeSeparableKernel *horiKernel, const resizeSeparableKernel *vertKernel
+)
+{
+    if ( srcWidth == 0 || srcHeight == 0 || dstWidth == 0 || dstHeight == 0 )
+    {
+        throw RwException( "invalid dimensions for separable resize filtering" );
+    }
+
+    resampleRowCodec codec( rasterFormat, colorOrder, srcDepth, paletteType, paletteData, paletteSize, dstDepth );
+
+    if ( codec.colorModel != COLORMODEL_RGBA && codec.colorModel != COLORMODEL_LUMINANCE )
+    {
+        throw RwException( "unsupported color model for separable resize filtering" );
+    }
+
+    resampleAxis horiAxis;
+    resampleAxis vertAxis;
+
+    horiAxis.Setup( srcWidth, dstWidth, horiKernel );
+    vertAxis.Setup( srcHeight, dstHeight, vertKernel );
+
+    uint32 srcRowSize = getRasterDataRowSize( srcWidth, srcDepth, rowAlignment );
+    uint32 dstRowSize = getRasterDataRowSize( dstWidth, dstDepth, rowAlignment );
+
+    // The target rows are split into bands that are processed independently.
+    // Each band filters the source rows it needs horizontally and then combines them vertically.
+    uint32 concurrency = 1;
+
+    if ( (uint64)dstWidth * dstHeight >= RESAMPLE_PARALLEL_MIN_PIXELS )
+    {
+        concurrency = GetParallelConcurrency( engineInterface );
+    }
+
+    uint32 bandHeight = std::min( dstHeight, 64u );
+
+    if ( concurrency > 1 )
+    {
+        // A few bands per thread so that uneven work is balanced out.
+        bandHeight = std::min( bandHeight, std::max( 1u, dstHeight / ( concurrency * 4 ) ) );
+    }
+
+    size_t filteredRowSize = (size_t)dstWidth * sizeof( float ) * 4;
+
+    while ( bandHeight > 1 )
+    {
+        uint32 bandSrcRows = (uint32)ceil( (double)bandHeight * srcHeight / dstHeight ) + vertAxis.windowSize;
+
+        if ( (size_t)bandSrcRows * filteredRowSize <= RESAMPLE_BAND_BUFFER_SIZE )
+            break;
+
+        bandHeight /= 2;
+    }
+
+    uint32 bandCount = ( ( dstHeight + bandHeight - 1 ) / bandHeight );
+
+    auto filterBand = [&]( uint32 bandIndex )
+    {
+        uint32 dstRowStart = ( bandIndex * bandHeight );
+        uint32 dstRowEnd = std::min( dstRowStart + bandHeight, dstHeight );
+
+        // The source rows that this band needs. The first indices grow with the target row.
+        uint32 srcRowStart = vertAxis.firstIndex[ dstRowStart ];
+        uint32 srcRowEnd = ( vertAxis.firstIndex[ dstRowEnd - 1 ] + vertAxis.windowSize );
+
+        uint32 filteredRowCount = ( srcRowEnd - srcRowStart );
+        uint32 filteredRowFloats = ( dstWidth * 4 );
+
+        std::vector <float> decodedRow( (size_t)srcWidth * 4 );
+        std::vector <float> filteredRows( (size_t)filteredRowCount * filteredRowFloats );
+        std::vector <float> targetRow( filteredRowFloats );
+
+        for ( uint32 srcRow = srcRowStart; srcRow < srcRowEnd; srcRow++ )
+        {
+            const void *srcRowData = getConstTexelDataRow( srcTexels, srcRowSize, srcRow );
+
+            codec.DecodeRow( srcRowData, decodedRow.data(), srcWidth );
+
+            resampleFilterRow(
+                decodedRow.data(),
+                filteredRows.data() + (size_t)( srcRow - srcRowStart ) * filteredRowFloats,
+                dstWidth, horiAxis
+            );
+        }
+
+        uint32 windowSize = vertAxis.windowSize;
+
+        for ( uint32 dstRow = dstRowStart; dstRow < dstRowEnd; dstRow++ )
+        {
+            uint32 firstIndex = vertAxis.firstIndex[ dstRow ];
+            const float *rowWeights = vertAxis.weights.data() + (size_t)dstRow * windowSize;
+
+            std::fill( targetRow.begin(), targetRow.end(), 0.0f );
+
+            for ( uint32 k = 0; k < windowSize; k++ )
+            {
+                float weight = rowWeights[ k ];
+
+                if ( weight == 0 )
+                    continue;
+
+                const float *filteredRow = filteredRows.data() + (size_t)( firstIndex + k - srcRowStart ) * filteredRowFloats;
+
+                resampleAccumulateRow( targetRow.data(), filteredRow, weight, filteredRowFloats );
+            }
+
+            void *dstRowData = getTexelDataRow( dstTexels, dstRowSize, dstRow );
+
+            codec.EncodeRow( targetRow.data(), dstRowData, dstWidth );
+        }
+    };
+
+    ParallelFor( engineInterface, bandCount, concurrency, filterBand );
+}
+
+// The kernels that we offer.
+struct boxResizeKernel
+{
+    static const char* GetName( void )     { return "box"; }
+    static double GetSupport( void )        { return 0.5; }
+
+    static double Evaluate( double x )
+    {
+        return ( x >= -0.5 && x < 0.5 ) ? 1.0 : 0.0;
+    }
+};
+
+struct bilinearResizeKernel
+{
+    static const char* GetName( void )     { return "bilinear"; }
+    static double GetSupport( void )        { return 1.0; }
+
+    static double Evaluate( double x )
+    {
+        x = fabs( x );
+
+        return ( x < 1.0 ) ? ( 1.0 - x ) : 0.0;
+    }
+};
+
+// Catmull-Rom spline.
+struct bicubicResizeKernel
+{
+    static const char* GetName( void )     { return "bicubic"; }
+    static double GetSupport( void )        { return 2.0; }
+
+    static double Evaluate( double x )
+    {
+        const double a = -0.5;
+
+        x = fabs( x );
+
+        if ( x < 1.0 )
+        {
+            return ( ( a + 2.0 ) * x - ( a + 3.0 ) ) * x * x + 1.0;
+        }
+        else if ( x < 2.0 )
+        {
+            return ( ( ( x - 5.0 ) * x + 8.0 ) * x - 4.0 ) * a;
+        }
+
+        return 0.0;
+    }
+};
+
+AINLINE double resizeSinc( double x )
+{
+    if ( fabs( x ) < 1e-6 )
+    {
+        return 1.0;
+    }
+
+    x *= 3.14159265358979323846;
+
+    return ( sin( x ) / x );
+}
+
+struct lanczos3ResizeKernel
+{
+    static const char* GetName( void )     { return "lanczos3"; }
+    static double GetSupport( void )        { return 3.0; }
+
+    static double Evaluate( double x )
+    {
+        if ( fabs( x ) >= 3.0 )
+        {
+            return 0.0;
+        }
+
+        return resizeSinc( x ) * resizeSinc( x / 3.0 );
+    }
+};
+
+// Sinc that is windowed by a Kaiser window.
+struct kaiserResizeKernel
+{
+    static const char* GetName( void )     { return "kaiser"; }
+    static double GetSupport( void )        { return 3.0; }
+
+    // Modified Bessel function of the first kind, order zero.
+    static double BesselI0( double x )
+    {
+        double sum = 1.0;
+        double term = 1.0;
+
+        double quarterSq = ( x * x / 4.0 );
+
+        for ( uint32 k = 1; k < 64; k++ )
+        {
+            term *= quarterSq / ( (double)k * k );
+
+            sum += term;
+
+            if ( term < sum * 1e-12 )
+                break;
+        }
+
+        return sum;
+    }
+
+    static double Evaluate( double x )
+    {
+        const double width = 3.0;
+        const double alpha = 4.0;
+
+        double t = ( x / width );
+
+        if ( fabs( t ) >= 1.0 )
+        {
+            return 0.0;
+        }
+
+        return resizeSinc( x ) * BesselI0( alpha * sqrt( 1.0 - t * t ) ) / BesselI0( alpha );
+    }
+};
+
+template <typename kernelType>
+struct resizeFilterSeparablePlugin : public rasterResizeFilterInterface, public resizeSeparableKernel
+{
+    void GetSupportedFiltering( resizeFilteringCaps& capsOut ) const override
+    {
+        capsOut.supportsMagnification = true;
+        capsOut.supportsMinification = true;
+        capsOut.magnify2D = true;
+        capsOut.minify2D = true;
+    }
+
+    const resizeSeparableKernel* GetSeparableKernel( void ) const override
+    {
+        return this;
+    }
+
+    double GetSupport( void ) const override
+    {
+        return kernelType::GetSupport();
+    }
+
+    double Evaluate( double x ) const override
+    {
+        return kernelType::Evaluate( x );
+    }
+
+    // The resize routines use the separable kernel instead.
+    void MagnifyFiltering(
+        const resizeColorPipeline& srcBmp, uint32 magX, uint32 magY, uint32 magScaleX, uint32 magScaleY,
+        resizeColorPipeline& dstBmp, uint32 dstX, uint32 dstY
+    ) const override
+    {
+        throw RwException( "separable filters do not support per-pixel magnification" );
+    }
+
+    void MinifyFiltering(
+        const resizeColorPipeline& srcBmp, uint32 minX, uint32 minY, uint32 minScaleX, uint32 minScaleY,
+        abstractColorItem& reducedColor
+    ) const override
+    {
+        throw RwException( "separable filters do not support per-pixel minification" );
+    }
+
+    inline void Initialize( EngineInterface *engineInterface )
+    {
+        RegisterResizeFiltering( engineInterface, kernelType::GetName(), this );
+    }
+
+    inline void Shutdown( EngineInterface *engineInterface )
+    {
+        UnregisterResizeFiltering( engineInterface, this );
+    }
+};
+
+static PluginDependantStructRegister <resizeFilterSeparablePlugin <boxResizeKernel>, RwInterfaceFactory_t> resizeFilterBoxPluginRegister;
+static PluginDependantStructRegister <resizeFilterSeparablePlugin <bilinearResizeKernel>, RwInterfaceFactory_t> resizeFilterBilinearPluginRegister;
+static PluginDependantStructRegister <resizeFilterSeparablePlugin <bicubicResizeKernel>, RwInterfaceFactory_t> resizeFilterBicubicPluginRegister;
+static PluginDependantStructRegister <resizeFilterSeparablePlugin <lanczos3ResizeKernel>, RwInterfaceFactory_t> resizeFilterLanczos3PluginRegister;
+static PluginDependantStructRegister <resizeFilterSeparablePlugin <kaiserResizeKernel>, RwInterfaceFactory_t> resizeFilterKaiserPluginRegister;
+
+void registerRasterResizeSeparablePlugins( void )
+{
+    resizeFilterBoxPluginRegister.RegisterPlugin( engineFactory );
+    resizeFilterBilinearPluginRegister.RegisterPlugin( engineFactory );
+    resizeFilterBicubicPluginRegister.RegisterPlugin( engineFactory );
+    resizeFilterLanczos3PluginRegister.RegisterPlugin( engineFactory );
+    resizeFilterKaiserPluginRegister.RegisterPlugin( engineFactory );
+}
+
+};
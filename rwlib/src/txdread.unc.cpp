@@ -255,6 +255,27 @@ void registerMobileUNCNativePlugin( void )
     uncNativeTexturePlugin.RegisterPlugin( engineFactory );
 }
 
+bool uncNativeTextureTypeProvider::DeserializeTextureProperties( TextureBase *theTexture, BlockProvider& inputProvider ) const
+{
+    return readTextureNativeStructHeader <mobile_unc::textureNativeGenericHeader> ( inputProvider,
+        [&]( const mobile_unc::textureNativeGenericHeader& metaHeader )
+        {
+            if ( metaHeader.platformDescriptor != PLATFORMDESC_UNC_MOBILE )
+            {
+                return false;
+            }
+
+            readTextureNativeNames( *theTexture, metaHeader.name, metaHeader.maskName );
+
+            metaHeader.formatInfo.parse( *theTexture );
+
+            theTexture->SetFilterMode( getFixedFilteringMode( theTexture->GetFilterMode(), metaHeader.mipmapCount ) );
+
+            return true;
+        }
+    );
+}
+
 };
 
 #endif //RWLIB_INCLUDE_NATIVETEX_UNC_MOBILE
\ No newline at end of file
@@ -123,6 +123,8 @@ struct uncNativeTextureTypeProvider : public texNativeTypeProvider
     void SerializeTexture( TextureBase *theTexture, PlatformTexture *nativeTex, BlockProvider& outputProvider ) const;
     void DeserializeTexture( TextureBase *theTexture, PlatformTexture *nativeTex, BlockProvider& inputProvider ) const;
 
+    bool DeserializeTextureProperties( TextureBase *theTexture, BlockProvider& inputProvider ) const;
+
     void GetPixelCapabilities( pixelCapabilities& capsOut ) const
     {
         capsOut.supportsDXT1 = false;
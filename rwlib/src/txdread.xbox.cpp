@@ -781,6 +781,49 @@ void xboxNativeTextureTypeProvider::GetTextureFormatString( Interface *engineInt
     lengthOut = formatString.length();
 }
 
+bool xboxNativeTextureTypeProvider::DeserializeTextureProperties( TextureBase *theTexture, BlockProvider& inputProvider ) const
+{
+    bool hasProperties = false;
+
+    BlockProvider texImageDataBlock( &inputProvider );
+
+    texImageDataBlock.EnterContext();
+
+    try
+    {
+        if ( texImageDataBlock.getBlockID() == CHUNK_STRUCT )
+        {
+            uint32 platform = texImageDataBlock.readUInt32();
+
+            if ( platform == NATIVE_TEXTURE_XBOX )
+            {
+                xbox::textureMetaHeaderStruct metaInfo;
+                texImageDataBlock.read( &metaInfo, sizeof(metaInfo) );
+
+                readTextureNativeNames( *theTexture, metaInfo.name, metaInfo.maskName );
+
+                texFormatInfo formatInfo = metaInfo.formatInfo;
+
+                formatInfo.parse( *theTexture );
+
+                theTexture->SetFilterMode( getFixedFilteringMode( theTexture->GetFilterMode(), metaInfo.mipmapCount ) );
+
+                hasProperties = true;
+            }
+        }
+    }
+    catch( ... )
+    {
+        texImageDataBlock.LeaveContext();
+
+        throw;
+    }
+
+    texImageDataBlock.LeaveContext();
+
+    return hasProperties;
+}
+
 };
 
 #endif //RWLIB_INCLUDE_NATIVETEX_XBOX
\ No newline at end of file
@@ -196,6 +196,13 @@ struct NativeTextureXBOX
     static void unswizzleMipmap( Interface *engineInterface, swizzleMipmapTraversal& pixelData );
 };
 
+// Swizzles or unswizzles a single mipmap layer into outData, which has the same size.
+void performXBOXSwizzle(
+    const void *srcData, void *outData,
+    uint32 mipWidth, uint32 mipHeight, uint32 depth, uint32 rowAlignment,
+    bool isUnswizzle
+);
+
 inline bool getDXTCompressionTypeFromXBOX( uint32 xboxCompressionType, eCompressionType& typeOut )
 {
     eCompressionType rwCompressionType = RWCOMPRESS_NONE;
@@ -263,6 +270,8 @@ struct xboxNativeTextureTypeProvider : public texNativeTypeProvider
     void SerializeTexture( TextureBase *theTexture, PlatformTexture *nativeTex, BlockProvider& outputProvider ) const;
     void DeserializeTexture( TextureBase *theTexture, PlatformTexture *nativeTex, BlockProvider& inputProvider ) const;
 
+    bool DeserializeTextureProperties( TextureBase *theTexture, BlockProvider& inputProvider ) const;
+
     void GetPixelCapabilities( pixelCapabilities& capsOut ) const
     {
         capsOut.supportsDXT1 = true;
@@ -4,6 +4,8 @@
 
 #include "txdread.xbox.hxx"
 
+#include <vector>
+
 #ifdef _USE_XBOX_SDK_
 // Define this macro if you want this tool to use the official XBOX development kit.
 #include <XGraphics.h>
@@ -13,241 +15,253 @@ namespace rw
 {
 
 #ifndef _USE_XBOX_SDK_
-enum eBlockOrder
+// The XBOX stores textures in Morton order: the bits of the x and y coordinates are interleaved,
+// starting with x. Once the smaller dimension runs out of bits, the remaining bits belong to the
+// bigger one. Since the bits of both coordinates never overlap, the permutation can be put together
+// from one table per dimension.
+struct xboxSwizzleTables
 {
-    BLOCK_XYZW,
-    BLOCK_XZYW
-};
+    // For every destination texel (col, row) the source texel is at
+    // ( srcColByCol[col] | srcColByRow[row], srcRowByCol[col] | srcRowByRow[row] ).
+    std::vector <uint32> srcColByCol, srcRowByCol;
+    std::vector <uint32> srcColByRow, srcRowByRow;
 
-struct XBOXSwizzle
-{
-    // TODO: find an efficient way to get swizzle coordinates just like that.
-    static void getSwizzleCoord(uint32 x, uint32 y, uint32 width, uint32 height, uint32& swizzleX, uint32& swizzleY)
+    static inline void getSwizzleMasks( uint32 width, uint32 height, uint32& maskXOut, uint32& maskYOut )
     {
-        uint32 swizOutX = 0;
-        uint32 swizOutY = 0;
+        uint32 maskX = 0;
+        uint32 maskY = 0;
+
+        uint32 bit = 1;
 
-        if ( width == 2 && height == 2 )
+        for ( uint32 n = 1; n < width || n < height; n <<= 1 )
         {
-            
+            if ( n < width )
+            {
+                maskX |= bit;
+                bit <<= 1;
+            }
+
+            if ( n < height )
+            {
+                maskY |= bit;
+                bit <<= 1;
+            }
         }
-        
 
-        swizzleX = swizOutX;
-        swizzleY = swizOutY;
+        maskXOut = maskX;
+        maskYOut = maskY;
     }
-};
-
-// http://gtaforums.com/topic/213907-unswizzle-tool/
-// TODO: fix this shit.
-template <typename arrayType>
-static inline void unswizzleXboxBlock
-(
-    const arrayType *srcData, arrayType *outData,
-    uint32& srcDataOffset, uint32 outDataOffset,
-    uint32 imWidth, uint32 imHeight, uint32 imStride,
-    bool isUnswizzle,
-    uint32 depthIter = 0
-)
-{
-    // srcData must be a different array than outData.
 
-    bool hasSubBlocks = true;
-
-	if (imWidth == 2 && imHeight == 2 ||
-        imWidth == 1 && imHeight == 2 ||
-        imWidth == 2 && imHeight == 1 ||
-        imWidth == 1 || imHeight == 1)
+    // Spreads the bits of value across the set bits of mask.
+    static inline uint32 depositBits( uint32 value, uint32 mask )
     {
-        uint32 curDecodePos = srcDataOffset;
+        uint32 result = 0;
 
-        for (uint32 y = 0; y < imHeight; y++)
+        for ( uint32 bit = 1; mask != 0; bit <<= 1 )
         {
-            uint32 seekOutOffsetHeight = ( y * imStride );
+            uint32 lowestMaskBit = ( mask & ( ~mask + 1 ) );
 
-            for (uint32 x = 0; x < imWidth; x++)
+            if ( value & bit )
             {
-                uint32 seekOutOffset = seekOutOffsetHeight + x;
+                result |= lowestMaskBit;
+            }
 
-                arrayType::trav_t srcVal;
+            mask &= ~lowestMaskBit;
+        }
 
-                // Decide which index to use where.
-                uint32 srcIndex, dstIndex;
-                
-                if ( isUnswizzle )
-                {
-                    srcIndex = curDecodePos++;
-                    dstIndex = outDataOffset + seekOutOffset;
-                }
-                else
-                {
-                    srcIndex = outDataOffset + seekOutOffset;
-                    dstIndex = curDecodePos++;
-                }
+        return result;
+    }
+
+    // Gathers the bits of value at the set bits of mask.
+    static inline uint32 extractBits( uint32 value, uint32 mask )
+    {
+        uint32 result = 0;
 
-                srcData->getvalue(srcIndex, srcVal);
+        for ( uint32 bit = 1; mask != 0; bit <<= 1 )
+        {
+            uint32 lowestMaskBit = ( mask & ( ~mask + 1 ) );
 
-                outData->setvalue(dstIndex, srcVal);
+            if ( value & lowestMaskBit )
+            {
+                result |= bit;
             }
-        }
 
-        // Go to the next block.
-		srcDataOffset += ( imWidth * imHeight );
+            mask &= ~lowestMaskBit;
+        }
 
-        hasSubBlocks = false;
-	}
+        return result;
+    }
 
-    if ( hasSubBlocks )
+    inline void Setup( uint32 width, uint32 height, bool isUnswizzle )
     {
-        // Catch an exception.
-        if (imWidth == 1 || imHeight == 1)
+        // Swizzling is only defined for power-of-two dimensions, which the XBOX size rules enforce.
+        if ( width == 0 || height == 0 || ( width & ( width - 1 ) ) != 0 || ( height & ( height - 1 ) ) != 0 )
         {
-            assert( 0 );
+            throw RwException( "XBOX swizzling requires power-of-two mipmap dimensions" );
         }
 
-        // We split the picture into four parts, recursively.
-        uint32 subImWidth = ( imWidth / 2 );
-        uint32 subImHeight = ( imHeight / 2 );
+        uint32 maskX, maskY;
+        getSwizzleMasks( width, height, maskX, maskY );
 
-        // Get the block ordering.
-        eBlockOrder blockOrder;
-        bool hasOrder = false;
+        uint32 widthShift = 0;
 
-        if ( imWidth == imHeight ||
-             imWidth == imHeight * 4 ||
-             imWidth * 4 == imHeight)
+        while ( ( 1u << widthShift ) < width )
         {
-            blockOrder = BLOCK_XYZW;
-        }
-        else
-        {
-            blockOrder = BLOCK_XZYW;
+            widthShift++;
         }
 
-        uint32 nextDepthIter = depthIter + 1;
+        uint32 widthMask = ( width - 1 );
 
-        // Calculate the block coordinates to use.
-        bool hasValidConfiguration = true;
+        srcColByCol.resize( width );
+        srcRowByCol.resize( width );
+        srcColByRow.resize( height );
+        srcRowByRow.resize( height );
 
-        // Top left.
-        uint32 topLeftOutOffset = outDataOffset;
+        if ( isUnswizzle )
+        {
+            // The destination is linear and the source is swizzled.
+            // The swizzled index is split into the column and row of the source buffer.
+            for ( uint32 x = 0; x < width; x++ )
+            {
+                uint32 swizzleIndex = depositBits( x, maskX );
 
-        // Top right.
-        uint32 topRightOutOffset = 0;
+                srcColByCol[ x ] = ( swizzleIndex & widthMask );
+                srcRowByCol[ x ] = ( swizzleIndex >> widthShift );
+            }
 
-        if (blockOrder == BLOCK_XYZW)
-        {
-            topRightOutOffset = outDataOffset + subImWidth;
-        }
-        else if (blockOrder == BLOCK_XZYW)
-        {
-            topRightOutOffset = outDataOffset + subImHeight*imStride;
+            for ( uint32 y = 0; y < height; y++ )
+            {
+                uint32 swizzleIndex = depositBits( y, maskY );
+
+                srcColByRow[ y ] = ( swizzleIndex & widthMask );
+                srcRowByRow[ y ] = ( swizzleIndex >> widthShift );
+            }
         }
         else
         {
-            hasValidConfiguration = false;
-        }
+            // The destination is swizzled and the source is linear.
+            for ( uint32 col = 0; col < width; col++ )
+            {
+                srcColByCol[ col ] = extractBits( col, maskX );
+                srcRowByCol[ col ] = extractBits( col, maskY );
+            }
 
-        // Bottom left.
-        uint32 bottomLeftOutOffset = 0;
+            for ( uint32 row = 0; row < height; row++ )
+            {
+                uint32 swizzleIndex = ( row << widthShift );
 
-        if (blockOrder == BLOCK_XYZW)
-        {
-            bottomLeftOutOffset = outDataOffset + subImHeight*imStride;
-        }
-        else if (blockOrder == BLOCK_XZYW)
-        {
-            bottomLeftOutOffset = outDataOffset + subImWidth;
+                srcColByRow[ row ] = extractBits( swizzleIndex, maskX );
+                srcRowByRow[ row ] = extractBits( swizzleIndex, maskY );
+            }
         }
-        else
+    }
+};
+
+// Moves texels according to the tables. Each item holds texelsPerItem texels.
+// The lowest swizzle bit always belongs to x if the width is at least two, so pairs of texels
+// stay next to each other and can be moved at once.
+template <typename itemType, uint32 texelsPerItem>
+static inline void gatherSwizzleItems(
+    const xboxSwizzleTables& tables,
+    const void *srcTexels, void *dstTexels,
+    uint32 mipWidth, uint32 mipHeight, uint32 rowSize
+)
+{
+    uint32 itemCount = ( mipWidth / texelsPerItem );
+
+    const uint32 *srcColByCol = tables.srcColByCol.data();
+    const uint32 *srcRowByCol = tables.srcRowByCol.data();
+
+    for ( uint32 row = 0; row < mipHeight; row++ )
+    {
+        itemType *dstRow = (itemType*)getTexelDataRow( dstTexels, rowSize, row );
+
+        uint32 srcColBase = tables.srcColByRow[ row ];
+        uint32 srcRowBase = tables.srcRowByRow[ row ];
+
+        for ( uint32 item = 0; item < itemCount; item++ )
         {
-            hasValidConfiguration = false;
-        }
+            uint32 col = ( item * texelsPerItem );
 
-        // Bottom right.
-        uint32 bottomRightOutOffset = outDataOffset + subImHeight*imStride + subImWidth;
+            const itemType *srcRow = (const itemType*)getConstTexelDataRow( srcTexels, rowSize, srcRowBase | srcRowByCol[ col ] );
 
-        /*===============================*/
+            dstRow[ item ] = srcRow[ ( srcColBase | srcColByCol[ col ] ) / texelsPerItem ];
+        }
+    }
+}
+
+// Single column 4bit textures cannot be moved in whole bytes.
+static inline void gatherSwizzleNibbles(
+    const xboxSwizzleTables& tables,
+    const void *srcTexels, void *dstTexels,
+    uint32 mipWidth, uint32 mipHeight, uint32 rowSize
+)
+{
+    for ( uint32 row = 0; row < mipHeight; row++ )
+    {
+        PixelFormat::palette4bit *dstRow = (PixelFormat::palette4bit*)getTexelDataRow( dstTexels, rowSize, row );
 
-        if (hasValidConfiguration)
+        for ( uint32 col = 0; col < mipWidth; col++ )
         {
-            // Top left.
-	        unswizzleXboxBlock(
-                srcData, outData, srcDataOffset,
-                topLeftOutOffset,
-                subImWidth, subImHeight, imStride,
-                isUnswizzle,
-                nextDepthIter
-            );
-
-            if ( depthIter != 0 )
-            {
-                // Top right.
-	            unswizzleXboxBlock(
-                    srcData, outData, srcDataOffset,
-                    topRightOutOffset,
-                    subImWidth, subImHeight, imStride,
-                    isUnswizzle,
-                    nextDepthIter
-                );
-
-                // Bottom left.
-	            unswizzleXboxBlock(
-                    srcData, outData, srcDataOffset,
-                    bottomLeftOutOffset,
-                    subImWidth, subImHeight, imStride,
-                    isUnswizzle,
-                    nextDepthIter
-                );
-
-                // Bottom right.
-	            unswizzleXboxBlock(
-                    srcData, outData, srcDataOffset,
-                    bottomRightOutOffset,
-                    subImWidth, subImHeight, imStride,
-                    isUnswizzle,
-                    nextDepthIter
-                );
-            }
+            const PixelFormat::palette4bit *srcRow =
+                (const PixelFormat::palette4bit*)getConstTexelDataRow( srcTexels, rowSize, tables.srcRowByRow[ row ] | tables.srcRowByCol[ col ] );
+
+            PixelFormat::palette4bit::trav_t travItem;
+            srcRow->getvalue( tables.srcColByRow[ row ] | tables.srcColByCol[ col ], travItem );
+
+            dstRow->setvalue( col, travItem );
         }
-	}
+    }
 }
 #endif //_USE_XBOX_SDK_
 
-inline void performXBOXSwizzle(
+void performXBOXSwizzle(
     const void *srcData, void *outData,
     uint32 mipWidth, uint32 mipHeight, uint32 depth, uint32 rowAlignment,
     bool isUnswizzle
 )
 {
 #ifndef _USE_XBOX_SDK_
-    uint32 offOut = 0;
+    xboxSwizzleTables tables;
+    tables.Setup( mipWidth, mipHeight, isUnswizzle );
+
+    uint32 rowSize = getRasterDataRowSize( mipWidth, depth, rowAlignment );
+
+    // Move two texels at once where we can.
+    bool canMovePairs = ( mipWidth >= 2 );
 
     if (depth == 4)
     {
-        unswizzleXboxBlock(
-            (const PixelFormat::palette4bit*)srcData,
-            (PixelFormat::palette4bit*)outData,
-            offOut, 0, mipWidth, mipHeight, mipWidth
-        );
+        if ( canMovePairs )
+        {
+            gatherSwizzleItems <uint8, 2> ( tables, srcData, outData, mipWidth, mipHeight, rowSize );
+        }
+        else
+        {
+            gatherSwizzleNibbles( tables, srcData, outData, mipWidth, mipHeight, rowSize );
+        }
     }
     else if (depth == 8)
     {
-        unswizzleXboxBlock(
-            (const PixelFormat::palette8bit*)srcData,
-            (PixelFormat::palette8bit*)outData,
-            offOut, 0, mipWidth, mipHeight, mipWidth
-        );
+        if ( canMovePairs )
+        {
+            gatherSwizzleItems <uint16, 2> ( tables, srcData, outData, mipWidth, mipHeight, rowSize );
+        }
+        else
+        {
+            gatherSwizzleItems <uint8, 1> ( tables, srcData, outData, mipWidth, mipHeight, rowSize );
+        }
     }
     else if (depth == 16)
     {
-        typedef PixelFormat::typedcolor <uint16> theColor;
-
-        unswizzleXboxBlock(
-            (const theColor*)srcData,
-            (theColor*)outData,
-            offOut, 0, mipWidth, mipHeight, mipWidth
-        );
+        if ( canMovePairs )
+        {
+            gatherSwizzleItems <uint32, 2> ( tables, srcData, outData, mipWidth, mipHeight, rowSize );
+        }
+        else
+        {
+            gatherSwizzleItems <uint16, 1> ( tables, srcData, outData, mipWidth, mipHeight, rowSize );
+        }
     }
     else if (depth == 24)
     {
@@ -256,23 +270,18 @@ inline void performXBOXSwizzle(
             uint8 x, y, z;
         };
 
-        typedef PixelFormat::typedcolor <colorStruct> theColor;
-
-        unswizzleXboxBlock(
-            (const theColor*)srcData,
-            (theColor*)outData,
-            offOut, 0, mipWidth, mipHeight, mipWidth
-        );
+        gatherSwizzleItems <colorStruct, 1> ( tables, srcData, outData, mipWidth, mipHeight, rowSize );
     }
     else if (depth == 32)
     {
-        typedef PixelFormat::typedcolor <uint32> theColor;
-
-        unswizzleXboxBlock(
-            (const theColor*)srcData,
-            (theColor*)outData,
-            offOut, 0, mipWidth, mipHeight, mipWidth
-        );
+        if ( canMovePairs )
+        {
+            gatherSwizzleItems <uint64, 2> ( tables, srcData, outData, mipWidth, mipHeight, rowSize );
+        }
+        else
+        {
+            gatherSwizzleItems <uint32, 1> ( tables, srcData, outData, mipWidth, mipHeight, rowSize );
+        }
     }
     else
     {
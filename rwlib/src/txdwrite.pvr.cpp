@@ -142,107 +142,247 @@ void pvrNativeTextureTypeProvider::SerializeTexture( TextureBase *theTexture, Pl
     engineInterface->SerializeExtensions( theTexture, outputProvider );
 }
 
-void pvrNativeTextureTypeProvider::DecompressPVRMipmap(
+bool pvrNativeTextureTypeProvider::IsUsingPVRTexLib( Interface *engineInterface ) const
+{
+#ifdef RWLIB_INCLUDE_PVRTEXLIB
+    return ( this->isPVRTexLibLoaded && engineInterface->GetPVRRuntime() == PVRRUNTIME_PVRTEXLIB );
+#else
+    return false;
+#endif //RWLIB_INCLUDE_PVRTEXLIB
+}
+
+void pvrNativeTextureTypeProvider::DecompressPVRToRGBA(
     Interface *engineInterface,
-    uint32 mipWidth, uint32 mipHeight, uint32 layerWidth, uint32 layerHeight, const void *srcTexels,
-    eRasterFormat pvrRasterFormat, uint32 pvrDepth, eColorOrdering pvrColorOrder,
-    eRasterFormat targetRasterFormat, uint32 targetDepth, uint32 targetRowAlignment, eColorOrdering targetColorOrder,
-    PVRPixelType pvrSrcPixelType, PVRPixelType pvrDstPixelType,
-    void*& dstTexelsOut, uint32& dstDataSizeOut
+    uint32 surfWidth, uint32 surfHeight, const void *srcTexels, ePVRInternalFormat pvrFormat,
+    void *dstTexels
 )
 {
-    // Create a PVR texture.
-    PVRTextureHeader pvrHeader = PVRTextureHeaderCreate( PVRPixelTypeGetID( pvrSrcPixelType ), mipHeight, mipWidth );
-
-    if ( !pvrHeader )
+#ifdef RWLIB_INCLUDE_PVRTEXLIB
+    if ( IsUsingPVRTexLib( engineInterface ) )
     {
-        throw RwException( "failed to create PVRTexLib texture header" );
-    }
+        PVRPixelType pvrSrcPixelType = PVRGetCachedPixelType( pvrFormat );
 
-    try
-    {
-        PVRTexture pvrSourceTexture = PVRTextureCreate( pvrHeader, srcTexels );
+        if ( !pvrSrcPixelType )
+        {
+            throw RwException( "failed to decompress PVRTC due to unknown internalFormat" );
+        }
+
+        // Create a PVR texture.
+        PVRTextureHeader pvrHeader = PVRTextureHeaderCreate( PVRPixelTypeGetID( pvrSrcPixelType ), surfHeight, surfWidth );
 
-        if ( !pvrSourceTexture )
+        if ( !pvrHeader )
         {
-            throw RwException( "failed to create PVRTexLib texture" );
+            throw RwException( "failed to create PVRTexLib texture header" );
         }
-        
+
         try
         {
-            // Decompress it.
-            bool transcodeSuccess =
-                PVRTranscode( pvrSourceTexture, pvrDstPixelType, ePVRTVarTypeUnsignedByteNorm, ePVRTCSpacelRGB );
+            PVRTexture pvrSourceTexture = PVRTextureCreate( pvrHeader, srcTexels );
+
+            if ( !pvrSourceTexture )
+            {
+                throw RwException( "failed to create PVRTexLib texture" );
+            }
+        
+            try
+            {
+                // Decompress it.
+                bool transcodeSuccess =
+                    PVRTranscode( pvrSourceTexture, this->pvrPixelType_rgba8888, ePVRTVarTypeUnsignedByteNorm, ePVRTCSpacelRGB );
 
-            if ( transcodeSuccess == false )
+                if ( transcodeSuccess == false )
+                {
+                    throw RwException( "failed to decompress PVRTC compressed data using PVRTexLib" );
+                }
+
+                memcpy( dstTexels, PVRTextureGetDataPtr( pvrSourceTexture ), surfWidth * surfHeight * sizeof( uint32 ) );
+            }
+            catch( ... )
             {
-                throw RwException( "failed to decompress PVRTC compressed data using PVRTexLib" );
+                PVRTextureDelete( pvrSourceTexture );
+
+                throw;
             }
 
-            // Create a new raw texture of the layer dimensions.
-            uint32 dstRowSize = getRasterDataRowSize( layerWidth, targetDepth, targetRowAlignment );
+            PVRTextureDelete( pvrSourceTexture );
+        }
+        catch( ... )
+        {
+            PVRTextureHeaderDelete( pvrHeader );
+
+            throw;
+        }
 
-            uint32 dstDataSize = getRasterDataSizeByRowSize( dstRowSize, layerHeight );
+        PVRTextureHeaderDelete( pvrHeader );
+        return;
+    }
+#endif //RWLIB_INCLUDE_PVRTEXLIB
 
-            uint32 pvrWidth = mipWidth;
-            uint32 pvrHeight = mipHeight;
+    pvrtc::DecompressSurface(
+        (EngineInterface*)engineInterface, getDepthByPVRFormat( pvrFormat ),
+        surfWidth, surfHeight, srcTexels,
+        dstTexels, surfWidth * sizeof( uint32 )
+    );
+}
 
-            uint32 pvrRowSize = getRasterDataRowSize( pvrWidth, pvrDepth, getPVRToolTextureDataRowAlignment() );
+void pvrNativeTextureTypeProvider::CompressRGBAToPVR(
+    Interface *engineInterface,
+    uint32 surfWidth, uint32 surfHeight, const void *srcTexels, ePVRInternalFormat pvrFormat,
+    void *dstTexels
+)
+{
+    uint32 pvrDepth = getDepthByPVRFormat( pvrFormat );
+
+#ifdef RWLIB_INCLUDE_PVRTEXLIB
+    if ( IsUsingPVRTexLib( engineInterface ) )
+    {
+        PVRPixelType pvrDstPixelType = PVRGetCachedPixelType( pvrFormat );
 
-            const void *srcTexelPtr = PVRTextureGetDataPtr( pvrSourceTexture );
+        if ( !pvrDstPixelType )
+        {
+            throw RwException( "failed to compress PVRTC due to unknown internalFormat" );
+        }
 
-            // Allocate new texels.
-            void *dstTexels = engineInterface->PixelAllocate( dstDataSize );
+        PVRTextureHeader pvrHeader = PVRTextureHeaderCreate( PVRPixelTypeGetID( this->pvrPixelType_rgba8888 ), surfHeight, surfWidth );
 
-            if ( !dstTexels )
+        if ( !pvrHeader )
+        {
+            throw RwException( "failed to create PVRTexLib texture header" );
+        }
+
+        try
+        {
+            PVRTexture pvrTexture = PVRTextureCreate( pvrHeader, srcTexels );
+
+            if ( !pvrTexture )
             {
-                throw RwException( "failed to allocate destination surface for decompressed PowerVR native texture data" );
+                throw RwException( "failed to create PVRTexLib texture handle" );
             }
 
             try
             {
-                colorModelDispatcher fetchDispatch( pvrRasterFormat, pvrColorOrder, pvrDepth, NULL, 0, PALETTE_NONE );
-                colorModelDispatcher putDispatch( targetRasterFormat, targetColorOrder, targetDepth, NULL, 0, PALETTE_NONE );
-
-                copyTexelDataBounded(
-                    srcTexelPtr, dstTexels,
-                    fetchDispatch, putDispatch,
-                    pvrWidth, pvrHeight,
-                    layerWidth, layerHeight,
-                    0, 0,
-                    0, 0,
-                    pvrRowSize, dstRowSize
-                );
+                // Transcode it.
+                bool transcodeSuccess =
+                    PVRTranscode( pvrTexture, pvrDstPixelType, ePVRTVarTypeUnsignedByteNorm, ePVRTCSpacelRGB );
+
+                if ( transcodeSuccess == false )
+                {
+                    throw RwException( "failed to compress texture data to PVRTC using PVRTexLib" );
+                }
+
+                // Copy the PowerVR pixels into the destination array.
+                uint32 dstDataSize = getPackedRasterDataSize( surfWidth * surfHeight, pvrDepth );
+
+                PVRTextureHeaderCheckDataSize( pvrTexture, dstDataSize );
+
+                memcpy( dstTexels, PVRTextureGetDataPtr( pvrTexture ), dstDataSize );
             }
             catch( ... )
             {
-                // If anything went wrong in the pixel fetching, we free our data.
-                engineInterface->PixelFree( dstTexels );
+                PVRTextureDelete( pvrTexture );
 
                 throw;
             }
 
-            // Give things to the runtime.
-            dstTexelsOut = dstTexels;
-            dstDataSizeOut = dstDataSize;
+            PVRTextureDelete( pvrTexture );
         }
         catch( ... )
         {
-            PVRTextureDelete( pvrSourceTexture );
+            PVRTextureHeaderDelete( pvrHeader );
+
+            throw;
+        }
+
+        PVRTextureHeaderDelete( pvrHeader );
+        return;
+    }
+#endif //RWLIB_INCLUDE_PVRTEXLIB
+
+    bool hasAlpha =
+        ( pvrFormat == GL_COMPRESSED_RGBA_PVRTC_4BPPV1_IMG ||
+          pvrFormat == GL_COMPRESSED_RGBA_PVRTC_2BPPV1_IMG );
+
+    pvrtc::CompressSurface(
+        (EngineInterface*)engineInterface, pvrDepth, hasAlpha,
+        surfWidth, surfHeight, srcTexels, surfWidth * sizeof( uint32 ),
+        dstTexels
+    );
+}
+
+void pvrNativeTextureTypeProvider::DecompressPVRMipmap(
+    Interface *engineInterface,
+    uint32 mipWidth, uint32 mipHeight, uint32 layerWidth, uint32 layerHeight, const void *srcTexels,
+    eRasterFormat pvrRasterFormat, uint32 pvrDepth, eColorOrdering pvrColorOrder,
+    eRasterFormat targetRasterFormat, uint32 targetDepth, uint32 targetRowAlignment, eColorOrdering targetColorOrder,
+    ePVRInternalFormat pvrFormat,
+    void*& dstTexelsOut, uint32& dstDataSizeOut
+)
+{
+    // Decompress into a temporary color buffer first.
+    uint32 pvrWidth = mipWidth;
+    uint32 pvrHeight = mipHeight;
+
+    uint32 pvrRowSize = getRasterDataRowSize( pvrWidth, pvrDepth, getPVRToolTextureDataRowAlignment() );
+
+    void *pvrColorBuf = engineInterface->PixelAllocate( getRasterDataSizeByRowSize( pvrRowSize, pvrHeight ) );
+
+    if ( !pvrColorBuf )
+    {
+        throw RwException( "failed to allocate color buffer for PVRTC decompression" );
+    }
+
+    try
+    {
+        DecompressPVRToRGBA( engineInterface, pvrWidth, pvrHeight, srcTexels, pvrFormat, pvrColorBuf );
+
+        // Create a new raw texture of the layer dimensions.
+        uint32 dstRowSize = getRasterDataRowSize( layerWidth, targetDepth, targetRowAlignment );
+
+        uint32 dstDataSize = getRasterDataSizeByRowSize( dstRowSize, layerHeight );
+
+        // Allocate new texels.
+        void *dstTexels = engineInterface->PixelAllocate( dstDataSize );
+
+        if ( !dstTexels )
+        {
+            throw RwException( "failed to allocate destination surface for decompressed PowerVR native texture data" );
+        }
+
+        try
+        {
+            colorModelDispatcher fetchDispatch( pvrRasterFormat, pvrColorOrder, pvrDepth, NULL, 0, PALETTE_NONE );
+            colorModelDispatcher putDispatch( targetRasterFormat, targetColorOrder, targetDepth, NULL, 0, PALETTE_NONE );
+
+            copyTexelDataBounded(
+                pvrColorBuf, dstTexels,
+                fetchDispatch, putDispatch,
+                pvrWidth, pvrHeight,
+                layerWidth, layerHeight,
+                0, 0,
+                0, 0,
+                pvrRowSize, dstRowSize
+            );
+        }
+        catch( ... )
+        {
+            // If anything went wrong in the pixel fetching, we free our data.
+            engineInterface->PixelFree( dstTexels );
 
             throw;
         }
 
-        PVRTextureDelete( pvrSourceTexture );
+        // Give things to the runtime.
+        dstTexelsOut = dstTexels;
+        dstDataSizeOut = dstDataSize;
     }
     catch( ... )
     {
-        PVRTextureHeaderDelete( pvrHeader );
+        engineInterface->PixelFree( pvrColorBuf );
 
         throw;
     }
 
-    PVRTextureHeaderDelete( pvrHeader );
+    engineInterface->PixelFree( pvrColorBuf );
 }
 
 inline void getPVRTargetRasterFormat( ePVRInternalFormat internalFormat, eRasterFormat& targetRasterFormat, uint32& targetDepth, eColorOrdering& targetColorOrder )
@@ -287,17 +427,6 @@ void pvrNativeTextureTypeProvider::GetPixelDataFromTexture( Interface *engineInt
 
     pixelsOut.mipmaps.resize( mipmapCount );
     {
-        // Create source of the pixel type descriptor.
-        PVRPixelType pvrSrcPixelType = PVRGetCachedPixelType( internalFormat );
-
-        if ( !pvrSrcPixelType )
-        {
-            throw RwException( "failed to decompress PVRTC due to unknown internalFormat" );
-        }
-
-        // We need a pixel type for the decompressed format.
-        PVRPixelType pvrDstPixelType = this->pvrPixelType_rgba8888;
-
         for ( size_t n = 0; n < mipmapCount; n++ )
         {
             // Get parameters of this mipmap layer.
@@ -320,7 +449,7 @@ void pvrNativeTextureTypeProvider::GetPixelDataFromTexture( Interface *engineInt
                 mipWidth, mipHeight, layerWidth, layerHeight, srcTexels,
                 RASTER_8888, 32, COLOR_RGBA,
                 targetRasterFormat, targetDepth, targetRowAlignment, targetColorOrder,
-                pvrSrcPixelType, pvrDstPixelType,
+                internalFormat,
                 dstTexels, dstDataSize
             );
 
@@ -415,17 +544,6 @@ void pvrNativeTextureTypeProvider::SetPixelDataToTexture( Interface *engineInter
 
     // Compress mipmap layers.
     {
-        // Determine the source pixel format.
-        PVRPixelType pvrSrcPixelType = this->pvrPixelType_rgba8888;
-
-        // Transform the internal format into a pvrtexlib parameter.
-        PVRPixelType pvrDstPixelType = PVRGetCachedPixelType( internalFormat );
-
-        if ( !pvrDstPixelType )
-        {
-            throw RwException( "failed to compress PVRTC due to unknown internalFormat" );
-        }
-
         // Determine the block dimensions of the PVR destination texture.
         uint32 pvrBlockWidth, pvrBlockHeight;
 
@@ -466,7 +584,7 @@ void pvrNativeTextureTypeProvider::SetPixelDataToTexture( Interface *engineInter
                 mipWidth, mipHeight, srcTexels,
                 srcRasterFormat, srcDepth, srcRowAlignment, srcColorOrder, srcPaletteType, paletteData, paletteSize,
                 RASTER_8888, 32, COLOR_RGBA,
-                pvrSrcPixelType, pvrDstPixelType,
+                internalFormat,
                 pvrBlockWidth, pvrBlockHeight,
                 pvrDepth,
                 compressedWidth, compressedHeight,
@@ -567,17 +685,6 @@ struct pvrMipmapManager
 
         getPVRTargetRasterFormat( internalFormat, targetRasterFormat, targetDepth, targetColorOrder );
 
-        // Create source of the pixel type descriptor.
-        pvrNativeTextureTypeProvider::PVRPixelType pvrSrcPixelType = typeProv->PVRGetCachedPixelType( internalFormat );
-
-        if ( !pvrSrcPixelType )
-        {
-            throw RwException( "failed to decompress PVRTC due to unknown internalFormat" );
-        }
-
-        // We need a pixel type for the decompressed format.
-        pvrNativeTextureTypeProvider::PVRPixelType pvrDstPixelType = typeProv->pvrPixelType_rgba8888;
-
         // Do the decompression.
         void *dstTexels = NULL;
         uint32 dstDataSize = 0;
@@ -587,7 +694,7 @@ struct pvrMipmapManager
             mipWidth, mipHeight, layerWidth, layerHeight, srcTexels,
             RASTER_8888, 32, COLOR_RGBA,
             targetRasterFormat, targetDepth, targetRowAlignment, targetColorOrder,
-            pvrSrcPixelType, pvrDstPixelType,
+            internalFormat,
             dstTexels, dstDataSize
         );
 
@@ -674,17 +781,6 @@ struct pvrMipmapManager
             srcTexelsNewlyAllocated = true;
         }
 
-        // Determine the source pixel format.
-        pvrNativeTextureTypeProvider::PVRPixelType pvrSrcPixelType = typeProv->pvrPixelType_rgba8888;
-
-        // Transform the internal format into a pvrtexlib parameter.
-        pvrNativeTextureTypeProvider::PVRPixelType pvrDstPixelType = typeProv->PVRGetCachedPixelType( internalFormat );
-
-        if ( !pvrDstPixelType )
-        {
-            throw RwException( "failed to compress PVRTC due to unknown internalFormat" );
-        }
-
         // Determine the block dimensions of the PVR destination texture.
         uint32 pvrBlockWidth, pvrBlockHeight;
 
@@ -692,7 +788,7 @@ struct pvrMipmapManager
 
         bool gotDimms = getPVRCompressionBlockDimensions( pvrDepth, pvrBlockWidth, pvrBlockHeight );
 
-        if ( gotDimms )
+        if ( !gotDimms )
         {
             throw RwException( "failed to get PVR native texture block compression dimensions in mipmap texel acquisition" );
         }
@@ -708,7 +804,7 @@ struct pvrMipmapManager
             width, height, srcTexels,
             rasterFormat, depth, rowAlignment, colorOrder, paletteType, paletteData, paletteSize,
             RASTER_8888, 32, COLOR_RGBA,
-            pvrSrcPixelType, pvrDstPixelType,
+            internalFormat,
             pvrBlockWidth, pvrBlockHeight,
             pvrDepth,
             compressedWidth, compressedHeight,
@@ -0,0 +1,209 @@
+// rwtest entry point: runs the registered regression tests and benchmarks.
+
+#include "rwtest.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <vector>
+
+static rwtestRegistration *_registeredTests = NULL;
+
+rwtestRegistration::rwtestRegistration( const char *name, eTestKind kind, rwtestProc_t proc )
+{
+    this->name = name;
+    this->kind = kind;
+    this->proc = proc;
+    this->next = _registeredTests;
+
+    _registeredTests = this;
+}
+
+std::wstring rwtestContext::GetScratchPath( const char *fileName ) const
+{
+    filePath fullPath;
+
+    if ( !this->scratchRoot->GetFullPath( fileName, true, fullPath ) )
+    {
+        throw rw::RwException( std::string( "invalid scratch file name: " ) + fileName );
+    }
+
+    return fullPath.convert_unicode();
+}
+
+void rwtestLog( const char *fmt, ... )
+{
+    va_list args;
+
+    va_start( args, fmt );
+    vprintf( fmt, args );
+    va_end( args );
+
+    printf( "\n" );
+}
+
+bool rwtestCheck( bool condition, const char *fmt, ... )
+{
+    if ( !condition )
+    {
+        va_list args;
+
+        printf( "  check failed: " );
+
+        va_start( args, fmt );
+        vprintf( fmt, args );
+        va_end( args );
+
+        printf( "\n" );
+    }
+
+    return condition;
+}
+
+double rwtestGetTime( void )
+{
+    typedef std::chrono::steady_clock clock_t;
+
+    return std::chrono::duration <double> ( clock_t::now().time_since_epoch() ).count();
+}
+
+// Warnings are part of the output, so that failing tests can be diagnosed.
+struct rwtestWarningManager : public rw::WarningManagerInterface
+{
+    void OnWarning( std::string&& message ) override
+    {
+        printf( "  [warning] %s\n", message.c_str() );
+    }
+};
+
+static bool RunTest( rwtestContext& ctx, const rwtestRegistration *test )
+{
+    rwtestLog( "* %s", test->name );
+
+    bool success = false;
+
+    double startTime = rwtestGetTime();
+
+    try
+    {
+        success = test->proc( ctx );
+    }
+    catch( rw::RwException& except )
+    {
+        rwtestLog( "  uncaught RenderWare exception: %s", except.message.c_str() );
+    }
+    catch( std::exception& except )
+    {
+        rwtestLog( "  uncaught C++ exception: %s", except.what() );
+    }
+
+    rwtestLog( "  %s (%.3f s)", ( success ? "passed" : "FAILED" ), rwtestGetTime() - startTime );
+
+    return success;
+}
+
+int main( int argc, char *argv[] )
+{
+    rw::LibraryVersion engineVersion;
+    engineVersion.rwLibMajor = 3;
+    engineVersion.rwLibMinor = 6;
+    engineVersion.rwRevMajor = 0;
+    engineVersion.rwRevMinor = 3;
+
+    rw::Interface *engineInterface = rw::CreateEngine( engineVersion );
+
+    if ( engineInterface == NULL )
+    {
+        rwtestLog( "failed to initialize the RenderWare engine" );
+        return -1;
+    }
+
+    rwtestWarningManager warningManager;
+
+    engineInterface->SetWarningManager( &warningManager );
+    engineInterface->SetWarningLevel( 3 );
+    engineInterface->SetIgnoreSecureWarnings( false );
+
+    fs_construction_params fsParams;
+    fsParams.nativeExecMan = (NativeExecutive::CExecutiveManager*)rw::GetThreadingNativeManager( engineInterface );
+
+    CFileSystem *fileSystem = CFileSystem::Create( fsParams );
+
+    if ( fileSystem == NULL )
+    {
+        rwtestLog( "failed to initialize the FileSystem module" );
+
+        rw::DeleteEngine( engineInterface );
+        return -1;
+    }
+
+    CFileTranslator *scratchRoot = fileSystem->GenerateTempRepository();
+
+    rw::uint32 failedCount = 0;
+    rw::uint32 runCount = 0;
+
+    if ( scratchRoot == NULL )
+    {
+        rwtestLog( "failed to create the scratch directory" );
+
+        failedCount++;
+    }
+    else
+    {
+        rwtestContext ctx;
+        ctx.engineInterface = engineInterface;
+        ctx.fileSystem = fileSystem;
+        ctx.scratchRoot = scratchRoot;
+
+        // Run in registration order.
+        std::vector <const rwtestRegistration*> tests;
+
+        for ( const rwtestRegistration *test = _registeredTests; test != NULL; test = test->next )
+        {
+            tests.insert( tests.begin(), test );
+        }
+
+        for ( const rwtestRegistration *test : tests )
+        {
+            bool shouldRun = false;
+
+            if ( argc <= 1 )
+            {
+                shouldRun = ( test->kind == RWTEST_REGRESSION );
+            }
+            else
+            {
+                for ( int n = 1; n < argc; n++ )
+                {
+                    if ( strcmp( argv[ n ], test->name ) == 0 )
+                    {
+                        shouldRun = true;
+                        break;
+                    }
+                }
+            }
+
+            if ( shouldRun )
+            {
+                runCount++;
+
+                if ( !RunTest( ctx, test ) )
+                {
+                    failedCount++;
+                }
+            }
+        }
+
+        fileSystem->DeleteTempRepository( scratchRoot );
+    }
+
+    rwtestLog( "%u run, %u failed", runCount, failedCount );
+
+    CFileSystem::Destroy( fileSystem );
+
+    rw::DeleteEngine( engineInterface );
+
+    return ( failedCount == 0 ? 0 : 1 );
+}
@@ -0,0 +1,83 @@
+// Shared include of the rwtools regression test and benchmark runner.
+
+#ifndef _RWTEST_MAIN_HEADER_
+#define _RWTEST_MAIN_HEADER_
+
+#include <renderware.h>
+
+#include <CFileSystemInterface.h>
+#include <CFileSystem.h>
+
+#include <string>
+
+// Everything a test gets to work with.
+struct rwtestContext
+{
+    rw::Interface *engineInterface;
+    CFileSystem *fileSystem;
+
+    CFileTranslator *scratchRoot;   // temporary directory, deleted after the run
+
+    // Returns the absolute path of a file inside the scratch directory.
+    std::wstring GetScratchPath( const char *fileName ) const;
+};
+
+typedef bool (*rwtestProc_t)( rwtestContext& ctx );
+
+enum eTestKind
+{
+    RWTEST_REGRESSION,
+    RWTEST_BENCHMARK
+};
+
+// Tests register themselves through a static object of this type.
+struct rwtestRegistration
+{
+    rwtestRegistration( const char *name, eTestKind kind, rwtestProc_t proc );
+
+    const char *name;
+    eTestKind kind;
+    rwtestProc_t proc;
+
+    rwtestRegistration *next;
+};
+
+#define RWTEST_CONCAT_NAME_( a, b ) a##b
+#define RWTEST_CONCAT_NAME( a, b ) RWTEST_CONCAT_NAME_( a, b )
+
+#define RWTEST_REGISTER( name, kind, proc ) \
+    static rwtestRegistration RWTEST_CONCAT_NAME( _rwtestRegistration, __LINE__ )( name, kind, proc )
+
+// Reporting helpers.
+void rwtestLog( const char *fmt, ... );
+
+// Prints a failure message if the condition is false and returns the condition.
+bool rwtestCheck( bool condition, const char *fmt, ... );
+
+// Monotonic time in seconds, for benchmarks.
+double rwtestGetTime( void );
+
+// Deterministic pseudo-random numbers so that every run sees the same data.
+struct rwtestRandom
+{
+    inline rwtestRandom( rw::uint32 seed )
+    {
+        this->state = ( seed * 2654435761u + 1 );
+    }
+
+    inline rw::uint32 Next( void )
+    {
+        this->state = ( this->state * 1103515245u + 12345u );
+
+        return ( this->state >> 8 );
+    }
+
+    inline rw::uint32 NextBelow( rw::uint32 maxValue )
+    {
+        return ( maxValue == 0 ? 0 : this->Next() % maxValue );
+    }
+
+    rw::uint32 state;
+};
+
+#endif //_RWTEST_MAIN_HEADER_
@@ -0,0 +1,11 @@
+// Shared include of the tests that look into the rwlib internals.
+// The private header of rwlib has to come before the public one, so that renderware.h sees RWCORE.
+
+#ifndef _RWTEST_INTERNAL_HEADER_
+#define _RWTEST_INTERNAL_HEADER_
+
+#include "../../rwlib/src/StdInc.h"
+
+#include "rwtest.h"
+
+#endif //_RWTEST_INTERNAL_HEADER_
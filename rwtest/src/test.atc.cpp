@@ -0,0 +1,392 @@
+// Tests of the ATC codec.
+// The decoder has to give the texels that the AMD Compressonator gives for a set of reference blocks,
+// because the native textures of the mobile GTA ports were made with it. The encoder has to produce
+// blocks that decode close to the source image, for every ATC format.
+
+#include "rwtest.internal.h"
+
+#ifdef RWLIB_INCLUDE_NATIVETEX_ATC_MOBILE
+
+#include "../../rwlib/src/txdread.atitc.hxx"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct _atcReferenceBlock
+{
+    rw::eATCInternalFormat internalFormat;
+    rw::uint8 blockData[16];        // only the first 8 bytes for ATC_RGB_AMD
+    rw::uint8 texels[16][4];        // RGBA in row order
+};
+
+static const _atcReferenceBlock _atcReferenceBlocks[] =
+{
+    // Black block.
+    {
+        rw::ATC_RGB_AMD,
+        { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+        {
+            {   0,   0,   0, 255 }, {   0,   0,   0, 255 }, {   0,   0,   0, 255 }, {   0,   0,   0, 255 },
+            {   0,   0,   0, 255 }, {   0,   0,   0, 255 }, {   0,   0,   0, 255 }, {   0,   0,   0, 255 },
+            {   0,   0,   0, 255 }, {   0,   0,   0, 255 }, {   0,   0,   0, 255 }, {   0,   0,   0, 255 },
+            {   0,   0,   0, 255 }, {   0,   0,   0, 255 }, {   0,   0,   0, 255 }, {   0,   0,   0, 255 }
+        }
+    },
+    // White to black, every palette entry once per row: 255, 159, 95, 0.
+    {
+        rw::ATC_RGB_AMD,
+        { 0xFF, 0x7F, 0x00, 0x00, 0xE4, 0xE4, 0xE4, 0xE4, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+        {
+            { 255, 255, 255, 255 }, { 159, 159, 159, 255 }, {  95,  95,  95, 255 }, {   0,   0,   0, 255 },
+            { 255, 255, 255, 255 }, { 159, 159, 159, 255 }, {  95,  95,  95, 255 }, {   0,   0,   0, 255 },
+            { 255, 255, 255, 255 }, { 159, 159, 159, 255 }, {  95,  95,  95, 255 }, {   0,   0,   0, 255 },
+            { 255, 255, 255, 255 }, { 159, 159, 159, 255 }, {  95,  95,  95, 255 }, {   0,   0,   0, 255 }
+        }
+    },
+    // Black to white, reversed indices.
+    {
+        rw::ATC_RGB_AMD,
+        { 0x00, 0x00, 0xFF, 0xFF, 0x1B, 0x1B, 0x1B, 0x1B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+        {
+            { 255, 255, 255, 255 }, { 159, 159, 159, 255 }, {  95,  95,  95, 255 }, {   0,   0,   0, 255 },
+            { 255, 255, 255, 255 }, { 159, 159, 159, 255 }, {  95,  95,  95, 255 }, {   0,   0,   0, 255 },
+            { 255, 255, 255, 255 }, { 159, 159, 159, 255 }, {  95,  95,  95, 255 }, {   0,   0,   0, 255 },
+            { 255, 255, 255, 255 }, { 159, 159, 159, 255 }, {  95,  95,  95, 255 }, {   0,   0,   0, 255 }
+        }
+    },
+    // Alternate mode: 0, c0 - c1/4 (clamped at 0), c0, c1.
+    {
+        rw::ATC_RGB_AMD,
+        { 0x5F, 0xD1, 0x04, 0xFD, 0xE4, 0xE4, 0xE4, 0xE4, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+        {
+            {   0,   0,   0, 255 }, { 102,  42, 247, 255 }, { 165,  82, 255, 255 }, { 255, 162,  33, 255 },
+            {   0,   0,   0, 255 }, { 102,  42, 247, 255 }, { 165,  82, 255, 255 }, { 255, 162,  33, 255 },
+            {   0,   0,   0, 255 }, { 102,  42, 247, 255 }, { 165,  82, 255, 255 }, { 255, 162,  33, 255 },
+            {   0,   0,   0, 255 }, { 102,  42, 247, 255 }, { 165,  82, 255, 255 }, { 255, 162,  33, 255 }
+        }
+    },
+    // Alternate mode where the second color clamps to zero.
+    {
+        rw::ATC_RGB_AMD,
+        { 0xC1, 0x8B, 0xFF, 0xFF, 0x4E, 0x4E, 0x4E, 0x4E, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+        {
+            {  16, 247,   8, 255 }, { 255, 255, 255, 255 }, {   0,   0,   0, 255 }, {   0, 184,   0, 255 },
+            {  16, 247,   8, 255 }, { 255, 255, 255, 255 }, {   0,   0,   0, 255 }, {   0, 184,   0, 255 },
+            {  16, 247,   8, 255 }, { 255, 255, 255, 255 }, {   0,   0,   0, 255 }, {   0, 184,   0, 255 },
+            {  16, 247,   8, 255 }, { 255, 255, 255, 255 }, {   0,   0,   0, 255 }, {   0, 184,   0, 255 }
+        }
+    },
+    // Random block.
+    {
+        rw::ATC_RGB_AMD,
+        { 0x64, 0x24, 0x88, 0xFB, 0xB1, 0xC3, 0x0E, 0xE1, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+        {
+            { 141,  57,  45, 255 }, {  74,  24,  33, 255 }, { 255, 113,  66, 255 }, { 187,  79,  53, 255 },
+            { 255, 113,  66, 255 }, {  74,  24,  33, 255 }, {  74,  24,  33, 255 }, { 255, 113,  66, 255 },
+            { 187,  79,  53, 255 }, { 255, 113,  66, 255 }, {  74,  24,  33, 255 }, {  74,  24,  33, 255 },
+            { 141,  57,  45, 255 }, {  74,  24,  33, 255 }, { 187,  79,  53, 255 }, { 255, 113,  66, 255 }
+        }
+    },
+    // Random block.
+    {
+        rw::ATC_RGB_AMD,
+        { 0xA5, 0x0A, 0x20, 0x45, 0x33, 0x04, 0x38, 0xE4, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+        {
+            {  66, 166,   0, 255 }, {  16, 173,  41, 255 }, {  66, 166,   0, 255 }, {  16, 173,  41, 255 },
+            {  16, 173,  41, 255 }, {  34, 170,  25, 255 }, {  16, 173,  41, 255 }, {  16, 173,  41, 255 },
+            {  16, 173,  41, 255 }, {  47, 168,  15, 255 }, {  66, 166,   0, 255 }, {  16, 173,  41, 255 },
+            {  16, 173,  41, 255 }, {  34, 170,  25, 255 }, {  47, 168,  15, 255 }, {  66, 166,   0, 255 }
+        }
+    },
+    // Random alternate mode block.
+    {
+        rw::ATC_RGB_AMD,
+        { 0x06, 0x9C, 0x68, 0x84, 0xBE, 0x36, 0xE5, 0x85, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+        {
+            {  57,   0,  49, 255 }, { 132, 142,  66, 255 }, { 132, 142,  66, 255 }, {  57,   0,  49, 255 },
+            {  57,   0,  49, 255 }, {  24,   0,  33, 255 }, { 132, 142,  66, 255 }, {   0,   0,   0, 255 },
+            {  24,   0,  33, 255 }, {  24,   0,  33, 255 }, {  57,   0,  49, 255 }, { 132, 142,  66, 255 },
+            {  24,   0,  33, 255 }, {  24,   0,  33, 255 }, {   0,   0,   0, 255 }, {  57,   0,  49, 255 }
+        }
+    },
+    // Every alpha step once, red to green.
+    {
+        rw::ATC_RGBA_EXPLICIT_ALPHA_AMD,
+        { 0x10, 0x32, 0x54, 0x76, 0x98, 0xBA, 0xDC, 0xFE, 0x00, 0x7C, 0xE0, 0x07, 0xE4, 0xE4, 0xE4, 0xE4 },
+        {
+            { 255,   0,   0,   0 }, { 159,  95,   0,  17 }, {  95, 159,   0,  34 }, {   0, 255,   0,  51 },
+            { 255,   0,   0,  68 }, { 159,  95,   0,  85 }, {  95, 159,   0, 102 }, {   0, 255,   0, 119 },
+            { 255,   0,   0, 136 }, { 159,  95,   0, 153 }, {  95, 159,   0, 170 }, {   0, 255,   0, 187 },
+            { 255,   0,   0, 204 }, { 159,  95,   0, 221 }, {  95, 159,   0, 238 }, {   0, 255,   0, 255 }
+        }
+    },
+    // Random alternate mode block.
+    {
+        rw::ATC_RGBA_EXPLICIT_ALPHA_AMD,
+        { 0x71, 0xDC, 0x3A, 0x13, 0x8E, 0x0A, 0x4C, 0x11, 0x66, 0x8B, 0x46, 0xBF, 0x52, 0x5B, 0xF6, 0x6E },
+        {
+            {  16, 222,  49,  17 }, {   0,   0,   0, 119 }, {   0, 164,  37, 204 }, {   0, 164,  37, 221 },
+            { 189, 235,  49, 170 }, {  16, 222,  49,  51 }, {   0, 164,  37,  51 }, {   0, 164,  37,  17 },
+            {  16, 222,  49, 238 }, {   0, 164,  37, 136 }, { 189, 235,  49, 170 }, { 189, 235,  49,   0 },
+            {  16, 222,  49, 204 }, { 189, 235,  49,  68 }, {  16, 222,  49,  17 }, {   0, 164,  37,  17 }
+        }
+    },
+    // Random block.
+    {
+        rw::ATC_RGBA_EXPLICIT_ALPHA_AMD,
+        { 0xDE, 0xDD, 0x24, 0x4B, 0xD3, 0x36, 0xCB, 0x1E, 0xCB, 0x57, 0xD7, 0x27, 0x2A, 0xE0, 0xAA, 0xEE },
+        {
+            {  85, 249, 151, 238 }, {  85, 249, 151, 221 }, {  85, 249, 151, 221 }, { 173, 247,  90, 221 },
+            { 173, 247,  90,  68 }, { 173, 247,  90,  34 }, {  85, 249, 151, 187 }, {  33, 251, 189,  68 },
+            {  85, 249, 151,  51 }, {  85, 249, 151, 221 }, {  85, 249, 151, 102 }, {  85, 249, 151,  51 },
+            {  85, 249, 151, 187 }, {  33, 251, 189, 204 }, {  85, 249, 151, 238 }, {  33, 251, 189,  17 }
+        }
+    },
+    // Eight step ramp: alpha0 > alpha1.
+    {
+        rw::ATC_RGBA_INTERPOLATED_ALPHA_AMD,
+        { 0xC8, 0x14, 0x88, 0xC6, 0xFA, 0x88, 0xC6, 0xFA, 0x10, 0x42, 0x08, 0x44, 0x1B, 0x1B, 0x1B, 0x1B },
+        {
+            {  66, 130,  66, 200 }, {  90, 130,  90,  20 }, { 107, 131, 107, 174 }, { 132, 132, 132, 149 },
+            {  66, 130,  66, 123 }, {  90, 130,  90,  97 }, { 107, 131, 107,  71 }, { 132, 132, 132,  46 },
+            {  66, 130,  66, 200 }, {  90, 130,  90,  20 }, { 107, 131, 107, 174 }, { 132, 132, 132, 149 },
+            {  66, 130,  66, 123 }, {  90, 130,  90,  97 }, { 107, 131, 107,  71 }, { 132, 132, 132,  46 }
+        }
+    },
+    // Six step ramp with explicit 0 and 255.
+    {
+        rw::ATC_RGBA_INTERPOLATED_ALPHA_AMD,
+        { 0x14, 0xC8, 0x88, 0xC6, 0xFA, 0x88, 0xC6, 0xFA, 0x10, 0x42, 0x08, 0x44, 0x1B, 0x1B, 0x1B, 0x1B },
+        {
+            {  66, 130,  66,  20 }, {  90, 130,  90, 200 }, { 107, 131, 107,  56 }, { 132, 132, 132,  92 },
+            {  66, 130,  66, 128 }, {  90, 130,  90, 164 }, { 107, 131, 107,   0 }, { 132, 132, 132, 255 },
+            {  66, 130,  66,  20 }, {  90, 130,  90, 200 }, { 107, 131, 107,  56 }, { 132, 132, 132,  92 },
+            {  66, 130,  66, 128 }, {  90, 130,  90, 164 }, { 107, 131, 107,   0 }, { 132, 132, 132, 255 }
+        }
+    },
+    // Full ramp over white.
+    {
+        rw::ATC_RGBA_INTERPOLATED_ALPHA_AMD,
+        { 0xFF, 0x00, 0x88, 0xC6, 0xFA, 0x88, 0xC6, 0xFA, 0xFF, 0x7F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },
+        {
+            { 255, 255, 255, 255 }, { 255, 255, 255,   0 }, { 255, 255, 255, 219 }, { 255, 255, 255, 182 },
+            { 255, 255, 255, 146 }, { 255, 255, 255, 109 }, { 255, 255, 255,  73 }, { 255, 255, 255,  36 },
+            { 255, 255, 255, 255 }, { 255, 255, 255,   0 }, { 255, 255, 255, 219 }, { 255, 255, 255, 182 },
+            { 255, 255, 255, 146 }, { 255, 255, 255, 109 }, { 255, 255, 255,  73 }, { 255, 255, 255,  36 }
+        }
+    },
+    // Random block.
+    {
+        rw::ATC_RGBA_INTERPOLATED_ALPHA_AMD,
+        { 0xCC, 0xB7, 0x68, 0x15, 0xCE, 0xB4, 0x01, 0x09, 0x27, 0x6B, 0xB4, 0xA9, 0xC3, 0x7B, 0x78, 0x02 },
+        {
+            { 173,  52, 165, 204 }, { 214, 206,  57, 192 }, { 214, 206,  57, 192 }, { 173,  52, 165, 201 },
+            { 173,  52, 165, 183 }, { 188, 109, 124, 195 }, { 173,  52, 165, 198 }, { 198, 148,  97, 189 },
+            { 214, 206,  57, 195 }, { 188, 109, 124, 189 }, { 173,  52, 165, 189 }, { 198, 148,  97, 204 },
+            { 188, 109, 124, 204 }, { 214, 206,  57, 201 }, { 214, 206,  57, 201 }, { 214, 206,  57, 204 }
+        }
+    },
+    // Random alternate mode block.
+    {
+        rw::ATC_RGBA_INTERPOLATED_ALPHA_AMD,
+        { 0x8E, 0x2B, 0x02, 0x65, 0x1D, 0xBE, 0x2C, 0x2B, 0x99, 0xF2, 0xDD, 0x8F, 0xA8, 0x7F, 0xE4, 0xE3 },
+        {
+            {   0,   0,   0, 128 }, { 231, 165, 206, 142 }, { 231, 165, 206, 100 }, { 231, 165, 206, 128 },
+            { 140, 251, 239,  71 }, { 140, 251, 239, 128 }, { 140, 251, 239,  57 }, { 196, 103, 147, 142 },
+            {   0,   0,   0,  71 }, { 196, 103, 147,  57 }, { 231, 165, 206, 128 }, { 140, 251, 239,  71 },
+            { 140, 251, 239, 128 }, {   0,   0,   0,  71 }, { 231, 165, 206, 128 }, { 140, 251, 239,  43 }
+        }
+    }
+};
+
+static const char* GetATCFormatName( rw::eATCInternalFormat internalFormat )
+{
+    if ( internalFormat == rw::ATC_RGB_AMD )
+    {
+        return "ATC RGB";
+    }
+    else if ( internalFormat == rw::ATC_RGBA_EXPLICIT_ALPHA_AMD )
+    {
+        return "ATC explicit alpha";
+    }
+
+    return "ATC interpolated alpha";
+}
+
+static bool test_atc_reference_blocks( rwtestContext& ctx )
+{
+    rw::EngineInterface *engineInterface = (rw::EngineInterface*)ctx.engineInterface;
+
+    bool success = true;
+
+    const size_t blockCount = ( sizeof( _atcReferenceBlocks ) / sizeof( *_atcReferenceBlocks ) );
+
+    for ( size_t n = 0; n < blockCount; n++ )
+    {
+        const _atcReferenceBlock& refBlock = _atcReferenceBlocks[ n ];
+
+        rw::uint8 texels[16][4];
+
+        rw::atitc::DecompressSurface( engineInterface, refBlock.internalFormat, 4, 4, refBlock.blockData, texels, 4 * sizeof( texels[0] ) );
+
+        for ( rw::uint32 texelIndex = 0; texelIndex < 16; texelIndex++ )
+        {
+            const rw::uint8 *texel = texels[ texelIndex ];
+            const rw::uint8 *expected = refBlock.texels[ texelIndex ];
+
+            if ( !rwtestCheck(
+                    memcmp( texel, expected, 4 ) == 0,
+                    "block %u (%s), texel %u: decoded ( %u, %u, %u, %u ) instead of ( %u, %u, %u, %u )",
+                    (rw::uint32)n, GetATCFormatName( refBlock.internalFormat ), texelIndex,
+                    texel[0], texel[1], texel[2], texel[3], expected[0], expected[1], expected[2], expected[3]
+                 ) )
+            {
+                success = false;
+                break;
+            }
+        }
+    }
+
+    return success;
+}
+
+RWTEST_REGISTER( "atc.reference_blocks", RWTEST_REGRESSION, test_atc_reference_blocks );
+
+// The dimensions are not a multiple of 4, so the encoder has to fill the border blocks.
+static const rw::uint32 _atcRoundTripWidth = 61;
+static const rw::uint32 _atcRoundTripHeight = 37;
+
+// Smooth images lose little in block compression, so these are far from what the encoder reaches.
+static const double _atcRoundTripMinColorPSNR = 30.0;
+
+// Four bit alpha is rounded to the closest of 16 steps.
+static const rw::uint32 _atcRoundTripMaxExplicitAlphaError = 8;
+
+// Half a step of the six value ramp over the full range.
+static const rw::uint32 _atcRoundTripMaxInterpolatedAlphaError = 26;
+
+// Color gradients with a little noise, alpha in gradients and in flat areas of 0 and 255.
+static std::vector <rw::uint8> GetATCRoundTripImage( rw::uint32 width, rw::uint32 height, rw::uint32 seed )
+{
+    rwtestRandom random( seed );
+
+    std::vector <rw::uint8> texels( width * height * 4 );
+
+    for ( rw::uint32 y = 0; y < height; y++ )
+    {
+        for ( rw::uint32 x = 0; x < width; x++ )
+        {
+            rw::uint8 *texel = &texels[ ( y * width + x ) * 4 ];
+
+            int noise = (int)random.NextBelow( 9 ) - 4;
+
+            texel[0] = (rw::uint8)std::max( 0, std::min( 255, (int)( x * 255 / width ) + noise ) );
+            texel[1] = (rw::uint8)std::max( 0, std::min( 255, (int)( y * 255 / height ) - noise ) );
+            texel[2] = (rw::uint8)std::max( 0, std::min( 255, 200 - (int)( ( x + y ) * 150 / ( width + height ) ) + noise ) );
+
+            if ( x < width / 4 )
+            {
+                texel[3] = 0;
+            }
+            else if ( x >= width * 3 / 4 )
+            {
+                texel[3] = 255;
+            }
+            else
+            {
+                texel[3] = (rw::uint8)( ( x + y * 3 ) * 255 / ( width + height * 3 ) );
+            }
+        }
+    }
+
+    return texels;
+}
+
+static bool CheckATCRoundTrip( rw::EngineInterface *engineInterface, rw::eATCInternalFormat internalFormat, rw::uint32 seed )
+{
+    const char *formatName = GetATCFormatName( internalFormat );
+
+    const rw::uint32 width = _atcRoundTripWidth;
+    const rw::uint32 height = _atcRoundTripHeight;
+
+    std::vector <rw::uint8> srcTexels = GetATCRoundTripImage( width, height, seed );
+
+    rw::uint32 surfWidth = ( ( width + 3 ) / 4 * 4 );
+    rw::uint32 surfHeight = ( ( height + 3 ) / 4 * 4 );
+
+    rw::uint32 blockCount = ( ( surfWidth / 4 ) * ( surfHeight / 4 ) );
+
+    std::vector <rw::uint8> blocks( blockCount * rw::getATCCompressionBlockSize( internalFormat ) );
+
+    rw::atitc::CompressSurface( engineInterface, internalFormat, width, height, srcTexels.data(), width * 4, blocks.data() );
+
+    std::vector <rw::uint8> decodedTexels( surfWidth * surfHeight * 4 );
+
+    rw::atitc::DecompressSurface( engineInterface, internalFormat, surfWidth, surfHeight, blocks.data(), decodedTexels.data(), surfWidth * 4 );
+
+    double colorErrorSum = 0;
+    rw::uint32 maxAlphaError = 0;
+
+    for ( rw::uint32 y = 0; y < height; y++ )
+    {
+        for ( rw::uint32 x = 0; x < width; x++ )
+        {
+            const rw::uint8 *srcTexel = &srcTexels[ ( y * width + x ) * 4 ];
+            const rw::uint8 *decodedTexel = &decodedTexels[ ( y * surfWidth + x ) * 4 ];
+
+            for ( rw::uint32 ch = 0; ch < 3; ch++ )
+            {
+                double diff = ( (double)srcTexel[ ch ] - (double)decodedTexel[ ch ] );
+
+                colorErrorSum += ( diff * diff );
+            }
+
+            rw::uint32 expectedAlpha = ( internalFormat == rw::ATC_RGB_AMD ? 255 : srcTexel[3] );
+
+            maxAlphaError = std::max( maxAlphaError, (rw::uint32)abs( (int)expectedAlpha - (int)decodedTexel[3] ) );
+        }
+    }
+
+    double colorMSE = ( colorErrorSum / ( (double)width * height * 3 ) );
+
+    double colorPSNR = ( colorMSE == 0 ? 99.0 : 10.0 * log10( 255.0 * 255.0 / colorMSE ) );
+
+    rwtestLog( "  %s: color PSNR %.2f dB, max alpha error %u", formatName, colorPSNR, maxAlphaError );
+
+    bool success = true;
+
+    success &= rwtestCheck( colorPSNR >= _atcRoundTripMinColorPSNR, "%s: the color PSNR is only %.2f dB", formatName, colorPSNR );
+
+    rw::uint32 alphaTolerance = 0;
+
+    if ( internalFormat == rw::ATC_RGBA_EXPLICIT_ALPHA_AMD )
+    {
+        alphaTolerance = _atcRoundTripMaxExplicitAlphaError;
+    }
+    else if ( internalFormat == rw::ATC_RGBA_INTERPOLATED_ALPHA_AMD )
+    {
+        alphaTolerance = _atcRoundTripMaxInterpolatedAlphaError;
+    }
+
+    success &= rwtestCheck( maxAlphaError <= alphaTolerance, "%s: alpha is off by up to %u", formatName, maxAlphaError );
+
+    return success;
+}
+
+static bool test_atc_roundtrip( rwtestContext& ctx )
+{
+    rw::EngineInterface *engineInterface = (rw::EngineInterface*)ctx.engineInterface;
+
+    bool success = true;
+
+    success &= CheckATCRoundTrip( engineInterface, rw::ATC_RGB_AMD, 0xA7C );
+    success &= CheckATCRoundTrip( engineInterface, rw::ATC_RGBA_EXPLICIT_ALPHA_AMD, 0xA7D );
+    success &= CheckATCRoundTrip( engineInterface, rw::ATC_RGBA_INTERPOLATED_ALPHA_AMD, 0xA7E );
+
+    return success;
+}
+
+RWTEST_REGISTER( "atc.roundtrip", RWTEST_REGRESSION, test_atc_roundtrip );
+
+#endif //RWLIB_INCLUDE_NATIVETEX_ATC_MOBILE
@@ -0,0 +1,267 @@
+// Parsing of deep block trees through BlockProvider.
+// Blocks with trusted regions are read through the read-ahead window of the root block, the others
+// go through every parent for each read. Both have to see the same data and leave the stream at the same place.
+
+#include "rwtest.h"
+
+// Every root block has a tree of 1365 blocks below it; the leaves are struct blocks.
+static const rw::uint32 _blockTreeDepth = 6;
+static const rw::uint32 _blockTreeFanOut = 4;
+static const rw::uint32 _blockStructValues = 24;
+static const rw::uint32 _blockRootCount = 3;
+static const rw::uint32 _blockReadRounds = 20;
+
+static void WriteBlockTree( rw::BlockProvider& block, rw::uint32 level, rwtestRandom& random )
+{
+    block.EnterContext();
+
+    try
+    {
+        if ( level + 1 == _blockTreeDepth )
+        {
+            block.setBlockID( rw::CHUNK_STRUCT );
+
+            for ( rw::uint32 n = 0; n < _blockStructValues; n++ )
+            {
+                block.writeUInt32( random.Next() );
+                block.writeUInt16( (rw::uint16)random.Next() );
+            }
+        }
+        else
+        {
+            block.setBlockID( rw::CHUNK_EXTENSION );
+
+            for ( rw::uint32 n = 0; n < _blockTreeFanOut; n++ )
+            {
+                rw::BlockProvider childBlock( &block );
+
+                WriteBlockTree( childBlock, level + 1, random );
+            }
+        }
+    }
+    catch( ... )
+    {
+        block.LeaveContext();
+
+        throw;
+    }
+
+    block.LeaveContext();
+}
+
+static rw::uint32 ReadBlockTree( rw::BlockProvider& block )
+{
+    block.EnterContext();
+
+    rw::uint32 checksum = block.getBlockID();
+
+    try
+    {
+        if ( block.getBlockID() == rw::CHUNK_STRUCT )
+        {
+            for ( rw::uint32 n = 0; n < _blockStructValues; n++ )
+            {
+                rw::uint32 intValue = block.readUInt32();
+                rw::uint16 shortValue = block.readUInt16();
+
+                checksum = ( checksum * 31 + intValue );
+                checksum = ( checksum * 31 + shortValue );
+            }
+        }
+        else
+        {
+            for ( rw::uint32 n = 0; n < _blockTreeFanOut; n++ )
+            {
+                rw::BlockProvider childBlock( &block );
+
+                checksum = ( checksum * 31 + ReadBlockTree( childBlock ) );
+            }
+        }
+    }
+    catch( ... )
+    {
+        block.LeaveContext();
+
+        throw;
+    }
+
+    block.LeaveContext();
+
+    return checksum;
+}
+
+struct _blockReadResult
+{
+    rw::uint32 checksum;
+    rw::int64 endOffset;
+    double seconds;
+};
+
+static bool ReadBlockRoots( rw::Stream *stream, bool ignoreBlockRegions, _blockReadResult& resultOut )
+{
+    resultOut.checksum = 0;
+    resultOut.endOffset = -1;
+
+    double startTime = rwtestGetTime();
+
+    try
+    {
+        for ( rw::uint32 round = 0; round < _blockReadRounds; round++ )
+        {
+            stream->seek( 0, rw::RWSEEK_BEG );
+
+            for ( rw::uint32 n = 0; n < _blockRootCount; n++ )
+            {
+                rw::BlockProvider rootBlock( stream, rw::RWBLOCKMODE_READ, ignoreBlockRegions );
+
+                resultOut.checksum = ( resultOut.checksum * 31 + ReadBlockTree( rootBlock ) );
+            }
+        }
+    }
+    catch( rw::RwException& except )
+    {
+        rwtestLog( "  reading the block tree failed: %s", except.message.c_str() );
+
+        return false;
+    }
+
+    resultOut.seconds = ( rwtestGetTime() - startTime );
+    resultOut.endOffset = stream->tell();
+
+    return true;
+}
+
+static bool CompareBlockReads( rw::Stream *stream, const char *streamName, rw::int64 dataSize )
+{
+    _blockReadResult chainedResult, flatResult;
+
+    bool couldReadChained = ReadBlockRoots( stream, true, chainedResult );
+    bool couldReadFlat = ReadBlockRoots( stream, false, flatResult );
+
+    bool success = rwtestCheck( couldReadChained && couldReadFlat, "%s: could not read the block trees", streamName );
+
+    if ( success )
+    {
+        success &= rwtestCheck( chainedResult.checksum == flatResult.checksum, "%s: read-ahead reading saw different data", streamName );
+        success &= rwtestCheck( chainedResult.endOffset == dataSize, "%s: chained reading ended at %lld", streamName, (long long)chainedResult.endOffset );
+        success &= rwtestCheck( flatResult.endOffset == dataSize, "%s: read-ahead reading ended at %lld", streamName, (long long)flatResult.endOffset );
+
+        rwtestLog(
+            "  %s: %.1f ms chained, %.1f ms read-ahead (%u rounds)",
+            streamName, chainedResult.seconds * 1000.0, flatResult.seconds * 1000.0, _blockReadRounds
+        );
+    }
+
+    return success;
+}
+
+static bool bench_block_readahead( rwtestContext& ctx )
+{
+    rw::Interface *engineInterface = ctx.engineInterface;
+
+    // Write the block trees once.
+    std::vector <char> blockData;
+    {
+        rw::streamConstructionMemoryParam_t memParam( NULL, 0 );
+
+        rw::Stream *writeStream = engineInterface->CreateStream( rw::RWSTREAMTYPE_MEMORY, rw::RWSTREAMMODE_CREATE, &memParam );
+
+        if ( !rwtestCheck( writeStream != NULL, "could not create the memory stream" ) )
+            return false;
+
+        bool couldWrite = true;
+
+        try
+        {
+            rwtestRandom random( 0xB10C );
+
+            for ( rw::uint32 n = 0; n < _blockRootCount; n++ )
+            {
+                rw::BlockProvider rootBlock( writeStream, rw::RWBLOCKMODE_WRITE, false );
+
+                WriteBlockTree( rootBlock, 0, random );
+            }
+
+            blockData.resize( (size_t)writeStream->size() );
+
+            writeStream->seek( 0, rw::RWSEEK_BEG );
+            writeStream->read( blockData.data(), blockData.size() );
+        }
+        catch( rw::RwException& except )
+        {
+            rwtestLog( "  writing the block tree failed: %s", except.message.c_str() );
+
+            couldWrite = false;
+        }
+
+        engineInterface->DeleteStream( writeStream );
+
+        if ( !couldWrite )
+            return false;
+    }
+
+    rw::int64 dataSize = (rw::int64)blockData.size();
+
+    bool success = true;
+
+    // Memory streams can be viewed directly.
+    {
+        rw::streamConstructionMemoryParam_t memParam( blockData.data(), blockData.size() );
+
+        rw::Stream *memStream = engineInterface->CreateStream( rw::RWSTREAMTYPE_MEMORY, rw::RWSTREAMMODE_READONLY, &memParam );
+
+        if ( rwtestCheck( memStream != NULL, "could not create the memory stream" ) )
+        {
+            success &= CompareBlockReads( memStream, "memory", dataSize );
+
+            engineInterface->DeleteStream( memStream );
+        }
+        else
+        {
+            success = false;
+        }
+    }
+
+    // File streams read through the window buffer.
+    std::wstring path = ctx.GetScratchPath( "block_readahead.bin" );
+    {
+        rw::streamConstructionFileParamW_t fileParam( path.c_str() );
+
+        rw::Stream *fileStream = engineInterface->CreateStream( rw::RWSTREAMTYPE_FILE_W, rw::RWSTREAMMODE_CREATE, &fileParam );
+
+        if ( rwtestCheck( fileStream != NULL, "could not create the block file" ) )
+        {
+            success &= rwtestCheck( fileStream->write( blockData.data(), blockData.size() ) == blockData.size(), "could not write the block file" );
+
+            engineInterface->DeleteStream( fileStream );
+        }
+        else
+        {
+            success = false;
+        }
+    }
+
+    if ( success )
+    {
+        rw::streamConstructionFileParamW_t fileParam( path.c_str() );
+
+        rw::Stream *fileStream = engineInterface->CreateStream( rw::RWSTREAMTYPE_FILE_W, rw::RWSTREAMMODE_READONLY, &fileParam );
+
+        if ( rwtestCheck( fileStream != NULL, "could not open the block file" ) )
+        {
+            success &= CompareBlockReads( fileStream, "file", dataSize );
+
+            engineInterface->DeleteStream( fileStream );
+        }
+        else
+        {
+            success = false;
+        }
+    }
+
+    ctx.scratchRoot->Delete( "block_readahead.bin" );
+
+    return success;
+}
+
+RWTEST_REGISTER( "bench.block_readahead", RWTEST_BENCHMARK, bench_block_readahead );
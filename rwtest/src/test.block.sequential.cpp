@@ -0,0 +1,119 @@
+// Sequential serialization assembles every outermost block in memory and writes it in one go.
+// The output has to be the same as if the block headers were patched in the stream, and a block
+// that fails to be written must not reach the stream at all.
+
+#include "rwtest.h"
+
+#include <algorithm>
+
+static void WriteSequentialTestBlock( rw::BlockProvider& block, rw::uint32 level, bool failInside )
+{
+    block.EnterContext();
+
+    try
+    {
+        block.setBlockID( level == 2 ? rw::CHUNK_STRUCT : rw::CHUNK_EXTENSION );
+
+        block.writeUInt32( level );
+
+        if ( level < 2 )
+        {
+            for ( rw::uint32 n = 0; n < 3; n++ )
+            {
+                rw::BlockProvider childBlock( &block );
+
+                WriteSequentialTestBlock( childBlock, level + 1, failInside && n == 2 );
+            }
+        }
+        else if ( failInside )
+        {
+            throw rw::RwException( "test failure" );
+        }
+    }
+    catch( ... )
+    {
+        block.AbortContext();
+
+        throw;
+    }
+
+    block.LeaveContext();
+}
+
+static bool WriteSequentialTestData( rw::Interface *engineInterface, bool sequential, bool failInside, std::vector <char>& dataOut )
+{
+    rw::streamConstructionMemoryParam_t memParam( NULL, 0 );
+
+    rw::Stream *outputStream = engineInterface->CreateStream( rw::RWSTREAMTYPE_MEMORY, rw::RWSTREAMMODE_CREATE, &memParam );
+
+    if ( outputStream == NULL )
+        return false;
+
+    bool prevSequential = engineInterface->GetSequentialSerialization();
+
+    engineInterface->SetSequentialSerialization( sequential );
+
+    bool hasFailed = false;
+
+    try
+    {
+        // A block that was written before the failing one has to stay.
+        for ( rw::uint32 n = 0; n < 2; n++ )
+        {
+            rw::BlockProvider rootBlock( outputStream, rw::RWBLOCKMODE_WRITE, false );
+
+            WriteSequentialTestBlock( rootBlock, 0, failInside && n == 1 );
+        }
+    }
+    catch( rw::RwException& )
+    {
+        hasFailed = true;
+    }
+
+    engineInterface->SetSequentialSerialization( prevSequential );
+
+    dataOut.resize( (size_t)outputStream->size() );
+
+    outputStream->seek( 0, rw::RWSEEK_BEG );
+    outputStream->read( dataOut.data(), dataOut.size() );
+
+    engineInterface->DeleteStream( outputStream );
+
+    return ( hasFailed == failInside );
+}
+
+static bool test_sequential_serialization( rwtestContext& ctx )
+{
+    rw::Interface *engineInterface = ctx.engineInterface;
+
+    std::vector <char> seekedData, sequentialData, abortedData;
+
+    bool success = true;
+
+    success &= rwtestCheck( WriteSequentialTestData( engineInterface, false, false, seekedData ), "writing with seeks failed" );
+    success &= rwtestCheck( WriteSequentialTestData( engineInterface, true, false, sequentialData ), "sequential writing failed" );
+    success &= rwtestCheck( WriteSequentialTestData( engineInterface, true, true, abortedData ), "the failing block did not fail" );
+
+    if ( success )
+    {
+        success &= rwtestCheck( seekedData == sequentialData, "sequential output differs from the output with seeks" );
+
+        // Only the first root block may have been written.
+        size_t rootBlockSize = ( seekedData.size() / 2 );
+
+        success &= rwtestCheck(
+            abortedData.size() == rootBlockSize,
+            "%u bytes were written for the failed serialization instead of %u",
+            (rw::uint32)abortedData.size(), (rw::uint32)rootBlockSize
+        );
+
+        success &= rwtestCheck(
+            abortedData.size() <= seekedData.size() && std::equal( abortedData.begin(), abortedData.end(), seekedData.begin() ),
+            "the block in front of the failed one was changed"
+        );
+    }
+
+    return success;
+}
+
+RWTEST_REGISTER( "block.sequential_abort", RWTEST_REGRESSION, test_sequential_serialization );
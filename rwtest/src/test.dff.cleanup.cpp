@@ -0,0 +1,371 @@
+// Geometry::cleanUp merges duplicate vertices through a hash table.
+// It has to pick exactly the vertices that the old linear scan picked, which is kept here as the reference.
+
+#include "rwtest.h"
+
+#include <string.h>
+#include <limits>
+
+// Copy of the attributes of a synthetic mesh, so that the reference does not depend on the geometry.
+struct _cleanupMesh
+{
+    rw::uint32 flags;
+    rw::uint32 numUVs;
+    bool hasNightColors;
+    bool hasSkin;
+
+    std::vector <rw::float32> vertices;
+    std::vector <rw::float32> normals;
+    std::vector <rw::float32> texCoords[ 2 ];
+    std::vector <rw::uint8> vertexColors;
+    std::vector <rw::uint8> nightColors;
+    std::vector <rw::uint32> vertexBoneIndices;
+    std::vector <rw::float32> vertexBoneWeights;
+
+    std::vector <rw::uint32> indices;
+
+    rw::uint32 GetVertexCount( void ) const
+    {
+        return (rw::uint32)( this->vertices.size() / 3 );
+    }
+};
+
+static rw::float32 RandomComponent( rwtestRandom& random )
+{
+    rw::uint32 kind = random.NextBelow( 64 );
+
+    // Signed zeroes have to merge, NaNs never do.
+    if ( kind == 0 )
+        return 0.0f;
+
+    if ( kind == 1 )
+        return -0.0f;
+
+    if ( kind == 2 )
+        return std::numeric_limits <rw::float32>::quiet_NaN();
+
+    return ( (rw::float32)random.NextBelow( 2000 ) / 100.0f - 10.0f );
+}
+
+static void GenerateMesh( rw::uint32 seed, rw::uint32 vertexCount, bool allAttributes, _cleanupMesh& meshOut )
+{
+    rwtestRandom random( seed );
+
+    meshOut.flags = ( allAttributes ? ( rw::FLAGS_NORMALS | rw::FLAGS_TEXTURED2 | rw::FLAGS_PRELIT ) : rw::FLAGS_TEXTURED );
+    meshOut.numUVs = ( allAttributes ? 2 : 1 );
+    meshOut.hasNightColors = allAttributes;
+    meshOut.hasSkin = allAttributes;
+
+    for ( rw::uint32 n = 0; n < vertexCount; n++ )
+    {
+        // About half of the vertices repeat an earlier one, like the strips of PS2 meshes do.
+        bool isDuplicate = ( n != 0 && random.NextBelow( 2 ) == 0 );
+
+        rw::uint32 srcIndex = ( isDuplicate ? random.NextBelow( n ) : n );
+
+        // Sometimes only a single attribute differs from the earlier vertex.
+        rw::uint32 differingAttrib = ( isDuplicate && random.NextBelow( 4 ) == 0 ? random.NextBelow( 7 ) : 0xFFFFFFFF );
+
+        for ( rw::uint32 c = 0; c < 3; c++ )
+        {
+            rw::float32 value = ( isDuplicate && differingAttrib != 0 ? meshOut.vertices[ srcIndex * 3 + c ] : RandomComponent( random ) );
+
+            // -0 and +0 are the same vertex.
+            if ( isDuplicate && value == 0.0f && random.NextBelow( 2 ) == 0 )
+            {
+                value = -value;
+            }
+
+            meshOut.vertices.push_back( value );
+        }
+
+        if ( meshOut.flags & rw::FLAGS_NORMALS )
+        {
+            for ( rw::uint32 c = 0; c < 3; c++ )
+            {
+                meshOut.normals.push_back( isDuplicate && differingAttrib != 1 ? meshOut.normals[ srcIndex * 3 + c ] : RandomComponent( random ) );
+            }
+        }
+
+        for ( rw::uint32 uv = 0; uv < meshOut.numUVs; uv++ )
+        {
+            for ( rw::uint32 c = 0; c < 2; c++ )
+            {
+                meshOut.texCoords[ uv ].push_back( isDuplicate && differingAttrib != 2 + uv ? meshOut.texCoords[ uv ][ srcIndex * 2 + c ] : RandomComponent( random ) );
+            }
+        }
+
+        if ( meshOut.flags & rw::FLAGS_PRELIT )
+        {
+            for ( rw::uint32 c = 0; c < 4; c++ )
+            {
+                meshOut.vertexColors.push_back( isDuplicate && differingAttrib != 4 ? meshOut.vertexColors[ srcIndex * 4 + c ] : (rw::uint8)random.Next() );
+            }
+        }
+
+        if ( meshOut.hasNightColors )
+        {
+            for ( rw::uint32 c = 0; c < 4; c++ )
+            {
+                meshOut.nightColors.push_back( isDuplicate && differingAttrib != 5 ? meshOut.nightColors[ srcIndex * 4 + c ] : (rw::uint8)random.Next() );
+            }
+        }
+
+        if ( meshOut.hasSkin )
+        {
+            meshOut.vertexBoneIndices.push_back( isDuplicate && differingAttrib != 6 ? meshOut.vertexBoneIndices[ srcIndex ] : random.Next() );
+
+            for ( rw::uint32 c = 0; c < 4; c++ )
+            {
+                meshOut.vertexBoneWeights.push_back( isDuplicate && differingAttrib != 6 ? meshOut.vertexBoneWeights[ srcIndex * 4 + c ] : RandomComponent( random ) );
+            }
+        }
+    }
+
+    for ( rw::uint32 n = 0; n < vertexCount * 2; n++ )
+    {
+        meshOut.indices.push_back( random.NextBelow( vertexCount ) );
+    }
+}
+
+static void LoadMeshIntoGeometry( const _cleanupMesh& mesh, rw::Geometry& geom )
+{
+    geom.flags = mesh.flags;
+    geom.numUVs = mesh.numUVs;
+    geom.hasNightColors = mesh.hasNightColors;
+    geom.hasSkin = mesh.hasSkin;
+    geom.vertexCount = mesh.GetVertexCount();
+
+    geom.vertices = mesh.vertices;
+    geom.normals = mesh.normals;
+    geom.texCoords[ 0 ] = mesh.texCoords[ 0 ];
+    geom.texCoords[ 1 ] = mesh.texCoords[ 1 ];
+    geom.vertexColors = mesh.vertexColors;
+    geom.nightColors = mesh.nightColors;
+    geom.vertexBoneIndices = mesh.vertexBoneIndices;
+    geom.vertexBoneWeights = mesh.vertexBoneWeights;
+
+    rw::Split split;
+    split.matIndex = 0;
+    split.indices = mesh.indices;
+
+    geom.splits.clear();
+    geom.splits.push_back( std::move( split ) );
+}
+
+template <typename numberType>
+static inline bool AreAttribsEqual( const std::vector <numberType>& attribs, rw::uint32 left, rw::uint32 right, rw::uint32 stride )
+{
+    for ( rw::uint32 c = 0; c < stride; c++ )
+    {
+        if ( attribs[ left * stride + c ] != attribs[ right * stride + c ] )
+            return false;
+    }
+
+    return true;
+}
+
+static bool AreVerticesEqual( const _cleanupMesh& mesh, rw::uint32 left, rw::uint32 right )
+{
+    if ( !AreAttribsEqual( mesh.vertices, left, right, 3 ) )
+        return false;
+
+    if ( ( mesh.flags & rw::FLAGS_NORMALS ) && !AreAttribsEqual( mesh.normals, left, right, 3 ) )
+        return false;
+
+    for ( rw::uint32 uv = 0; uv < mesh.numUVs; uv++ )
+    {
+        if ( !AreAttribsEqual( mesh.texCoords[ uv ], left, right, 2 ) )
+            return false;
+    }
+
+    if ( ( mesh.flags & rw::FLAGS_PRELIT ) && !AreAttribsEqual( mesh.vertexColors, left, right, 4 ) )
+        return false;
+
+    if ( mesh.hasNightColors && !AreAttribsEqual( mesh.nightColors, left, right, 4 ) )
+        return false;
+
+    if ( mesh.hasSkin )
+    {
+        if ( mesh.vertexBoneIndices[ left ] != mesh.vertexBoneIndices[ right ] )
+            return false;
+
+        if ( !AreAttribsEqual( mesh.vertexBoneWeights, left, right, 4 ) )
+            return false;
+    }
+
+    return true;
+}
+
+// The old algorithm: compare every vertex against all vertices that were kept so far.
+static void ReferenceCleanUp( const _cleanupMesh& mesh, std::vector <rw::uint32>& keptOut, std::vector <rw::uint32>& newIndicesOut )
+{
+    rw::uint32 vertexCount = mesh.GetVertexCount();
+
+    for ( rw::uint32 n = 0; n < vertexCount; n++ )
+    {
+        rw::uint32 newIndex = (rw::uint32)keptOut.size();
+
+        for ( rw::uint32 k = 0; k < (rw::uint32)keptOut.size(); k++ )
+        {
+            if ( AreVerticesEqual( mesh, keptOut[ k ], n ) )
+            {
+                newIndex = k;
+                break;
+            }
+        }
+
+        if ( newIndex == keptOut.size() )
+        {
+            keptOut.push_back( n );
+        }
+
+        newIndicesOut.push_back( newIndex );
+    }
+}
+
+template <typename numberType>
+static inline bool IsKeptAttrib(
+    const std::vector <numberType>& result, const std::vector <numberType>& source,
+    const std::vector <rw::uint32>& kept, rw::uint32 stride
+)
+{
+    if ( result.size() != kept.size() * stride )
+        return false;
+
+    // The first occurrence is kept, bit for bit.
+    for ( size_t k = 0; k < kept.size(); k++ )
+    {
+        if ( memcmp( &result[ k * stride ], &source[ kept[ k ] * stride ], sizeof( numberType ) * stride ) != 0 )
+            return false;
+    }
+
+    return true;
+}
+
+static bool CheckCleanUp( rw::Interface *engineInterface, rw::uint32 seed, rw::uint32 vertexCount, bool allAttributes )
+{
+    _cleanupMesh mesh;
+
+    GenerateMesh( seed, vertexCount, allAttributes, mesh );
+
+    std::vector <rw::uint32> kept;
+    std::vector <rw::uint32> newIndices;
+
+    ReferenceCleanUp( mesh, kept, newIndices );
+
+    rw::Geometry geom( engineInterface, NULL );
+
+    LoadMeshIntoGeometry( mesh, geom );
+
+    geom.cleanUp();
+
+    bool success = true;
+
+    success &= rwtestCheck( geom.vertices.size() == kept.size() * 3, "mesh %u/%u: %u vertices kept, expected %u", seed, vertexCount, (rw::uint32)( geom.vertices.size() / 3 ), (rw::uint32)kept.size() );
+
+    if ( !success )
+        return false;
+
+    success &= rwtestCheck( IsKeptAttrib( geom.vertices, mesh.vertices, kept, 3 ), "mesh %u/%u: positions differ", seed, vertexCount );
+
+    if ( mesh.flags & rw::FLAGS_NORMALS )
+    {
+        success &= rwtestCheck( IsKeptAttrib( geom.normals, mesh.normals, kept, 3 ), "mesh %u/%u: normals differ", seed, vertexCount );
+    }
+
+    for ( rw::uint32 uv = 0; uv < mesh.numUVs; uv++ )
+    {
+        success &= rwtestCheck( IsKeptAttrib( geom.texCoords[ uv ], mesh.texCoords[ uv ], kept, 2 ), "mesh %u/%u: UV set %u differs", seed, vertexCount, uv );
+    }
+
+    if ( mesh.flags & rw::FLAGS_PRELIT )
+    {
+        success &= rwtestCheck( IsKeptAttrib( geom.vertexColors, mesh.vertexColors, kept, 4 ), "mesh %u/%u: prelit colors differ", seed, vertexCount );
+    }
+
+    if ( mesh.hasNightColors )
+    {
+        success &= rwtestCheck( IsKeptAttrib( geom.nightColors, mesh.nightColors, kept, 4 ), "mesh %u/%u: night colors differ", seed, vertexCount );
+    }
+
+    if ( mesh.hasSkin )
+    {
+        success &= rwtestCheck( IsKeptAttrib( geom.vertexBoneIndices, mesh.vertexBoneIndices, kept, 1 ), "mesh %u/%u: bone indices differ", seed, vertexCount );
+        success &= rwtestCheck( IsKeptAttrib( geom.vertexBoneWeights, mesh.vertexBoneWeights, kept, 4 ), "mesh %u/%u: bone weights differ", seed, vertexCount );
+    }
+
+    const std::vector <rw::uint32>& resultIndices = geom.splits[ 0 ].indices;
+
+    for ( size_t n = 0; n < mesh.indices.size(); n++ )
+    {
+        if ( resultIndices[ n ] != newIndices[ mesh.indices[ n ] ] )
+        {
+            success &= rwtestCheck( false, "mesh %u/%u: split index %u differs", seed, vertexCount, (rw::uint32)n );
+            break;
+        }
+    }
+
+    return success;
+}
+
+static bool test_cleanup_equivalence( rwtestContext& ctx )
+{
+    static const rw::uint32 vertexCounts[] = { 1, 2, 7, 64, 1000, 5000 };
+
+    bool success = true;
+
+    rw::uint32 seed = 1;
+
+    for ( rw::uint32 vertexCount : vertexCounts )
+    {
+        for ( rw::uint32 variation = 0; variation < 4; variation++ )
+        {
+            success &= CheckCleanUp( ctx.engineInterface, seed++, vertexCount, ( variation % 2 == 0 ) );
+        }
+    }
+
+    return success;
+}
+
+RWTEST_REGISTER( "dff.cleanup_equivalence", RWTEST_REGRESSION, test_cleanup_equivalence );
+
+static bool bench_cleanup( rwtestContext& ctx )
+{
+    static const rw::uint32 vertexCounts[] = { 1000, 10000, 30000, 60000 };
+
+    for ( rw::uint32 vertexCount : vertexCounts )
+    {
+        _cleanupMesh mesh;
+
+        GenerateMesh( vertexCount, vertexCount, true, mesh );
+
+        double startTime = rwtestGetTime();
+
+        std::vector <rw::uint32> kept;
+        std::vector <rw::uint32> newIndices;
+
+        ReferenceCleanUp( mesh, kept, newIndices );
+
+        double linearTime = ( rwtestGetTime() - startTime );
+
+        rw::Geometry geom( ctx.engineInterface, NULL );
+
+        LoadMeshIntoGeometry( mesh, geom );
+
+        startTime = rwtestGetTime();
+
+        geom.cleanUp();
+
+        double hashedTime = ( rwtestGetTime() - startTime );
+
+        rwtestLog(
+            "  %6u vertices (%u unique): linear scan %.2f ms, cleanUp %.2f ms",
+            vertexCount, (rw::uint32)kept.size(), linearTime * 1000.0, hashedTime * 1000.0
+        );
+    }
+
+    return true;
+}
+
+RWTEST_REGISTER( "bench.dff_cleanup", RWTEST_BENCHMARK, bench_cleanup );
@@ -0,0 +1,452 @@
+// Tests of the 64bit file offsets in the rwlib streams and the FileSystem streams.
+// The files are sparse, so the data beyond 4GB does not actually take up disk space.
+// A texture dictionary behind the hole checks that the block offsets are 64bit too.
+
+#include "rwtest.h"
+
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <winioctl.h>
+#endif //_WIN32
+
+// Offset of the marker; above 4GB and not aligned to anything.
+static const rw::int64 _sparseMarkerOffset = ( ( (rw::int64)5 << 30 ) + 4099 );
+
+static const char _sparseMarker[] = "rwtest >4GB marker";
+
+// Creates an empty file that the file system does not fill with zeroes when it grows.
+static bool CreateSparseFile( const std::wstring& path )
+{
+#ifdef _WIN32
+    HANDLE fileHandle = CreateFileW( path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL );
+
+    if ( fileHandle == INVALID_HANDLE_VALUE )
+        return false;
+
+    DWORD bytesReturned = 0;
+
+    BOOL isSparse = DeviceIoControl( fileHandle, FSCTL_SET_SPARSE, NULL, 0, NULL, 0, &bytesReturned, NULL );
+
+    CloseHandle( fileHandle );
+
+    return ( isSparse == TRUE );
+#else
+    // Files on POSIX systems are sparse by default.
+    FILE *file = fopen( filePath( path.c_str() ).convert_ansi().c_str(), "wb" );
+
+    if ( file == NULL )
+        return false;
+
+    fclose( file );
+    return true;
+#endif //_WIN32
+}
+
+static bool test_sparse_rwstream( rwtestContext& ctx )
+{
+    rw::Interface *engineInterface = ctx.engineInterface;
+
+    std::wstring path = ctx.GetScratchPath( "sparse_rwstream.bin" );
+
+    if ( !rwtestCheck( CreateSparseFile( path ), "could not create a sparse file" ) )
+        return false;
+
+    bool success = true;
+
+    rw::int64 markerEnd = ( _sparseMarkerOffset + sizeof( _sparseMarker ) );
+
+    // Write the marker behind the 4GB boundary.
+    {
+        rw::streamConstructionFileParamW_t fileParam( path.c_str() );
+
+        rw::Stream *stream = engineInterface->CreateStream( rw::RWSTREAMTYPE_FILE_W, rw::RWSTREAMMODE_READWRITE, &fileParam );
+
+        if ( !rwtestCheck( stream != NULL, "could not open the sparse file for writing" ) )
+            return false;
+
+        stream->seek( _sparseMarkerOffset, rw::RWSEEK_BEG );
+
+        success &= rwtestCheck( stream->tell() == _sparseMarkerOffset, "tell after seek is %lld", (long long)stream->tell() );
+
+        success &= rwtestCheck( stream->write( _sparseMarker, sizeof( _sparseMarker ) ) == sizeof( _sparseMarker ), "marker write failed" );
+
+        success &= rwtestCheck( stream->tell() == markerEnd, "tell after write is %lld", (long long)stream->tell() );
+
+        engineInterface->DeleteStream( stream );
+    }
+
+    // Read it back through a new stream.
+    {
+        rw::streamConstructionFileParamW_t fileParam( path.c_str() );
+
+        rw::Stream *stream = engineInterface->CreateStream( rw::RWSTREAMTYPE_FILE_W, rw::RWSTREAMMODE_READONLY, &fileParam );
+
+        if ( !rwtestCheck( stream != NULL, "could not open the sparse file for reading" ) )
+            return false;
+
+        success &= rwtestCheck( stream->size() == markerEnd, "size is %lld", (long long)stream->size() );
+
+        // Seek relative to the end, so the offset has to be added with 64bit precision.
+        stream->seek( -(rw::int64)sizeof( _sparseMarker ), rw::RWSEEK_END );
+
+        success &= rwtestCheck( stream->tell() == _sparseMarkerOffset, "tell after seek from end is %lld", (long long)stream->tell() );
+
+        char readBuf[ sizeof( _sparseMarker ) ];
+
+        success &= rwtestCheck( stream->read( readBuf, sizeof( readBuf ) ) == sizeof( readBuf ), "marker read failed" );
+        success &= rwtestCheck( memcmp( readBuf, _sparseMarker, sizeof( readBuf ) ) == 0, "marker does not match" );
+
+        // Skip back across the 4GB boundary and read the zeroes in front of it.
+        stream->seek( ( (rw::int64)4 << 30 ) - 2, rw::RWSEEK_BEG );
+        stream->skip( 1 );
+
+        success &= rwtestCheck( stream->tell() == ( ( (rw::int64)4 << 30 ) - 1 ), "tell after skip is %lld", (long long)stream->tell() );
+
+        char zeroes[ 2 ] = { 1, 1 };
+
+        success &= rwtestCheck( stream->read( zeroes, sizeof( zeroes ) ) == sizeof( zeroes ) && zeroes[ 0 ] == 0 && zeroes[ 1 ] == 0, "sparse hole is not zero" );
+
+        engineInterface->DeleteStream( stream );
+    }
+
+    ctx.scratchRoot->Delete( "sparse_rwstream.bin" );
+
+    return success;
+}
+
+RWTEST_REGISTER( "file.sparse_4gb_rwstream", RWTEST_REGRESSION, test_sparse_rwstream );
+
+static bool test_sparse_cfile( rwtestContext& ctx )
+{
+    std::wstring path = ctx.GetScratchPath( "sparse_cfile.bin" );
+
+    if ( !rwtestCheck( CreateSparseFile( path ), "could not create a sparse file" ) )
+        return false;
+
+    bool success = true;
+
+    fsOffsetNumber_t markerEnd = ( _sparseMarkerOffset + sizeof( _sparseMarker ) );
+
+    {
+        CFile *file = ctx.scratchRoot->Open( "sparse_cfile.bin", "rb+" );
+
+        if ( !rwtestCheck( file != NULL, "could not open the sparse file for writing" ) )
+            return false;
+
+        success &= rwtestCheck( file->SeekNative( _sparseMarkerOffset, SEEK_SET ) == 0, "SeekNative failed" );
+        success &= rwtestCheck( file->TellNative() == _sparseMarkerOffset, "TellNative after seek is %lld", (long long)file->TellNative() );
+
+        success &= rwtestCheck( file->Write( _sparseMarker, 1, sizeof( _sparseMarker ) ) == sizeof( _sparseMarker ), "marker write failed" );
+
+        file->Flush();
+
+        success &= rwtestCheck( file->GetSizeNative() == markerEnd, "GetSizeNative is %lld", (long long)file->GetSizeNative() );
+
+        delete file;
+    }
+
+    {
+        CFile *file = ctx.scratchRoot->Open( "sparse_cfile.bin", "rb" );
+
+        if ( !rwtestCheck( file != NULL, "could not open the sparse file for reading" ) )
+            return false;
+
+        // Buffered and raw streams both have to base SEEK_END on the 64bit size.
+        success &= rwtestCheck( file->Seek( -(long)sizeof( _sparseMarker ), SEEK_END ) == 0, "Seek from end failed" );
+        success &= rwtestCheck( file->TellNative() == _sparseMarkerOffset, "TellNative after seek from end is %lld", (long long)file->TellNative() );
+
+        char readBuf[ sizeof( _sparseMarker ) ];
+
+        success &= rwtestCheck( file->Read( readBuf, 1, sizeof( readBuf ) ) == sizeof( readBuf ), "marker read failed" );
+        success &= rwtestCheck( memcmp( readBuf, _sparseMarker, sizeof( readBuf ) ) == 0, "marker does not match" );
+
+        delete file;
+    }
+
+    ctx.scratchRoot->Delete( "sparse_cfile.bin" );
+
+    return success;
+}
+
+RWTEST_REGISTER( "file.sparse_4gb_cfile", RWTEST_REGRESSION, test_sparse_cfile );
+
+// Offset of the texture dictionary; also above 4GB and unaligned, but apart from the marker.
+static const rw::int64 _sparseTXDOffset = ( ( (rw::int64)6 << 30 ) + 517 );
+
+static const rw::uint32 _sparseTXDSizes[][2] =
+{
+    { 16, 16 }, { 32, 8 }, { 64, 64 }
+};
+
+struct _sparseTexture
+{
+    std::string name;
+    rw::uint32 width, height;
+    std::vector <rw::uint8> texels;
+};
+
+static void GetSparseTextureTexels( rw::Raster *raster, _sparseTexture& texOut )
+{
+    raster->getSize( texOut.width, texOut.height );
+
+    rw::Bitmap bitmap = raster->getBitmap();
+
+    const rw::uint8 *texels = (const rw::uint8*)bitmap.getTexelsData();
+
+    texOut.texels.assign( texels, texels + bitmap.getDataSize() );
+}
+
+// Creates a dictionary of Direct3D9 textures with random texels.
+static rw::TexDictionary* CreateSparseTXD( rw::Interface *engineInterface, std::vector <_sparseTexture>& texturesOut )
+{
+    rw::TexDictionary *txd = rw::CreateTexDictionary( engineInterface );
+
+    if ( txd == NULL )
+        return NULL;
+
+    rwtestRandom random( 0x46B );
+
+    rw::uint32 texIndex = 0;
+
+    for ( const auto& size : _sparseTXDSizes )
+    {
+        rw::Bitmap bitmap( engineInterface, 32, rw::RASTER_8888, rw::COLOR_RGBA );
+
+        bitmap.setSize( size[ 0 ], size[ 1 ] );
+
+        rw::uint8 *texels = (rw::uint8*)bitmap.getTexelsData();
+
+        for ( rw::uint32 n = 0; n < bitmap.getDataSize(); n++ )
+        {
+            texels[ n ] = (rw::uint8)random.Next();
+        }
+
+        rw::Raster *raster = rw::CreateRaster( engineInterface );
+
+        if ( raster == NULL )
+        {
+            engineInterface->DeleteRwObject( txd );
+            return NULL;
+        }
+
+        rw::TextureBase *texture = NULL;
+
+        try
+        {
+            raster->newNativeData( "Direct3D9" );
+            raster->setImageData( bitmap );
+
+            texture = rw::CreateTexture( engineInterface, raster );
+        }
+        catch( rw::RwException& except )
+        {
+            rwtestLog( "  could not create a texture: %s", except.message.c_str() );
+        }
+
+        if ( texture == NULL )
+        {
+            rw::DeleteRaster( raster );
+
+            engineInterface->DeleteRwObject( txd );
+            return NULL;
+        }
+
+        _sparseTexture expected;
+        expected.name = "sparse_tex" + std::to_string( texIndex++ );
+
+        GetSparseTextureTexels( raster, expected );
+
+        rw::DeleteRaster( raster );
+
+        texture->SetName( expected.name.c_str() );
+        texture->AddToDictionary( txd );
+
+        texturesOut.push_back( std::move( expected ) );
+    }
+
+    return txd;
+}
+
+static bool test_sparse_txd( rwtestContext& ctx )
+{
+    rw::Interface *engineInterface = ctx.engineInterface;
+
+    std::wstring path = ctx.GetScratchPath( "sparse_txd.bin" );
+
+    if ( !rwtestCheck( CreateSparseFile( path ), "could not create a sparse file" ) )
+        return false;
+
+    std::vector <_sparseTexture> expectedTextures;
+
+    rw::TexDictionary *txd = CreateSparseTXD( engineInterface, expectedTextures );
+
+    if ( !rwtestCheck( txd != NULL, "could not create the texture dictionary" ) )
+        return false;
+
+    bool success = true;
+
+    rw::int64 txdEnd = -1;
+
+    // Write the dictionary behind the hole.
+    {
+        rw::streamConstructionFileParamW_t fileParam( path.c_str() );
+
+        rw::Stream *stream = engineInterface->CreateStream( rw::RWSTREAMTYPE_FILE_W, rw::RWSTREAMMODE_READWRITE, &fileParam );
+
+        if ( rwtestCheck( stream != NULL, "could not open the sparse file for writing" ) )
+        {
+            try
+            {
+                stream->seek( _sparseTXDOffset, rw::RWSEEK_BEG );
+
+                engineInterface->Serialize( txd, stream );
+
+                txdEnd = stream->tell();
+            }
+            catch( rw::RwException& except )
+            {
+                success = rwtestCheck( false, "could not serialize the texture dictionary: %s", except.message.c_str() );
+            }
+
+            engineInterface->DeleteStream( stream );
+        }
+        else
+        {
+            success = false;
+        }
+    }
+
+    engineInterface->DeleteRwObject( txd );
+
+    if ( success )
+    {
+        rw::streamConstructionFileParamW_t fileParam( path.c_str() );
+
+        rw::Stream *stream = engineInterface->CreateStream( rw::RWSTREAMTYPE_FILE_W, rw::RWSTREAMMODE_READONLY, &fileParam );
+
+        if ( !rwtestCheck( stream != NULL, "could not open the sparse file for reading" ) )
+            return false;
+
+        success &= rwtestCheck( stream->size() == txdEnd, "size is %lld instead of %lld", (long long)stream->size(), (long long)txdEnd );
+
+        try
+        {
+            // The block offsets have to be absolute 64bit offsets of the stream.
+            stream->seek( _sparseTXDOffset, rw::RWSEEK_BEG );
+            {
+                rw::BlockProvider rootBlock( stream, rw::RWBLOCKMODE_READ, false );
+
+                rootBlock.EnterContext();
+
+                try
+                {
+                    rw::int64 dataOffset = ( _sparseTXDOffset + 12 );
+
+                    success &= rwtestCheck( rootBlock.getBlockID() == rw::CHUNK_TEXDICTIONARY, "the root block is 0x%x", rootBlock.getBlockID() );
+                    success &= rwtestCheck( rootBlock.tell_absolute() == dataOffset, "tell_absolute at the block start is %lld", (long long)rootBlock.tell_absolute() );
+
+                    success &= rwtestCheck(
+                        dataOffset + rootBlock.getBlockLength() == txdEnd,
+                        "the root block ends at %lld instead of %lld", (long long)( dataOffset + rootBlock.getBlockLength() ), (long long)txdEnd
+                    );
+
+                    rootBlock.skip( (size_t)rootBlock.getBlockLength() );
+
+                    success &= rwtestCheck( rootBlock.tell_absolute() == txdEnd, "tell_absolute at the block end is %lld", (long long)rootBlock.tell_absolute() );
+                }
+                catch( ... )
+                {
+                    rootBlock.LeaveContext();
+
+                    throw;
+                }
+
+                rootBlock.LeaveContext();
+            }
+
+            // Parse the whole dictionary from there.
+            stream->seek( _sparseTXDOffset, rw::RWSEEK_BEG );
+
+            rw::RwObject *rwObj = engineInterface->Deserialize( stream );
+
+            success &= rwtestCheck( stream->tell() == txdEnd, "reading ended at %lld", (long long)stream->tell() );
+
+            rw::TexDictionary *readTXD = ( rwObj ? rw::ToTexDictionary( engineInterface, rwObj ) : NULL );
+
+            if ( rwtestCheck( readTXD != NULL, "could not read the texture dictionary" ) )
+            {
+                success &= rwtestCheck(
+                    readTXD->GetTextureCount() == expectedTextures.size(),
+                    "%u textures were read instead of %u", readTXD->GetTextureCount(), (rw::uint32)expectedTextures.size()
+                );
+
+                for ( rw::TexDictionary::texIter_t iter( readTXD->GetTextureIterator() ); !iter.IsEnd(); iter.Increment() )
+                {
+                    rw::TextureBase *texture = iter.Resolve();
+
+                    const std::string& texName = texture->GetName();
+
+                    const _sparseTexture *expected = NULL;
+
+                    for ( const _sparseTexture& candidate : expectedTextures )
+                    {
+                        if ( candidate.name == texName )
+                        {
+                            expected = &candidate;
+                            break;
+                        }
+                    }
+
+                    if ( !rwtestCheck( expected != NULL, "unexpected texture %s", texName.c_str() ) )
+                    {
+                        success = false;
+                        continue;
+                    }
+
+                    rw::Raster *raster = texture->GetRaster();
+
+                    if ( !rwtestCheck( raster != NULL, "%s has no raster", texName.c_str() ) )
+                    {
+                        success = false;
+                        continue;
+                    }
+
+                    _sparseTexture readTexture;
+
+                    GetSparseTextureTexels( raster, readTexture );
+
+                    success &= rwtestCheck(
+                        readTexture.width == expected->width && readTexture.height == expected->height,
+                        "%s is %ux%u instead of %ux%u", texName.c_str(), readTexture.width, readTexture.height, expected->width, expected->height
+                    );
+
+                    success &= rwtestCheck( readTexture.texels == expected->texels, "%s has different texels", texName.c_str() );
+                }
+            }
+            else
+            {
+                success = false;
+            }
+
+            if ( rwObj )
+            {
+                engineInterface->DeleteRwObject( rwObj );
+            }
+        }
+        catch( rw::RwException& except )
+        {
+            success = rwtestCheck( false, "could not read the texture dictionary: %s", except.message.c_str() );
+        }
+
+        engineInterface->DeleteStream( stream );
+    }
+
+    ctx.scratchRoot->Delete( "sparse_txd.bin" );
+
+    return success;
+}
+
+RWTEST_REGISTER( "file.sparse_4gb_txd", RWTEST_REGRESSION, test_sparse_txd );
@@ -0,0 +1,1076 @@
+// Tests of the GameCube tile transcoding.
+// Native surfaces that are made of whole tiles are decoded, encoded and transformed tile row by tile row.
+// The result has to be the same as looking up the tiled coordinate of every single texel through
+// GCProcessTiledCoordsFromLinear, which is how the texels were moved before.
+
+#include "rwtest.internal.h"
+
+#ifdef RWLIB_INCLUDE_NATIVETEX_GAMECUBE
+
+#include "../../rwlib/src/txdread.gc.hxx"
+
+#include "../../rwlib/src/txdread.gc.miptrans.hxx"
+
+#include <string.h>
+
+struct gcTileTestFormat
+{
+    rw::eGCNativeTextureFormat format;
+    const char *name;
+};
+
+static const gcTileTestFormat _gcTileTestFormats[] =
+{
+    { rw::GVRFMT_LUM_4BIT, "lum4" },
+    { rw::GVRFMT_LUM_8BIT, "lum8" },
+    { rw::GVRFMT_LUM_4BIT_ALPHA, "lum4_alpha" },
+    { rw::GVRFMT_LUM_8BIT_ALPHA, "lum8_alpha" },
+    { rw::GVRFMT_RGB565, "rgb565" },
+    { rw::GVRFMT_RGB5A3, "rgb5a3" },
+    { rw::GVRFMT_RGBA8888, "rgba8888" },
+    { rw::GVRFMT_PAL_4BIT, "pal4" },
+    { rw::GVRFMT_PAL_8BIT, "pal8" },
+    { rw::GVRFMT_CMP, "cmp" }
+};
+
+struct gcTileTestSize
+{
+    rw::uint32 width, height;
+};
+
+// Multiples of 8 are whole tiles in every format.
+static const gcTileTestSize _gcTileAlignedSizes[] =
+{
+    { 8, 8 }, { 16, 8 }, { 8, 32 }, { 40, 24 }, { 64, 64 }
+};
+
+// Layers that only cover a part of their last tiles. The native surfaces around them are still whole tiles.
+static const gcTileTestSize _gcTileUnalignedSizes[] =
+{
+    { 1, 1 }, { 3, 5 }, { 13, 7 }, { 37, 21 }, { 100, 3 }, { 2, 90 }
+};
+
+static const rw::uint32 _gcTileFrameworkRowAlignment = 4;
+
+static const unsigned int _gcTileRandomIndexListCount = 100000;
+
+static const rw::uint32 _gcTileBenchSize = 512;
+static const unsigned int _gcTileBenchRepeatCount = 4;
+
+typedef rw::dxt1_block <rw::endian::little_endian> gcTileFrameworkBlock;
+
+static const char* GetGCTileFormatName( rw::eGCNativeTextureFormat format )
+{
+    for ( const gcTileTestFormat& info : _gcTileTestFormats )
+    {
+        if ( info.format == format )
+        {
+            return info.name;
+        }
+    }
+
+    return "unknown";
+}
+
+static bool IsGCTilePaletteFormat( rw::eGCNativeTextureFormat format )
+{
+    return ( format == rw::GVRFMT_PAL_4BIT || format == rw::GVRFMT_PAL_8BIT );
+}
+
+// How the texels of a GC format are stored on the native surface.
+struct gcTileSurfaceInfo
+{
+    rw::uint32 depth;
+    rw::uint32 clusterWidth, clusterHeight, clusterCount;
+    bool isSwizzled;
+};
+
+static gcTileSurfaceInfo GetGCTileSurfaceInfo( rw::eGCNativeTextureFormat format )
+{
+    gcTileSurfaceInfo info;
+
+    info.depth = rw::getGCInternalFormatDepth( format );
+    info.isSwizzled = rw::isGVRNativeFormatSwizzled( format );
+
+    rw::getGVRNativeFormatClusterDimensions( info.depth, info.clusterWidth, info.clusterHeight, info.clusterCount );
+
+    return info;
+}
+
+// The framework format that a GC format is decoded into.
+struct gcTileFrameworkFormat
+{
+    rw::eRasterFormat rasterFormat;
+    rw::uint32 depth;
+    rw::eColorOrdering colorOrder;
+    rw::ePaletteType paletteType;
+    rw::eCompressionType compressionType;
+};
+
+static gcTileFrameworkFormat GetGCTileFrameworkFormat( rw::eGCNativeTextureFormat format )
+{
+    gcTileFrameworkFormat fwFormat;
+
+    rw::getRecommendedGCNativeTextureRasterFormat(
+        format, rw::GVRPIX_RGB565,
+        fwFormat.rasterFormat, fwFormat.depth, fwFormat.colorOrder, fwFormat.paletteType,
+        fwFormat.compressionType
+    );
+
+    return fwFormat;
+}
+
+// Native surfaces are made of whole tiles, which are 2x2 DXT1 blocks for CMP.
+static void GetGCTileNativeSurface(
+    rw::eGCNativeTextureFormat format, rw::uint32 layerWidth, rw::uint32 layerHeight,
+    rw::uint32& surfWidthOut, rw::uint32& surfHeightOut, rw::uint32& dataSizeOut
+)
+{
+    if ( format == rw::GVRFMT_CMP )
+    {
+        surfWidthOut = ALIGN_SIZE( layerWidth, 8u );
+        surfHeightOut = ALIGN_SIZE( layerHeight, 8u );
+
+        dataSizeOut = ( ( surfWidthOut / 4 ) * ( surfHeightOut / 4 ) * (rw::uint32)sizeof( rw::gc_dxt1_block ) );
+        return;
+    }
+
+    gcTileSurfaceInfo info = GetGCTileSurfaceInfo( format );
+
+    surfWidthOut = ALIGN_SIZE( layerWidth, info.clusterWidth );
+    surfHeightOut = ALIGN_SIZE( layerHeight, info.clusterHeight );
+
+    dataSizeOut = rw::getRasterDataSizeByRowSize( rw::getGCRasterDataRowSize( surfWidthOut, info.depth ), surfHeightOut );
+}
+
+static void GetGCTileFrameworkSurface(
+    rw::eGCNativeTextureFormat format, rw::uint32 layerWidth, rw::uint32 layerHeight,
+    rw::uint32& surfWidthOut, rw::uint32& surfHeightOut, rw::uint32& dataSizeOut
+)
+{
+    if ( format == rw::GVRFMT_CMP )
+    {
+        surfWidthOut = ALIGN_SIZE( layerWidth, 4u );
+        surfHeightOut = ALIGN_SIZE( layerHeight, 4u );
+
+        dataSizeOut = ( ( surfWidthOut / 4 ) * ( surfHeightOut / 4 ) * (rw::uint32)sizeof( gcTileFrameworkBlock ) );
+        return;
+    }
+
+    gcTileFrameworkFormat fwFormat = GetGCTileFrameworkFormat( format );
+
+    surfWidthOut = layerWidth;
+    surfHeightOut = layerHeight;
+
+    dataSizeOut = rw::getRasterDataSizeByRowSize( rw::getRasterDataRowSize( layerWidth, fwFormat.depth, _gcTileFrameworkRowAlignment ), layerHeight );
+}
+
+static void FillGCTileTestData( std::vector <rw::uint8>& data, rw::uint32 seed )
+{
+    rwtestRandom random( seed );
+
+    for ( rw::uint8& value : data )
+    {
+        value = (rw::uint8)random.Next();
+    }
+}
+
+// Reads the item at index from a row, without the other half of the byte for 4bit items.
+static rw::uint32 GetGCTileTestItem( const void *row, rw::uint32 index, rw::uint32 itemDepth, bool isLSBNibble )
+{
+    if ( itemDepth == 4 )
+    {
+        rw::uint8 value;
+
+        if ( isLSBNibble )
+        {
+            ( (const rw::PixelFormat::palette4bit_lsb*)row )->getvalue( index, value );
+        }
+        else
+        {
+            ( (const rw::PixelFormat::palette4bit*)row )->getvalue( index, value );
+        }
+
+        return value;
+    }
+
+    rw::uint32 itemSize = ( itemDepth / 8 );
+
+    rw::uint32 value = 0;
+
+    memcpy( &value, (const rw::uint8*)row + index * itemSize, itemSize );
+
+    return value;
+}
+
+// Mirrors a 4x4 DXT1 index list along both axis, texel by texel.
+static rw::uint32 ReferenceInverseIndexList( rw::uint32 srcIndexList )
+{
+    rw::uint32 dstIndexList = 0;
+
+    for ( rw::uint32 local_y = 0; local_y < 4; local_y++ )
+    {
+        for ( rw::uint32 local_x = 0; local_x < 4; local_x++ )
+        {
+            rw::uint32 item = rw::fetchDXTIndexList( srcIndexList, local_x, local_y );
+
+            rw::putDXTIndexList( dstIndexList, 3 - local_x, 3 - local_y, item );
+        }
+    }
+
+    return dstIndexList;
+}
+
+template <typename dstBlockType, typename srcBlockType>
+static void ReferenceCopyDXT1Block( dstBlockType& dstBlock, const srcBlockType& srcBlock )
+{
+    dstBlock.col0 = srcBlock.col0;
+    dstBlock.col1 = srcBlock.col1;
+    dstBlock.indexList = ReferenceInverseIndexList( srcBlock.indexList );
+}
+
+template <typename blockType>
+static void ReferenceClearDXT1Block( blockType& dstBlock )
+{
+    rw::rgb565 clearColor;
+    clearColor.val = 0;
+
+    dstBlock.col0 = clearColor;
+    dstBlock.col1 = clearColor;
+    dstBlock.indexList = 0;
+}
+
+static std::vector <rw::uint8> ReferenceGCDecode(
+    rw::eGCNativeTextureFormat format, const std::vector <rw::uint8>& nativeTexels,
+    rw::uint32 mipWidth, rw::uint32 mipHeight, rw::uint32 layerWidth, rw::uint32 layerHeight,
+    rw::uint32 paletteSize
+)
+{
+    rw::uint32 fwWidth, fwHeight, fwDataSize;
+    GetGCTileFrameworkSurface( format, layerWidth, layerHeight, fwWidth, fwHeight, fwDataSize );
+
+    std::vector <rw::uint8> fwTexels( fwDataSize );
+
+    if ( format == rw::GVRFMT_CMP )
+    {
+        rw::uint32 gcBlocksWidth = ( mipWidth / 4 );
+        rw::uint32 gcBlocksHeight = ( mipHeight / 4 );
+
+        rw::uint32 dxtBlocksWidth = ( fwWidth / 4 );
+        rw::uint32 dxtBlocksHeight = ( fwHeight / 4 );
+
+        const rw::gc_dxt1_block *gcBlocks = (const rw::gc_dxt1_block*)nativeTexels.data();
+        gcTileFrameworkBlock *dstBlocks = (gcTileFrameworkBlock*)fwTexels.data();
+
+        for ( rw::uint32 block_y = 0; block_y < dxtBlocksHeight; block_y++ )
+        {
+            for ( rw::uint32 block_x = 0; block_x < dxtBlocksWidth; block_x++ )
+            {
+                auto copyBlock = [&]( rw::uint32 tiled_x, rw::uint32 tiled_y, rw::uint32 cluster_index )
+                {
+                    ReferenceCopyDXT1Block( dstBlocks[ block_x + block_y * dxtBlocksWidth ], gcBlocks[ tiled_x + tiled_y * gcBlocksWidth ] );
+                };
+
+                rw::GCProcessTiledCoordsFromLinear( block_x, block_y, gcBlocksWidth, gcBlocksHeight, 2, 2, 1, true, copyBlock );
+            }
+        }
+
+        return fwTexels;
+    }
+
+    gcTileSurfaceInfo info = GetGCTileSurfaceInfo( format );
+    gcTileFrameworkFormat fwFormat = GetGCTileFrameworkFormat( format );
+
+    rw::uint32 srcRowSize = rw::getGCRasterDataRowSize( mipWidth, info.depth );
+    rw::uint32 dstRowSize = rw::getRasterDataRowSize( layerWidth, fwFormat.depth, _gcTileFrameworkRowAlignment );
+
+    bool isPaletteFormat = IsGCTilePaletteFormat( format );
+
+    rw::gcColorDispatch srcDispatch( format, rw::GVRPIX_NO_PALETTE, rw::COLOR_RGBA, 0, rw::PALETTE_NONE, NULL, 0 );
+    rw::colorModelDispatcher dstDispatch( fwFormat.rasterFormat, fwFormat.colorOrder, fwFormat.depth, NULL, 0, rw::PALETTE_NONE );
+
+    auto keepColor = []( rw::abstractColorItem& colorItem ) {};
+
+    for ( rw::uint32 y = 0; y < layerHeight; y++ )
+    {
+        void *dstRow = rw::getTexelDataRow( fwTexels.data(), dstRowSize, y );
+
+        for ( rw::uint32 x = 0; x < layerWidth; x++ )
+        {
+            rw::abstractColorItem colorItem;
+
+            if ( !isPaletteFormat )
+            {
+                dstDispatch.setClearedColor( colorItem );
+            }
+
+            auto readTexel = [&]( rw::uint32 tiled_x, rw::uint32 tiled_y, rw::uint32 cluster_index )
+            {
+                const void *srcRow = rw::getConstTexelDataRow( nativeTexels.data(), srcRowSize, tiled_y );
+
+                if ( isPaletteFormat )
+                {
+                    rw::copyPaletteItemGeneric(
+                        srcRow, dstRow,
+                        tiled_x, info.depth, fwFormat.paletteType,
+                        x, fwFormat.depth, fwFormat.paletteType,
+                        paletteSize
+                    );
+                }
+                else
+                {
+                    rw::readGCNativeColor( srcRow, srcDispatch, tiled_x, cluster_index, keepColor, colorItem );
+                }
+            };
+
+            rw::GCProcessTiledCoordsFromLinear(
+                x, y, mipWidth, mipHeight,
+                info.clusterWidth, info.clusterHeight, info.clusterCount,
+                info.isSwizzled,
+                readTexel
+            );
+
+            if ( !isPaletteFormat )
+            {
+                dstDispatch.setColor( dstRow, x, colorItem );
+            }
+        }
+    }
+
+    return fwTexels;
+}
+
+static std::vector <rw::uint8> LibraryGCDecode(
+    rw::Interface *engineInterface,
+    rw::eGCNativeTextureFormat format, std::vector <rw::uint8>& nativeTexels,
+    rw::uint32 mipWidth, rw::uint32 mipHeight, rw::uint32 layerWidth, rw::uint32 layerHeight,
+    rw::uint32 paletteSize
+)
+{
+    gcTileFrameworkFormat fwFormat = GetGCTileFrameworkFormat( format );
+
+    rw::uint32 dstSurfWidth, dstSurfHeight;
+    void *dstTexels;
+    rw::uint32 dstDataSize;
+
+    rw::ConvertGCMipmapToRasterFormat(
+        engineInterface,
+        mipWidth, mipHeight, layerWidth, layerHeight, nativeTexels.data(), (rw::uint32)nativeTexels.size(),
+        format, rw::GVRPIX_RGB565,
+        fwFormat.paletteType, NULL, paletteSize,
+        fwFormat.rasterFormat, fwFormat.depth, _gcTileFrameworkRowAlignment, fwFormat.colorOrder,
+        fwFormat.compressionType,
+        dstSurfWidth, dstSurfHeight,
+        dstTexels, dstDataSize
+    );
+
+    std::vector <rw::uint8> fwTexels( (const rw::uint8*)dstTexels, (const rw::uint8*)dstTexels + dstDataSize );
+
+    engineInterface->PixelFree( dstTexels );
+
+    return fwTexels;
+}
+
+// Row padding of the decoded layer is not written, so only the texels are compared.
+static bool CompareGCDecoded(
+    rw::eGCNativeTextureFormat format, const std::vector <rw::uint8>& result, const std::vector <rw::uint8>& reference,
+    rw::uint32 layerWidth, rw::uint32 layerHeight
+)
+{
+    const char *formatName = GetGCTileFormatName( format );
+
+    if ( !rwtestCheck( result.size() == reference.size(), "%s, %ux%u: decoded %u bytes instead of %u", formatName, layerWidth, layerHeight, (rw::uint32)result.size(), (rw::uint32)reference.size() ) )
+        return false;
+
+    if ( format == rw::GVRFMT_CMP )
+    {
+        return rwtestCheck( result == reference, "%s, %ux%u: decoded blocks differ", formatName, layerWidth, layerHeight );
+    }
+
+    gcTileFrameworkFormat fwFormat = GetGCTileFrameworkFormat( format );
+
+    rw::uint32 rowSize = rw::getRasterDataRowSize( layerWidth, fwFormat.depth, _gcTileFrameworkRowAlignment );
+
+    bool isLSBNibble = ( fwFormat.paletteType == rw::PALETTE_4BIT_LSB );
+
+    for ( rw::uint32 y = 0; y < layerHeight; y++ )
+    {
+        const void *resultRow = rw::getConstTexelDataRow( result.data(), rowSize, y );
+        const void *referenceRow = rw::getConstTexelDataRow( reference.data(), rowSize, y );
+
+        for ( rw::uint32 x = 0; x < layerWidth; x++ )
+        {
+            rw::uint32 resultItem = GetGCTileTestItem( resultRow, x, fwFormat.depth, isLSBNibble );
+            rw::uint32 referenceItem = GetGCTileTestItem( referenceRow, x, fwFormat.depth, isLSBNibble );
+
+            if ( !rwtestCheck( resultItem == referenceItem, "%s, %ux%u: decoded texel ( %u, %u ) is 0x%X instead of 0x%X", formatName, layerWidth, layerHeight, x, y, resultItem, referenceItem ) )
+                return false;
+        }
+    }
+
+    return true;
+}
+
+static std::vector <rw::uint8> ReferenceGCEncode(
+    rw::eGCNativeTextureFormat format, const std::vector <rw::uint8>& fwTexels,
+    rw::uint32 layerWidth, rw::uint32 layerHeight,
+    rw::ePaletteType srcPaletteType, rw::uint32 paletteSize
+)
+{
+    rw::uint32 fwWidth, fwHeight, fwDataSize;
+    GetGCTileFrameworkSurface( format, layerWidth, layerHeight, fwWidth, fwHeight, fwDataSize );
+
+    rw::uint32 gcSurfWidth, gcSurfHeight, gcDataSize;
+    GetGCTileNativeSurface( format, layerWidth, layerHeight, gcSurfWidth, gcSurfHeight, gcDataSize );
+
+    std::vector <rw::uint8> gcTexels( gcDataSize );
+
+    if ( format == rw::GVRFMT_CMP )
+    {
+        rw::uint32 srcBlocksWidth = ( fwWidth / 4 );
+        rw::uint32 srcBlocksHeight = ( fwHeight / 4 );
+
+        rw::uint32 gcBlocksWidth = ( gcSurfWidth / 4 );
+        rw::uint32 gcBlocksHeight = ( gcSurfHeight / 4 );
+
+        const gcTileFrameworkBlock *srcBlocks = (const gcTileFrameworkBlock*)fwTexels.data();
+        rw::gc_dxt1_block *gcBlocks = (rw::gc_dxt1_block*)gcTexels.data();
+
+        for ( rw::uint32 block_y = 0; block_y < gcBlocksHeight; block_y++ )
+        {
+            for ( rw::uint32 block_x = 0; block_x < gcBlocksWidth; block_x++ )
+            {
+                auto putBlock = [&]( rw::uint32 tiled_x, rw::uint32 tiled_y, rw::uint32 cluster_index )
+                {
+                    rw::gc_dxt1_block& dstBlock = gcBlocks[ tiled_x + tiled_y * gcBlocksWidth ];
+
+                    if ( block_x < srcBlocksWidth && block_y < srcBlocksHeight )
+                    {
+                        ReferenceCopyDXT1Block( dstBlock, srcBlocks[ block_x + block_y * srcBlocksWidth ] );
+                    }
+                    else
+                    {
+                        ReferenceClearDXT1Block( dstBlock );
+                    }
+                };
+
+                rw::GCProcessTiledCoordsFromLinear( block_x, block_y, gcBlocksWidth, gcBlocksHeight, 2, 2, 1, true, putBlock );
+            }
+        }
+
+        return gcTexels;
+    }
+
+    gcTileSurfaceInfo info = GetGCTileSurfaceInfo( format );
+    gcTileFrameworkFormat fwFormat = GetGCTileFrameworkFormat( format );
+
+    rw::uint32 srcRowSize = rw::getRasterDataRowSize( layerWidth, fwFormat.depth, _gcTileFrameworkRowAlignment );
+    rw::uint32 gcRowSize = rw::getGCRasterDataRowSize( gcSurfWidth, info.depth );
+
+    bool isPaletteFormat = IsGCTilePaletteFormat( format );
+
+    rw::ePaletteType gcPaletteType = rw::getPaletteTypeFromGCNativeFormat( format );
+
+    rw::colorModelDispatcher srcDispatch( fwFormat.rasterFormat, fwFormat.colorOrder, fwFormat.depth, NULL, 0, rw::PALETTE_NONE );
+    rw::gcColorDispatch dstDispatch( format, rw::GVRPIX_NO_PALETTE, rw::COLOR_RGBA, 0, rw::PALETTE_NONE, NULL, 0 );
+
+    // Every item of the native surface is written, the ones outside of the layer are cleared.
+    for ( rw::uint32 y = 0; y < gcSurfHeight; y++ )
+    {
+        for ( rw::uint32 x = 0; x < gcSurfWidth; x++ )
+        {
+            bool isInsideLayer = ( x < layerWidth && y < layerHeight );
+
+            rw::abstractColorItem colorItem;
+
+            if ( !isPaletteFormat )
+            {
+                if ( isInsideLayer )
+                {
+                    srcDispatch.getColor( rw::getConstTexelDataRow( fwTexels.data(), srcRowSize, y ), x, colorItem );
+                }
+                else
+                {
+                    srcDispatch.setClearedColor( colorItem );
+                }
+            }
+
+            auto writeTexel = [&]( rw::uint32 tiled_x, rw::uint32 tiled_y, rw::uint32 cluster_index )
+            {
+                if ( isPaletteFormat )
+                {
+                    rw::copyPaletteIndexAcrossSurfaces(
+                        fwTexels.data(), layerWidth, layerHeight, srcRowSize,
+                        gcTexels.data(), gcSurfWidth, gcSurfHeight, gcRowSize,
+                        x, y,
+                        tiled_x, tiled_y,
+                        fwFormat.depth, srcPaletteType,
+                        info.depth, gcPaletteType,
+                        paletteSize
+                    );
+                }
+                else
+                {
+                    void *dstRow = rw::getTexelDataRow( gcTexels.data(), gcRowSize, tiled_y );
+
+                    rw::writeGCNativeColor( dstRow, dstDispatch, tiled_x, cluster_index, colorItem );
+                }
+            };
+
+            rw::GCProcessTiledCoordsFromLinear(
+                x, y, gcSurfWidth, gcSurfHeight,
+                info.clusterWidth, info.clusterHeight, info.clusterCount,
+                info.isSwizzled,
+                writeTexel
+            );
+        }
+    }
+
+    return gcTexels;
+}
+
+static std::vector <rw::uint8> LibraryGCEncode(
+    rw::Interface *engineInterface,
+    rw::eGCNativeTextureFormat format, const std::vector <rw::uint8>& fwTexels,
+    rw::uint32 layerWidth, rw::uint32 layerHeight,
+    rw::ePaletteType srcPaletteType, rw::uint32 paletteSize
+)
+{
+    gcTileFrameworkFormat fwFormat = GetGCTileFrameworkFormat( format );
+
+    rw::uint32 fwWidth, fwHeight, fwDataSize;
+    GetGCTileFrameworkSurface( format, layerWidth, layerHeight, fwWidth, fwHeight, fwDataSize );
+
+    rw::uint32 dstSurfWidth, dstSurfHeight;
+    void *dstTexels;
+    rw::uint32 dstDataSize;
+
+    rw::TranscodeIntoNativeGCLayer(
+        engineInterface,
+        fwWidth, fwHeight, layerWidth, layerHeight, fwTexels.data(), (rw::uint32)fwTexels.size(),
+        fwFormat.rasterFormat, fwFormat.depth, _gcTileFrameworkRowAlignment, fwFormat.colorOrder,
+        srcPaletteType, paletteSize, fwFormat.compressionType,
+        format, rw::GVRPIX_RGB565,
+        dstSurfWidth, dstSurfHeight,
+        dstTexels, dstDataSize
+    );
+
+    std::vector <rw::uint8> gcTexels( (const rw::uint8*)dstTexels, (const rw::uint8*)dstTexels + dstDataSize );
+
+    engineInterface->PixelFree( dstTexels );
+
+    return gcTexels;
+}
+
+// Only the texels of the layer are written into the destination surface of a transform.
+static std::vector <rw::uint8> ReferenceGCTransform(
+    rw::eGCNativeTextureFormat srcFormat, rw::eGCNativeTextureFormat dstFormat,
+    const std::vector <rw::uint8>& srcTexels, rw::uint32 layerWidth, rw::uint32 layerHeight,
+    rw::uint32 paletteSize
+)
+{
+    gcTileSurfaceInfo srcInfo = GetGCTileSurfaceInfo( srcFormat );
+    gcTileSurfaceInfo dstInfo = GetGCTileSurfaceInfo( dstFormat );
+
+    rw::uint32 srcMipWidth, srcMipHeight, srcDataSize;
+    GetGCTileNativeSurface( srcFormat, layerWidth, layerHeight, srcMipWidth, srcMipHeight, srcDataSize );
+
+    rw::uint32 dstMipWidth, dstMipHeight, dstDataSize;
+    GetGCTileNativeSurface( dstFormat, layerWidth, layerHeight, dstMipWidth, dstMipHeight, dstDataSize );
+
+    rw::uint32 srcRowSize = rw::getGCRasterDataRowSize( srcMipWidth, srcInfo.depth );
+    rw::uint32 dstRowSize = rw::getGCRasterDataRowSize( dstMipWidth, dstInfo.depth );
+
+    std::vector <rw::uint8> dstTexels( dstDataSize );
+
+    bool isPaletteFormat = IsGCTilePaletteFormat( dstFormat );
+
+    rw::ePaletteType paletteType = rw::getPaletteTypeFromGCNativeFormat( dstFormat );
+
+    rw::gcColorDispatch srcDispatch( srcFormat, rw::GVRPIX_NO_PALETTE, rw::COLOR_RGBA, 0, rw::PALETTE_NONE, NULL, 0 );
+    rw::gcColorDispatch dstDispatch( dstFormat, rw::GVRPIX_NO_PALETTE, rw::COLOR_RGBA, 0, rw::PALETTE_NONE, NULL, 0 );
+
+    auto keepColor = []( rw::abstractColorItem& colorItem ) {};
+
+    for ( rw::uint32 y = 0; y < layerHeight; y++ )
+    {
+        for ( rw::uint32 x = 0; x < layerWidth; x++ )
+        {
+            if ( isPaletteFormat )
+            {
+                rw::uint32 src_tiled_x, src_tiled_y;
+                rw::uint32 dst_tiled_x, dst_tiled_y;
+
+                auto getSrcCoord = [&]( rw::uint32 tiled_x, rw::uint32 tiled_y, rw::uint32 cluster_index )
+                {
+                    src_tiled_x = tiled_x;
+                    src_tiled_y = tiled_y;
+                };
+
+                auto getDstCoord = [&]( rw::uint32 tiled_x, rw::uint32 tiled_y, rw::uint32 cluster_index )
+                {
+                    dst_tiled_x = tiled_x;
+                    dst_tiled_y = tiled_y;
+                };
+
+                rw::GCProcessTiledCoordsFromLinear( x, y, srcMipWidth, srcMipHeight, srcInfo.clusterWidth, srcInfo.clusterHeight, 1, srcInfo.isSwizzled, getSrcCoord );
+                rw::GCProcessTiledCoordsFromLinear( x, y, dstMipWidth, dstMipHeight, dstInfo.clusterWidth, dstInfo.clusterHeight, 1, dstInfo.isSwizzled, getDstCoord );
+
+                rw::copyPaletteIndexAcrossSurfaces(
+                    srcTexels.data(), srcMipWidth, srcMipHeight, srcRowSize,
+                    dstTexels.data(), dstMipWidth, dstMipHeight, dstRowSize,
+                    src_tiled_x, src_tiled_y,
+                    dst_tiled_x, dst_tiled_y,
+                    srcInfo.depth, paletteType,
+                    dstInfo.depth, paletteType,
+                    paletteSize
+                );
+            }
+            else
+            {
+                rw::abstractColorItem colorItem;
+                colorItem.setClearedColor( rw::COLORMODEL_RGBA );
+
+                auto readTexel = [&]( rw::uint32 tiled_x, rw::uint32 tiled_y, rw::uint32 cluster_index )
+                {
+                    const void *srcRow = rw::getConstTexelDataRow( srcTexels.data(), srcRowSize, tiled_y );
+
+                    rw::readGCNativeColor( srcRow, srcDispatch, tiled_x, cluster_index, keepColor, colorItem );
+                };
+
+                auto writeTexel = [&]( rw::uint32 tiled_x, rw::uint32 tiled_y, rw::uint32 cluster_index )
+                {
+                    void *dstRow = rw::getTexelDataRow( dstTexels.data(), dstRowSize, tiled_y );
+
+                    rw::writeGCNativeColor( dstRow, dstDispatch, tiled_x, cluster_index, colorItem );
+                };
+
+                rw::GCProcessTiledCoordsFromLinear(
+                    x, y, srcMipWidth, srcMipHeight,
+                    srcInfo.clusterWidth, srcInfo.clusterHeight, srcInfo.clusterCount,
+                    srcInfo.isSwizzled,
+                    readTexel
+                );
+
+                rw::GCProcessTiledCoordsFromLinear(
+                    x, y, dstMipWidth, dstMipHeight,
+                    dstInfo.clusterWidth, dstInfo.clusterHeight, dstInfo.clusterCount,
+                    dstInfo.isSwizzled,
+                    writeTexel
+                );
+            }
+        }
+    }
+
+    return dstTexels;
+}
+
+static std::vector <rw::uint8> LibraryGCTransform(
+    rw::Interface *engineInterface,
+    rw::eGCNativeTextureFormat srcFormat, rw::eGCNativeTextureFormat dstFormat,
+    std::vector <rw::uint8>& srcTexels, rw::uint32 layerWidth, rw::uint32 layerHeight,
+    rw::uint32 paletteSize
+)
+{
+    gcTileSurfaceInfo srcInfo = GetGCTileSurfaceInfo( srcFormat );
+    gcTileSurfaceInfo dstInfo = GetGCTileSurfaceInfo( dstFormat );
+
+    rw::uint32 srcMipWidth, srcMipHeight, srcDataSize;
+    GetGCTileNativeSurface( srcFormat, layerWidth, layerHeight, srcMipWidth, srcMipHeight, srcDataSize );
+
+    rw::uint32 dstMipWidth, dstMipHeight;
+    void *dstTexels;
+    rw::uint32 dstDataSize;
+
+    rw::TransformRawGCMipmapLayer(
+        engineInterface,
+        srcTexels.data(), layerWidth, layerHeight,
+        srcFormat, dstFormat,
+        srcMipWidth, srcMipHeight,
+        srcInfo.depth, dstInfo.depth,
+        srcInfo.clusterWidth, srcInfo.clusterHeight, srcInfo.clusterCount,
+        dstInfo.clusterWidth, dstInfo.clusterHeight, dstInfo.clusterCount,
+        srcInfo.isSwizzled, dstInfo.isSwizzled,
+        paletteSize,
+        dstMipWidth, dstMipHeight,
+        dstTexels, dstDataSize
+    );
+
+    std::vector <rw::uint8> gcTexels( (const rw::uint8*)dstTexels, (const rw::uint8*)dstTexels + dstDataSize );
+
+    engineInterface->PixelFree( dstTexels );
+
+    return gcTexels;
+}
+
+// The items outside of the layer are left alone by a transform, so only the items of the layer are compared.
+static bool CompareGCTransformed(
+    rw::eGCNativeTextureFormat srcFormat, rw::eGCNativeTextureFormat dstFormat,
+    const std::vector <rw::uint8>& result, const std::vector <rw::uint8>& reference,
+    rw::uint32 layerWidth, rw::uint32 layerHeight
+)
+{
+    const char *srcFormatName = GetGCTileFormatName( srcFormat );
+    const char *dstFormatName = GetGCTileFormatName( dstFormat );
+
+    if ( !rwtestCheck( result.size() == reference.size(), "%s to %s, %ux%u: transformed into %u bytes instead of %u", srcFormatName, dstFormatName, layerWidth, layerHeight, (rw::uint32)result.size(), (rw::uint32)reference.size() ) )
+        return false;
+
+    gcTileSurfaceInfo dstInfo = GetGCTileSurfaceInfo( dstFormat );
+
+    rw::uint32 dstMipWidth, dstMipHeight, dstDataSize;
+    GetGCTileNativeSurface( dstFormat, layerWidth, layerHeight, dstMipWidth, dstMipHeight, dstDataSize );
+
+    rw::uint32 dstRowSize = rw::getGCRasterDataRowSize( dstMipWidth, dstInfo.depth );
+
+    rw::uint32 itemDepth = ( dstInfo.depth / dstInfo.clusterCount );
+
+    bool isLSBNibble = ( dstFormat == rw::GVRFMT_PAL_4BIT );
+
+    for ( rw::uint32 y = 0; y < layerHeight; y++ )
+    {
+        for ( rw::uint32 x = 0; x < layerWidth; x++ )
+        {
+            bool isEqual = true;
+
+            auto compareItem = [&]( rw::uint32 tiled_x, rw::uint32 tiled_y, rw::uint32 cluster_index )
+            {
+                const void *resultRow = rw::getConstTexelDataRow( result.data(), dstRowSize, tiled_y );
+                const void *referenceRow = rw::getConstTexelDataRow( reference.data(), dstRowSize, tiled_y );
+
+                if ( GetGCTileTestItem( resultRow, tiled_x, itemDepth, isLSBNibble ) != GetGCTileTestItem( referenceRow, tiled_x, itemDepth, isLSBNibble ) )
+                {
+                    isEqual = false;
+                }
+            };
+
+            rw::GCProcessTiledCoordsFromLinear(
+                x, y, dstMipWidth, dstMipHeight,
+                dstInfo.clusterWidth, dstInfo.clusterHeight, dstInfo.clusterCount,
+                dstInfo.isSwizzled,
+                compareItem
+            );
+
+            if ( !rwtestCheck( isEqual, "%s to %s, %ux%u: transformed texel ( %u, %u ) differs", srcFormatName, dstFormatName, layerWidth, layerHeight, x, y ) )
+                return false;
+        }
+    }
+
+    return true;
+}
+
+// Palettes that are smaller than the index range, so that clamping of out-of-range indices is covered.
+static rw::uint32 GetGCTilePaletteSize( rw::eGCNativeTextureFormat format )
+{
+    if ( format == rw::GVRFMT_PAL_4BIT )
+    {
+        return 13;
+    }
+
+    if ( format == rw::GVRFMT_PAL_8BIT )
+    {
+        return 200;
+    }
+
+    return 0;
+}
+
+static bool CheckGCTileShape( rw::Interface *engineInterface, rw::eGCNativeTextureFormat format, rw::uint32 layerWidth, rw::uint32 layerHeight, rw::uint32 seed )
+{
+    const char *formatName = GetGCTileFormatName( format );
+
+    rw::uint32 paletteSize = GetGCTilePaletteSize( format );
+
+    rw::uint32 mipWidth, mipHeight, nativeDataSize;
+    GetGCTileNativeSurface( format, layerWidth, layerHeight, mipWidth, mipHeight, nativeDataSize );
+
+    rw::uint32 fwWidth, fwHeight, fwDataSize;
+    GetGCTileFrameworkSurface( format, layerWidth, layerHeight, fwWidth, fwHeight, fwDataSize );
+
+    std::vector <rw::uint8> nativeTexels( nativeDataSize );
+    FillGCTileTestData( nativeTexels, seed );
+
+    std::vector <rw::uint8> fwTexels( fwDataSize );
+    FillGCTileTestData( fwTexels, seed + 1 );
+
+    // Decode.
+    {
+        std::vector <rw::uint8> result = LibraryGCDecode( engineInterface, format, nativeTexels, mipWidth, mipHeight, layerWidth, layerHeight, paletteSize );
+        std::vector <rw::uint8> reference = ReferenceGCDecode( format, nativeTexels, mipWidth, mipHeight, layerWidth, layerHeight, paletteSize );
+
+        if ( !CompareGCDecoded( format, result, reference, layerWidth, layerHeight ) )
+            return false;
+    }
+
+    // Encode. 4bit indices are also encoded from the other nibble order.
+    {
+        gcTileFrameworkFormat fwFormat = GetGCTileFrameworkFormat( format );
+
+        std::vector <rw::ePaletteType> srcPaletteTypes( 1, fwFormat.paletteType );
+
+        if ( format == rw::GVRFMT_PAL_4BIT )
+        {
+            srcPaletteTypes.push_back( rw::PALETTE_4BIT );
+        }
+
+        for ( rw::ePaletteType srcPaletteType : srcPaletteTypes )
+        {
+            std::vector <rw::uint8> result = LibraryGCEncode( engineInterface, format, fwTexels, layerWidth, layerHeight, srcPaletteType, paletteSize );
+            std::vector <rw::uint8> reference = ReferenceGCEncode( format, fwTexels, layerWidth, layerHeight, srcPaletteType, paletteSize );
+
+            if ( !rwtestCheck( result == reference, "%s, %ux%u: encoded surface differs (source palette type %u)", formatName, layerWidth, layerHeight, (rw::uint32)srcPaletteType ) )
+                return false;
+        }
+    }
+
+    // Transform. Palette formats keep their palette type, compressed surfaces are never transformed.
+    if ( format == rw::GVRFMT_CMP )
+        return true;
+
+    for ( const gcTileTestFormat& dstFormatInfo : _gcTileTestFormats )
+    {
+        rw::eGCNativeTextureFormat dstFormat = dstFormatInfo.format;
+
+        if ( dstFormat == rw::GVRFMT_CMP )
+            continue;
+
+        if ( IsGCTilePaletteFormat( format ) || IsGCTilePaletteFormat( dstFormat ) )
+        {
+            if ( dstFormat != format )
+                continue;
+        }
+
+        std::vector <rw::uint8> result = LibraryGCTransform( engineInterface, format, dstFormat, nativeTexels, layerWidth, layerHeight, paletteSize );
+        std::vector <rw::uint8> reference = ReferenceGCTransform( format, dstFormat, nativeTexels, layerWidth, layerHeight, paletteSize );
+
+        if ( !CompareGCTransformed( format, dstFormat, result, reference, layerWidth, layerHeight ) )
+            return false;
+    }
+
+    return true;
+}
+
+static bool CheckDXTIndexListInverse( void )
+{
+    std::vector <rw::uint32> indexLists = { 0, 0xFFFFFFFF, 0x55555555, 0xAAAAAAAA, 0x1B1B1B1B, 0xE4E4E4E4 };
+
+    for ( rw::uint32 bit = 0; bit < 32; bit++ )
+    {
+        indexLists.push_back( 1u << bit );
+    }
+
+    rwtestRandom random( 0x6C7 );
+
+    for ( unsigned int n = 0; n < _gcTileRandomIndexListCount; n++ )
+    {
+        indexLists.push_back( ( random.Next() << 16 ) ^ random.Next() );
+    }
+
+    for ( rw::uint32 indexList : indexLists )
+    {
+        rw::uint32 result = 0;
+        rw::DXTIndexListInverseCopy( result, indexList, 4u, 4u );
+
+        rw::uint32 reference = ReferenceInverseIndexList( indexList );
+
+        if ( !rwtestCheck( result == reference, "index list 0x%08X is mirrored into 0x%08X instead of 0x%08X", indexList, result, reference ) )
+            return false;
+
+        // Mirroring twice has to give back the original list.
+        rw::uint32 roundTrip = 0;
+        rw::DXTIndexListInverseCopy( roundTrip, result, 4u, 4u );
+
+        if ( !rwtestCheck( roundTrip == indexList, "index list 0x%08X does not survive mirroring twice", indexList ) )
+            return false;
+    }
+
+    return true;
+}
+
+static bool test_gc_tile_transcode( rwtestContext& ctx )
+{
+    rw::Interface *engineInterface = ctx.engineInterface;
+
+    bool success = CheckDXTIndexListInverse();
+
+    rw::uint32 seed = 0x6C0;
+
+    for ( const gcTileTestFormat& formatInfo : _gcTileTestFormats )
+    {
+        try
+        {
+            for ( const gcTileTestSize& size : _gcTileAlignedSizes )
+            {
+                success &= CheckGCTileShape( engineInterface, formatInfo.format, size.width, size.height, seed );
+
+                seed += 2;
+            }
+
+            for ( const gcTileTestSize& size : _gcTileUnalignedSizes )
+            {
+                success &= CheckGCTileShape( engineInterface, formatInfo.format, size.width, size.height, seed );
+
+                seed += 2;
+            }
+        }
+        catch( rw::RwException& except )
+        {
+            success = rwtestCheck( false, "%s: %s", formatInfo.name, except.message.c_str() );
+        }
+    }
+
+    return success;
+}
+
+RWTEST_REGISTER( "gc.tile_transcode", RWTEST_REGRESSION, test_gc_tile_transcode );
+
+// Compares the speed of the tile row path with the per-texel path, on a surface that is made of whole tiles.
+static void LogGCTileBenchResult( const char *operationName, double tiledSeconds, double perTexelSeconds )
+{
+    rwtestLog(
+        "  %s: tile rows %.2f ms, per texel %.2f ms (%.2fx)",
+        operationName, tiledSeconds * 1000.0, perTexelSeconds * 1000.0, perTexelSeconds / tiledSeconds
+    );
+}
+
+static bool RunGCTileBench( rw::Interface *engineInterface, rw::eGCNativeTextureFormat format )
+{
+    const rw::uint32 size = _gcTileBenchSize;
+
+    rw::uint32 paletteSize = GetGCTilePaletteSize( format );
+
+    rw::uint32 mipWidth, mipHeight, nativeDataSize;
+    GetGCTileNativeSurface( format, size, size, mipWidth, mipHeight, nativeDataSize );
+
+    rw::uint32 fwWidth, fwHeight, fwDataSize;
+    GetGCTileFrameworkSurface( format, size, size, fwWidth, fwHeight, fwDataSize );
+
+    std::vector <rw::uint8> nativeTexels( nativeDataSize );
+    FillGCTileTestData( nativeTexels, 0xB6C );
+
+    std::vector <rw::uint8> fwTexels( fwDataSize );
+    FillGCTileTestData( fwTexels, 0xB6D );
+
+    gcTileFrameworkFormat fwFormat = GetGCTileFrameworkFormat( format );
+
+    bool success = true;
+
+    try
+    {
+        // Decode.
+        {
+            std::vector <rw::uint8> result, reference;
+
+            double startTime = rwtestGetTime();
+
+            for ( unsigned int n = 0; n < _gcTileBenchRepeatCount; n++ )
+            {
+                result = LibraryGCDecode( engineInterface, format, nativeTexels, mipWidth, mipHeight, size, size, paletteSize );
+            }
+
+            double tiledSeconds = ( ( rwtestGetTime() - startTime ) / _gcTileBenchRepeatCount );
+
+            startTime = rwtestGetTime();
+
+            for ( unsigned int n = 0; n < _gcTileBenchRepeatCount; n++ )
+            {
+                reference = ReferenceGCDecode( format, nativeTexels, mipWidth, mipHeight, size, size, paletteSize );
+            }
+
+            double perTexelSeconds = ( ( rwtestGetTime() - startTime ) / _gcTileBenchRepeatCount );
+
+            LogGCTileBenchResult( "decode", tiledSeconds, perTexelSeconds );
+
+            success &= CompareGCDecoded( format, result, reference, size, size );
+        }
+
+        // Encode.
+        {
+            std::vector <rw::uint8> result, reference;
+
+            double startTime = rwtestGetTime();
+
+            for ( unsigned int n = 0; n < _gcTileBenchRepeatCount; n++ )
+            {
+                result = LibraryGCEncode( engineInterface, format, fwTexels, size, size, fwFormat.paletteType, paletteSize );
+            }
+
+            double tiledSeconds = ( ( rwtestGetTime() - startTime ) / _gcTileBenchRepeatCount );
+
+            startTime = rwtestGetTime();
+
+            for ( unsigned int n = 0; n < _gcTileBenchRepeatCount; n++ )
+            {
+                reference = ReferenceGCEncode( format, fwTexels, size, size, fwFormat.paletteType, paletteSize );
+            }
+
+            double perTexelSeconds = ( ( rwtestGetTime() - startTime ) / _gcTileBenchRepeatCount );
+
+            LogGCTileBenchResult( "encode", tiledSeconds, perTexelSeconds );
+
+            success &= rwtestCheck( result == reference, "%s: encoded surface differs", GetGCTileFormatName( format ) );
+        }
+
+        // Transform into the format that a consistency update would most likely pick.
+        if ( format != rw::GVRFMT_CMP )
+        {
+            rw::eGCNativeTextureFormat dstFormat = format;
+
+            if ( !IsGCTilePaletteFormat( format ) )
+            {
+                dstFormat = ( format == rw::GVRFMT_RGBA8888 ? rw::GVRFMT_RGB565 : rw::GVRFMT_RGBA8888 );
+            }
+
+            std::vector <rw::uint8> result, reference;
+
+            double startTime = rwtestGetTime();
+
+            for ( unsigned int n = 0; n < _gcTileBenchRepeatCount; n++ )
+            {
+                result = LibraryGCTransform( engineInterface, format, dstFormat, nativeTexels, size, size, paletteSize );
+            }
+
+            double tiledSeconds = ( ( rwtestGetTime() - startTime ) / _gcTileBenchRepeatCount );
+
+            startTime = rwtestGetTime();
+
+            for ( unsigned int n = 0; n < _gcTileBenchRepeatCount; n++ )
+            {
+                reference = ReferenceGCTransform( format, dstFormat, nativeTexels, size, size, paletteSize );
+            }
+
+            double perTexelSeconds = ( ( rwtestGetTime() - startTime ) / _gcTileBenchRepeatCount );
+
+            std::string operationName = ( std::string( "transform to " ) + GetGCTileFormatName( dstFormat ) );
+
+            LogGCTileBenchResult( operationName.c_str(), tiledSeconds, perTexelSeconds );
+
+            success &= CompareGCTransformed( format, dstFormat, result, reference, size, size );
+        }
+    }
+    catch( rw::RwException& except )
+    {
+        success = rwtestCheck( false, "%s: %s", GetGCTileFormatName( format ), except.message.c_str() );
+    }
+
+    return success;
+}
+
+template <rw::eGCNativeTextureFormat format>
+static bool bench_gc_tiles( rwtestContext& ctx )
+{
+    return RunGCTileBench( ctx.engineInterface, format );
+}
+
+RWTEST_REGISTER( "bench.gc_tiles.lum4", RWTEST_BENCHMARK, bench_gc_tiles <rw::GVRFMT_LUM_4BIT> );
+RWTEST_REGISTER( "bench.gc_tiles.lum8", RWTEST_BENCHMARK, bench_gc_tiles <rw::GVRFMT_LUM_8BIT> );
+RWTEST_REGISTER( "bench.gc_tiles.lum4_alpha", RWTEST_BENCHMARK, bench_gc_tiles <rw::GVRFMT_LUM_4BIT_ALPHA> );
+RWTEST_REGISTER( "bench.gc_tiles.lum8_alpha", RWTEST_BENCHMARK, bench_gc_tiles <rw::GVRFMT_LUM_8BIT_ALPHA> );
+RWTEST_REGISTER( "bench.gc_tiles.rgb565", RWTEST_BENCHMARK, bench_gc_tiles <rw::GVRFMT_RGB565> );
+RWTEST_REGISTER( "bench.gc_tiles.rgb5a3", RWTEST_BENCHMARK, bench_gc_tiles <rw::GVRFMT_RGB5A3> );
+RWTEST_REGISTER( "bench.gc_tiles.rgba8888", RWTEST_BENCHMARK, bench_gc_tiles <rw::GVRFMT_RGBA8888> );
+RWTEST_REGISTER( "bench.gc_tiles.pal4", RWTEST_BENCHMARK, bench_gc_tiles <rw::GVRFMT_PAL_4BIT> );
+RWTEST_REGISTER( "bench.gc_tiles.pal8", RWTEST_BENCHMARK, bench_gc_tiles <rw::GVRFMT_PAL_8BIT> );
+RWTEST_REGISTER( "bench.gc_tiles.cmp", RWTEST_BENCHMARK, bench_gc_tiles <rw::GVRFMT_CMP> );
+
+#endif //RWLIB_INCLUDE_NATIVETEX_GAMECUBE
@@ -0,0 +1,171 @@
+// Format detection through the magic number tables (rwimaging.sig.hxx).
+// A mixed corpus of image headers, unknown data and truncated streams is run through
+// GetNativeImageTypeForStream. Every stream has to be classified correctly and left at its start.
+
+#include "rwtest.h"
+
+#include <string.h>
+
+enum eSignatureSampleKind
+{
+    SIGSAMPLE_PNG,
+    SIGSAMPLE_JPEG,
+    SIGSAMPLE_BMP,
+    SIGSAMPLE_TIFF_LE,
+    SIGSAMPLE_TIFF_BE,
+    SIGSAMPLE_DDS,
+    SIGSAMPLE_UNKNOWN,
+    SIGSAMPLE_TRUNCATED,
+
+    SIGSAMPLE_KIND_COUNT
+};
+
+struct _signatureSample
+{
+    eSignatureSampleKind kind;
+    std::vector <char> data;
+};
+
+static void GenerateSignatureSample( eSignatureSampleKind kind, rwtestRandom& random, _signatureSample& sampleOut )
+{
+    static const char pngMagic[] = { (char)0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    static const char jpegMagic[] = { (char)0xFF, (char)0xD8, (char)0xFF, (char)0xE0 };
+    static const char bmpMagic[] = { 'B', 'M' };
+    static const char tiffLEMagic[] = { 'I', 'I', 42, 0 };
+    static const char tiffBEMagic[] = { 'M', 'M', 0, 42 };
+    static const char ddsMagic[] = { 'D', 'D', 'S', ' ' };
+
+    sampleOut.kind = kind;
+
+    if ( kind == SIGSAMPLE_TRUNCATED )
+    {
+        // Shorter than any signature.
+        sampleOut.data.resize( random.NextBelow( 4 ) );
+
+        for ( char& c : sampleOut.data )
+        {
+            c = (char)random.Next();
+        }
+
+        return;
+    }
+
+    sampleOut.data.resize( 128 + random.NextBelow( 1024 ) );
+
+    for ( char& c : sampleOut.data )
+    {
+        c = (char)random.Next();
+    }
+
+    const char *magic = NULL;
+    size_t magicSize = 0;
+
+    switch( kind )
+    {
+    case SIGSAMPLE_PNG:         magic = pngMagic; magicSize = sizeof( pngMagic ); break;
+    case SIGSAMPLE_JPEG:        magic = jpegMagic; magicSize = sizeof( jpegMagic ); break;
+    case SIGSAMPLE_BMP:         magic = bmpMagic; magicSize = sizeof( bmpMagic ); break;
+    case SIGSAMPLE_TIFF_LE:     magic = tiffLEMagic; magicSize = sizeof( tiffLEMagic ); break;
+    case SIGSAMPLE_TIFF_BE:     magic = tiffBEMagic; magicSize = sizeof( tiffBEMagic ); break;
+    case SIGSAMPLE_DDS:         magic = ddsMagic; magicSize = sizeof( ddsMagic ); break;
+    default:
+        // Make sure that random data does not start like a DDS file or a legacy PVR header.
+        sampleOut.data[ 0 ] = 'X';
+        break;
+    }
+
+    if ( magic != NULL )
+    {
+        memcpy( sampleOut.data.data(), magic, magicSize );
+    }
+}
+
+static const char* GetExpectedNativeImageType( eSignatureSampleKind kind )
+{
+    // Only DDS is a native image format among these.
+    return ( kind == SIGSAMPLE_DDS ? "DDS" : NULL );
+}
+
+static const rw::uint32 _signatureCorpusSize = 1400;
+static const rw::uint32 _signatureRounds = 200;
+
+static bool bench_signature_probing( rwtestContext& ctx )
+{
+    rw::Interface *engineInterface = ctx.engineInterface;
+
+    rwtestRandom random( 0x5167 );
+
+    std::vector <_signatureSample> corpus( _signatureCorpusSize );
+
+    for ( rw::uint32 n = 0; n < _signatureCorpusSize; n++ )
+    {
+        GenerateSignatureSample( (eSignatureSampleKind)( n % SIGSAMPLE_KIND_COUNT ), random, corpus[ n ] );
+    }
+
+    std::vector <rw::Stream*> streams;
+    streams.reserve( corpus.size() );
+
+    for ( _signatureSample& sample : corpus )
+    {
+        rw::streamConstructionMemoryParam_t memParam( sample.data.data(), sample.data.size() );
+
+        rw::Stream *stream = engineInterface->CreateStream( rw::RWSTREAMTYPE_MEMORY, rw::RWSTREAMMODE_READONLY, &memParam );
+
+        if ( stream == NULL )
+        {
+            break;
+        }
+
+        streams.push_back( stream );
+    }
+
+    bool success = rwtestCheck( streams.size() == corpus.size(), "failed to create the memory streams" );
+
+    if ( success )
+    {
+        // First check the results once.
+        for ( size_t n = 0; n < streams.size(); n++ )
+        {
+            rw::Stream *stream = streams[ n ];
+
+            const char *typeName = rw::GetNativeImageTypeForStream( stream );
+            const char *expectedName = GetExpectedNativeImageType( corpus[ n ].kind );
+
+            bool isCorrect =
+                ( typeName == NULL || expectedName == NULL ) ?
+                ( typeName == expectedName ) :
+                ( strcmp( typeName, expectedName ) == 0 );
+
+            success &= rwtestCheck( isCorrect, "sample %u (kind %u) detected as %s", (rw::uint32)n, (rw::uint32)corpus[ n ].kind, typeName ? typeName : "nothing" );
+            success &= rwtestCheck( stream->tell() == 0, "sample %u was not seeked back to its start", (rw::uint32)n );
+        }
+
+        double startTime = rwtestGetTime();
+
+        for ( rw::uint32 round = 0; round < _signatureRounds; round++ )
+        {
+            for ( rw::Stream *stream : streams )
+            {
+                rw::GetNativeImageTypeForStream( stream );
+            }
+        }
+
+        double detectionTime = ( rwtestGetTime() - startTime );
+
+        double detectionCount = ( (double)_signatureRounds * streams.size() );
+
+        rwtestLog(
+            "  %u streams x %u rounds: %.1f ns per detection",
+            (rw::uint32)streams.size(), _signatureRounds, detectionTime * 1000000000.0 / detectionCount
+        );
+    }
+
+    for ( rw::Stream *stream : streams )
+    {
+        engineInterface->DeleteStream( stream );
+    }
+
+    return success;
+}
+
+RWTEST_REGISTER( "bench.imaging_signature", RWTEST_BENCHMARK, bench_signature_probing );
@@ -0,0 +1,342 @@
+// LZO compression of XBOX IMG entries.
+// The blocks of a stream are compressed and decompressed on the worker threads of the filesystem.
+// The output may not depend on the amount of threads, and the checksum in the header has to be verified
+// by Decompress and by the decompression stream.
+
+#include "rwtest.h"
+
+#include <string.h>
+
+// LZO blocks are 128 KiB, so both sizes span several batches of blocks.
+static const size_t _lzoChecksumDataSize = ( 600 * 1024 );
+static const size_t _lzoBenchDataSize = ( 6 * 1024 * 1024 );
+
+// Offset of the checksum in the compression header, behind the magic.
+static const size_t _lzoChecksumOffset = 4;
+
+// Data that compresses about as well as game models and textures: runs of repeated bytes and copies of
+// earlier data between random noise.
+static std::vector <char> GetLZOTestData( size_t dataSize, rw::uint32 seed )
+{
+    rwtestRandom random( seed );
+
+    std::vector <char> data( dataSize );
+
+    size_t n = 0;
+
+    while ( n < dataSize )
+    {
+        size_t runLength = std::min( dataSize - n, (size_t)( 1 + random.NextBelow( 256 ) ) );
+
+        rw::uint32 kind = random.NextBelow( 3 );
+
+        if ( kind == 0 )
+        {
+            memset( &data[ n ], (int)random.Next(), runLength );
+        }
+        else if ( kind == 1 && n >= 4096 )
+        {
+            size_t copyFrom = ( n - 1 - random.NextBelow( 4096 ) );
+
+            for ( size_t i = 0; i < runLength; i++ )
+            {
+                data[ n + i ] = data[ copyFrom + i ];
+            }
+        }
+        else
+        {
+            for ( size_t i = 0; i < runLength; i++ )
+            {
+                data[ n + i ] = (char)random.Next();
+            }
+        }
+
+        n += runLength;
+    }
+
+    return data;
+}
+
+static bool WriteLZOScratchFile( CFileTranslator *root, const char *path, const std::vector <char>& data )
+{
+    CFile *file = root->Open( path, "wb" );
+
+    if ( file == NULL )
+        return false;
+
+    bool success = ( file->Write( data.data(), 1, data.size() ) == data.size() );
+
+    delete file;
+
+    return success;
+}
+
+static void ReadLZOStreamToEnd( CFile *stream, std::vector <char>& dataOut )
+{
+    dataOut.clear();
+
+    char buf[ 0x8000 ];
+
+    while ( size_t readCount = stream->Read( buf, 1, sizeof( buf ) ) )
+    {
+        dataOut.insert( dataOut.end(), buf, buf + readCount );
+    }
+}
+
+static bool ReadLZOScratchFile( CFileTranslator *root, const char *path, std::vector <char>& dataOut )
+{
+    CFile *file = root->Open( path, "rb" );
+
+    if ( file == NULL )
+        return false;
+
+    ReadLZOStreamToEnd( file, dataOut );
+
+    delete file;
+
+    return true;
+}
+
+// Runs a handler method from one scratch file into another.
+static bool RunLZOHandler(
+    CFileTranslator *root, CIMGArchiveCompressionHandler *handler, bool compress,
+    const char *srcPath, const char *dstPath
+)
+{
+    CFile *srcFile = root->Open( srcPath, "rb" );
+
+    if ( srcFile == NULL )
+        return false;
+
+    bool success = false;
+
+    if ( CFile *dstFile = root->Open( dstPath, "wb" ) )
+    {
+        if ( compress )
+        {
+            success = handler->Compress( srcFile, dstFile );
+        }
+        else
+        {
+            success = handler->Decompress( srcFile, dstFile );
+        }
+
+        delete dstFile;
+    }
+
+    delete srcFile;
+
+    return success;
+}
+
+static bool ReadLZODecompressionStream(
+    CFileTranslator *root, CIMGArchiveCompressionHandler *handler, const char *srcPath, std::vector <char>& dataOut
+)
+{
+    CFile *srcFile = root->Open( srcPath, "rb" );
+
+    if ( srcFile == NULL )
+        return false;
+
+    // The stream takes the source file.
+    CFile *decodedStream = handler->OpenDecompressionStream( srcFile );
+
+    if ( decodedStream == NULL )
+    {
+        delete srcFile;
+        return false;
+    }
+
+    ReadLZOStreamToEnd( decodedStream, dataOut );
+
+    delete decodedStream;
+
+    return true;
+}
+
+static bool test_img_lzo_checksum( rwtestContext& ctx )
+{
+    CFileSystem *fileSystem = ctx.fileSystem;
+    CFileTranslator *scratchRoot = ctx.scratchRoot;
+
+    CIMGArchiveCompressionHandler *handler = fileSystem->CreateLZOCompressor();
+
+    if ( !rwtestCheck( handler != NULL, "could not create the LZO compressor" ) )
+        return false;
+
+    std::vector <char> rawData = GetLZOTestData( _lzoChecksumDataSize, 0x120 );
+
+    std::vector <char> compressedData, decompressedData, streamedData;
+
+    bool success = rwtestCheck( WriteLZOScratchFile( scratchRoot, "lzo_raw.bin", rawData ), "could not write the raw data" );
+
+    if ( success )
+    {
+        success &= rwtestCheck( RunLZOHandler( scratchRoot, handler, true, "lzo_raw.bin", "lzo_good.bin" ), "could not compress the data" );
+    }
+
+    if ( success )
+    {
+        success &= rwtestCheck( RunLZOHandler( scratchRoot, handler, false, "lzo_good.bin", "lzo_good.out" ), "could not decompress the data" );
+        success &= rwtestCheck( ReadLZOScratchFile( scratchRoot, "lzo_good.out", decompressedData ), "could not read the decompressed data" );
+        success &= rwtestCheck( decompressedData == rawData, "decompressed data differs" );
+
+        success &= rwtestCheck( ReadLZODecompressionStream( scratchRoot, handler, "lzo_good.bin", streamedData ), "could not open the decompression stream" );
+        success &= rwtestCheck( streamedData == rawData, "streamed data differs" );
+
+        success &= rwtestCheck( ReadLZOScratchFile( scratchRoot, "lzo_good.bin", compressedData ), "could not read the compressed data" );
+    }
+
+    // Break the checksum; the data itself stays fine.
+    if ( success && rwtestCheck( compressedData.size() > _lzoChecksumOffset, "the compressed data is too short" ) )
+    {
+        compressedData[ _lzoChecksumOffset ] ^= 0x5A;
+
+        success &= rwtestCheck( WriteLZOScratchFile( scratchRoot, "lzo_bad.bin", compressedData ), "could not write the broken data" );
+
+        if ( success )
+        {
+            success &= rwtestCheck(
+                RunLZOHandler( scratchRoot, handler, false, "lzo_bad.bin", "lzo_bad.out" ) == false,
+                "data with a wrong checksum was decompressed"
+            );
+
+            if ( rwtestCheck( ReadLZODecompressionStream( scratchRoot, handler, "lzo_bad.bin", streamedData ), "could not open the broken decompression stream" ) )
+            {
+                success &= rwtestCheck(
+                    streamedData.size() < rawData.size(),
+                    "the decompression stream gave out all %u bytes despite the wrong checksum", (rw::uint32)streamedData.size()
+                );
+            }
+            else
+            {
+                success = false;
+            }
+        }
+    }
+    else
+    {
+        success = false;
+    }
+
+    fileSystem->DestroyLZOCompressor( handler );
+
+    scratchRoot->Delete( "lzo_raw.bin" );
+    scratchRoot->Delete( "lzo_good.bin" );
+    scratchRoot->Delete( "lzo_good.out" );
+    scratchRoot->Delete( "lzo_bad.bin" );
+    scratchRoot->Delete( "lzo_bad.out" );
+
+    return success;
+}
+
+RWTEST_REGISTER( "img.lzo_checksum", RWTEST_REGRESSION, test_img_lzo_checksum );
+
+struct _lzoBenchResult
+{
+    std::vector <char> compressedData;
+    double compressSeconds;
+    double decompressSeconds;
+};
+
+static bool RunLZOBenchmark(
+    CFileSystem *fileSystem, CFileTranslator *scratchRoot, CIMGArchiveCompressionHandler *handler,
+    unsigned int threadCount, const std::vector <char>& rawData, _lzoBenchResult& resultOut
+)
+{
+    fileSystem->SetLZOConcurrencyLimit( threadCount );
+
+    double startTime = rwtestGetTime();
+
+    bool couldCompress = RunLZOHandler( scratchRoot, handler, true, "lzo_bench_raw.bin", "lzo_bench.bin" );
+
+    resultOut.compressSeconds = ( rwtestGetTime() - startTime );
+
+    if ( !rwtestCheck( couldCompress, "%u threads: could not compress the data", threadCount ) )
+        return false;
+
+    startTime = rwtestGetTime();
+
+    bool couldDecompress = RunLZOHandler( scratchRoot, handler, false, "lzo_bench.bin", "lzo_bench.out" );
+
+    resultOut.decompressSeconds = ( rwtestGetTime() - startTime );
+
+    if ( !rwtestCheck( couldDecompress, "%u threads: could not decompress the data", threadCount ) )
+        return false;
+
+    std::vector <char> decompressedData;
+
+    bool success = true;
+
+    success &= rwtestCheck( ReadLZOScratchFile( scratchRoot, "lzo_bench.bin", resultOut.compressedData ), "%u threads: could not read the compressed data", threadCount );
+    success &= rwtestCheck( ReadLZOScratchFile( scratchRoot, "lzo_bench.out", decompressedData ), "%u threads: could not read the decompressed data", threadCount );
+    success &= rwtestCheck( decompressedData == rawData, "%u threads: decompressed data differs", threadCount );
+
+    double megaBytes = ( (double)rawData.size() / ( 1024.0 * 1024.0 ) );
+
+    rwtestLog(
+        "  %u threads: compress %.2f MB/s, decompress %.1f MB/s",
+        threadCount, megaBytes / resultOut.compressSeconds, megaBytes / resultOut.decompressSeconds
+    );
+
+    return success;
+}
+
+static bool bench_img_lzo_threads( rwtestContext& ctx )
+{
+    CFileSystem *fileSystem = ctx.fileSystem;
+    CFileTranslator *scratchRoot = ctx.scratchRoot;
+
+    CIMGArchiveCompressionHandler *handler = fileSystem->CreateLZOCompressor();
+
+    if ( !rwtestCheck( handler != NULL, "could not create the LZO compressor" ) )
+        return false;
+
+    std::vector <char> rawData = GetLZOTestData( _lzoBenchDataSize, 0xB3C );
+
+    bool success = rwtestCheck( WriteLZOScratchFile( scratchRoot, "lzo_bench_raw.bin", rawData ), "could not write the raw data" );
+
+    if ( success )
+    {
+        fileSystem->SetLZOConcurrencyLimit( 0 );
+
+        unsigned int maxThreadCount = fileSystem->GetLZOConcurrency();
+
+        _lzoBenchResult singleResult, parallelResult;
+
+        success &= RunLZOBenchmark( fileSystem, scratchRoot, handler, 1, rawData, singleResult );
+
+        if ( maxThreadCount > 1 )
+        {
+            success &= RunLZOBenchmark( fileSystem, scratchRoot, handler, maxThreadCount, rawData, parallelResult );
+
+            if ( success )
+            {
+                success &= rwtestCheck( singleResult.compressedData == parallelResult.compressedData, "the compressed data depends on the thread count" );
+
+                rwtestLog(
+                    "  speedup with %u threads: %.2fx compress, %.2fx decompress",
+                    maxThreadCount,
+                    singleResult.compressSeconds / parallelResult.compressSeconds,
+                    singleResult.decompressSeconds / parallelResult.decompressSeconds
+                );
+            }
+        }
+        else
+        {
+            rwtestLog( "  the filesystem has no worker threads, so only one thread was measured" );
+        }
+
+        fileSystem->SetLZOConcurrencyLimit( 0 );
+    }
+
+    fileSystem->DestroyLZOCompressor( handler );
+
+    scratchRoot->Delete( "lzo_bench_raw.bin" );
+    scratchRoot->Delete( "lzo_bench.bin" );
+    scratchRoot->Delete( "lzo_bench.out" );
+
+    return success;
+}
+
+RWTEST_REGISTER( "bench.img_lzo_threads", RWTEST_BENCHMARK, bench_img_lzo_threads );
@@ -0,0 +1,293 @@
+// Interrupted in-place saves of IMG archives.
+// The archive files are copied after every step of a save that grows the version 2 directory into
+// the blocks of an entry. Opening a copy has to give the archive either as it was before the save
+// or, once the save is committed, as it is after it.
+
+#include "rwtest.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// 63 entries fit into the first directory block, so adding more moves the directory into the block of the first entry.
+static const rw::uint32 _recoveryOldEntryCount = 60;
+static const rw::uint32 _recoveryNewEntryCount = 70;
+
+// Entry that is rewritten by the save.
+static const rw::uint32 _recoveryChangedEntry = 7;
+
+static const char *const _recoveryStepNames[] =
+{
+    "data_written",
+    "journal_written",
+    "directory_written",
+    "committed"
+};
+
+static std::string GetRecoveryEntryName( rw::uint32 index )
+{
+    char nameBuf[ 32 ];
+
+    snprintf( nameBuf, sizeof( nameBuf ), "entry%02u.dat", index );
+
+    return nameBuf;
+}
+
+static std::vector <char> GetRecoveryEntryData( rw::uint32 index, rw::uint32 revision )
+{
+    rwtestRandom random( index * 977 + revision );
+
+    // Between a few bytes and three blocks.
+    std::vector <char> data( 1 + random.NextBelow( 3 * 2048 ) );
+
+    for ( char& c : data )
+    {
+        c = (char)random.Next();
+    }
+
+    return data;
+}
+
+static bool WriteRecoveryEntry( CFileTranslator *archive, rw::uint32 index, rw::uint32 revision )
+{
+    CFile *entryFile = archive->Open( GetRecoveryEntryName( index ).c_str(), "wb" );
+
+    if ( entryFile == NULL )
+        return false;
+
+    std::vector <char> data = GetRecoveryEntryData( index, revision );
+
+    bool success = ( entryFile->Write( data.data(), 1, data.size() ) == data.size() );
+
+    delete entryFile;
+
+    return success;
+}
+
+// Checks that the archive has exactly the entries of the given state.
+static bool VerifyRecoveryArchive( CFileTranslator *archive, bool isSaved, const char *stateName )
+{
+    rw::uint32 entryCount = ( isSaved ? _recoveryNewEntryCount : _recoveryOldEntryCount );
+
+    bool success = true;
+
+    for ( rw::uint32 n = 0; n < _recoveryNewEntryCount; n++ )
+    {
+        std::string entryName = GetRecoveryEntryName( n );
+
+        if ( n >= entryCount )
+        {
+            success &= rwtestCheck( archive->Exists( entryName.c_str() ) == false, "%s: %s should not exist", stateName, entryName.c_str() );
+            continue;
+        }
+
+        rw::uint32 revision = ( isSaved && n == _recoveryChangedEntry ? 1 : 0 );
+
+        std::vector <char> expectedData = GetRecoveryEntryData( n, revision );
+
+        CFile *entryFile = archive->Open( entryName.c_str(), "rb" );
+
+        if ( !rwtestCheck( entryFile != NULL, "%s: could not open %s", stateName, entryName.c_str() ) )
+        {
+            success = false;
+            continue;
+        }
+
+        std::vector <char> data( expectedData.size() + 1 );
+
+        size_t readCount = entryFile->Read( data.data(), 1, data.size() );
+
+        delete entryFile;
+
+        success &= rwtestCheck(
+            readCount == expectedData.size() && memcmp( data.data(), expectedData.data(), readCount ) == 0,
+            "%s: %s has the wrong contents", stateName, entryName.c_str()
+        );
+    }
+
+    return success;
+}
+
+static bool CopyRecoveryFile( CFileTranslator *root, const char *srcPath, const char *dstPath )
+{
+    // The archive keeps its file open for writing.
+    CFile *srcFile = root->Open( srcPath, "rb", FILE_FLAG_WRITESHARE );
+
+    if ( srcFile == NULL )
+        return false;
+
+    bool success = false;
+
+    if ( CFile *dstFile = root->Open( dstPath, "wb" ) )
+    {
+        success = true;
+
+        char buf[ 4096 ];
+
+        while ( size_t readCount = srcFile->Read( buf, 1, sizeof( buf ) ) )
+        {
+            if ( dstFile->Write( buf, 1, readCount ) != readCount )
+            {
+                success = false;
+                break;
+            }
+        }
+
+        delete dstFile;
+    }
+
+    delete srcFile;
+
+    return success;
+}
+
+struct _recoverySnapshotContext
+{
+    CFileTranslator *scratchRoot;
+    bool hasCopied[ 4 ];
+};
+
+static void RecoverySaveStepCallback( eIMGSaveStep step, void *ud )
+{
+    _recoverySnapshotContext *snapshotCtx = (_recoverySnapshotContext*)ud;
+
+    std::string snapshotName = std::string( "recovery_" ) + _recoveryStepNames[ step ] + ".img";
+
+    snapshotCtx->hasCopied[ step ] = CopyRecoveryFile( snapshotCtx->scratchRoot, "recovery.img", snapshotName.c_str() );
+}
+
+static bool test_img_interrupted_save( rwtestContext& ctx )
+{
+    CFileSystem *fileSystem = ctx.fileSystem;
+    CFileTranslator *scratchRoot = ctx.scratchRoot;
+
+    // Create the archive as it is before the save.
+    {
+        CIMGArchiveTranslatorHandle *archive = fileSystem->CreateIMGArchive( scratchRoot, "recovery.img", IMG_VERSION_2 );
+
+        if ( !rwtestCheck( archive != NULL, "could not create the archive" ) )
+            return false;
+
+        bool couldWrite = true;
+
+        for ( rw::uint32 n = 0; n < _recoveryOldEntryCount; n++ )
+        {
+            couldWrite &= WriteRecoveryEntry( archive, n, 0 );
+        }
+
+        archive->Save();
+
+        delete archive;
+
+        if ( !rwtestCheck( couldWrite, "could not write the entries" ) )
+            return false;
+    }
+
+    // Grow the directory and rewrite an entry, copying the archive after every step.
+    _recoverySnapshotContext snapshotCtx;
+    snapshotCtx.scratchRoot = scratchRoot;
+
+    for ( bool& hasCopied : snapshotCtx.hasCopied )
+    {
+        hasCopied = false;
+    }
+
+    {
+        CIMGArchiveTranslatorHandle *archive = fileSystem->OpenIMGArchive( scratchRoot, "recovery.img", true );
+
+        if ( !rwtestCheck( archive != NULL, "could not open the archive" ) )
+            return false;
+
+        bool couldWrite = WriteRecoveryEntry( archive, _recoveryChangedEntry, 1 );
+
+        for ( rw::uint32 n = _recoveryOldEntryCount; n < _recoveryNewEntryCount; n++ )
+        {
+            couldWrite &= WriteRecoveryEntry( archive, n, 0 );
+        }
+
+        archive->SetSaveStepCallback( RecoverySaveStepCallback, &snapshotCtx );
+        archive->Save();
+
+        delete archive;
+
+        if ( !rwtestCheck( couldWrite, "could not write the changed entries" ) )
+            return false;
+    }
+
+    bool success = true;
+
+    for ( rw::uint32 step = 0; step < 4; step++ )
+    {
+        const char *stepName = _recoveryStepNames[ step ];
+
+        if ( !rwtestCheck( snapshotCtx.hasCopied[ step ], "the archive was not copied at step %s", stepName ) )
+        {
+            success = false;
+            continue;
+        }
+
+        std::string snapshotName = std::string( "recovery_" ) + stepName + ".img";
+
+        bool isCommitted = ( step == IMG_SAVESTEP_COMMITTED );
+
+        // A leftover backup needs write access to be rolled back.
+        if ( step == IMG_SAVESTEP_DIRECTORY_WRITTEN )
+        {
+            CIMGArchiveTranslatorHandle *readOnlyArchive = fileSystem->OpenIMGArchive( scratchRoot, snapshotName.c_str(), false );
+
+            success &= rwtestCheck( readOnlyArchive == NULL, "%s: the torn archive was opened without rolling it back", stepName );
+
+            delete readOnlyArchive;
+        }
+
+        CIMGArchiveTranslatorHandle *archive = fileSystem->OpenIMGArchive( scratchRoot, snapshotName.c_str(), true );
+
+        if ( rwtestCheck( archive != NULL, "%s: could not open the archive", stepName ) )
+        {
+            success &= VerifyRecoveryArchive( archive, isCommitted, stepName );
+
+            delete archive;
+        }
+        else
+        {
+            success = false;
+        }
+
+        // Opening it again must not change anything.
+        archive = fileSystem->OpenIMGArchive( scratchRoot, snapshotName.c_str(), false );
+
+        if ( rwtestCheck( archive != NULL, "%s: could not open the recovered archive read-only", stepName ) )
+        {
+            success &= VerifyRecoveryArchive( archive, isCommitted, stepName );
+
+            delete archive;
+        }
+        else
+        {
+            success = false;
+        }
+
+        scratchRoot->Delete( snapshotName.c_str() );
+    }
+
+    // The saved archive itself.
+    {
+        CIMGArchiveTranslatorHandle *archive = fileSystem->OpenIMGArchive( scratchRoot, "recovery.img", false );
+
+        if ( rwtestCheck( archive != NULL, "could not open the saved archive" ) )
+        {
+            success &= VerifyRecoveryArchive( archive, true, "saved" );
+
+            delete archive;
+        }
+        else
+        {
+            success = false;
+        }
+    }
+
+    scratchRoot->Delete( "recovery.img" );
+
+    return success;
+}
+
+RWTEST_REGISTER( "img.interrupted_save", RWTEST_REGRESSION, test_img_interrupted_save );
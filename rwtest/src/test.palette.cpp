@@ -0,0 +1,436 @@
+// Tests of the native palettizer.
+// The inverse color lookup only searches the palette entries that can be the closest for a cell of the
+// color space, so it has to pick the same entry as a search through the whole palette. The benchmark
+// compares the quality and speed of the native palettizer with libimagequant.
+
+#include "rwtest.internal.h"
+
+#include "../../rwlib/src/pixelformat.hxx"
+#include "../../rwlib/src/txdread.palette.hxx"
+
+#include <math.h>
+
+static const unsigned int _closestLinkRandomColorCount = 20000;
+
+// Normalizes the color like the palettizer does and searches every palette entry.
+// Ties go to the lowest index.
+static rw::uint32 FindClosestEntryBruteForce( const rw::palettizer& conv, rw::uint8 red, rw::uint8 green, rw::uint8 blue, rw::uint8 alpha, rw::uint32& distOut )
+{
+    if ( alpha == 0 )
+    {
+        red = 0;
+        green = 0;
+        blue = 0;
+    }
+
+    rw::uint32 closestIndex = 0;
+    rw::uint32 closestDist = 0xFFFFFFFF;
+
+    for ( rw::uint32 n = 0; n < (rw::uint32)conv.texelElimData.size(); n++ )
+    {
+        rw::uint32 dist = rw::palettizer::colordistance( conv.texelElimData[ n ], red, green, blue, alpha );
+
+        if ( dist < closestDist )
+        {
+            closestIndex = n;
+            closestDist = dist;
+        }
+    }
+
+    distOut = closestDist;
+
+    return closestIndex;
+}
+
+static bool CheckClosestLink( const char *paletteName, const rw::palettizer& conv, rw::uint8 red, rw::uint8 green, rw::uint8 blue, rw::uint8 alpha )
+{
+    rw::uint32 expectedDist;
+    rw::uint32 expectedIndex = FindClosestEntryBruteForce( conv, red, green, blue, alpha, expectedDist );
+
+    rw::uint32 foundIndex = conv.getclosestlink( red, green, blue, alpha );
+
+    if ( foundIndex == expectedIndex )
+        return true;
+
+    rw::uint32 foundDist = (rw::uint32)-1;
+
+    if ( foundIndex < conv.texelElimData.size() )
+    {
+        rw::uint8 normRed = ( alpha == 0 ? 0 : red );
+        rw::uint8 normGreen = ( alpha == 0 ? 0 : green );
+        rw::uint8 normBlue = ( alpha == 0 ? 0 : blue );
+
+        foundDist = rw::palettizer::colordistance( conv.texelElimData[ foundIndex ], normRed, normGreen, normBlue, alpha );
+    }
+
+    return rwtestCheck( false,
+        "%s: color ( %u, %u, %u, %u ) maps to entry %u (distance %u) instead of %u (distance %u)",
+        paletteName, red, green, blue, alpha, foundIndex, foundDist, expectedIndex, expectedDist
+    );
+}
+
+static bool CheckPaletteLookup( const char *paletteName, rw::palettizer& conv, rw::uint32 seed )
+{
+    conv.buildlookup();
+
+    rwtestRandom random( seed );
+
+    // Random colors, some of them fully transparent.
+    for ( unsigned int n = 0; n < _closestLinkRandomColorCount; n++ )
+    {
+        rw::uint32 color = random.Next();
+
+        rw::uint8 alpha = ( random.NextBelow( 8 ) == 0 ? 0 : (rw::uint8)random.Next() );
+
+        if ( !CheckClosestLink( paletteName, conv, (rw::uint8)color, (rw::uint8)( color >> 8 ), (rw::uint8)( color >> 16 ), alpha ) )
+            return false;
+    }
+
+    // The corners of the lookup cells, where the candidate pruning is tightest.
+    static const rw::uint8 cellEdges[] = { 0, 15, 16, 31, 32, 127, 128, 223, 224, 239, 240, 255 };
+
+    for ( rw::uint8 red : cellEdges )
+    {
+        for ( rw::uint8 green : cellEdges )
+        {
+            for ( rw::uint8 blue : cellEdges )
+            {
+                for ( rw::uint8 alpha : cellEdges )
+                {
+                    if ( !CheckClosestLink( paletteName, conv, red, green, blue, alpha ) )
+                        return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+static void SetRandomPalette( rw::palettizer& conv, rw::uint32 entryCount, rw::uint32 seed, rw::uint32 colorRange )
+{
+    rwtestRandom random( seed );
+
+    conv.texelElimData.resize( entryCount );
+
+    for ( rw::palettizer::texel_t& entry : conv.texelElimData )
+    {
+        entry.red = (rw::uint8)random.NextBelow( colorRange );
+        entry.green = (rw::uint8)random.NextBelow( colorRange );
+        entry.blue = (rw::uint8)random.NextBelow( colorRange );
+        entry.alpha = (rw::uint8)( 255 - random.NextBelow( colorRange ) );
+    }
+}
+
+static bool test_palette_closest_link( rwtestContext& ctx )
+{
+    bool success = true;
+
+    // Random palettes of many sizes, spread over the whole color space.
+    static const rw::uint32 paletteSizes[] = { 1, 2, 3, 16, 17, 200, 255, 256 };
+
+    for ( rw::uint32 paletteSize : paletteSizes )
+    {
+        rw::palettizer conv;
+
+        SetRandomPalette( conv, paletteSize, 0x9A1 + paletteSize, 256 );
+
+        std::string paletteName = "random palette of " + std::to_string( paletteSize );
+
+        success &= CheckPaletteLookup( paletteName.c_str(), conv, paletteSize );
+    }
+
+    // Entries crowded into a corner, so that most cells are far away from every entry.
+    {
+        rw::palettizer conv;
+
+        SetRandomPalette( conv, 256, 0x9B2, 24 );
+
+        success &= CheckPaletteLookup( "crowded palette", conv, 0x9B3 );
+    }
+
+    // Duplicate entries, where only the lowest index may be picked.
+    {
+        rw::palettizer conv;
+
+        SetRandomPalette( conv, 64, 0x9C4, 256 );
+
+        for ( rw::uint32 n = 0; n < 64; n++ )
+        {
+            conv.texelElimData.push_back( conv.texelElimData[ 63 - n ] );
+        }
+
+        success &= CheckPaletteLookup( "palette with duplicates", conv, 0x9C5 );
+    }
+
+    // Palettes that the quantizer built itself.
+    static const rw::uint32 quantizedSizes[] = { 16, 256 };
+
+    for ( rw::uint32 maxEntries : quantizedSizes )
+    {
+        rw::palettizer conv;
+
+        rwtestRandom random( 0x9D6 + maxEntries );
+
+        for ( rw::uint32 n = 0; n < 4096; n++ )
+        {
+            rw::uint32 color = random.Next();
+
+            conv.feedcolor( (rw::uint8)color, (rw::uint8)( color >> 8 ), (rw::uint8)( color >> 16 ), (rw::uint8)( random.NextBelow( 4 ) * 85 ) );
+        }
+
+        conv.constructpalette( maxEntries );
+
+        std::string paletteName = "quantized palette of " + std::to_string( maxEntries );
+
+        success &= CheckPaletteLookup( paletteName.c_str(), conv, 0x9E7 + maxEntries );
+    }
+
+    return success;
+}
+
+RWTEST_REGISTER( "palette.closest_link", RWTEST_REGRESSION, test_palette_closest_link );
+
+// Synthetic images for the palettizer benchmark.
+enum ePalettizerBenchImage
+{
+    PALBENCH_GRADIENT,          // smooth opaque color gradients
+    PALBENCH_ALPHA_GRADIENT,    // color gradients under an alpha ramp with transparent areas
+    PALBENCH_NOISY,             // overlapping waves with noise, like a photo
+
+    PALBENCH_IMAGE_COUNT
+};
+
+static const char *const _palettizerBenchImageNames[ PALBENCH_IMAGE_COUNT ] =
+{
+    "gradient", "alpha gradient", "noisy"
+};
+
+static const rw::uint32 _palettizerBenchSize = 512;
+
+// Stored reference figures in dB, for builds without libimagequant.
+// These are the lowest PSNR values that the native palettizer may drop to; it usually does better.
+static const double _palettizerReferencePSNR[ PALBENCH_IMAGE_COUNT ][ 2 ] =
+{
+    // PAL4, PAL8
+    { 18.0, 28.0 },
+    { 17.0, 26.0 },
+    { 14.0, 22.0 }
+};
+
+static void FillPalettizerBenchImage( rw::Bitmap& bitmap, ePalettizerBenchImage image )
+{
+    const rw::uint32 size = _palettizerBenchSize;
+
+    bitmap.setSize( size, size );
+
+    rw::uint8 *texels = (rw::uint8*)bitmap.getTexelsData();
+
+    rwtestRandom random( 0xB47 + (rw::uint32)image );
+
+    for ( rw::uint32 y = 0; y < size; y++ )
+    {
+        for ( rw::uint32 x = 0; x < size; x++ )
+        {
+            rw::uint8 *texel = &texels[ ( y * size + x ) * 4 ];
+
+            double fx = ( (double)x / size );
+            double fy = ( (double)y / size );
+
+            double red, green, blue, alpha = 255;
+
+            if ( image == PALBENCH_NOISY )
+            {
+                red = 128 + 90 * sin( fx * 17.0 + fy * 5.0 ) + 30 * sin( fy * 41.0 );
+                green = 128 + 80 * sin( fy * 13.0 - fx * 7.0 ) + 30 * cos( fx * 37.0 );
+                blue = 128 + 100 * cos( ( fx + fy ) * 11.0 );
+
+                red += (int)random.NextBelow( 33 ) - 16;
+                green += (int)random.NextBelow( 33 ) - 16;
+                blue += (int)random.NextBelow( 33 ) - 16;
+            }
+            else
+            {
+                red = fx * 255;
+                green = fy * 255;
+                blue = ( 1.0 - fx * fy ) * 255;
+
+                if ( image == PALBENCH_ALPHA_GRADIENT )
+                {
+                    alpha = ( fx < 0.25 ? 0 : ( fx - 0.25 ) / 0.75 * 255 );
+                }
+            }
+
+            texel[0] = (rw::uint8)std::max( 0.0, std::min( 255.0, red ) );
+            texel[1] = (rw::uint8)std::max( 0.0, std::min( 255.0, green ) );
+            texel[2] = (rw::uint8)std::max( 0.0, std::min( 255.0, blue ) );
+            texel[3] = (rw::uint8)std::max( 0.0, std::min( 255.0, alpha ) );
+        }
+    }
+}
+
+// PSNR over all four channels. Fully transparent texels only count with their alpha.
+static double GetPalettizedPSNR( const rw::Bitmap& original, const rw::Bitmap& palettized )
+{
+    rw::uint32 width, height;
+    original.getSize( width, height );
+
+    double errorSum = 0;
+
+    for ( rw::uint32 y = 0; y < height; y++ )
+    {
+        for ( rw::uint32 x = 0; x < width; x++ )
+        {
+            rw::uint8 srcColor[4], palColor[4];
+
+            original.browsecolor( x, y, srcColor[0], srcColor[1], srcColor[2], srcColor[3] );
+            palettized.browsecolor( x, y, palColor[0], palColor[1], palColor[2], palColor[3] );
+
+            rw::uint32 firstChannel = ( srcColor[3] == 0 ? 3 : 0 );
+
+            for ( rw::uint32 ch = firstChannel; ch < 4; ch++ )
+            {
+                double diff = ( (double)srcColor[ ch ] - (double)palColor[ ch ] );
+
+                errorSum += ( diff * diff );
+            }
+        }
+    }
+
+    double mse = ( errorSum / ( (double)width * height * 4 ) );
+
+    return ( mse == 0 ? 99.0 : 10.0 * log10( 255.0 * 255.0 / mse ) );
+}
+
+struct _palettizerBenchResult
+{
+    double psnr;
+    double seconds;
+};
+
+static bool RunPalettizerBench(
+    rw::Interface *engineInterface, const rw::Bitmap& original, rw::ePaletteType paletteType, _palettizerBenchResult& resultOut
+)
+{
+    rw::Raster *raster = rw::CreateRaster( engineInterface );
+
+    if ( !rwtestCheck( raster != NULL, "could not create a raster" ) )
+        return false;
+
+    bool success = false;
+
+    try
+    {
+        raster->newNativeData( "Direct3D9" );
+        raster->setImageData( original );
+
+        double startTime = rwtestGetTime();
+
+        raster->convertToPalette( paletteType, rw::RASTER_8888 );
+
+        resultOut.seconds = ( rwtestGetTime() - startTime );
+
+        rw::Bitmap palettized = raster->getBitmap();
+
+        resultOut.psnr = GetPalettizedPSNR( original, palettized );
+
+        success = true;
+    }
+    catch( rw::RwException& except )
+    {
+        rwtestCheck( false, "could not palettize the image: %s", except.message.c_str() );
+    }
+
+    rw::DeleteRaster( raster );
+
+    return success;
+}
+
+static bool bench_palettizer( rwtestContext& ctx )
+{
+    rw::Interface *engineInterface = ctx.engineInterface;
+
+    rw::ePaletteRuntimeType prevRuntime = engineInterface->GetPaletteRuntime();
+
+    // libimagequant is the reference if this build has it.
+    bool hasImageQuant = engineInterface->SetPaletteRuntime( rw::PALRUNTIME_PNGQUANT );
+
+    if ( !hasImageQuant )
+    {
+        rwtestLog( "  libimagequant is not part of this build; comparing with the stored reference figures" );
+    }
+
+    static const rw::ePaletteType paletteTypes[] = { rw::PALETTE_4BIT, rw::PALETTE_8BIT };
+    static const char *const paletteTypeNames[] = { "PAL4", "PAL8" };
+
+    bool success = true;
+
+    for ( rw::uint32 image = 0; image < PALBENCH_IMAGE_COUNT; image++ )
+    {
+        rw::Bitmap original( engineInterface, 32, rw::RASTER_8888, rw::COLOR_RGBA );
+
+        FillPalettizerBenchImage( original, (ePalettizerBenchImage)image );
+
+        for ( rw::uint32 palIndex = 0; palIndex < 2; palIndex++ )
+        {
+            rw::ePaletteType paletteType = paletteTypes[ palIndex ];
+
+            const char *imageName = _palettizerBenchImageNames[ image ];
+            const char *palName = paletteTypeNames[ palIndex ];
+
+            _palettizerBenchResult nativeResult;
+
+            engineInterface->SetPaletteRuntime( rw::PALRUNTIME_NATIVE );
+
+            if ( !RunPalettizerBench( engineInterface, original, paletteType, nativeResult ) )
+            {
+                success = false;
+                continue;
+            }
+
+            double referencePSNR = _palettizerReferencePSNR[ image ][ palIndex ];
+
+            if ( hasImageQuant )
+            {
+                _palettizerBenchResult quantResult;
+
+                engineInterface->SetPaletteRuntime( rw::PALRUNTIME_PNGQUANT );
+
+                if ( RunPalettizerBench( engineInterface, original, paletteType, quantResult ) )
+                {
+                    rwtestLog(
+                        "  %s, %s: native %.2f dB in %.1f ms, libimagequant %.2f dB in %.1f ms (%+.2f dB)",
+                        imageName, palName,
+                        nativeResult.psnr, nativeResult.seconds * 1000.0,
+                        quantResult.psnr, quantResult.seconds * 1000.0,
+                        nativeResult.psnr - quantResult.psnr
+                    );
+                }
+                else
+                {
+                    success = false;
+                }
+            }
+            else
+            {
+                rwtestLog(
+                    "  %s, %s: native %.2f dB in %.1f ms, reference %.2f dB (%+.2f dB)",
+                    imageName, palName,
+                    nativeResult.psnr, nativeResult.seconds * 1000.0,
+                    referencePSNR, nativeResult.psnr - referencePSNR
+                );
+            }
+
+            success &= rwtestCheck(
+                nativeResult.psnr >= referencePSNR,
+                "%s, %s: the native palettizer dropped below the reference figure of %.2f dB", imageName, palName, referencePSNR
+            );
+        }
+    }
+
+    engineInterface->SetPaletteRuntime( prevRuntime );
+
+    return success;
+}
+
+RWTEST_REGISTER( "bench.palettizer", RWTEST_BENCHMARK, bench_palettizer );
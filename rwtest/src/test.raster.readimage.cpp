@@ -0,0 +1,200 @@
+// Raster::readImage converts PNG and TGA rows into the native texture format while decoding them.
+// The rasters have to be the same as if the whole image was decoded first and converted afterwards.
+
+#include "rwtest.h"
+
+#include <string.h>
+
+struct _readImageSource
+{
+    const char *name;
+    rw::eRasterFormat rasterFormat;
+    rw::uint32 depth;
+};
+
+static const _readImageSource _readImageSources[] =
+{
+    { "RGBA", rw::RASTER_8888, 32 },
+    { "RGB", rw::RASTER_888, 32 },
+    { "LUM", rw::RASTER_LUM, 8 },
+    { "LUMA", rw::RASTER_LUM_ALPHA, 16 }
+};
+
+static const char *const _readImageFormats[] = { "PNG", "TGA" };
+
+static const char *const _readImageNativeTextures[] = { "Direct3D8", "Direct3D9", "PlayStation2", "XBOX" };
+
+static const rw::uint32 _readImageSizes[][2] =
+{
+    { 1, 1 }, { 3, 5 }, { 17, 9 }, { 64, 64 }, { 100, 37 }, { 256, 130 }
+};
+
+// Encodes a random image of the given format into a memory stream.
+static rw::Stream* CreateImageStream(
+    rw::Interface *engineInterface, const char *imageFormat, const _readImageSource& source,
+    rw::uint32 width, rw::uint32 height, rw::uint32 seed
+)
+{
+    rw::Bitmap bitmap( engineInterface, source.depth, source.rasterFormat, rw::COLOR_RGBA );
+
+    bitmap.setSize( width, height );
+
+    rwtestRandom random( seed );
+
+    rw::uint8 *texels = (rw::uint8*)bitmap.getTexelsData();
+
+    for ( rw::uint32 n = 0; n < bitmap.getDataSize(); n++ )
+    {
+        texels[ n ] = (rw::uint8)random.Next();
+    }
+
+    rw::streamConstructionMemoryParam_t memParam( NULL, 0 );
+
+    rw::Stream *imageStream = engineInterface->CreateStream( rw::RWSTREAMTYPE_MEMORY, rw::RWSTREAMMODE_CREATE, &memParam );
+
+    if ( imageStream )
+    {
+        if ( !rw::SerializeImage( imageStream, imageFormat, bitmap ) )
+        {
+            engineInterface->DeleteStream( imageStream );
+
+            return NULL;
+        }
+    }
+
+    return imageStream;
+}
+
+struct _readImageResult
+{
+    std::string formatString;
+    rw::uint32 width, height;
+    std::vector <rw::uint8> texels;
+};
+
+static bool ReadImageIntoRaster(
+    rw::Interface *engineInterface, rw::Stream *imageStream, const char *nativeTexName, bool streamed,
+    _readImageResult& resultOut
+)
+{
+    engineInterface->SetStreamedImageDecoding( streamed );
+
+    imageStream->seek( 0, rw::RWSEEK_BEG );
+
+    rw::Raster *raster = rw::CreateRaster( engineInterface );
+
+    if ( raster == NULL )
+    {
+        return false;
+    }
+
+    bool success = false;
+
+    try
+    {
+        raster->newNativeData( nativeTexName );
+
+        raster->readImage( imageStream );
+
+        char formatString[ 256 ];
+        size_t formatStringLength = 0;
+
+        raster->getFormatString( formatString, sizeof( formatString ), formatStringLength );
+
+        resultOut.formatString.assign( formatString, formatStringLength );
+
+        raster->getSize( resultOut.width, resultOut.height );
+
+        rw::Bitmap bitmap = raster->getBitmap();
+
+        const rw::uint8 *texels = (const rw::uint8*)bitmap.getTexelsData();
+
+        resultOut.texels.assign( texels, texels + bitmap.getDataSize() );
+
+        success = true;
+    }
+    catch( rw::RwException& except )
+    {
+        rwtestLog( "  readImage into %s failed: %s", nativeTexName, except.message.c_str() );
+    }
+
+    rw::DeleteRaster( raster );
+
+    return success;
+}
+
+static bool test_readimage_roundtrip( rwtestContext& ctx )
+{
+    rw::Interface *engineInterface = ctx.engineInterface;
+
+    bool prevStreamed = engineInterface->GetStreamedImageDecoding();
+
+    bool success = true;
+
+    rw::uint32 seed = 1;
+
+    for ( const char *imageFormat : _readImageFormats )
+    {
+        for ( const _readImageSource& source : _readImageSources )
+        {
+            for ( const auto& size : _readImageSizes )
+            {
+                rw::uint32 width = size[ 0 ];
+                rw::uint32 height = size[ 1 ];
+
+                rw::Stream *imageStream = CreateImageStream( engineInterface, imageFormat, source, width, height, seed++ );
+
+                // Not every format can store every source.
+                if ( imageStream == NULL )
+                    continue;
+
+                for ( const char *nativeTexName : _readImageNativeTextures )
+                {
+                    if ( !rw::IsNativeTexture( engineInterface, nativeTexName ) )
+                        continue;
+
+                    _readImageResult wholeResult, streamedResult;
+
+                    bool couldReadWhole = ReadImageIntoRaster( engineInterface, imageStream, nativeTexName, false, wholeResult );
+                    bool couldReadStreamed = ReadImageIntoRaster( engineInterface, imageStream, nativeTexName, true, streamedResult );
+
+                    success &= rwtestCheck(
+                        couldReadWhole == couldReadStreamed,
+                        "%s %s %ux%u into %s: only one path could read the image",
+                        imageFormat, source.name, width, height, nativeTexName
+                    );
+
+                    if ( couldReadWhole && couldReadStreamed )
+                    {
+                        success &= rwtestCheck(
+                            wholeResult.formatString == streamedResult.formatString,
+                            "%s %s %ux%u into %s: raster format %s instead of %s",
+                            imageFormat, source.name, width, height, nativeTexName,
+                            streamedResult.formatString.c_str(), wholeResult.formatString.c_str()
+                        );
+
+                        success &= rwtestCheck(
+                            wholeResult.width == streamedResult.width && wholeResult.height == streamedResult.height,
+                            "%s %s %ux%u into %s: raster size differs",
+                            imageFormat, source.name, width, height, nativeTexName
+                        );
+
+                        success &= rwtestCheck(
+                            wholeResult.texels == streamedResult.texels,
+                            "%s %s %ux%u into %s: texels differ",
+                            imageFormat, source.name, width, height, nativeTexName
+                        );
+                    }
+                }
+
+                engineInterface->DeleteStream( imageStream );
+            }
+        }
+    }
+
+    engineInterface->SetStreamedImageDecoding( prevStreamed );
+
+    return success;
+}
+
+RWTEST_REGISTER( "raster.readimage_roundtrip", RWTEST_REGRESSION, test_readimage_roundtrip );
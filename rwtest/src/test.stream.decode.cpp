@@ -0,0 +1,381 @@
+// Streams that decompress their source while they are read.
+// Random seeks and reads on the decoding stream have to return the same bytes as decompressing
+// the whole entry at once, no matter in which order the chunks are visited.
+
+#include "rwtest.h"
+
+#include <string.h>
+
+// Spans several LZO blocks (128 KiB) and several inflate chunks (64 KiB).
+static const size_t _decodeStreamDataSize = ( 700 * 1024 + 123 );
+
+static const unsigned int _decodeStreamOperationCount = 600;
+
+// Runs of repeated bytes between random noise, so that both compressors have something to do.
+static std::vector <char> GetDecodeStreamTestData( size_t dataSize, rw::uint32 seed )
+{
+    rwtestRandom random( seed );
+
+    std::vector <char> data( dataSize );
+
+    size_t n = 0;
+
+    while ( n < dataSize )
+    {
+        size_t runLength = std::min( dataSize - n, (size_t)( 1 + random.NextBelow( 512 ) ) );
+
+        if ( random.NextBelow( 2 ) == 0 )
+        {
+            memset( &data[ n ], (int)random.Next(), runLength );
+        }
+        else
+        {
+            for ( size_t i = 0; i < runLength; i++ )
+            {
+                data[ n + i ] = (char)random.Next();
+            }
+        }
+
+        n += runLength;
+    }
+
+    return data;
+}
+
+static bool WriteDecodeStreamFile( CFileTranslator *root, const char *path, const std::vector <char>& data )
+{
+    CFile *file = root->Open( path, "wb" );
+
+    if ( file == NULL )
+        return false;
+
+    bool success = ( file->Write( data.data(), 1, data.size() ) == data.size() );
+
+    delete file;
+
+    return success;
+}
+
+static bool ReadDecodeStreamFile( CFileTranslator *root, const char *path, std::vector <char>& dataOut )
+{
+    CFile *file = root->Open( path, "rb" );
+
+    if ( file == NULL )
+        return false;
+
+    dataOut.clear();
+
+    char buf[ 0x8000 ];
+
+    while ( size_t readCount = file->Read( buf, 1, sizeof( buf ) ) )
+    {
+        dataOut.insert( dataOut.end(), buf, buf + readCount );
+    }
+
+    delete file;
+
+    return true;
+}
+
+// Seeks around the decoding stream and compares every read against the reference data.
+// Reads of zero-sized elements must not read anything, and reads behind the end must stop at the end.
+static bool CheckDecodeStreamRandomAccess( const char *streamName, CFile *stream, const std::vector <char>& reference, rw::uint32 seed )
+{
+    rwtestRandom random( seed );
+
+    const fsOffsetNumber_t dataSize = (fsOffsetNumber_t)reference.size();
+
+    if ( !rwtestCheck( stream->GetSizeNative() == dataSize, "%s: the stream size is %u instead of %u", streamName, (rw::uint32)stream->GetSizeNative(), (rw::uint32)dataSize ) )
+        return false;
+
+    std::vector <char> buf;
+
+    fsOffsetNumber_t expectedSeek = 0;
+
+    for ( unsigned int n = 0; n < _decodeStreamOperationCount; n++ )
+    {
+        // Seek in every way the stream supports, sometimes behind the end.
+        rw::uint32 seekKind = random.NextBelow( 4 );
+
+        fsOffsetNumber_t seekTarget = expectedSeek;
+
+        if ( seekKind == 0 )
+        {
+            seekTarget = random.NextBelow( (rw::uint32)dataSize + 64 );
+
+            stream->SeekNative( seekTarget, SEEK_SET );
+        }
+        else if ( seekKind == 1 )
+        {
+            fsOffsetNumber_t seekOffset = ( (fsOffsetNumber_t)random.NextBelow( 0x40000 ) - 0x20000 );
+
+            if ( expectedSeek + seekOffset >= 0 )
+            {
+                seekTarget = ( expectedSeek + seekOffset );
+
+                stream->SeekNative( seekOffset, SEEK_CUR );
+            }
+        }
+        else if ( seekKind == 2 )
+        {
+            fsOffsetNumber_t seekOffset = -(fsOffsetNumber_t)random.NextBelow( 0x30000 );
+
+            if ( dataSize + seekOffset >= 0 )
+            {
+                seekTarget = ( dataSize + seekOffset );
+
+                stream->SeekNative( seekOffset, SEEK_END );
+            }
+        }
+
+        expectedSeek = seekTarget;
+
+        if ( !rwtestCheck( stream->TellNative() == expectedSeek, "%s: operation %u: the seek is %u instead of %u", streamName, n, (rw::uint32)stream->TellNative(), (rw::uint32)expectedSeek ) )
+            return false;
+
+        // Read sometimes nothing, sometimes single bytes and sometimes across many chunks.
+        size_t elementSize = 1;
+        size_t elementCount;
+
+        rw::uint32 readKind = random.NextBelow( 8 );
+
+        if ( readKind == 0 )
+        {
+            elementSize = 0;
+            elementCount = 1 + random.NextBelow( 100 );
+        }
+        else if ( readKind == 1 )
+        {
+            elementCount = 1;
+        }
+        else if ( readKind == 2 )
+        {
+            elementSize = 4;
+            elementCount = random.NextBelow( 0x8000 );
+        }
+        else if ( readKind == 3 )
+        {
+            elementCount = 0x20000 + random.NextBelow( 0x40000 );
+        }
+        else
+        {
+            elementCount = random.NextBelow( 0x2000 );
+        }
+
+        size_t byteCount = ( elementSize * elementCount );
+
+        buf.resize( byteCount + 1 );
+
+        size_t readCount = stream->Read( buf.data(), elementSize, elementCount );
+
+        size_t availableBytes = ( expectedSeek < dataSize ? (size_t)( dataSize - expectedSeek ) : 0 );
+
+        size_t expectedBytes = std::min( byteCount, availableBytes );
+
+        size_t expectedCount = ( elementSize == 0 ? 0 : expectedBytes / elementSize );
+
+        if ( !rwtestCheck(
+                readCount == expectedCount,
+                "%s: operation %u: read %u elements of %u bytes at %u instead of %u",
+                streamName, n, (rw::uint32)readCount, (rw::uint32)elementSize, (rw::uint32)expectedSeek, (rw::uint32)expectedCount
+             ) )
+        {
+            return false;
+        }
+
+        if ( expectedBytes != 0 &&
+             !rwtestCheck(
+                memcmp( buf.data(), &reference[ (size_t)expectedSeek ], expectedBytes ) == 0,
+                "%s: operation %u: the %u bytes at %u differ", streamName, n, (rw::uint32)expectedBytes, (rw::uint32)expectedSeek
+             ) )
+        {
+            return false;
+        }
+
+        expectedSeek += expectedBytes;
+
+        if ( !rwtestCheck( stream->TellNative() == expectedSeek, "%s: operation %u: the seek after the read is %u instead of %u", streamName, n, (rw::uint32)stream->TellNative(), (rw::uint32)expectedSeek ) )
+            return false;
+
+        if ( !rwtestCheck( stream->IsEOF() == ( expectedSeek >= dataSize ), "%s: operation %u: wrong end of stream state at %u", streamName, n, (rw::uint32)expectedSeek ) )
+            return false;
+    }
+
+    return true;
+}
+
+static bool CheckLZODecodeStream( CFileSystem *fileSystem, CFileTranslator *scratchRoot, const std::vector <char>& rawData )
+{
+    CIMGArchiveCompressionHandler *handler = fileSystem->CreateLZOCompressor();
+
+    if ( !rwtestCheck( handler != NULL, "could not create the LZO compressor" ) )
+        return false;
+
+    bool success = false;
+
+    CFile *rawFile = scratchRoot->Open( "decode_raw.bin", "rb" );
+    CFile *compressedFile = scratchRoot->Open( "decode_lzo.bin", "wb" );
+
+    if ( rawFile && compressedFile )
+    {
+        success = rwtestCheck( handler->Compress( rawFile, compressedFile ), "could not compress the LZO entry" );
+    }
+
+    delete compressedFile;
+    delete rawFile;
+
+    std::vector <char> decompressedData;
+
+    if ( success )
+    {
+        CFile *srcFile = scratchRoot->Open( "decode_lzo.bin", "rb" );
+        CFile *dstFile = scratchRoot->Open( "decode_lzo.out", "wb" );
+
+        success = ( srcFile && dstFile && handler->Decompress( srcFile, dstFile ) );
+
+        delete dstFile;
+        delete srcFile;
+
+        success = rwtestCheck( success, "could not decompress the LZO entry" );
+    }
+
+    if ( success )
+    {
+        success &= rwtestCheck( ReadDecodeStreamFile( scratchRoot, "decode_lzo.out", decompressedData ), "could not read the decompressed LZO entry" );
+        success &= rwtestCheck( decompressedData == rawData, "the decompressed LZO entry differs from the raw data" );
+    }
+
+    if ( success )
+    {
+        CFile *srcFile = scratchRoot->Open( "decode_lzo.bin", "rb" );
+
+        // The stream takes the source file.
+        CFile *decodedStream = ( srcFile ? handler->OpenDecompressionStream( srcFile ) : NULL );
+
+        if ( decodedStream )
+        {
+            success = CheckDecodeStreamRandomAccess( "lzo", decodedStream, decompressedData, 0x1D0 );
+
+            delete decodedStream;
+        }
+        else
+        {
+            delete srcFile;
+
+            success = rwtestCheck( false, "could not open the LZO decompression stream" );
+        }
+    }
+
+    fileSystem->DestroyLZOCompressor( handler );
+
+    scratchRoot->Delete( "decode_lzo.bin" );
+    scratchRoot->Delete( "decode_lzo.out" );
+
+    return success;
+}
+
+static bool CheckZLIBDecodeStream( CFileSystem *fileSystem, CFileTranslator *scratchRoot, const std::vector <char>& rawData, bool hasHeader )
+{
+    const char *streamName = ( hasHeader ? "zlib" : "deflate" );
+
+    bool success = false;
+
+    CFile *rawFile = scratchRoot->Open( "decode_raw.bin", "rb" );
+    CFile *compressedFile = scratchRoot->Open( "decode_zlib.bin", "wb" );
+
+    if ( rawFile && compressedFile )
+    {
+        fileSystem->CompressZLIBStream( rawFile, compressedFile, hasHeader );
+
+        success = true;
+    }
+
+    delete compressedFile;
+    delete rawFile;
+
+    if ( !rwtestCheck( success, "%s: could not compress the entry", streamName ) )
+        return false;
+
+    std::vector <char> compressedData, decompressedData;
+
+    success &= rwtestCheck( ReadDecodeStreamFile( scratchRoot, "decode_zlib.bin", compressedData ), "%s: could not read the compressed entry", streamName );
+
+    if ( success )
+    {
+        CFile *srcFile = scratchRoot->Open( "decode_zlib.bin", "rb" );
+        CFile *dstFile = scratchRoot->Open( "decode_zlib.out", "wb" );
+
+        if ( srcFile && dstFile )
+        {
+            fileSystem->DecompressZLIBStream( srcFile, dstFile, compressedData.size(), hasHeader );
+        }
+        else
+        {
+            success = false;
+        }
+
+        delete dstFile;
+        delete srcFile;
+
+        success &= rwtestCheck( success, "%s: could not decompress the entry", streamName );
+    }
+
+    if ( success )
+    {
+        success &= rwtestCheck( ReadDecodeStreamFile( scratchRoot, "decode_zlib.out", decompressedData ), "%s: could not read the decompressed entry", streamName );
+        success &= rwtestCheck( decompressedData == rawData, "%s: the decompressed entry differs from the raw data", streamName );
+    }
+
+    if ( success )
+    {
+        // Once with the decoded size known up front, like MH2Z headers give it, and once without.
+        for ( unsigned int sizeKnown = 0; success && sizeKnown < 2; sizeKnown++ )
+        {
+            CFile *srcFile = scratchRoot->Open( "decode_zlib.bin", "rb" );
+
+            if ( !rwtestCheck( srcFile != NULL, "%s: could not open the compressed entry", streamName ) )
+            {
+                success = false;
+                break;
+            }
+
+            CFile *decodedStream = fileSystem->CreateZLIBDecompressionStream(
+                srcFile, compressedData.size(), ( sizeKnown ? (fsOffsetNumber_t)decompressedData.size() : -1 ), hasHeader
+            );
+
+            std::string runName = std::string( streamName ) + ( sizeKnown ? " (known size)" : " (unknown size)" );
+
+            success = CheckDecodeStreamRandomAccess( runName.c_str(), decodedStream, decompressedData, 0x2E0 + sizeKnown );
+
+            delete decodedStream;
+        }
+    }
+
+    scratchRoot->Delete( "decode_zlib.bin" );
+    scratchRoot->Delete( "decode_zlib.out" );
+
+    return success;
+}
+
+static bool test_stream_decode_seek( rwtestContext& ctx )
+{
+    CFileSystem *fileSystem = ctx.fileSystem;
+    CFileTranslator *scratchRoot = ctx.scratchRoot;
+
+    std::vector <char> rawData = GetDecodeStreamTestData( _decodeStreamDataSize, 0x5EE );
+
+    if ( !rwtestCheck( WriteDecodeStreamFile( scratchRoot, "decode_raw.bin", rawData ), "could not write the raw data" ) )
+        return false;
+
+    bool success = true;
+
+    success &= CheckLZODecodeStream( fileSystem, scratchRoot, rawData );
+    success &= CheckZLIBDecodeStream( fileSystem, scratchRoot, rawData, true );
+    success &= CheckZLIBDecodeStream( fileSystem, scratchRoot, rawData, false );
+
+    scratchRoot->Delete( "decode_raw.bin" );
+
+    return success;
+}
+
+RWTEST_REGISTER( "stream.decode_seek", RWTEST_REGRESSION, test_stream_decode_seek );
@@ -0,0 +1,697 @@
+// Loading of texture dictionaries.
+// Lazily loaded dictionaries only read the texture properties up front and the rasters when they are first
+// needed. They have to end up with the same textures as a dictionary that is read completely, even if the
+// source stream is deleted while rasters are still pending. The texture native blocks may also be decoded on
+// the worker threads, which may not change the textures or the warnings, not even for broken blocks.
+
+#include "rwtest.h"
+
+#include <string.h>
+
+enum eTXDLoadTexelKind
+{
+    TXDLOAD_8888,
+    TXDLOAD_565,
+    TXDLOAD_PAL8,
+    TXDLOAD_DXT1
+};
+
+struct _txdLoadTexture
+{
+    const char *name;
+    const char *maskName;
+    rw::uint32 width, height;
+    rw::uint32 maxMipmapCount;
+    eTXDLoadTexelKind texelKind;
+    rw::eRasterStageFilterMode filterMode;
+    rw::eRasterStageFilterMode fixedFilterMode;     // what the reader makes out of filterMode for the mipmap count
+    rw::eRasterStageAddressMode uAddressing, vAddressing;
+};
+
+// Some filter modes do not fit the mipmap count, so the readers have to fix them.
+static const _txdLoadTexture _txdLoadTextures[] =
+{
+    { "load_rgba", "", 64, 32, 1, TXDLOAD_8888, rw::RWFILTER_LINEAR, rw::RWFILTER_LINEAR, rw::RWTEXADDRESS_CLAMP, rw::RWTEXADDRESS_WRAP },
+    { "load_mips", "load_mips_a", 64, 64, 7, TXDLOAD_8888, rw::RWFILTER_LINEAR, rw::RWFILTER_LINEAR_LINEAR, rw::RWTEXADDRESS_WRAP, rw::RWTEXADDRESS_MIRROR },
+    { "load_565", "", 17, 9, 1, TXDLOAD_565, rw::RWFILTER_LINEAR_LINEAR, rw::RWFILTER_LINEAR, rw::RWTEXADDRESS_MIRROR, rw::RWTEXADDRESS_CLAMP },
+    { "load_pal", "load_pal_mask", 32, 32, 6, TXDLOAD_PAL8, rw::RWFILTER_POINT, rw::RWFILTER_POINT_POINT, rw::RWTEXADDRESS_WRAP, rw::RWTEXADDRESS_WRAP },
+    { "load_dxt", "", 128, 64, 1, TXDLOAD_DXT1, rw::RWFILTER_POINT_LINEAR, rw::RWFILTER_POINT, rw::RWTEXADDRESS_BORDER, rw::RWTEXADDRESS_WRAP },
+    { "load_dxt_mips", "", 64, 64, 4, TXDLOAD_DXT1, rw::RWFILTER_LINEAR_POINT, rw::RWFILTER_LINEAR_POINT, rw::RWTEXADDRESS_CLAMP, rw::RWTEXADDRESS_CLAMP }
+};
+
+static const rw::uint32 _txdLoadTextureKindCount = (rw::uint32)( sizeof( _txdLoadTextures ) / sizeof( *_txdLoadTextures ) );
+
+static inline const _txdLoadTexture& GetTXDLoadTexture( rw::uint32 texIndex )
+{
+    return _txdLoadTextures[ texIndex % _txdLoadTextureKindCount ];
+}
+
+static std::string GetTXDLoadTextureName( const char *name, rw::uint32 texIndex )
+{
+    if ( *name == '\0' )
+    {
+        return std::string();
+    }
+
+    return ( name + std::to_string( texIndex ) );
+}
+
+static rw::TextureBase* CreateTXDLoadTexture( rw::Interface *engineInterface, rw::uint32 texIndex )
+{
+    const _txdLoadTexture& info = GetTXDLoadTexture( texIndex );
+
+    rw::Bitmap bitmap( engineInterface, 32, rw::RASTER_8888, rw::COLOR_RGBA );
+
+    bitmap.setSize( info.width, info.height );
+
+    rwtestRandom random( 0x7D0 + texIndex );
+
+    rw::uint8 *texels = (rw::uint8*)bitmap.getTexelsData();
+
+    for ( rw::uint32 n = 0; n < bitmap.getDataSize(); n++ )
+    {
+        texels[ n ] = (rw::uint8)random.Next();
+    }
+
+    rw::Raster *raster = rw::CreateRaster( engineInterface );
+
+    if ( raster == NULL )
+        return NULL;
+
+    rw::TextureBase *texture = NULL;
+
+    try
+    {
+        raster->newNativeData( "Direct3D9" );
+        raster->setImageData( bitmap );
+
+        if ( info.maxMipmapCount > 1 )
+        {
+            raster->generateMipmaps( info.maxMipmapCount );
+        }
+
+        if ( info.texelKind == TXDLOAD_565 )
+        {
+            raster->convertToFormat( rw::RASTER_565 );
+        }
+        else if ( info.texelKind == TXDLOAD_PAL8 )
+        {
+            raster->convertToPalette( rw::PALETTE_8BIT );
+        }
+        else if ( info.texelKind == TXDLOAD_DXT1 )
+        {
+            raster->compressCustom( rw::RWCOMPRESS_DXT1 );
+        }
+
+        texture = rw::CreateTexture( engineInterface, raster );
+    }
+    catch( rw::RwException& except )
+    {
+        rwtestLog( "  could not create texture %u: %s", texIndex, except.message.c_str() );
+    }
+
+    rw::DeleteRaster( raster );
+
+    if ( texture )
+    {
+        texture->SetName( GetTXDLoadTextureName( info.name, texIndex ).c_str() );
+        texture->SetMaskName( GetTXDLoadTextureName( info.maskName, texIndex ).c_str() );
+        texture->SetFilterMode( info.filterMode );
+        texture->SetUAddressing( info.uAddressing );
+        texture->SetVAddressing( info.vAddressing );
+    }
+
+    return texture;
+}
+
+static bool SerializeTXDLoadObject( rw::Interface *engineInterface, rw::RwObject *rwObj, std::vector <char>& dataOut )
+{
+    rw::streamConstructionMemoryParam_t memParam( NULL, 0 );
+
+    rw::Stream *stream = engineInterface->CreateStream( rw::RWSTREAMTYPE_MEMORY, rw::RWSTREAMMODE_CREATE, &memParam );
+
+    if ( stream == NULL )
+        return false;
+
+    bool success = false;
+
+    try
+    {
+        engineInterface->Serialize( rwObj, stream );
+
+        dataOut.resize( (size_t)stream->size() );
+
+        stream->seek( 0, rw::RWSEEK_BEG );
+
+        success = ( stream->read( dataOut.data(), dataOut.size() ) == dataOut.size() );
+    }
+    catch( rw::RwException& except )
+    {
+        rwtestLog( "  could not serialize: %s", except.message.c_str() );
+    }
+
+    engineInterface->DeleteStream( stream );
+
+    return success;
+}
+
+// Writes a dictionary of textures that cycle through the table above.
+static bool CreateTXDLoadData( rw::Interface *engineInterface, rw::uint32 textureCount, std::vector <char>& dataOut )
+{
+    rw::TexDictionary *txd = rw::CreateTexDictionary( engineInterface );
+
+    if ( txd == NULL )
+        return false;
+
+    bool success = true;
+
+    for ( rw::uint32 n = 0; n < textureCount && success; n++ )
+    {
+        rw::TextureBase *texture = CreateTXDLoadTexture( engineInterface, n );
+
+        if ( texture )
+        {
+            texture->AddToDictionary( txd );
+        }
+        else
+        {
+            success = false;
+        }
+    }
+
+    if ( success )
+    {
+        success = SerializeTXDLoadObject( engineInterface, txd, dataOut );
+    }
+
+    engineInterface->DeleteRwObject( txd );
+
+    return success;
+}
+
+// Reads a dictionary from memory. The stream is kept for lazily loaded textures.
+static rw::TexDictionary* ReadTXDLoadData( rw::Interface *engineInterface, std::vector <char>& data, rw::Stream*& streamOut )
+{
+    streamOut = NULL;
+
+    rw::streamConstructionMemoryParam_t memParam( data.data(), data.size() );
+
+    rw::Stream *stream = engineInterface->CreateStream( rw::RWSTREAMTYPE_MEMORY, rw::RWSTREAMMODE_READONLY, &memParam );
+
+    if ( stream == NULL )
+        return NULL;
+
+    rw::RwObject *rwObj = NULL;
+
+    try
+    {
+        rwObj = engineInterface->Deserialize( stream );
+    }
+    catch( rw::RwException& except )
+    {
+        rwtestLog( "  could not read the texture dictionary: %s", except.message.c_str() );
+    }
+
+    rw::TexDictionary *txd = ( rwObj ? rw::ToTexDictionary( engineInterface, rwObj ) : NULL );
+
+    if ( txd == NULL )
+    {
+        if ( rwObj )
+        {
+            engineInterface->DeleteRwObject( rwObj );
+        }
+
+        engineInterface->DeleteStream( stream );
+
+        return NULL;
+    }
+
+    streamOut = stream;
+
+    return txd;
+}
+
+struct _txdLoadResult
+{
+    std::string name;
+    std::string maskName;
+    rw::eRasterStageFilterMode filterMode;
+    rw::eRasterStageAddressMode uAddressing, vAddressing;
+
+    bool hasRaster;
+    std::string formatString;
+    rw::uint32 width, height;
+    rw::uint32 mipmapCount;
+    std::vector <rw::uint8> texels;
+};
+
+// Only touches the properties, so lazily loaded textures stay pending.
+static void GetTXDLoadProperties( rw::TexDictionary *txd, std::vector <_txdLoadResult>& resultsOut )
+{
+    resultsOut.clear();
+
+    for ( rw::TexDictionary::texIter_t iter( txd->GetTextureIterator() ); !iter.IsEnd(); iter.Increment() )
+    {
+        rw::TextureBase *texture = iter.Resolve();
+
+        _txdLoadResult result;
+        result.name = texture->GetName();
+        result.maskName = texture->GetMaskName();
+        result.filterMode = texture->GetFilterMode();
+        result.uAddressing = texture->GetUAddressing();
+        result.vAddressing = texture->GetVAddressing();
+        result.hasRaster = false;
+        result.width = 0;
+        result.height = 0;
+        result.mipmapCount = 0;
+
+        resultsOut.push_back( std::move( result ) );
+    }
+}
+
+static void GetTXDLoadRasters( rw::TexDictionary *txd, std::vector <_txdLoadResult>& results )
+{
+    size_t texIndex = 0;
+
+    for ( rw::TexDictionary::texIter_t iter( txd->GetTextureIterator() ); !iter.IsEnd() && texIndex < results.size(); iter.Increment() )
+    {
+        _txdLoadResult& result = results[ texIndex++ ];
+
+        rw::Raster *raster = iter.Resolve()->GetRaster();
+
+        result.hasRaster = ( raster != NULL );
+
+        if ( raster == NULL )
+            continue;
+
+        char formatString[ 256 ];
+        size_t formatStringLength = 0;
+
+        raster->getFormatString( formatString, sizeof( formatString ), formatStringLength );
+
+        result.formatString.assign( formatString, formatStringLength );
+
+        raster->getSize( result.width, result.height );
+
+        result.mipmapCount = raster->getMipmapCount();
+
+        rw::Bitmap bitmap = raster->getBitmap();
+
+        const rw::uint8 *texels = (const rw::uint8*)bitmap.getTexelsData();
+
+        result.texels.assign( texels, texels + bitmap.getDataSize() );
+    }
+}
+
+static bool CompareTXDLoadResults(
+    const char *what, const std::vector <_txdLoadResult>& expected, const std::vector <_txdLoadResult>& results, bool compareRasters
+)
+{
+    if ( !rwtestCheck( results.size() == expected.size(), "%s: %u textures instead of %u", what, (rw::uint32)results.size(), (rw::uint32)expected.size() ) )
+        return false;
+
+    bool success = true;
+
+    for ( size_t n = 0; n < expected.size(); n++ )
+    {
+        const _txdLoadResult& expectedTex = expected[ n ];
+        const _txdLoadResult& resultTex = results[ n ];
+
+        const char *texName = expectedTex.name.c_str();
+
+        success &= rwtestCheck( resultTex.name == expectedTex.name, "%s: texture %u is %s instead of %s", what, (rw::uint32)n, resultTex.name.c_str(), texName );
+        success &= rwtestCheck( resultTex.maskName == expectedTex.maskName, "%s: %s has mask name %s", what, texName, resultTex.maskName.c_str() );
+
+        success &= rwtestCheck(
+            resultTex.filterMode == expectedTex.filterMode,
+            "%s: %s has filter mode %u instead of %u", what, texName, (rw::uint32)resultTex.filterMode, (rw::uint32)expectedTex.filterMode
+        );
+
+        success &= rwtestCheck(
+            resultTex.uAddressing == expectedTex.uAddressing && resultTex.vAddressing == expectedTex.vAddressing,
+            "%s: %s has different addressing", what, texName
+        );
+
+        if ( compareRasters )
+        {
+            if ( !rwtestCheck( resultTex.hasRaster && expectedTex.hasRaster, "%s: %s has no raster", what, texName ) )
+            {
+                success = false;
+                continue;
+            }
+
+            success &= rwtestCheck(
+                resultTex.formatString == expectedTex.formatString,
+                "%s: %s has raster format %s instead of %s", what, texName, resultTex.formatString.c_str(), expectedTex.formatString.c_str()
+            );
+
+            success &= rwtestCheck(
+                resultTex.width == expectedTex.width && resultTex.height == expectedTex.height && resultTex.mipmapCount == expectedTex.mipmapCount,
+                "%s: %s has a different raster size or mipmap count", what, texName
+            );
+
+            success &= rwtestCheck( resultTex.texels == expectedTex.texels, "%s: %s has different texels", what, texName );
+        }
+    }
+
+    return success;
+}
+
+static bool test_txd_lazy_load( rwtestContext& ctx )
+{
+    rw::Interface *engineInterface = ctx.engineInterface;
+
+    std::vector <char> txdData;
+
+    if ( !rwtestCheck( CreateTXDLoadData( engineInterface, _txdLoadTextureKindCount, txdData ), "could not create the texture dictionary" ) )
+        return false;
+
+    bool prevLazyLoading = engineInterface->GetLazyTexDictionaryLoading();
+
+    rw::Stream *eagerStream, *lazyStream, *orphanStream;
+
+    engineInterface->SetLazyTexDictionaryLoading( false );
+
+    rw::TexDictionary *eagerTXD = ReadTXDLoadData( engineInterface, txdData, eagerStream );
+
+    engineInterface->SetLazyTexDictionaryLoading( true );
+
+    rw::TexDictionary *lazyTXD = ReadTXDLoadData( engineInterface, txdData, lazyStream );
+    rw::TexDictionary *orphanTXD = ReadTXDLoadData( engineInterface, txdData, orphanStream );
+
+    engineInterface->SetLazyTexDictionaryLoading( prevLazyLoading );
+
+    bool success =
+        rwtestCheck( eagerTXD != NULL, "could not read the dictionary completely" ) &&
+        rwtestCheck( lazyTXD != NULL && orphanTXD != NULL, "could not read the dictionary lazily" );
+
+    std::vector <_txdLoadResult> eagerResults;
+    std::vector <char> eagerData;
+
+    if ( eagerTXD )
+    {
+        engineInterface->DeleteStream( eagerStream );
+
+        GetTXDLoadProperties( eagerTXD, eagerResults );
+        GetTXDLoadRasters( eagerTXD, eagerResults );
+
+        success &= rwtestCheck( SerializeTXDLoadObject( engineInterface, eagerTXD, eagerData ), "could not write the completely read dictionary" );
+
+        // The filter modes have to fit the mipmap counts.
+        for ( size_t n = 0; n < eagerResults.size() && n < _txdLoadTextureKindCount; n++ )
+        {
+            const _txdLoadTexture& info = GetTXDLoadTexture( (rw::uint32)n );
+
+            success &= rwtestCheck(
+                eagerResults[ n ].filterMode == info.fixedFilterMode,
+                "%s: filter mode %u was read as %u instead of %u",
+                eagerResults[ n ].name.c_str(), (rw::uint32)info.filterMode, (rw::uint32)eagerResults[ n ].filterMode, (rw::uint32)info.fixedFilterMode
+            );
+        }
+    }
+
+    if ( success )
+    {
+        std::vector <_txdLoadResult> lazyResults;
+
+        // The properties come from the headers, before any raster is read.
+        GetTXDLoadProperties( lazyTXD, lazyResults );
+
+        success &= CompareTXDLoadResults( "lazy properties", eagerResults, lazyResults, false );
+
+        // Writing the dictionary has to read the pending rasters.
+        std::vector <char> lazyData;
+
+        if ( rwtestCheck( SerializeTXDLoadObject( engineInterface, lazyTXD, lazyData ), "could not write the lazily read dictionary" ) )
+        {
+            success &= rwtestCheck( lazyData == eagerData, "the lazily read dictionary is written differently" );
+        }
+        else
+        {
+            success = false;
+        }
+
+        GetTXDLoadProperties( lazyTXD, lazyResults );
+        GetTXDLoadRasters( lazyTXD, lazyResults );
+
+        success &= CompareTXDLoadResults( "lazy", eagerResults, lazyResults, true );
+    }
+
+    if ( lazyStream )
+    {
+        engineInterface->DeleteStream( lazyStream );
+    }
+
+    if ( success )
+    {
+        // Read one raster, then delete the stream while the others are still pending.
+        rw::TexDictionary::texIter_t iter( orphanTXD->GetTextureIterator() );
+
+        if ( !iter.IsEnd() )
+        {
+            iter.Resolve()->GetRaster();
+        }
+
+        engineInterface->DeleteStream( orphanStream );
+
+        orphanStream = NULL;
+
+        // Nothing may be read from the memory of the stream anymore.
+        memset( txdData.data(), 0, txdData.size() );
+
+        std::vector <_txdLoadResult> orphanResults;
+
+        GetTXDLoadProperties( orphanTXD, orphanResults );
+        GetTXDLoadRasters( orphanTXD, orphanResults );
+
+        success &= CompareTXDLoadResults( "deleted stream", eagerResults, orphanResults, true );
+
+        std::vector <char> orphanData;
+
+        if ( rwtestCheck( SerializeTXDLoadObject( engineInterface, orphanTXD, orphanData ), "could not write the dictionary of the deleted stream" ) )
+        {
+            success &= rwtestCheck( orphanData == eagerData, "the dictionary of the deleted stream is written differently" );
+        }
+        else
+        {
+            success = false;
+        }
+    }
+
+    if ( orphanStream )
+    {
+        engineInterface->DeleteStream( orphanStream );
+    }
+
+    if ( eagerTXD )
+    {
+        engineInterface->DeleteRwObject( eagerTXD );
+    }
+
+    if ( lazyTXD )
+    {
+        engineInterface->DeleteRwObject( lazyTXD );
+    }
+
+    if ( orphanTXD )
+    {
+        engineInterface->DeleteRwObject( orphanTXD );
+    }
+
+    return success;
+}
+
+RWTEST_REGISTER( "txd.lazy_load", RWTEST_REGRESSION, test_txd_lazy_load );
+
+// Enough textures for several batches of the parallel loader.
+static const rw::uint32 _txdParallelTextureCount = 40;
+static const rw::uint32 _txdParallelWorkerCount = 4;
+
+// One texture keeps loading with a warning, the other cannot be read at all.
+static const rw::uint32 _txdParallelBadFilterTexture = 7;
+static const rw::uint32 _txdParallelBrokenTexture = 21;
+
+// Returns the offset of the struct data of a texture native block.
+static bool FindTXDTextureNativeStruct( const std::vector <char>& data, rw::uint32 texIndex, size_t& offsetOut )
+{
+    auto readUInt32 = [&]( size_t offset )
+    {
+        const rw::uint8 *bytes = (const rw::uint8*)data.data() + offset;
+
+        return ( (rw::uint32)bytes[ 0 ] | ( (rw::uint32)bytes[ 1 ] << 8 ) | ( (rw::uint32)bytes[ 2 ] << 16 ) | ( (rw::uint32)bytes[ 3 ] << 24 ) );
+    };
+
+    const size_t headerSize = 12;
+
+    // Skip the dictionary header and its struct block.
+    size_t offset = headerSize;
+
+    if ( offset + headerSize > data.size() || readUInt32( offset ) != rw::CHUNK_STRUCT )
+        return false;
+
+    offset += ( headerSize + readUInt32( offset + 4 ) );
+
+    for ( rw::uint32 n = 0; offset + headerSize * 2 <= data.size(); n++ )
+    {
+        if ( readUInt32( offset ) != rw::CHUNK_TEXTURENATIVE )
+            return false;
+
+        if ( n == texIndex )
+        {
+            if ( readUInt32( offset + headerSize ) != rw::CHUNK_STRUCT )
+                return false;
+
+            offsetOut = ( offset + headerSize * 2 );
+            return true;
+        }
+
+        offset += ( headerSize + readUInt32( offset + 4 ) );
+    }
+
+    return false;
+}
+
+static void WriteTXDUInt32( std::vector <char>& data, size_t offset, rw::uint32 value )
+{
+    for ( size_t n = 0; n < 4; n++ )
+    {
+        data[ offset + n ] = (char)( value >> ( n * 8 ) );
+    }
+}
+
+struct _txdLoadWarningCapture : public rw::WarningManagerInterface
+{
+    void OnWarning( std::string&& message ) override
+    {
+        this->messages.push_back( std::move( message ) );
+    }
+
+    std::vector <std::string> messages;
+};
+
+struct _txdParallelResult
+{
+    bool couldRead;
+    std::vector <_txdLoadResult> textures;
+    std::vector <char> serializedData;
+    std::vector <std::string> warnings;
+};
+
+static void ReadTXDParallelData( rw::Interface *engineInterface, std::vector <char>& data, bool parallel, _txdParallelResult& resultOut )
+{
+    engineInterface->SetParallelTexDictionaryLoading( parallel );
+
+    _txdLoadWarningCapture warningCapture;
+
+    rw::WarningManagerInterface *prevWarningManager = engineInterface->GetWarningManager();
+
+    engineInterface->SetWarningManager( &warningCapture );
+
+    rw::Stream *stream;
+
+    rw::TexDictionary *txd = ReadTXDLoadData( engineInterface, data, stream );
+
+    engineInterface->SetWarningManager( prevWarningManager );
+
+    resultOut.couldRead = ( txd != NULL );
+    resultOut.warnings = std::move( warningCapture.messages );
+
+    if ( txd )
+    {
+        engineInterface->DeleteStream( stream );
+
+        GetTXDLoadProperties( txd, resultOut.textures );
+        GetTXDLoadRasters( txd, resultOut.textures );
+
+        resultOut.couldRead = SerializeTXDLoadObject( engineInterface, txd, resultOut.serializedData );
+
+        engineInterface->DeleteRwObject( txd );
+    }
+}
+
+static bool test_txd_parallel_load( rwtestContext& ctx )
+{
+    rw::Interface *engineInterface = ctx.engineInterface;
+
+    std::vector <char> txdData;
+
+    if ( !rwtestCheck( CreateTXDLoadData( engineInterface, _txdParallelTextureCount, txdData ), "could not create the texture dictionary" ) )
+        return false;
+
+    size_t badFilterOffset, brokenOffset;
+
+    bool couldFindBlocks =
+        FindTXDTextureNativeStruct( txdData, _txdParallelBadFilterTexture, badFilterOffset ) &&
+        FindTXDTextureNativeStruct( txdData, _txdParallelBrokenTexture, brokenOffset );
+
+    if ( !rwtestCheck( couldFindBlocks, "could not find the texture native blocks" ) )
+        return false;
+
+    // The filter mode follows the platform descriptor in the Direct3D 9 header.
+    txdData[ badFilterOffset + 4 ] = (char)0x7F;
+
+    // No texture native knows this platform, so the block is skipped.
+    WriteTXDUInt32( txdData, brokenOffset, 0x7EADBEEF );
+
+    bool prevLazyLoading = engineInterface->GetLazyTexDictionaryLoading();
+    bool prevParallelLoading = engineInterface->GetParallelTexDictionaryLoading();
+    rw::uint32 prevWorkerThreadCount = engineInterface->GetWorkerThreadCount();
+
+    // Use the worker threads even on machines with a single processor.
+    engineInterface->SetLazyTexDictionaryLoading( false );
+    engineInterface->SetWorkerThreadCount( _txdParallelWorkerCount );
+
+    _txdParallelResult serialResult, parallelResult;
+
+    ReadTXDParallelData( engineInterface, txdData, false, serialResult );
+    ReadTXDParallelData( engineInterface, txdData, true, parallelResult );
+
+    engineInterface->SetLazyTexDictionaryLoading( prevLazyLoading );
+    engineInterface->SetParallelTexDictionaryLoading( prevParallelLoading );
+    engineInterface->SetWorkerThreadCount( prevWorkerThreadCount );
+
+    if ( !rwtestCheck( serialResult.couldRead && parallelResult.couldRead, "could not read the dictionary" ) )
+        return false;
+
+    bool success = true;
+
+    success &= rwtestCheck(
+        serialResult.textures.size() == _txdParallelTextureCount - 1,
+        "%u textures were read instead of %u", (rw::uint32)serialResult.textures.size(), _txdParallelTextureCount - 1
+    );
+
+    bool hasReadingFailure = false;
+
+    for ( const std::string& message : serialResult.warnings )
+    {
+        if ( message.find( "texture native reading failure" ) != std::string::npos )
+        {
+            hasReadingFailure = true;
+        }
+    }
+
+    success &= rwtestCheck( hasReadingFailure, "the broken block was not reported" );
+
+    success &= CompareTXDLoadResults( "parallel", serialResult.textures, parallelResult.textures, true );
+
+    success &= rwtestCheck( parallelResult.serializedData == serialResult.serializedData, "the dictionary read in parallel is written differently" );
+
+    if ( !rwtestCheck( parallelResult.warnings == serialResult.warnings, "the warnings differ" ) )
+    {
+        success = false;
+
+        for ( const std::string& message : serialResult.warnings )
+        {
+            rwtestLog( "  serial: %s", message.c_str() );
+        }
+
+        for ( const std::string& message : parallelResult.warnings )
+        {
+            rwtestLog( "  parallel: %s", message.c_str() );
+        }
+    }
+
+    return success;
+}
+
+RWTEST_REGISTER( "txd.parallel_load", RWTEST_REGRESSION, test_txd_parallel_load );
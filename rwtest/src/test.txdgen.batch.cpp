@@ -0,0 +1,370 @@
+// Stress tests of the txdgen batch scheduler (src/tools/txdgenbatch.cpp).
+// The same files are run through the scheduler with different worker counts and memory budgets.
+// Output bytes, write order, log text and failure reporting have to be the same in every configuration.
+// Run these under a race detector or the debug heap to catch races between the workers and the submitter.
+
+#include "rwtest.h"
+
+#include "../../src/tools/txdgenbatch.h"
+
+#include <string.h>
+
+static const rw::uint32 _batchFileCount = 64;
+
+static const size_t _batchTightBudget = ( 64 * 1024 );
+static const size_t _batchLooseBudget = ( 256 * 1024 * 1024 );
+
+// Collects the log of the scheduler. It is only called by the submitting thread.
+struct _batchLogReceiver : public MessageReceiver
+{
+    void OnMessage( const std::string& msg ) override
+    {
+        this->log += msg;
+    }
+
+    void OnMessage( const std::wstring& msg ) override
+    {
+        this->log += filePath( msg.c_str() ).convert_ansi();
+    }
+
+    CFile* WrapStreamCodec( CFile *compressed ) override
+    {
+        return compressed;
+    }
+
+    std::string log;
+};
+
+static inline rw::uint32 HashBytes( const char *data, size_t dataSize )
+{
+    rw::uint32 hash = 2166136261u;
+
+    for ( size_t n = 0; n < dataSize; n++ )
+    {
+        hash = ( ( hash ^ (unsigned char)data[ n ] ) * 16777619u );
+    }
+
+    return hash;
+}
+
+static void GenerateSourceFile( rw::uint32 fileIndex, txdgenMemoryFile& fileOut )
+{
+    rwtestRandom random( fileIndex + 1 );
+
+    // Mix small and big files so that the tight budget actually has to hold back submissions.
+    size_t fileSize = ( 512 + random.NextBelow( ( fileIndex % 4 == 0 ) ? 96 * 1024 : 8 * 1024 ) );
+
+    fileOut.data.resize( fileSize );
+
+    for ( char& c : fileOut.data )
+    {
+        c = (char)random.Next();
+    }
+
+    fileOut.seekPos = 0;
+}
+
+// Stands in for ProcessTXDArchive: deterministic output, a varying amount of work, warnings,
+// files that cannot be converted and optionally a file that throws.
+static bool ConvertTestFile(
+    rw::Interface *engineInterface, rw::uint32 fileIndex, rw::uint32 throwIndex,
+    CFile *srcStream, CFile *targetStream, std::string& logOut
+)
+{
+    if ( fileIndex == throwIndex )
+    {
+        throw rw::RwException( "conversion of file " + std::to_string( fileIndex ) + " blew up" );
+    }
+
+    if ( fileIndex % 7 == 3 )
+    {
+        logOut += "error:\nnot a convertible file\n";
+        return false;
+    }
+
+    if ( fileIndex % 5 == 1 )
+    {
+        engineInterface->PushWarning( "warning of file " + std::to_string( fileIndex ) );
+    }
+
+    std::vector <char> data( srcStream->GetSize() );
+
+    if ( !data.empty() )
+    {
+        srcStream->Read( data.data(), 1, data.size() );
+    }
+
+    // Later files are cheaper than earlier ones, so the workers finish out of order.
+    rw::uint32 roundCount = ( 1 + ( ( _batchFileCount - fileIndex ) % 13 ) );
+
+    rw::uint32 hash = 0;
+
+    for ( rw::uint32 round = 0; round < roundCount; round++ )
+    {
+        hash = HashBytes( data.data(), data.size() );
+
+        for ( char& c : data )
+        {
+            c = (char)( c ^ ( hash >> 24 ) );
+
+            hash = ( hash * 16777619u + 1 );
+        }
+    }
+
+    targetStream->Write( data.data(), 1, data.size() );
+    targetStream->Write( &hash, sizeof( hash ), 1 );
+
+    logOut += "OK\n";
+    return true;
+}
+
+struct _batchRunResult
+{
+    std::string log;
+    std::vector <rw::uint32> outputHashes;      // zero if the file was not written
+    txdgenBatchProgress progress;
+    bool hasFailed = false;
+};
+
+static filePath GetOutputPath( const char *runName, rw::uint32 fileIndex )
+{
+    std::string path = std::string( "batch_" ) + runName + "_" + std::to_string( fileIndex ) + ".bin";
+
+    return filePath( path.c_str() );
+}
+
+// Submits every test file and reads the outputs back. If cancelAfter is not zero, the batch is
+// cancelled after that many files were submitted.
+static void RunBatch(
+    rwtestContext& ctx, const char *runName, rw::uint32 workerCount, size_t memoryBudget,
+    rw::uint32 throwIndex, rw::uint32 cancelAfter,
+    _batchRunResult& resultOut
+)
+{
+    rw::Interface *engineInterface = ctx.engineInterface;
+    CFileTranslator *targetRoot = ctx.scratchRoot;
+
+    _batchLogReceiver receiver;
+
+    try
+    {
+        TxdGenBatchScheduler batch( engineInterface, &receiver, workerCount, memoryBudget );
+
+        for ( rw::uint32 fileIndex = 0; fileIndex < _batchFileCount; fileIndex++ )
+        {
+            if ( cancelAfter != 0 && fileIndex == cancelAfter )
+            {
+                batch.Cancel();
+            }
+
+            txdgenMemoryFile srcFile;
+
+            GenerateSourceFile( fileIndex, srcFile );
+
+            std::string logHeader = "*** file " + std::to_string( fileIndex ) + " ...";
+
+            // Every eighth file is just copied, like the files in archives that are not TXDs.
+            TxdGenBatchScheduler::convertCallback_t convert;
+
+            if ( fileIndex % 8 != 6 )
+            {
+                convert = [engineInterface, fileIndex, throwIndex]( CFile *srcStream, CFile *targetStream, std::string& logOut ) -> bool
+                {
+                    return ConvertTestFile( engineInterface, fileIndex, throwIndex, srcStream, targetStream, logOut );
+                };
+            }
+
+            batch.Submit( targetRoot, GetOutputPath( runName, fileIndex ), &srcFile, std::move( logHeader ), std::move( convert ) );
+        }
+
+        batch.Flush();
+
+        batch.GetProgress( resultOut.progress );
+    }
+    catch( rw::RwException& )
+    {
+        resultOut.hasFailed = true;
+    }
+
+    resultOut.log = std::move( receiver.log );
+
+    resultOut.outputHashes.resize( _batchFileCount );
+
+    for ( rw::uint32 fileIndex = 0; fileIndex < _batchFileCount; fileIndex++ )
+    {
+        filePath outputPath = GetOutputPath( runName, fileIndex );
+
+        rw::uint32 outputHash = 0;
+
+        if ( CFile *outputFile = targetRoot->Open( outputPath, "rb" ) )
+        {
+            std::vector <char> data( outputFile->GetSize() );
+
+            size_t readCount = ( data.empty() ? 0 : outputFile->Read( data.data(), 1, data.size() ) );
+
+            delete outputFile;
+
+            // Never zero, so that zero can mean missing.
+            outputHash = ( HashBytes( data.data(), readCount ) | 1 );
+
+            targetRoot->Delete( outputPath );
+        }
+
+        resultOut.outputHashes[ fileIndex ] = outputHash;
+    }
+}
+
+static bool CompareRuns( const char *runName, const _batchRunResult& reference, const _batchRunResult& result )
+{
+    bool success = true;
+
+    success &= rwtestCheck( result.hasFailed == reference.hasFailed, "%s: failure state differs", runName );
+    success &= rwtestCheck( result.log == reference.log, "%s: log differs from the sequential run", runName );
+
+    for ( rw::uint32 fileIndex = 0; fileIndex < _batchFileCount; fileIndex++ )
+    {
+        success &= rwtestCheck(
+            result.outputHashes[ fileIndex ] == reference.outputHashes[ fileIndex ],
+            "%s: output of file %u differs", runName, fileIndex
+        );
+    }
+
+    return success;
+}
+
+struct _batchConfig
+{
+    const char *name;
+    rw::uint32 workerCount;
+    size_t memoryBudget;
+};
+
+static const _batchConfig _batchConfigs[] =
+{
+    { "w1_tight", 1, _batchTightBudget },
+    { "w4_tight", 4, _batchTightBudget },
+    { "w4_loose", 4, _batchLooseBudget },
+    { "w16_tight", 16, _batchTightBudget },
+    { "w16_loose", 16, _batchLooseBudget }
+};
+
+static bool test_batch_determinism( rwtestContext& ctx )
+{
+    _batchRunResult reference;
+
+    RunBatch( ctx, "reference", 1, _batchLooseBudget, 0xFFFFFFFF, 0, reference );
+
+    bool success = true;
+
+    success &= rwtestCheck( reference.hasFailed == false, "sequential run failed" );
+    success &= rwtestCheck( reference.progress.filesWritten == _batchFileCount, "sequential run wrote %u files", reference.progress.filesWritten );
+    success &= rwtestCheck( reference.progress.bytesInFlight == 0, "bytes still in flight after flush" );
+
+    // The log has to list the files in submission order.
+    size_t lastLogPos = 0;
+
+    for ( rw::uint32 fileIndex = 0; fileIndex < _batchFileCount; fileIndex++ )
+    {
+        size_t logPos = reference.log.find( "*** file " + std::to_string( fileIndex ) + " ..." );
+
+        success &= rwtestCheck( logPos != std::string::npos && logPos >= lastLogPos, "file %u is out of order in the log", fileIndex );
+
+        if ( logPos != std::string::npos )
+        {
+            lastLogPos = logPos;
+        }
+
+        success &= rwtestCheck( reference.outputHashes[ fileIndex ] != 0, "file %u was not written", fileIndex );
+    }
+
+    for ( const _batchConfig& config : _batchConfigs )
+    {
+        _batchRunResult result;
+
+        RunBatch( ctx, config.name, config.workerCount, config.memoryBudget, 0xFFFFFFFF, 0, result );
+
+        success &= CompareRuns( config.name, reference, result );
+
+        success &= rwtestCheck( result.progress.filesConverted == reference.progress.filesConverted, "%s: converted count differs", config.name );
+        success &= rwtestCheck( result.progress.filesFailed == reference.progress.filesFailed, "%s: failed count differs", config.name );
+        success &= rwtestCheck( result.progress.bytesInFlight == 0, "%s: bytes still in flight after flush", config.name );
+    }
+
+    return success;
+}
+
+RWTEST_REGISTER( "txdgen.batch_determinism", RWTEST_REGRESSION, test_batch_determinism );
+
+static bool test_batch_failure( rwtestContext& ctx )
+{
+    const rw::uint32 throwIndex = 20;
+
+    // Without workers the exception comes straight out of Submit.
+    _batchRunResult reference;
+
+    RunBatch( ctx, "fail_reference", 1, _batchLooseBudget, throwIndex, 0, reference );
+
+    bool success = true;
+
+    success &= rwtestCheck( reference.hasFailed, "sequential run did not report the failure" );
+
+    for ( rw::uint32 fileIndex = 0; fileIndex < _batchFileCount; fileIndex++ )
+    {
+        bool shouldExist = ( fileIndex < throwIndex );
+
+        success &= rwtestCheck( ( reference.outputHashes[ fileIndex ] != 0 ) == shouldExist, "file %u: unexpected output state", fileIndex );
+    }
+
+    // The workers have to report it the same way, once it is the turn of the file.
+    for ( const _batchConfig& config : _batchConfigs )
+    {
+        std::string runName = std::string( "fail_" ) + config.name;
+
+        _batchRunResult result;
+
+        RunBatch( ctx, runName.c_str(), config.workerCount, config.memoryBudget, throwIndex, 0, result );
+
+        success &= CompareRuns( runName.c_str(), reference, result );
+    }
+
+    return success;
+}
+
+RWTEST_REGISTER( "txdgen.batch_failure", RWTEST_REGRESSION, test_batch_failure );
+
+static bool test_batch_cancel( rwtestContext& ctx )
+{
+    bool success = true;
+
+    for ( const _batchConfig& config : _batchConfigs )
+    {
+        std::string runName = std::string( "cancel_" ) + config.name;
+
+        _batchRunResult result;
+
+        RunBatch( ctx, runName.c_str(), config.workerCount, config.memoryBudget, 0xFFFFFFFF, 24, result );
+
+        success &= rwtestCheck( result.hasFailed == false, "%s: cancelled run failed", runName.c_str() );
+        success &= rwtestCheck( result.progress.bytesInFlight == 0, "%s: bytes still in flight after cancel", runName.c_str() );
+
+        // Whatever was written before the cancellation is a prefix of the submitted files.
+        bool hasGap = false;
+
+        for ( rw::uint32 fileIndex = 0; fileIndex < _batchFileCount; fileIndex++ )
+        {
+            bool isWritten = ( result.outputHashes[ fileIndex ] != 0 );
+
+            success &= rwtestCheck( !( hasGap && isWritten ), "%s: file %u written after a dropped file", runName.c_str(), fileIndex );
+            success &= rwtestCheck( !( isWritten && fileIndex >= 24 ), "%s: file %u written after cancel", runName.c_str(), fileIndex );
+
+            if ( !isWritten )
+            {
+                hasGap = true;
+            }
+        }
+    }
+
+    return success;
+}
+
+RWTEST_REGISTER( "txdgen.batch_cancel", RWTEST_REGRESSION, test_batch_cancel );
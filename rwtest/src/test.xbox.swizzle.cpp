@@ -0,0 +1,281 @@
+// Tests of the XBOX swizzle against simple implementations.
+// The table-driven swizzle has to order the texels exactly like a per-texel Morton reference, which
+// follows the rules of the XGraphics Swizzler, and for square textures like the recursive block walk
+// that was used before. Swizzling and unswizzling again has to give back the original texels.
+
+#include "rwtest.internal.h"
+
+#ifdef RWLIB_INCLUDE_NATIVETEX_XBOX
+
+#include "../../rwlib/src/txdread.xbox.hxx"
+
+#include <string.h>
+
+// Every power-of-two size up to this, in both dimensions.
+static const rw::uint32 _swizzleTestMaxGridDimm = 64;
+
+// Shapes with random power-of-two sizes and depths on top of the grid.
+static const unsigned int _swizzleTestRandomShapeCount = 160;
+static const rw::uint32 _swizzleTestMaxDimmLog2 = 11;
+static const rw::uint32 _swizzleTestMaxTexels = ( 1 << 18 );
+
+static const rw::uint32 _swizzleTestDepths[] = { 4, 8, 16, 24, 32 };
+
+// Interleaves the coordinate bits, starting with x. Once a dimension is out of bits, the other one takes the rest.
+static rw::uint32 GetMortonSwizzleIndex( rw::uint32 x, rw::uint32 y, rw::uint32 width, rw::uint32 height )
+{
+    rw::uint32 swizzleIndex = 0;
+    rw::uint32 outBit = 0;
+
+    for ( rw::uint32 n = 1, bit = 0; n < width || n < height; n <<= 1, bit++ )
+    {
+        if ( n < width )
+        {
+            swizzleIndex |= ( ( ( x >> bit ) & 1 ) << outBit++ );
+        }
+
+        if ( n < height )
+        {
+            swizzleIndex |= ( ( ( y >> bit ) & 1 ) << outBit++ );
+        }
+    }
+
+    return swizzleIndex;
+}
+
+static void CopySwizzleTestTexel(
+    const void *srcData, rw::uint32 srcX, rw::uint32 srcY,
+    void *dstData, rw::uint32 dstX, rw::uint32 dstY,
+    rw::uint32 rowSize, rw::uint32 depth
+)
+{
+    const void *srcRow = rw::getConstTexelDataRow( srcData, rowSize, srcY );
+    void *dstRow = rw::getTexelDataRow( dstData, rowSize, dstY );
+
+    if ( depth == 4 )
+    {
+        rw::PixelFormat::palette4bit::trav_t travItem;
+
+        ( (const rw::PixelFormat::palette4bit*)srcRow )->getvalue( srcX, travItem );
+        ( (rw::PixelFormat::palette4bit*)dstRow )->setvalue( dstX, travItem );
+    }
+    else
+    {
+        rw::uint32 texelSize = ( depth / 8 );
+
+        memcpy( (rw::uint8*)dstRow + dstX * texelSize, (const rw::uint8*)srcRow + srcX * texelSize, texelSize );
+    }
+}
+
+// The swizzled buffer is read like a linear one that has the same dimensions.
+static inline void MoveSwizzledTexel(
+    const void *srcData, void *dstData,
+    rw::uint32 linearX, rw::uint32 linearY, rw::uint32 swizzleIndex,
+    rw::uint32 width, rw::uint32 rowSize, rw::uint32 depth, bool isUnswizzle
+)
+{
+    rw::uint32 swizzleX = ( swizzleIndex % width );
+    rw::uint32 swizzleY = ( swizzleIndex / width );
+
+    if ( isUnswizzle )
+    {
+        CopySwizzleTestTexel( srcData, swizzleX, swizzleY, dstData, linearX, linearY, rowSize, depth );
+    }
+    else
+    {
+        CopySwizzleTestTexel( srcData, linearX, linearY, dstData, swizzleX, swizzleY, rowSize, depth );
+    }
+}
+
+static void ReferenceMortonSwizzle(
+    const void *srcData, void *dstData,
+    rw::uint32 width, rw::uint32 height, rw::uint32 rowSize, rw::uint32 depth, bool isUnswizzle
+)
+{
+    for ( rw::uint32 y = 0; y < height; y++ )
+    {
+        for ( rw::uint32 x = 0; x < width; x++ )
+        {
+            rw::uint32 swizzleIndex = GetMortonSwizzleIndex( x, y, width, height );
+
+            MoveSwizzledTexel( srcData, dstData, x, y, swizzleIndex, width, rowSize, depth, isUnswizzle );
+        }
+    }
+}
+
+// The recursive walk of the old swizzle: split the block into four quadrants (top left, top right,
+// bottom left, bottom right) until it is 2x2, whose texels come in row order.
+static void ReferenceBlockSwizzle(
+    const void *srcData, void *dstData,
+    rw::uint32 blockX, rw::uint32 blockY, rw::uint32 blockSize, rw::uint32& swizzleIndex,
+    rw::uint32 width, rw::uint32 rowSize, rw::uint32 depth, bool isUnswizzle
+)
+{
+    if ( blockSize <= 2 )
+    {
+        for ( rw::uint32 y = 0; y < blockSize; y++ )
+        {
+            for ( rw::uint32 x = 0; x < blockSize; x++ )
+            {
+                MoveSwizzledTexel( srcData, dstData, blockX + x, blockY + y, swizzleIndex++, width, rowSize, depth, isUnswizzle );
+            }
+        }
+
+        return;
+    }
+
+    rw::uint32 subSize = ( blockSize / 2 );
+
+    ReferenceBlockSwizzle( srcData, dstData, blockX, blockY, subSize, swizzleIndex, width, rowSize, depth, isUnswizzle );
+    ReferenceBlockSwizzle( srcData, dstData, blockX + subSize, blockY, subSize, swizzleIndex, width, rowSize, depth, isUnswizzle );
+    ReferenceBlockSwizzle( srcData, dstData, blockX, blockY + subSize, subSize, swizzleIndex, width, rowSize, depth, isUnswizzle );
+    ReferenceBlockSwizzle( srcData, dstData, blockX + subSize, blockY + subSize, subSize, swizzleIndex, width, rowSize, depth, isUnswizzle );
+}
+
+static void FillSwizzleTestData( std::vector <rw::uint8>& data, rw::uint32 seed )
+{
+    rwtestRandom random( seed );
+
+    for ( rw::uint8& value : data )
+    {
+        value = (rw::uint8)random.Next();
+    }
+}
+
+static bool CheckSwizzleShape( rw::uint32 width, rw::uint32 height, rw::uint32 depth, rw::uint32 seed )
+{
+    rw::uint32 rowAlignment = rw::getXBOXTextureDataRowAlignment();
+
+    rw::uint32 rowSize = rw::getRasterDataRowSize( width, depth, rowAlignment );
+
+    rw::uint32 dataSize = rw::getRasterDataSizeByRowSize( rowSize, height );
+
+    std::vector <rw::uint8> srcTexels( dataSize );
+    FillSwizzleTestData( srcTexels, seed );
+
+    for ( rw::uint32 direction = 0; direction < 2; direction++ )
+    {
+        bool isUnswizzle = ( direction == 1 );
+
+        const char *directionName = ( isUnswizzle ? "unswizzle" : "swizzle" );
+
+        // Row padding is not written, so it has to stay the same.
+        std::vector <rw::uint8> resultTexels( dataSize );
+        FillSwizzleTestData( resultTexels, seed + 1 );
+
+        std::vector <rw::uint8> referenceTexels( resultTexels );
+
+        rw::performXBOXSwizzle( srcTexels.data(), resultTexels.data(), width, height, depth, rowAlignment, isUnswizzle );
+
+        ReferenceMortonSwizzle( srcTexels.data(), referenceTexels.data(), width, height, rowSize, depth, isUnswizzle );
+
+        if ( !rwtestCheck( resultTexels == referenceTexels, "%ux%u, %u bit: %s differs from the Morton order", width, height, depth, directionName ) )
+            return false;
+
+        if ( width == height )
+        {
+            std::vector <rw::uint8> blockTexels( dataSize );
+            FillSwizzleTestData( blockTexels, seed + 1 );
+
+            rw::uint32 swizzleIndex = 0;
+
+            ReferenceBlockSwizzle( srcTexels.data(), blockTexels.data(), 0, 0, width, swizzleIndex, width, rowSize, depth, isUnswizzle );
+
+            if ( !rwtestCheck( resultTexels == blockTexels, "%ux%u, %u bit: %s differs from the block walk", width, height, depth, directionName ) )
+                return false;
+        }
+
+        // Going back has to give us the texels we started with.
+        std::vector <rw::uint8> roundTripTexels( resultTexels );
+
+        rw::performXBOXSwizzle( resultTexels.data(), roundTripTexels.data(), width, height, depth, rowAlignment, !isUnswizzle );
+
+        for ( rw::uint32 row = 0; row < height; row++ )
+        {
+            rw::uint32 rowBits = ( width * depth );
+
+            const rw::uint8 *srcRow = (const rw::uint8*)rw::getConstTexelDataRow( srcTexels.data(), rowSize, row );
+            const rw::uint8 *roundTripRow = (const rw::uint8*)rw::getConstTexelDataRow( roundTripTexels.data(), rowSize, row );
+
+            bool isRowEqual = ( memcmp( srcRow, roundTripRow, rowBits / 8 ) == 0 );
+
+            // Single 4bit texels only take the low nibble.
+            if ( isRowEqual && rowBits % 8 != 0 )
+            {
+                rw::PixelFormat::palette4bit::trav_t srcItem, roundTripItem;
+
+                ( (const rw::PixelFormat::palette4bit*)srcRow )->getvalue( width - 1, srcItem );
+                ( (const rw::PixelFormat::palette4bit*)roundTripRow )->getvalue( width - 1, roundTripItem );
+
+                isRowEqual = ( srcItem == roundTripItem );
+            }
+
+            if ( !rwtestCheck( isRowEqual, "%ux%u, %u bit: %s round trip differs in row %u", width, height, depth, directionName, row ) )
+                return false;
+        }
+    }
+
+    return true;
+}
+
+static bool test_xbox_swizzle_roundtrip( rwtestContext& ctx )
+{
+#ifdef _USE_XBOX_SDK_
+    // The XGraphics library does the swizzle, so there is no implementation of ours to compare.
+    rwtestLog( "  rwlib swizzles through the XBOX SDK; nothing to compare" );
+
+    return true;
+#else
+    rw::uint32 seed = 0;
+
+    for ( rw::uint32 depth : _swizzleTestDepths )
+    {
+        for ( rw::uint32 width = 1; width <= _swizzleTestMaxGridDimm; width *= 2 )
+        {
+            for ( rw::uint32 height = 1; height <= _swizzleTestMaxGridDimm; height *= 2 )
+            {
+                if ( !CheckSwizzleShape( width, height, depth, seed++ ) )
+                    return false;
+            }
+        }
+
+        // Very thin textures, where one dimension gets most of the bits.
+        if ( !CheckSwizzleShape( 1024, 2, depth, seed++ ) || !CheckSwizzleShape( 2, 1024, depth, seed++ ) )
+            return false;
+    }
+
+    rwtestRandom random( 0x5A1 );
+
+    const rw::uint32 depthCount = (rw::uint32)( sizeof( _swizzleTestDepths ) / sizeof( *_swizzleTestDepths ) );
+
+    for ( unsigned int n = 0; n < _swizzleTestRandomShapeCount; n++ )
+    {
+        rw::uint32 depth = _swizzleTestDepths[ random.NextBelow( depthCount ) ];
+
+        rw::uint32 width = ( 1u << random.NextBelow( _swizzleTestMaxDimmLog2 + 1 ) );
+        rw::uint32 height = ( 1u << random.NextBelow( _swizzleTestMaxDimmLog2 + 1 ) );
+
+        // Keep the run short by shrinking the bigger dimension.
+        while ( width * height > _swizzleTestMaxTexels )
+        {
+            if ( width > height )
+            {
+                width /= 2;
+            }
+            else
+            {
+                height /= 2;
+            }
+        }
+
+        if ( !CheckSwizzleShape( width, height, depth, random.Next() ) )
+            return false;
+    }
+
+    return true;
+#endif //_USE_XBOX_SDK_
+}
+
+RWTEST_REGISTER( "xbox.swizzle_roundtrip", RWTEST_REGRESSION, test_xbox_swizzle_roundtrip );
+
+#endif //RWLIB_INCLUDE_NATIVETEX_XBOX
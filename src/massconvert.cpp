@@ -243,6 +243,7 @@ MassConvertWindow::MassConvertWindow( MainWindow *mainwnd ) : QDialog( mainwnd )
     this->convConsistencyLock = rw::CreateReadWriteLock( rwEngine );
 
     this->conversionThread = NULL;
+    this->conversionModule = NULL;
 
     // buttons at the bottom
     QPushButton *buttonConvert = CreateButtonL("Tools.MassCnv.Convert");
@@ -279,6 +280,12 @@ MassConvertWindow::~MassConvertWindow( void )
 
     if ( rw::thread_t convThread = this->conversionThread )
     {
+        // Let the files that are being converted finish cleanly.
+        if ( TxdGenModule *convModule = this->conversionModule )
+        {
+            convModule->RequestCancel();
+        }
+
         convThread = rw::AcquireThread( rwEngine, convThread );
 
         this->convConsistencyLock->leave_read();
@@ -334,6 +341,18 @@ struct ConversionFinishEvent : public QEvent
     {}
 };
 
+struct ConversionProgressEvent : public QEvent
+{
+    inline ConversionProgressEvent( rw::uint32 filesWritten, rw::uint32 filesQueued ) : QEvent( QEvent::User )
+    {
+        this->filesWritten = filesWritten;
+        this->filesQueued = filesQueued;
+    }
+
+    rw::uint32 filesWritten;
+    rw::uint32 filesQueued;
+};
+
 void MassConvertWindow::postLogMessage( QString msg )
 {
     logEditControl.postLogMessage( std::move( msg ) );
@@ -362,6 +381,13 @@ struct MassConvertTxdGenModule : public TxdGenModule
     {
         return CreateDecompressedStream( massconvWnd->mainwnd, compressed );
     }
+
+    void OnBatchProgress( const txdgenBatchProgress& progress ) override
+    {
+        ConversionProgressEvent *evt = new ConversionProgressEvent( progress.filesWritten, progress.filesQueued );
+
+        QCoreApplication::postEvent( massconvWnd, evt );
+    }
 };
 
 static void convThreadEntryPoint( rw::thread_t threadHandle, rw::Interface *engineInterface, void *ud )
@@ -385,7 +411,33 @@ static void convThreadEntryPoint( rw::thread_t threadHandle, rw::Interface *engi
 
         MassConvertTxdGenModule module( massconvWnd, engineInterface );
 
-        module.ApplicationMain( run_cfg );
+        // Allow the window to cancel us.
+        massconvWnd->convConsistencyLock->enter_write();
+
+        massconvWnd->conversionModule = &module;
+
+        massconvWnd->convConsistencyLock->leave_write();
+
+        try
+        {
+            module.ApplicationMain( run_cfg );
+        }
+        catch( ... )
+        {
+            massconvWnd->convConsistencyLock->enter_write();
+
+            massconvWnd->conversionModule = NULL;
+
+            massconvWnd->convConsistencyLock->leave_write();
+
+            throw;
+        }
+
+        massconvWnd->convConsistencyLock->enter_write();
+
+        massconvWnd->conversionModule = NULL;
+
+        massconvWnd->convConsistencyLock->leave_write();
 
         // Notify the application that we finished.
         {
@@ -444,11 +496,24 @@ void MassConvertWindow::customEvent( QEvent *evt )
     // Handle events for the log.
     logEditControl.customEvent( evt );
     
+    if ( ConversionProgressEvent *convProgressEvt = dynamic_cast <ConversionProgressEvent*> ( evt ) )
+    {
+        // Show how far we are in the title.
+        this->setWindowTitle(
+            MAGIC_TEXT( "Tools.MassCnv.Desc" ) +
+            QString( " (%1/%2)" ).arg( convProgressEvt->filesWritten ).arg( convProgressEvt->filesQueued )
+        );
+
+        return;
+    }
+
     if ( ConversionFinishEvent *convEndEvt = dynamic_cast <ConversionFinishEvent*> ( evt ) )
     {
         // We can enable the conversion button again.
         this->buttonConvert->setDisabled( false );
 
+        this->setWindowTitle( MAGIC_TEXT( "Tools.MassCnv.Desc" ) );
+
         return;
     }
 
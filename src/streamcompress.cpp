@@ -194,7 +194,15 @@ CFile* CreateDecompressedStream( MainWindow *mainWnd, CFile *compressed )
         // If we found a compressed format...
         if ( theManager )
         {
-            // ... we want to create a random file and decompress into it.
+            // ... we prefer to decompress while reading, so that no temporary file is needed.
+            CFile *decStream = theManager->CreateDecompressionStream( compressed );
+
+            if ( decStream )
+            {
+                return decStream;
+            }
+
+            // Otherwise we want to create a random file and decompress into it.
             CFileTranslator *repo = env->GetRepository( mainWnd );
 
             if ( repo )
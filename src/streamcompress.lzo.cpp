@@ -64,6 +64,23 @@ struct lzoStreamCompressionManager : public compressionManager
         mainWnd->fileSystem->DestroyLZOCompressor( fsysHandler );
     }
 
+    CFile* CreateDecompressionStream( CFile *compressed ) override
+    {
+        CFile *decStream = NULL;
+
+        CIMGArchiveCompressionHandler *lzo = mainWnd->fileSystem->CreateLZOCompressor();
+
+        if ( lzo )
+        {
+            // The stream does not depend on the compressor.
+            decStream = lzo->OpenDecompressionStream( compressed );
+
+            mainWnd->fileSystem->DestroyLZOCompressor( lzo );
+        }
+
+        return decStream;
+    }
+
     MainWindow *mainWnd;
 };
 
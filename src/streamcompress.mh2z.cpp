@@ -80,6 +80,23 @@ struct mh2zCompressionEnv : public compressionManager
         }
     };
 
+    CFile* CreateDecompressionStream( CFile *compressed ) override
+    {
+        fsOffsetNumber_t startOffset = compressed->TellNative();
+
+        mh2zHeader header;
+
+        if ( !compressed->ReadStruct( header ) || header.magic_num != MAGIC_NUM )
+        {
+            compressed->SeekNative( startOffset, SEEK_SET );
+            return NULL;
+        }
+
+        size_t dataSize = (size_t)( compressed->GetSizeNative() - compressed->TellNative() );
+
+        return fileSystem->CreateZLIBDecompressionStream( compressed, dataSize, header.decomp_size, true );
+    }
+
     compressionProvider* CreateProvider( void ) override
     {
         mh2zCompressionProvider *prov = new mh2zCompressionProvider();
@@ -202,6 +202,9 @@ private:
 
                                     srcIMGRoot->ScanDirectory( "@", "*", true, NULL, _discFileCallback, &traverse );
 
+                                    // The sentry could still be busy with files of this archive.
+                                    info->sentry->OnArchiveScanEnd();
+
                                     if ( outputRoot_archive != NULL )
                                     {
                                         module->OnMessage( "writing " );
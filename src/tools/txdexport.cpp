@@ -220,6 +220,11 @@ struct _discFileSentry_txdexport
         return anyWork;
     }
 
+    inline void OnArchiveScanEnd( void )
+    {
+        return;
+    }
+
     inline void OnArchiveFail( const filePath& fileName, const filePath& extention )
     {
         return;
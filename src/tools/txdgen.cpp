@@ -4,6 +4,10 @@
 
 #include <iostream>
 #include <streambuf>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
 #include <gtaconfig/include.h>
 
 #include "dirtools.h"
@@ -21,15 +25,102 @@ static inline void ConvertRasterToPlatformEx( rw::TextureBase *theTexture, rw::R
     }
 }
 
+// Warnings of textures that are processed in parallel are kept per texture.
+// They are passed on in texture order once all textures are done, so the log looks the
+// same no matter how many threads were used.
+struct _txdgenTextureTask
+{
+    rw::TextureBase *texture;
+    std::vector <std::string> warnings;
+    double processTimeMS = 0;
+};
+
+typedef std::function <void ( rw::TextureBase* )> _txdgenProcessCallback_t;
+
+static void ProcessTextureTask( _txdgenTextureTask& task, const _txdgenProcessCallback_t& processTexture )
+{
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+    processTexture( task.texture );
+
+    task.processTimeMS = std::chrono::duration <double, std::milli> ( std::chrono::steady_clock::now() - startTime ).count();
+}
+
+// Processes all textures of a TXD on the threads of texturePool, or on this thread if there is no pool.
+// Every texture is processed by exactly one thread and the texture order is left untouched, so the
+// resulting TXD does not depend on the worker count. If a texture fails, the first error is rethrown.
+static void ProcessTexturesOrdered(
+    rw::Interface *rwEngine, rw::TexDictionary *txd, TxdGenTexturePool *texturePool, std::string *timingReportOut,
+    const _txdgenProcessCallback_t& processTexture
+)
+{
+    std::vector <_txdgenTextureTask> tasks;
+
+    for ( rw::TexDictionary::texIter_t iter = txd->GetTextureIterator(); !iter.IsEnd(); iter.Increment() )
+    {
+        _txdgenTextureTask task;
+        task.texture = iter.Resolve();
+
+        tasks.push_back( std::move( task ) );
+    }
+
+    if ( texturePool != NULL && texturePool->GetWorkerCount() > 1 && tasks.size() > 1 )
+    {
+        texturePool->Run( tasks.size(),
+            [&]( size_t taskIndex, txdgenWarningList& warningList )
+            {
+                _txdgenTextureTask& task = tasks[ taskIndex ];
+
+                warningList.messages = &task.warnings;
+
+                // We could have been asked to terminate.
+                rw::CheckThreadHazards( rwEngine );
+
+                ProcessTextureTask( task, processTexture );
+            }
+        );
+
+        // Pass on the warnings in texture order.
+        for ( _txdgenTextureTask& task : tasks )
+        {
+            for ( std::string& warning : task.warnings )
+            {
+                rwEngine->PushWarning( std::move( warning ) );
+            }
+        }
+    }
+    else
+    {
+        // Just do it on this thread, like we always did.
+        for ( _txdgenTextureTask& task : tasks )
+        {
+            ProcessTextureTask( task, processTexture );
+        }
+    }
+
+    if ( timingReportOut )
+    {
+        for ( const _txdgenTextureTask& task : tasks )
+        {
+            char timeBuf[ 32 ];
+            snprintf( timeBuf, sizeof( timeBuf ), "%.2f", task.processTimeMS );
+
+            *timingReportOut += "  - " + task.texture->GetName() + ": " + timeBuf + " ms\n";
+        }
+    }
+}
+
 bool TxdGenModule::ProcessTXDArchive(
-    CFileTranslator *srcRoot, CFile *srcStream, CFile *targetStream, eTargetPlatform targetPlatform, eTargetGame targetGame,
+    const filePath *debugSrcPath, CFile *srcStream, CFile *targetStream, eTargetPlatform targetPlatform, eTargetGame targetGame,
     bool clearMipmaps,
     bool generateMipmaps, rw::eMipmapGenerationMode mipGenMode, rw::uint32 mipGenMaxLevel,
     bool improveFiltering,
     bool doCompress, float compressionQuality,
     bool outputDebug, CFileTranslator *debugRoot,
+    TxdGenTexturePool *texturePool,
     const rw::LibraryVersion& gameVersion,
-    std::string& errMsg
+    std::string& errMsg,
+    std::string *timingReportOut
 ) const
 {
     rw::Interface *rwEngine = this->rwEngine;
@@ -80,185 +171,181 @@ bool TxdGenModule::ProcessTXDArchive(
             // Update the version of this texture dictionary.
             txd->SetEngineVersion( gameVersion );
 
-            try
+            // Runs the conversion pipeline on a single texture.
+            // Textures do not share any state, so this may be called from multiple threads at once.
+            auto processTexture = [&]( rw::TextureBase *theTexture )
             {
-                // Process all textures.
-                bool processSuccessful = true;
+                // Update the version of this texture.
+                theTexture->SetEngineVersion( gameVersion );
 
-                try
+                // We need to modify the raster.
+                rw::Raster *texRaster = theTexture->GetRaster();
+
+                if ( texRaster )
                 {
-                    for ( rw::TexDictionary::texIter_t iter = txd->GetTextureIterator(); !iter.IsEnd(); iter.Increment() )
-                    {
-                        rw::TextureBase *theTexture = iter.Resolve();
+                    // Decide whether to convert to target architecture beforehand or afterward.
+                    bool shouldConvertBeforehand = ShouldRasterConvertBeforehand( texRaster, targetPlatform );
 
-                        // Update the version of this texture.
-                        theTexture->SetEngineVersion( gameVersion );
+                    bool hasConvertedToTargetArchitecture = false;
 
-                        // We need to modify the raster.
-                        rw::Raster *texRaster = theTexture->GetRaster();
+                    if ( shouldConvertBeforehand == true )
+                    {
+                        ConvertRasterToPlatformEx( theTexture, texRaster, targetPlatform, targetGame );
 
-                        if ( texRaster )
-                        {
-                            // Decide whether to convert to target architecture beforehand or afterward.
-                            bool shouldConvertBeforehand = ShouldRasterConvertBeforehand( texRaster, targetPlatform );
+                        hasConvertedToTargetArchitecture = true;
+                    }
 
-                            bool hasConvertedToTargetArchitecture = false;
+                    // Clear mipmaps if requested.
+                    if ( clearMipmaps )
+                    {
+                        texRaster->clearMipmaps();
 
-                            if ( shouldConvertBeforehand == true )
-                            {
-                                ConvertRasterToPlatformEx( theTexture, texRaster, targetPlatform, targetGame );
+                        theTexture->fixFiltering();
+                    }
 
-                                hasConvertedToTargetArchitecture = true;
-                            }
+                    // Generate mipmaps on demand.
+                    if ( generateMipmaps )
+                    {
+                        // We generate as many mipmaps as we can.
+                        texRaster->generateMipmaps( mipGenMaxLevel + 1, mipGenMode );
 
-                            // Clear mipmaps if requested.
-                            if ( clearMipmaps )
-                            {
-                                texRaster->clearMipmaps();
+                        theTexture->fixFiltering();
+                    }
 
-                                theTexture->fixFiltering();
-                            }
+                    // Output debug stuff.
+                    if ( outputDebug && debugRoot != NULL && debugSrcPath != NULL )
+                    {
+                        // The file translators are not meant to be used by multiple threads at once.
+                        std::unique_lock <std::mutex> debugOutputLock( this->_debugOutputLock );
 
-                            // Generate mipmaps on demand.
-                            if ( generateMipmaps )
-                            {
-                                // We generate as many mipmaps as we can.
-                                texRaster->generateMipmaps( mipGenMaxLevel + 1, mipGenMode );
+                        // We want to debug mipmap generation, so output debug textures only using mipmaps.
+                        //if ( _meetsDebugCriteria( tex ) )
+                        {
+                            // Create a unique filename for this texture.
+                            filePath directoryPart;
 
-                                theTexture->fixFiltering();
-                            }
+                            filePath fileNamePart = FileSystem::GetFileNameItem( debugSrcPath->c_str(), false, &directoryPart, NULL );
 
-                            // Output debug stuff.
-                            if ( outputDebug && debugRoot != NULL )
+                            if ( fileNamePart.size() != 0 )
                             {
-                                // We want to debug mipmap generation, so output debug textures only using mipmaps.
-                                //if ( _meetsDebugCriteria( tex ) )
-                                {
-                                    std::wstring srcPath = srcStream->GetPath().convert_unicode();
+                                filePath uniqueTextureNameTGA = directoryPart + fileNamePart + "_" + filePath( theTexture->GetName().c_str() ) + ".tga";
 
-                                    filePath relSrcPath;
+                                CFile *debugOutputStream = debugRoot->Open( uniqueTextureNameTGA, "wb" );
 
-                                    bool hasRelSrcPath = srcRoot->GetRelativePathFromRoot( srcPath.c_str(), true, relSrcPath );
+                                if ( debugOutputStream )
+                                {
+                                    // Create a debug raster.
+                                    rw::Raster *newRaster = rw::CreateRaster( rwEngine );
 
-                                    if ( hasRelSrcPath )
+                                    if ( newRaster )
                                     {
-                                        // Create a unique filename for this texture.
-                                        filePath directoryPart;
+                                        try
+                                        {
+                                            newRaster->newNativeData( "Direct3D9" );
 
-                                        filePath fileNamePart = FileSystem::GetFileNameItem( relSrcPath.c_str(), false, &directoryPart, NULL );
+                                            // Put the debug content into it.
+                                            {
+                                                rw::Bitmap debugTexContent( rwEngine );
 
-                                        if ( fileNamePart.size() != 0 )
-                                        {
-                                            filePath uniqueTextureNameTGA = directoryPart + fileNamePart + "_" + filePath( theTexture->GetName().c_str() ) + ".tga";
+                                                debugTexContent.setBgColor( 1, 1, 1 );
 
-                                            CFile *debugOutputStream = debugRoot->Open( uniqueTextureNameTGA, "wb" );
+                                                bool gotDebugContent = rw::DebugDrawMipmaps( rwEngine, texRaster, debugTexContent );
 
-                                            if ( debugOutputStream )
+                                                if ( gotDebugContent )
+                                                {
+                                                    newRaster->setImageData( debugTexContent );
+                                                }
+                                            }
+
+                                            if ( newRaster->getMipmapCount() > 0 )
                                             {
-                                                // Create a debug raster.
-                                                rw::Raster *newRaster = rw::CreateRaster( rwEngine );
+                                                // Write the debug texture to it.
+                                                rw::Stream *outputStream = RwStreamCreateTranslated( rwEngine, debugOutputStream );
 
-                                                if ( newRaster )
+                                                if ( outputStream )
                                                 {
                                                     try
                                                     {
-                                                        newRaster->newNativeData( "Direct3D9" );
-
-                                                        // Put the debug content into it.
-                                                        {
-                                                            rw::Bitmap debugTexContent( rwEngine );
-
-                                                            debugTexContent.setBgColor( 1, 1, 1 );
-
-                                                            bool gotDebugContent = rw::DebugDrawMipmaps( rwEngine, texRaster, debugTexContent );
-
-                                                            if ( gotDebugContent )
-                                                            {
-                                                                newRaster->setImageData( debugTexContent );
-                                                            }
-                                                        }
-
-                                                        if ( newRaster->getMipmapCount() > 0 )
-                                                        {
-                                                            // Write the debug texture to it.
-                                                            rw::Stream *outputStream = RwStreamCreateTranslated( rwEngine, debugOutputStream );
-
-                                                            if ( outputStream )
-                                                            {
-                                                                try
-                                                                {
-                                                                    newRaster->writeImage( outputStream, "TGA" );
-                                                                }
-                                                                catch( ... )
-                                                                {
-                                                                    rwEngine->DeleteStream( outputStream );
-
-                                                                    throw;
-                                                                }
-
-                                                                rwEngine->DeleteStream( outputStream );
-                                                            }
-                                                        }
+                                                        newRaster->writeImage( outputStream, "TGA" );
                                                     }
                                                     catch( ... )
                                                     {
-                                                        rw::DeleteRaster( newRaster );
+                                                        rwEngine->DeleteStream( outputStream );
 
                                                         throw;
                                                     }
 
-                                                    rw::DeleteRaster( newRaster );
+                                                    rwEngine->DeleteStream( outputStream );
                                                 }
-
-                                                // Free the stream handle.
-                                                delete debugOutputStream;
                                             }
                                         }
+                                        catch( ... )
+                                        {
+                                            rw::DeleteRaster( newRaster );
+
+                                            throw;
+                                        }
+
+                                        rw::DeleteRaster( newRaster );
                                     }
+
+                                    // Free the stream handle.
+                                    delete debugOutputStream;
                                 }
                             }
+                        }
+                    }
 
-                            // Palettize the texture to save space.
-                            if ( doCompress )
-                            {
-                                // If we are not target architecture already, make sure we are.
-                                if ( hasConvertedToTargetArchitecture == false )
-                                {
-                                    ConvertRasterToPlatformEx( theTexture, texRaster, targetPlatform, targetGame );
+                    // Palettize the texture to save space.
+                    if ( doCompress )
+                    {
+                        // If we are not target architecture already, make sure we are.
+                        if ( hasConvertedToTargetArchitecture == false )
+                        {
+                            ConvertRasterToPlatformEx( theTexture, texRaster, targetPlatform, targetGame );
 
-                                    hasConvertedToTargetArchitecture = true;
-                                }
+                            hasConvertedToTargetArchitecture = true;
+                        }
 
-                                if ( targetPlatform == PLATFORM_PS2 )
-                                {
-                                    texRaster->optimizeForLowEnd( compressionQuality );
-                                }
-                                else if ( targetPlatform == PLATFORM_XBOX || targetPlatform == PLATFORM_PC )
-                                {
-                                    // Compress if we are not already compressed.
-                                    texRaster->compress( compressionQuality );
-                                }
-                            }
+                        if ( targetPlatform == PLATFORM_PS2 )
+                        {
+                            texRaster->optimizeForLowEnd( compressionQuality );
+                        }
+                        else if ( targetPlatform == PLATFORM_XBOX || targetPlatform == PLATFORM_PC )
+                        {
+                            // Compress if we are not already compressed.
+                            texRaster->compress( compressionQuality );
+                        }
+                    }
 
-                            // Improve the filtering mode if the user wants us to.
-                            if ( improveFiltering )
-                            {
-                                theTexture->improveFiltering();
-                            }
+                    // Improve the filtering mode if the user wants us to.
+                    if ( improveFiltering )
+                    {
+                        theTexture->improveFiltering();
+                    }
 
-                            // Convert it into the target platform.
-                            if ( shouldConvertBeforehand == false )
-                            {
-                                if ( hasConvertedToTargetArchitecture == false )
-                                {
-                                    ConvertRasterToPlatformEx( theTexture, texRaster, targetPlatform, targetGame );
+                    // Convert it into the target platform.
+                    if ( shouldConvertBeforehand == false )
+                    {
+                        if ( hasConvertedToTargetArchitecture == false )
+                        {
+                            ConvertRasterToPlatformEx( theTexture, texRaster, targetPlatform, targetGame );
 
-                                    hasConvertedToTargetArchitecture = true;
-                                }
-                            }
+                            hasConvertedToTargetArchitecture = true;
                         }
                     }
                 }
+            };
+
+            try
+            {
+                // Process all textures.
+                bool processSuccessful = true;
+
+                try
+                {
+                    ProcessTexturesOrdered( rwEngine, txd, texturePool, timingReportOut, processTexture );
+                }
                 catch( rw::RwException& except )
                 {
                     errMsg = "error processing textures: " + except.message;
@@ -354,6 +441,7 @@ bool TxdGenModule::ProcessTXDArchive(
 struct _discFileSentry_txdgen
 {
     TxdGenModule *module;
+    TxdGenBatchScheduler *batch;
     rwkind::eTargetPlatform targetPlatform;
     rwkind::eTargetGame targetGame;
     bool clearMipmaps;
@@ -366,6 +454,8 @@ struct _discFileSentry_txdgen
     rw::LibraryVersion gameVersion;
     bool outputDebug;
     CFileTranslator *debugTranslator;
+    TxdGenTexturePool *texturePool;
+    bool reportTextureTiming;
 
     inline bool OnSingletonFile(
         CFileTranslator *sourceRoot, CFileTranslator *buildRoot, const filePath& relPathFromRoot,
@@ -376,86 +466,84 @@ struct _discFileSentry_txdgen
         // If we are asked to terminate, just do it.
         rw::CheckThreadHazards( module->GetEngine() );
 
-        // Decide whether we need a copy.
-        bool requiresCopy = false;
-
-        bool anyWork = false;
-
-        if ( extention.equals( "TXD", false ) == true || isInArchive )
+        if ( module->IsCancelRequested() )
         {
-            requiresCopy = true;
-        }
-
-        // Open the target stream.
-        CFile *targetStream = NULL;
+            batch->Cancel();
 
-        if ( requiresCopy )
-        {
-            targetStream = buildRoot->Open( relPathFromRoot, L"wb" );
+            return false;
         }
 
-        if ( targetStream && sourceStream )
-        {
-            // Allow to perform custom logic on the source and target streams.
-            bool hasCopiedFile = false;
-            {
-                if ( extention.equals( "TXD", false ) == true )
-                {
-                    module->OnMessage( "*** " + relPathFromRoot.convert_ansi() + " ..." );
+        if ( !sourceStream )
+            return false;
 
-                    std::string errorMessage;
+        bool isTXD = ( extention.equals( "TXD", false ) == true );
 
-                    bool couldProcessTXD = this->module->ProcessTXDArchive(
-                        sourceRoot, sourceStream, targetStream, this->targetPlatform, this->targetGame,
-                        this->clearMipmaps,
-                        this->generateMipmaps, this->mipGenMode, this->mipGenMaxLevel,
-                        this->improveFiltering,
-                        this->doCompress, this->compressionQuality,
-                        this->outputDebug, this->debugTranslator,
-                        this->gameVersion,
-                        errorMessage
-                    );
+        // Only TXD files and the contents of archives end up in the build root.
+        if ( isTXD == false && isInArchive == false )
+            return false;
 
-                    if ( couldProcessTXD )
-                    {
-                        hasCopiedFile = true;
+        TxdGenBatchScheduler::convertCallback_t convertCallback;
+        std::string logHeader;
 
-                        anyWork = true;
+        if ( isTXD )
+        {
+            logHeader = "*** " + relPathFromRoot.convert_ansi() + " ...";
 
-                        module->OnMessage( "OK\n" );
-                    }
-                    else
-                    {
-                        module->OnMessage( "error:\n" + errorMessage + "\n" );
-                    }
+            // The source root is busy with the scan on this thread, so the workers must not touch it.
+            // Resolve the path that names the debug output right here instead.
+            filePath debugSrcPath;
+            bool hasDebugSrcPath = false;
 
-                    // Output any warnings.
-                    module->_warningMan.Purge();
-                }
+            if ( this->outputDebug )
+            {
+                std::wstring srcPath = sourceStream->GetPath().convert_unicode();
+
+                hasDebugSrcPath = sourceRoot->GetRelativePathFromRoot( srcPath.c_str(), true, debugSrcPath );
             }
 
-            if ( requiresCopy )
+            // This runs on a worker thread of the batch scheduler.
+            convertCallback = [this, debugSrcPath, hasDebugSrcPath]( CFile *srcStream, CFile *targetStream, std::string& logOut ) -> bool
             {
-                // If we have not yet created the new copy, we default to simple stream swap.
-                if ( !hasCopiedFile && targetStream )
+                std::string errorMessage;
+                std::string timingReport;
+
+                bool couldProcessTXD = this->module->ProcessTXDArchive(
+                    ( hasDebugSrcPath ? &debugSrcPath : NULL ), srcStream, targetStream, this->targetPlatform, this->targetGame,
+                    this->clearMipmaps,
+                    this->generateMipmaps, this->mipGenMode, this->mipGenMaxLevel,
+                    this->improveFiltering,
+                    this->doCompress, this->compressionQuality,
+                    this->outputDebug, this->debugTranslator,
+                    this->texturePool,
+                    this->gameVersion,
+                    errorMessage,
+                    ( this->reportTextureTiming ? &timingReport : NULL )
+                );
+
+                if ( couldProcessTXD )
                 {
-                    // Make sure we copy from the beginning of the source stream.
-                    sourceStream->Seek( 0, SEEK_SET );
-                    
-                    // Copy the stream contents.
-                    FileSystem::StreamCopy( *sourceStream, *targetStream );
-
-                    hasCopiedFile = true;
+                    logOut += "OK\n";
+                    logOut += timingReport;
+                }
+                else
+                {
+                    logOut += "error:\n" + errorMessage + "\n";
                 }
-            }
-        }
 
-        if ( targetStream )
-        {
-            delete targetStream;
+                return couldProcessTXD;
+            };
         }
 
-        return anyWork;
+        // Files that are not converted are copied, in order, so that rebuilt archives keep their layout.
+        batch->Submit( buildRoot, relPathFromRoot, sourceStream, std::move( logHeader ), std::move( convertCallback ) );
+
+        return isTXD;
+    }
+
+    inline void OnArchiveScanEnd( void )
+    {
+        // The archive is saved or closed after this, so every file of it has to be written.
+        batch->Flush();
     }
 
     inline void OnArchiveFail( const filePath& fileName, const filePath& extention )
@@ -554,6 +642,14 @@ TxdGenModule::run_config TxdGenModule::ParseConfig( CFileTranslator *root, const
                     {
                         cfg.c_mipGenMode = rw::MIPMAPGEN_SELECTCLOSE;
                     } 
+                    else if ( stricmp( mipGenMode, "srgb" ) == 0 )
+                    {
+                        cfg.c_mipGenMode = rw::MIPMAPGEN_SRGB;
+                    }
+                    else if ( stricmp( mipGenMode, "premultipliedalpha" ) == 0 )
+                    {
+                        cfg.c_mipGenMode = rw::MIPMAPGEN_PREMULTIPLIED_ALPHA;
+                    }
                 }
 
                 // Mipmap generation maximum level.
@@ -613,6 +709,20 @@ TxdGenModule::run_config TxdGenModule::ParseConfig( CFileTranslator *root, const
                     }
                 }
 
+                // PVRTC compression method.
+                if ( const char *pvrCompressionMethod = mainEntry->Get( "pvrRuntimeType" ) )
+                {
+                    if ( stricmp( pvrCompressionMethod, "native" ) == 0 )
+                    {
+                        cfg.c_pvrRuntimeType = rw::PVRRUNTIME_NATIVE;
+                    }
+                    else if ( stricmp( pvrCompressionMethod, "pvrtexlib" ) == 0 ||
+                                stricmp( pvrCompressionMethod, "recommended" ) == 0 )
+                    {
+                        cfg.c_pvrRuntimeType = rw::PVRRUNTIME_PVRTEXLIB;
+                    }
+                }
+
                 // Warning level.
                 if ( mainEntry->Find( "warningLevel" ) )
                 {
@@ -660,6 +770,44 @@ TxdGenModule::run_config TxdGenModule::ParseConfig( CFileTranslator *root, const
                 {
                     cfg.c_outputDebug = mainEntry->GetBool( "outputDebug" );
                 }
+
+                // Amount of threads that process the textures of a TXD.
+                if ( mainEntry->Find( "workerCount" ) )
+                {
+                    int workerCountInt = mainEntry->GetInt( "workerCount" );
+
+                    if ( workerCountInt >= 0 )
+                    {
+                        cfg.c_workerCount = (rw::uint32)workerCountInt;
+                    }
+                }
+
+                if ( mainEntry->Find( "reportTextureTiming" ) )
+                {
+                    cfg.c_reportTextureTiming = mainEntry->GetBool( "reportTextureTiming" );
+                }
+
+                // Amount of threads that convert TXD files at the same time.
+                if ( mainEntry->Find( "batchWorkerCount" ) )
+                {
+                    int batchWorkerCountInt = mainEntry->GetInt( "batchWorkerCount" );
+
+                    if ( batchWorkerCountInt >= 0 )
+                    {
+                        cfg.c_batchWorkerCount = (rw::uint32)batchWorkerCountInt;
+                    }
+                }
+
+                // Memory (in megabytes) that files in flight may take.
+                if ( mainEntry->Find( "batchMemoryBudget" ) )
+                {
+                    int batchMemoryBudgetInt = mainEntry->GetInt( "batchMemoryBudget" );
+
+                    if ( batchMemoryBudgetInt > 0 )
+                    {
+                        cfg.c_batchMemoryBudget = (rw::uint32)batchMemoryBudgetInt;
+                    }
+                }
             }
 
             // Kill the configuration.
@@ -687,6 +835,7 @@ bool TxdGenModule::ApplicationMain( const run_config& cfg )
         // Set some configuration.
         rwEngine->SetPaletteRuntime( cfg.c_palRuntimeType );
         rwEngine->SetDXTRuntime( cfg.c_dxtRuntimeType );
+        rwEngine->SetPVRRuntime( cfg.c_pvrRuntimeType );
 
         // We inherit certain properties from Magic.TXD, so we do not want to set them here anymore.
 #if 0
@@ -804,6 +953,14 @@ bool TxdGenModule::ApplicationMain( const run_config& cfg )
         {
             mipGenModeString = "selectclose";
         }
+        else if ( cfg.c_mipGenMode == rw::MIPMAPGEN_SRGB )
+        {
+            mipGenModeString = "srgb";
+        }
+        else if ( cfg.c_mipGenMode == rw::MIPMAPGEN_PREMULTIPLIED_ALPHA )
+        {
+            mipGenModeString = "premultipliedalpha";
+        }
 
         this->OnMessage(
             std::string( "* mipGenMode: " ) + mipGenModeString + "\n"
@@ -859,6 +1016,23 @@ bool TxdGenModule::ApplicationMain( const run_config& cfg )
             std::string( "* dxtRuntimeType: " ) + strDXTRuntimeType + "\n"
         );
 
+        rw::ePVRCompressionMethod actualPVRRuntimeType = rwEngine->GetPVRRuntime();
+
+        const char *strPVRRuntimeType = "unknown";
+
+        if ( actualPVRRuntimeType == rw::PVRRUNTIME_NATIVE )
+        {
+            strPVRRuntimeType = "native";
+        }
+        else if ( actualPVRRuntimeType == rw::PVRRUNTIME_PVRTEXLIB )
+        {
+            strPVRRuntimeType = "pvrtexlib";
+        }
+
+        this->OnMessage(
+            std::string( "* pvrRuntimeType: " ) + strPVRRuntimeType + "\n"
+        );
+
         this->OnMessage(
             std::string( "* warningLevel: " ) + std::to_string( rwEngine->GetWarningLevel() ) + "\n"
         );
@@ -887,6 +1061,22 @@ bool TxdGenModule::ApplicationMain( const run_config& cfg )
             std::string( "* ignoreSerializationRegions: " ) + ( rwEngine->GetIgnoreSerializationBlockRegions() ? "true" : "false" ) + "\n"
         );
 
+        this->OnMessage(
+            std::string( "* workerCount: " ) + ( cfg.c_workerCount == 0 ? std::string( "auto" ) : std::to_string( cfg.c_workerCount ) ) + "\n"
+        );
+
+        this->OnMessage(
+            std::string( "* reportTextureTiming: " ) + ( cfg.c_reportTextureTiming ? "true" : "false" ) + "\n"
+        );
+
+        this->OnMessage(
+            std::string( "* batchWorkerCount: " ) + ( cfg.c_batchWorkerCount == 0 ? std::string( "auto" ) : std::to_string( cfg.c_batchWorkerCount ) ) + "\n"
+        );
+
+        this->OnMessage(
+            std::string( "* batchMemoryBudget: " ) + std::to_string( cfg.c_batchMemoryBudget ) + " MB\n"
+        );
+
         // Finish with a newline.
         this->OnMessage( "\n" );
 
@@ -926,8 +1116,37 @@ bool TxdGenModule::ApplicationMain( const run_config& cfg )
 
                     fileProc.setUseCompressedIMGArchives( cfg.c_imgArchivesCompressed );
 
+                    // Threads that process the textures of a TXD are kept for the whole run.
+                    // The pool has to outlive the batch, whose workers use it.
+                    TxdGenTexturePool texturePool( rwEngine );
+
+                    // Files are read and written on this thread while the workers convert them.
+                    TxdGenBatchScheduler batch(
+                        rwEngine, this, cfg.c_batchWorkerCount,
+                        (size_t)std::max( cfg.c_batchMemoryBudget, 1u ) * 1024 * 1024
+                    );
+
+                    batch.onProgress = [this]( const txdgenBatchProgress& progress )
+                    {
+                        this->OnBatchProgress( progress );
+                    };
+
+                    // If whole files are converted in parallel already, we do not split every TXD across all processors again.
+                    rw::uint32 textureWorkerCount = cfg.c_workerCount;
+
+                    if ( textureWorkerCount == 0 && batch.GetWorkerCount() > 1 )
+                    {
+                        textureWorkerCount = 1;
+                    }
+
+                    if ( textureWorkerCount != 1 )
+                    {
+                        texturePool.EnsureWorkers( textureWorkerCount );
+                    }
+
                     _discFileSentry_txdgen sentry;
                     sentry.module = this;
+                    sentry.batch = &batch;
                     sentry.targetPlatform = cfg.c_targetPlatform;
                     sentry.targetGame = cfg.c_gameType;
                     sentry.clearMipmaps = cfg.c_clearMipmaps;
@@ -940,9 +1159,19 @@ bool TxdGenModule::ApplicationMain( const run_config& cfg )
                     sentry.gameVersion = targetVersion;
                     sentry.outputDebug = cfg.c_outputDebug;
                     sentry.debugTranslator = absDebugOutputTranslator;
+                    sentry.texturePool = &texturePool;
+                    sentry.reportTextureTiming = cfg.c_reportTextureTiming;
 
                     fileProc.process( &sentry, absGameRootTranslator, absOutputRootTranslator );
 
+                    // Write the files that are still in flight.
+                    batch.Flush();
+
+                    if ( batch.IsCancelled() )
+                    {
+                        this->OnMessage( "conversion cancelled\n" );
+                    }
+
                     // Output any warnings.
                     _warningMan.Purge();
                 }
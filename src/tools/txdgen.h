@@ -2,6 +2,10 @@
 #define _TXDGEN_MODULE_
 
 #include "shared.h"
+#include "txdgenbatch.h"
+
+#include <atomic>
+#include <mutex>
 
 class TxdGenModule : public MessageReceiver
 {
@@ -10,6 +14,7 @@ public:
     {
         this->rwEngine = rwEngine;
         this->_warningMan.module = this;
+        this->_cancelRequested = false;
     }
 
     struct run_config
@@ -38,6 +43,8 @@ public:
 
         rw::eDXTCompressionMethod c_dxtRuntimeType = rw::DXTRUNTIME_SQUISH;
 
+        rw::ePVRCompressionMethod c_pvrRuntimeType = rw::PVRRUNTIME_PVRTEXLIB;
+
         bool c_reconstructIMGArchives = true;
 
         bool c_fixIncompatibleRasters = true;
@@ -54,6 +61,19 @@ public:
         int c_warningLevel = 3;
 
         bool c_ignoreSecureWarnings = false;
+
+        // Amount of threads that process the textures of a TXD, zero means one per processor.
+        // Stays sequential unless the config asks for more.
+        rw::uint32 c_workerCount = 1;
+
+        bool c_reportTextureTiming = false;
+
+        // Amount of threads that convert TXD files at the same time, zero means one per processor.
+        // Converts one file after another unless the config asks for more.
+        rw::uint32 c_batchWorkerCount = 1;
+
+        // Memory in megabytes that files waiting for conversion or writing may take.
+        rw::uint32 c_batchMemoryBudget = 256;
     };
 
     run_config ParseConfig( CFileTranslator *root, const filePath& cfgPath ) const;
@@ -61,14 +81,16 @@ public:
     bool ApplicationMain( const run_config& cfg );
 
     bool ProcessTXDArchive(
-        CFileTranslator *srcRoot, CFile *srcStream, CFile *targetStream, rwkind::eTargetPlatform targetPlatform, rwkind::eTargetGame targetGame,
+        const filePath *debugSrcPath, CFile *srcStream, CFile *targetStream, rwkind::eTargetPlatform targetPlatform, rwkind::eTargetGame targetGame,
         bool clearMipmaps,
         bool generateMipmaps, rw::eMipmapGenerationMode mipGenMode, rw::uint32 mipGenMaxLevel,
         bool improveFiltering,
         bool doCompress, float compressionQuality,
         bool outputDebug, CFileTranslator *debugRoot,
+        TxdGenTexturePool *texturePool,
         const rw::LibraryVersion& gameVersion,
-        std::string& errMsg
+        std::string& errMsg,
+        std::string *timingReportOut = NULL
     ) const;
 
     rw::Interface* GetEngine( void ) const
@@ -76,6 +98,23 @@ public:
         return this->rwEngine;
     }
 
+    // Called on the thread that runs ApplicationMain whenever a file was queued or written.
+    virtual void OnBatchProgress( const txdgenBatchProgress& progress )
+    {
+        return;
+    }
+
+    // Can be called from any thread; stops the conversion after the files that are being converted.
+    void RequestCancel( void )
+    {
+        this->_cancelRequested = true;
+    }
+
+    bool IsCancelRequested( void ) const
+    {
+        return this->_cancelRequested;
+    }
+
     struct RwWarningBuffer : public rw::WarningManagerInterface
     {
         TxdGenModule *module;
@@ -109,8 +148,13 @@ public:
 
     RwWarningBuffer _warningMan;
 
+    // The debug output translator may be used by one thread at a time only.
+    mutable std::mutex _debugOutputLock;
+
 private:
     rw::Interface *rwEngine;
+
+    std::atomic <bool> _cancelRequested;
 };
 
 #endif //_TXDGEN_MODULE_
\ No newline at end of file
@@ -0,0 +1,891 @@
+// Does not use the precompiled header, so that rwtest can build the scheduler without the editor.
+#include <renderware.h>
+
+#include <CFileSystemInterface.h>
+#include <CFileSystem.h>
+
+#include <string.h>
+
+#include "txdgenbatch.h"
+
+#include <algorithm>
+#include <thread>
+
+// Memory file implementation.
+txdgenMemoryFile::txdgenMemoryFile( void )
+{
+    this->seekPos = 0;
+    this->hasStats = false;
+}
+
+size_t txdgenMemoryFile::Read( void *buffer, size_t sElement, size_t iNumElements )
+{
+    if ( sElement == 0 || this->seekPos >= this->data.size() )
+        return 0;
+
+    size_t availableCount = ( this->data.size() - this->seekPos ) / sElement;
+
+    size_t readCount = std::min( iNumElements, availableCount );
+
+    size_t readBytes = ( readCount * sElement );
+
+    memcpy( buffer, this->data.data() + this->seekPos, readBytes );
+
+    this->seekPos += readBytes;
+
+    return readCount;
+}
+
+size_t txdgenMemoryFile::Write( const void *buffer, size_t sElement, size_t iNumElements )
+{
+    size_t writeBytes = ( sElement * iNumElements );
+
+    if ( writeBytes == 0 )
+        return 0;
+
+    size_t writeEnd = ( this->seekPos + writeBytes );
+
+    if ( writeEnd > this->data.size() )
+    {
+        // Gaps that were created by seeking are filled with zeroes.
+        this->data.resize( writeEnd );
+    }
+
+    memcpy( this->data.data() + this->seekPos, buffer, writeBytes );
+
+    this->seekPos = writeEnd;
+
+    return iNumElements;
+}
+
+int txdgenMemoryFile::Seek( long iOffset, int iType )
+{
+    return this->SeekNative( iOffset, iType );
+}
+
+int txdgenMemoryFile::SeekNative( fsOffsetNumber_t iOffset, int iType )
+{
+    fsOffsetNumber_t basePos;
+
+    if ( iType == SEEK_SET )
+    {
+        basePos = 0;
+    }
+    else if ( iType == SEEK_CUR )
+    {
+        basePos = (fsOffsetNumber_t)this->seekPos;
+    }
+    else if ( iType == SEEK_END )
+    {
+        basePos = (fsOffsetNumber_t)this->data.size();
+    }
+    else
+    {
+        return -1;
+    }
+
+    fsOffsetNumber_t newPos = ( basePos + iOffset );
+
+    if ( newPos < 0 )
+        return -1;
+
+    this->seekPos = (size_t)newPos;
+
+    return 0;
+}
+
+long txdgenMemoryFile::Tell( void ) const
+{
+    return (long)this->seekPos;
+}
+
+fsOffsetNumber_t txdgenMemoryFile::TellNative( void ) const
+{
+    return (fsOffsetNumber_t)this->seekPos;
+}
+
+bool txdgenMemoryFile::IsEOF( void ) const
+{
+    return ( this->seekPos >= this->data.size() );
+}
+
+bool txdgenMemoryFile::Stat( struct stat *stats ) const
+{
+    if ( this->hasStats == false )
+        return false;
+
+    *stats = this->stats;
+
+    stats->st_size = (decltype( stats->st_size ))this->data.size();
+
+    return true;
+}
+
+void txdgenMemoryFile::PushStat( const struct stat *stats )
+{
+    this->stats = *stats;
+    this->hasStats = true;
+}
+
+void txdgenMemoryFile::SetSeekEnd( void )
+{
+    if ( this->seekPos < this->data.size() )
+    {
+        this->data.resize( this->seekPos );
+    }
+}
+
+size_t txdgenMemoryFile::GetSize( void ) const
+{
+    return this->data.size();
+}
+
+fsOffsetNumber_t txdgenMemoryFile::GetSizeNative( void ) const
+{
+    return (fsOffsetNumber_t)this->data.size();
+}
+
+void txdgenMemoryFile::Flush( void )
+{
+    return;
+}
+
+const filePath& txdgenMemoryFile::GetPath( void ) const
+{
+    return this->path;
+}
+
+bool txdgenMemoryFile::IsReadable( void ) const
+{
+    return true;
+}
+
+bool txdgenMemoryFile::IsWriteable( void ) const
+{
+    return true;
+}
+
+void txdgenMemoryFile::ReadFrom( CFile *srcStream )
+{
+    this->path = srcStream->GetPath();
+
+    this->hasStats = srcStream->Stat( &this->stats );
+
+    fsOffsetNumber_t remainingSize = ( srcStream->GetSizeNative() - srcStream->TellNative() );
+
+    if ( remainingSize > 0 )
+    {
+        this->data.reserve( this->data.size() + (size_t)remainingSize );
+    }
+
+    // Some streams (like decompressing ones) do not know their size, so read until the end.
+    char buffer[ 65536 ];
+
+    while ( true )
+    {
+        size_t readCount = srcStream->Read( buffer, 1, sizeof( buffer ) );
+
+        if ( readCount == 0 )
+            break;
+
+        this->data.insert( this->data.end(), buffer, buffer + readCount );
+    }
+
+    this->seekPos = 0;
+}
+
+void txdgenMemoryFile::Clear( void )
+{
+    std::vector <char> ().swap( this->data );
+
+    this->seekPos = 0;
+}
+
+// Batch scheduler implementation.
+TxdGenBatchScheduler::TxdGenBatchScheduler( rw::Interface *rwEngine, MessageReceiver *receiver, rw::uint32 workerCount, size_t memoryBudget )
+{
+    this->rwEngine = rwEngine;
+    this->receiver = receiver;
+    this->memoryBudget = memoryBudget;
+    this->isTerminating = false;
+    this->isCancelled = false;
+
+    this->lock = rw::CreateReadWriteLock( rwEngine );
+    this->workAvailableCond = rw::CreateConditionVariable( rwEngine );
+    this->jobFinishedCond = rw::CreateConditionVariable( rwEngine );
+
+    if ( workerCount == 0 )
+    {
+        workerCount = std::thread::hardware_concurrency();
+    }
+
+    if ( workerCount > 1 )
+    {
+        // The workers have to convert like the thread that created us.
+        this->threadConfig.Capture( rwEngine );
+
+        for ( rw::uint32 n = 0; n < workerCount; n++ )
+        {
+            rw::thread_t worker = rw::MakeThread( rwEngine, _WorkerThreadMain, this );
+
+            if ( worker == NULL )
+                break;
+
+            this->workers.push_back( worker );
+
+            rw::ResumeThread( rwEngine, worker );
+        }
+    }
+}
+
+TxdGenBatchScheduler::~TxdGenBatchScheduler( void )
+{
+    // Anything that was not flushed is dropped.
+    this->Cancel();
+
+    {
+        rw::scoped_rwlock_writer <rw::rwlock> lock( this->lock );
+
+        // Wait for the files that the workers are still busy with.
+        // We must not check for thread hazards here, because we could be unwinding already.
+        while ( !this->submittedJobs.empty() )
+        {
+            batchJob *job = this->submittedJobs.front();
+
+            if ( job->isFinished == false )
+            {
+                this->jobFinishedCond->wait( this->lock );
+                continue;
+            }
+
+            this->submittedJobs.pop_front();
+
+            delete job;
+        }
+    }
+
+    this->StopWorkers();
+
+    rw::CloseConditionVariable( this->rwEngine, this->jobFinishedCond );
+    rw::CloseConditionVariable( this->rwEngine, this->workAvailableCond );
+    rw::CloseReadWriteLock( this->rwEngine, this->lock );
+}
+
+rw::uint32 TxdGenBatchScheduler::GetWorkerCount( void ) const
+{
+    return (rw::uint32)this->workers.size();
+}
+
+void TxdGenBatchScheduler::Submit(
+    CFileTranslator *targetRoot, const filePath& targetPath, CFile *srcStream,
+    std::string logHeader, convertCallback_t convert
+)
+{
+    if ( this->isCancelled )
+        return;
+
+    srcStream->Seek( 0, SEEK_SET );
+
+    if ( this->workers.empty() == false )
+    {
+        // Wait until the file fits into our memory budget, before we load it.
+        // Streams that do not know their size (like decompressing ones) are accounted for once they are loaded.
+        // We always accept a file if nothing else is in flight, so that big files cannot block us.
+        fsOffsetNumber_t srcSize = srcStream->GetSizeNative();
+
+        size_t expectedMemoryUsage = ( srcSize > 0 ? (size_t)srcSize : 0 );
+
+        while ( true )
+        {
+            this->RetireFinishedJobs( false );
+
+            rw::scoped_rwlock_writer <rw::rwlock> lock( this->lock );
+
+            if ( this->submittedJobs.empty() || this->progress.bytesInFlight + expectedMemoryUsage <= this->memoryBudget )
+                break;
+
+            if ( this->submittedJobs.front()->isFinished == false )
+            {
+                this->WaitStep();
+            }
+        }
+    }
+
+    batchJob *job = new batchJob;
+
+    try
+    {
+        job->targetRoot = targetRoot;
+        job->targetPath = targetPath;
+        job->logHeader = std::move( logHeader );
+        job->convert = std::move( convert );
+
+        // Read (and decompress) the file while the workers are converting other files.
+        job->srcData.ReadFrom( srcStream );
+
+        job->memoryUsage = job->srcData.GetSize();
+    }
+    catch( ... )
+    {
+        delete job;
+
+        throw;
+    }
+
+    if ( this->workers.empty() )
+    {
+        // No workers, so we do it right here.
+        {
+            rw::scoped_rwlock_writer <rw::rwlock> lock( this->lock );
+
+            this->progress.filesQueued++;
+        }
+
+        try
+        {
+            if ( job->convert )
+            {
+                rw::WarningManagerInterface *prevWarningMan = this->rwEngine->GetWarningManager();
+
+                txdgenWarningList warningList;
+
+                this->rwEngine->SetWarningManager( &warningList );
+
+                try
+                {
+                    this->ConvertJob( job, warningList );
+                }
+                catch( ... )
+                {
+                    this->rwEngine->SetWarningManager( prevWarningMan );
+
+                    throw;
+                }
+
+                this->rwEngine->SetWarningManager( prevWarningMan );
+            }
+
+            this->WriteJob( job );
+        }
+        catch( ... )
+        {
+            delete job;
+
+            throw;
+        }
+
+        {
+            rw::scoped_rwlock_writer <rw::rwlock> lock( this->lock );
+
+            this->progress.filesWritten++;
+        }
+
+        delete job;
+
+        this->NotifyProgress();
+        return;
+    }
+
+    {
+        rw::scoped_rwlock_writer <rw::rwlock> lock( this->lock );
+
+        this->progress.bytesInFlight += job->memoryUsage;
+        this->progress.filesQueued++;
+
+        this->submittedJobs.push_back( job );
+
+        if ( job->convert )
+        {
+            this->pendingJobs.push_back( job );
+
+            this->workAvailableCond->signal();
+        }
+        else
+        {
+            // Files that are just copied are ready to be written right away.
+            job->isFinished = true;
+        }
+    }
+
+    this->NotifyProgress();
+
+    this->RetireFinishedJobs( false );
+}
+
+void TxdGenBatchScheduler::Flush( void )
+{
+    this->RetireFinishedJobs( true );
+}
+
+void TxdGenBatchScheduler::Cancel( void )
+{
+    rw::scoped_rwlock_writer <rw::rwlock> lock( this->lock );
+
+    this->isCancelled = true;
+
+    // Files that no worker has taken yet are not converted anymore.
+    for ( batchJob *job : this->pendingJobs )
+    {
+        job->isFinished = true;
+    }
+
+    this->pendingJobs.clear();
+
+    this->jobFinishedCond->signal_all();
+}
+
+bool TxdGenBatchScheduler::IsCancelled( void ) const
+{
+    return this->isCancelled;
+}
+
+void TxdGenBatchScheduler::GetProgress( txdgenBatchProgress& progressOut ) const
+{
+    rw::scoped_rwlock_writer <rw::rwlock> lock( this->lock );
+
+    progressOut = this->progress;
+}
+
+void TxdGenBatchScheduler::ConvertJob( batchJob *job, txdgenWarningList& warningList )
+{
+    warningList.messages = &job->warnings;
+
+    try
+    {
+        job->hasConverted = job->convert( &job->srcData, &job->dstData, job->log );
+    }
+    catch( ... )
+    {
+        warningList.messages = NULL;
+
+        throw;
+    }
+
+    warningList.messages = NULL;
+
+    if ( job->hasConverted == false )
+    {
+        // We copy the source instead.
+        job->dstData.Clear();
+    }
+
+    rw::scoped_rwlock_writer <rw::rwlock> lock( this->lock );
+
+    if ( job->hasConverted )
+    {
+        this->progress.filesConverted++;
+    }
+    else
+    {
+        this->progress.filesFailed++;
+    }
+}
+
+void TxdGenBatchScheduler::RetireFinishedJobs( bool waitForAll )
+{
+    while ( true )
+    {
+        batchJob *job = NULL;
+        {
+            rw::scoped_rwlock_writer <rw::rwlock> lock( this->lock );
+
+            if ( this->submittedJobs.empty() )
+                break;
+
+            batchJob *firstJob = this->submittedJobs.front();
+
+            if ( firstJob->isFinished == false )
+            {
+                if ( waitForAll == false )
+                    break;
+
+                this->WaitStep();
+                continue;
+            }
+
+            this->submittedJobs.pop_front();
+
+            job = firstJob;
+        }
+
+        try
+        {
+            if ( this->isCancelled == false )
+            {
+                // A file whose conversion threw fails the batch right here, in submission order,
+                // just like it would have failed Submit without workers.
+                if ( job->failure )
+                {
+                    std::rethrow_exception( job->failure );
+                }
+
+                this->WriteJob( job );
+            }
+        }
+        catch( ... )
+        {
+            {
+                rw::scoped_rwlock_writer <rw::rwlock> lock( this->lock );
+
+                this->progress.bytesInFlight -= job->memoryUsage;
+            }
+
+            delete job;
+
+            throw;
+        }
+
+        {
+            rw::scoped_rwlock_writer <rw::rwlock> lock( this->lock );
+
+            this->progress.bytesInFlight -= job->memoryUsage;
+
+            if ( this->isCancelled == false )
+            {
+                this->progress.filesWritten++;
+            }
+        }
+
+        delete job;
+
+        this->NotifyProgress();
+    }
+}
+
+void TxdGenBatchScheduler::WriteJob( batchJob *job )
+{
+    MessageReceiver *receiver = this->receiver;
+
+    // Output the log of this file, like if we just converted it.
+    if ( !job->logHeader.empty() || !job->log.empty() )
+    {
+        receiver->OnMessage( job->logHeader + job->log );
+    }
+
+    if ( !job->warnings.empty() )
+    {
+        std::string warningText;
+
+        for ( const std::string& warning : job->warnings )
+        {
+            if ( !warningText.empty() )
+            {
+                warningText += '\n';
+            }
+
+            warningText += warning;
+        }
+
+        warningText += "\n";
+
+        receiver->OnMessage( "- Warnings:\n" );
+        receiver->OnMessage( warningText );
+    }
+
+    CFile *targetStream = job->targetRoot->Open( job->targetPath, L"wb" );
+
+    if ( targetStream )
+    {
+        const txdgenMemoryFile& outputData = ( job->hasConverted ? job->dstData : job->srcData );
+
+        try
+        {
+            if ( outputData.GetSize() != 0 )
+            {
+                targetStream->Write( outputData.data.data(), 1, outputData.GetSize() );
+            }
+        }
+        catch( ... )
+        {
+            delete targetStream;
+
+            throw;
+        }
+
+        delete targetStream;
+    }
+}
+
+void TxdGenBatchScheduler::WaitStep( void )
+{
+    // Called with the scheduler lock held.
+    // Every worker signals when it finishes a file and Cancel signals too, so we cannot sleep forever.
+    this->jobFinishedCond->wait( this->lock );
+}
+
+void TxdGenBatchScheduler::NotifyProgress( void )
+{
+    if ( !this->onProgress )
+        return;
+
+    txdgenBatchProgress curProgress;
+
+    this->GetProgress( curProgress );
+
+    this->onProgress( curProgress );
+}
+
+void TxdGenBatchScheduler::StopWorkers( void )
+{
+    {
+        rw::scoped_rwlock_writer <rw::rwlock> lock( this->lock );
+
+        this->isTerminating = true;
+
+        this->workAvailableCond->signal_all();
+    }
+
+    for ( rw::thread_t worker : this->workers )
+    {
+        rw::JoinThread( this->rwEngine, worker );
+        rw::CloseThread( this->rwEngine, worker );
+    }
+
+    this->workers.clear();
+}
+
+void __cdecl TxdGenBatchScheduler::_WorkerThreadMain( rw::thread_t threadHandle, rw::Interface *rwEngine, void *ud )
+{
+    TxdGenBatchScheduler *scheduler = (TxdGenBatchScheduler*)ud;
+
+    rw::AssignThreadedRuntimeConfig( rwEngine );
+
+    scheduler->threadConfig.Apply( rwEngine );
+
+    txdgenWarningList warningList;
+
+    rwEngine->SetWarningManager( &warningList );
+
+    rw::rwlock *schedulerLock = scheduler->lock;
+
+    schedulerLock->enter_write();
+
+    while ( true )
+    {
+        if ( scheduler->pendingJobs.empty() )
+        {
+            if ( scheduler->isTerminating )
+                break;
+
+            scheduler->workAvailableCond->wait( schedulerLock );
+            continue;
+        }
+
+        batchJob *job = scheduler->pendingJobs.front();
+
+        scheduler->pendingJobs.pop_front();
+
+        schedulerLock->leave_write();
+
+        try
+        {
+            scheduler->ConvertJob( job, warningList );
+        }
+        catch( ... )
+        {
+            // Passed on to the submitting thread once it is the turn of this file.
+            job->hasConverted = false;
+            job->dstData.Clear();
+
+            job->failure = std::current_exception();
+        }
+
+        schedulerLock->enter_write();
+
+        job->memoryUsage += job->dstData.GetSize();
+
+        scheduler->progress.bytesInFlight += job->dstData.GetSize();
+
+        job->isFinished = true;
+
+        scheduler->jobFinishedCond->signal_all();
+    }
+
+    schedulerLock->leave_write();
+
+    rw::ReleaseThreadedRuntimeConfig( rwEngine );
+}
+
+// Texture pool implementation.
+TxdGenTexturePool::TxdGenTexturePool( rw::Interface *rwEngine )
+{
+    this->rwEngine = rwEngine;
+    this->isTerminating = false;
+
+    this->lock = rw::CreateReadWriteLock( rwEngine );
+    this->workAvailableCond = rw::CreateConditionVariable( rwEngine );
+    this->jobFinishedCond = rw::CreateConditionVariable( rwEngine );
+}
+
+TxdGenTexturePool::~TxdGenTexturePool( void )
+{
+    // Jobs wait for their tasks, so nobody can be using us anymore.
+    this->StopWorkers();
+
+    rw::CloseConditionVariable( this->rwEngine, this->jobFinishedCond );
+    rw::CloseConditionVariable( this->rwEngine, this->workAvailableCond );
+    rw::CloseReadWriteLock( this->rwEngine, this->lock );
+}
+
+void TxdGenTexturePool::EnsureWorkers( rw::uint32 workerCount )
+{
+    if ( workerCount == 0 )
+    {
+        workerCount = std::thread::hardware_concurrency();
+    }
+
+    rw::scoped_rwlock_writer <rw::rwlock> lock( this->lock );
+
+    if ( this->workers.size() >= workerCount )
+        return;
+
+    // The workers have to process textures like the thread that started them.
+    this->threadConfig.Capture( this->rwEngine );
+
+    while ( this->workers.size() < workerCount )
+    {
+        rw::thread_t worker = rw::MakeThread( this->rwEngine, _WorkerThreadMain, this );
+
+        if ( worker == NULL )
+            break;
+
+        this->workers.push_back( worker );
+
+        rw::ResumeThread( this->rwEngine, worker );
+    }
+}
+
+rw::uint32 TxdGenTexturePool::GetWorkerCount( void ) const
+{
+    rw::scoped_rwlock_writer <rw::rwlock> lock( this->lock );
+
+    return (rw::uint32)this->workers.size();
+}
+
+void TxdGenTexturePool::Run( size_t taskCount, const taskCallback_t& callback )
+{
+    if ( taskCount == 0 )
+        return;
+
+    poolJob job;
+    job.callback = &callback;
+    job.taskCount = taskCount;
+    job.nextTask = 0;
+    job.pendingTasks = taskCount;
+
+    {
+        rw::scoped_rwlock_writer <rw::rwlock> lock( this->lock );
+
+        this->activeJobs.push_back( &job );
+
+        this->workAvailableCond->signal_all();
+
+        // The job lives on our stack, so wait for every task that was started, even if one failed.
+        while ( job.pendingTasks != 0 )
+        {
+            this->jobFinishedCond->wait( this->lock );
+        }
+    }
+
+    if ( job.failure )
+    {
+        std::rethrow_exception( job.failure );
+    }
+}
+
+void TxdGenTexturePool::StopWorkers( void )
+{
+    {
+        rw::scoped_rwlock_writer <rw::rwlock> lock( this->lock );
+
+        this->isTerminating = true;
+
+        this->workAvailableCond->signal_all();
+    }
+
+    for ( rw::thread_t worker : this->workers )
+    {
+        rw::JoinThread( this->rwEngine, worker );
+        rw::CloseThread( this->rwEngine, worker );
+    }
+
+    this->workers.clear();
+}
+
+void __cdecl TxdGenTexturePool::_WorkerThreadMain( rw::thread_t threadHandle, rw::Interface *rwEngine, void *ud )
+{
+    TxdGenTexturePool *pool = (TxdGenTexturePool*)ud;
+
+    rw::AssignThreadedRuntimeConfig( rwEngine );
+
+    txdgenWarningList warningList;
+
+    rw::rwlock *poolLock = pool->lock;
+
+    poolLock->enter_write();
+
+    pool->threadConfig.Apply( rwEngine );
+
+    rwEngine->SetWarningManager( &warningList );
+
+    while ( true )
+    {
+        if ( pool->activeJobs.empty() )
+        {
+            if ( pool->isTerminating )
+                break;
+
+            pool->workAvailableCond->wait( poolLock );
+            continue;
+        }
+
+        poolJob *job = pool->activeJobs.front();
+
+        size_t taskIndex = job->nextTask++;
+
+        if ( job->nextTask == job->taskCount )
+        {
+            pool->activeJobs.pop_front();
+        }
+
+        poolLock->leave_write();
+
+        std::exception_ptr failure;
+
+        try
+        {
+            ( *job->callback )( taskIndex, warningList );
+        }
+        catch( ... )
+        {
+            failure = std::current_exception();
+        }
+
+        warningList.messages = NULL;
+
+        poolLock->enter_write();
+
+        if ( failure && !job->failure )
+        {
+            job->failure = failure;
+
+            // Do not start the tasks that are left.
+            if ( job->nextTask != job->taskCount )
+            {
+                job->pendingTasks -= ( job->taskCount - job->nextTask );
+                job->nextTask = job->taskCount;
+
+                pool->activeJobs.erase( std::find( pool->activeJobs.begin(), pool->activeJobs.end(), job ) );
+            }
+        }
+
+        if ( --job->pendingTasks == 0 )
+        {
+            pool->jobFinishedCond->signal_all();
+        }
+    }
+
+    poolLock->leave_write();
+
+    rw::ReleaseThreadedRuntimeConfig( rwEngine );
+}
@@ -0,0 +1,283 @@
+#ifndef _TXDGEN_BATCH_SCHEDULER_
+#define _TXDGEN_BATCH_SCHEDULER_
+
+#include "shared.h"
+
+#include <atomic>
+#include <functional>
+#include <deque>
+#include <exception>
+#include <vector>
+
+// Worker threads get their own RenderWare configuration, so we have to give them the same settings
+// as the thread that runs txdgen.
+struct txdgenThreadConfig
+{
+    inline void Capture( rw::Interface *rwEngine )
+    {
+        this->version = rwEngine->GetVersion();
+        this->metaDataTagging = rwEngine->GetMetaDataTagging();
+        this->fileInterface = rwEngine->GetFileInterface();
+        this->warningLevel = rwEngine->GetWarningLevel();
+        this->ignoreSecureWarnings = rwEngine->GetIgnoreSecureWarnings();
+        this->palRuntimeType = rwEngine->GetPaletteRuntime();
+        this->dxtRuntimeType = rwEngine->GetDXTRuntime();
+        this->pvrRuntimeType = rwEngine->GetPVRRuntime();
+        this->fixIncompatibleRasters = rwEngine->GetFixIncompatibleRasters();
+        this->compatTransformNativeImaging = rwEngine->GetCompatTransformNativeImaging();
+        this->preferPackedSampleExport = rwEngine->GetPreferPackedSampleExport();
+        this->dxtPackedDecompression = rwEngine->GetDXTPackedDecompression();
+        this->ignoreSerializationRegions = rwEngine->GetIgnoreSerializationBlockRegions();
+    }
+
+    inline void Apply( rw::Interface *rwEngine ) const
+    {
+        rwEngine->SetVersion( this->version );
+        rwEngine->SetMetaDataTagging( this->metaDataTagging );
+        rwEngine->SetFileInterface( this->fileInterface );
+        rwEngine->SetWarningLevel( this->warningLevel );
+        rwEngine->SetIgnoreSecureWarnings( this->ignoreSecureWarnings );
+        rwEngine->SetPaletteRuntime( this->palRuntimeType );
+        rwEngine->SetDXTRuntime( this->dxtRuntimeType );
+        rwEngine->SetPVRRuntime( this->pvrRuntimeType );
+        rwEngine->SetFixIncompatibleRasters( this->fixIncompatibleRasters );
+        rwEngine->SetCompatTransformNativeImaging( this->compatTransformNativeImaging );
+        rwEngine->SetPreferPackedSampleExport( this->preferPackedSampleExport );
+        rwEngine->SetDXTPackedDecompression( this->dxtPackedDecompression );
+        rwEngine->SetIgnoreSerializationBlockRegions( this->ignoreSerializationRegions );
+
+        // Work is already spread across threads, so we do not want every item to
+        // split its work across all processors again.
+        rwEngine->SetWorkerThreadCount( 1 );
+    }
+
+    rw::LibraryVersion version;
+    bool metaDataTagging;
+    rw::FileInterface *fileInterface;
+    int warningLevel;
+    bool ignoreSecureWarnings;
+    rw::ePaletteRuntimeType palRuntimeType;
+    rw::eDXTCompressionMethod dxtRuntimeType;
+    rw::ePVRCompressionMethod pvrRuntimeType;
+    bool fixIncompatibleRasters;
+    bool compatTransformNativeImaging;
+    bool preferPackedSampleExport;
+    bool dxtPackedDecompression;
+    bool ignoreSerializationRegions;
+};
+
+// Collects RenderWare warnings into a list instead of printing them.
+struct txdgenWarningList : public rw::WarningManagerInterface
+{
+    std::vector <std::string> *messages = NULL;
+
+    void OnWarning( std::string&& message ) override
+    {
+        if ( messages )
+        {
+            messages->push_back( std::move( message ) );
+        }
+    }
+};
+
+// A read-write file that lives in system memory.
+// Files are kept like this while they wait for conversion or for their turn to be written.
+struct txdgenMemoryFile : public CFile
+{
+    txdgenMemoryFile( void );
+
+    size_t Read( void *buffer, size_t sElement, size_t iNumElements ) override;
+    size_t Write( const void *buffer, size_t sElement, size_t iNumElements ) override;
+
+    int Seek( long iOffset, int iType ) override;
+    int SeekNative( fsOffsetNumber_t iOffset, int iType ) override;
+
+    long Tell( void ) const override;
+    fsOffsetNumber_t TellNative( void ) const override;
+
+    bool IsEOF( void ) const override;
+
+    bool Stat( struct stat *stats ) const override;
+    void PushStat( const struct stat *stats ) override;
+
+    void SetSeekEnd( void ) override;
+
+    size_t GetSize( void ) const override;
+    fsOffsetNumber_t GetSizeNative( void ) const override;
+
+    void Flush( void ) override;
+
+    const filePath& GetPath( void ) const override;
+
+    bool IsReadable( void ) const override;
+    bool IsWriteable( void ) const override;
+
+    // Takes the remaining contents of another stream.
+    void ReadFrom( CFile *srcStream );
+    void Clear( void );
+
+    std::vector <char> data;
+    size_t seekPos;
+
+    filePath path;
+
+    bool hasStats;
+    struct stat stats;
+};
+
+struct txdgenBatchProgress
+{
+    rw::uint32 filesQueued = 0;         // files that were handed to the scheduler
+    rw::uint32 filesConverted = 0;      // files that went through conversion successfully
+    rw::uint32 filesFailed = 0;         // files that could not be converted (they are copied unchanged)
+    rw::uint32 filesWritten = 0;        // files that have been written to the output
+    size_t bytesInFlight = 0;           // memory taken by files that have not been written yet
+};
+
+// Spreads the conversion of many files across worker threads.
+// The thread that submits files reads and decompresses them, the workers convert them and the
+// submitting thread writes the results. Files are written and logged in the order they were
+// submitted, so the output looks the same as if everything was done one after another.
+// To bound the memory use, submission waits while too many bytes are in flight.
+class TxdGenBatchScheduler
+{
+public:
+    // Converts srcStream into targetStream. Returns false if the source should be copied unchanged.
+    // Anything appended to logOut is printed after the log header of the file.
+    typedef std::function <bool ( CFile *srcStream, CFile *targetStream, std::string& logOut )> convertCallback_t;
+
+    typedef std::function <void ( const txdgenBatchProgress& progress )> progressCallback_t;
+
+    // workerCount zero means one worker per processor, one converts everything on the submitting thread.
+    TxdGenBatchScheduler( rw::Interface *rwEngine, MessageReceiver *receiver, rw::uint32 workerCount, size_t memoryBudget );
+    ~TxdGenBatchScheduler( void );
+
+    // Queues a file that is written to targetPath of targetRoot. If convert is empty, the file is just copied.
+    // targetRoot has to stay alive until the file has been written, see Flush.
+    void Submit(
+        CFileTranslator *targetRoot, const filePath& targetPath, CFile *srcStream,
+        std::string logHeader, convertCallback_t convert
+    );
+
+    // Waits for every submitted file and writes it.
+    void Flush( void );
+
+    // Drops all files that have not been written yet and stops converting.
+    void Cancel( void );
+    bool IsCancelled( void ) const;
+
+    void GetProgress( txdgenBatchProgress& progressOut ) const;
+
+    // Amount of threads that convert files, zero if we convert on the submitting thread.
+    rw::uint32 GetWorkerCount( void ) const;
+
+    progressCallback_t onProgress;
+
+private:
+    struct batchJob
+    {
+        CFileTranslator *targetRoot;
+        filePath targetPath;
+        std::string logHeader;
+        convertCallback_t convert;
+
+        txdgenMemoryFile srcData;
+        txdgenMemoryFile dstData;
+
+        std::string log;
+        std::vector <std::string> warnings;
+
+        bool hasConverted = false;
+        bool isFinished = false;        // protected by the scheduler lock
+
+        std::exception_ptr failure;     // rethrown when it is the turn of the file to be written
+
+        size_t memoryUsage = 0;
+    };
+
+    void ConvertJob( batchJob *job, txdgenWarningList& warningList );
+    void RetireFinishedJobs( bool waitForAll );
+    void WriteJob( batchJob *job );
+    void WaitStep( void );
+    void NotifyProgress( void );
+    void StopWorkers( void );
+
+    static void __cdecl _WorkerThreadMain( rw::thread_t threadHandle, rw::Interface *rwEngine, void *ud );
+
+    rw::Interface *rwEngine;
+    MessageReceiver *receiver;
+
+    txdgenThreadConfig threadConfig;
+
+    size_t memoryBudget;
+
+    rw::rwlock *lock;
+    rw::rwcond *workAvailableCond;          // signaled when a file is queued for conversion or the workers terminate
+    rw::rwcond *jobFinishedCond;            // signaled when a file finished converting or the batch was cancelled
+
+    std::deque <batchJob*> pendingJobs;     // not taken by a worker yet
+    std::deque <batchJob*> submittedJobs;   // not written yet, in submission order
+
+    std::vector <rw::thread_t> workers;
+
+    bool isTerminating;
+    std::atomic <bool> isCancelled;
+
+    txdgenBatchProgress progress;           // protected by the scheduler lock
+};
+
+// Threads that process the textures of a TXD in parallel.
+// They live as long as the pool, so that converting many small TXDs does not create and join threads for each one.
+// Every worker has its own warning list, which the task callback can point at its own warning buffer.
+// Multiple threads may run jobs at the same time; the workers take tasks from the oldest job first.
+class TxdGenTexturePool
+{
+public:
+    typedef std::function <void ( size_t taskIndex, txdgenWarningList& warningList )> taskCallback_t;
+
+    TxdGenTexturePool( rw::Interface *rwEngine );
+    ~TxdGenTexturePool( void );
+
+    // Starts threads until there are workerCount of them; zero means one per processor.
+    // The workers take the configuration of the calling thread.
+    void EnsureWorkers( rw::uint32 workerCount );
+
+    rw::uint32 GetWorkerCount( void ) const;
+
+    // Calls the callback for every task index on the workers and waits for all of them.
+    // The calling thread only waits, so that its (possibly global) configuration is left alone.
+    // After a task failed no more tasks are started, and the first error is rethrown.
+    void Run( size_t taskCount, const taskCallback_t& callback );
+
+private:
+    struct poolJob
+    {
+        const taskCallback_t *callback;
+
+        size_t taskCount;
+        size_t nextTask;                // protected by the pool lock
+        size_t pendingTasks;            // protected by the pool lock
+
+        std::exception_ptr failure;     // protected by the pool lock
+    };
+
+    void StopWorkers( void );
+
+    static void __cdecl _WorkerThreadMain( rw::thread_t threadHandle, rw::Interface *rwEngine, void *ud );
+
+    rw::Interface *rwEngine;
+
+    txdgenThreadConfig threadConfig;
+
+    rw::rwlock *lock;
+    rw::rwcond *workAvailableCond;          // signaled when a job is posted or the workers terminate
+    rw::rwcond *jobFinishedCond;            // signaled when the last task of a job finished
+
+    std::deque <poolJob*> activeJobs;       // jobs with tasks that were not taken yet
+
+    std::vector <rw::thread_t> workers;
+
+    bool isTerminating;
+};
+
+#endif //_TXDGEN_BATCH_SCHEDULER_